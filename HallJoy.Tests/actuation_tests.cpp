@@ -0,0 +1,358 @@
+// actuation_tests.cpp
+// Key actuation replayed on tap traces (1 ms ticks, sensor noise): partial
+// taps from mid-travel, flutter around a threshold and full taps, fixed point
+// vs rapid trigger; the config swap while an update runs. Benchmarks: latency
+// gained on the traces, update cost for 256 keys.
+#include "test.h"
+
+#include "../HallJoy/actuation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr uint16_t kHid = 4;
+
+    struct Rng
+    {
+        uint32_t s;
+        uint32_t Next() { s = s * 1664525u + 1013904223u; return s >> 8; }
+        int Noise(int amp) { return amp ? (int)(Next() % (uint32_t)(2 * amp + 1)) - amp : 0; }
+    };
+
+    // Depth per tick, with where each tap starts down and starts back up
+    struct Trace
+    {
+        std::vector<uint16_t> depth;
+        std::vector<int>      strokes;   // tick the finger starts pressing
+        std::vector<int>      lifts;     // tick the finger starts releasing
+    };
+
+    struct TraceWriter
+    {
+        Trace t;
+        Rng   rng{ 1 };
+        int   noise = 6;
+        int   at = 0;
+
+        void Push(int v) { t.depth.push_back((uint16_t)std::clamp(v + rng.Noise(noise), 0, 1000)); at = v; }
+        void Hold(int ticks) { for (int i = 0; i < ticks; ++i) Push(at); }
+        void Move(int to, int ticks)
+        {
+            const int from = at;
+            for (int i = 1; i <= ticks; ++i) Push(from + (to - from) * i / ticks);
+        }
+        void Press(int to, int ticks) { t.strokes.push_back((int)t.depth.size()); Move(to, ticks); }
+        void Lift(int to, int ticks) { t.lifts.push_back((int)t.depth.size()); Move(to, ticks); }
+    };
+
+    // Fast re-taps the way players do them: the key comes up to 40 %, never
+    // back past the 10 % actuation point, then goes down again.
+    Trace PartialTaps(int taps)
+    {
+        TraceWriter w;
+        w.Hold(5);
+        w.Press(800, 16);
+        w.Hold(4);
+        for (int i = 1; i < taps; ++i) {
+            w.Lift(400, 8);
+            w.Press(800, 8);
+            w.Hold(4);
+        }
+        w.Lift(0, 16);
+        w.Hold(5);
+        return w.t;
+    }
+
+    // Bottom out and come back to the top every time
+    Trace FullTaps(int taps)
+    {
+        TraceWriter w;
+        for (int i = 0; i < taps; ++i) {
+            w.Hold(5);
+            w.Press(1000, 20);
+            w.Hold(5);
+            w.Lift(0, 20);
+        }
+        w.Hold(5);
+        return w.t;
+    }
+
+    // One press, then the finger rests on the key: depth shakes by +-amp around `at`
+    Trace Flutter(int at, int amp)
+    {
+        TraceWriter w;
+        w.Hold(5);
+        w.noise = 0;
+        w.Press(at, 10);
+        w.noise = amp;
+        w.Hold(500);
+        w.noise = 0;
+        w.Lift(0, 10);
+        w.Hold(5);
+        return w.t;
+    }
+
+    uint16_t ReadDepth(void* user, uint16_t hid)
+    {
+        return hid == kHid ? *static_cast<const uint16_t*>(user) : 0;
+    }
+
+    bool Tick(uint16_t depth)
+    {
+        const uint64_t keys[4] = { 1ull << kHid, 0, 0, 0 };
+        Actuation_Update(keys, &ReadDepth, &depth);
+        return (Actuation_DownChunk(0) >> kHid) & 1ull;
+    }
+
+    struct Replay
+    {
+        int    presses = 0;
+        int    caught = 0;           // taps with a press of their own
+        double pressLatencyMs = 0;   // mean, from the start of the stroke
+        double releaseLatencyMs = 0; // mean, from the start of the lift
+    };
+
+    Replay Run(const KeyActuation& cfg, const Trace& trace)
+    {
+        Actuation_Set(kHid, cfg);
+        for (int i = 0; i < 4; ++i) Tick(0);             // fully released
+        std::vector<int> pressAt, releaseAt;
+        bool down = false;
+        for (int i = 0; i < (int)trace.depth.size(); ++i) {
+            const bool now = Tick(trace.depth[(size_t)i]);
+            if (now && !down) pressAt.push_back(i);
+            if (!now && down) releaseAt.push_back(i);
+            down = now;
+        }
+        Actuation_Set(kHid, KeyActuation{});
+
+        // A tap is caught by the first press between its stroke and the next one
+        Replay r;
+        r.presses = (int)pressAt.size();
+        int pressSum = 0, releaseSum = 0, released = 0;
+        for (size_t k = 0; k < trace.strokes.size(); ++k) {
+            const int from = trace.strokes[k];
+            const int to = (k + 1 < trace.strokes.size()) ? trace.strokes[k + 1] : (int)trace.depth.size();
+            auto p = std::lower_bound(pressAt.begin(), pressAt.end(), from);
+            if (p != pressAt.end() && *p < to) { ++r.caught; pressSum += *p - from; }
+        }
+        for (size_t k = 0; k < trace.lifts.size(); ++k) {
+            const int from = trace.lifts[k];
+            auto q = std::lower_bound(releaseAt.begin(), releaseAt.end(), from);
+            if (q != releaseAt.end() && (k + 1 >= trace.lifts.size() || *q < trace.lifts[k + 1])) {
+                ++released;
+                releaseSum += *q - from;
+            }
+        }
+        r.pressLatencyMs = r.caught ? (double)pressSum / r.caught : 0.0;
+        r.releaseLatencyMs = released ? (double)releaseSum / released : 0.0;
+        return r;
+    }
+
+    KeyActuation Fixed(uint16_t press, uint16_t release = 0)
+    {
+        KeyActuation c;
+        c.pressM = press;
+        c.releaseM = release;
+        return c;
+    }
+
+    KeyActuation Rapid(ActuationMode mode = ActuationMode::RapidTrigger, uint16_t sensitivity = 50)
+    {
+        KeyActuation c;
+        c.mode = mode;
+        c.rtDownM = sensitivity;
+        c.rtUpM = sensitivity;
+        return c;
+    }
+}
+
+TEST(Actuation_RapidTriggerCatchesPartialTaps)
+{
+    const Trace trace = PartialTaps(20);
+    CHECK_EQ(trace.strokes.size(), 20u);
+
+    // The fixed point sees one long press: the key never comes back above 10 %
+    const Replay fixed = Run(Fixed(ACTUATION_DEFAULT_PRESS_M), trace);
+    CHECK_EQ(fixed.presses, 1);
+    CHECK_EQ(fixed.caught, 1);
+
+    // Rapid trigger: every tap, within a couple of ticks of the finger turning
+    for (ActuationMode mode : { ActuationMode::RapidTrigger, ActuationMode::RapidContinuous }) {
+        const Replay rapid = Run(Rapid(mode), trace);
+        CHECK_EQ(rapid.presses, 20);
+        CHECK_EQ(rapid.caught, 20);
+        CHECK(rapid.releaseLatencyMs <= 3.0);
+    }
+
+    // Sensitivity above the tap travel (400): back to one press
+    CHECK_EQ(Run(Rapid(ActuationMode::RapidTrigger, 450), trace).presses, 1);
+}
+
+TEST(Actuation_FullTapsAndReleaseLatency)
+{
+    const Trace trace = FullTaps(20);
+    const Replay fixed = Run(Fixed(ACTUATION_DEFAULT_PRESS_M), trace);
+    const Replay rapid = Run(Rapid(), trace);
+    CHECK_EQ(fixed.caught, 20);
+    CHECK_EQ(fixed.presses, 20);
+    CHECK_EQ(rapid.caught, 20);
+    CHECK_EQ(rapid.presses, 20);
+
+    // Same actuation point on the way down; on the way up rapid trigger lets
+    // go after 5 % of travel, the fixed point only at 10 % from the top
+    CHECK(std::abs(rapid.pressLatencyMs - fixed.pressLatencyMs) < 1.0);
+    CHECK(fixed.releaseLatencyMs >= 16.0);
+    CHECK(rapid.releaseLatencyMs <= 3.0);
+
+    // A deeper actuation point presses later and releases sooner
+    const Replay deep = Run(Fixed(600, 550), trace);
+    CHECK_EQ(deep.caught, 20);
+    CHECK(deep.pressLatencyMs > fixed.pressLatencyMs + 8.0);
+    CHECK(deep.releaseLatencyMs < fixed.releaseLatencyMs - 8.0);
+}
+
+TEST(Actuation_FlutterDoesNotChatter)
+{
+    // Noise across the fixed point: without hysteresis it chatters, a release
+    // point below the noise band gives one press
+    const Trace atPoint = Flutter(100, 8);
+    CHECK(Run(Fixed(100), atPoint).presses > 20);
+    CHECK_EQ(Run(Fixed(100, 80), atPoint).presses, 1);
+
+    // Resting mid-travel with noise below the sensitivity: one press, held
+    const Trace resting = Flutter(500, 15);
+    for (ActuationMode mode : { ActuationMode::RapidTrigger, ActuationMode::RapidContinuous }) {
+        const Replay r = Run(Rapid(mode), resting);
+        CHECK_EQ(r.presses, 1);
+        CHECK_EQ(r.caught, 1);
+    }
+    // Sensitivity inside the noise band: it would chatter
+    CHECK(Run(Rapid(ActuationMode::RapidTrigger, 10), resting).presses > 20);
+}
+
+TEST(Actuation_ConfigSwapWaitsForTheUpdateInProgress)
+{
+    // An update held open in its read callback
+    struct Gate
+    {
+        std::atomic<bool> inside{ false };
+        std::atomic<bool> release{ false };
+        uint16_t depth = 500;
+    } gate;
+    auto blockingRead = [](void* user, uint16_t) -> uint16_t {
+        Gate& g = *static_cast<Gate*>(user);
+        g.inside.store(true);
+        while (!g.release.load()) std::this_thread::yield();
+        return g.depth;
+    };
+
+    Actuation_Set(kHid, Fixed(300));    // down at 500
+    Tick(0);
+
+    bool downInUpdate = false;
+    std::thread rt([&] {
+        const uint64_t keys[4] = { 1ull << kHid, 0, 0, 0 };
+        Actuation_Update(keys, blockingRead, &gate);
+        downInUpdate = (Actuation_DownChunk(0) >> kHid) & 1ull;
+    });
+    while (!gate.inside.load()) std::this_thread::yield();
+
+    // Two swaps in a row: the second would refill the table the update reads
+    std::atomic<int> swaps{ 0 };
+    std::thread writer([&] {
+        Actuation_Set(kHid, Fixed(700));
+        swaps.fetch_add(1);
+        Actuation_Set(kHid, Fixed(900));
+        swaps.fetch_add(1);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    CHECK_EQ(swaps.load(), 0);           // waiting for the update to end
+
+    gate.release.store(true);
+    rt.join();
+    writer.join();
+    CHECK_EQ(swaps.load(), 2);
+
+    // The update ran on the config it started with; the next one sees the new one
+    CHECK(downInUpdate);
+    CHECK(!Tick(500));
+    CHECK(!Tick(800));
+    CHECK(Tick(900));
+    CHECK_EQ(Actuation_Get(kHid).pressM, 900);
+
+    // Swaps racing a running realtime thread (run it under TSan too): key 5
+    // flips between two configs that agree on its depths, up at 200 and down
+    // at 800, so the output never moves; the last swap is in effect after.
+    constexpr uint16_t kOther = 5;
+    KeyActuation a = Fixed(400, 300);
+    KeyActuation b = Rapid(ActuationMode::RapidContinuous, 100);
+    b.pressM = 600;
+    b.releaseM = 500;
+    Actuation_Set(kOther, a);
+    std::atomic<bool> stop{ false };
+    std::atomic<int> wrong{ 0 };
+    std::thread loop([&] {
+        uint16_t depths[2] = { 200, 800 };
+        for (uint32_t i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+            const uint16_t d = depths[i & 1];
+            const uint64_t keys[4] = { 1ull << kOther, 0, 0, 0 };
+            Actuation_Update(keys, [](void* u, uint16_t) { return *static_cast<uint16_t*>(u); }, (void*)&d);
+            const bool down = (Actuation_DownChunk(0) >> kOther) & 1ull;
+            if (down != (d == 800)) wrong.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    for (int i = 0; i < 2000; ++i) Actuation_Set(kOther, (i & 1) ? b : a);
+    stop.store(true);
+    loop.join();
+    CHECK_EQ(wrong.load(), 0);
+    CHECK(Actuation_Get(kOther).mode == ActuationMode::RapidContinuous);
+    Actuation_ClearAll();
+    Tick(0);
+}
+
+BENCH(Actuation_LatencyGainOnTraces)
+{
+    const Trace partial = PartialTaps(20);
+    const Trace full = FullTaps(20);
+    const Replay fp = Run(Fixed(ACTUATION_DEFAULT_PRESS_M), partial);
+    const Replay rp = Run(Rapid(), partial);
+    const Replay ff = Run(Fixed(ACTUATION_DEFAULT_PRESS_M), full);
+    const Replay rf = Run(Rapid(), full);
+
+    // Taps the fixed point misses outright; for the others, what a re-tap costs
+    // with each (full lift and press with the fixed point, partial with rapid)
+    const int missed = rp.caught - fp.caught;
+    std::printf("  partial taps: fixed %d/20, rapid %d/20, rapid press %.1f ms after the finger turns\n",
+        fp.caught, rp.caught, rp.pressLatencyMs);
+    std::printf("  full taps:    press fixed %.1f ms / rapid %.1f ms, release fixed %.1f ms / rapid %.1f ms\n",
+        ff.pressLatencyMs, rf.pressLatencyMs, ff.releaseLatencyMs, rf.releaseLatencyMs);
+    const double perTap = (ff.pressLatencyMs + ff.releaseLatencyMs) - (rp.pressLatencyMs + rp.releaseLatencyMs);
+    std::printf("  gain: %d taps recovered, %.1f ms per re-tap (release + press, vs fixed on full taps)\n",
+        missed, perTap);
+    CHECK_EQ(missed, 19);
+    CHECK(perTap > 10.0);
+
+    // Update cost, all 256 keys read
+    Actuation_Set(kHid, Rapid());
+    uint64_t keys[4] = { ~1ull, ~0ull, ~0ull, ~0ull };
+    uint16_t depth = 0;
+    constexpr int kTicks = 1000000;
+    int presses = 0;
+    const double t0 = Test::NowSec();
+    for (int i = 0; i < kTicks; ++i) {
+        depth = partial.depth[(size_t)i % partial.depth.size()];
+        presses += Actuation_Update(keys, [](void* u, uint16_t) { return *static_cast<uint16_t*>(u); }, &depth);
+    }
+    const double ns = (Test::NowSec() - t0) * 1e9 / kTicks;
+    std::printf("  update, 256 keys: %.0f ns / tick (%d presses)\n", ns, presses);
+    CHECK(ns < 20000.0);
+    Actuation_ClearAll();
+    Tick(0);
+}
@@ -0,0 +1,195 @@
+// analog_devices_tests.cpp
+// Several analog keyboards through FakeAnalogSource: merge policies, pinned
+// keys, unplug with a key held, replug, slot overflow. Benchmark: poll cost
+// against the number of devices.
+#include "test.h"
+
+#include "../HallJoy/analog_devices.h"
+
+namespace
+{
+    constexpr uint16_t kW = 26, kA = 4, kSpace = 44;
+
+    // Fresh slots, no pin, Max: each test starts from the defaults
+    struct Reset
+    {
+        Reset() { Clear(); }
+        ~Reset() { Clear(); }
+        static void Clear()
+        {
+            AnalogDevices_SetSlotIds({});
+            AnalogDevices_ClearKeyDevices();
+            AnalogDevices_SetPolicy(AnalogMergePolicy::Max);
+        }
+    };
+}
+
+TEST(Devices_MergePolicies)
+{
+    Reset reset;
+    FakeAnalogSource src;
+    src.AddDevice(100, "keyboard");
+    src.AddDevice(200, "keypad");
+    src.SetKey(100, kW, 0.3f);
+    src.SetKey(200, kW, 0.8f);
+    src.SetKey(200, kA, 0.5f);
+
+    CHECK_EQ(AnalogDevices_Poll(src, 0), 2);
+    CHECK_EQ(AnalogDevices_Depth(-1, kW), 0.8f);
+    CHECK_EQ(AnalogDevices_Depth(0, kW), 0.8f);
+    CHECK_EQ(AnalogDevices_Depth(-1, kA), 0.5f);
+    CHECK(!AnalogDevices_PerPad());
+
+    AnalogDevices_SetPolicy(AnalogMergePolicy::First);   // slot order: 100 first
+    AnalogDevices_Poll(src, 1);
+    CHECK_EQ(AnalogDevices_Depth(-1, kW), 0.3f);
+    CHECK_EQ(AnalogDevices_Depth(-1, kA), 0.5f);
+
+    AnalogDevices_SetPolicy(AnalogMergePolicy::PerPad);
+    AnalogDevices_Poll(src, 2);
+    CHECK(AnalogDevices_PerPad());
+    CHECK_EQ(AnalogDevices_Depth(0, kW), 0.3f);
+    CHECK_EQ(AnalogDevices_Depth(1, kW), 0.8f);
+    CHECK_EQ(AnalogDevices_Depth(0, kA), 0.0f);
+    CHECK_EQ(AnalogDevices_Depth(2, kW), 0.0f);           // no third device
+    CHECK_EQ(AnalogDevices_Depth(-1, kW), 0.8f);          // not per pad: Max
+    // Pad masks: only the keys its device reports
+    CHECK_EQ(AnalogDevices_PadKeysChunk(0, 0), 1ull << kW);
+    CHECK_EQ(AnalogDevices_PadKeysChunk(1, 0), (1ull << kW) | (1ull << kA));
+    CHECK_EQ(AnalogDevices_PadKeysChunk(-1, 0), ~0ull);
+
+    // Out of range and non-finite depths are clamped / ignored
+    src.SetKey(100, kSpace, 3.0f);
+    src.SetKey(200, kSpace, -1.0f);
+    AnalogDevices_SetPolicy(AnalogMergePolicy::Max);
+    AnalogDevices_Poll(src, 3);
+    CHECK_EQ(AnalogDevices_Depth(-1, kSpace), 1.0f);
+    CHECK_EQ(AnalogDevices_Depth(-1, 0), 0.0f);
+    CHECK_EQ(AnalogDevices_Depth(-1, 300), 0.0f);
+}
+
+TEST(Devices_PinnedKeyReadsItsDevice)
+{
+    Reset reset;
+    FakeAnalogSource src;
+    src.AddDevice(100);
+    src.AddDevice(200);
+    src.SetKey(100, kW, 0.9f);
+    src.SetKey(200, kW, 0.2f);
+
+    AnalogDevices_SetKeyDevice(kW, 1);   // W from slot 1 only
+    CHECK_EQ(AnalogDevices_GetKeyDevice(kW), 1);
+    AnalogDevices_Poll(src, 0);
+    CHECK_EQ(AnalogDevices_Depth(-1, kW), 0.2f);
+    CHECK_EQ(AnalogDevices_Depth(0, kW), 0.2f);
+
+    // Under PerPad a pinned key belongs to the pads by its device, not the pad's
+    AnalogDevices_SetPolicy(AnalogMergePolicy::PerPad);
+    AnalogDevices_Poll(src, 1);
+    CHECK_EQ(AnalogDevices_PadKeysChunk(0, 0), 1ull << kW);
+    src.SetKey(200, kW, 0.0f);
+    AnalogDevices_Poll(src, 2);
+    CHECK_EQ(AnalogDevices_PadKeysChunk(0, 0), 0ull);
+    CHECK_EQ(AnalogDevices_Depth(0, kW), 0.0f);
+
+    std::vector<std::pair<uint16_t, int>> pins;
+    AnalogDevices_EnumerateKeyDevices(pins);
+    CHECK_EQ(pins.size(), 1u);
+    AnalogDevices_SetKeyDevice(kW, 99);  // out of range: back to any device
+    CHECK_EQ(AnalogDevices_GetKeyDevice(kW), ANALOG_ANY_DEVICE);
+}
+
+TEST(Devices_UnplugReleasesAndReplugKeepsTheSlot)
+{
+    Reset reset;
+    FakeAnalogSource src;
+    src.AddDevice(100, "a");
+    src.AddDevice(200, "b");
+    src.SetKey(200, kW, 0.7f);
+    AnalogDevices_Poll(src, 0);
+    CHECK_EQ(AnalogDevices_Depth(-1, kW), 0.7f);
+
+    // Gone between two scans with W held: released on this very tick
+    src.RemoveDevice(200);
+    CHECK_EQ(AnalogDevices_Poll(src, 10), 1);
+    CHECK_EQ(AnalogDevices_Depth(-1, kW), 0.0f);
+    AnalogDevicesStats st;
+    AnalogDevices_GetStats(&st);
+    CHECK(st.readErrors >= 1);
+
+    AnalogDevices_Poll(src, 20);          // rescan: slot 1 kept, disconnected
+    std::vector<AnalogSlotInfo> slots;
+    AnalogDevices_GetSlots(slots);
+    CHECK_EQ(slots.size(), 2u);
+    if (slots.size() == 2) CHECK(slots[1].info.id == 200 && !slots[1].connected);
+
+    // A new device takes a free slot, the old one comes back to its own
+    src.AddDevice(300, "c");
+    src.AddDevice(200, "b");
+    src.SetKey(200, kA, 0.4f);
+    AnalogDevices_RequestRescan();
+    CHECK_EQ(AnalogDevices_Poll(src, 30), 3);
+    const std::vector<uint64_t> ids = AnalogDevices_GetSlotIds();
+    CHECK(ids[0] == 100 && ids[1] == 200 && ids[2] == 300);
+    AnalogDevices_SetPolicy(AnalogMergePolicy::PerPad);
+    AnalogDevices_Poll(src, 40);
+    CHECK_EQ(AnalogDevices_Depth(1, kA), 0.4f);
+}
+
+TEST(Devices_SlotOverflowAndSavedSlots)
+{
+    Reset reset;
+    // Saved order from settings.ini: 900 keeps slot 0 even plugged in last
+    AnalogDevices_SetSlotIds({ 900, 0, 0 });
+    FakeAnalogSource src;
+    for (uint64_t id = 1; id <= ANALOG_MAX_DEVICES; ++id) src.AddDevice(id);
+    src.AddDevice(900);
+    CHECK_EQ(AnalogDevices_Poll(src, 0), ANALOG_MAX_DEVICES);
+    const std::vector<uint64_t> ids = AnalogDevices_GetSlotIds();
+    CHECK_EQ(ids[0], 900u);
+    AnalogDevicesStats st;
+    AnalogDevices_GetStats(&st);
+    CHECK_EQ(st.unslotted, 1u);
+    CHECK_EQ(st.devices, (uint32_t)ANALOG_MAX_DEVICES);
+
+    // No device info: the caller keeps the merged read
+    class NoInfo : public IAnalogSource
+    {
+    public:
+        int Devices(AnalogDeviceInfo*, int) override { return -1; }
+        int ReadDevice(uint64_t, uint16_t*, float*, int) override { return -1; }
+    } none;
+    AnalogDevices_SetSlotIds({});
+    CHECK_EQ(AnalogDevices_Poll(none, 100), 0);
+    CHECK(!AnalogDevices_PerPad());
+}
+
+BENCH(Devices_PollScalesWithDevices)
+{
+    // 10 keys held per device, one poll per tick
+    Reset reset;
+    constexpr int kPolls = 20000;
+    double perDevice[ANALOG_MAX_DEVICES + 1]{};
+    for (int n : { 1, 2, 4, 8 }) {
+        Reset::Clear();
+        FakeAnalogSource src;
+        for (int d = 0; d < n; ++d) {
+            src.AddDevice(1000 + d);
+            for (uint16_t k = 0; k < 10; ++k) src.SetKey(1000 + d, (uint16_t)(4 + k * 7 + d), 0.5f);
+        }
+        AnalogDevices_Poll(src, 0);
+        const uint64_t reads0 = src.Reads();
+        float sink = 0.0f;
+        const double t0 = Test::NowSec();
+        for (int i = 0; i < kPolls; ++i) {
+            AnalogDevices_Poll(src, 1 + (uint64_t)i % 1000);   // no rescan inside the loop
+            sink += AnalogDevices_Depth(-1, 4);
+        }
+        const double us = (Test::NowSec() - t0) * 1e6 / kPolls;
+        perDevice[n] = us / n;
+        std::printf("  %d device(s): %.2f us / poll, %.2f us / device (%g)\n", n, us, us / n, sink);
+        CHECK_EQ(src.Reads() - reads0, (uint64_t)kPolls * n);   // one bulk read per device
+    }
+    // Linear: a device costs about the same whatever the count (fixed part aside)
+    CHECK(perDevice[8] < perDevice[1] * 2.0);
+}
@@ -0,0 +1,209 @@
+// app_profiles_tests.cpp
+// Per-application profiles with a StaticForegroundProvider: exe patterns,
+// compiled images, switching, fallback to the live bindings, deferred free
+// of a reloaded set. Benchmark: switch cost and a reader ticking meanwhile.
+#include "test.h"
+
+#include "../HallJoy/app_profiles.h"
+
+#include <atomic>
+#include <thread>
+
+namespace
+{
+    // HID 4 (A) on LX-, `hid` on button A of pad 0
+    ProfileSource Source(const wchar_t* name, uint16_t hid)
+    {
+        ProfileSource src;
+        src.name = name;
+        src.pads[0].axes[(int)Axis::LX].minusHid = 4;
+        src.pads[0].buttons[(int)GameButton::A][hid / 64] |= 1ull << (hid % 64);
+        return src;
+    }
+
+    std::vector<std::unique_ptr<ProfileImage>> Images(std::initializer_list<ProfileSource> srcs)
+    {
+        std::vector<std::unique_ptr<ProfileImage>> out;
+        for (const ProfileSource& s : srcs) out.push_back(AppProfiles_Compile(s));
+        return out;
+    }
+
+    // Profiles, rules and provider gone, retired sets freed
+    struct Cleanup
+    {
+        ~Cleanup()
+        {
+            AppProfiles_SetForegroundProvider(nullptr);
+            AppProfiles_SetProfiles({}, {});
+            AppProfiles_OnForegroundChanged();
+            AppProfiles_BeginTick();
+            AppProfiles_SetProfiles({}, {});
+            Bindings_ClearAll();
+        }
+    };
+}
+
+TEST(Profiles_ExePatterns)
+{
+    CHECK(AppProfiles_MatchExe(L"game.exe", L"GAME.EXE"));
+    CHECK(AppProfiles_MatchExe(L"*-Win64-Shipping.exe", L"Foo-Win64-Shipping.exe"));
+    CHECK(AppProfiles_MatchExe(L"*", L"anything.exe"));
+    CHECK(AppProfiles_MatchExe(L"g?me*.exe", L"gameX64.exe"));
+    CHECK(AppProfiles_MatchExe(L"*a*b*c", L"xxaxxbxxbxc"));
+    CHECK(!AppProfiles_MatchExe(L"game.exe", L"game.exe2"));
+    CHECK(!AppProfiles_MatchExe(L"g?me.exe", L"gme.exe"));
+    CHECK(!AppProfiles_MatchExe(L"", L"game.exe"));
+    CHECK(!AppProfiles_MatchExe(L"*.exe", L"game.ex"));
+}
+
+TEST(Profiles_CompiledImage)
+{
+    ProfileSource src = Source(L"p", 30);
+    src.pads[3].triggers[1] = 200;
+    src.layers[1].keys[0].hid = 57;
+    src.layers[1].keys[0].layer = 1;
+    src.layers[1].keyCount = 1;
+    src.hasStickShape = true;
+    src.sticks[2][1].circle = true;
+
+    const auto img = AppProfiles_Compile(src);
+    CHECK(img->name == L"p");
+    CHECK(!img->ownSocd && img->ownStickShape);
+    auto bound = [&](uint16_t hid) { return ((img->boundAny[hid / 64] >> (hid % 64)) & 1ull) != 0; };
+    CHECK(bound(4) && bound(30) && bound(200) && bound(57));
+    CHECK(!bound(0) && !bound(5));
+    CHECK(img->pads[0].socd[0] == SocdMode::Global);
+    CHECK(img->pads[0].sticks[0].identity);
+    CHECK(!img->pads[2].sticks[1].identity);
+    CHECK_EQ(img->pads[1].layers.keyCount, 1);
+}
+
+TEST(Profiles_SwitchOnForeground)
+{
+    Cleanup cleanup;
+    StaticForegroundProvider fg;
+    AppProfiles_SetForegroundProvider(&fg);
+
+    // Live bindings: HID 9 on pad 0
+    PadBindings live;
+    live.triggers[0] = 9;
+    Bindings_SetPad(0, live);
+
+    std::vector<AppProfileRule> rules = {
+        { L"shooter*.exe", L"fps" },
+        { L"*.exe", L"generic" },
+        { L"ghost.exe", L"missing" },     // unknown profile: ignored
+    };
+    AppProfiles_SetProfiles(Images({ Source(L"fps", 30), Source(L"generic", 31) }), rules);
+    AppProfilesStats st;
+    AppProfiles_GetStats(&st);
+    CHECK_EQ(st.profiles, 2u);
+    CHECK_EQ(st.rules, 3u);
+
+    // Nothing in front yet: live state
+    CHECK(AppProfiles_BeginTick() == nullptr);
+    CHECK(AppProfiles_ActiveName().empty());
+    CHECK(AppProfiles_IsHidBound(9));
+    CHECK(!AppProfiles_IsHidBound(30));
+
+    fg.Set(L"Shooter2.exe");
+    AppProfiles_OnForegroundChanged();
+    const ProfileImage* img = AppProfiles_BeginTick();
+    CHECK(img && img->name == L"fps");
+    CHECK(AppProfiles_IsHidBound(30) && AppProfiles_IsHidBound(4));
+    CHECK(!AppProfiles_IsHidBound(9) && !AppProfiles_IsHidBound(31));
+
+    fg.Set(L"notepad.exe");                  // first match wins: the second rule
+    AppProfiles_OnForegroundChanged();
+    CHECK(AppProfiles_ActiveName() == L"generic");
+
+    fg.Set(L"readme.txt");                   // no rule: back to the live state
+    AppProfiles_OnForegroundChanged();
+    CHECK(AppProfiles_BeginTick() == nullptr);
+    CHECK(AppProfiles_IsHidBound(9));
+
+    fg.Set(L"");                             // unknown foreground
+    AppProfiles_OnForegroundChanged();
+    CHECK(AppProfiles_ActiveName().empty());
+
+    AppProfilesStats after;
+    AppProfiles_GetStats(&after);
+    CHECK_EQ(after.foregroundChanges - st.foregroundChanges, 4u);
+    CHECK_EQ(after.switches - st.switches, 3u);
+}
+
+TEST(Profiles_ReloadFreesTheOldSetAfterATick)
+{
+    Cleanup cleanup;
+    StaticForegroundProvider fg;
+    fg.Set(L"game.exe");
+    AppProfiles_SetForegroundProvider(&fg);
+    const std::vector<AppProfileRule> rules = { { L"game.exe", L"g" } };
+
+    AppProfiles_SetProfiles(Images({ Source(L"g", 30) }), rules);
+    AppProfiles_OnForegroundChanged();
+    const ProfileImage* first = AppProfiles_BeginTick();
+    CHECK(first && first->name == L"g");
+
+    // Reload while a tick holds `first`: the new image is picked up at
+    // once, the old set waits for the next tick
+    AppProfiles_SetProfiles(Images({ Source(L"g", 40) }), rules);
+    AppProfilesStats st;
+    AppProfiles_GetStats(&st);
+    CHECK_EQ(st.retiredPending, 1u);
+    CHECK(AppProfiles_IsHidBound(40) && !AppProfiles_IsHidBound(30));
+    CHECK(first->name == L"g");   // still readable
+
+    const ProfileImage* second = AppProfiles_BeginTick();
+    CHECK(second && second != first);
+    AppProfiles_OnForegroundChanged();   // control side frees what the tick released
+    AppProfiles_GetStats(&st);
+    CHECK_EQ(st.retiredPending, 0u);
+}
+
+BENCH(Profiles_SwitchWhileTicking)
+{
+    // Switches and reloads on this thread, a realtime-like reader on another
+    Cleanup cleanup;
+    StaticForegroundProvider fg;
+    AppProfiles_SetForegroundProvider(&fg);
+    const std::vector<AppProfileRule> rules = { { L"a.exe", L"a" }, { L"b.exe", L"b" } };
+    AppProfiles_SetProfiles(Images({ Source(L"a", 30), Source(L"b", 31) }), rules);
+
+    std::atomic<bool> stop{ false };
+    std::atomic<uint64_t> ticks{ 0 }, bad{ 0 };
+    std::thread reader([&] {
+        while (!stop.load(std::memory_order_relaxed)) {
+            const ProfileImage* img = AppProfiles_BeginTick();
+            // Each image binds HID 4 and its own 30 / 31: a freed image would show here
+            if (img && !(((img->boundAny[0] >> 4) & 1) && (((img->boundAny[0] >> 30) & 1) || ((img->boundAny[0] >> 31) & 1))))
+                bad.fetch_add(1);
+            ticks.fetch_add(1, std::memory_order_relaxed);
+            std::this_thread::yield();
+        }
+    });
+
+    constexpr int kSwitches = 20000;
+    constexpr int kReloads = 200;
+    const double t0 = Test::NowSec();
+    for (int i = 0; i < kSwitches; ++i) {
+        fg.Set((i & 1) ? L"b.exe" : L"a.exe");
+        AppProfiles_OnForegroundChanged();
+    }
+    const double switchSec = Test::NowSec() - t0;
+
+    const double t1 = Test::NowSec();
+    for (int i = 0; i < kReloads; ++i) {
+        AppProfiles_SetProfiles(Images({ Source(L"a", 30), Source(L"b", 31) }), rules);
+        AppProfiles_OnForegroundChanged();
+    }
+    const double reloadSec = Test::NowSec() - t1;
+    stop.store(true);
+    reader.join();
+
+    AppProfilesStats st;
+    AppProfiles_GetStats(&st);
+    std::printf("  switch %.2f us, reload (compile 2 images + swap) %.1f us, %llu reader ticks, %u sets pending\n",
+        switchSec * 1e6 / kSwitches, reloadSec * 1e6 / kReloads, (unsigned long long)ticks.load(), st.retiredPending);
+    CHECK_EQ(bad.load(), 0u);
+}
@@ -0,0 +1,16 @@
+// app_stubs.cpp
+// What the combo engine calls into outside the modules under test: the
+// backend's analog outputs and the HID / VK helpers of mouse_combo_system.cpp.
+// No device, no ViGEm: the test binary links the engine alone.
+#include "../HallJoy/backend.h"
+#include "../HallJoy/key_table.h"
+#include "../HallJoy/mouse_combo_system.h"
+
+uint16_t BackendUI_GetRawMilli(uint16_t) { return 0; }
+void BackendUI_SetAnalogMilli(uint16_t, uint16_t) {}
+void Backend_SetMacroAnalog(uint16_t, float) {}
+void Backend_ClearMacroAnalog(uint16_t) {}
+void Backend_SetMacroAnalogForMs(uint16_t, float, uint32_t) {}
+
+uint16_t VkToHid(WORD vk) { return KeyTable_VkToHid(vk); }
+WORD HidToVk(uint16_t hid) { return KeyTable_HidToVk(hid); }
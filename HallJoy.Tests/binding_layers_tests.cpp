@@ -0,0 +1,273 @@
+// binding_layers_tests.cpp
+// Binding layers: a layer key switches on the tick it goes down, and a
+// random press / release replay against a reference resolver shows no
+// stuck or missing output across layer transitions. Benchmark: ns per pad.
+#include "test.h"
+
+#include "../HallJoy/binding_layers.h"
+
+namespace
+{
+    constexpr uint16_t kFirstHid = 4;    // ordinary keys 4..19
+    constexpr int      kKeys = 16;
+    constexpr uint16_t kHold1 = 20, kToggle2 = 21, kHold3 = 22, kToggle1 = 23;
+
+    // What the pad sends: button bits, axis directions (axis * 2 + plus), triggers
+    struct Output
+    {
+        uint32_t buttons = 0;
+        uint32_t axisDirs = 0;
+        uint32_t triggers = 0;
+        bool operator==(const Output& o) const { return buttons == o.buttons && axisDirs == o.axisDirs && triggers == o.triggers; }
+        bool Any() const { return buttons || axisDirs || triggers; }
+    };
+
+    bool Held(const uint64_t (&down)[4], uint16_t hid)
+    {
+        return hid != 0 && ((down[hid / 64] >> (hid % 64)) & 1ull);
+    }
+
+    void SetHeld(uint64_t (&down)[4], uint16_t hid, bool on)
+    {
+        const uint64_t bit = 1ull << (hid % 64);
+        down[hid / 64] = on ? (down[hid / 64] | bit) : (down[hid / 64] & ~bit);
+    }
+
+    bool Binds(const PadBindings& b, uint16_t hid)
+    {
+        for (const AxisBinding& a : b.axes) if (a.minusHid == hid || a.plusHid == hid) return true;
+        for (uint16_t t : b.triggers) if (t == hid) return true;
+        for (const auto& btn : b.buttons) if ((btn[hid / 64] >> (hid % 64)) & 1ull) return true;
+        return false;
+    }
+
+    void AddOutputs(const PadBindings& b, uint16_t hid, Output& out)
+    {
+        for (int i = 0; i < BINDINGS_BUTTON_COUNT; ++i)
+            if ((b.buttons[i][hid / 64] >> (hid % 64)) & 1ull) out.buttons |= 1u << i;
+        for (int a = 0; a < 4; ++a) {
+            if (b.axes[a].minusHid == hid) out.axisDirs |= 1u << (a * 2);
+            if (b.axes[a].plusHid == hid) out.axisDirs |= 1u << (a * 2 + 1);
+        }
+        for (int t = 0; t < 2; ++t)
+            if (b.triggers[t] == hid) out.triggers |= 1u << t;
+    }
+
+    // What the compiled tables give for the held keys
+    Output Resolve(const PadBindings& applied, const uint64_t (&down)[4])
+    {
+        Output out;
+        for (int i = 0; i < BINDINGS_BUTTON_COUNT; ++i)
+            for (int c = 0; c < 4; ++c)
+                if (applied.buttons[i][c] & down[c]) out.buttons |= 1u << i;
+        for (int a = 0; a < 4; ++a) {
+            if (Held(down, applied.axes[a].minusHid)) out.axisDirs |= 1u << (a * 2);
+            if (Held(down, applied.axes[a].plusHid)) out.axisDirs |= 1u << (a * 2 + 1);
+        }
+        for (int t = 0; t < 2; ++t)
+            if (Held(down, applied.triggers[t])) out.triggers |= 1u << t;
+        return out;
+    }
+
+    // Reference: each held key does what its highest active binding layer says
+    Output Reference(const PadBindings& base, const PadLayers& layers, uint8_t active, const uint64_t (&down)[4])
+    {
+        Output out;
+        for (uint16_t hid = kFirstHid; hid < kFirstHid + kKeys; ++hid) {
+            if (!Held(down, hid)) continue;
+            const PadBindings* b = &base;
+            for (int l = BINDING_LAYERS - 2; l >= 0; --l)
+                if ((active >> l) & 1 && Binds(layers.layers[l], hid)) { b = &layers.layers[l]; break; }
+            AddOutputs(*b, hid, out);
+        }
+        return out;
+    }
+
+    struct Rng
+    {
+        uint32_t s;
+        uint32_t Next() { s = s * 1664525u + 1013904223u; return s >> 8; }
+    };
+
+    void BindButton(PadBindings& b, uint16_t hid, int button)
+    {
+        b.buttons[button][hid / 64] |= 1ull << (hid % 64);
+    }
+
+    // Base: buttons, left stick, LT. Layers: buttons, and each layer alone
+    // on its own slots (1: right stick X, 2: right stick Y, 3: RT) so a
+    // single-HID slot is never claimed by two layers.
+    void RandomConfig(Rng& rng, PadBindings& base, PadLayers& layers)
+    {
+        base = PadBindings{};
+        layers = PadLayers{};
+        auto key = [&] { return (uint16_t)(kFirstHid + rng.Next() % kKeys); };
+        for (uint16_t hid = kFirstHid; hid < kFirstHid + kKeys; ++hid)
+            if (rng.Next() % 2) BindButton(base, hid, (int)(rng.Next() % BINDINGS_BUTTON_COUNT));
+        base.axes[(int)Axis::LX] = { key(), key() };
+        base.axes[(int)Axis::LY] = { key(), key() };
+        base.triggers[(int)Trigger::LT] = key();
+
+        for (int l = 0; l < BINDING_LAYERS - 1; ++l)
+            for (uint16_t hid = kFirstHid; hid < kFirstHid + kKeys; ++hid)
+                if (rng.Next() % 3 == 0) BindButton(layers.layers[l], hid, (int)(rng.Next() % BINDINGS_BUTTON_COUNT));
+        layers.layers[0].axes[(int)Axis::RX] = { key(), key() };
+        layers.layers[1].axes[(int)Axis::RY] = { key(), key() };
+        layers.layers[2].triggers[(int)Trigger::RT] = key();
+
+        layers.keys[0] = { kHold1, 1, LayerKeyMode::Hold };
+        layers.keys[1] = { kToggle2, 2, LayerKeyMode::Toggle };
+        layers.keys[2] = { kHold3, 3, LayerKeyMode::Hold };
+        layers.keys[3] = { kToggle1, 1, LayerKeyMode::Toggle };
+        layers.keyCount = 4;
+    }
+}
+
+TEST(Layers_SwitchOnTheSameTick)
+{
+    // W (26) is LY- on layer 0 and button A on layer 1 (hold key 20)
+    PadBindings base;
+    base.axes[(int)Axis::LY].minusHid = 26;
+    PadLayers layers;
+    BindButton(layers.layers[0], 26, (int)GameButton::A);
+    layers.keys[0] = { 20, 1, LayerKeyMode::Hold };
+    layers.keyCount = 1;
+    PadLayerTable t;
+    BindingLayers_Compile(layers, t);
+
+    PadLayerState st;
+    uint64_t down[4]{};
+    PadBindings applied;
+    auto tick = [&] {
+        BindingLayers_Apply(t, BindingLayers_Update(t, st, down), base, applied);
+        return Resolve(applied, down);
+    };
+
+    SetHeld(down, 26, true);
+    CHECK_EQ(tick().axisDirs, 1u << ((int)Axis::LY * 2));
+    SetHeld(down, 20, true);                  // layer key down: this tick already
+    Output o = tick();
+    CHECK_EQ(o.axisDirs, 0u);
+    CHECK_EQ(o.buttons, 1u << (int)GameButton::A);
+    SetHeld(down, 20, false);                 // back, W still held
+    o = tick();
+    CHECK_EQ(o.buttons, 0u);
+    CHECK_EQ(o.axisDirs, 1u << ((int)Axis::LY * 2));
+    SetHeld(down, 26, false);
+    CHECK(!tick().Any());
+}
+
+TEST(Layers_ToggleFlipsOnPressEdges)
+{
+    PadLayers layers;
+    layers.keys[0] = { 30, 2, LayerKeyMode::Toggle };
+    layers.keyCount = 1;
+    PadLayerTable t;
+    BindingLayers_Compile(layers, t);
+    PadLayerState st;
+    uint64_t down[4]{};
+
+    CHECK_EQ(BindingLayers_Update(t, st, down), 0);
+    SetHeld(down, 30, true);
+    CHECK_EQ(BindingLayers_Update(t, st, down), 2);
+    CHECK_EQ(BindingLayers_Update(t, st, down), 2);   // held: no new edge
+    SetHeld(down, 30, false);
+    CHECK_EQ(BindingLayers_Update(t, st, down), 2);
+    SetHeld(down, 30, true);
+    CHECK_EQ(BindingLayers_Update(t, st, down), 0);
+
+    // Bad keys are dropped; no key left = layer 0 as is
+    PadLayers bad;
+    bad.keys[0] = { 0, 1, LayerKeyMode::Hold };
+    bad.keys[1] = { 40, 4, LayerKeyMode::Hold };
+    bad.keys[2] = { 300, 1, LayerKeyMode::Hold };
+    bad.keyCount = 3;
+    BindingLayers_Compile(bad, t);
+    CHECK_EQ(t.keyCount, 0);
+}
+
+TEST(Layers_ReplayNoStuckButtons)
+{
+    Rng rng{ 11 };
+    int compared = 0;
+    for (int config = 0; config < 200; ++config) {
+        PadBindings base;
+        PadLayers layers;
+        RandomConfig(rng, base, layers);
+        PadLayerTable t;
+        BindingLayers_Compile(layers, t);
+
+        PadLayerState st;
+        uint8_t refToggled = 0;
+        bool refPrev[4]{};
+        uint64_t down[4]{};
+        PadBindings applied;
+
+        auto tick = [&] {
+            const uint8_t active = BindingLayers_Update(t, st, down);
+            BindingLayers_Apply(t, active, base, applied);
+
+            uint8_t hold = 0;
+            for (int i = 0; i < layers.keyCount; ++i) {
+                const LayerKey& k = layers.keys[i];
+                const bool on = Held(down, k.hid);
+                if (on && k.mode == LayerKeyMode::Hold) hold |= (uint8_t)(1u << (k.layer - 1));
+                if (on && !refPrev[i] && k.mode == LayerKeyMode::Toggle) refToggled ^= (uint8_t)(1u << (k.layer - 1));
+                refPrev[i] = on;
+            }
+            const uint8_t refActive = (uint8_t)(refToggled | hold);
+            CHECK_EQ(active, refActive);
+            CHECK(Resolve(applied, down) == Reference(base, layers, refActive, down));
+            ++compared;
+        };
+
+        for (int step = 0; step < 2000; ++step) {
+            // Mostly ordinary keys, a layer key one time in four
+            const uint32_t r = rng.Next();
+            const uint16_t hid = (r % 4 == 0) ? (uint16_t)(kHold1 + (r >> 4) % 4) : (uint16_t)(kFirstHid + (r >> 4) % kKeys);
+            SetHeld(down, hid, !Held(down, hid));
+            tick();
+            if (Test::Failures()) return;
+        }
+
+        // Everything released, in random order, layers switching meanwhile
+        for (uint16_t hid = kFirstHid; hid <= kToggle1; ++hid) {
+            const uint16_t h = (uint16_t)(kFirstHid + (hid * 7 + config) % (kToggle1 - kFirstHid + 1));
+            SetHeld(down, h, false);
+            tick();
+        }
+        BindingLayers_Apply(t, BindingLayers_Update(t, st, down), base, applied);
+        CHECK(!Resolve(applied, down).Any());
+        if (Test::Failures()) return;
+    }
+    CHECK(compared > 400000);
+}
+
+BENCH(Layers_ResolvePerPad)
+{
+    Rng rng{ 3 };
+    PadBindings base;
+    PadLayers layers;
+    RandomConfig(rng, base, layers);
+    PadLayerTable t;
+    const double c0 = Test::NowSec();
+    for (int i = 0; i < 100; ++i) BindingLayers_Compile(layers, t);
+    const double compileUs = (Test::NowSec() - c0) * 1e6 / 100;
+
+    constexpr int kTicks = 1000000;
+    PadLayerState st;
+    uint64_t down[4]{};
+    PadBindings applied;
+    uint32_t sink = 0;
+    const double t0 = Test::NowSec();
+    for (int i = 0; i < kTicks; ++i) {
+        const uint32_t r = rng.Next();
+        const uint16_t hid = (r % 4 == 0) ? (uint16_t)(kHold1 + (r >> 4) % 4) : (uint16_t)(kFirstHid + (r >> 4) % kKeys);
+        SetHeld(down, hid, !Held(down, hid));
+        BindingLayers_Apply(t, BindingLayers_Update(t, st, down), base, applied);
+        sink += (uint32_t)applied.buttons[0][0] + applied.axes[0].minusHid;
+    }
+    const double ns = (Test::NowSec() - t0) * 1e9 / kTicks;
+    std::printf("  update + apply %.1f ns / pad (%u), compile %.1f us\n", ns, sink, compileUs);
+    CHECK(ns < 5000.0);
+}
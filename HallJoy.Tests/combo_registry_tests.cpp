@@ -0,0 +1,189 @@
+// combo_registry_tests.cpp
+// Stable combo ids: SlotMap handles, ids across delete / reorder in
+// FreeComboSystem. Benchmark: event dispatch latency while a UI-style
+// thread edits, reorders, creates and deletes combos.
+#include "test.h"
+
+#include "../HallJoy/combo_sim.h"
+#include "../HallJoy/free_combo_system.h"
+#include "../HallJoy/slot_map.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+
+namespace
+{
+    struct Engine
+    {
+        Engine() { FreeComboSystem::Initialize(); }
+        ~Engine()
+        {
+            for (int id : FreeComboSystem::GetAllIds()) FreeComboSystem::DeleteCombo(id);
+            FreeComboSystem::Shutdown();
+        }
+    };
+
+    int AddKeyCombo(WORD vk, const wchar_t* name = L"test")
+    {
+        const int id = FreeComboSystem::CreateCombo(name);
+        FreeTrigger t;
+        t.keyType = FreeTriggerKeyType::Keyboard;
+        t.vkCode = vk;
+        FreeComboSystem::SetTrigger(id, t);
+        ComboAction a;
+        a.type = ComboActionType::TapKey;
+        a.keyHid = 4;
+        FreeComboSystem::AddAction(id, a);
+        return id;
+    }
+
+    double Percentile(std::vector<double> v, double p)
+    {
+        if (v.empty()) return 0.0;
+        std::sort(v.begin(), v.end());
+        return v[std::min(v.size() - 1, (size_t)(p * (double)v.size()))];
+    }
+}
+
+TEST(SlotMap_StaleHandleStopsResolving)
+{
+    SlotMap<std::string> m;
+    const int a = m.Insert("a");
+    const int b = m.Insert("b");
+    CHECK(a > 0 && b > 0 && a != b);
+    CHECK(m.Get(a) && *m.Get(a) == "a");
+    CHECK_EQ(m.Size(), 2u);
+
+    CHECK(m.Erase(a));
+    CHECK(!m.Erase(a));
+    CHECK(m.Get(a) == nullptr);
+
+    // The slot is reused under a new generation: the old handle stays dead
+    const int c = m.Insert("c");
+    CHECK_EQ(SlotMap<std::string>::SlotOf(c), SlotMap<std::string>::SlotOf(a));
+    CHECK(c != a);
+    CHECK(m.Get(a) == nullptr);
+    CHECK(m.Get(c) && *m.Get(c) == "c");
+    CHECK(m.Get(-1) == nullptr);
+    CHECK(m.Get(12345678) == nullptr);
+}
+
+TEST(SlotMap_PointersSurviveGrowth)
+{
+    SlotMap<int> m;
+    const int first = m.Insert(42);
+    int* p = m.Get(first);
+    for (int i = 0; i < 10000; ++i) m.Insert(i);
+    CHECK(m.Get(first) == p);
+    CHECK_EQ(*p, 42);
+    CHECK_EQ(m.HandleAt(SlotMap<int>::SlotOf(first)), first);
+
+    m.Clear();
+    CHECK_EQ(m.Size(), 0u);
+    CHECK(m.Get(first) == nullptr);
+    CHECK_EQ(m.HandleAt(SlotMap<int>::SlotOf(first)), -1);
+}
+
+TEST(SlotMap_GenerationWrapsPositive)
+{
+    SlotMap<int> m;
+    int h = m.Insert(0);
+    for (uint32_t i = 0; i < SlotMap<int>::kMaxGeneration + 5; ++i) {
+        CHECK(m.Erase(h));
+        h = m.Insert((int)i);
+        CHECK(h > 0);
+        if (Test::Failures()) return;
+    }
+    CHECK_EQ(m.SlotCount(), 1u);
+}
+
+TEST(Registry_IdsSurviveDeleteAndReorder)
+{
+    Engine engine;
+    const int a = AddKeyCombo(VK_F5, L"a");
+    const int b = AddKeyCombo(VK_F6, L"b");
+    const int c = AddKeyCombo(VK_F7, L"c");
+
+    CHECK(FreeComboSystem::DeleteCombo(a));
+    CHECK(FreeComboSystem::GetCombo(a) == nullptr);
+    CHECK(!FreeComboSystem::DeleteCombo(a));
+    CHECK(FreeComboSystem::GetCombo(b) && FreeComboSystem::GetCombo(b)->name == L"b");
+    CHECK(FreeComboSystem::GetCombo(c) && FreeComboSystem::GetCombo(c)->name == L"c");
+
+    CHECK(FreeComboSystem::SwapCombos(b, c));
+    CHECK((FreeComboSystem::GetAllIds() == std::vector<int>{ c, b }));
+    const int d = AddKeyCombo(VK_F8, L"d");
+    CHECK(d != a);
+    CHECK(FreeComboSystem::MoveCombo(2, 0));
+    CHECK((FreeComboSystem::GetAllIds() == std::vector<int>{ d, c, b }));
+    CHECK(FreeComboSystem::GetCombo(b) && FreeComboSystem::GetCombo(b)->name == L"b");
+
+    // Triggers still resolve to their own combo after the shuffle
+    ComboSimulator sim;
+    sim.KeyDown(VK_F6); sim.KeyUp(VK_F6);
+    sim.KeyDown(VK_F5); sim.KeyUp(VK_F5);
+    CHECK_EQ(sim.FireCount(b), 1u);
+    CHECK_EQ(sim.FireCount(c), 0u);
+    CHECK_EQ(sim.Stats().fired, 1u);
+}
+
+BENCH(Registry_DispatchUnderUiEdits)
+{
+    // 26 letter combos dispatched; the "UI" thread creates, edits, reorders
+    // and deletes its own F13..F24 combos without pause.
+    Engine engine;
+    for (int i = 0; i < 26; ++i) AddKeyCombo((WORD)('A' + i));
+
+    ComboSimulator sim;
+    sim.SetRecording(false);
+    constexpr int kPresses = 20000;
+
+    auto dispatch = [&](std::vector<double>& latUs) {
+        latUs.clear();
+        latUs.reserve(kPresses);
+        const uint64_t before = sim.Stats().fired;
+        for (int i = 0; i < kPresses; ++i) {
+            const WORD vk = (WORD)('A' + i % 26);
+            const double t0 = Test::NowSec();
+            sim.KeyDown(vk);
+            latUs.push_back((Test::NowSec() - t0) * 1e6);
+            sim.KeyUp(vk);
+        }
+        return sim.Stats().fired - before;
+    };
+
+    std::vector<double> idle, busy;
+    const uint64_t idleFires = dispatch(idle);
+
+    std::atomic<bool> stop{ false };
+    std::atomic<uint64_t> edits{ 0 };
+    std::thread ui([&] {
+        uint32_t n = 0;
+        while (!stop.load()) {
+            const int id = AddKeyCombo((WORD)(VK_F13 + n % 12), L"ui");
+            FreeComboSystem::SetEnabled(id, (n & 1) != 0);
+            FreeComboSystem::SetRepeat(id, true, 100 + n % 50);
+            const std::vector<int> ids = FreeComboSystem::GetAllIds();
+            FreeComboSystem::SwapCombos(ids[n % ids.size()], ids[(n * 7 + 3) % ids.size()]);
+            FreeComboSystem::MoveCombo((int)(n % ids.size()), 0);
+            FreeComboSystem::DeleteCombo(id);
+            edits.fetch_add(7, std::memory_order_relaxed);
+            ++n;
+        }
+    });
+    const double t0 = Test::NowSec();
+    const uint64_t busyFires = dispatch(busy);
+    const double sec = Test::NowSec() - t0;
+    stop.store(true);
+    ui.join();
+
+    std::printf("  %u hardware threads, %.0f UI edits / s during dispatch\n",
+        std::thread::hardware_concurrency(), (double)edits.load() / sec);
+    std::printf("  key down, idle: p50 %.2f us, p99 %.2f us\n", Percentile(idle, 0.5), Percentile(idle, 0.99));
+    std::printf("  key down, edits: p50 %.2f us, p99 %.2f us\n", Percentile(busy, 0.5), Percentile(busy, 0.99));
+    CHECK_EQ(idleFires, (uint64_t)kPresses);
+    CHECK_EQ(busyFires, (uint64_t)kPresses);
+    CHECK_EQ(FreeComboSystem::GetCount(), 26);
+}
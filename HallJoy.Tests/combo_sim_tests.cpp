@@ -0,0 +1,257 @@
+// combo_sim_tests.cpp
+// FreeComboSystem on the virtual clock (ComboSimulator): key and modifier
+// triggers, long press, repeat-while-held over a long run, mouse triggers,
+// cancel on release and the repeat rate limiter. Benchmark: simulated time per second of CPU.
+#include "test.h"
+
+#include "../HallJoy/combo_sim.h"
+#include "../HallJoy/free_combo_system.h"
+
+namespace
+{
+    // Engine up for one test, every combo deleted on the way out
+    struct Engine
+    {
+        Engine() { FreeComboSystem::Initialize(); }
+        ~Engine()
+        {
+            for (int id : FreeComboSystem::GetAllIds()) FreeComboSystem::DeleteCombo(id);
+            FreeComboSystem::Shutdown();
+        }
+    };
+
+    int AddKeyCombo(WORD vk, FreeTriggerModifier mod = FreeTriggerModifier::None)
+    {
+        const int id = FreeComboSystem::CreateCombo(L"test");
+        FreeTrigger t;
+        t.keyType = FreeTriggerKeyType::Keyboard;
+        t.vkCode = vk;
+        t.modifier = mod;
+        FreeComboSystem::SetTrigger(id, t);
+        ComboAction a;
+        a.type = ComboActionType::TapKey;
+        a.keyHid = 4;
+        FreeComboSystem::AddAction(id, a);
+        return id;
+    }
+}
+
+TEST(Sim_KeyTriggerFiresOncePerPress)
+{
+    Engine engine;
+    const int id = AddKeyCombo(VK_F8);
+    ComboSimulator sim;
+    for (int i = 0; i < 5; ++i) {
+        sim.KeyDown(VK_F8);
+        sim.Advance(50);
+        sim.KeyUp(VK_F8);
+        sim.Advance(200);
+    }
+    CHECK_EQ(sim.FireCount(id), 5u);
+    sim.KeyDown('A');
+    sim.KeyUp('A');
+    CHECK_EQ(sim.Stats().fired, 5u);
+}
+
+TEST(Sim_ModifierRequired)
+{
+    Engine engine;
+    const int id = AddKeyCombo('F', FreeTriggerModifier::Ctrl);
+    ComboSimulator sim;
+    sim.KeyDown('F'); sim.KeyUp('F');
+    CHECK_EQ(sim.FireCount(id), 0u);
+    sim.KeyDown(VK_LCONTROL);
+    sim.KeyDown('F'); sim.KeyUp('F');
+    sim.KeyUp(VK_LCONTROL);
+    CHECK_EQ(sim.FireCount(id), 1u);
+}
+
+TEST(Sim_LongPressFiresAtDeadlineOnly)
+{
+    Engine engine;
+    const int id = AddKeyCombo(VK_F9);
+    FreeComboSystem::GetCombo(id)->longPressEnabled = true;
+    FreeComboSystem::GetCombo(id)->longPressMs = 500;
+    ComboSimulator sim(1);
+
+    sim.KeyDown(VK_F9);
+    sim.Advance(300);
+    sim.KeyUp(VK_F9);
+    sim.Advance(1000);
+    CHECK_EQ(sim.FireCount(id), 0u);
+
+    sim.ClearRecords();
+    const uint32_t pressAt = sim.NowMs();
+    sim.KeyDown(VK_F9);
+    sim.Advance(2000);
+    sim.KeyUp(VK_F9);
+    CHECK_EQ(sim.FireCount(id), 1u);
+    CHECK(!sim.Records().empty());
+    if (!sim.Records().empty()) {
+        const uint32_t at = sim.Records().front().timeMs - pressAt;
+        CHECK(at >= 500 && at <= 502);
+    }
+}
+
+TEST(Sim_RepeatWhileHeldForAnHour)
+{
+    Engine engine;
+    const int id = AddKeyCombo(VK_F10);
+    FreeComboSystem::SetRepeat(id, true, 100);
+    ComboSimulator sim(1);
+    sim.SetRecording(false);
+
+    sim.KeyDown(VK_F10);
+    sim.Advance(3600u * 1000u);
+    sim.KeyUp(VK_F10);
+    const uint64_t held = sim.FireCount(id);
+    sim.Advance(1000);
+    CHECK_EQ(sim.FireCount(id), held);   // nothing after the release
+    // First fire at the press, then one every 100 ms, no drift over the hour
+    CHECK(held >= 36000 && held <= 36001);
+}
+
+TEST(Sim_MouseButtonTrigger)
+{
+    Engine engine;
+    const int id = FreeComboSystem::CreateCombo(L"mouse");
+    FreeTrigger t;
+    t.keyType = FreeTriggerKeyType::MouseX1;
+    FreeComboSystem::SetTrigger(id, t);
+    ComboSimulator sim;
+    sim.MouseDown(InputMouseButton::X1);
+    sim.MouseUp(InputMouseButton::X1);
+    sim.MouseDown(InputMouseButton::Left);
+    sim.MouseUp(InputMouseButton::Left);
+    CHECK_EQ(sim.FireCount(id), 1u);
+}
+
+TEST(Sim_CancelRequestedWhenTheTriggerIsReleased)
+{
+    using Ev = FreeComboSystem::ComboSimEvent;
+    Engine engine;
+    const int id = AddKeyCombo(VK_F8);
+    FreeComboSystem::SetCancelOnRelease(id, true);
+    ComboSimulator sim(1);
+
+    // Another key going up while F8 is held cancels nothing
+    sim.KeyDown(VK_F8);
+    sim.Advance(20);
+    sim.KeyDown('A');
+    sim.KeyUp('A');
+    CHECK_EQ(sim.Stats().cancels, 0u);
+    sim.Advance(20);
+    const uint32_t releaseAt = sim.NowMs();
+    sim.KeyUp(VK_F8);
+    CHECK_EQ(sim.FireCount(id), 1u);
+    CHECK_EQ(sim.Stats().cancels, 1u);
+    CHECK(!sim.Records().empty());
+    if (!sim.Records().empty()) {
+        CHECK(sim.Records().back().ev == Ev::CancelRequested);
+        CHECK_EQ(sim.Records().back().timeMs, releaseAt);
+    }
+
+    // The next press clears the flag: one cancel per release
+    sim.KeyDown(VK_F8);
+    sim.KeyUp(VK_F8);
+    CHECK_EQ(sim.Stats().cancels, 2u);
+
+    // Modifier trigger: letting go of Ctrl with F still down cancels too
+    const int ctrlF = AddKeyCombo('F', FreeTriggerModifier::Ctrl);
+    FreeComboSystem::SetCancelOnRelease(ctrlF, true);
+    sim.KeyDown(VK_LCONTROL);
+    sim.KeyDown('F');
+    CHECK_EQ(sim.FireCount(ctrlF), 1u);
+    sim.KeyUp(VK_LCONTROL);
+    CHECK_EQ(sim.Stats().cancels, 3u);
+    sim.KeyUp('F');
+    CHECK_EQ(sim.Stats().cancels, 3u);
+
+    // Off: releasing the trigger leaves the run alone
+    FreeComboSystem::SetCancelOnRelease(id, false);
+    sim.KeyDown(VK_F8);
+    sim.Advance(20);
+    sim.KeyUp(VK_F8);
+    CHECK_EQ(sim.Stats().cancels, 3u);
+}
+
+TEST(Sim_RateLimitStopsARunawayRepeat)
+{
+    using Ev = FreeComboSystem::ComboSimEvent;
+    Engine engine;
+    const int id = AddKeyCombo(VK_F11);
+    FreeComboSystem::SetRepeat(id, true, 5);   // 200 / s, four times the limit
+    ComboSimulator sim(1);
+
+    const uint32_t pressAt = sim.NowMs();
+    sim.KeyDown(VK_F11);
+    sim.Advance(2000);
+    CHECK_EQ(sim.Stats().rateLimitStops, 1u);
+    // The press, then 50 repeats in the window; the 51st is the hard stop
+    CHECK_EQ(sim.FireCount(id), 51u);
+
+    uint32_t stopAt = 0, lastFire = 0;
+    for (const ComboSimRecord& r : sim.Records()) {
+        if (r.ev == Ev::RateLimitStop) {
+            CHECK_EQ(r.comboId, id);
+            stopAt = r.timeMs;
+        } else if (r.ev == Ev::Fired) {
+            lastFire = r.timeMs;
+        }
+    }
+    CHECK_EQ(stopAt - pressAt, 51u * 5u);
+    CHECK(lastFire < stopAt);          // not re-armed: nothing after the stop
+
+    // Released past the window, the next press repeats again
+    sim.KeyUp(VK_F11);
+    sim.Advance(1000);
+    sim.ClearRecords();
+    sim.KeyDown(VK_F11);
+    sim.Advance(100);
+    sim.KeyUp(VK_F11);
+    CHECK_EQ(sim.FireCount(id), 21u);
+    CHECK_EQ(sim.Stats().rateLimitStops, 0u);
+}
+
+BENCH(Sim_Throughput)
+{
+    // 50 key combos (10 of them repeating), typing-like script, about 15 simulated minutes
+    Engine engine;
+    std::vector<int> ids;
+    for (int i = 0; i < 50; ++i) {
+        const int id = AddKeyCombo((WORD)('A' + i % 26), (FreeTriggerModifier)(i / 26));
+        if (i % 5 == 0) FreeComboSystem::SetRepeat(id, true, 150);
+        ids.push_back(id);
+    }
+
+    std::vector<ComboSimInput> script;
+    uint32_t at = 0, seed = 7;
+    for (int k = 0; k < 100000; ++k) {
+        seed = seed * 1103515245u + 12345u;
+        at += 2 + (seed >> 16) % 10;
+        ComboSimInput down;
+        down.atMs = at;
+        down.ev.type = InputEventType::KeyDown;
+        down.ev.code = (uint16_t)('A' + (seed >> 8) % 26);
+        ComboSimInput up = down;
+        up.atMs = at + 1 + (seed >> 20) % 3;
+        up.ev.type = InputEventType::KeyUp;
+        script.push_back(down);
+        script.push_back(up);
+        at = up.atMs;
+    }
+
+    ComboSimulator sim(1);
+    sim.SetRecording(false);
+    const double t0 = Test::NowSec();
+    sim.RunScript(script, 1000);
+    const double sec = Test::NowSec() - t0;
+
+    const ComboSimStats& st = sim.Stats();
+    std::printf("  %.0f s simulated in %.3f s (x%.0f), %llu events, %llu ticks, %llu fires\n",
+        sim.NowMs() / 1000.0, sec, sim.NowMs() / 1000.0 / sec,
+        (unsigned long long)st.inputEvents, (unsigned long long)st.ticks, (unsigned long long)st.fired);
+    std::printf("  %.0f ns / event + tick\n", sec * 1e9 / (double)(st.inputEvents + st.ticks));
+    CHECK(st.fired > 0);
+    CHECK(sim.NowMs() / 1000.0 / sec > 10.0);   // far faster than real time
+}
@@ -0,0 +1,496 @@
+// combo_store_tests.cpp
+// free_combos.dat on real files: V1..V5 import and the one-time .v5.bak,
+// one record appended per edit, torn tail / bad CRC recovery, compaction.
+// Benchmarks on 10,000 combos: full save, single-edit append, load.
+#include "test.h"
+
+#include "../HallJoy/combo_store.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const wchar_t* kPath = L"cs_test.dat";
+    const wchar_t* kBakPath = L"cs_test.dat.v5.bak";
+
+    bool ReadBytes(const wchar_t* path, std::vector<uint8_t>* out)
+    {
+        FILE* f = nullptr;
+        if (_wfopen_s(&f, path, L"rb") != 0 || !f) return false;
+        out->clear();
+        uint8_t chunk[4096];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) out->insert(out->end(), chunk, chunk + n);
+        fclose(f);
+        return true;
+    }
+
+    bool WriteBytes(const wchar_t* path, const void* data, size_t size)
+    {
+        FILE* f = nullptr;
+        if (_wfopen_s(&f, path, L"wb") != 0 || !f) return false;
+        const bool ok = fwrite(data, 1, size, f) == size;
+        return (fclose(f) == 0) && ok;
+    }
+
+    bool WriteText(const wchar_t* path, const std::string& text) { return WriteBytes(path, text.data(), text.size()); }
+
+    uint64_t FileSize(const wchar_t* path)
+    {
+        std::vector<uint8_t> data;
+        return ReadBytes(path, &data) ? data.size() : 0;
+    }
+
+    bool Exists(const wchar_t* path) { return GetFileAttributesW(path) != INVALID_FILE_ATTRIBUTES; }
+
+    ComboStoreStats Stats()
+    {
+        ComboStoreStats st;
+        ComboStore_GetStats(&st);
+        return st;
+    }
+
+    ComboAction Act(ComboActionType type, uint16_t hid, uint32_t ms = 0, const wchar_t* text = L"")
+    {
+        ComboAction a;
+        a.type = type;
+        a.keyHid = hid;
+        a.delayMs = ms;
+        a.text = text;
+        return a;
+    }
+
+    FreeCombo MakeCombo(uint32_t uid)
+    {
+        FreeCombo c;
+        c.uid = uid;
+        c.name = L"Combo " + std::to_wstring(uid);
+        c.trigger.modifier = (FreeTriggerModifier)(uid % 5);
+        c.trigger.keyType = FreeTriggerKeyType::Keyboard;
+        c.trigger.vkCode = (WORD)(0x41 + uid % 26);
+        c.trigger.analogParam = 40 + uid % 50;
+        c.repeatDelayMs = 100 + uid % 300;
+        c.cancelOnRelease = (uid & 1) != 0;
+        c.actions = { Act(ComboActionType::TapKey, (uint16_t)(4 + uid % 30)),
+                      Act(ComboActionType::Delay, 0, 20 + uid % 80),
+                      Act(ComboActionType::TypeText, 0, 0, L"gg wp") };
+        return c;
+    }
+
+    ComboLibrary MakeLibrary(uint32_t combos)
+    {
+        ComboLibrary lib;
+        lib.wlMode = 1;
+        lib.wheelCDEnabled = true;
+        lib.wheelCDMs = 90;
+        lib.whitelist = { L"game.exe", L"other.exe" };
+        lib.hasSettings = true;
+        for (uint32_t i = 1; i <= combos; ++i) lib.combos.push_back(MakeCombo(i));
+        return lib;
+    }
+
+    bool SameCombo(const FreeCombo& a, const FreeCombo& b)
+    {
+        if (a.uid != b.uid || a.name != b.name || a.actions.size() != b.actions.size()) return false;
+        if (a.trigger.modifier != b.trigger.modifier || a.trigger.keyType != b.trigger.keyType
+            || a.trigger.vkCode != b.trigger.vkCode || a.trigger.holdKeyType != b.trigger.holdKeyType
+            || a.trigger.holdVkCode != b.trigger.holdVkCode || a.trigger.keyTypeIsHold != b.trigger.keyTypeIsHold
+            || a.trigger.analogParam != b.trigger.analogParam) return false;
+        if (a.enabled != b.enabled || a.repeatWhileHeld != b.repeatWhileHeld || a.repeatDelayMs != b.repeatDelayMs
+            || a.isExample != b.isExample || a.repeatCount != b.repeatCount || a.cancelOnRelease != b.cancelOnRelease
+            || a.longPressEnabled != b.longPressEnabled || a.longPressMs != b.longPressMs) return false;
+        for (size_t i = 0; i < a.actions.size(); ++i) {
+            const ComboAction& x = a.actions[i];
+            const ComboAction& y = b.actions[i];
+            if (x.type != y.type || x.keyHid != y.keyHid || x.delayMs != y.delayMs
+                || x.mouseButton != y.mouseButton || x.text != y.text) return false;
+        }
+        return true;
+    }
+
+    bool SameLibrary(const ComboLibrary& a, const ComboLibrary& b)
+    {
+        if (a.combos.size() != b.combos.size() || a.wlMode != b.wlMode || a.wheelCDEnabled != b.wheelCDEnabled
+            || a.wheelCDMs != b.wheelCDMs || a.whitelist != b.whitelist) return false;
+        for (size_t i = 0; i < a.combos.size(); ++i)
+            if (!SameCombo(a.combos[i], b.combos[i])) return false;
+        return true;
+    }
+
+    bool LoadMatches(const wchar_t* path, const ComboLibrary& expected)
+    {
+        ComboLibrary lib;
+        return ComboStore_Load(path, &lib) && SameLibrary(lib, expected);
+    }
+
+    void RemoveFiles(const wchar_t* path)
+    {
+        const std::wstring p = path;
+        DeleteFileW(p.c_str());
+        DeleteFileW((p + L".tmp").c_str());
+        DeleteFileW((p + L".v5.bak").c_str());
+    }
+
+    // One combo in each legacy text format
+    const char* kLegacyV1 =
+        "DRDRE_FREECOMBOS_V1\n1\nOld one\n"
+        "2 1 65\n"
+        "1 0 250 0\n"
+        "2\n3 4 0 0\n6 0 50 0\n";
+    const char* kLegacyV2 =
+        "DRDRE_FREECOMBOS_V2\n1\nTwo\n"
+        "1 1 66 2 0\n"
+        "1 1 300 0\n"
+        "1\n4 0 0 0 hi there\n";
+    const char* kLegacyV3 =
+        "DRDRE_FREECOMBOS_V3\n1\nThree\n"
+        "3 1 67 1 68 1 70\n"
+        "0 0 400 1\n"
+        "2\n4 0 0 0\nabc\n3 5 0 0\n__EMPTY__\n";
+    const char* kLegacyV4 =
+        "DRDRE_FREECOMBOS_V4\n1\nFour\n"
+        "0 1 69 0 0 0 50\n"
+        "1 1 100 0 3 1 1 700\n"
+        "1\n5 0 0 1\n__EMPTY__\n";
+    const char* kLegacyV5 =
+        "DRDRE_FREECOMBOS_V5\nWL_MODE 2\nWHEEL_CD 1 90\nWL_COUNT 2\nWL_ENTRY game.exe\nWL_ENTRY other.exe\n"
+        "2\nFive\n"
+        "0 1 70 0 0 0 50\n"
+        "1 0 400 0 0 0 0 500\n"
+        "1\n3 6 0 0\n__EMPTY__\n"
+        "Five b\n"
+        "4 1 71 0 0 0 60\n"
+        "1 0 400 0 0 0 0 500\n"
+        "0\n";
+}
+
+TEST(ComboStore_ImportsV1ToV5)
+{
+    ComboLibrary lib;
+
+    CHECK(WriteText(kPath, kLegacyV1) && ComboStore_Load(kPath, &lib));
+    CHECK(Stats().legacy);
+    CHECK(!lib.hasSettings);
+    CHECK_EQ(lib.combos.size(), 1u);
+    if (lib.combos.size() == 1) {
+        const FreeCombo& c = lib.combos[0];
+        CHECK(c.name == L"Old one");
+        CHECK(c.trigger.modifier == FreeTriggerModifier::Shift && c.trigger.vkCode == 65);
+        CHECK(c.enabled && c.repeatDelayMs == 250);
+        CHECK_EQ(c.actions.size(), 2u);
+        CHECK(c.actions[0].type == ComboActionType::TapKey && c.actions[0].keyHid == 4);
+        CHECK(c.actions[1].type == ComboActionType::Delay && c.actions[1].delayMs == 50);
+        CHECK_EQ(c.uid, 0u);                           // assigned by the first save
+    }
+
+    CHECK(WriteText(kPath, kLegacyV2) && ComboStore_Load(kPath, &lib));
+    CHECK_EQ(lib.combos.size(), 1u);
+    if (lib.combos.size() == 1) {
+        const FreeCombo& c = lib.combos[0];
+        CHECK(c.trigger.holdKeyType == FreeTriggerKeyType::MouseLeft);
+        CHECK_EQ(c.trigger.analogParam, 50u);          // not in V2: default
+        CHECK(c.repeatWhileHeld);
+        CHECK(c.actions.size() == 1 && c.actions[0].text == L"hi there");
+    }
+
+    CHECK(WriteText(kPath, kLegacyV3) && ComboStore_Load(kPath, &lib));
+    CHECK_EQ(lib.combos.size(), 1u);
+    if (lib.combos.size() == 1) {
+        const FreeCombo& c = lib.combos[0];
+        CHECK(c.trigger.holdVkCode == 68 && c.trigger.keyTypeIsHold && c.trigger.analogParam == 70);
+        CHECK(!c.enabled && c.isExample);
+        CHECK_EQ(c.actions.size(), 2u);
+        if (c.actions.size() == 2) {
+            CHECK(c.actions[0].text == L"abc");
+            CHECK(c.actions[1].text.empty() && c.actions[1].keyHid == 5);
+        }
+    }
+
+    CHECK(WriteText(kPath, kLegacyV4) && ComboStore_Load(kPath, &lib));
+    CHECK_EQ(lib.combos.size(), 1u);
+    if (lib.combos.size() == 1) {
+        const FreeCombo& c = lib.combos[0];
+        CHECK_EQ(c.repeatCount, 3u);
+        CHECK(c.cancelOnRelease && c.longPressEnabled);
+        CHECK_EQ(c.longPressMs, 700u);
+        CHECK(c.actions.size() == 1 && c.actions[0].mouseButton == 1);
+    }
+    CHECK(!lib.hasSettings);
+
+    CHECK(WriteText(kPath, kLegacyV5) && ComboStore_Load(kPath, &lib));
+    CHECK(lib.hasSettings);
+    CHECK_EQ(lib.wlMode, 2);
+    CHECK(lib.wheelCDEnabled && lib.wheelCDMs == 90);
+    CHECK(lib.whitelist == std::vector<std::wstring>({ L"game.exe", L"other.exe" }));
+    CHECK_EQ(lib.combos.size(), 2u);
+    if (lib.combos.size() == 2) {
+        CHECK(lib.combos[1].name == L"Five b" && lib.combos[1].actions.empty());
+        CHECK_EQ(lib.combos[1].trigger.analogParam, 60u);
+    }
+
+    // Unknown header, empty file: unreadable
+    CHECK(WriteText(kPath, "DRDRE_FREECOMBOS_V9\n0\n"));
+    CHECK(!ComboStore_Load(kPath, &lib));
+    CHECK(WriteText(kPath, ""));
+    CHECK(!ComboStore_Load(kPath, &lib));
+    RemoveFiles(kPath);
+}
+
+TEST(ComboStore_BacksUpTheLegacyFileOnlyOnTheFirstWrite)
+{
+    RemoveFiles(kPath);
+    CHECK(WriteText(kPath, kLegacyV5));
+    ComboLibrary lib;
+    CHECK(ComboStore_Load(kPath, &lib));
+    for (size_t i = 0; i < lib.combos.size(); ++i) lib.combos[i].uid = (uint32_t)(i + 1);
+
+    // First write: the text file is kept as .v5.bak, the journal replaces it
+    CHECK(ComboStore_Write(kPath, lib));
+    std::vector<uint8_t> bak, dat;
+    CHECK(ReadBytes(kBakPath, &bak));
+    CHECK(bak.size() == std::strlen(kLegacyV5) && std::memcmp(bak.data(), kLegacyV5, bak.size()) == 0);
+    CHECK(ReadBytes(kPath, &dat) && dat.size() >= 4 && std::memcmp(dat.data(), "DCJ6", 4) == 0);
+    CHECK(LoadMatches(kPath, lib));
+    CHECK(!Stats().legacy);
+
+    // Later writes, appends and full rewrites alike, never make another one
+    DeleteFileW(kBakPath);
+    lib.combos[0].name = L"Renamed";
+    CHECK(ComboStore_Write(kPath, lib));
+    CHECK(!Exists(kBakPath));
+    CHECK(ComboStore_Write(L"cs_test_other.dat", lib));   // another path: full snapshot there
+    CHECK(ComboStore_Write(kPath, lib));                   // and a full snapshot back here
+    CHECK(!Exists(kBakPath));
+    CHECK(!Exists(L"cs_test_other.dat.v5.bak"));
+    RemoveFiles(L"cs_test_other.dat");
+
+    // An explicit import works the same; an existing backup is never overwritten
+    CHECK(WriteText(kPath, kLegacyV1));
+    CHECK(WriteText(kBakPath, "older backup"));
+    CHECK(ComboStore_ImportLegacy(kPath, &lib));
+    lib.combos[0].uid = 7;
+    CHECK(ComboStore_Write(kPath, lib));
+    CHECK(ReadBytes(kBakPath, &bak) && std::string(bak.begin(), bak.end()) == "older backup");
+
+    // A failed import leaves nothing to back up
+    RemoveFiles(kPath);
+    CHECK(!ComboStore_ImportLegacy(kPath, &lib));
+    CHECK(ComboStore_Write(kPath, MakeLibrary(2)));
+    CHECK(!Exists(kBakPath));
+    RemoveFiles(kPath);
+}
+
+TEST(ComboStore_EditAppendsOneRecord)
+{
+    RemoveFiles(kPath);
+    ComboLibrary lib = MakeLibrary(50);
+    CHECK(ComboStore_Write(kPath, lib));
+    const uint32_t rewrites = Stats().rewrites;
+    const uint64_t full = FileSize(kPath);
+
+    // Nothing changed: nothing written
+    CHECK(ComboStore_Write(kPath, lib));
+    CHECK_EQ(Stats().lastAppended, 0u);
+    CHECK_EQ(FileSize(kPath), full);
+
+    // One combo edited: one Combo record, the size of that combo
+    lib.combos[17].actions.push_back(Act(ComboActionType::TapKey, 9));
+    CHECK(ComboStore_Write(kPath, lib));
+    ComboStoreStats st = Stats();
+    CHECK_EQ(st.lastAppended, 1u);
+    CHECK_EQ(st.rewrites, rewrites);
+    const uint64_t grown = FileSize(kPath) - full;
+    CHECK(grown > 0 && grown < full / 40);
+    CHECK_EQ(st.fileBytes, FileSize(kPath));
+    CHECK(LoadMatches(kPath, lib));
+
+    // Deleted: a Delete and the new Order. Moved: the Order alone. Settings: one record.
+    lib.combos.erase(lib.combos.begin() + 3);
+    CHECK(ComboStore_Write(kPath, lib));
+    CHECK_EQ(Stats().lastAppended, 2u);
+    std::swap(lib.combos[0], lib.combos[1]);
+    CHECK(ComboStore_Write(kPath, lib));
+    CHECK_EQ(Stats().lastAppended, 1u);
+    lib.whitelist.push_back(L"third.exe");
+    CHECK(ComboStore_Write(kPath, lib));
+    CHECK_EQ(Stats().lastAppended, 1u);
+
+    // New combo at the end: its record and the order
+    lib.combos.push_back(MakeCombo(500));
+    CHECK(ComboStore_Write(kPath, lib));
+    CHECK_EQ(Stats().lastAppended, 2u);
+    CHECK_EQ(Stats().rewrites, rewrites);
+    CHECK(LoadMatches(kPath, lib));
+
+    // The reloaded journal appends as well
+    lib.combos[5].name = L"After reload";
+    CHECK(ComboStore_Write(kPath, lib));
+    CHECK_EQ(Stats().lastAppended, 1u);
+    CHECK(LoadMatches(kPath, lib));
+    RemoveFiles(kPath);
+}
+
+TEST(ComboStore_RecoversFromATornTailOrABadCrc)
+{
+    enum class Damage { Truncated, BadCrc, BadLength };
+    for (Damage damage : { Damage::Truncated, Damage::BadCrc, Damage::BadLength }) {
+        RemoveFiles(kPath);
+        const ComboLibrary before = MakeLibrary(20);
+        ComboLibrary after = before;
+        after.combos[9].name = L"Edited";
+        CHECK(ComboStore_Write(kPath, before));
+        const uint64_t intact = FileSize(kPath);
+        CHECK(ComboStore_Write(kPath, after));
+        CHECK_EQ(Stats().lastAppended, 1u);
+
+        // Damage the appended record
+        std::vector<uint8_t> data;
+        CHECK(ReadBytes(kPath, &data));
+        switch (damage) {
+        case Damage::Truncated: data.resize(data.size() - 3); break;
+        case Damage::BadCrc:    data.back() ^= 0x40; break;
+        case Damage::BadLength: data[(size_t)intact + 3] = 0x7F; break;
+        }
+        CHECK(WriteBytes(kPath, data.data(), data.size()));
+
+        // The damaged record is dropped, everything before it is there
+        ComboLibrary lib;
+        CHECK(ComboStore_Load(kPath, &lib));
+        ComboStoreStats st = Stats();
+        CHECK(st.tornTail);
+        CHECK_EQ(st.fileBytes, intact);
+        CHECK(SameLibrary(lib, before));
+
+        // The next save rewrites the whole file, clean
+        const uint32_t rewrites = st.rewrites;
+        CHECK(ComboStore_Write(kPath, after));
+        CHECK_EQ(Stats().rewrites, rewrites + 1);
+        CHECK(LoadMatches(kPath, after));
+        CHECK(!Stats().tornTail);
+        CHECK_EQ(FileSize(kPath), Stats().fileBytes);
+    }
+
+    // Deleted or truncated behind the store's back: the next save is a whole file, not an orphan append
+    ComboLibrary lib = MakeLibrary(20);
+    CHECK(ComboStore_Write(kPath, lib));
+    DeleteFileW(kPath);
+    lib.combos[3].name = L"Edited";
+    uint32_t rewrites = Stats().rewrites;
+    CHECK(ComboStore_Write(kPath, lib));
+    CHECK_EQ(Stats().rewrites, rewrites + 1);
+    CHECK(LoadMatches(kPath, lib));
+    CHECK(WriteText(kPath, "DCJ6"));
+    rewrites = Stats().rewrites;
+    CHECK(ComboStore_Write(kPath, lib));
+    CHECK_EQ(Stats().rewrites, rewrites + 1);
+    CHECK(LoadMatches(kPath, lib));
+
+    // A bad header is not a journal: read as text, which fails
+    std::vector<uint8_t> data;
+    CHECK(ReadBytes(kPath, &data));
+    data[0] = 'X';
+    CHECK(WriteBytes(kPath, data.data(), data.size()));
+    CHECK(!ComboStore_Load(kPath, &lib));
+    RemoveFiles(kPath);
+}
+
+TEST(ComboStore_CompactsWhenDeadRecordsOutweighLive)
+{
+    RemoveFiles(kPath);
+    ComboLibrary lib = MakeLibrary(5);
+    CHECK(ComboStore_Write(kPath, lib));
+    const uint32_t rewrites = Stats().rewrites;
+
+    // One combo with a long text, edited over and over: dead records pile up
+    bool compacted = false;
+    uint64_t largest = 0;
+    int edits = 0;
+    for (; edits < 1000 && !compacted; ++edits) {
+        lib.combos[2].actions[2].text = std::wstring(1000, L'a' + (wchar_t)(edits % 26));
+        CHECK(ComboStore_Write(kPath, lib));
+        largest = std::max<uint64_t>(largest, FileSize(kPath));
+        compacted = Stats().rewrites != rewrites;
+    }
+    CHECK(compacted);
+    CHECK(edits > 10);
+
+    // Back to a snapshot: live data only, the same library
+    const ComboStoreStats st = Stats();
+    CHECK_EQ(st.fileBytes, st.liveBytes);
+    CHECK_EQ(FileSize(kPath), st.fileBytes);
+    CHECK(largest > 2 * st.liveBytes);
+    CHECK(LoadMatches(kPath, lib));
+
+    // And appends go on from there
+    lib.combos[0].name = L"After compaction";
+    CHECK(ComboStore_Write(kPath, lib));
+    CHECK_EQ(Stats().lastAppended, 1u);
+    CHECK(LoadMatches(kPath, lib));
+    RemoveFiles(kPath);
+}
+
+BENCH(ComboStore_FullSave10k)
+{
+    const ComboLibrary lib = MakeLibrary(10000);
+    const wchar_t* paths[2] = { L"cs_bench_a.dat", L"cs_bench_b.dat" };
+    constexpr int kSaves = 10;
+    bool ok = true;
+    const double t0 = Test::NowSec();
+    for (int i = 0; i < kSaves; ++i) ok = ComboStore_Write(paths[i & 1], lib) && ok; // path change: full snapshot
+    const double ms = (Test::NowSec() - t0) * 1000.0 / kSaves;
+    CHECK(ok);
+    std::printf("  full save: %.2f ms (%llu KB)\n", ms, (unsigned long long)(FileSize(paths[0]) / 1024));
+    CHECK(ms < 2000.0);
+    RemoveFiles(paths[0]);
+    RemoveFiles(paths[1]);
+}
+
+BENCH(ComboStore_SingleEditAppend10k)
+{
+    ComboLibrary lib = MakeLibrary(10000);
+    const wchar_t* path = L"cs_bench_a.dat";
+    CHECK(ComboStore_Write(path, lib));
+    const uint64_t full = FileSize(path);
+
+    constexpr int kEdits = 200;
+    bool ok = true;
+    uint32_t appended = 0;
+    const double t0 = Test::NowSec();
+    for (int i = 0; i < kEdits; ++i) {
+        lib.combos[(size_t)(i * 37) % lib.combos.size()].repeatDelayMs += 1;
+        ok = ComboStore_Write(path, lib) && ok;
+        appended += Stats().lastAppended;
+    }
+    const double ms = (Test::NowSec() - t0) * 1000.0 / kEdits;
+    const uint64_t perEdit = (FileSize(path) - full) / kEdits;
+    CHECK(ok);
+    CHECK_EQ(appended, (uint32_t)kEdits);
+    std::printf("  single edit: %.2f ms, %llu bytes appended (full file %llu KB)\n",
+        ms, (unsigned long long)perEdit, (unsigned long long)(full / 1024));
+    CHECK(ms < 500.0);
+    RemoveFiles(path);
+}
+
+BENCH(ComboStore_Load10k)
+{
+    const ComboLibrary lib = MakeLibrary(10000);
+    const wchar_t* path = L"cs_bench_a.dat";
+    CHECK(ComboStore_Write(path, lib));
+
+    constexpr int kLoads = 10;
+    size_t combos = 0;
+    const double t0 = Test::NowSec();
+    for (int i = 0; i < kLoads; ++i) {
+        ComboLibrary loaded;
+        if (ComboStore_Load(path, &loaded)) combos += loaded.combos.size();
+    }
+    const double ms = (Test::NowSec() - t0) * 1000.0 / kLoads;
+    CHECK_EQ(combos, (size_t)kLoads * 10000);
+    std::printf("  load: %.2f ms\n", ms);
+    CHECK(ms < 2000.0);
+    CHECK(LoadMatches(path, lib));
+    RemoveFiles(path);
+}
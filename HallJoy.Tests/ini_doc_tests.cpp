@@ -0,0 +1,190 @@
+// ini_doc_tests.cpp
+// In-memory INI document: profile API lookup rules, round trip of comments
+// and order, encodings, compiled form. Benchmark: settings.ini with 256
+// overridden keys, single pass vs one parse per key, file round trip.
+#include "test.h"
+
+#include "../HallJoy/ini_doc.h"
+
+#include <cstdio>
+#include <string>
+
+namespace
+{
+    const wchar_t* kSample =
+        L"; HallJoy settings\r\n"
+        L"[Main]\r\n"
+        L"  PollingMs = 2 \r\n"
+        L"Name=\"quoted value\"\r\n"
+        L"# kept\r\n"
+        L"\r\n"
+        L"[main]\r\n"
+        L"PollingMs=9\r\n"
+        L"[Other]\r\n"
+        L"Hex=0x1F\r\n"
+        L"Neg=-42abc\r\n"
+        L"not a key\r\n";
+
+    // settings.ini-like text: 50 globals, 256 keys x 13 fields
+    std::wstring SettingsText()
+    {
+        std::wstring s = L"; generated\r\n[Main]\r\n";
+        for (int i = 0; i < 50; ++i) s += L"Global" + std::to_wstring(i) + L"=" + std::to_wstring(i * 7) + L"\r\n";
+        s += L"\r\n[KeyDeadzone]\r\n";
+        static const wchar_t* kFields[13] = { L"Use", L"Inv", L"Mode", L"L", L"H", L"ADZ", L"Cap", L"C1X", L"C1Y", L"C2X", L"C2Y", L"C1W", L"C2W" };
+        for (int hid = 0; hid < 256; ++hid)
+            for (int f = 0; f < 13; ++f)
+                s += std::to_wstring(hid) + L"_" + kFields[f] + L"=" + std::to_wstring(hid * 13 + f) + L"\r\n";
+        return s;
+    }
+}
+
+TEST(Ini_ProfileApiLookupRules)
+{
+    IniDoc doc;
+    doc.Parse(kSample);
+    CHECK_EQ(doc.GetInt(L"MAIN", L"pollingms", -1), 2);       // case, trim, first duplicate
+    CHECK(doc.GetString(L"Main", L"Name") == L"quoted value");
+    CHECK_EQ(doc.GetInt(L"Other", L"Hex", 0), 31);
+    CHECK_EQ(doc.GetInt(L"Other", L"Neg", 0), -42);
+    CHECK_EQ(doc.GetInt(L"Other", L"Missing", 5), 5);
+    CHECK(doc.GetString(L"Nope", L"x", L"def") == L"def");
+    CHECK(doc.HasSection(L"other"));
+    CHECK(!doc.Has(L"Other", L"not a key"));
+
+    std::vector<std::wstring_view> keys;
+    doc.Keys(L"Main", keys);
+    CHECK_EQ(keys.size(), 2u);
+    if (keys.size() == 2) CHECK(keys[0] == L"PollingMs" && keys[1] == L"Name");
+}
+
+TEST(Ini_RoundTripKeepsCommentsAndOrder)
+{
+    IniDoc doc;
+    doc.Parse(kSample);
+    // Key lines come back as key=value, everything else byte for byte
+    std::wstring expected = kSample;
+    expected.replace(expected.find(L"  PollingMs = 2 "), 16, L"PollingMs=2");
+    CHECK(doc.Serialize() == expected);
+
+    doc.SetInt(L"main", L"PollingMs", 4);    // in place, first occurrence
+    doc.Set(L"Main", L"Added", L"x");        // end of its section, before its blank lines
+    doc.SetUInt(L"New", L"U", 4000000000u);  // new section at the end
+    doc.Erase(L"Other", L"Neg");
+
+    IniDoc back;
+    back.Parse(doc.Serialize());
+    CHECK_EQ(back.GetInt(L"Main", L"PollingMs", 0), 4);
+    CHECK(back.GetString(L"New", L"U") == L"4000000000");
+    CHECK(!back.Has(L"Other", L"Neg"));
+    const std::wstring text = back.Serialize();
+    CHECK(text.find(L"; HallJoy settings") == 0);
+    CHECK(text.find(L"# kept") != std::wstring::npos);
+    CHECK(text.find(L"Added=x") > text.find(L"# kept"));
+    CHECK(text.find(L"Added=x") < text.find(L"[main]"));
+    CHECK(text.find(L"[New]") > text.find(L"[Other]"));
+
+    back.EraseSection(L"Other");
+    CHECK(!back.HasSection(L"Other"));
+    CHECK(back.Serialize().find(L"Hex") == std::wstring::npos);
+}
+
+TEST(Ini_Encodings)
+{
+    // UTF-8 (é), ANSI Latin-1 (é), UTF-16LE with BOM from SerializeBytes
+    const uint8_t utf8[] = { 0xEF, 0xBB, 0xBF, '[', 'a', ']', '\n', 'k', '=', 0xC3, 0xA9, '\n' };
+    const uint8_t ansi[] = { '[', 'a', ']', '\n', 'k', '=', 0xE9, '\n' };
+    IniDoc doc;
+    doc.ParseBytes(utf8, sizeof(utf8));
+    CHECK(doc.GetString(L"a", L"k") == L"é");
+    doc.ParseBytes(ansi, sizeof(ansi));
+    CHECK(doc.GetString(L"a", L"k") == L"é");
+
+    doc.Set(L"a", L"k", L"é€");
+    const std::vector<uint8_t> bytes = doc.SerializeBytes();
+    CHECK(bytes.size() >= 2 && bytes[0] == 0xFF && bytes[1] == 0xFE);
+    IniDoc back;
+    back.ParseBytes(bytes.data(), bytes.size());
+    CHECK(back.GetString(L"a", L"k") == L"é€");
+}
+
+TEST(Ini_CompiledFormRoundTrip)
+{
+    IniDoc doc;
+    doc.Parse(SettingsText());
+    std::vector<uint8_t> blob;
+    doc.SaveCompiled(blob);
+
+    IniDoc back;
+    CHECK(back.LoadCompiled(blob.data(), blob.size()));
+    CHECK_EQ(back.KeyCount(), doc.KeyCount());
+    CHECK_EQ(back.GetInt(L"KeyDeadzone", L"255_C2W", -1), 255 * 13 + 12);
+    CHECK(back.Serialize() == doc.Serialize());
+
+    blob[0] ^= 0xFF;
+    CHECK(!back.LoadCompiled(blob.data(), blob.size()));
+    CHECK(!back.LoadCompiled(blob.data(), 3));
+}
+
+BENCH(Ini_256OverriddenKeys)
+{
+    const std::wstring text = SettingsText();
+    IniDoc doc;
+    doc.Parse(text);
+    const std::vector<uint8_t> bytes = doc.SerializeBytes();
+    std::vector<std::wstring> names;
+    for (int hid = 0; hid < 256; ++hid) names.push_back(std::to_wstring(hid) + L"_C1X");
+
+    constexpr int kRounds = 20;
+    int64_t sum = 0;
+
+    // Single pass: decode + parse once, every key is a hash probe
+    double t0 = Test::NowSec();
+    for (int r = 0; r < kRounds; ++r) {
+        IniDoc d;
+        d.ParseBytes(bytes.data(), bytes.size());
+        for (const std::wstring& n : names) sum += d.GetInt(L"KeyDeadzone", n, 0);
+    }
+    const double loadMs = (Test::NowSec() - t0) * 1e3 / kRounds;
+
+    t0 = Test::NowSec();
+    for (int r = 0; r < kRounds; ++r) {
+        for (size_t i = 0; i < names.size(); ++i) doc.SetInt(L"KeyDeadzone", names[i], (int)(i + r));
+        sum += (int64_t)doc.SerializeBytes().size();
+    }
+    const double saveMs = (Test::NowSec() - t0) * 1e3 / kRounds;
+
+    // What the profile API does: one full decode + parse per key read
+    t0 = Test::NowSec();
+    constexpr int kPerCall = 64;
+    for (int i = 0; i < kPerCall; ++i) {
+        IniDoc d;
+        d.ParseBytes(bytes.data(), bytes.size());
+        sum += d.GetInt(L"KeyDeadzone", names[(size_t)i], 0);
+    }
+    const double perKeyMs = (Test::NowSec() - t0) * 1e3 / kPerCall;
+
+    // File round trip: serialize + one write, one read + parse
+    const char* path = "ini_doc_bench.ini";
+    t0 = Test::NowSec();
+    bool ok = true;
+    std::vector<uint8_t> file;
+    for (int r = 0; r < kRounds; ++r) {
+        const std::vector<uint8_t> out = doc.SerializeBytes();
+        ok &= Test::SaveFile(path, out.data(), out.size());
+        ok &= Test::LoadFile(path, file);
+        IniDoc d;
+        d.ParseBytes(file.data(), file.size());
+        sum += (int64_t)d.KeyCount();
+        ok &= d.KeyCount() == doc.KeyCount();
+    }
+    const double fileMs = (Test::NowSec() - t0) * 1e3 / kRounds;
+    std::remove(path);
+
+    std::printf("  %zu keys, %zu bytes (%lld)\n", doc.KeyCount(), bytes.size(), (long long)sum);
+    std::printf("  single pass: load %.2f ms, save %.2f ms, file save + load %.2f ms\n", loadMs, saveMs, fileMs);
+    std::printf("  parse per key: %.2f ms / key, %.0f ms for the %zu keys\n", perKeyMs, perKeyMs * (double)doc.KeyCount(), doc.KeyCount());
+    CHECK(ok);
+    CHECK_EQ(doc.KeyCount(), 50u + 256u * 13u);
+    CHECK(loadMs < 50.0);
+}
@@ -0,0 +1,172 @@
+// input_bus_tests.cpp
+// Input bus: sequences, canonical held state, auto-repeat flag, lapped
+// readers. Benchmark: one producer, 4 consumers on their own threads.
+#include "test.h"
+
+#include "../HallJoy/input_bus.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace
+{
+    InputEvent Key(InputEventType type, uint16_t vk)
+    {
+        InputEvent ev;
+        ev.type = type;
+        ev.code = vk;
+        return ev;
+    }
+
+    InputEvent Mouse(InputEventType type, InputMouseButton b)
+    {
+        InputEvent ev;
+        ev.type = type;
+        ev.code = (uint16_t)b;
+        return ev;
+    }
+}
+
+TEST(Bus_SequencesAndSubscribeSkipsHistory)
+{
+    InputBus_Publish(Key(InputEventType::KeyDown, 'A'));
+    InputBusReader r;
+    InputBus_Subscribe(&r);
+    InputEvent ev;
+    CHECK(!InputBus_Poll(&r, &ev));   // what came before is not replayed
+
+    const uint64_t s1 = InputBus_Publish(Key(InputEventType::KeyUp, 'A'));
+    const uint64_t s2 = InputBus_Publish(Key(InputEventType::KeyDown, 'B'));
+    CHECK_EQ(s2, s1 + 1);
+    CHECK_EQ(InputBus_GetHeadSeq(), s2);
+    CHECK(InputBus_Poll(&r, &ev) && ev.seq == s1 && ev.code == 'A' && ev.type == InputEventType::KeyUp);
+    CHECK(InputBus_Poll(&r, &ev) && ev.seq == s2 && ev.code == 'B');
+    CHECK(!InputBus_Poll(&r, &ev));
+    InputBus_ResetHeld();
+}
+
+TEST(Bus_HeldStateAndRepeatFlag)
+{
+    InputBus_ResetHeld();
+    InputBusReader r;
+    InputBus_Subscribe(&r);
+
+    InputBus_Publish(Key(InputEventType::KeyDown, 0xA2));
+    InputBus_Publish(Key(InputEventType::KeyDown, 0xA2));   // OS auto-repeat
+    InputBus_Publish(Mouse(InputEventType::MouseDown, InputMouseButton::Right));
+    CHECK(InputBus_IsKeyHeld(0xA2));
+    CHECK(!InputBus_IsKeyHeld(0xA3));
+    CHECK(InputBus_IsMouseHeld(InputMouseButton::Right));
+    CHECK_EQ(InputBus_GetMouseHeldMask(), 1u << (int)InputMouseButton::Right);
+    uint64_t bits[4];
+    InputBus_GetKeyHeldBits(bits);
+    CHECK_EQ(bits[0xA2 / 64], 1ull << (0xA2 % 64));
+
+    InputEvent ev;
+    CHECK(InputBus_Poll(&r, &ev) && !(ev.flags & InputEventFlag_Repeat));
+    CHECK(InputBus_Poll(&r, &ev) && (ev.flags & InputEventFlag_Repeat));
+
+    InputBus_Publish(Key(InputEventType::KeyUp, 0xA2));
+    CHECK(!InputBus_IsKeyHeld(0xA2));
+    InputBus_ResetHeld();
+    CHECK(!InputBus_IsMouseHeld(InputMouseButton::Right));
+}
+
+TEST(Bus_LappedReaderCountsOverruns)
+{
+    InputBusReader r;
+    InputBus_Subscribe(&r);
+    const uint32_t total = INPUT_BUS_CAPACITY * 3 + 17;
+    for (uint32_t i = 0; i < total; ++i) {
+        InputEvent ev = Key(InputEventType::KeyUp, (uint16_t)(i & 0xFF));
+        ev.timeUs = i;
+        InputBus_Publish(ev);
+    }
+    uint64_t got = 0, last = 0;
+    bool ordered = true;
+    InputEvent ev;
+    while (InputBus_Poll(&r, &ev)) {
+        ordered = ordered && ev.seq > last && ev.code == (uint16_t)(ev.timeUs & 0xFF);
+        last = ev.seq;
+        ++got;
+    }
+    CHECK(ordered);
+    CHECK_EQ(got + r.overruns, (uint64_t)total);   // nothing silently lost
+    CHECK(got <= INPUT_BUS_CAPACITY);
+    CHECK_EQ(last, InputBus_GetHeadSeq());         // caught up with the newest
+    InputBus_ResetHeld();
+}
+
+BENCH(Bus_FourConsumers)
+{
+    // Delivered throughput: the producer never gets more than half the ring
+    // ahead of the slowest consumer (flow control of the bench only, the
+    // input thread never waits), so every consumer must see every event.
+    constexpr int kConsumers = 4;
+    constexpr uint64_t kEvents = 2000000;
+    constexpr uint64_t kWindow = INPUT_BUS_CAPACITY / 2;
+    std::atomic<bool> go{ false };
+    std::atomic<int> ready{ 0 };
+    std::atomic<uint64_t> progress[kConsumers]{};
+    uint64_t got[kConsumers]{}, lost[kConsumers]{}, bad[kConsumers]{};
+
+    const uint64_t base = InputBus_GetHeadSeq();
+    std::thread consumers[kConsumers];
+    for (int c = 0; c < kConsumers; ++c) {
+        consumers[c] = std::thread([&, c] {
+            InputBusReader r;
+            InputBus_Subscribe(&r);
+            ready.fetch_add(1);
+            while (!go.load()) std::this_thread::yield();
+            InputEvent ev;
+            uint64_t last = 0;
+            while (last < base + kEvents) {
+                if (!InputBus_Poll(&r, &ev)) {
+                    progress[c].store(last - base, std::memory_order_release);
+                    std::this_thread::yield();
+                    continue;
+                }
+                // Payload derived from the sequence: a torn read shows up here
+                const uint64_t n = ev.seq - base;
+                if (ev.seq <= last || ev.timeUs != n * 3 || ev.code != (uint16_t)(n & 0xFF)) ++bad[c];
+                last = ev.seq;
+                ++got[c];
+            }
+            progress[c].store(kEvents, std::memory_order_release);
+            lost[c] = r.overruns;
+        });
+    }
+    while (ready.load() < kConsumers) std::this_thread::yield();
+
+    const double t0 = Test::NowSec();
+    go.store(true);
+    for (uint64_t i = 1; i <= kEvents; ++i) {
+        for (;;) {
+            uint64_t slowest = kEvents;
+            for (const auto& p : progress) slowest = std::min(slowest, p.load(std::memory_order_acquire));
+            if (i <= slowest + kWindow) break;
+            std::this_thread::yield();
+        }
+        InputEvent ev = Key((i & 1) ? InputEventType::KeyDown : InputEventType::KeyUp, (uint16_t)(i & 0xFF));
+        ev.timeUs = i * 3;
+        InputBus_Publish(ev);
+    }
+    for (std::thread& t : consumers) t.join();
+    const double sec = Test::NowSec() - t0;
+
+    // Publish alone (no reader keeps up: the ring just wraps)
+    const double t1 = Test::NowSec();
+    for (uint64_t i = 0; i < kEvents; ++i) InputBus_Publish(Key(InputEventType::KeyUp, (uint16_t)(i & 0xFF)));
+    const double publishSec = Test::NowSec() - t1;
+
+    std::printf("  %u hardware threads\n", std::thread::hardware_concurrency());
+    std::printf("  publish alone: %.1f M events / s\n", kEvents / publishSec / 1e6);
+    std::printf("  delivered to %d consumers, none lost: %.2f M events / s\n", kConsumers, kEvents / sec / 1e6);
+    for (int c = 0; c < kConsumers; ++c) {
+        CHECK_EQ(bad[c], 0u);
+        CHECK_EQ(lost[c], 0u);
+        CHECK_EQ(got[c], kEvents);
+    }
+    InputBus_ResetHeld();
+}
@@ -0,0 +1,187 @@
+// macro_recorder_tests.cpp
+// Post-processing of recordings (MacroRecorder_Compile): taps, delay grid,
+// stray releases, the Stop click, analog curves.
+#include "test.h"
+
+#include "../HallJoy/macro_compiler.h"
+#include "../HallJoy/macro_recorder.h"
+
+#include <algorithm>
+
+namespace
+{
+    using T = ComboActionType;
+
+    MacroRecEvent Ev(uint64_t ms, MacroRecKind kind, uint16_t code, uint16_t value = 0)
+    {
+        MacroRecEvent e;
+        e.timeUs = ms * 1000ull;
+        e.kind = kind;
+        e.code = code;
+        e.value = value;
+        return e;
+    }
+
+    std::vector<ComboAction> Compile(const std::vector<MacroRecEvent>& ev, const MacroRecOptions& opt = {})
+    {
+        std::vector<ComboAction> out;
+        MacroRecorder_Compile(ev, opt, &out);
+        return out;
+    }
+
+    uint64_t TotalDelayMs(const std::vector<ComboAction>& actions)
+    {
+        uint64_t ms = 0;
+        for (const ComboAction& a : actions)
+            if (a.type == T::Delay || a.type == T::AnalogRamp) ms += a.delayMs;
+        return ms;
+    }
+
+    int Count(const std::vector<ComboAction>& actions, ComboActionType type)
+    {
+        int n = 0;
+        for (const ComboAction& a : actions) n += (a.type == type);
+        return n;
+    }
+}
+
+TEST(Recorder_ShortPressBecomesTap)
+{
+    const auto out = Compile({ Ev(0, MacroRecKind::KeyDown, 4), Ev(60, MacroRecKind::KeyUp, 4) });
+    CHECK_EQ(out.size(), 1u);
+    CHECK(out[0].type == T::TapKey && out[0].keyHid == 4);
+}
+
+TEST(Recorder_LongOrOverlappedPressStaysPressRelease)
+{
+    // Held longer than tapMaxMs
+    auto out = Compile({ Ev(0, MacroRecKind::KeyDown, 4), Ev(400, MacroRecKind::KeyUp, 4) });
+    CHECK_EQ(out.size(), 3u);
+    CHECK(out[0].type == T::PressKey);
+    CHECK(out[1].type == T::Delay && out[1].delayMs == 400);
+    CHECK(out[2].type == T::ReleaseKey);
+
+    // Short, but another key went down in between: the order must be kept
+    out = Compile({ Ev(0, MacroRecKind::KeyDown, 225), Ev(20, MacroRecKind::KeyDown, 4),
+                    Ev(40, MacroRecKind::KeyUp, 4), Ev(60, MacroRecKind::KeyUp, 225) });
+    CHECK_EQ(Count(out, T::PressKey), 1);
+    CHECK_EQ(Count(out, T::TapKey), 1);
+    CHECK_EQ(Count(out, T::ReleaseKey), 1);
+    CHECK(out.front().type == T::PressKey && out.back().type == T::ReleaseKey);
+}
+
+TEST(Recorder_DelayGridDoesNotDrift)
+{
+    // 200 taps every 33.3 ms: each gap alone rounds to 30, the grid keeps the total
+    std::vector<MacroRecEvent> ev;
+    for (uint64_t i = 0; i < 200; ++i) {
+        const uint64_t t = i * 33333;
+        ev.push_back({ t, MacroRecKind::KeyDown, 4, 0 });
+        ev.push_back({ t + 5000, MacroRecKind::KeyUp, 4, 0 });
+    }
+    MacroRecOptions opt;
+    opt.quantumMs = 10;
+    const auto out = Compile(ev, opt);
+    CHECK_EQ(Count(out, T::TapKey), 200);
+    const uint64_t recordedMs = (199 * 33333 + 500) / 1000;
+    const uint64_t total = TotalDelayMs(out);
+    CHECK(total + 5 >= recordedMs && total <= recordedMs + 5);
+    for (const ComboAction& a : out)
+        if (a.type == T::Delay) CHECK_EQ(a.delayMs % 10, 0u);
+}
+
+TEST(Recorder_MaxDelayShortensPauses)
+{
+    MacroRecOptions opt;
+    opt.maxDelayMs = 500;
+    const auto out = Compile({ Ev(0, MacroRecKind::KeyDown, 4), Ev(50, MacroRecKind::KeyUp, 4),
+                               Ev(5000, MacroRecKind::KeyDown, 5), Ev(5050, MacroRecKind::KeyUp, 5) }, opt);
+    CHECK_EQ(out.size(), 3u);
+    CHECK(out[1].type == T::Delay && out[1].delayMs == 500);
+}
+
+TEST(Recorder_StrayReleaseIgnoredHeldKeyReleased)
+{
+    // 7 was held when the recording started, 8 is still held when it stops
+    const auto out = Compile({ Ev(0, MacroRecKind::KeyUp, 7), Ev(10, MacroRecKind::KeyDown, 8),
+                               Ev(300, MacroRecKind::KeyDown, 4), Ev(350, MacroRecKind::KeyUp, 4) });
+    for (const ComboAction& a : out) CHECK(a.keyHid != 7);
+    CHECK_EQ(Count(out, T::PressKey), 1);
+    CHECK_EQ(Count(out, T::ReleaseKey), 1);
+    CHECK(out.back().type == T::ReleaseKey && out.back().keyHid == 8);
+}
+
+TEST(Recorder_TrailingStopClickDropped)
+{
+    const std::vector<MacroRecEvent> ev = {
+        Ev(0, MacroRecKind::MouseDown, 1), Ev(30, MacroRecKind::MouseUp, 1),
+        Ev(100, MacroRecKind::KeyDown, 4), Ev(150, MacroRecKind::KeyUp, 4),
+        Ev(900, MacroRecKind::MouseDown, 0), Ev(950, MacroRecKind::MouseUp, 0),
+    };
+    auto out = Compile(ev);
+    CHECK_EQ(Count(out, T::MouseClick), 1);
+    CHECK(out.front().type == T::MouseClick && out.front().mouseButton == 1);
+    CHECK(out.back().type == T::TapKey);
+
+    MacroRecOptions keep;
+    keep.dropTrailingClick = false;
+    out = Compile(ev, keep);
+    CHECK_EQ(Count(out, T::MouseClick), 2);
+}
+
+TEST(Recorder_AnalogCurveSimplifiedToRamps)
+{
+    // Linear press to full depth in 100 ms, hold, linear release in 100 ms;
+    // the digital press of the same key is the same input and is not kept
+    std::vector<MacroRecEvent> ev;
+    ev.push_back(Ev(0, MacroRecKind::KeyDown, 4));
+    for (uint16_t i = 1; i <= 100; ++i) ev.push_back(Ev(i, MacroRecKind::Analog, 4, (uint16_t)(i * 10)));
+    for (uint16_t i = 1; i <= 100; ++i) ev.push_back(Ev(300 + i, MacroRecKind::Analog, 4, (uint16_t)(1000 - i * 10)));
+    ev.push_back(Ev(400, MacroRecKind::KeyUp, 4));
+
+    MacroRecOptions opt;
+    opt.quantumMs = 1;
+    const auto out = Compile(ev, opt);
+    CHECK_EQ(Count(out, T::PressKey) + Count(out, T::TapKey) + Count(out, T::ReleaseKey), 0);
+    CHECK(out.size() <= 6u);
+    CHECK(out.front().type == T::AnalogSet);
+    CHECK(out.back().type == T::AnalogRelease && out.back().keyHid == 4);
+    CHECK(Count(out, T::AnalogRamp) >= 2);
+
+    uint16_t peak = 0;
+    for (const ComboAction& a : out)
+        if (a.type == T::AnalogSet || a.type == T::AnalogRamp) peak = std::max<uint16_t>(peak, (uint16_t)a.mouseButton);
+    CHECK_EQ(peak, 1000);
+    const uint64_t total = TotalDelayMs(out);
+    CHECK(total >= 395 && total <= 405);
+}
+
+TEST(Recorder_AnalogOffKeepsDigitalPress)
+{
+    std::vector<MacroRecEvent> ev = { Ev(0, MacroRecKind::KeyDown, 4) };
+    for (uint16_t i = 1; i <= 10; ++i) ev.push_back(Ev(i, MacroRecKind::Analog, 4, (uint16_t)(i * 100)));
+    ev.push_back(Ev(50, MacroRecKind::KeyUp, 4));
+    MacroRecOptions opt;
+    opt.keepAnalog = false;
+    const auto out = Compile(ev, opt);
+    CHECK_EQ(out.size(), 1u);
+    CHECK(out[0].type == T::TapKey);
+}
+
+TEST(Recorder_OutputCompilesForTheVm)
+{
+    std::vector<MacroRecEvent> ev;
+    for (uint64_t i = 0; i < 50; ++i) {
+        ev.push_back(Ev(i * 40, MacroRecKind::KeyDown, (uint16_t)(4 + i % 20)));
+        ev.push_back(Ev(i * 40 + (i % 3 ? 20 : 300), MacroRecKind::KeyUp, (uint16_t)(4 + i % 20)));
+        if (i % 7 == 0) ev.push_back(Ev(i * 40 + 10, MacroRecKind::MouseDown, 0));
+    }
+    for (uint16_t i = 0; i <= 40; ++i) ev.push_back(Ev(100 + i * 5, MacroRecKind::Analog, 26, (uint16_t)(i * 25)));
+    std::sort(ev.begin(), ev.end(), [](const MacroRecEvent& a, const MacroRecEvent& b) { return a.timeUs < b.timeUs; });
+
+    const auto out = Compile(ev);
+    MacroProgram prog;
+    std::wstring err;
+    CHECK(MacroCompile(out, &prog, &err));
+    CHECK(!prog.code.empty());
+}
@@ -0,0 +1,405 @@
+// macro_vm_tests.cpp
+// Macro VM through a recording IMacroHost: loops, If/Else on live input,
+// variables, random delays, analog ramps, StepLimit / BadProgram and the
+// compiler's block errors. Benchmark: instructions per second.
+#include "test.h"
+
+#include "../HallJoy/macro_compiler.h"
+#include "../HallJoy/macro_vm.h"
+
+#include <algorithm>
+#include <climits>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using T = ComboActionType;
+
+    struct HostEvent
+    {
+        char kind;          // 'D' down, 'U' up, 'T' tap, 'X' text, 'M' click, 'S' set analog, 'R' release analog
+        uint16_t code;
+        uint16_t value;
+    };
+
+    // Records every effect on a virtual clock; live input comes from held / analog.
+    class RecordingHost : public IMacroHost
+    {
+    public:
+        std::vector<HostEvent> events;
+        std::wstring typed;
+        uint64_t nowMs = 0;
+        uint64_t steps = 0;
+        uint64_t stopAtStep = ~0ull;   // BeginStep returns false from this step on
+        uint64_t stopAtMs = ~0ull;     // Wait returns false once the clock reaches it
+        bool held[256]{};
+        uint16_t analog[256]{};
+
+        bool BeginStep() override { return ++steps < stopAtStep; }
+        void KeyDown(uint16_t hid) override { events.push_back({ 'D', hid, 0 }); }
+        void KeyUp(uint16_t hid) override { events.push_back({ 'U', hid, 0 }); }
+        void KeyTap(uint16_t hid) override { events.push_back({ 'T', hid, 0 }); }
+        void TypeText(const wchar_t* text, uint32_t len) override
+        {
+            events.push_back({ 'X', 0, (uint16_t)len });
+            typed.append(text, len);
+        }
+        void MouseClick(uint8_t button) override { events.push_back({ 'M', button, 0 }); }
+        bool Wait(uint32_t ms) override
+        {
+            nowMs += ms;
+            return nowMs < stopAtMs;
+        }
+        void SetAnalog(uint16_t hid, uint16_t milli) override { events.push_back({ 'S', hid, milli }); }
+        void ReleaseAnalog(uint16_t hid) override { events.push_back({ 'R', hid, 0 }); }
+        bool IsKeyHeld(uint16_t hid) override { return held[hid & 0xFF]; }
+        uint16_t GetAnalogMilli(uint16_t hid) override { return analog[hid & 0xFF]; }
+
+        int Count(char kind, uint16_t code) const
+        {
+            int n = 0;
+            for (const HostEvent& e : events) n += (e.kind == kind && e.code == code);
+            return n;
+        }
+    };
+
+    ComboAction Act(ComboActionType type, uint16_t hid = 0, int value = 0, uint32_t ms = 0)
+    {
+        ComboAction a;
+        a.type = type;
+        a.keyHid = hid;
+        a.mouseButton = value;
+        a.delayMs = ms;
+        return a;
+    }
+
+    MacroProgram Compile(const std::vector<ComboAction>& actions)
+    {
+        MacroProgram prog;
+        std::wstring err;
+        const bool ok = MacroCompile(actions, &prog, &err);
+        CHECK(ok);
+        return prog;
+    }
+
+    MacroRunResult Run(const MacroProgram& prog, RecordingHost& host, uint32_t seed = 1, uint64_t maxSteps = 1000000)
+    {
+        MacroVm vm;
+        vm.Reset(seed);
+        return vm.Run(prog, host, maxSteps);
+    }
+
+    MacroInstr In(MacroOp op, uint16_t hid = 0, int32_t a = 0, int32_t b = 0, uint8_t reg = 0)
+    {
+        MacroInstr in;
+        in.op = op; in.reg = reg; in.hid = hid; in.a = a; in.b = b;
+        return in;
+    }
+}
+
+TEST(MacroVm_LoopsRunTheirCount)
+{
+    // 3 x (2 x tap 4, tap 5), then a text
+    ComboAction text = Act(T::TypeText);
+    text.text = L"gg";
+    const MacroProgram prog = Compile({
+        Act(T::Loop, 0, 3),
+            Act(T::Loop, 0, 2), Act(T::TapKey, 4), Act(T::EndLoop),
+            Act(T::TapKey, 5),
+        Act(T::EndLoop),
+        text });
+    CHECK_EQ(prog.maxEffects, 10u);
+
+    RecordingHost host;
+    CHECK(Run(prog, host) == MacroRunResult::Finished);
+    CHECK_EQ(host.Count('T', 4), 6);
+    CHECK_EQ(host.Count('T', 5), 3);
+    CHECK_EQ(host.events.size(), 10u);
+    CHECK(host.typed == L"gg");
+    CHECK_EQ(host.steps, prog.maxEffects);
+
+    // "Until stopped": runs until the host says stop
+    const MacroProgram endless = Compile({ Act(T::Loop, 0, 0), Act(T::TapKey, 4), Act(T::Delay, 0, 0, 10) });
+    CHECK_EQ(endless.maxEffects, MACRO_EFFECTS_UNBOUNDED);
+    host = RecordingHost{};
+    host.stopAtMs = 1000;
+    CHECK(Run(endless, host) == MacroRunResult::Stopped);
+    CHECK_EQ(host.Count('T', 4), 100);
+}
+
+TEST(MacroVm_IfElseFollowsLiveInput)
+{
+    const MacroProgram prog = Compile({
+        Act(T::IfKeyHeld, 10), Act(T::TapKey, 4), Act(T::Else), Act(T::TapKey, 5), Act(T::EndIf),
+        Act(T::IfAnalogAbove, 20, 500), Act(T::TapKey, 6), Act(T::EndIf),
+        Act(T::TapKey, 7) });
+
+    RecordingHost host;
+    host.analog[20] = 500;                  // "above" is strict
+    CHECK(Run(prog, host) == MacroRunResult::Finished);
+    CHECK_EQ(host.Count('T', 4), 0);
+    CHECK_EQ(host.Count('T', 5), 1);
+    CHECK_EQ(host.Count('T', 6), 0);
+    CHECK_EQ(host.Count('T', 7), 1);
+
+    host = RecordingHost{};
+    host.held[10] = true;
+    host.analog[20] = 501;
+    CHECK(Run(prog, host) == MacroRunResult::Finished);
+    CHECK_EQ(host.Count('T', 4), 1);
+    CHECK_EQ(host.Count('T', 5), 0);
+    CHECK_EQ(host.Count('T', 6), 1);
+    CHECK_EQ(host.Count('T', 7), 1);
+
+    // An If left open is closed at the end
+    const MacroProgram open = Compile({ Act(T::IfKeyHeld, 10), Act(T::TapKey, 4) });
+    host = RecordingHost{};
+    CHECK(Run(open, host) == MacroRunResult::Finished);
+    CHECK(host.events.empty());
+}
+
+TEST(MacroVm_VariablesCountAndSaturate)
+{
+    // while (v0 < 10) { v0 += 3; tap } as a bounded loop with an If
+    const MacroProgram prog = Compile({
+        Act(T::SetVar, 0, 0),
+        Act(T::Loop, 0, 20),
+            Act(T::IfVarBelow, 0, 10), Act(T::AddVar, 0, 3), Act(T::TapKey, 4), Act(T::EndIf),
+        Act(T::EndLoop) });
+    RecordingHost host;
+    MacroVm vm;
+    vm.Reset(1);
+    CHECK(vm.Run(prog, host) == MacroRunResult::Finished);
+    CHECK_EQ(vm.Var(0), 12);
+    CHECK_EQ(host.Count('T', 4), 4);
+    CHECK_EQ(vm.Var(MACRO_VM_VARS), 0);
+
+    // Variables survive between runs until Reset
+    const MacroProgram bump = Compile({ Act(T::AddVar, 1, -5) });
+    vm.Run(bump, host);
+    vm.Run(bump, host);
+    CHECK_EQ(vm.Var(1), -10);
+    vm.Reset(1);
+    CHECK_EQ(vm.Var(1), 0);
+
+    // No wrap at the int32 limits
+    const MacroProgram up = Compile({ Act(T::SetVar, 2, INT_MAX - 1), Act(T::AddVar, 2, 5), Act(T::AddVar, 2, INT_MAX) });
+    vm.Run(up, host);
+    CHECK_EQ(vm.Var(2), INT_MAX);
+    const MacroProgram down = Compile({ Act(T::SetVar, 3, INT_MIN + 2), Act(T::AddVar, 3, -7), Act(T::AddVar, 3, INT_MIN) });
+    vm.Run(down, host);
+    CHECK_EQ(vm.Var(3), INT_MIN);
+    const MacroProgram back = Compile({ Act(T::AddVar, 2, -1) });
+    vm.Run(back, host);
+    CHECK_EQ(vm.Var(2), INT_MAX - 1);
+}
+
+TEST(MacroVm_RandomDelayStaysInRange)
+{
+    const MacroProgram prog = Compile({ Act(T::RandomDelay, 0, 40, 20) });
+    uint32_t lo = ~0u, hi = 0;
+    uint64_t total = 0;
+    constexpr int kRuns = 2000;
+    MacroVm vm;
+    vm.Reset(42);
+    RecordingHost host;
+    for (int i = 0; i < kRuns; ++i) {
+        const uint64_t before = host.nowMs;
+        vm.Run(prog, host);
+        const uint32_t ms = (uint32_t)(host.nowMs - before);
+        lo = std::min(lo, ms);
+        hi = std::max(hi, ms);
+        total += ms;
+    }
+    CHECK_EQ(lo, 20u);
+    CHECK_EQ(hi, 40u);
+    const double mean = (double)total / kRuns;
+    CHECK(mean > 28.0 && mean < 32.0);
+
+    // Swapped bounds read as min / max; the same seed replays the same delays
+    const MacroProgram swapped = Compile({ Act(T::RandomDelay, 0, 20, 40) });
+    RecordingHost a, b;
+    MacroVm va, vb;
+    va.Reset(7);
+    vb.Reset(7);
+    for (int i = 0; i < 100; ++i) {
+        va.Run(prog, a);
+        vb.Run(swapped, b);
+    }
+    CHECK_EQ(a.nowMs, b.nowMs);
+    CHECK(a.nowMs >= 2000 && a.nowMs <= 4000);
+
+    // Equal bounds: a fixed delay
+    const MacroProgram fixed = Compile({ Act(T::RandomDelay, 0, 15, 15) });
+    RecordingHost c;
+    Run(fixed, c);
+    CHECK_EQ(c.nowMs, 15u);
+}
+
+TEST(MacroVm_AnalogRampsAndRelease)
+{
+    // Set 200, ramp to 1000 in 100 ms: 10 steps of 80, 100 ms waited, released at the end
+    const MacroProgram prog = Compile({ Act(T::AnalogSet, 30, 200), Act(T::AnalogRamp, 30, 1000, 100) });
+    RecordingHost host;
+    CHECK(Run(prog, host) == MacroRunResult::Finished);
+    CHECK_EQ(host.nowMs, 100u);
+    CHECK_EQ(host.events.size(), 12u);
+    CHECK_EQ(host.events[0].value, 200);
+    for (int i = 1; i <= 10; ++i) {
+        CHECK(host.events[(size_t)i].kind == 'S');
+        CHECK_EQ(host.events[(size_t)i].value, 200 + 80 * i);
+    }
+    CHECK(host.events.back().kind == 'R' && host.events.back().code == 30);
+
+    // Duration not a multiple of the step: spread exactly; ramp down from the last value
+    const MacroProgram odd = Compile({ Act(T::AnalogSet, 31, 900), Act(T::AnalogRamp, 31, 0, 35),
+                                       Act(T::AnalogRelease, 31) });
+    host = RecordingHost{};
+    CHECK(Run(odd, host) == MacroRunResult::Finished);
+    CHECK_EQ(host.nowMs, 35u);
+    CHECK_EQ(host.Count('S', 31), 4);                      // 900, 600, 300, 0
+    CHECK_EQ(host.events[3].value, 0);
+    CHECK_EQ(host.Count('R', 31), 1);                      // released once, not again at the end
+
+    // Out of range targets are clamped; a zero duration ramp is a set
+    const MacroProgram clamp = Compile({ Act(T::AnalogRamp, 32, 5000, 0), Act(T::AnalogSet, 33, -40) });
+    host = RecordingHost{};
+    Run(clamp, host);
+    CHECK_EQ(host.events[0].value, 1000);
+    CHECK_EQ(host.events[1].value, 0);
+    CHECK_EQ(host.nowMs, 0u);
+
+    // Stopped mid-ramp: the axis is still released
+    host = RecordingHost{};
+    host.stopAtMs = 50;
+    CHECK(Run(prog, host) == MacroRunResult::Stopped);
+    CHECK_EQ(host.Count('S', 30), 6);
+    CHECK(host.events.back().kind == 'R' && host.events.back().code == 30);
+}
+
+TEST(MacroVm_StepLimitAndBadProgram)
+{
+    // Endless loop with no effect: only the step limit ends it
+    const MacroProgram spin = Compile({ Act(T::Loop, 0, 0), Act(T::AddVar, 0, 1) });
+    RecordingHost host;
+    MacroVm vm;
+    vm.Reset(1);
+    CHECK(vm.Run(spin, host, 5000) == MacroRunResult::StepLimit);
+    CHECK_EQ(vm.Steps(), 5001u);
+    CHECK(host.events.empty());
+
+    // The host stopping at BeginStep
+    const MacroProgram taps = Compile({ Act(T::Loop, 0, 0), Act(T::TapKey, 4) });
+    host.stopAtStep = 6;
+    CHECK(vm.Run(taps, host) == MacroRunResult::Stopped);
+    CHECK_EQ(host.Count('T', 4), 5);
+
+    // Hand-built programs the compiler never emits
+    const std::vector<std::vector<MacroInstr>> bad = {
+        { In(MacroOp::Jump, 0, 5) },                                   // past the end
+        { In(MacroOp::Jump, 0, -1) },
+        { In(MacroOp::JumpIfNotHeld, 4, 9) },
+        { In(MacroOp::JumpIfVarNotBelow, 0, 1, 0, MACRO_VM_VARS) },    // variable out of range
+        { In(MacroOp::SetVar, 0, 1, 0, MACRO_VM_VARS) },
+        { In(MacroOp::AddVar, 0, 1, 0, 200) },
+        { In(MacroOp::LoopInit, 0, 3, 0, MACRO_VM_LOOP_DEPTH) },        // loop slot out of range
+        { In(MacroOp::LoopNext, 0, 7, 0, 0) },
+        { In(MacroOp::Text, 0, 0, 3) },                                 // past the text pool
+        { In((MacroOp)200) },
+    };
+    for (const auto& code : bad) {
+        MacroProgram prog;
+        prog.code = code;
+        RecordingHost h;
+        CHECK(Run(prog, h) == MacroRunResult::BadProgram);
+        CHECK(h.events.empty());
+    }
+
+    // An analog set before the bad instruction is still released
+    MacroProgram prog;
+    prog.code = { In(MacroOp::AnalogSet, 40, 700), In(MacroOp::Jump, 0, 99) };
+    RecordingHost h;
+    CHECK(Run(prog, h) == MacroRunResult::BadProgram);
+    CHECK_EQ(h.Count('R', 40), 1);
+
+    // Jumping to the end is a normal finish
+    prog.code = { In(MacroOp::Jump, 0, 2), In(MacroOp::KeyTap, 4) };
+    h = RecordingHost{};
+    CHECK(Run(prog, h) == MacroRunResult::Finished);
+    CHECK(h.events.empty());
+}
+
+TEST(MacroCompile_MismatchedBlocksFail)
+{
+    struct Case { std::vector<ComboAction> actions; const wchar_t* error; };
+    const Case cases[] = {
+        { { Act(T::TapKey, 4), Act(T::EndLoop) },                                  L"action 2: End loop without Loop" },
+        { { Act(T::Else) },                                                        L"action 1: Else without If" },
+        { { Act(T::EndIf) },                                                       L"action 1: End if without If" },
+        { { Act(T::Loop, 0, 2), Act(T::EndIf) },                                   L"action 2: End if without If" },
+        { { Act(T::IfKeyHeld, 4), Act(T::EndLoop) },                               L"action 2: End loop without Loop" },
+        { { Act(T::IfKeyHeld, 4), Act(T::Else), Act(T::Else) },                    L"action 3: Else without If" },
+        { { Act(T::IfKeyHeld, 4), Act(T::Loop, 0, 2), Act(T::Else) },              L"action 3: Else without If" },
+        { { Act(T::SetVar, MACRO_VM_VARS, 1) },                                    L"action 1: variable index out of range" },
+        { { Act(T::IfVarBelow, 100, 1) },                                          L"action 1: variable index out of range" },
+    };
+    for (const Case& c : cases) {
+        MacroProgram prog;
+        prog.code.push_back(In(MacroOp::KeyTap, 4));
+        std::wstring err;
+        CHECK(!MacroCompile(c.actions, &prog, &err));
+        CHECK(err == c.error);
+        CHECK(prog.code.empty());
+    }
+
+    // Too many nested loops
+    std::vector<ComboAction> deep;
+    for (int i = 0; i <= MACRO_VM_LOOP_DEPTH; ++i) deep.push_back(Act(T::Loop, 0, 2));
+    MacroProgram prog;
+    std::wstring err;
+    CHECK(!MacroCompile(deep, &prog, &err));
+    CHECK(err == L"action " + std::to_wstring(MACRO_VM_LOOP_DEPTH + 1) + L": too many nested loops");
+
+    // One less is fine, closed implicitly: 2^8 taps
+    deep.pop_back();
+    deep.push_back(Act(T::TapKey, 4));
+    CHECK(MacroCompile(deep, &prog, &err));
+    CHECK_EQ(prog.maxEffects, 1u << MACRO_VM_LOOP_DEPTH);
+    RecordingHost host;
+    CHECK(Run(prog, host) == MacroRunResult::Finished);
+    CHECK_EQ(host.Count('T', 4), 1 << MACRO_VM_LOOP_DEPTH);
+}
+
+BENCH(MacroVm_InstructionsPerSecond)
+{
+    // Control flow only (the VM's own cost) and a mix with effects on a no-op host
+    const MacroProgram flow = Compile({
+        Act(T::Loop, 0, 0),
+            Act(T::AddVar, 0, 1),
+            Act(T::IfVarBelow, 0, 1000), Act(T::AddVar, 1, 1), Act(T::Else), Act(T::SetVar, 0, 0), Act(T::EndIf),
+        Act(T::EndLoop) });
+    const MacroProgram mixed = Compile({
+        Act(T::Loop, 0, 0),
+            Act(T::IfKeyHeld, 10), Act(T::TapKey, 4), Act(T::Else), Act(T::PressKey, 5), Act(T::ReleaseKey, 5), Act(T::EndIf),
+            Act(T::AnalogSet, 30, 500), Act(T::Delay, 0, 0, 1),
+        Act(T::EndLoop) });
+
+    struct Bench { const char* name; const MacroProgram* prog; };
+    for (const Bench& b : { Bench{ "control flow", &flow }, Bench{ "with effects", &mixed } }) {
+        constexpr uint64_t kSteps = 20000000;
+        RecordingHost host;
+        MacroVm vm;
+        vm.Reset(1);
+        uint64_t done = 0;
+        const double t0 = Test::NowSec();
+        while (done < kSteps) {
+            host.events.clear();
+            vm.Run(*b.prog, host, 100000);
+            done += vm.Steps();
+        }
+        const double sec = Test::NowSec() - t0;
+        std::printf("  %s: %.1f M instructions / s\n", b.name, (double)done / sec / 1e6);
+        CHECK(done / sec > 1e6);
+    }
+}
@@ -0,0 +1,193 @@
+// mouse_output_tests.cpp
+// Mouse output through RecordingMouseSink: slow movement is not lost to
+// truncation, the total sent stays within one unit of the integral over long
+// runs, reversals, the curve and the config. Benchmark: ns per tick.
+#include "test.h"
+
+#include "../HallJoy/mouse_output.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+    struct Rng
+    {
+        uint32_t s;
+        uint32_t Next() { s = s * 1664525u + 1013904223u; return s >> 8; }
+        float Unit() { return (float)Next() / 16777216.0f; }          // 0..1
+        float Signed() { return Unit() * 2.0f - 1.0f; }                // -1..1
+    };
+
+    // What the realtime thread does with a tick's move
+    void Send(RecordingMouseSink& sink, const MouseOutMove& m)
+    {
+        if (m.Any()) MouseOut_RecordMove(m, sink.Move(m));
+    }
+}
+
+TEST(Mouse_SlowMovementIsNotLost)
+{
+    // Half a pixel per tick: one pixel every other tick, none lost
+    RecordingMouseSink sink;
+    MouseOutAccum acc;
+    for (int i = 0; i < 1000; ++i) Send(sink, MouseOut_Integrate(acc, 500.0f, -500.0f, 0.0f, 0.001f));
+    CHECK_EQ(sink.TotalX(), 500);
+    CHECK_EQ(sink.TotalY(), -500);
+    CHECK_EQ(sink.Moves().size(), 500u);
+    for (const MouseOutMove& m : sink.Moves()) CHECK(std::abs(m.dx) <= 1 && std::abs(m.dy) <= 1);
+
+    // 0.37 px / s at 1 kHz for an hour: far below a pixel per tick, still all there
+    sink.Clear();
+    acc = MouseOutAccum{};
+    constexpr uint64_t kTicks = 1000ull * 3600;
+    const float dt = 0.001f;
+    for (uint64_t i = 0; i < kTicks; ++i) Send(sink, MouseOut_Integrate(acc, 0.37f, -0.37f, 0.0f, dt));
+    const double ideal = 0.37 * (double)dt * (double)kTicks;
+    CHECK(std::fabs((double)sink.TotalX() - ideal) < 1.0);
+    CHECK_EQ(sink.TotalX(), -sink.TotalY());
+    CHECK(sink.TotalX() > 0);
+}
+
+TEST(Mouse_TotalStaysWithinOneUnitOfTheIntegral)
+{
+    // Random deflections and tick lengths through the curve, against the
+    // same speeds integrated in long double
+    MouseOutConfig cfg;
+    cfg.enabled = true;
+    RecordingMouseSink sink;
+    MouseOutAccum acc;
+    Rng rng{ 7 };
+    long double refX = 0, refY = 0, refW = 0;
+    for (int i = 0; i < 2000000; ++i) {
+        const MouseOutInput in{ rng.Signed(), rng.Signed(), rng.Signed() };
+        const float dt = 0.0001f + rng.Unit() * 0.0019f;
+
+        const float r = std::sqrt(in.x * in.x + in.y * in.y);
+        if (r > 0.0f) {
+            const float speed = MouseOut_Speed(cfg.move, std::min(r, 1.0f));
+            refX += (long double)(in.x / r * speed) * dt;
+            refY += (long double)(in.y / r * speed) * dt;
+        }
+        refW += (long double)(std::copysign(MouseOut_Speed(cfg.wheel, std::fabs(in.wheel)), in.wheel)
+            * (float)MOUSE_OUT_WHEEL_DELTA) * dt;
+
+        Send(sink, MouseOut_Step(cfg, acc, in, dt));
+        if (std::fabs(acc.x) >= 1.0 || std::fabs(acc.y) >= 1.0 || std::fabs(acc.wheel) >= 1.0) {
+            CHECK(false);
+            return;
+        }
+    }
+    CHECK(std::fabs((long double)sink.TotalX() - refX) < 1);
+    CHECK(std::fabs((long double)sink.TotalY() - refY) < 1);
+    CHECK(std::fabs((long double)sink.TotalWheel() - refW) < 1);
+}
+
+TEST(Mouse_ReversalEatsTheRemainderFirst)
+{
+    RecordingMouseSink sink;
+    MouseOutAccum acc;
+    Send(sink, MouseOut_Integrate(acc, 1700.0f, 0.0f, 0.0f, 0.001f));   // 1.7 px
+    CHECK_EQ(sink.TotalX(), 1);
+    CHECK(std::fabs(acc.x - 0.7) < 1e-6);
+
+    // 0.9 back: the 0.7 left goes first, no pixel the other way yet
+    Send(sink, MouseOut_Integrate(acc, -900.0f, 0.0f, 0.0f, 0.001f));
+    CHECK_EQ(sink.TotalX(), 1);
+    CHECK(std::fabs(acc.x + 0.2) < 1e-6);
+    Send(sink, MouseOut_Integrate(acc, -900.0f, 0.0f, 0.0f, 0.001f));
+    CHECK_EQ(sink.TotalX(), 0);
+    CHECK_EQ(sink.Moves().back().dx, -1);
+
+    // Back and forth by less than a pixel sends nothing
+    sink.Clear();
+    acc = MouseOutAccum{};
+    for (int i = 0; i < 1000; ++i)
+        Send(sink, MouseOut_Integrate(acc, (i & 1) ? -900.0f : 900.0f, 0.0f, 0.0f, 0.001f));
+    CHECK_EQ(sink.Moves().size(), 0u);
+}
+
+TEST(Mouse_CurveConfigAndStats)
+{
+    const MouseOutCurve c;
+    CHECK_EQ(MouseOut_Speed(c, 0.04f), 0.0f);
+    CHECK(std::fabs(MouseOut_Speed(c, 1.0f) - 1500.0f) < 0.01f);
+    CHECK(MouseOut_Speed(c, 0.5f) < 750.0f);                    // gamma 1.5 under linear
+    CHECK_EQ(MouseOut_Speed(c, 2.0f), MouseOut_Speed(c, 1.0f));
+
+    // Disabled: nothing moves and the remainders are dropped
+    MouseOutConfig cfg;
+    MouseOutAccum acc{ 0.5, 0.5, 0.5 };
+    CHECK(!MouseOut_Step(cfg, acc, { 1.0f, 1.0f, 1.0f }, 0.01f).Any());
+    CHECK_EQ(acc.x, 0.0);
+    CHECK_EQ(acc.wheel, 0.0);
+
+    cfg.keys[0] = 300;
+    cfg.stickPad = 40;
+    cfg.stick = 5;
+    cfg.move.gammaM = 1;
+    cfg.wheel.maxSpeed = 0;
+    cfg = MouseOut_Sanitize(cfg);
+    CHECK_EQ(cfg.keys[0], 0);
+    CHECK_EQ(cfg.stickPad, -1);
+    CHECK_EQ(cfg.stick, 1);
+    CHECK_EQ(cfg.move.gammaM, 250);
+    CHECK_EQ(cfg.wheel.maxSpeed, 1u);
+
+    // A stall moves as if the tick lasted MOUSE_OUT_MAX_DT
+    cfg.enabled = true;
+    acc = MouseOutAccum{};
+    const MouseOutMove stall = MouseOut_Step(cfg, acc, { 1.0f, 0.0f, 0.0f }, 5.0f);
+    CHECK_EQ(stall.dx, (int32_t)(1500 * MOUSE_OUT_MAX_DT));
+
+    // Bound keys follow the config, only while enabled
+    const uint32_t gen = MouseOut_ConfigGeneration();
+    cfg.keys[(int)MouseOutKey::Right] = 7;
+    MouseOut_Set(cfg);
+    CHECK(MouseOut_ConfigGeneration() != gen);
+    CHECK(MouseOut_IsHidBound(7));
+    CHECK(!MouseOut_IsHidBound(4));
+    CHECK(!MouseOut_IsHidBound(0));
+    CHECK_EQ(MouseOut_Get().keys[(int)MouseOutKey::Right], 7);
+    cfg.enabled = false;
+    MouseOut_Set(cfg);
+    CHECK(!MouseOut_IsHidBound(7));
+    MouseOut_Set(MouseOutConfig{});
+
+    // Stats count what the sink took; a failed move adds nothing
+    MouseOutStats before, after;
+    MouseOut_GetStats(&before);
+    RecordingMouseSink sink;
+    Send(sink, stall);
+    MouseOut_RecordMove(stall, false);
+    MouseOut_GetStats(&after);
+    CHECK_EQ(after.moves - before.moves, 2u);
+    CHECK_EQ(after.failures - before.failures, 1u);
+    CHECK_EQ(after.totalX - before.totalX, (int64_t)stall.dx);
+    CHECK_EQ(sink.TotalX(), (int64_t)stall.dx);
+}
+
+BENCH(Mouse_StepPerTick)
+{
+    MouseOutConfig cfg;
+    cfg.enabled = true;
+    RecordingMouseSink sink;
+    MouseOutAccum acc;
+    Rng rng{ 3 };
+    int64_t sent = 0;
+    constexpr int kTicks = 5000000;
+    const double t0 = Test::NowSec();
+    for (int i = 0; i < kTicks; ++i) {
+        const MouseOutInput in{ rng.Signed(), rng.Signed(), rng.Signed() };
+        const MouseOutMove m = MouseOut_Step(cfg, acc, in, 0.001f);
+        if (m.Any()) {
+            sink.Move(m);
+            sent += m.dx;
+            if (sink.Moves().size() > 4096) sink.Clear();
+        }
+    }
+    const double ns = (Test::NowSec() - t0) * 1e9 / kTicks;
+    std::printf("  step + sink %.1f ns / tick (%lld px)\n", ns, (long long)sent);
+    CHECK(ns < 2000.0);
+}
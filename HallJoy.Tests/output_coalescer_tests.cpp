@@ -0,0 +1,206 @@
+// output_coalescer_tests.cpp
+// Macro output stage on the virtual clock (RecordingOutputSink): one sink
+// call per deadline, absolute deadlines, late restart, split batches.
+// Benchmark: cost per event through the coalescer.
+#include "test.h"
+
+#include "../HallJoy/output_coalescer.h"
+
+namespace
+{
+    // Sink that takes `costUs` of virtual time per call (a slow SendInput)
+    class SlowSink : public RecordingOutputSink
+    {
+    public:
+        explicit SlowSink(uint64_t costUs) : m_costUs(costUs) {}
+        uint32_t Send(const OutputEvent* events, uint32_t count) override
+        {
+            const uint32_t n = RecordingOutputSink::Send(events, count);
+            AdvanceUs(m_costUs);
+            return n;
+        }
+
+    private:
+        uint64_t m_costUs;
+    };
+}
+
+TEST(Out_SameDeadlineIsOneCall)
+{
+    RecordingOutputSink sink;
+    OutputCoalescer out(&sink);
+    out.Key('A', 0, false);
+    out.Key('B', 0, false);
+    out.Mouse(0, false);
+    CHECK_EQ(sink.Batches().size(), 0u);
+    out.Wait(10000);
+    out.Key('A', 0, true);
+    out.Flush();
+
+    CHECK_EQ(sink.Batches().size(), 2u);
+    CHECK_EQ(sink.Batches()[0].events.size(), 3u);
+    CHECK_EQ(sink.Batches()[0].timeUs, 0u);
+    CHECK_EQ(sink.Batches()[1].timeUs, 10000u);
+    CHECK_EQ(out.SendCalls(), 2u);
+    CHECK_EQ(out.EventsSent(), 4u);
+    CHECK_EQ(out.PendingCount(), 0u);
+}
+
+TEST(Out_DeadlinesDoNotDriftWithSendCost)
+{
+    // 100 x (press, 10 ms): a 3 ms send must not stretch the run to 1.3 s.
+    // The first gap counts from after the first send, then the grid holds.
+    SlowSink sink(3000);
+    OutputCoalescer out(&sink);
+    for (int i = 0; i < 100; ++i) {
+        out.Key('A', 0, (i & 1) != 0);
+        out.Wait(10000);
+    }
+    CHECK_EQ(sink.Batches().size(), 100u);
+    CHECK_EQ(sink.Batches()[0].timeUs, 0u);
+    for (size_t i = 1; i < sink.Batches().size(); ++i)
+        CHECK_EQ(sink.Batches()[i].timeUs, 3000u + i * 10000u);
+    CHECK_EQ(sink.NowUs(), 3000u + 1000000u);
+}
+
+TEST(Out_LateByMoreThanAGapRestartsFromNow)
+{
+    RecordingOutputSink sink;
+    OutputCoalescer out(&sink);
+    out.Key('A', 0, false);
+    out.Wait(10000);                 // cursor 10 ms
+    sink.AdvanceUs(50000);           // stalled: now 60 ms
+    out.Key('A', 0, true);
+    out.Wait(10000);                 // no catch-up burst: 70 ms
+    out.Key('B', 0, false);
+    out.Flush();
+
+    CHECK_EQ(sink.Batches().size(), 3u);
+    CHECK_EQ(sink.Batches()[1].timeUs, 60000u);
+    CHECK_EQ(sink.Batches()[2].timeUs, 70000u);
+
+    // Restart forgets the cursor: the next gap counts from now
+    sink.AdvanceUs(5000);
+    out.Restart();
+    out.Wait(10000);
+    CHECK_EQ(sink.NowUs(), 85000u);
+}
+
+TEST(Out_LongBurstIsSplitByMaxBatch)
+{
+    RecordingOutputSink sink;
+    OutputCoalescer out(&sink);
+    OutputPacing p;
+    p.maxBatch = 8;
+    p.batchGapUs = 500;
+    out.SetPacing(p);
+
+    for (uint16_t i = 0; i < 20; ++i) out.Unicode(L'a' + i, false);
+    out.Flush();
+    CHECK_EQ(sink.Batches().size(), 3u);
+    CHECK_EQ(sink.Batches()[0].events.size(), 8u);
+    CHECK_EQ(sink.Batches()[2].events.size(), 4u);
+    CHECK_EQ(sink.Batches()[1].timeUs, 500u);
+    CHECK_EQ(sink.Batches()[2].timeUs, 1000u);
+    CHECK_EQ(sink.Batches()[2].events[3].code, (uint16_t)(L'a' + 19));
+
+    // Past kMaxPending the buffer flushes itself, nothing is dropped
+    sink.Clear();
+    out.SetPacing(OutputPacing{});
+    for (uint32_t i = 0; i < OutputCoalescer::kMaxPending + 10; ++i) out.Key('A', 0, (i & 1) != 0);
+    out.Flush();
+    size_t events = 0;
+    for (const auto& b : sink.Batches()) events += b.events.size();
+    CHECK_EQ(events, (size_t)OutputCoalescer::kMaxPending + 10);
+}
+
+TEST(Out_TypeText50UnderTheShippedPacing)
+{
+    // TypeText as the combo worker runs it: Text(), then the action gap
+    const wchar_t* text = L"The quick brown fox jumps over the lazy dog 123456";
+    constexpr uint32_t kLen = 50;
+    auto typeText = [&](const OutputPacing& p, RecordingOutputSink& sink) {
+        OutputCoalescer out(&sink);
+        out.SetPacing(p);
+        CHECK(out.Text(text, kLen));
+        out.Wait(p.actionGapUs);
+        return sink.NowUs();
+    };
+
+    const OutputPacing shipped;
+    CHECK(shipped.mode == OutputPacingMode::Burst);
+    RecordingOutputSink burst;
+    const uint64_t burstUs = typeText(shipped, burst);
+
+    OutputPacing paced;
+    paced.mode = OutputPacingMode::Paced;
+    RecordingOutputSink legacy;
+    const uint64_t pacedUs = typeText(paced, legacy);
+
+    // Every character down + up, in order, in both modes
+    for (const RecordingOutputSink* sink : { &burst, &legacy }) {
+        uint32_t n = 0;
+        for (const auto& b : sink->Batches())
+            for (const OutputEvent& ev : b.events) {
+                CHECK(ev.kind == OutputEventKind::Unicode);
+                CHECK_EQ(ev.code, (uint16_t)text[n / 2]);
+                CHECK_EQ(ev.up, (n & 1) != 0);
+                ++n;
+            }
+        CHECK_EQ(n, 2 * kLen);
+    }
+
+    // Burst: 100 events in two sink calls (maxBatch 64), then one action gap
+    CHECK_EQ(burst.Batches().size(), 2u);
+    CHECK_EQ(burstUs, (uint64_t)shipped.actionGapUs);
+    CHECK_EQ(legacy.Batches().size(), (size_t)kLen);
+    CHECK_EQ(pacedUs, (uint64_t)kLen * paced.textCharGapUs + paced.actionGapUs);
+    std::printf("  50 chars: burst %.1f ms, paced %.1f ms (x%.0f)\n",
+        burstUs / 1000.0, pacedUs / 1000.0, (double)pacedUs / (double)burstUs);
+    CHECK(pacedUs >= 10 * burstUs);
+
+    // Cancelled before the first unit: nothing queued
+    std::atomic<bool> cancel{ true };
+    RecordingOutputSink none;
+    OutputCoalescer out(&none);
+    CHECK(!out.Text(text, kLen, &cancel));
+    CHECK_EQ(out.PendingCount(), 0u);
+}
+
+TEST(Out_NoSinkDropsPending)
+{
+    OutputCoalescer out(nullptr);
+    out.Key('A', 0, false);
+    out.Wait(10000);
+    CHECK_EQ(out.PendingCount(), 0u);
+    CHECK_EQ(out.SendCalls(), 0u);
+}
+
+BENCH(Out_CoalescerPerEvent)
+{
+    // Text-sized bursts (32 down/up pairs) per deadline, virtual clock
+    class NullSink : public IOutputSink
+    {
+    public:
+        uint32_t Send(const OutputEvent*, uint32_t count) override { return count; }
+        uint64_t NowUs() override { return m_now; }
+        void SleepUntilUs(uint64_t d) override { if (d > m_now) m_now = d; }
+        uint64_t m_now = 0;
+    } sink;
+    OutputCoalescer out(&sink);
+
+    constexpr int kDeadlines = 200000;
+    const double t0 = Test::NowSec();
+    for (int d = 0; d < kDeadlines; ++d) {
+        for (uint16_t c = 0; c < 32; ++c) {
+            out.Unicode(c, false);
+            out.Unicode(c, true);
+        }
+        out.Wait(1000);
+    }
+    const double sec = Test::NowSec() - t0;
+    const double events = (double)out.EventsSent();
+    std::printf("  %.1f ns / event, %.1f events / sink call\n", sec / events * 1e9, events / (double)out.SendCalls());
+    CHECK_EQ(out.EventsSent(), (uint64_t)kDeadlines * 64);
+    CHECK(sec / events < 1e-6);
+}
@@ -0,0 +1,323 @@
+// pad_sink_tests.cpp
+// The analog -> curve -> report -> pad pipeline end to end: FakeAnalogSource
+// keyboards in, RecordingPadSink out, PadSink_Update stats; on Linux the
+// uinput event encoding and connect errors too. Benchmark: tick cost and write latency per sink.
+#include "test.h"
+
+#include "../HallJoy/analog_devices.h"
+#include "../HallJoy/curve_math.h"
+#include "../HallJoy/pad_sink.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__linux__)
+#include "../HallJoy/uinput_pad_sink.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr uint16_t kA = 4, kD = 7, kQ = 20, kS = 22, kW = 26, kSpace = 44;
+
+    struct Reset
+    {
+        Reset() { Clear(); }
+        ~Reset() { Clear(); }
+        static void Clear()
+        {
+            AnalogDevices_SetSlotIds({});
+            AnalogDevices_ClearKeyDevices();
+            AnalogDevices_SetPolicy(AnalogMergePolicy::Max);
+        }
+    };
+
+    // W/A/S/D -> left stick, Space -> A, Q -> LT, through the default key
+    // curve as the backend applies it (nothing below low, the cap above high)
+    PadReport BuildReport(int pad)
+    {
+        static const KeyDeadzone ks;
+        static const CurveMath::Curve01 curve = CurveMath::FromKeyDeadzone(ks);
+        auto d = [&](uint16_t hid) {
+            const float x = AnalogDevices_Depth(pad, hid);
+            if (x < ks.low) return 0.0f;
+            if (x > ks.high) return ks.outputCap;
+            return CurveMath::EvalRationalYForX(curve, x);
+        };
+        PadReport r;
+        r.lx = (int16_t)std::lround(std::clamp(d(kD) - d(kA), -1.0f, 1.0f) * 32767.0f);
+        r.ly = (int16_t)std::lround(std::clamp(d(kW) - d(kS), -1.0f, 1.0f) * 32767.0f);
+        r.leftTrigger = (uint8_t)std::lround(d(kQ) * 255.0f);
+        if (d(kSpace) > 0.5f) r.buttons |= PAD_BTN_A;
+        return r;
+    }
+
+    bool Same(const PadReport& a, const PadReport& b)
+    {
+        return std::memcmp(&a, &b, sizeof(PadReport)) == 0;
+    }
+
+    // One tick of the realtime side: poll, build, send the reports that changed
+    struct Pipeline
+    {
+        IPadSink&    sink;
+        int          pads;
+        PadReport    last[PAD_SINK_MAX_PADS]{};
+        bool         sent[PAD_SINK_MAX_PADS]{};
+        PadSinkStats stats{};
+
+        void Tick(IAnalogSource& src, uint64_t nowMs)
+        {
+            AnalogDevices_Poll(src, nowMs);
+            for (int pad = 0; pad < pads; ++pad) {
+                const PadReport r = BuildReport(pad);
+                if (sent[pad] && Same(r, last[pad])) continue;
+                int err = 0;
+                if (PadSink_Update(sink, pad, r, &err, stats)) { last[pad] = r; sent[pad] = true; }
+            }
+        }
+    };
+
+#if defined(__linux__)
+    // uinput's encoding and one write() per report, into /dev/null: the
+    // write path without a uinput device
+    class NullUinputSink : public IPadSink
+    {
+    public:
+        ~NullUinputSink() override { Disconnect(); }
+        const char* Name() const override { return "uinput (/dev/null)"; }
+        bool Connect(int count, int* outErr) override
+        {
+            m_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+            if (outErr) *outErr = m_fd < 0 ? errno : 0;
+            m_count = m_fd < 0 ? 0 : std::clamp(count, 1, PAD_SINK_MAX_PADS);
+            return m_fd >= 0;
+        }
+        void Disconnect() override
+        {
+            if (m_fd >= 0) close(m_fd);
+            m_fd = -1;
+            m_count = 0;
+        }
+        int Pads() const override { return m_count; }
+        bool Update(int pad, const PadReport& report, int* outErr) override
+        {
+            if (outErr) *outErr = 0;
+            input_event ev[UINPUT_PAD_MAX_EVENTS];
+            const int n = UinputPadSink::Encode(m_last[pad], report, !m_sent[pad], ev);
+            if (!n) return true;
+            const ssize_t bytes = (ssize_t)(sizeof(input_event) * (size_t)n);
+            if (write(m_fd, ev, (size_t)bytes) != bytes) { if (outErr) *outErr = errno; return false; }
+            m_last[pad] = report;
+            m_sent[pad] = true;
+            return true;
+        }
+
+    private:
+        int       m_fd = -1;
+        int       m_count = 0;
+        PadReport m_last[PAD_SINK_MAX_PADS]{};
+        bool      m_sent[PAD_SINK_MAX_PADS]{};
+    };
+#endif
+
+    void BenchSink(IPadSink& sink, int pads)
+    {
+        Reset reset;
+        FakeAnalogSource src;
+        for (int i = 0; i < pads; ++i) src.AddDevice(100 + (uint64_t)i);
+        AnalogDevices_SetPolicy(AnalogMergePolicy::PerPad);
+        int err = 0;
+        CHECK(sink.Connect(pads, &err));
+
+        constexpr int kTicks = 20000;
+        Pipeline pipe{ sink, pads };
+        const double t0 = Test::NowSec();
+        for (int t = 0; t < kTicks; ++t) {
+            for (int i = 0; i < pads; ++i) {
+                src.SetKey(100 + (uint64_t)i, kW, 0.5f + 0.5f * std::sin((float)(t + i) * 0.01f));
+                src.SetKey(100 + (uint64_t)i, kSpace, (t / 50) & 1 ? 1.0f : 0.0f);
+            }
+            pipe.Tick(src, (uint64_t)t);
+        }
+        const double us = (Test::NowSec() - t0) * 1e6 / kTicks;
+        const PadSinkStats& st = pipe.stats;
+        std::printf("  %-18s %2d pad(s): %.2f us / tick, write mean %.2f us, p50 <= %u us, p99 <= %u us, max %u us\n",
+            sink.Name(), pads, us, st.updates ? (double)st.totalUs / (double)st.updates : 0.0,
+            PadSink_LatencyPercentileUs(st, 0.5f), PadSink_LatencyPercentileUs(st, 0.99f), st.maxUs);
+        CHECK_EQ(st.failures, 0u);
+        CHECK(st.updates > (uint64_t)kTicks * (uint64_t)pads / 2);
+        sink.Disconnect();
+    }
+}
+
+TEST(PadSink_RecordingSinkAndStats)
+{
+    RecordingPadSink sink;
+    int err = -1;
+    CHECK(sink.Connect(40, &err));
+    CHECK_EQ(err, 0);
+    CHECK_EQ(sink.Pads(), PAD_SINK_MAX_PADS);
+
+    PadSinkStats st;
+    PadReport r;
+    r.buttons = PAD_BTN_A;
+    CHECK(PadSink_Update(sink, 3, r, &err, st));
+    CHECK(!PadSink_Update(sink, PAD_SINK_MAX_PADS, r, &err, st));
+    CHECK_EQ(err, 1);
+    sink.SetBroken(true);
+    CHECK(!PadSink_Update(sink, 0, r, &err, st));
+    sink.SetBroken(false);
+    CHECK(PadSink_Update(sink, 0, r, &err, st));
+
+    CHECK_EQ(sink.Updates().size(), 2u);
+    CHECK_EQ(sink.Updates()[0].pad, 3);
+    CHECK_EQ(sink.Updates()[0].report.buttons, PAD_BTN_A);
+    CHECK_EQ(st.updates, 4u);
+    CHECK_EQ(st.failures, 2u);
+    uint64_t bucketed = 0;
+    for (uint64_t n : st.latency) bucketed += n;
+    CHECK_EQ(bucketed, 4u);
+    CHECK(PadSink_LatencyPercentileUs(st, 0.5f) >= 1u);
+    CHECK_EQ(PadSink_LatencyPercentileUs(PadSinkStats{}, 0.5f), 0u);
+
+    sink.Disconnect();
+    CHECK(!sink.Update(0, r, &err));
+}
+
+TEST(PadSink_PipelineEndToEnd)
+{
+    Reset reset;
+    FakeAnalogSource src;
+    src.AddDevice(100, "left");
+    src.AddDevice(200, "right");
+    AnalogDevices_SetPolicy(AnalogMergePolicy::PerPad);
+
+    RecordingPadSink sink;
+    int err = 0;
+    CHECK(sink.Connect(2, &err));
+    Pipeline pipe{ sink, 2 };
+
+    // First tick: both pads at rest, one report each
+    pipe.Tick(src, 0);
+    CHECK_EQ(sink.Updates().size(), 2u);
+    CHECK(Same(sink.Updates()[0].report, PadReport{}));
+
+    // Keys of the first keyboard only drive pad 0
+    src.SetKey(100, kW, 1.0f);
+    src.SetKey(100, kD, 0.5f);
+    src.SetKey(100, kSpace, 1.0f);
+    src.SetKey(100, kQ, 0.95f);
+    sink.Clear();
+    pipe.Tick(src, 1);
+    CHECK_EQ(sink.Updates().size(), 1u);
+    const PadReport& p0 = sink.Updates()[0].report;
+    CHECK_EQ(sink.Updates()[0].pad, 0);
+    CHECK_EQ(p0.ly, 32767);
+    CHECK(p0.lx > 8000 && p0.lx < 24000);
+    CHECK_EQ(p0.buttons, PAD_BTN_A);
+    CHECK_EQ(p0.leftTrigger, 255);
+
+    // Below the curve's deadzone nothing moves; nothing changed, nothing sent
+    src.SetKey(200, kS, 0.05f);
+    sink.Clear();
+    pipe.Tick(src, 2);
+    pipe.Tick(src, 3);
+    CHECK_EQ(sink.Updates().size(), 0u);
+
+    // Opposite directions on the second keyboard cancel, down alone is down
+    src.SetKey(200, kW, 1.0f);
+    src.SetKey(200, kS, 1.0f);
+    pipe.Tick(src, 4);
+    CHECK_EQ(sink.Updates().size(), 0u);
+    src.SetKey(200, kW, 0.0f);
+    pipe.Tick(src, 5);
+    CHECK_EQ(sink.Updates().size(), 1u);
+    CHECK_EQ(sink.Updates()[0].pad, 1);
+    CHECK_EQ(sink.Updates()[0].report.ly, -32767);
+
+    // Unplugged with keys held: pad 0 goes back to rest
+    src.RemoveDevice(100);
+    sink.Clear();
+    pipe.Tick(src, 6);
+    CHECK_EQ(sink.Updates().size(), 1u);
+    CHECK(Same(sink.Updates()[0].report, PadReport{}));
+
+    // A sink that broke is retried on the next tick
+    src.SetKey(200, kSpace, 1.0f);
+    sink.SetBroken(true);
+    sink.Clear();
+    pipe.Tick(src, 7);
+    sink.SetBroken(false);
+    pipe.Tick(src, 8);
+    CHECK_EQ(sink.Updates().size(), 1u);
+    CHECK_EQ(sink.Updates()[0].report.buttons, PAD_BTN_A);
+    CHECK_EQ(pipe.stats.failures, 1u);
+}
+
+#if defined(__linux__)
+TEST(Uinput_EncodeFullThenDelta)
+{
+    input_event ev[UINPUT_PAD_MAX_EVENTS];
+    PadReport rest, next;
+    next.lx = 1000;
+    next.ly = 32767;
+    next.buttons = PAD_BTN_A | PAD_BTN_DPAD_UP;
+
+    // Full: 11 buttons, 4 sticks, 2 triggers, 2 hat axes, SYN_REPORT last
+    int n = UinputPadSink::Encode(rest, rest, true, ev);
+    CHECK_EQ(n, 20);
+    CHECK(ev[n - 1].type == EV_SYN && ev[n - 1].code == SYN_REPORT);
+
+    // Delta: A, LX, LY, HAT0Y, SYN_REPORT; Y flipped
+    n = UinputPadSink::Encode(rest, next, false, ev);
+    CHECK_EQ(n, 5);
+    for (int i = 0; i < n; ++i) {
+        if (ev[i].type == EV_ABS && ev[i].code == ABS_Y) CHECK_EQ(ev[i].value, -32768);
+        if (ev[i].type == EV_ABS && ev[i].code == ABS_HAT0Y) CHECK_EQ(ev[i].value, -1);
+        if (ev[i].type == EV_KEY && ev[i].code == BTN_SOUTH) CHECK_EQ(ev[i].value, 1);
+    }
+    CHECK_EQ(UinputPadSink::Encode(next, next, false, ev), 0);
+}
+
+TEST(Uinput_ConnectFailsWithoutADevice)
+{
+    // No node: the open's errno, nothing connected
+    int err = 0;
+    UinputPadSink missing("/nonexistent/uinput");
+    CHECK(!missing.Connect(2, &err));
+    CHECK_EQ(err, ENOENT);
+    CHECK_EQ(missing.Pads(), 0);
+
+    // A node that is not uinput: the first ioctl fails, the fd is closed
+    UinputPadSink notUinput("/dev/null");
+    err = 0;
+    CHECK(!notUinput.Connect(1, &err));
+    CHECK_EQ(err, ENOTTY);
+    CHECK_EQ(notUinput.Pads(), 0);
+
+    PadReport r;
+    CHECK(!notUinput.Update(0, r, &err));
+    CHECK_EQ(err, ENODEV);
+}
+#endif
+
+BENCH(PadSink_EndToEnd)
+{
+    // One keyboard per pad (PerPad policy)
+    for (int pads : { 1, 4, ANALOG_MAX_DEVICES }) {
+        RecordingPadSink rec;
+        BenchSink(rec, pads);
+    }
+#if defined(__linux__)
+    for (int pads : { 1, 4, ANALOG_MAX_DEVICES }) {
+        NullUinputSink nul;
+        BenchSink(nul, pads);
+    }
+#endif
+}
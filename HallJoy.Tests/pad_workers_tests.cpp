@@ -0,0 +1,309 @@
+// pad_workers_tests.cpp
+// Pad workers run every index of a run exactly once, with or without
+// workers and when the count changes from one run to the next, and a bindings snapshot stays as it was while a higher pad grows
+// the block. Benchmark: cost of the per-pad tick work for 1, 4, 8, 16 pads.
+#include "test.h"
+
+#include "../HallJoy/binding_layers.h"
+#include "../HallJoy/bindings.h"
+#include "../HallJoy/pad_workers.h"
+#include "../HallJoy/socd.h"
+#include "../HallJoy/stick_shape.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    struct Rng
+    {
+        uint32_t s;
+        uint32_t Next() { s = s * 1664525u + 1013904223u; return s >> 8; }
+    };
+
+    bool SameBindings(const PadBindings& a, const PadBindings& b)
+    {
+        for (int i = 0; i < 4; ++i)
+            if (a.axes[i].minusHid != b.axes[i].minusHid || a.axes[i].plusHid != b.axes[i].plusHid) return false;
+        return a.triggers[0] == b.triggers[0] && a.triggers[1] == b.triggers[1]
+            && std::memcmp(a.buttons, b.buttons, sizeof(a.buttons)) == 0;
+    }
+
+    bool Unbound(const PadBindings& b)
+    {
+        return SameBindings(b, PadBindings{});
+    }
+
+    // Pad p binds its own 14 keys: 8 stick directions, 2 triggers, 4 buttons
+    PadBindings PadOf(int p)
+    {
+        PadBindings pb;
+        const uint16_t h = (uint16_t)(4 + (p * 14) % 240);
+        for (int a = 0; a < 4; ++a) pb.axes[a] = { (uint16_t)(h + a * 2), (uint16_t)(h + a * 2 + 1) };
+        pb.triggers[0] = (uint16_t)(h + 8);
+        pb.triggers[1] = (uint16_t)(h + 9);
+        for (int b = 0; b < 4; ++b) {
+            const uint16_t hid = (uint16_t)(h + 10 + b);
+            pb.buttons[b][hid / 64] |= 1ull << (hid % 64);
+        }
+        return pb;
+    }
+
+    struct CountJob
+    {
+        std::atomic<int> hits[64];
+    };
+
+    void CountIndex(void* user, int index)
+    {
+        static_cast<CountJob*>(user)->hits[index].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Same job through another function: a worker running an index with the
+    // previous run's function or count shows up as a miss or a double hit
+    void CountIndexTwice(void* user, int index)
+    {
+        static_cast<CountJob*>(user)->hits[index].fetch_add(2, std::memory_order_relaxed);
+    }
+
+    // ---- What the backend does per pad in a tick, on plain arrays ----
+    struct Report
+    {
+        uint16_t buttons = 0;
+        int16_t  sticks[4]{};
+        uint8_t  triggers[2]{};
+        bool operator==(const Report& o) const { return std::memcmp(this, &o, sizeof(Report)) == 0; }
+    };
+
+    struct TickJob
+    {
+        const float*            depth = nullptr;   // 256 HIDs, 0..1
+        const uint64_t*         down = nullptr;    // 4 chunks
+        const PadBindings*      bindings = nullptr;
+        const SocdAxis*         axes = nullptr;    // pad * 4 + axis
+        SocdAxisState*          socd = nullptr;
+        const StickShapeTables* sticks = nullptr;  // pad * 2 + stick
+        Report*                 reports = nullptr;
+    };
+
+    int16_t StickValue(float v)
+    {
+        return (int16_t)std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f);
+    }
+
+    void BuildReport(void* user, int pad)
+    {
+        const TickJob& job = *static_cast<const TickJob*>(user);
+        const PadBindings& pb = job.bindings[pad];
+        float v[4];
+        for (int a = 0; a < 4; ++a)
+            v[a] = Socd_Resolve(job.socd[pad * 4 + a], job.axes[pad * 4 + a],
+                job.depth[pb.axes[a].minusHid], job.depth[pb.axes[a].plusHid]);
+        StickShape_Apply(job.sticks[pad * 2], v[0], v[1]);
+        StickShape_Apply(job.sticks[pad * 2 + 1], v[2], v[3]);
+
+        Report r;
+        for (int a = 0; a < 4; ++a) r.sticks[a] = StickValue(v[a]);
+        for (int t = 0; t < 2; ++t) r.triggers[t] = (uint8_t)std::lround(job.depth[pb.triggers[t]] * 255.0f);
+        for (int b = 0; b < BINDINGS_BUTTON_COUNT; ++b)
+            for (int chunk = 0; chunk < 4; ++chunk)
+                if (pb.buttons[b][chunk] & job.down[chunk]) { r.buttons |= (uint16_t)(1u << b); break; }
+        job.reports[pad] = r;
+    }
+
+    // Every pad configured: bindings published, a hold layer, SOCD modes, stick shapes.
+    struct Rig
+    {
+        static constexpr int kPads = BINDINGS_MAX_GAMEPADS;
+        std::vector<PadLayerTable>    layers = std::vector<PadLayerTable>(kPads);
+        std::vector<PadLayerState>    layerState = std::vector<PadLayerState>(kPads);
+        std::vector<PadBindings>      base = std::vector<PadBindings>(kPads);
+        std::vector<PadBindings>      tick = std::vector<PadBindings>(kPads);
+        std::vector<SocdAxis>         axes = std::vector<SocdAxis>(kPads * 4);
+        std::vector<SocdAxisState>    socd = std::vector<SocdAxisState>(kPads * 4);
+        std::vector<StickShapeTables> sticks = std::vector<StickShapeTables>(kPads * 2);
+        std::vector<Report>           reports = std::vector<Report>(kPads);
+        float    depth[256]{};
+        uint64_t down[4]{};
+        BindingsSnapshot snapshot;
+
+        Rig()
+        {
+            Bindings_ClearAll();
+            StickShapeConfig shape;
+            shape.circle = true;
+            shape.innerM = 80;
+            shape.gammaM = 1500;
+            const SocdMode modes[4] = { SocdMode::LastWins, SocdMode::Neutral, SocdMode::Sum, SocdMode::AnalogMax };
+            for (int p = 0; p < kPads; ++p) {
+                Bindings_SetPad(p, PadOf(p));
+                PadLayers pl;
+                pl.keys[0] = { 250, 1, LayerKeyMode::Hold };
+                pl.keyCount = 1;
+                pl.layers[0].axes[0] = PadOf(p + 1).axes[2];
+                BindingLayers_Compile(pl, layers[(size_t)p]);
+                for (int a = 0; a < 4; ++a) axes[(size_t)(p * 4 + a)] = Socd_Compile(modes[(p + a) % 4], false, true, 0.12f);
+                StickShape_Compile(shape, sticks[(size_t)(p * 2)]);
+                StickShape_Compile(StickShapeConfig{}, sticks[(size_t)(p * 2 + 1)]);
+            }
+            snapshot = Bindings_Snapshot();
+        }
+
+        ~Rig() { Bindings_ClearAll(); }
+
+        void Step(Rng& rng)
+        {
+            for (int i = 0; i < 24; ++i) {
+                const uint32_t r = rng.Next();
+                const uint16_t hid = (uint16_t)(4 + r % 252);
+                depth[hid] = (float)((r >> 8) % 1001) / 1000.0f;
+                const uint64_t bit = 1ull << (hid % 64);
+                down[hid / 64] = depth[hid] > 0.4f ? (down[hid / 64] | bit) : (down[hid / 64] & ~bit);
+            }
+        }
+
+        // Layer 0 from the snapshot, layers on this tick's keys, then the reports
+        void Tick(int pads)
+        {
+            for (int p = 0; p < pads; ++p) {
+                Bindings_ReadPad(*snapshot, p, base[(size_t)p]);
+                const uint8_t active = BindingLayers_Update(layers[(size_t)p], layerState[(size_t)p], down);
+                BindingLayers_Apply(layers[(size_t)p], active, base[(size_t)p], tick[(size_t)p]);
+            }
+            TickJob job{ depth, down, tick.data(), axes.data(), socd.data(), sticks.data(), reports.data() };
+            PadWorkers_Run(pads, BuildReport, &job);
+        }
+    };
+}
+
+TEST(PadWorkers_EveryIndexOnce)
+{
+    for (int workers : { 0, 3 }) {
+        PadWorkers_Start(workers);
+        CHECK_EQ(PadWorkers_Count(), workers);
+        PadWorkersStats before;
+        PadWorkers_GetStats(&before);
+
+        for (int count : { 1, 7, 8, 16, 64 }) {
+            for (int run = 0; run < 200; ++run) {
+                CountJob job;
+                for (auto& h : job.hits) h.store(0, std::memory_order_relaxed);
+                PadWorkers_Run(count, CountIndex, &job);
+                for (int i = 0; i < 64; ++i)
+                    CHECK_EQ(job.hits[i].load(std::memory_order_relaxed), i < count ? 1 : 0);
+                if (Test::Failures()) { PadWorkers_Stop(); return; }
+            }
+        }
+
+        // Below PAD_WORKERS_MIN_ITEMS the caller runs the indices itself
+        PadWorkersStats after;
+        PadWorkers_GetStats(&after);
+        CHECK_EQ(after.runs - before.runs, 1000u);
+        CHECK_EQ(after.parallelRuns - before.parallelRuns, workers ? 600u : 0u);
+        PadWorkers_Stop();
+    }
+    CHECK_EQ(PadWorkers_Count(), 0);
+}
+
+TEST(PadWorkers_CountChangesBetweenRuns)
+{
+    // Short runs followed by longer ones: a worker still looking at the last
+    // claim of a finished run must not take an index of the next run
+    PadWorkers_Start(3);
+    Rng rng{ 11 };
+    CountJob jobs[2];
+    for (int run = 0; run < 50000; ++run) {
+        CountJob& job = jobs[run & 1];
+        for (auto& h : job.hits) h.store(0, std::memory_order_relaxed);
+        const int count = (run & 1) ? 8 + (int)(rng.Next() % 57) : 8;
+        const int per = (run % 3) ? 1 : 2;
+        PadWorkers_Run(count, per == 1 ? CountIndex : CountIndexTwice, &job);
+        for (int i = 0; i < 64; ++i)
+            CHECK_EQ(job.hits[i].load(std::memory_order_relaxed), i < count ? per : 0);
+        if (Test::Failures()) break;
+    }
+    PadWorkers_Stop();
+}
+
+TEST(Bindings_SnapshotKeepsItsPadsWhileTheBlockGrows)
+{
+    Bindings_ClearAll();
+    Bindings_SetPad(1, PadOf(1));
+    const BindingsSnapshot before = Bindings_Snapshot();
+    const uint32_t gen = Bindings_Generation();
+
+    Bindings_SetPad(12, PadOf(12));
+    CHECK(Bindings_Generation() != gen);
+    const BindingsSnapshot after = Bindings_Snapshot();
+
+    PadBindings pb;
+    Bindings_ReadPad(*before, 12, pb);
+    CHECK(Unbound(pb));
+    Bindings_ReadPad(*before, 1, pb);
+    CHECK(SameBindings(pb, PadOf(1)));
+    Bindings_ReadPad(*after, 12, pb);
+    CHECK(SameBindings(pb, PadOf(12)));
+    Bindings_ReadPad(*after, 1, pb);
+    CHECK(SameBindings(pb, PadOf(1)));
+
+    // Pads past the capacity and the limit read as unbound
+    Bindings_ReadPad(*after, 15, pb);
+    CHECK(Unbound(pb));
+    Bindings_ReadPad(*after, BINDINGS_MAX_GAMEPADS + 3, pb);
+    CHECK(Unbound(pb));
+    Bindings_ClearAll();
+}
+
+TEST(PadWorkers_ReportsMatchTheSerialTick)
+{
+    constexpr int kTicks = 2000;
+    std::vector<Report> expected;
+    {
+        Rig rig;
+        Rng rng{ 5 };
+        for (int t = 0; t < kTicks; ++t) {
+            rig.Step(rng);
+            rig.Tick(Rig::kPads);
+            expected.insert(expected.end(), rig.reports.begin(), rig.reports.end());
+        }
+    }
+
+    Rig rig;
+    Rng rng{ 5 };
+    PadWorkers_Start(3);
+    for (int t = 0; t < kTicks && !Test::Failures(); ++t) {
+        rig.Step(rng);
+        rig.Tick(Rig::kPads);
+        for (int p = 0; p < Rig::kPads; ++p)
+            CHECK(rig.reports[(size_t)p] == expected[(size_t)(t * Rig::kPads + p)]);
+    }
+    PadWorkers_Stop();
+}
+
+BENCH(Tick_CostVsPadCount)
+{
+    Rig rig;
+    for (int workers : { 0, 3 }) {
+        PadWorkers_Start(workers);
+        std::printf("  %d worker(s)\n", PadWorkers_Count());
+        for (int pads : { 1, 4, 8, 16 }) {
+            constexpr int kTicks = 100000;
+            Rng rng{ 9 };
+            for (int i = 0; i < 1000; ++i) { rig.Step(rng); rig.Tick(pads); }
+            const double t0 = Test::NowSec();
+            uint32_t sink = 0;
+            for (int i = 0; i < kTicks; ++i) {
+                rig.Step(rng);
+                rig.Tick(pads);
+                sink += rig.reports[(size_t)pads - 1].buttons;
+            }
+            const double us = (Test::NowSec() - t0) * 1e6 / kTicks;
+            std::printf("  %2d pad(s): %.2f us / tick, %.0f ns / pad (%u)\n", pads, us, us * 1000.0 / pads, sink);
+            CHECK(us < 100.0);
+        }
+        PadWorkers_Stop();
+    }
+}
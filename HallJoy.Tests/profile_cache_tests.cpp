@@ -0,0 +1,202 @@
+// profile_cache_tests.cpp
+// profile.cache on real files: miss then rebuild, hit, touched source
+// (hash hit), edited source, corrupt cache, runtime loads. Benchmark:
+// startup load of the INI set, cold parse vs cache hit.
+#include "test.h"
+
+#include "../HallJoy/ini_doc.h"
+#include "../HallJoy/ini_util.h"
+#include "../HallJoy/persist_service.h"
+#include "../HallJoy/profile_cache.h"
+
+#include <string>
+
+namespace
+{
+    const wchar_t* kCache = L"pc_test.cache";
+
+    std::wstring SourcePath(int i) { return L"pc_test_" + std::to_wstring(i) + L".ini"; }
+
+    // i == 0: settings.ini-sized (256 keys x 13 fields), others: small presets
+    bool WriteSource(int i, int salt = 0)
+    {
+        IniDoc doc;
+        doc.Parse(L"; source\r\n");
+        const int keys = (i == 0) ? 256 * 13 : 40;
+        for (int k = 0; k < keys; ++k)
+            doc.SetInt(i == 0 ? L"KeyDeadzone" : L"Layout", L"K" + std::to_wstring(k), k * 3 + salt);
+        const std::vector<uint8_t> bytes = doc.SerializeBytes();
+        return IniUtil_WriteFileAtomic(SourcePath(i).c_str(), bytes.data(), bytes.size());
+    }
+
+    // The document through the cache matches the file, parsed directly
+    bool LoadMatches(int i)
+    {
+        IniDoc viaCache, direct;
+        const bool ok = ProfileCache_LoadIni(SourcePath(i).c_str(), viaCache)
+            && IniUtil_LoadDoc(SourcePath(i).c_str(), direct);
+        return ok && viaCache.Serialize() == direct.Serialize();
+    }
+
+    ProfileCacheStats Stats()
+    {
+        ProfileCacheStats st;
+        ProfileCache_GetStats(&st);
+        return st;
+    }
+
+    // Close runs or queues the rebuild: the service (if running) writes it now
+    void CloseAndRebuild()
+    {
+        ProfileCache_Close();
+        Persist_Flush();
+    }
+
+    void RemoveFiles(int sources)
+    {
+        for (int i = 0; i < sources; ++i) DeleteFileW(SourcePath(i).c_str());
+        DeleteFileW(kCache);
+    }
+}
+
+TEST(Cache_MissRebuildHitAndStaleSources)
+{
+    constexpr int kSources = 3;
+    RemoveFiles(kSources);
+    for (int i = 0; i < kSources; ++i) CHECK(WriteSource(i));
+
+    // No cache: every load misses, Close builds it
+    ProfileCacheStats s0 = Stats();
+    CHECK(!ProfileCache_Open(kCache));
+    for (int i = 0; i < kSources; ++i) CHECK(LoadMatches(i));
+    CloseAndRebuild();
+    ProfileCacheStats s1 = Stats();
+    CHECK_EQ(s1.misses - s0.misses, 3u);
+    CHECK_EQ(s1.rebuilds - s0.rebuilds, 1u);
+
+    // Hit: same documents, nothing rebuilt
+    CHECK(ProfileCache_Open(kCache));
+    CHECK_EQ(Stats().sources, 3u);
+    for (int i = 0; i < kSources; ++i) CHECK(LoadMatches(i));
+    CloseAndRebuild();
+    ProfileCacheStats s2 = Stats();
+    CHECK_EQ(s2.hits - s1.hits, 3u);
+    CHECK_EQ(s2.misses, s1.misses);
+    CHECK_EQ(s2.rebuilds, s1.rebuilds);
+
+    // 1 rewritten with the same bytes (new time), 2 edited
+    Sleep(20);
+    CHECK(WriteSource(1));
+    CHECK(WriteSource(2, 1000));
+    CHECK(ProfileCache_Open(kCache));
+    for (int i = 0; i < kSources; ++i) CHECK(LoadMatches(i));
+    CloseAndRebuild();
+    ProfileCacheStats s3 = Stats();
+    CHECK_EQ(s3.hits - s2.hits, 1u);
+    CHECK_EQ(s3.hashHits - s2.hashHits, 1u);
+    CHECK_EQ(s3.misses - s2.misses, 1u);
+    CHECK_EQ(s3.rebuilds - s2.rebuilds, 1u);
+
+    // The rebuilt cache has the new times and content
+    CHECK(ProfileCache_Open(kCache));
+    for (int i = 0; i < kSources; ++i) CHECK(LoadMatches(i));
+    CloseAndRebuild();
+    ProfileCacheStats s4 = Stats();
+    CHECK_EQ(s4.hits - s3.hits, 3u);
+
+    // Loads after Close (profile switch) go to the file, no stats
+    CHECK(LoadMatches(0));
+    CHECK_EQ(Stats().hits, s4.hits);
+    CHECK_EQ(Stats().misses, s4.misses);
+    RemoveFiles(kSources);
+}
+
+TEST(Cache_CorruptCacheFallsBackToTheFiles)
+{
+    RemoveFiles(2);
+    CHECK(WriteSource(0));
+    CHECK(WriteSource(1));
+    ProfileCache_Open(kCache);
+    CHECK(LoadMatches(0) && LoadMatches(1));
+    CloseAndRebuild();
+
+    // Flip a byte of the entry table: the table checksum rejects the file
+    std::vector<uint8_t> bytes;
+    {
+        HANDLE h = CreateFileW(kCache, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        CHECK(h != INVALID_HANDLE_VALUE);
+        if (h == INVALID_HANDLE_VALUE) return;
+        LARGE_INTEGER size{};
+        GetFileSizeEx(h, &size);
+        bytes.resize((size_t)size.QuadPart);
+        DWORD got = 0;
+        ReadFile(h, bytes.data(), (DWORD)bytes.size(), &got, nullptr);
+        CloseHandle(h);
+    }
+    CHECK(bytes.size() > 40);
+    if (bytes.size() <= 40) return;
+    bytes[40] ^= 0x5A;
+    CHECK(IniUtil_WriteFileAtomic(kCache, bytes.data(), bytes.size()));
+
+    const ProfileCacheStats s0 = Stats();
+    CHECK(!ProfileCache_Open(kCache));
+    CHECK(LoadMatches(0) && LoadMatches(1));
+    CloseAndRebuild();
+    const ProfileCacheStats s1 = Stats();
+    CHECK_EQ(s1.misses - s0.misses, 2u);
+    CHECK_EQ(s1.rebuilds - s0.rebuilds, 1u);
+
+    // Truncated to less than a header
+    CHECK(IniUtil_WriteFileAtomic(kCache, bytes.data(), 8));
+    CHECK(!ProfileCache_Open(kCache));
+    CHECK(LoadMatches(0));
+    CloseAndRebuild();
+    CHECK(ProfileCache_Open(kCache));
+    ProfileCache_Close();
+    RemoveFiles(2);
+}
+
+BENCH(Cache_StartupColdVsHit)
+{
+    // settings.ini-sized file + 7 presets, as loaded at startup
+    constexpr int kSources = 8;
+    constexpr int kRounds = 50;
+    RemoveFiles(kSources);
+    for (int i = 0; i < kSources; ++i) CHECK(WriteSource(i));
+
+    size_t keys = 0;
+    double t0 = Test::NowSec();
+    for (int r = 0; r < kRounds; ++r)
+        for (int i = 0; i < kSources; ++i) {
+            IniDoc doc;
+            IniUtil_LoadDoc(SourcePath(i).c_str(), doc);
+            keys += doc.KeyCount();
+        }
+    const double coldMs = (Test::NowSec() - t0) * 1e3 / kRounds;
+
+    ProfileCache_Open(kCache);
+    for (int i = 0; i < kSources; ++i) { IniDoc doc; ProfileCache_LoadIni(SourcePath(i).c_str(), doc); }
+    CloseAndRebuild();
+
+    const ProfileCacheStats before = Stats();
+    t0 = Test::NowSec();
+    for (int r = 0; r < kRounds; ++r) {
+        ProfileCache_Open(kCache);
+        for (int i = 0; i < kSources; ++i) {
+            IniDoc doc;
+            ProfileCache_LoadIni(SourcePath(i).c_str(), doc);
+            keys += doc.KeyCount();
+        }
+        ProfileCache_Close();
+    }
+    const double hitMs = (Test::NowSec() - t0) * 1e3 / kRounds;
+    const ProfileCacheStats after = Stats();
+
+    std::printf("  %d files, %zu keys per startup\n", kSources, keys / (2 * kRounds));
+    std::printf("  cold read + parse: %.2f ms\n", coldMs);
+    std::printf("  cache hit: %.2f ms (open %.3f ms, loads %.3f ms)\n", hitMs,
+        (double)after.openUs / 1e3, (double)(after.loadUs - before.loadUs) / 1e3 / kRounds);
+    CHECK_EQ(after.hits - before.hits, (uint32_t)(kSources * kRounds));
+    CHECK(hitMs < coldMs);
+    RemoveFiles(kSources);
+}
@@ -0,0 +1,221 @@
+// socd_tests.cpp
+// Properties of every SOCD strategy over random walks of the two keys:
+// range, rest, single-key passthrough, conflict rules, mirror symmetry.
+// Benchmark: ns per axis and per strategy.
+#include "test.h"
+
+#include "../HallJoy/socd.h"
+
+#include <cmath>
+
+namespace
+{
+    constexpr SocdMode kModes[] = {
+        SocdMode::Sum, SocdMode::Neutral, SocdMode::LastWins, SocdMode::FirstWins,
+        SocdMode::PriorityMinus, SocdMode::PriorityPlus, SocdMode::AnalogMax,
+    };
+    constexpr const char* kNames[] = { "sum", "neutral", "last wins", "first wins", "priority -", "priority +", "analog max" };
+
+    SocdMode Mirror(SocdMode m)
+    {
+        if (m == SocdMode::PriorityMinus) return SocdMode::PriorityPlus;
+        if (m == SocdMode::PriorityPlus) return SocdMode::PriorityMinus;
+        return m;
+    }
+
+    struct Rng
+    {
+        uint32_t s;
+        uint32_t Next() { s = s * 1664525u + 1013904223u; return s >> 8; }
+        float Unit() { return (float)(Next() & 0xFFFF) / 65535.0f; }
+    };
+
+    // One key moves per step (no two edges on the same tick): released,
+    // fully pressed, or somewhere in between, like a real analog key.
+    struct Walk
+    {
+        float m = 0.0f, p = 0.0f;
+        void Step(Rng& rng)
+        {
+            float& v = (rng.Next() & 1) ? p : m;
+            const uint32_t r = rng.Next() % 8;
+            v = (r == 0) ? 0.0f : (r == 1) ? 1.0f : std::fabs(std::fmod(v + (rng.Unit() - 0.5f) * 0.6f, 1.0f));
+        }
+    };
+
+    constexpr float kPressed = SOCD_PRESS_V;
+}
+
+TEST(Socd_RangeAndRest)
+{
+    for (SocdMode mode : kModes) {
+        const SocdAxis ax = Socd_Compile(mode, false, false, 0.12f);
+        SocdAxisState st;
+        Rng rng{ 1 };
+        Walk w;
+        for (int i = 0; i < 20000; ++i) {
+            w.Step(rng);
+            const float v = Socd_Resolve(st, ax, w.m, w.p);
+            CHECK(v >= -1.0f && v <= 1.0f);
+        }
+        st = SocdAxisState{};
+        CHECK_EQ(Socd_Resolve(st, ax, 0.0f, 0.0f), 0.0f);
+        if (Test::Failures()) return;
+    }
+}
+
+TEST(Socd_SingleKeyPassesThrough)
+{
+    for (SocdMode mode : kModes) {
+        const SocdAxis ax = Socd_Compile(mode, false, false, 0.12f);
+        SocdAxisState st;
+        for (float v = 0.01f; v <= 1.0f; v += 0.01f) {
+            CHECK_EQ(Socd_Resolve(st, ax, 0.0f, v), v);
+        }
+        st = SocdAxisState{};
+        for (float v = 0.01f; v <= 1.0f; v += 0.01f) {
+            CHECK_EQ(Socd_Resolve(st, ax, v, 0.0f), -v);
+        }
+        if (Test::Failures()) return;
+    }
+}
+
+TEST(Socd_ConflictRules)
+{
+    // Every strategy against its rule, both keys held, random depths.
+    // LastWins at the top sensitivity: a held key can never be re-pressed
+    // (0.95 above a valley >= SOCD_PRESS_V), the last edge decides alone.
+    for (SocdMode mode : kModes) {
+        const SocdAxis ax = Socd_Compile(mode, false, false, mode == SocdMode::LastWins ? 0.95f : 0.12f);
+        SocdAxisState st;
+        Rng rng{ 7 };
+        Walk w;
+        int firstDir = 0, lastDir = 0;
+        float prevM = 0.0f, prevP = 0.0f;
+        for (int i = 0; i < 50000; ++i) {
+            w.Step(rng);
+            const bool md = w.m >= kPressed, pd = w.p >= kPressed;
+            const bool mEdge = md && prevM < kPressed, pEdge = pd && prevP < kPressed;
+            if (mEdge) lastDir = -1;
+            if (pEdge) lastDir = +1;
+            firstDir = (md && pd) ? firstDir : (md ? -1 : (pd ? +1 : 0));
+            prevM = w.m;
+            prevP = w.p;
+
+            const float v = Socd_Resolve(st, ax, w.m, w.p);
+            if (!(md && pd)) continue;
+            switch (mode) {
+            case SocdMode::Sum:           CHECK_EQ(v, w.p - w.m); break;
+            case SocdMode::Neutral:       CHECK_EQ(v, 0.0f); break;
+            case SocdMode::FirstWins:     CHECK_EQ(v, firstDir > 0 ? w.p : -w.m); break;
+            case SocdMode::PriorityMinus: CHECK_EQ(v, -w.m); break;
+            case SocdMode::PriorityPlus:  CHECK_EQ(v, w.p); break;
+            case SocdMode::AnalogMax:
+                if (std::fabs(w.p - w.m) > 0.01f) CHECK_EQ(v, w.p > w.m ? w.p : -w.m);
+                break;
+            case SocdMode::LastWins:
+                CHECK_EQ(v, lastDir > 0 ? w.p : -w.m);
+                break;
+            default: break;
+            }
+            if (Test::Failures()) return;
+        }
+    }
+}
+
+TEST(Socd_LastWinsReactivation)
+{
+    const SocdAxis ax = Socd_Compile(SocdMode::LastWins, false, false, 0.2f);
+    SocdAxisState st;
+    CHECK_EQ(Socd_Resolve(st, ax, 0.8f, 0.0f), -0.8f);
+    CHECK_EQ(Socd_Resolve(st, ax, 0.8f, 0.6f), 0.6f);     // plus pressed last
+    CHECK_EQ(Socd_Resolve(st, ax, 0.5f, 0.6f), 0.6f);     // minus eases off: valley 0.5
+    CHECK_EQ(Socd_Resolve(st, ax, 0.65f, 0.6f), 0.6f);    // +0.15 from the valley: not yet
+    CHECK_EQ(Socd_Resolve(st, ax, 0.75f, 0.6f), -0.75f);  // +0.25: pressed again, minus wins
+    CHECK_EQ(Socd_Resolve(st, ax, 0.75f, 0.0f), -0.75f);
+}
+
+TEST(Socd_MirrorSymmetry)
+{
+    // Swapping the keys negates the output (priority sides swap too)
+    for (SocdMode mode : kModes) {
+        const SocdAxis ax = Socd_Compile(mode, false, false, 0.12f);
+        const SocdAxis mx = Socd_Compile(Mirror(mode), false, false, 0.12f);
+        SocdAxisState a, b;
+        Rng rng{ 99 };
+        Walk w;
+        for (int i = 0; i < 50000; ++i) {
+            w.Step(rng);
+            CHECK_EQ(Socd_Resolve(a, ax, w.m, w.p), -Socd_Resolve(b, mx, w.p, w.m));
+            if (Test::Failures()) return;
+        }
+    }
+}
+
+TEST(Socd_GlobalFollowsTheLegacyToggles)
+{
+    struct Case { bool snap, lkp; SocdMode same; float snapV; };
+    const Case cases[] = {
+        { false, false, SocdMode::Sum, 0.0f },
+        { true,  false, SocdMode::AnalogMax, 0.0f },
+        { false, true,  SocdMode::LastWins, 0.0f },
+        { true,  true,  SocdMode::LastWins, 1.0f },
+    };
+    for (const Case& c : cases) {
+        const SocdAxis g = Socd_Compile(SocdMode::Global, c.snap, c.lkp, 0.3f);
+        SocdAxis ref = Socd_Compile(c.same, false, false, 0.3f);
+        ref.snap = c.snapV;
+        CHECK(g.fn == ref.fn);
+        CHECK_EQ(g.snap, ref.snap);
+        CHECK_EQ(g.reactivate, 0.3f);
+    }
+    CHECK_EQ(Socd_Compile(SocdMode::Sum, false, false, 5.0f).reactivate, 0.95f);
+    CHECK(Socd_Compile(SocdMode::Count, false, false, 0.1f).fn == Socd_Compile(SocdMode::Sum, false, false, 0.1f).fn);
+}
+
+TEST(Socd_ModesPerPadAndAxis)
+{
+    Socd_ResetModes();
+    const uint32_t gen = Socd_ConfigGeneration();
+    Socd_SetMode(3, 2, SocdMode::Neutral);
+    CHECK(Socd_ConfigGeneration() != gen);
+    CHECK(Socd_GetMode(3, 2) == SocdMode::Neutral);
+    CHECK(Socd_GetMode(3, 1) == SocdMode::Global);
+    CHECK(Socd_GetMode(2, 2) == SocdMode::Global);
+
+    Socd_SetMode(SOCD_MAX_PADS, 0, SocdMode::Neutral);   // ignored
+    Socd_SetMode(0, 0, SocdMode::Count);                 // back to Global
+    CHECK(Socd_GetMode(0, 0) == SocdMode::Global);
+    CHECK(Socd_GetMode(-1, 0) == SocdMode::Global);
+    Socd_ResetModes();
+    CHECK(Socd_GetMode(3, 2) == SocdMode::Global);
+}
+
+BENCH(Socd_PerStrategy)
+{
+    // Random walks prepared up front: the loop only resolves
+    constexpr int kSteps = 1 << 16;
+    constexpr int kRounds = 40;
+    std::vector<float> ms(kSteps), ps(kSteps);
+    Rng rng{ 5 };
+    Walk w;
+    for (int i = 0; i < kSteps; ++i) {
+        w.Step(rng);
+        ms[i] = w.m;
+        ps[i] = w.p;
+    }
+
+    for (size_t k = 0; k < sizeof(kModes) / sizeof(kModes[0]); ++k) {
+        const SocdAxis ax = Socd_Compile(kModes[k], false, false, 0.12f);
+        SocdAxisState st[SOCD_AXES];
+        float sink = 0.0f;
+        const double t0 = Test::NowSec();
+        for (int r = 0; r < kRounds; ++r)
+            for (int i = 0; i < kSteps; ++i)
+                sink += Socd_Resolve(st[i & (SOCD_AXES - 1)], ax, ms[i], ps[i]);
+        const double sec = Test::NowSec() - t0;
+        const double ns = sec * 1e9 / ((double)kSteps * kRounds);
+        std::printf("  %-11s %5.1f ns / axis  (%g)\n", kNames[k], ns, sink);
+        CHECK(ns < 500.0);
+    }
+}
@@ -0,0 +1,193 @@
+// stick_shape_tests.cpp
+// Headless accuracy of the 2D stick shaping tables against the analytic
+// shape: identity, square to circle, deadzones / anti-deadzone / curve,
+// angular snapping. Benchmark: ns per stick.
+#include "test.h"
+
+#include "../HallJoy/stick_shape.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr double kPi = 3.14159265358979323846;
+
+    double Deg(double x, double y) { return std::atan2(y, x) * 180.0 / kPi; }
+
+    // Smallest difference between two angles, degrees
+    double AngleDiff(double a, double b)
+    {
+        double d = std::fmod(std::fabs(a - b), 360.0);
+        return std::min(d, 360.0 - d);
+    }
+
+    StickShapeTables Compile(const StickShapeConfig& cfg)
+    {
+        StickShapeTables t;
+        StickShape_Compile(cfg, t);
+        return t;
+    }
+}
+
+TEST(Shape_DefaultIsBitExactIdentity)
+{
+    const StickShapeTables t = Compile(StickShapeConfig{});
+    CHECK(t.identity);
+    for (float x = -1.0f; x <= 1.0f; x += 0.0371f)
+        for (float y = -1.0f; y <= 1.0f; y += 0.0419f) {
+            float ox = x, oy = y;
+            StickShape_Apply(t, ox, oy);
+            CHECK(ox == x && oy == y);
+        }
+}
+
+TEST(Shape_SquareToCircle)
+{
+    // Every point of the square lands at its Chebyshev radius, same direction:
+    // the corners end on the unit circle.
+    StickShapeConfig cfg;
+    cfg.circle = true;
+    const StickShapeTables t = Compile(cfg);
+    double maxR = 0.0, maxDir = 0.0, maxLen = 0.0;
+    for (int i = -200; i <= 200; ++i)
+        for (int j = -200; j <= 200; ++j) {
+            const float x = i / 200.0f, y = j / 200.0f;
+            if (i == 0 && j == 0) continue;
+            float ox = x, oy = y;
+            StickShape_Apply(t, ox, oy);
+            const double cheb = std::max(std::fabs(x), std::fabs(y));
+            const double len = std::hypot((double)ox, (double)oy);
+            maxR = std::max(maxR, std::fabs(len - cheb));
+            maxDir = std::max(maxDir, std::fabs(std::atan2((double)x * oy - (double)y * ox, (double)x * ox + (double)y * oy)));
+            maxLen = std::max(maxLen, len);
+        }
+    std::printf("  radius error %.2g, direction error %.2g rad\n", maxR, maxDir);
+    CHECK(maxR < 1e-5);
+    CHECK(maxDir < 1e-5);
+    CHECK(maxLen <= 1.0 + 1e-5);
+}
+
+TEST(Shape_RadialMatchesTheAnalyticCurve)
+{
+    StickShapeConfig cfg;
+    cfg.innerM = 150;
+    cfg.outerM = 900;
+    cfg.antiDzM = 200;
+    cfg.gammaM = 2000;
+    const StickShapeTables t = Compile(cfg);
+
+    double maxErr = 0.0;
+    for (int a = 0; a < 72; ++a) {
+        const double th = a * 5.0 * kPi / 180.0 + 0.01;
+        for (int i = 1; i <= 1000; ++i) {
+            const double r = i / 1000.0;
+            float x = (float)(r * std::cos(th)), y = (float)(r * std::sin(th));
+            StickShape_Apply(t, x, y);
+            const double u = std::clamp((r - 0.15) / (0.9 - 0.15), 0.0, 1.0);
+            const double want = (r <= 0.15) ? 0.0 : 0.2 + 0.8 * u * u;
+            if (std::fabs(r - 0.15) < 2e-3) continue;   // the step itself
+            maxErr = std::max(maxErr, std::fabs(std::hypot((double)x, (double)y) - want));
+            if (want > 0.0) CHECK(AngleDiff(Deg(x, y), th * 180.0 / kPi) < 1e-3);
+        }
+    }
+    std::printf("  max radius error %.2g (%.1f LSB of 32767)\n", maxErr, maxErr * 32767.0);
+    CHECK(maxErr < 1e-3);
+}
+
+TEST(Shape_SnapInsideTheWindowsOnly)
+{
+    for (StickSnap snap : { StickSnap::Four, StickSnap::Eight }) {
+        StickShapeConfig cfg;
+        cfg.snap = snap;
+        cfg.snapDeg = 10;
+        const StickShapeTables t = Compile(cfg);
+        const double dirDeg = (snap == StickSnap::Four) ? 90.0 : 45.0;
+
+        for (double deg = 0.0; deg < 360.0; deg += 0.25) {
+            const double k = std::round(deg / dirDeg);
+            const double off = std::fabs(deg - k * dirDeg);
+            if (std::fabs(off - 10.0) < 1.0) continue;   // bucket edge
+            float x = (float)(0.8 * std::cos(deg * kPi / 180.0)), y = (float)(0.8 * std::sin(deg * kPi / 180.0));
+            StickShape_Apply(t, x, y);
+            const double got = Deg(x, y);
+            CHECK(std::fabs(std::hypot((double)x, (double)y) - 0.8) < 1e-4);
+            CHECK(AngleDiff(got, off < 10.0 ? k * dirDeg : deg) < 1e-3);
+            if (Test::Failures()) return;
+        }
+    }
+}
+
+TEST(Shape_SanitizeAndConfigSlots)
+{
+    StickShapeConfig bad;
+    bad.innerM = 2000;
+    bad.outerM = 10;
+    bad.gammaM = 9;
+    bad.snap = StickSnap::Eight;
+    bad.snapDeg = 200;
+    const StickShapeConfig c = StickShape_Sanitize(bad);
+    CHECK_EQ(c.innerM, 900);
+    CHECK(c.outerM >= c.innerM + 50 && c.outerM <= 1000);
+    CHECK_EQ(c.gammaM, 250);
+    CHECK_EQ(c.snapDeg, 22);
+
+    StickShapeConfig cfg;
+    cfg.circle = true;
+    cfg.innerM = 123;
+    cfg.outerM = 876;
+    cfg.antiDzM = 45;
+    cfg.gammaM = 3210;
+    cfg.snap = StickSnap::Four;
+    cfg.snapDeg = 33;
+    const uint32_t gen = StickShape_ConfigGeneration();
+    StickShape_Set(STICK_SHAPE_MAX_PADS - 1, 1, cfg);
+    CHECK(StickShape_ConfigGeneration() != gen);
+    const StickShapeConfig back = StickShape_Get(STICK_SHAPE_MAX_PADS - 1, 1);
+    CHECK(back.circle && back.innerM == 123 && back.outerM == 876 && back.antiDzM == 45);
+    CHECK(back.gammaM == 3210 && back.snap == StickSnap::Four && back.snapDeg == 33);
+    CHECK(StickShape_Get(0, 0).IsIdentity());
+    CHECK(StickShape_Get(STICK_SHAPE_MAX_PADS, 0).IsIdentity());
+    StickShape_ResetAll();
+    CHECK(StickShape_Get(STICK_SHAPE_MAX_PADS - 1, 1).IsIdentity());
+}
+
+BENCH(Shape_PerStick)
+{
+    StickShapeConfig cfg;
+    cfg.circle = true;
+    cfg.innerM = 100;
+    cfg.antiDzM = 150;
+    cfg.gammaM = 1500;
+    cfg.snap = StickSnap::Eight;
+    StickShapeTables t;
+    StickShape_Compile(cfg, t);
+
+    constexpr int kPoints = 4096;
+    constexpr int kRounds = 500;
+    std::vector<float> xs(kPoints), ys(kPoints);
+    uint32_t s = 3;
+    for (int i = 0; i < kPoints; ++i) {
+        s = s * 1664525u + 1013904223u;
+        xs[i] = (float)(s >> 16) / 32768.0f - 1.0f;
+        s = s * 1664525u + 1013904223u;
+        ys[i] = (float)(s >> 16) / 32768.0f - 1.0f;
+    }
+
+    float sum = 0.0f;
+    const double t0 = Test::NowSec();
+    for (int r = 0; r < kRounds; ++r)
+        for (int i = 0; i < kPoints; ++i) {
+            float x = xs[i], y = ys[i];
+            StickShape_Apply(t, x, y);
+            sum += x + y;
+        }
+    const double ns = (Test::NowSec() - t0) * 1e9 / ((double)kPoints * kRounds);
+
+    const double c0 = Test::NowSec();
+    for (int r = 0; r < 200; ++r) StickShape_Compile(cfg, t);
+    const double compileUs = (Test::NowSec() - c0) * 1e6 / 200.0;
+
+    std::printf("  %.1f ns / stick (%g), compile %.1f us\n", ns, sum, compileUs);
+    CHECK(ns < 500.0);
+}
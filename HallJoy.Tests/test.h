@@ -0,0 +1,71 @@
+// test.h
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// ============================================================
+// TESTS
+// Minimal self-registering tests and benchmarks for the portable modules
+// (no framework: the console runner is test_main.cpp).
+// - TEST(name) { ... CHECK(cond); CHECK_EQ(a, b); }
+//   A failed check is reported and the test goes on; the run fails.
+// - BENCH(name) { ... }  run only with --bench, prints its own figures.
+//   A bench may CHECK a budget (throughput floor, latency ceiling): they
+//   are generous, the point is to catch an order-of-magnitude regression.
+// Portable (no Win32).
+// ============================================================
+
+namespace Test
+{
+    using Fn = void (*)();
+
+    struct Case
+    {
+        const char* name;
+        Fn          fn;
+        bool        bench;
+    };
+
+    std::vector<Case>& Registry();
+    void Fail(const char* file, int line, const char* expr);
+    // Failed checks so far (a test reads it to stop early if needed)
+    int Failures();
+
+    // Whole-file write / read with std::FILE, relative to the working
+    // directory: file round trips in portable tests and benchmarks.
+    bool SaveFile(const char* path, const void* data, size_t size);
+    bool LoadFile(const char* path, std::vector<uint8_t>& out);
+
+    struct Registrar
+    {
+        Registrar(const char* name, Fn fn, bool bench) { Registry().push_back({ name, fn, bench }); }
+    };
+
+    inline double NowSec()
+    {
+        using namespace std::chrono;
+        return duration<double>(steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+#define TEST_CAT2(a, b) a##b
+#define TEST_CAT(a, b) TEST_CAT2(a, b)
+
+#define TEST(name)                                                              \
+    static void TEST_CAT(test_, name)();                                        \
+    static Test::Registrar TEST_CAT(reg_, name)(#name, &TEST_CAT(test_, name), false); \
+    static void TEST_CAT(test_, name)()
+
+#define BENCH(name)                                                             \
+    static void TEST_CAT(bench_, name)();                                       \
+    static Test::Registrar TEST_CAT(regb_, name)(#name, &TEST_CAT(bench_, name), true); \
+    static void TEST_CAT(bench_, name)()
+
+#define CHECK(cond) \
+    do { if (!(cond)) Test::Fail(__FILE__, __LINE__, #cond); } while (0)
+
+#define CHECK_EQ(a, b) \
+    do { if (!((a) == (b))) Test::Fail(__FILE__, __LINE__, #a " == " #b); } while (0)
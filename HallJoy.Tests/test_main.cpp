@@ -0,0 +1,75 @@
+// test_main.cpp
+#include "test.h"
+
+#include <cstring>
+
+namespace
+{
+    int g_failures = 0;
+}
+
+std::vector<Test::Case>& Test::Registry()
+{
+    static std::vector<Case> cases;
+    return cases;
+}
+
+void Test::Fail(const char* file, int line, const char* expr)
+{
+    ++g_failures;
+    std::printf("  FAILED %s(%d): %s\n", file, line, expr);
+}
+
+int Test::Failures()
+{
+    return g_failures;
+}
+
+bool Test::SaveFile(const char* path, const void* data, size_t size)
+{
+    std::FILE* f = std::fopen(path, "wb");
+    if (!f) return false;
+    const bool ok = std::fwrite(data, 1, size, f) == size;
+    return (std::fclose(f) == 0) && ok;
+}
+
+bool Test::LoadFile(const char* path, std::vector<uint8_t>& out)
+{
+    out.clear();
+    std::FILE* f = std::fopen(path, "rb");
+    if (!f) return false;
+    uint8_t buf[64 * 1024];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+    const bool ok = !std::ferror(f);
+    std::fclose(f);
+    return ok;
+}
+
+// HallJoy.Tests.exe [--bench] [filter]
+// Runs every test (or every benchmark) whose name contains `filter`.
+int main(int argc, char** argv)
+{
+    bool bench = false;
+    const char* filter = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--bench") == 0) bench = true;
+        else filter = argv[i];
+    }
+
+    int run = 0, failed = 0;
+    for (const Test::Case& c : Test::Registry()) {
+        if (c.bench != bench) continue;
+        if (filter && !std::strstr(c.name, filter)) continue;
+        const int before = g_failures;
+        std::printf("[ RUN  ] %s\n", c.name);
+        std::fflush(stdout);
+        c.fn();
+        ++run;
+        if (g_failures != before) { ++failed; std::printf("[ FAIL ] %s\n", c.name); }
+        else std::printf("[  OK  ] %s\n", c.name);
+        std::fflush(stdout);
+    }
+    std::printf("%d %s, %d failed\n", run, bench ? "benchmarks" : "tests", failed);
+    return failed ? 1 : 0;
+}
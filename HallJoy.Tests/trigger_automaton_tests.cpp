@@ -0,0 +1,244 @@
+// trigger_automaton_tests.cpp
+// TriggerAutomaton: sequences, gaps, chords, held steps, and a brute-force
+// comparison on random pattern sets. Benchmark: 5,000 sequence triggers.
+#include "test.h"
+
+#include "../HallJoy/trigger_automaton.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Deterministic, same stream on every run and platform
+    struct Lcg
+    {
+        uint64_t s;
+        explicit Lcg(uint64_t seed) : s(seed) {}
+        uint32_t Next() { s = s * 6364136223846793005ull + 1442695040888963407ull; return (uint32_t)(s >> 33); }
+        uint32_t Below(uint32_t n) { return Next() % n; }
+    };
+
+    struct Held
+    {
+        bool down[TRIGGER_SYM_COUNT]{};
+        static bool Fn(void* user, TriggerSymbol sym) { return static_cast<Held*>(user)->down[sym]; }
+    };
+
+    TriggerPattern Seq(uint32_t id, std::initializer_list<TriggerSymbol> keys, uint32_t gapMs = 500)
+    {
+        TriggerPattern p;
+        p.id = id;
+        p.maxGapMs = gapMs;
+        for (TriggerSymbol k : keys) p.steps[p.stepCount++].key = k;
+        return p;
+    }
+
+    std::vector<uint32_t> Press(TriggerAutomaton& a, TriggerSymbol sym, uint32_t ms, Held* held = nullptr)
+    {
+        std::vector<uint32_t> out;
+        a.Press(sym, ms, held ? &Held::Fn : nullptr, held, &out);
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+
+    using Ids = std::vector<uint32_t>;
+
+    struct Stroke
+    {
+        TriggerSymbol sym;
+        uint32_t      ms;
+    };
+
+    // Reference: a pattern fires when the last presses are its steps, gaps within its limit
+    Ids Reference(const std::vector<TriggerPattern>& pats, const std::vector<Stroke>& hist)
+    {
+        Ids out;
+        for (const TriggerPattern& p : pats) {
+            if (hist.size() < p.stepCount) continue;
+            const size_t base = hist.size() - p.stepCount;
+            bool ok = true;
+            for (size_t i = 0; i < p.stepCount && ok; ++i) {
+                if (hist[base + i].sym != p.steps[i].key) ok = false;
+                else if (i > 0 && hist[base + i].ms - hist[base + i - 1].ms > p.maxGapMs) ok = false;
+            }
+            if (ok) out.push_back(p.id);
+        }
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+}
+
+TEST(Automaton_SequenceAndOverlap)
+{
+    TriggerAutomaton a;
+    CHECK(a.Add(Seq(1, { 'A', 'B', 'C' })));
+    CHECK(a.Add(Seq(2, { 'B', 'C' })));
+    CHECK(a.Add(Seq(3, { 'C' })));
+    a.Build();
+
+    CHECK(Press(a, 'A', 0).empty());
+    CHECK(Press(a, 'B', 100).empty());
+    CHECK_EQ(Press(a, 'C', 200), (Ids{ 1, 2, 3 }));
+    // A repeated prefix falls back on the failure link
+    CHECK(Press(a, 'A', 300).empty());
+    CHECK(Press(a, 'A', 400).empty());
+    CHECK(Press(a, 'B', 500).empty());
+    CHECK_EQ(Press(a, 'C', 600), (Ids{ 1, 2, 3 }));
+}
+
+TEST(Automaton_GapAndUnrelatedKeyBreakSequence)
+{
+    TriggerAutomaton a;
+    a.Add(Seq(1, { 'A', 'B' }, 200));
+    a.Build();
+
+    Press(a, 'A', 0);
+    CHECK(Press(a, 'B', 201).empty());       // too late
+    Press(a, 'A', 1000);
+    Press(a, 'X', 1050);                      // used by no trigger
+    CHECK(Press(a, 'B', 1100).empty());
+    Press(a, 'A', 2000);
+    CHECK_EQ(Press(a, 'B', 2200), (Ids{ 1 }));
+
+    // GetTickCount wrap between the two presses
+    Press(a, 'A', 0xFFFFFFF0u);
+    CHECK_EQ(Press(a, 'B', 0x40), (Ids{ 1 }));
+}
+
+TEST(Automaton_DoubleAndTripleTap)
+{
+    TriggerAutomaton a;
+    a.Add(Seq(2, { TRIGGER_SYM_MOUSE_LEFT, TRIGGER_SYM_MOUSE_LEFT }, 300));
+    a.Add(Seq(3, { TRIGGER_SYM_MOUSE_LEFT, TRIGGER_SYM_MOUSE_LEFT, TRIGGER_SYM_MOUSE_LEFT }, 300));
+    a.Build();
+
+    CHECK(Press(a, TRIGGER_SYM_MOUSE_LEFT, 0).empty());
+    CHECK_EQ(Press(a, TRIGGER_SYM_MOUSE_LEFT, 150), (Ids{ 2 }));
+    CHECK_EQ(Press(a, TRIGGER_SYM_MOUSE_LEFT, 300), (Ids{ 2, 3 }));
+    CHECK(Press(a, TRIGGER_SYM_MOUSE_LEFT, 1000).empty());
+}
+
+TEST(Automaton_ChordAnyOrderAndHeldStep)
+{
+    TriggerAutomaton a;
+    const TriggerSymbol chord[3] = { 'Q', 'W', 'E' };
+    CHECK(a.AddChord(7, chord, 3));
+    TriggerPattern p = Seq(8, { TRIGGER_SYM_MOUSE_LEFT });
+    p.steps[0].with[p.steps[0].withCount++] = TRIGGER_SYM_MOUSE_RIGHT;
+    CHECK(a.Add(p));
+    a.Build();
+
+    Held h;
+    h.down['E'] = h.down['Q'] = true;
+    CHECK_EQ(Press(a, 'W', 0, &h), (Ids{ 7 }));
+    h.down['Q'] = false;
+    CHECK(Press(a, 'W', 10, &h).empty());
+
+    CHECK(Press(a, TRIGGER_SYM_MOUSE_LEFT, 20, &h).empty());
+    h.down[TRIGGER_SYM_MOUSE_RIGHT] = true;
+    CHECK_EQ(Press(a, TRIGGER_SYM_MOUSE_LEFT, 30, &h), (Ids{ 8 }));
+}
+
+TEST(Automaton_FirstPatternKeepsItsHeldKeys)
+{
+    // Modifier on the very first pattern of a fresh automaton (Ctrl + F)
+    TriggerAutomaton a;
+    TriggerPattern p = Seq(1, { 'F' });
+    p.steps[0].with[p.steps[0].withCount++] = TRIGGER_SYM_CTRL;
+    CHECK(a.Add(p));
+    a.Build();
+
+    Held h;
+    CHECK(Press(a, 'F', 0, &h).empty());
+    h.down[TRIGGER_SYM_CTRL] = true;
+    CHECK_EQ(Press(a, 'F', 10, &h), (Ids{ 1 }));
+}
+
+TEST(Automaton_RejectsBadPatterns)
+{
+    TriggerAutomaton a;
+    TriggerPattern empty;
+    CHECK(!a.Add(empty));
+    TriggerPattern bad = Seq(1, { 'A' });
+    bad.steps[0].key = TRIGGER_SYM_COUNT;
+    CHECK(!a.Add(bad));
+    a.Build();
+    CHECK_EQ(Press(a, 'A', 0).size(), 0u);
+}
+
+TEST(Automaton_MatchesBruteForceOnRandomSets)
+{
+    Lcg rng(12345);
+    for (int round = 0; round < 40; ++round) {
+        const uint32_t alphabet = 2 + rng.Below(5);   // small: many overlaps
+        std::vector<TriggerPattern> pats;
+        TriggerAutomaton a;
+        const int n = 1 + (int)rng.Below(30);
+        for (int i = 0; i < n; ++i) {
+            TriggerPattern p;
+            p.id = (uint32_t)i;
+            p.maxGapMs = 50 + rng.Below(400);
+            p.stepCount = (uint8_t)(1 + rng.Below(5));
+            for (int s = 0; s < p.stepCount; ++s) p.steps[s].key = (TriggerSymbol)('A' + rng.Below(alphabet));
+            pats.push_back(p);
+            CHECK(a.Add(p));
+        }
+        a.Build();
+
+        std::vector<Stroke> hist;
+        uint32_t ms = 0;
+        for (int k = 0; k < 2000; ++k) {
+            ms += rng.Below(500);
+            const TriggerSymbol sym = (TriggerSymbol)('A' + rng.Below(alphabet + 1)); // +1: unused key
+            hist.push_back({ sym, ms });
+            const Ids got = Press(a, sym, ms);
+            const Ids want = Reference(pats, hist);
+            CHECK(got == want);
+            if (got != want) return;
+        }
+    }
+}
+
+BENCH(Automaton_5000SequenceTriggers)
+{
+    // 5,000 sequences of 2..5 steps over 24 keys
+    Lcg rng(2024);
+    TriggerAutomaton a;
+    const double t0 = Test::NowSec();
+    for (uint32_t i = 0; i < 5000; ++i) {
+        TriggerPattern p;
+        p.id = i;
+        p.maxGapMs = 400;
+        p.stepCount = (uint8_t)(2 + rng.Below(4));
+        for (int s = 0; s < p.stepCount; ++s) p.steps[s].key = (TriggerSymbol)('A' + rng.Below(24));
+        a.Add(p);
+    }
+    a.Build();
+    const double buildMs = (Test::NowSec() - t0) * 1000.0;
+
+    // Typing-like stream: 2M presses, 30..230 ms apart, a few unbound keys
+    constexpr int kPresses = 2000000;
+    std::vector<Stroke> stream(kPresses);
+    uint32_t ms = 0;
+    for (Stroke& p : stream) {
+        ms += 30 + rng.Below(200);
+        p.sym = (TriggerSymbol)('A' + rng.Below(26));
+        p.ms = ms;
+    }
+
+    std::vector<uint32_t> out;
+    out.reserve(1024);
+    uint64_t matches = 0;
+    const double t1 = Test::NowSec();
+    for (const Stroke& p : stream) {
+        out.clear();
+        matches += (uint64_t)a.Press(p.sym, p.ms, nullptr, nullptr, &out);
+    }
+    const double sec = Test::NowSec() - t1;
+    const double nsPerPress = sec * 1e9 / kPresses;
+
+    std::printf("  %zu patterns, %zu states, build %.1f ms\n", a.PatternCount(), a.StateCount(), buildMs);
+    std::printf("  %d presses: %.0f ns / press, %llu matches\n", kPresses, nsPerPress, (unsigned long long)matches);
+    CHECK(matches > 0);
+    CHECK(nsPerPress < 5000.0);
+}
@@ -0,0 +1,188 @@
+// actuation.cpp
+#include "actuation.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    // One array per field: the update loop runs over plain uint8 / uint16
+    // columns the compiler can vectorize.
+    struct ConfigTable
+    {
+        uint16_t pressM[256];
+        uint16_t releaseM[256];   // resolved: never 0, never above pressM
+        uint16_t rtDownM[256];
+        uint16_t rtUpM[256];
+        uint8_t  rapid[256];      // 0 / 1
+        uint8_t  continuous[256]; // 0 / 1
+    };
+
+    std::array<KeyActuation, 256> g_config{};   // under g_writeMutex
+    std::mutex                    g_writeMutex;
+
+    // Double buffer: the writer fills the inactive table, then flips g_active.
+    ConfigTable           g_tables[2];
+    std::atomic<int>      g_active{ 0 };
+    // Odd while the realtime thread reads a table (seqlock-like epoch).
+    std::atomic<uint32_t> g_rtEpoch{ 0 };
+
+    // ---- Realtime thread state ----
+    uint16_t g_depth[256];
+    uint8_t  g_down[256];
+    uint8_t  g_armed[256];    // rapid trigger: inside the zone since the first actuation
+    uint16_t g_extreme[256];  // lowest point while up, highest point while down
+    uint16_t g_presses[256];
+    uint64_t g_downMask[4];
+
+    std::array<std::atomic<uint64_t>, 4> g_downPublished{};
+
+    void FillTable(ConfigTable& t)
+    {
+        for (int hid = 0; hid < 256; ++hid) {
+            const KeyActuation& c = g_config[(size_t)hid];
+            const uint16_t press = std::clamp<uint16_t>(c.pressM, 1, 1000);
+            t.pressM[hid] = press;
+            t.releaseM[hid] = c.releaseM ? std::clamp<uint16_t>(c.releaseM, 1, press) : press;
+            t.rtDownM[hid] = std::clamp<uint16_t>(c.rtDownM, 1, 1000);
+            t.rtUpM[hid] = std::clamp<uint16_t>(c.rtUpM, 1, 1000);
+            t.rapid[hid] = (c.mode != ActuationMode::Fixed) ? 1 : 0;
+            t.continuous[hid] = (c.mode == ActuationMode::RapidContinuous) ? 1 : 0;
+        }
+    }
+
+    // Caller holds g_writeMutex.
+    void PublishUnlocked()
+    {
+        const int next = 1 - g_active.load(std::memory_order_seq_cst);
+
+        // An update that started before the previous flip may still read `next`:
+        // wait for it to end (one tick at most). A later one only sees the active table.
+        const uint32_t epoch = g_rtEpoch.load(std::memory_order_seq_cst);
+        if (epoch & 1u)
+            while (g_rtEpoch.load(std::memory_order_seq_cst) == epoch)
+                std::this_thread::yield();
+
+        FillTable(g_tables[next]);
+        g_active.store(next, std::memory_order_seq_cst);
+    }
+
+    struct DefaultTables
+    {
+        DefaultTables() { FillTable(g_tables[0]); FillTable(g_tables[1]); }
+    } g_defaultTables;
+}
+
+void Actuation_Set(uint16_t hid, const KeyActuation& cfg)
+{
+    if (hid == 0 || hid >= 256) return;
+    std::lock_guard<std::mutex> lk(g_writeMutex);
+    g_config[hid] = cfg;
+    PublishUnlocked();
+}
+
+KeyActuation Actuation_Get(uint16_t hid)
+{
+    if (hid == 0 || hid >= 256) return KeyActuation{};
+    std::lock_guard<std::mutex> lk(g_writeMutex);
+    return g_config[hid];
+}
+
+void Actuation_ClearAll()
+{
+    std::lock_guard<std::mutex> lk(g_writeMutex);
+    g_config.fill(KeyActuation{});
+    PublishUnlocked();
+}
+
+void Actuation_Enumerate(std::vector<std::pair<uint16_t, KeyActuation>>& out)
+{
+    out.clear();
+    std::lock_guard<std::mutex> lk(g_writeMutex);
+    for (uint16_t hid = 1; hid < 256; ++hid)
+        if (!g_config[hid].IsDefault()) out.emplace_back(hid, g_config[hid]);
+}
+
+int Actuation_Update(const uint64_t keys[4], ActuationReadFn read, void* user)
+{
+    // Odd from here to the end: a writer never refills a table while an update
+    // runs, the depth reads included (so a test can hold an update open in its
+    // read callback).
+    g_rtEpoch.fetch_add(1, std::memory_order_seq_cst);
+    const ConfigTable& t = g_tables[g_active.load(std::memory_order_seq_cst)];
+
+    // Gather: only the keys somebody listens to are read
+    std::fill(std::begin(g_depth), std::end(g_depth), (uint16_t)0);
+    for (int chunk = 0; keys && read && chunk < 4; ++chunk) {
+        for (uint64_t bits = keys[chunk]; bits; bits &= bits - 1) {
+            const uint16_t hid = (uint16_t)(chunk * 64 + std::countr_zero(bits));
+            if (hid) g_depth[hid] = std::min<uint16_t>(read(user, hid), 1000);
+        }
+    }
+
+    // Every key, every tick, same instructions: every column is loaded up
+    // front and conditions are 0 / 1 ints combined with & | ^ (no
+    // short-circuit), so the loop has no branch and the compiler vectorizes it.
+    int presses = 0;
+    for (int i = 0; i < 256; ++i) {
+        const int v = g_depth[i];
+        const int e = g_extreme[i];
+        const int down = g_down[i];
+        const int armed = g_armed[i];
+        const int rapid = t.rapid[i];
+        const int press = t.pressM[i];
+        const int release = t.releaseM[i];
+        const int rtDown = t.rtDownM[i];
+        const int rtUp = t.rtUpM[i];
+        const int zoneTop = t.continuous[i] ? (int)ACTUATION_TOP_M + 1 : release;
+
+        const int fixedDown = v >= (down ? release : press);
+
+        const int peak = std::max(e, v);
+        const int valley = std::min(e, v);
+        const int outOfZone = v < zoneTop;
+        const int rtRelease = outOfZone | (v + rtUp <= peak);
+        const int rtPress = (outOfZone ^ 1) & (v >= (armed ? valley + rtDown : press));
+        const int rapidDown = (down & (rtRelease ^ 1)) | ((down ^ 1) & rtPress);
+
+        const int nowDown = (rapid & rapidDown) | ((rapid ^ 1) & fixedDown);
+        const int pressed = nowDown & (down ^ 1);
+
+        g_armed[i] = (uint8_t)(rapid & (outOfZone ^ 1) & (armed | nowDown));
+        g_extreme[i] = (uint16_t)((nowDown != down) ? v : (nowDown ? peak : valley));
+        g_presses[i] = (uint16_t)(g_presses[i] + pressed);
+        g_down[i] = (uint8_t)nowDown;
+        presses += pressed;
+    }
+
+    g_rtEpoch.fetch_add(1, std::memory_order_seq_cst); // even: done
+
+    for (int chunk = 0; chunk < 4; ++chunk) {
+        uint64_t m = 0;
+        for (int bit = 0; bit < 64; ++bit)
+            m |= (uint64_t)g_down[chunk * 64 + bit] << bit;
+        g_downMask[chunk] = m;
+        g_downPublished[(size_t)chunk].store(m, std::memory_order_relaxed);
+    }
+    return presses;
+}
+
+uint64_t Actuation_DownChunk(int chunk)
+{
+    return (chunk >= 0 && chunk < 4) ? g_downMask[chunk] : 0;
+}
+
+uint16_t Actuation_GetPressCount(uint16_t hid)
+{
+    return hid < 256 ? g_presses[hid] : 0;
+}
+
+bool Actuation_IsDown(uint16_t hid)
+{
+    if (hid == 0 || hid >= 256) return false;
+    return (g_downPublished[hid / 64].load(std::memory_order_relaxed) >> (hid % 64)) & 1ULL;
+}
@@ -0,0 +1,75 @@
+// actuation.h
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// ============================================================
+// KEY ACTUATION
+// Digital state (down / up) of every key from its depth, per-key:
+// - actuation point: the key goes down at pressM ...
+// - release point:   ... and up below releaseM (hysteresis, 0 = same as pressM)
+// - rapid trigger:   while the key is between the release point and the
+//                    bottom, it goes up as soon as it rises by rtUpM from its
+//                    lowest point and down again as soon as it moves down by
+//                    rtDownM from its highest point, wherever that is: repeated
+//                    taps no longer have to travel back past a fixed point.
+//                    Continuous: the zone extends to the top of the travel,
+//                    only a full release (<= ACTUATION_TOP_M) resets it.
+// Depth is the key value after its curve (0..1000, what the gamepad sees):
+// the default config (pressM 100, no rapid trigger) is the old fixed 0.10
+// threshold.
+// The realtime thread updates all 256 keys at once (Actuation_Update) from
+// structure-of-arrays tables, with no branch per key, no lock and no
+// allocation. Its outputs feed the gamepad buttons (Actuation_DownChunk) and
+// the Actuation combo triggers (press counter, analog_trigger.h).
+// Portable (no Win32).
+// ============================================================
+
+constexpr uint16_t ACTUATION_DEFAULT_PRESS_M = 100;
+// Continuous rapid trigger: at or below this depth the key is fully released.
+constexpr uint16_t ACTUATION_TOP_M = 20;
+
+enum class ActuationMode : uint8_t
+{
+    Fixed = 0,          // press / release points only
+    RapidTrigger,       // rapid trigger below the release point
+    RapidContinuous,    // rapid trigger over the whole travel once actuated
+};
+
+struct KeyActuation
+{
+    ActuationMode mode = ActuationMode::Fixed;
+    uint16_t      pressM = ACTUATION_DEFAULT_PRESS_M;  // 1..1000
+    uint16_t      releaseM = 0;                        // 0 = pressM, else <= pressM
+    uint16_t      rtDownM = 50;                        // rapid trigger sensitivity, 1..1000
+    uint16_t      rtUpM = 50;
+
+    bool IsDefault() const
+    {
+        return mode == ActuationMode::Fixed && pressM == ACTUATION_DEFAULT_PRESS_M && releaseM == 0;
+    }
+};
+
+// ---- Config (any thread, serialised internally) ----
+// HID 1..255. Never blocks the realtime thread; waits at most for one update
+// in progress. The key state is kept across a change.
+void Actuation_Set(uint16_t hid, const KeyActuation& cfg);
+KeyActuation Actuation_Get(uint16_t hid);
+void Actuation_ClearAll();
+// Keys that differ from the default (ini save).
+void Actuation_Enumerate(std::vector<std::pair<uint16_t, KeyActuation>>& out);
+
+// ---- Realtime thread only ----
+// Depth (0..1000) of a key, called once per key of `keys` per update.
+using ActuationReadFn = uint16_t (*)(void* user, uint16_t hid);
+// keys: 4 x 64-bit HID mask of the keys to read, the others count as released.
+// Returns the number of new presses.
+int Actuation_Update(const uint64_t keys[4], ActuationReadFn read, void* user);
+// Down keys after the last update (bit = HID).
+uint64_t Actuation_DownChunk(int chunk);
+// Presses of a key since start (wraps): a change = the key actuated again.
+uint16_t Actuation_GetPressCount(uint16_t hid);
+
+// ---- Other threads ----
+bool Actuation_IsDown(uint16_t hid);
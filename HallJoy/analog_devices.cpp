@@ -0,0 +1,370 @@
+// analog_devices.cpp
+#include "analog_devices.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+
+namespace
+{
+    // ---- Config (any thread) ----
+    std::atomic<uint8_t>                      g_policy{ (uint8_t)AnalogMergePolicy::Max };
+    std::array<std::atomic<uint8_t>, 256>     g_keyDevice{};   // slot + 1, 0 = any device
+    std::atomic<uint32_t>                     g_configGeneration{ 1 };
+    std::atomic<bool>                         g_rescanRequested{ true };
+
+    // Slots: written by the rescan (realtime thread) and the ini load, under the lock
+    std::mutex                                          g_mutex;
+    std::array<uint64_t, ANALOG_MAX_DEVICES>            g_slotIds{};
+    std::array<AnalogDeviceInfo, ANALOG_MAX_DEVICES>    g_slotInfo{};
+    std::array<bool, ANALOG_MAX_DEVICES>                g_slotConnected{};
+    uint32_t                                            g_unslotted = 0;
+
+    // ---- Realtime thread only ----
+    struct DeviceSnap
+    {
+        uint64_t id = 0;
+        bool     present = false;
+        float    depth[256]{};
+        uint64_t keys[4]{};        // keys with a depth this tick
+    };
+    std::array<DeviceSnap, ANALOG_MAX_DEVICES> g_snap{};
+    float             g_merged[256]{};
+    int               g_activeCount = 0;
+    AnalogMergePolicy g_tickPolicy = AnalogMergePolicy::Max;
+    uint32_t          g_tickGeneration = 0;
+    uint64_t          g_lastScanMs = 0;
+    int8_t            g_tickPin[256]{};
+    uint64_t          g_pinMask[ANALOG_MAX_DEVICES][4]{};   // keys pinned to each slot
+    uint64_t          g_pinnedAll[4]{};
+    uint64_t          g_pinnedDown[4]{};                    // pinned keys down on their device
+
+    // Scratch for one bulk read
+    uint16_t          g_readHids[256];
+    float             g_readDepths[256];
+
+    // Stats
+    std::atomic<uint32_t> g_statDevices{ 0 };
+    std::atomic<uint64_t> g_statPolls{ 0 };
+    std::atomic<uint64_t> g_statReads{ 0 };
+    std::atomic<uint64_t> g_statReadErrors{ 0 };
+    std::atomic<uint64_t> g_statRescans{ 0 };
+}
+
+// ---- FakeAnalogSource ----
+void FakeAnalogSource::AddDevice(uint64_t id, const char* name)
+{
+    for (const Device& d : m_devices)
+        if (d.info.id == id) return;
+    Device d;
+    d.info.id = id;
+    if (name) memcpy(d.info.name, name, std::min(strlen(name), sizeof(d.info.name) - 1));
+    m_devices.push_back(d);
+}
+
+void FakeAnalogSource::RemoveDevice(uint64_t id)
+{
+    std::erase_if(m_devices, [id](const Device& d) { return d.info.id == id; });
+}
+
+void FakeAnalogSource::SetKey(uint64_t id, uint16_t hid, float depth)
+{
+    if (hid == 0 || hid >= 256) return;
+    for (Device& d : m_devices)
+        if (d.info.id == id) d.depth[hid] = depth;
+}
+
+void FakeAnalogSource::ReleaseAll(uint64_t id)
+{
+    for (Device& d : m_devices)
+        if (d.info.id == id) std::fill(std::begin(d.depth), std::end(d.depth), 0.0f);
+}
+
+int FakeAnalogSource::Devices(AnalogDeviceInfo* out, int max)
+{
+    int n = 0;
+    for (const Device& d : m_devices)
+        if (n < max) out[n++] = d.info;
+    return n;
+}
+
+int FakeAnalogSource::ReadDevice(uint64_t id, uint16_t* hids, float* depths, int max)
+{
+    for (const Device& d : m_devices)
+    {
+        if (d.info.id != id) continue;
+        ++m_reads;
+        int n = 0;
+        for (int hid = 1; hid < 256 && n < max; ++hid)
+        {
+            if (d.depth[hid] <= 0.0f) continue;
+            hids[n] = (uint16_t)hid;
+            depths[n] = d.depth[hid];
+            ++n;
+        }
+        return n;
+    }
+    return -1;
+}
+
+// ---- Config ----
+void AnalogDevices_SetPolicy(AnalogMergePolicy policy)
+{
+    if ((uint8_t)policy >= (uint8_t)AnalogMergePolicy::Count) policy = AnalogMergePolicy::Max;
+    g_policy.store((uint8_t)policy, std::memory_order_relaxed);
+    g_configGeneration.fetch_add(1, std::memory_order_acq_rel);
+}
+
+AnalogMergePolicy AnalogDevices_GetPolicy()
+{
+    return (AnalogMergePolicy)g_policy.load(std::memory_order_relaxed);
+}
+
+void AnalogDevices_SetKeyDevice(uint16_t hid, int slot)
+{
+    if (hid == 0 || hid >= 256) return;
+    if (slot < 0 || slot >= ANALOG_MAX_DEVICES) slot = ANALOG_ANY_DEVICE;
+    g_keyDevice[hid].store((uint8_t)(slot + 1), std::memory_order_relaxed);
+    g_configGeneration.fetch_add(1, std::memory_order_acq_rel);
+}
+
+int AnalogDevices_GetKeyDevice(uint16_t hid)
+{
+    if (hid == 0 || hid >= 256) return ANALOG_ANY_DEVICE;
+    return (int)g_keyDevice[hid].load(std::memory_order_relaxed) - 1;
+}
+
+void AnalogDevices_EnumerateKeyDevices(std::vector<std::pair<uint16_t, int>>& out)
+{
+    out.clear();
+    for (int hid = 1; hid < 256; ++hid)
+    {
+        const int slot = AnalogDevices_GetKeyDevice((uint16_t)hid);
+        if (slot != ANALOG_ANY_DEVICE) out.emplace_back((uint16_t)hid, slot);
+    }
+}
+
+void AnalogDevices_ClearKeyDevices()
+{
+    for (auto& d : g_keyDevice) d.store(0, std::memory_order_relaxed);
+    g_configGeneration.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void AnalogDevices_SetSlotIds(const std::vector<uint64_t>& ids)
+{
+    {
+        std::lock_guard<std::mutex> lk(g_mutex);
+        g_slotIds.fill(0);
+        for (int slot = 0; slot < ANALOG_MAX_DEVICES && slot < (int)ids.size(); ++slot)
+        {
+            // One slot per device
+            const uint64_t id = ids[(size_t)slot];
+            if (id != 0 && std::find(g_slotIds.begin(), g_slotIds.end(), id) == g_slotIds.end())
+                g_slotIds[(size_t)slot] = id;
+        }
+    }
+    AnalogDevices_RequestRescan();
+}
+
+std::vector<uint64_t> AnalogDevices_GetSlotIds()
+{
+    std::lock_guard<std::mutex> lk(g_mutex);
+    return std::vector<uint64_t>(g_slotIds.begin(), g_slotIds.end());
+}
+
+void AnalogDevices_RequestRescan()
+{
+    g_rescanRequested.store(true, std::memory_order_release);
+}
+
+// ---- Realtime thread ----
+static void RefreshConfigIfChanged()
+{
+    const uint32_t gen = g_configGeneration.load(std::memory_order_acquire);
+    if (gen == g_tickGeneration) return;
+    g_tickGeneration = gen;
+
+    g_tickPolicy = AnalogDevices_GetPolicy();
+    memset(g_pinMask, 0, sizeof(g_pinMask));
+    memset(g_pinnedAll, 0, sizeof(g_pinnedAll));
+    for (int hid = 0; hid < 256; ++hid)
+    {
+        const int8_t slot = (int8_t)AnalogDevices_GetKeyDevice((uint16_t)hid);
+        g_tickPin[hid] = slot;
+        if (slot < 0) continue;
+        g_pinMask[slot][hid / 64] |= 1ULL << (hid % 64);
+        g_pinnedAll[hid / 64] |= 1ULL << (hid % 64);
+    }
+}
+
+static void Rescan(IAnalogSource& src, uint64_t nowMs)
+{
+    g_lastScanMs = nowMs;
+    g_rescanRequested.store(false, std::memory_order_relaxed);
+    g_statRescans.fetch_add(1, std::memory_order_relaxed);
+
+    AnalogDeviceInfo found[ANALOG_MAX_DEVICES * 2];
+    const int n = std::max(0, src.Devices(found, ANALOG_MAX_DEVICES * 2));
+
+    std::lock_guard<std::mutex> lk(g_mutex);
+    g_slotConnected.fill(false);
+    g_unslotted = 0;
+    auto take = [&](size_t slot, const AnalogDeviceInfo& info) {
+        g_slotIds[slot] = info.id;
+        g_slotInfo[slot] = info;
+        g_slotConnected[slot] = true;
+        };
+
+    // Known devices keep their slot...
+    bool placed[ANALOG_MAX_DEVICES * 2]{};
+    for (int i = 0; i < n; ++i)
+    {
+        auto it = std::find(g_slotIds.begin(), g_slotIds.end(), found[i].id);
+        if (found[i].id == 0 || it == g_slotIds.end()) continue;
+        take((size_t)(it - g_slotIds.begin()), found[i]);
+        placed[i] = true;
+    }
+    // ... new ones take a free slot, else the slot of a device not connected
+    for (int i = 0; i < n; ++i)
+    {
+        if (placed[i] || found[i].id == 0) continue;
+        auto it = std::find(g_slotIds.begin(), g_slotIds.end(), 0ULL);
+        if (it == g_slotIds.end())
+            it = std::find(g_slotConnected.begin(), g_slotConnected.end(), false) - g_slotConnected.begin() + g_slotIds.begin();
+        if (it == g_slotIds.end()) { ++g_unslotted; continue; }
+        take((size_t)(it - g_slotIds.begin()), found[i]);
+    }
+
+    uint32_t devices = 0;
+    for (int slot = 0; slot < ANALOG_MAX_DEVICES; ++slot)
+    {
+        DeviceSnap& d = g_snap[(size_t)slot];
+        d.id = g_slotIds[(size_t)slot];
+        d.present = g_slotConnected[(size_t)slot];
+        if (!d.present)
+        {
+            memset(d.depth, 0, sizeof(d.depth));
+            memset(d.keys, 0, sizeof(d.keys));
+        }
+        devices += d.present ? 1u : 0u;
+    }
+    g_statDevices.store(devices, std::memory_order_relaxed);
+}
+
+int AnalogDevices_Poll(IAnalogSource& src, uint64_t nowMs)
+{
+    g_statPolls.fetch_add(1, std::memory_order_relaxed);
+    RefreshConfigIfChanged();
+    if (g_rescanRequested.load(std::memory_order_acquire) || nowMs - g_lastScanMs >= ANALOG_RESCAN_MS)
+        Rescan(src, nowMs);
+
+    const bool first = g_tickPolicy == AnalogMergePolicy::First;
+    uint64_t mergedSet[4]{};
+    memset(g_merged, 0, sizeof(g_merged));
+    memset(g_pinnedDown, 0, sizeof(g_pinnedDown));
+
+    int count = 0;
+    for (int slot = 0; slot < ANALOG_MAX_DEVICES; ++slot)
+    {
+        DeviceSnap& d = g_snap[(size_t)slot];
+        if (!d.present) continue;
+
+        memset(d.depth, 0, sizeof(d.depth));
+        memset(d.keys, 0, sizeof(d.keys));
+
+        const int n = src.ReadDevice(d.id, g_readHids, g_readDepths, 256);
+        if (n < 0)
+        {
+            // Unplugged between two scans: nothing stays pressed, find out on the next tick
+            d.present = false;
+            g_statReadErrors.fetch_add(1, std::memory_order_relaxed);
+            AnalogDevices_RequestRescan();
+            continue;
+        }
+        g_statReads.fetch_add(1, std::memory_order_relaxed);
+        ++count;
+
+        for (int i = 0; i < n && i < 256; ++i)
+        {
+            const uint16_t hid = g_readHids[i];
+            float v = g_readDepths[i];
+            if (hid == 0 || hid >= 256 || !std::isfinite(v) || v <= 0.0f) continue;
+            v = std::min(v, 1.0f);
+
+            const int c = hid / 64;
+            const uint64_t bit = 1ULL << (hid % 64);
+            d.depth[hid] = v;
+            d.keys[c] |= bit;
+
+            if (first)
+            {
+                if (!(mergedSet[c] & bit)) { g_merged[hid] = v; mergedSet[c] |= bit; }
+            }
+            else
+            {
+                g_merged[hid] = std::max(g_merged[hid], v);
+            }
+        }
+
+        for (int c = 0; c < 4; ++c)
+            g_pinnedDown[c] |= d.keys[c] & g_pinMask[slot][c];
+    }
+
+    g_activeCount = count;
+    return count;
+}
+
+float AnalogDevices_Depth(int pad, uint16_t hid)
+{
+    if (hid == 0 || hid >= 256) return 0.0f;
+
+    const int pin = g_tickPin[hid];
+    if (pin >= 0) return g_snap[(size_t)pin].depth[hid];
+    if (pad >= 0 && g_tickPolicy == AnalogMergePolicy::PerPad)
+        return pad < ANALOG_MAX_DEVICES ? g_snap[(size_t)pad].depth[hid] : 0.0f;
+    return g_merged[hid];
+}
+
+bool AnalogDevices_PerPad()
+{
+    return g_activeCount > 0 && g_tickPolicy == AnalogMergePolicy::PerPad;
+}
+
+uint64_t AnalogDevices_PadKeysChunk(int pad, int chunk)
+{
+    if (pad < 0 || !AnalogDevices_PerPad() || chunk < 0 || chunk >= 4) return ~0ULL;
+    const uint64_t own = pad < ANALOG_MAX_DEVICES ? g_snap[(size_t)pad].keys[chunk] : 0;
+    return (own & ~g_pinnedAll[chunk]) | g_pinnedDown[chunk];
+}
+
+// ---- Any thread ----
+void AnalogDevices_GetSlots(std::vector<AnalogSlotInfo>& out)
+{
+    out.clear();
+    std::lock_guard<std::mutex> lk(g_mutex);
+    for (int slot = 0; slot < ANALOG_MAX_DEVICES; ++slot)
+    {
+        if (g_slotIds[(size_t)slot] == 0) continue;
+        AnalogSlotInfo s;
+        s.slot = slot;
+        s.connected = g_slotConnected[(size_t)slot];
+        s.info = g_slotInfo[(size_t)slot];
+        s.info.id = g_slotIds[(size_t)slot];
+        out.push_back(s);
+    }
+}
+
+void AnalogDevices_GetStats(AnalogDevicesStats* out)
+{
+    if (!out) return;
+    out->devices = g_statDevices.load(std::memory_order_relaxed);
+    out->polls = g_statPolls.load(std::memory_order_relaxed);
+    out->deviceReads = g_statReads.load(std::memory_order_relaxed);
+    out->readErrors = g_statReadErrors.load(std::memory_order_relaxed);
+    out->rescans = g_statRescans.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lk(g_mutex);
+    out->unslotted = g_unslotted;
+}
@@ -0,0 +1,134 @@
+// analog_devices.h
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// ============================================================
+// ANALOG DEVICES
+// Several analog keyboards / keypads as one input space.
+// - Once per tick the realtime thread reads every device with one bulk read
+//   (all its pressed keys) into a device-indexed snapshot: cost linear in
+//   the number of devices, nothing per key.
+// - Devices get a slot by their id. The slot order is the priority order;
+//   it is kept in settings.ini so a keyboard keeps its slot across restarts
+//   and replugs. New devices take the next free slot.
+// - Merge policy (what a key reads):
+//     Max:    deepest press of the key on any device
+//     First:  the first device, in slot order, that reports the key
+//     PerPad: pad N reads device slot N only (two players, two keyboards);
+//             what is not per pad (actuation, combo triggers, UI) uses Max
+// - Key pin: a HID can be pinned to one device slot; it then reads that
+//   device only, whatever the policy. The pin is per HID, not a binding
+//   address: bindings still name a HID, so the same key on two devices
+//   cannot drive two different bindings (W pinned to the keypad makes the
+//   keyboard's W read nothing).
+// With no device reported (SDK without device info, nothing plugged) the
+// backend keeps the SDK's merged per-key read, as before.
+// Portable (no Win32): the Wooting SDK source is in backend.cpp, tests and
+// the simulation use FakeAnalogSource.
+// ============================================================
+
+constexpr int ANALOG_MAX_DEVICES = 8;
+constexpr int ANALOG_ANY_DEVICE = -1;
+// The device list is re-read at most this often (plug / unplug)
+constexpr uint32_t ANALOG_RESCAN_MS = 2000;
+
+struct AnalogDeviceInfo
+{
+    uint64_t id = 0;            // SDK device id, stable for one device
+    uint16_t vendorId = 0;
+    uint16_t productId = 0;
+    char     name[64]{};
+};
+
+class IAnalogSource
+{
+public:
+    virtual ~IAnalogSource() = default;
+    // Connected devices, at most max. <0: no device info (use the merged read).
+    virtual int Devices(AnalogDeviceInfo* out, int max) = 0;
+    // Bulk read of one device: every key with a depth, at most max entries.
+    // <0: the device is gone.
+    virtual int ReadDevice(uint64_t id, uint16_t* hids, float* depths, int max) = 0;
+};
+
+// Scripted devices for tests and the simulation.
+class FakeAnalogSource : public IAnalogSource
+{
+public:
+    void AddDevice(uint64_t id, const char* name = "");
+    void RemoveDevice(uint64_t id);
+    void SetKey(uint64_t id, uint16_t hid, float depth);   // 0 releases the key
+    void ReleaseAll(uint64_t id);
+    uint64_t Reads() const { return m_reads; }              // bulk reads served
+
+    int Devices(AnalogDeviceInfo* out, int max) override;
+    int ReadDevice(uint64_t id, uint16_t* hids, float* depths, int max) override;
+
+private:
+    struct Device
+    {
+        AnalogDeviceInfo info;
+        float depth[256]{};
+    };
+    std::vector<Device> m_devices;
+    uint64_t m_reads = 0;
+};
+
+enum class AnalogMergePolicy : uint8_t
+{
+    Max = 0,
+    First,
+    PerPad,
+    Count
+};
+
+// ---- Config (any thread) ----
+void AnalogDevices_SetPolicy(AnalogMergePolicy policy);
+AnalogMergePolicy AnalogDevices_GetPolicy();
+// slot 0..ANALOG_MAX_DEVICES-1, ANALOG_ANY_DEVICE = the merge policy decides.
+void AnalogDevices_SetKeyDevice(uint16_t hid, int slot);
+int  AnalogDevices_GetKeyDevice(uint16_t hid);
+// Pinned keys only (ini save).
+void AnalogDevices_EnumerateKeyDevices(std::vector<std::pair<uint16_t, int>>& out);
+void AnalogDevices_ClearKeyDevices();
+// Device id per slot, 0 = free slot (ini save / load).
+void AnalogDevices_SetSlotIds(const std::vector<uint64_t>& ids);
+std::vector<uint64_t> AnalogDevices_GetSlotIds();
+// Re-read the device list on the next tick (SDK restart).
+void AnalogDevices_RequestRescan();
+
+// ---- Realtime thread ----
+// Once per tick, before any key read. Returns the number of devices read;
+// 0 = no per-device input this tick (the caller keeps the merged read).
+int   AnalogDevices_Poll(IAnalogSource& src, uint64_t nowMs);
+// Depth 0..1 of a key after the policy and the key's pin; pad < 0 = the view
+// that is not per pad. HID 1..255.
+float AnalogDevices_Depth(int pad, uint16_t hid);
+// PerPad policy with devices: pads read their own device.
+bool  AnalogDevices_PerPad();
+// Keys the pad's device reports this tick (pinned keys: their device), for
+// masking the shared actuation state. All ones when not PerPad or pad < 0.
+uint64_t AnalogDevices_PadKeysChunk(int pad, int chunk);
+
+// ---- Any thread ----
+struct AnalogSlotInfo
+{
+    int              slot = 0;
+    bool             connected = false;
+    AnalogDeviceInfo info;
+};
+void AnalogDevices_GetSlots(std::vector<AnalogSlotInfo>& out);
+
+struct AnalogDevicesStats
+{
+    uint32_t devices = 0;         // connected, with a slot
+    uint64_t polls = 0;
+    uint64_t deviceReads = 0;     // bulk reads
+    uint64_t readErrors = 0;
+    uint64_t rescans = 0;
+    uint32_t unslotted = 0;       // connected but every slot taken
+};
+
+void AnalogDevices_GetStats(AnalogDevicesStats* out);
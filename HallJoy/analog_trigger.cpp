@@ -0,0 +1,225 @@
+// analog_trigger.cpp
+#include "analog_trigger.h"
+#include "actuation.h"
+#include "spsc_ring.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    struct RuleTable
+    {
+        uint32_t          generation = 0;
+        int               count = 0;
+        AnalogTriggerRule rules[ANALOG_TRIGGER_MAX_RULES]; // sorted by hid: one read per key
+    };
+
+    // Double buffer: the writer fills the inactive table, then flips g_active.
+    RuleTable             g_tables[2];
+    std::atomic<int>      g_active{ 0 };
+    std::atomic<int>      g_activeCount{ 0 };
+    std::array<std::atomic<uint64_t>, 4> g_actuationKeys{};
+    // Odd while the realtime thread reads a table (seqlock-like epoch).
+    std::atomic<uint32_t> g_rtEpoch{ 0 };
+    std::mutex            g_writeMutex;
+    uint32_t              g_nextGeneration = 1; // under g_writeMutex
+
+    // ---- Realtime thread state ----
+    constexpr uint16_t kUnknown = 0xFFFF;
+
+    enum : uint8_t
+    {
+        Phase_Armed = 0,
+        Phase_Fired,        // Depth / Velocity: wait for the re-arm condition
+        Phase_Actuated,     // DoubleActuation: first actuation seen
+        Phase_Partial,      // DoubleActuation: partially released, key still down
+        Phase_Done,         // DoubleActuation: fired, wait for a full release
+    };
+
+    struct RuleState
+    {
+        uint16_t lastM = kUnknown;
+        uint8_t  phase = Phase_Armed;
+    };
+
+    RuleState g_state[ANALOG_TRIGGER_MAX_RULES];
+    uint32_t  g_stateGeneration = 0;
+    uint64_t  g_lastUs = 0;
+
+    SpscRing<AnalogTriggerEvent, 256> g_events;
+    std::atomic<uint64_t>             g_dropped{ 0 };
+}
+
+void AnalogTrigger_SetRules(const AnalogTriggerRule* rules, int count)
+{
+    std::lock_guard<std::mutex> lk(g_writeMutex);
+    const int next = 1 - g_active.load(std::memory_order_seq_cst);
+
+    // An evaluation that started before the previous flip may still read `next`:
+    // wait for it to end (one tick at most). A later one only sees the active table.
+    const uint32_t epoch = g_rtEpoch.load(std::memory_order_seq_cst);
+    if (epoch & 1u)
+        while (g_rtEpoch.load(std::memory_order_seq_cst) == epoch)
+            std::this_thread::yield();
+
+    RuleTable& t = g_tables[next];
+    t.count = 0;
+    for (int i = 0; rules && i < count && t.count < ANALOG_TRIGGER_MAX_RULES; ++i) {
+        AnalogTriggerRule r = rules[i];
+        if (r.hid == 0) continue;
+        r.thresholdM = std::min<uint16_t>(std::max<uint16_t>(r.thresholdM, 1), 1000);
+        t.rules[t.count++] = r;
+    }
+    std::stable_sort(t.rules, t.rules + t.count,
+        [](const AnalogTriggerRule& a, const AnalogTriggerRule& b) { return a.hid < b.hid; });
+    t.generation = g_nextGeneration++;
+
+    uint64_t keys[4]{};
+    for (int i = 0; i < t.count; ++i)
+        if (t.rules[i].kind == AnalogTriggerKind::Actuation && t.rules[i].hid < 256)
+            keys[t.rules[i].hid / 64] |= 1ULL << (t.rules[i].hid % 64);
+
+    g_active.store(next, std::memory_order_seq_cst);
+    g_activeCount.store(t.count, std::memory_order_relaxed);
+    for (int chunk = 0; chunk < 4; ++chunk)
+        g_actuationKeys[(size_t)chunk].store(keys[chunk], std::memory_order_relaxed);
+}
+
+bool AnalogTrigger_HasRules()
+{
+    return g_activeCount.load(std::memory_order_relaxed) > 0;
+}
+
+void AnalogTrigger_GetActuationKeys(uint64_t keys[4])
+{
+    for (int chunk = 0; chunk < 4; ++chunk)
+        keys[chunk] |= g_actuationKeys[(size_t)chunk].load(std::memory_order_relaxed);
+}
+
+// First sample after a table change: take the key as it is, never fire on it.
+static uint8_t InitialPhase(const AnalogTriggerRule& r, uint16_t v)
+{
+    switch (r.kind) {
+    case AnalogTriggerKind::Depth:           return (v >= r.thresholdM) ? Phase_Fired : Phase_Armed;
+    case AnalogTriggerKind::Velocity:        return (v > ANALOG_TRIGGER_RELEASED_M) ? Phase_Fired : Phase_Armed;
+    case AnalogTriggerKind::DoubleActuation: return (v > ANALOG_TRIGGER_RELEASED_M) ? Phase_Done : Phase_Armed;
+    case AnalogTriggerKind::Actuation:       return Phase_Armed;
+    }
+    return Phase_Armed;
+}
+
+// true = the rule fires on this sample
+static bool Step(const AnalogTriggerRule& r, RuleState& s, uint16_t v, uint64_t dtUs)
+{
+    const int rearmBelow = (int)r.thresholdM - (int)ANALOG_TRIGGER_HYSTERESIS_M;
+    const bool released = (v <= ANALOG_TRIGGER_RELEASED_M);
+
+    switch (r.kind) {
+    case AnalogTriggerKind::Depth:
+        if (s.phase == Phase_Armed) {
+            if (v >= r.thresholdM) { s.phase = Phase_Fired; return true; }
+        } else if ((int)v < rearmBelow || released) {
+            s.phase = Phase_Armed;
+        }
+        return false;
+
+    case AnalogTriggerKind::Velocity:
+        // Once per press: the fastest part of a keystroke spans several ticks
+        if (s.phase == Phase_Armed) {
+            if (dtUs > 0 && v > s.lastM) {
+                const uint64_t speed = (uint64_t)(v - s.lastM) * 1000000ull / dtUs;
+                if (speed >= r.velocityMps) { s.phase = Phase_Fired; return true; }
+            }
+        } else if (released) {
+            s.phase = Phase_Armed;
+        }
+        return false;
+
+    case AnalogTriggerKind::DoubleActuation:
+        if (released) { s.phase = Phase_Armed; return false; }
+        switch (s.phase) {
+        case Phase_Armed:
+            if (v >= r.thresholdM) s.phase = Phase_Actuated;
+            break;
+        case Phase_Actuated:
+            if ((int)v < rearmBelow) s.phase = Phase_Partial;
+            break;
+        case Phase_Partial:
+            if (v >= r.thresholdM) { s.phase = Phase_Done; return true; }
+            break;
+        default:
+            break;
+        }
+        return false;
+
+    case AnalogTriggerKind::Actuation:
+        // v is the key's press counter: any change is a new actuation
+        return v != s.lastM;
+    }
+    return false;
+}
+
+int AnalogTrigger_Evaluate(uint64_t nowUs, AnalogTriggerReadFn read, void* user)
+{
+    if (!read || !AnalogTrigger_HasRules()) return 0;
+
+    g_rtEpoch.fetch_add(1, std::memory_order_seq_cst); // odd: reading
+    const RuleTable& t = g_tables[g_active.load(std::memory_order_seq_cst)];
+
+    if (t.generation != g_stateGeneration) {
+        g_stateGeneration = t.generation;
+        for (int i = 0; i < t.count; ++i) g_state[i] = RuleState{};
+    }
+    const uint64_t dtUs = (g_lastUs && nowUs > g_lastUs) ? nowUs - g_lastUs : 0;
+    g_lastUs = nowUs;
+
+    int pushed = 0;
+    uint16_t hid = 0, v = 0;
+    for (int i = 0; i < t.count; ++i) {
+        const AnalogTriggerRule& r = t.rules[i];
+        if (r.hid != hid) {
+            hid = r.hid;
+            v = std::min<uint16_t>(read(user, hid), 1000);
+        }
+
+        // Actuation rules follow the press counter instead of the depth
+        const uint16_t in = (r.kind == AnalogTriggerKind::Actuation)
+            ? (uint16_t)(Actuation_GetPressCount(r.hid) & 0x7FFF) : v;
+
+        RuleState& s = g_state[i];
+        if (s.lastM == kUnknown) {
+            s.phase = InitialPhase(r, in);
+            s.lastM = in;
+            continue;
+        }
+        const bool fire = Step(r, s, in, dtUs);
+        s.lastM = in;
+        if (!fire) continue;
+
+        AnalogTriggerEvent ev;
+        ev.timeUs = nowUs;
+        ev.id = r.id;
+        ev.hid = r.hid;
+        ev.valueM = v;
+        ev.kind = r.kind;
+        if (g_events.TryPush(ev)) ++pushed;
+        else g_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    g_rtEpoch.fetch_add(1, std::memory_order_seq_cst); // even: done
+    return pushed;
+}
+
+bool AnalogTrigger_Poll(AnalogTriggerEvent* out)
+{
+    return out && g_events.TryPop(*out);
+}
+
+uint64_t AnalogTrigger_GetDroppedCount()
+{
+    return g_dropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,82 @@
+// analog_trigger.h
+#pragma once
+#include <cstdint>
+
+// ============================================================
+// ANALOG TRIGGERS
+// Combo triggers driven by key depth instead of OS key events:
+// - Depth:           the key crosses a depth threshold going down
+// - Velocity:        the key goes down faster than a given speed
+// - DoubleActuation: actuate, partially release, actuate again without
+//                    letting the key go up (one press, two actuations)
+// - Actuation:       every press of the key's actuation state machine
+//                    (actuation.h: per-key actuation point, rapid trigger)
+// Rules are evaluated on the realtime thread (Backend_Tick) against the
+// depth read in the same tick, through a compact table grouped per key:
+// one read per key, a few compares per rule, no lock, no allocation.
+// Events reach the combo engine through a lock-free SPSC queue drained by
+// the input thread (FreeComboSystem::PumpInputBus).
+// Portable (no Win32).
+// ============================================================
+
+enum class AnalogTriggerKind : uint8_t
+{
+    Depth = 0,
+    Velocity,
+    DoubleActuation,
+    Actuation,
+};
+
+constexpr int ANALOG_TRIGGER_MAX_RULES = 64;
+// Full key travel, for the mm/s <-> depth/s conversion (Hall effect boards: ~4 mm).
+constexpr float ANALOG_TRIGGER_TRAVEL_MM = 4.0f;
+// Depth has to go back below threshold - hysteresis before a rule re-arms.
+constexpr uint16_t ANALOG_TRIGGER_HYSTERESIS_M = 60;
+// Below this depth the key counts as released (end of a press).
+constexpr uint16_t ANALOG_TRIGGER_RELEASED_M = 50;
+
+struct AnalogTriggerRule
+{
+    uint32_t          id = 0;            // owner, returned in the event (combo index)
+    uint16_t          hid = 0;
+    AnalogTriggerKind kind = AnalogTriggerKind::Depth;
+    uint16_t          thresholdM = 500;  // Depth / DoubleActuation: 0..1000 (Actuation: unused)
+    uint32_t          velocityMps = 0;   // Velocity: depth units (1/1000 travel) per second
+};
+
+struct AnalogTriggerEvent
+{
+    uint64_t          timeUs = 0;        // timestamp given to AnalogTrigger_Evaluate
+    uint32_t          id = 0;
+    uint16_t          hid = 0;
+    uint16_t          valueM = 0;        // depth when the rule fired
+    AnalogTriggerKind kind = AnalogTriggerKind::Depth;
+};
+
+inline uint32_t AnalogTrigger_MmPerSecToMilli(uint32_t mmPerSec)
+{
+    return (uint32_t)((float)mmPerSec * 1000.0f / ANALOG_TRIGGER_TRAVEL_MM);
+}
+
+// ---- Writer (combo engine, serialised internally) ----
+// Replaces the whole rule set (at most ANALOG_TRIGGER_MAX_RULES, extra rules are
+// ignored). Never blocks the realtime thread; waits at most for one evaluation
+// in progress. Per-rule state restarts from the current depth: a key already
+// pressed past its threshold does not fire.
+void AnalogTrigger_SetRules(const AnalogTriggerRule* rules, int count);
+// Cheap, lock-free: lets the realtime loop skip the call entirely.
+bool AnalogTrigger_HasRules();
+// ORs the keys of the Actuation rules into keys[4] (HID mask): they have to be
+// fed to Actuation_Update before AnalogTrigger_Evaluate.
+void AnalogTrigger_GetActuationKeys(uint64_t keys[4]);
+
+// ---- Realtime thread only ----
+// Current depth (0..1000) of a key.
+using AnalogTriggerReadFn = uint16_t (*)(void* user, uint16_t hid);
+// Evaluates every rule against this tick. Returns the number of events queued.
+int AnalogTrigger_Evaluate(uint64_t nowUs, AnalogTriggerReadFn read, void* user);
+
+// ---- Consumer (one thread: input thread) ----
+bool AnalogTrigger_Poll(AnalogTriggerEvent* out);
+// Events lost because the queue was full.
+uint64_t AnalogTrigger_GetDroppedCount();
@@ -34,7 +34,15 @@
 #include "app_paths.h"
 #include "ui_theme.h"
 #include "free_combo_system.h"   // ← Nouveau système combos libres v2.0
+#include "input_thread.h"
+#include "input_bus.h"
+#include "combo_timer.h"
+#include "persist_service.h"
+#include "app_profiles.h"
+#include "mouse_output.h"
+#include "profile_cache.h"
 #include "Logger.h"
+#include "key_table.h"
 
 // shared ignore window used by macro senders to prevent retrigger loops
 std::atomic<unsigned long long> s_ignoreKeyEventsUntilMs{ 0 };  // défini ici depuis v3.3 (macro_system.cpp supprimé)
@@ -54,6 +62,10 @@ static const UINT SETTINGS_SAVE_TIMER_MS = 350;
 static HWND g_hPageMain = nullptr;
 static HHOOK g_hKeyboardHook = nullptr;
 static HHOOK g_hMouseHook = nullptr;
+static HWINEVENTHOOK g_hForegroundHook = nullptr;
+// Foreground state cached for the LL hooks (updated on EVENT_SYSTEM_FOREGROUND,
+// GetForegroundWindow + GetClassNameW are too slow to run on every key).
+static std::atomic<bool> g_ownForeground{ false };
 static HWND  g_hMainWnd = nullptr;  // ref fenêtre principale
 static HWND  g_hCompactWnd = nullptr;  // fenêtre mode compact
 HWND  g_hCompactTip = nullptr;  // tooltip fenêtre compacte — extern dans keyboard_ui.cpp
@@ -469,66 +481,9 @@ static bool IsOwnForegroundWindow()
 
 uint16_t HidFromKeyboardScanCode(DWORD scanCode, bool extended, DWORD vkCode)
 {
-    switch (scanCode & 0xFFu)
-    {
-    case 0x01: return 41; case 0x02: return 30; case 0x03: return 31; case 0x04: return 32;
-    case 0x05: return 33; case 0x06: return 34; case 0x07: return 35; case 0x08: return 36;
-    case 0x09: return 37; case 0x0A: return 38; case 0x0B: return 39; case 0x0C: return 45;
-    case 0x0D: return 46; case 0x0E: return 42; case 0x0F: return 43; case 0x10: return 20;
-    case 0x11: return 26; case 0x12: return 8;  case 0x13: return 21; case 0x14: return 23;
-    case 0x15: return 28; case 0x16: return 24; case 0x17: return 12; case 0x18: return 18;
-    case 0x19: return 19; case 0x1A: return 47; case 0x1B: return 48;
-    case 0x1C: return extended ? 88 : 40;
-    case 0x1D: return extended ? 228 : 224;
-    case 0x1E: return 4;  case 0x1F: return 22; case 0x20: return 7;  case 0x21: return 9;
-    case 0x22: return 10; case 0x23: return 11; case 0x24: return 13; case 0x25: return 14;
-    case 0x26: return 15; case 0x27: return 51; case 0x28: return 52; case 0x29: return 53;
-    case 0x2A: return 225; case 0x2B: return 49; case 0x2C: return 29; case 0x2D: return 27;
-    case 0x2E: return 6;  case 0x2F: return 25; case 0x30: return 5;  case 0x31: return 17;
-    case 0x32: return 16; case 0x33: return 54; case 0x34: return 55;
-    case 0x35: return extended ? 84 : 56;
-    case 0x36: return 229;
-    case 0x37: return extended ? 70 : 85;
-    case 0x38: return extended ? 230 : 226;
-    case 0x39: return 44; case 0x3A: return 57; case 0x3B: return 58; case 0x3C: return 59;
-    case 0x3D: return 60; case 0x3E: return 61; case 0x3F: return 62; case 0x40: return 63;
-    case 0x41: return 64; case 0x42: return 65; case 0x43: return 66; case 0x44: return 67;
-    case 0x45: return 83; case 0x46: return 71;
-    case 0x47: return extended ? 74 : 95;
-    case 0x48: return extended ? 82 : 96;
-    case 0x49: return extended ? 75 : 97;
-    case 0x4A: return 86;
-    case 0x4B: return extended ? 80 : 92;
-    case 0x4C: return 93;
-    case 0x4D: return extended ? 79 : 94;
-    case 0x4E: return 87;
-    case 0x4F: return extended ? 77 : 89;
-    case 0x50: return extended ? 81 : 90;
-    case 0x51: return extended ? 78 : 91;
-    case 0x52: return extended ? 73 : 98;
-    case 0x53: return extended ? 76 : 99;
-    case 0x57: return 68; case 0x58: return 69;
-    case 0x5B: return 227; case 0x5C: return 231; case 0x5D: return 101;
-    default: break;
-    }
-    switch (vkCode)
-    {
-    case 'A': return 4; case 'B': return 5; case 'C': return 6; case 'D': return 7; case 'E': return 8;
-    case 'F': return 9; case 'G': return 10; case 'H': return 11; case 'I': return 12; case 'J': return 13;
-    case 'K': return 14; case 'L': return 15; case 'M': return 16; case 'N': return 17; case 'O': return 18;
-    case 'P': return 19; case 'Q': return 20; case 'R': return 21; case 'S': return 22; case 'T': return 23;
-    case 'U': return 24; case 'V': return 25; case 'W': return 26; case 'X': return 27; case 'Y': return 28;
-    case 'Z': return 29;
-    case '1': return 30; case '2': return 31; case '3': return 32; case '4': return 33; case '5': return 34;
-    case '6': return 35; case '7': return 36; case '8': return 37; case '9': return 38; case '0': return 39;
-    case VK_SPACE: return 44; case VK_TAB: return 43;
-    case VK_RETURN: return extended ? 88 : 40;
-    case VK_BACK: return 42; case VK_ESCAPE: return 41;
-    case VK_LEFT: return 80; case VK_RIGHT: return 79; case VK_UP: return 82; case VK_DOWN: return 81;
-    case VK_HOME: return 74; case VK_END: return 77; case VK_PRIOR: return 75; case VK_NEXT: return 78;
-    case VK_INSERT: return 73; case VK_DELETE: return 76;
-    default: return 0;
-    }
+    // key_table.h: generated dense arrays, VK only for scan codes it does not know
+    const uint16_t hid = KeyTable_HidFromScan(scanCode, extended);
+    return hid ? hid : KeyTable_VkToHid(vkCode);
 }
 
 // FIX WASD lock: g_hookKeyDown moved to file scope so it can be reset
@@ -536,102 +491,183 @@ uint16_t HidFromKeyboardScanCode(DWORD scanCode, bool extended, DWORD vkCode)
 // disconnected mid-press, the KEYUP is never seen → g_hookKeyDown[vk] stays
 // true → every subsequent press is blocked indefinitely → reboot required.
 static bool g_hookKeyDown[256] = { 0 };
+// Physical mouse buttons held, as the mouse hook saw them (bit = FreeTriggerKeyType - MouseLeft)
+static uint8_t g_hookMouseDown = 0;
 
 void App_ResetHookKeyDown()
 {
     memset(g_hookKeyDown, 0, sizeof(g_hookKeyDown));
+    g_hookMouseDown = 0;
+    InputBus_ResetHeld();
 }
 
-static LRESULT CALLBACK KeyboardBlockHookProc(int nCode, WPARAM wParam, LPARAM lParam)
+// App profiles: executable of the foreground window (UI thread, on focus change only)
+class WinForegroundProvider : public IForegroundProvider
 {
-    if (nCode == HC_ACTION && lParam)
+public:
+    bool ForegroundExe(std::wstring& exeName) override
     {
+        HWND fg = GetForegroundWindow();
+        if (!fg) return false;
+        DWORD pid = 0;
+        GetWindowThreadProcessId(fg, &pid);
+        if (!pid) return false;
+        HANDLE hProc = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+        if (!hProc) return false;
+        wchar_t exeFull[MAX_PATH] = {};
+        DWORD sz = MAX_PATH;
+        const bool ok = QueryFullProcessImageNameW(hProc, 0, exeFull, &sz) != FALSE;
+        CloseHandle(hProc);
+        if (!ok) return false;
+        const wchar_t* slash = wcsrchr(exeFull, L'\\');
+        exeName = slash ? slash + 1 : exeFull;
+        return true;
+    }
+};
+static WinForegroundProvider g_foregroundProvider;
+
+static void CALLBACK ForegroundWinEventProc(HWINEVENTHOOK, DWORD, HWND, LONG, LONG, DWORD, DWORD)
+{
+    g_ownForeground.store(IsOwnForegroundWindow(), std::memory_order_relaxed);
+    FreeComboSystem::RefreshForegroundCache();
+    AppProfiles_OnForegroundChanged();
+}
+
+// Held state for FreeComboSystem::IsKeyboardTriggerCandidate, from the hooks' own tracking
+static FreeComboSystem::HookHeldState HookHeld()
+{
+    FreeComboSystem::HookHeldState h;
+    uint8_t m = (uint8_t)(1u << (unsigned)FreeTriggerModifier::None);
+    if (g_hookKeyDown[VK_LCONTROL] || g_hookKeyDown[VK_RCONTROL]) m |= (uint8_t)(1u << (unsigned)FreeTriggerModifier::Ctrl);
+    if (g_hookKeyDown[VK_LSHIFT] || g_hookKeyDown[VK_RSHIFT])     m |= (uint8_t)(1u << (unsigned)FreeTriggerModifier::Shift);
+    if (g_hookKeyDown[VK_LMENU] || g_hookKeyDown[VK_RMENU])       m |= (uint8_t)(1u << (unsigned)FreeTriggerModifier::Alt);
+    if (g_hookKeyDown[VK_LWIN] || g_hookKeyDown[VK_RWIN])         m |= (uint8_t)(1u << (unsigned)FreeTriggerModifier::Win);
+    h.modifiers = m;
+    h.mouseButtons = g_hookMouseDown;
+    h.keys = g_hookKeyDown;
+    return h;
+}
 
-        // FreeComboSystem : toujours actif, ecoute toutes les touches non-injectees
-        if (wParam == WM_KEYDOWN || wParam == WM_KEYUP || wParam == WM_SYSKEYDOWN || wParam == WM_SYSKEYUP)
+// Bit of a button message in g_hookMouseDown (Left, Right, Middle, X1, X2), -1 otherwise
+static int HookMouseButtonBit(WPARAM msg, DWORD mouseData)
+{
+    switch (msg)
+    {
+    case WM_LBUTTONDOWN: case WM_LBUTTONUP: return 0;
+    case WM_RBUTTONDOWN: case WM_RBUTTONUP: return 1;
+    case WM_MBUTTONDOWN: case WM_MBUTTONUP: return 2;
+    case WM_XBUTTONDOWN: case WM_XBUTTONUP: return HIWORD(mouseData) == XBUTTON1 ? 3 : 4;
+    }
+    return -1;
+}
+
+// LL hooks: block/pass decision only, from lock-free tables.
+// Everything else (combos, capture, SendInput) runs on the input thread.
+static LRESULT CALLBACK KeyboardBlockHookProc(int nCode, WPARAM wParam, LPARAM lParam)
+{
+    if (nCode == HC_ACTION && lParam &&
+        (wParam == WM_KEYDOWN || wParam == WM_KEYUP || wParam == WM_SYSKEYDOWN || wParam == WM_SYSKEYUP))
+    {
+        const uint64_t t0 = InputThread_Now();
+        const KBDLLHOOKSTRUCT* k = (const KBDLLHOOKSTRUCT*)lParam;
+        const bool injected = (k->flags & LLKHF_INJECTED) != 0 || (k->dwExtraInfo == (ULONG_PTR)0x484A4D43ULL);
+        const bool ext = (k->flags & LLKHF_EXTENDED) != 0;
+        const bool isDown = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
+        const uint16_t hid = HidFromKeyboardScanCode(k->scanCode, ext, k->vkCode);
+
+        RawInputEvent ev;
+        ev.kind = RawInputKind::Keyboard;
+        ev.qpc = t0;
+        ev.msg = (uint32_t)wParam;
+        ev.vkCode = k->vkCode;
+        ev.scanCode = k->scanCode;
+        ev.llFlags = k->flags;
+        ev.time = k->time;
+        ev.hid = hid;
+
+        bool block = false;
+        if (injected)
         {
-            const KBDLLHOOKSTRUCT* kfc = (const KBDLLHOOKSTRUCT*)lParam;
-            if (kfc && !(kfc->flags & LLKHF_INJECTED) && kfc->dwExtraInfo != (ULONG_PTR)0x484A4D43ULL)
-            {
-                if (FreeComboSystem::ProcessKeyboardEvent((UINT)wParam, (WPARAM)kfc->vkCode, lParam))
-                {
-                    // Only block the trigger key from reaching the game if it is also
-                    // mapped to an Xbox button. If it is a pure keyboard key (not bound),
-                    // let it pass through so the game receives it normally.
-                    const bool ext2 = (kfc->flags & LLKHF_EXTENDED) != 0;
-                    uint16_t hid2 = HidFromKeyboardScanCode(kfc->scanCode, ext2, kfc->vkCode);
-                    if (hid2 != 0 && Bindings_IsHidBound(hid2))
-                        return 1; // bound to Xbox → block, ViGEm handles it
-                    // else: pure keyboard trigger → fall through, game sees the key
-                }
-            }
+            ev.flags |= RawInputFlag_Injected;
         }
-
-        if (wParam == WM_KEYDOWN || wParam == WM_KEYUP || wParam == WM_SYSKEYDOWN || wParam == WM_SYSKEYUP)
+        else if (k->vkCode < 256)
         {
-            const KBDLLHOOKSTRUCT* k = (const KBDLLHOOKSTRUCT*)lParam;
-            if (k)
-            {
-                const bool injected = (k->flags & LLKHF_INJECTED) != 0 || (k->dwExtraInfo == (ULONG_PTR)0x484A4D43ULL);
-                const bool ext = (k->flags & LLKHF_EXTENDED) != 0;
-                uint16_t hid = HidFromKeyboardScanCode(k->scanCode, ext, k->vkCode);
-
-                if (!injected)
-                {
-                    int vk = (int)k->vkCode;
-                    if (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN)
-                    {
-                        if (vk >= 0 && vk < 256)
-                        {
-                            if (g_hookKeyDown[vk])
-                            {
-                                if (hid != 0 && Settings_GetBlockBoundKeys() && Backend_GetRemapEnabled() && Bindings_IsHidBound(hid) && !IsOwnForegroundWindow())
-                                {
-                                    INPUT inputs[2] = {};
-                                    inputs[0].type = INPUT_KEYBOARD;
-                                    inputs[0].ki.wVk = (WORD)k->vkCode;
-                                    inputs[0].ki.dwFlags = 0;
-                                    inputs[0].ki.dwExtraInfo = (ULONG_PTR)0x484A4D43ULL;
-                                    inputs[1].type = INPUT_KEYBOARD;
-                                    inputs[1].ki.wVk = (WORD)k->vkCode;
-                                    inputs[1].ki.dwFlags = KEYEVENTF_KEYUP;
-                                    inputs[1].ki.dwExtraInfo = (ULONG_PTR)0x484A4D43ULL;
-                                    unsigned long long now2 = GetTickCount64();
-                                    s_ignoreKeyEventsUntilMs.store(now2 + 200ULL, std::memory_order_release);
-                                    SendInput(2, inputs, sizeof(INPUT));
-                                    return 1;
-                                }
-                            }
-                            else { g_hookKeyDown[vk] = true; }
-                        }
-                    }
-                    else if (wParam == WM_KEYUP || wParam == WM_SYSKEYUP)
-                    {
-                        int vk2 = (int)k->vkCode;
-                        if (vk2 >= 0 && vk2 < 256) g_hookKeyDown[vk2] = false;
-                    }
-                }
+            const int vk = (int)k->vkCode;
+            const bool bound = (hid != 0) && (AppProfiles_IsHidBound(hid) || MouseOut_IsHidBound(hid));
+            const bool blockBound = bound && Settings_GetBlockBoundKeys() && Backend_GetRemapEnabled() &&
+                !g_ownForeground.load(std::memory_order_relaxed);
 
-                if (Settings_GetBlockBoundKeys() && Backend_GetRemapEnabled() && !injected && !IsOwnForegroundWindow())
-                    if (hid != 0 && Bindings_IsHidBound(hid)) return 1;
+            if (isDown)
+            {
+                const bool repeat = g_hookKeyDown[vk];
+                g_hookKeyDown[vk] = true;
+
+                // Combo that will fire on this press (modifier + hold key held) and key also
+                // mapped to an Xbox button → block, ViGEm handles it.
+                // A pure keyboard trigger (not bound) passes through so the game sees the key.
+                if (!repeat && bound && FreeComboSystem::IsKeyboardTriggerCandidate((WORD)vk, HookHeld()))
+                    block = true;
+
+                // Auto-repeat of a blocked key: the input thread re-sends a marked tap.
+                if (repeat && blockBound)
+                    ev.flags |= RawInputFlag_ReinjectTap;
+            }
+            else
+            {
+                g_hookKeyDown[vk] = false;
             }
+
+            if (blockBound) block = true;
         }
+
+        if (block) ev.flags |= RawInputFlag_Blocked;
+        if (!injected)
+            InputThread_Push(ev); // FreeComboSystem n'écoute que les touches physiques
+
+        InputThread_RecordHookTime(InputHookId::Keyboard, t0);
+        if (block) return 1;
     }
     return CallNextHookEx(g_hKeyboardHook, nCode, wParam, lParam);
 }
 
 static LRESULT CALLBACK MouseHookProc(int nCode, WPARAM wParam, LPARAM lParam)
 {
-    if (nCode == HC_ACTION && lParam)
+    if (nCode == HC_ACTION && lParam && wParam != WM_MOUSEMOVE)
     {
+        const uint64_t t0 = InputThread_Now();
+        const MSLLHOOKSTRUCT* m = (const MSLLHOOKSTRUCT*)lParam;
+
+        RawInputEvent ev;
+        ev.kind = RawInputKind::Mouse;
+        ev.qpc = t0;
+        ev.msg = (uint32_t)wParam;
+        ev.llFlags = m->flags;
+        ev.mouseData = m->mouseData;
+        ev.time = m->time;
+        if ((m->flags & LLMHF_INJECTED) != 0 || m->dwExtraInfo == (ULONG_PTR)0x484A4D43ULL)
+            ev.flags |= RawInputFlag_Injected;
+        else if (const int bit = HookMouseButtonBit(wParam, m->mouseData); bit >= 0)
+        {
+            const bool down = wParam == WM_LBUTTONDOWN || wParam == WM_RBUTTONDOWN ||
+                wParam == WM_MBUTTONDOWN || wParam == WM_XBUTTONDOWN;
+            if (down) g_hookMouseDown |= (uint8_t)(1u << bit);
+            else      g_hookMouseDown &= (uint8_t)~(1u << bit);
+        }
+
         // Wheel cooldown natif : bloquer les doublons molette avant le jeu
+        bool block = false;
         if ((wParam == WM_MOUSEWHEEL || wParam == WM_MOUSEHWHEEL) &&
             !FreeComboSystem::IsWheelEventAllowed())
         {
-            return 1; // bloquer — ne pas passer au jeu
+            block = true;
+            ev.flags |= RawInputFlag_Blocked;
         }
-        // FreeComboSystem : toujours actif
-        FreeComboSystem::ProcessMouseEvent((UINT)wParam, wParam, lParam);
+
+        // FreeComboSystem : toujours actif (traité sur le thread d'entrée)
+        InputThread_Push(ev);
+
+        InputThread_RecordHookTime(InputHookId::Mouse, t0);
+        if (block) return 1; // bloquer — ne pas passer au jeu
     }
     return CallNextHookEx(g_hMouseHook, nCode, wParam, lParam);
 }
@@ -1037,11 +1073,20 @@ static LRESULT CALLBACK MainWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM l
             static ULONGLONG s_lastTimerLog = 0;
             ULONGLONG nowTick = GetTickCount64();
             bool doLog = (nowTick - s_lastTimerLog) >= 5000;
-            FreeComboSystem::Tick();
-            if (doLog) Logger::Info("TIMER", "Tick complet OK");
+            // Long press / repeats: combo_timer thread, no longer this timer
+            if (doLog)
+            {
+                s_lastTimerLog = nowTick;
+                Logger::Info("TIMER", "Tick complet OK");
+                InputThread_LogHookStats();
+                ComboTimer_LogStats();
+                Persist_LogStats();
+                ProfileCache_LogStats();
+            }
         }
         else if (wParam == SETTINGS_SAVE_TIMER_ID)
         {
+            // Snapshot only: the persistence service does the disk write
             KillTimer(hwnd, SETTINGS_SAVE_TIMER_ID);
             SettingsIni_Save(AppPaths_SettingsIni().c_str());
         }
@@ -1104,7 +1149,11 @@ static LRESULT CALLBACK MainWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM l
         // pendant la destruction de la fenêtre → souris figée quelques instants
         if (g_hKeyboardHook) { UnhookWindowsHookEx(g_hKeyboardHook); g_hKeyboardHook = nullptr; }
         if (g_hMouseHook) { UnhookWindowsHookEx(g_hMouseHook);    g_hMouseHook = nullptr; }
+        if (g_hForegroundHook) { UnhookWinEvent(g_hForegroundHook); g_hForegroundHook = nullptr; }
 
+        // Hooks gone → no more producer: drain + stop the input thread before combos shut down
+        InputThread_Stop();
+        ComboTimer_Stop();
         FreeComboSystem::Shutdown();
 
         Logger::Info("WM_DESTROY", "Shutdown complet OK");
@@ -1220,12 +1269,26 @@ int App_Run(HINSTANCE hInst, int nCmdShow)
         }
     }
 
+    if (!InputThread_Start())
+        Logger::Error("APP_RUN", "InputThread_Start echoue ! combos inactifs");
+    if (!ComboTimer_Start())
+        Logger::Error("APP_RUN", "ComboTimer_Start echoue ! long press / repeats inactifs");
+
+    // Foreground tracking for the hooks and the app profiles (out-of-context → delivered on this thread's message loop)
+    AppProfiles_SetForegroundProvider(&g_foregroundProvider);
+    g_hForegroundHook = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, nullptr,
+        ForegroundWinEventProc, 0, 0, WINEVENT_OUTOFCONTEXT);
+    ForegroundWinEventProc(nullptr, 0, nullptr, 0, 0, 0, 0);
+
     Logger::Info("APP_RUN", "Avant SetWindowsHookExW keyboard");
     g_hKeyboardHook = SetWindowsHookExW(WH_KEYBOARD_LL, KeyboardBlockHookProc, GetModuleHandleW(nullptr), 0);
     Logger::Info("APP_RUN", "Avant SetWindowsHookExW mouse");
     g_hMouseHook = SetWindowsHookExW(WH_MOUSE_LL, MouseHookProc, GetModuleHandleW(nullptr), 0);
     Logger::Info("APP_RUN", "Hooks OK - entree boucle messages");
 
+    // Demarrage termine : plus de lecture via le cache
+    ProfileCache_Close();
+
     MSG msg{};
     while (true)
     {
@@ -1243,6 +1306,9 @@ int App_Run(HINSTANCE hInst, int nCmdShow)
 
     if (g_hKeyboardHook) { UnhookWindowsHookEx(g_hKeyboardHook); g_hKeyboardHook = nullptr; }
     if (g_hMouseHook) { UnhookWindowsHookEx(g_hMouseHook);    g_hMouseHook = nullptr; }
+    if (g_hForegroundHook) { UnhookWinEvent(g_hForegroundHook); g_hForegroundHook = nullptr; }
+    InputThread_Stop();
+    ComboTimer_Stop();
 
     Logger::Info("APP_RUN", "App_Run termine normalement");
     return (int)msg.wParam;
@@ -0,0 +1,205 @@
+// app_profiles.cpp
+#include "app_profiles.h"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <utility>
+
+namespace
+{
+    struct RetiredSet
+    {
+        std::vector<std::unique_ptr<ProfileImage>> images;
+        uint64_t epoch = 0;   // free once the realtime thread has seen it
+    };
+
+    // Realtime side: one pointer, one epoch each way
+    std::atomic<const ProfileImage*> g_active{ nullptr };
+    std::atomic<uint64_t>            g_epoch{ 1 };        // bumped after every publish
+    std::atomic<uint64_t>            g_readerEpoch{ 0 };  // epoch of the tick in progress
+    std::array<std::atomic<uint64_t>, 4> g_activeBound{}; // copy of the active boundAny (LL hook)
+
+    // Control side (UI thread, under the lock)
+    std::mutex                                 g_mutex;
+    std::vector<std::unique_ptr<ProfileImage>> g_images;
+    std::vector<AppProfileRule>                g_rules;
+    std::vector<RetiredSet>                    g_retired;
+    IForegroundProvider*                       g_provider = nullptr;
+    std::wstring                               g_foregroundExe;
+    AppProfilesStats                           g_stats;
+}
+
+static wchar_t FoldAscii(wchar_t c)
+{
+    return (c >= L'A' && c <= L'Z') ? (wchar_t)(c + (L'a' - L'A')) : c;
+}
+
+bool AppProfiles_MatchExe(std::wstring_view pattern, std::wstring_view exeName)
+{
+    // Iterative glob: backtrack only to the last '*'
+    size_t p = 0, s = 0;
+    size_t starP = std::wstring_view::npos, starS = 0;
+    while (s < exeName.size())
+    {
+        if (p < pattern.size() && (pattern[p] == L'?' || FoldAscii(pattern[p]) == FoldAscii(exeName[s])))
+        {
+            ++p; ++s;
+        }
+        else if (p < pattern.size() && pattern[p] == L'*')
+        {
+            starP = p++;
+            starS = s;
+        }
+        else if (starP != std::wstring_view::npos)
+        {
+            p = starP + 1;
+            s = ++starS;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == L'*') ++p;
+    return p == pattern.size();
+}
+
+std::unique_ptr<ProfileImage> AppProfiles_Compile(const ProfileSource& src)
+{
+    auto img = std::make_unique<ProfileImage>();
+    img->name = src.name;
+    img->ownSocd = src.hasSocd;
+    img->ownStickShape = src.hasStickShape;
+
+    for (int pad = 0; pad < BINDINGS_MAX_GAMEPADS; ++pad)
+    {
+        ProfilePadImage& dst = img->pads[pad];
+        dst.bindings = src.pads[pad];
+
+        // Bound index: same rule as Bindings_IsHidBound (HID 0 never bound)
+        auto mark = [&](uint16_t hid) {
+            if (hid != 0 && hid < 256) img->boundAny[hid / 64] |= 1ULL << (hid % 64);
+            };
+        for (const AxisBinding& a : dst.bindings.axes) { mark(a.minusHid); mark(a.plusHid); }
+        for (uint16_t t : dst.bindings.triggers) mark(t);
+        for (const auto& btn : dst.bindings.buttons)
+            for (int c = 0; c < 4; ++c) img->boundAny[c] |= btn[c];
+        for (int i = 0; i < dst.bindings.zones.keyCount; ++i) mark(dst.bindings.zones.keys[i].hid);
+
+        BindingLayers_Compile(src.layers[pad], dst.layers);
+        for (int c = 0; c < 4; ++c) img->boundAny[c] |= dst.layers.layerHids[c];
+
+        for (int axis = 0; axis < SOCD_AXES; ++axis)
+            dst.socd[axis] = src.hasSocd ? src.socd[pad][axis] : SocdMode::Global;
+        for (int stick = 0; stick < STICK_SHAPE_STICKS; ++stick)
+            StickShape_Compile(src.hasStickShape ? StickShape_Sanitize(src.sticks[pad][stick]) : StickShapeConfig{},
+                dst.sticks[stick]);
+    }
+    img->boundAny[0] &= ~1ULL;
+    return img;
+}
+
+// Caller holds g_mutex.
+static const ProfileImage* PickUnlocked(const std::wstring& exe)
+{
+    if (exe.empty()) return nullptr;
+    for (const AppProfileRule& r : g_rules)
+    {
+        if (!AppProfiles_MatchExe(r.exePattern, exe)) continue;
+        for (const auto& img : g_images)
+            if (img->name == r.profile) return img.get();
+    }
+    return nullptr;
+}
+
+// Caller holds g_mutex.
+static void PublishUnlocked(const ProfileImage* img)
+{
+    if (g_active.load(std::memory_order_relaxed) == img) return;
+
+    for (int c = 0; c < 4; ++c)
+        g_activeBound[(size_t)c].store(img ? img->boundAny[c] : 0, std::memory_order_relaxed);
+    g_active.store(img, std::memory_order_release);
+    g_epoch.fetch_add(1, std::memory_order_acq_rel);
+    ++g_stats.switches;
+}
+
+// Caller holds g_mutex.
+static void FreeRetiredUnlocked()
+{
+    const uint64_t seen = g_readerEpoch.load(std::memory_order_acquire);
+    std::erase_if(g_retired, [seen](const RetiredSet& r) { return r.epoch <= seen; });
+}
+
+void AppProfiles_SetProfiles(std::vector<std::unique_ptr<ProfileImage>> images, std::vector<AppProfileRule> rules)
+{
+    std::lock_guard<std::mutex> lk(g_mutex);
+
+    RetiredSet old;
+    old.images = std::move(g_images);
+    g_images = std::move(images);
+    g_rules = std::move(rules);
+    g_stats.profiles = (uint32_t)g_images.size();
+    g_stats.rules = (uint32_t)g_rules.size();
+
+    PublishUnlocked(PickUnlocked(g_foregroundExe));
+
+    // The old set may still be read by the tick in progress
+    if (!old.images.empty())
+    {
+        old.epoch = g_epoch.load(std::memory_order_relaxed);
+        g_retired.push_back(std::move(old));
+    }
+    FreeRetiredUnlocked();
+}
+
+void AppProfiles_SetForegroundProvider(IForegroundProvider* provider)
+{
+    std::lock_guard<std::mutex> lk(g_mutex);
+    g_provider = provider;
+}
+
+void AppProfiles_OnForegroundChanged()
+{
+    std::lock_guard<std::mutex> lk(g_mutex);
+    ++g_stats.foregroundChanges;
+
+    std::wstring exe;
+    if (!g_provider || !g_provider->ForegroundExe(exe)) exe.clear();
+    g_foregroundExe = std::move(exe);
+
+    PublishUnlocked(PickUnlocked(g_foregroundExe));
+    FreeRetiredUnlocked();
+}
+
+std::wstring AppProfiles_ActiveName()
+{
+    std::lock_guard<std::mutex> lk(g_mutex);
+    const ProfileImage* img = g_active.load(std::memory_order_relaxed);
+    return img ? img->name : std::wstring();
+}
+
+const ProfileImage* AppProfiles_BeginTick()
+{
+    // Epoch first: a tick that saw epoch E also loads the pointer published before E
+    const uint64_t epoch = g_epoch.load(std::memory_order_acquire);
+    const ProfileImage* img = g_active.load(std::memory_order_acquire);
+    g_readerEpoch.store(epoch, std::memory_order_release);
+    return img;
+}
+
+bool AppProfiles_IsHidBound(uint16_t hid)
+{
+    if (!g_active.load(std::memory_order_acquire)) return Bindings_IsHidBound(hid) || BindingLayers_IsHidBound(hid);
+    if (hid == 0 || hid >= 256) return false;
+    return (g_activeBound[hid / 64].load(std::memory_order_relaxed) >> (hid % 64)) & 1ULL;
+}
+
+void AppProfiles_GetStats(AppProfilesStats* out)
+{
+    if (!out) return;
+    std::lock_guard<std::mutex> lk(g_mutex);
+    *out = g_stats;
+    out->retiredPending = (uint32_t)g_retired.size();
+}
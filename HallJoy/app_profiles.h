@@ -0,0 +1,127 @@
+// app_profiles.h
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bindings.h"
+#include "binding_layers.h"
+#include "socd.h"
+#include "stick_shape.h"
+
+// ============================================================
+// APP PROFILES
+// Named profiles picked by the executable in the foreground.
+// - A profile is compiled once, when it is loaded, into an immutable
+//   ProfileImage: bindings and layer tables of every pad, bound-HID index,
+//   SOCD modes and 2D stick tables. The file format is the bindings profile
+//   (Profile_SaveIni, layers included) plus optional [SOCD] / [StickShape]
+//   sections as in settings.ini; a missing section means the live settings
+//   apply.
+// - Rules: executable name pattern ('*' / '?', case-insensitive) -> profile
+//   name, first match wins. No match: the live bindings and settings (the
+//   ones the UI edits) apply, as before.
+// - Switch: on a foreground change the provider names the executable, the
+//   rules pick an image and one atomic pointer store publishes it. The
+//   realtime thread loads that pointer once per tick, so the next tick runs
+//   on the new image; nothing is parsed or allocated on its side.
+// - Images replaced by a reload are freed once the realtime thread has
+//   started a tick after the swap (epoch), never while it may read them.
+// Curves stay global and combos keep their own per-app whitelist.
+// Portable (no Win32): the Win32 provider is in app.cpp, the files are read
+// by settings_ini.cpp.
+// ============================================================
+
+static_assert(SOCD_MAX_PADS == BINDINGS_MAX_GAMEPADS && STICK_SHAPE_MAX_PADS == BINDINGS_MAX_GAMEPADS,
+    "one profile pad per virtual pad");
+
+struct ProfilePadImage
+{
+    PadBindings      bindings;
+    PadLayerTable    layers;
+    SocdMode         socd[SOCD_AXES]{};
+    StickShapeTables sticks[STICK_SHAPE_STICKS];
+};
+
+struct ProfileImage
+{
+    std::wstring    name;
+    bool            ownSocd = false;        // false: the live SOCD modes apply
+    bool            ownStickShape = false;  // false: the live stick shaping applies
+    uint64_t        boundAny[4]{};          // HID<256 used by any pad (LL hook)
+    ProfilePadImage pads[BINDINGS_MAX_GAMEPADS];
+};
+
+// What a profile file holds, before compilation.
+struct ProfileSource
+{
+    std::wstring     name;
+    PadBindings      pads[BINDINGS_MAX_GAMEPADS];
+    PadLayers        layers[BINDINGS_MAX_GAMEPADS];
+    bool             hasSocd = false;
+    SocdMode         socd[SOCD_MAX_PADS][SOCD_AXES]{};
+    bool             hasStickShape = false;
+    StickShapeConfig sticks[STICK_SHAPE_MAX_PADS][STICK_SHAPE_STICKS];
+};
+
+std::unique_ptr<ProfileImage> AppProfiles_Compile(const ProfileSource& src);
+
+struct AppProfileRule
+{
+    std::wstring exePattern;   // "game.exe", "*-Win64-Shipping.exe"...
+    std::wstring profile;      // ProfileImage::name
+};
+
+// '*' any run, '?' one character, case-insensitive (ASCII).
+bool AppProfiles_MatchExe(std::wstring_view pattern, std::wstring_view exeName);
+
+// Foreground source. The default (none) never switches; tests and the
+// simulation install a StaticForegroundProvider.
+class IForegroundProvider
+{
+public:
+    virtual ~IForegroundProvider() = default;
+    // File name of the foreground executable ("game.exe"); false if unknown.
+    virtual bool ForegroundExe(std::wstring& exeName) = 0;
+};
+
+class StaticForegroundProvider : public IForegroundProvider
+{
+public:
+    bool ForegroundExe(std::wstring& exeName) override { exeName = m_exe; return !m_exe.empty(); }
+    void Set(std::wstring exe) { m_exe = std::move(exe); }
+
+private:
+    std::wstring m_exe;
+};
+
+// ---- Control side (UI thread) ----
+// Replaces the profile set, then re-picks the image for the current foreground.
+// Rules naming an unknown profile are ignored.
+void AppProfiles_SetProfiles(std::vector<std::unique_ptr<ProfileImage>> images, std::vector<AppProfileRule> rules);
+void AppProfiles_SetForegroundProvider(IForegroundProvider* provider);
+// Asks the provider and swaps the active image if the match changed.
+void AppProfiles_OnForegroundChanged();
+// Empty: no app profile, the live state applies.
+std::wstring AppProfiles_ActiveName();
+
+// ---- Realtime thread ----
+// Once at the start of a tick: the image of the whole tick (nullptr = live state).
+const ProfileImage* AppProfiles_BeginTick();
+
+// ---- Any thread ----
+// Bound in the active image, or in the live bindings / layers without one.
+bool AppProfiles_IsHidBound(uint16_t hid);
+
+struct AppProfilesStats
+{
+    uint32_t profiles = 0;
+    uint32_t rules = 0;
+    uint64_t foregroundChanges = 0;
+    uint64_t switches = 0;        // active image actually replaced
+    uint32_t retiredPending = 0;  // replaced sets waiting for the realtime thread
+};
+
+void AppProfiles_GetStats(AppProfilesStats* out);
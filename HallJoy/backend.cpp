@@ -15,10 +15,7 @@
 #include <cstdint>
 #include <cstdlib>
 #include <mutex>
-
-#if defined(_MSC_VER)
-#include <intrin.h>
-#endif
+#include <thread>
 
 #include <ViGEm/Client.h>
 #include "wooting-analog-wrapper.h"
@@ -27,6 +24,21 @@
 #include "bindings.h"
 #include "settings.h"
 #include "key_settings.h"
+#include "actuation.h"
+#include "analog_trigger.h"
+#include "combo_timer.h"   // ComboTimer_NowUs: same time base as the combo engine
+#include "input_thread.h"
+#include "macro_recorder.h"
+#include "socd.h"
+#include "stick_shape.h"
+#include "app_profiles.h"
+#include "analog_devices.h"
+#include "binding_layers.h"
+#include "pad_workers.h"
+#include "pad_sink.h"
+#include "vigem_pad_sink.h"
+#include "mouse_output.h"
+#include "sendinput_sink.h"
 
 #include "curve_math.h"
 
@@ -50,15 +62,66 @@ static float wooting_analog_read_analog_safe(unsigned short code)
     return wooting_analog_read_analog(code);
 }
 
+// Per-device input (analog_devices.h): device list and one bulk read per
+// device and tick, same mutex as every other SDK call.
+class WootingAnalogSource final : public IAnalogSource
+{
+public:
+    int Devices(AnalogDeviceInfo* out, int max) override
+    {
+        WootingAnalog_DeviceInfo_FFI* infos[ANALOG_MAX_DEVICES * 2]{};
+        max = std::clamp(max, 0, (int)std::size(infos));
+
+        std::lock_guard<std::mutex> lock(g_wootingMutex);
+        const int n = wooting_analog_get_connected_devices_info(infos, (unsigned int)max);
+        if (n < 0) return -1;
+        // The SDK owns the infos until the next call: copied under the lock
+        for (int i = 0; i < n && i < max; ++i)
+        {
+            out[i] = AnalogDeviceInfo{};
+            if (!infos[i]) continue;
+            out[i].id = infos[i]->device_id;
+            out[i].vendorId = infos[i]->vendor_id;
+            out[i].productId = infos[i]->product_id;
+            if (infos[i]->device_name)
+                strncpy_s(out[i].name, infos[i]->device_name, _TRUNCATE);
+        }
+        return std::min(n, max);
+    }
+
+    int ReadDevice(uint64_t id, uint16_t* hids, float* depths, int max) override
+    {
+        std::lock_guard<std::mutex> lock(g_wootingMutex);
+        return wooting_analog_read_full_buffer_device(hids, depths, (unsigned int)max, (WootingAnalog_DeviceID)id);
+    }
+};
+
+static WootingAnalogSource g_wootingSource;
+// Devices read this tick: key reads come from their snapshot, not from the SDK
+static bool g_deviceInput = false;
+
+// Depth of one key from the hardware: the device snapshot when there is one
+// (pad >= 0: that pad's view under the PerPad policy), the SDK's merged read
+// otherwise.
+static float ReadAnalogHw(uint16_t hidKeycode, int pad)
+{
+    if (g_deviceInput && hidKeycode < 256) return AnalogDevices_Depth(pad, hidKeycode);
+    return wooting_analog_read_analog_safe(hidKeycode);
+}
+
 // ---------------------------------------------------------------
 
-static PVIGEM_CLIENT g_client = nullptr;
-static constexpr int kMaxVirtualPads = 4;
-static std::array<PVIGEM_TARGET, kMaxVirtualPads> g_pads{};
+static constexpr int kMaxVirtualPads = BINDINGS_MAX_GAMEPADS;
+static_assert(kMaxVirtualPads <= PAD_SINK_MAX_PADS, "every virtual pad has a sink pad");
+// Output: ViGEm unless a sink was installed (Backend_SetPadSink)
+static VigemPadSink g_vigemSink;
+static IPadSink* g_sink = &g_vigemSink;
+static PadSinkStats g_sinkStats;            // realtime thread
+static std::mutex g_sinkStatsMutex;         // published copy, for the UI
+static PadSinkStats g_sinkStatsPublished;
 static std::atomic<int> g_virtualPadCount{ 1 };
 static std::atomic<bool> g_virtualPadsEnabled{ true };
 static std::atomic<bool> g_remapEnabled{ true };        // F1: Remap Toggle
-static int g_connectedPadCount = 0;
 
 static std::array<XUSB_REPORT, kMaxVirtualPads> g_reports{};
 static std::array<XUSB_REPORT, kMaxVirtualPads> g_lastSentReports{};
@@ -209,44 +272,30 @@ static float ApplyCurveByHid(uint16_t hid, float x01Raw)
 
 static void Vigem_Destroy()
 {
-    if (g_client)
-    {
-        for (int i = 0; i < g_connectedPadCount; ++i)
-        {
-            if (g_pads[(size_t)i])
-            {
-                vigem_target_remove(g_client, g_pads[(size_t)i]);
-                vigem_target_free(g_pads[(size_t)i]);
-                g_pads[(size_t)i] = nullptr;
-            }
-        }
-    }
-    g_connectedPadCount = 0;
+    g_sink->Disconnect();
     for (int i = 0; i < kMaxVirtualPads; ++i) g_lastSentValid[(size_t)i] = 0;
-    if (g_client) { vigem_disconnect(g_client); vigem_free(g_client); g_client = nullptr; }
 }
 
 static bool Vigem_Create(int padCount, VIGEM_ERROR* outErr)
 {
     padCount = std::clamp(padCount, 1, kMaxVirtualPads);
-    if (outErr) *outErr = VIGEM_ERROR_NONE;
-    g_client = vigem_alloc();
-    if (!g_client) { if (outErr) *outErr = VIGEM_ERROR_BUS_NOT_FOUND; return false; }
-    VIGEM_ERROR err = vigem_connect(g_client);
-    if (!VIGEM_SUCCESS(err)) { if (outErr) *outErr = err; vigem_free(g_client); g_client = nullptr; return false; }
-
-    g_connectedPadCount = 0;
-    for (int i = 0; i < padCount; ++i)
-    {
-        PVIGEM_TARGET pad = vigem_target_x360_alloc();
-        if (!pad) { if (outErr) *outErr = VIGEM_ERROR_INVALID_TARGET; Vigem_Destroy(); return false; }
-        err = vigem_target_add(g_client, pad);
-        if (!VIGEM_SUCCESS(err)) { if (outErr) *outErr = err; vigem_target_free(pad); Vigem_Destroy(); return false; }
-        g_pads[(size_t)i] = pad;
-        g_connectedPadCount = i + 1;
-    }
-    if (outErr) *outErr = VIGEM_ERROR_NONE;
-    return true;
+    int err = VIGEM_ERROR_NONE;
+    const bool ok = g_sink->Connect(padCount, &err);
+    if (outErr) *outErr = ok ? VIGEM_ERROR_NONE : (VIGEM_ERROR)err;
+    return ok;
+}
+
+static PadReport ToPadReport(const XUSB_REPORT& r)
+{
+    PadReport p;
+    p.buttons = r.wButtons;
+    p.leftTrigger = r.bLeftTrigger;
+    p.rightTrigger = r.bRightTrigger;
+    p.lx = r.sThumbLX;
+    p.ly = r.sThumbLY;
+    p.rx = r.sThumbRX;
+    p.ry = r.sThumbRY;
+    return p;
 }
 
 static bool Vigem_ReconnectThrottled(bool force = false)
@@ -280,6 +329,7 @@ struct HidCache
     std::array<float, 256> filtered{};
     std::bitset<256> hasRaw{};
     std::bitset<256> hasFiltered{};
+    int pad = -1;   // PerPad policy: the pad whose device is read
 };
 
 static float ReadRaw01Cached(uint16_t hidKeycode, HidCache& cache)
@@ -292,7 +342,7 @@ static float ReadRaw01Cached(uint16_t hidKeycode, HidCache& cache)
             return cache.raw[hidKeycode];
 
         // FIX : appel via wooting_analog_read_analog_safe (mutex protégé)
-        float vHw = wooting_analog_read_analog_safe(hidKeycode);
+        float vHw = ReadAnalogHw(hidKeycode, cache.pad);
         if (!std::isfinite(vHw)) vHw = 0.0f;
         vHw = Clamp01(vHw);
         if (vHw > 0.001f) {
@@ -331,11 +381,18 @@ static float ReadRaw01Cached(uint16_t hidKeycode, HidCache& cache)
     }
 
     // FIX : appel via wooting_analog_read_analog_safe (mutex protégé)
-    float v = wooting_analog_read_analog_safe(hidKeycode);
+    float v = ReadAnalogHw(hidKeycode, cache.pad);
     if (!std::isfinite(v)) v = 0.0f;
     return Clamp01(v);
 }
 
+// AnalogTrigger_Evaluate callback: raw depth, same value as g_uiRawM
+static uint16_t ReadRawMilliForTrigger(void* user, uint16_t hid)
+{
+    float raw = ReadRaw01Cached(hid, *static_cast<HidCache*>(user));
+    return (uint16_t)std::clamp((int)std::lround(raw * 1000.0f), 0, 1000);
+}
+
 static float ReadRaw01Hardware(uint16_t hidKeycode, HidCache& cache)
 {
     if (hidKeycode == 0) return 0.0f;
@@ -346,7 +403,7 @@ static float ReadRaw01Hardware(uint16_t hidKeycode, HidCache& cache)
             return cache.raw[hidKeycode];
 
         // FIX : appel via wooting_analog_read_analog_safe (mutex protégé)
-        float v = wooting_analog_read_analog_safe(hidKeycode);
+        float v = ReadAnalogHw(hidKeycode, cache.pad);
         if (!std::isfinite(v)) v = 0.0f;
         v = Clamp01(v);
         cache.raw[hidKeycode] = v;
@@ -355,7 +412,7 @@ static float ReadRaw01Hardware(uint16_t hidKeycode, HidCache& cache)
     }
 
     // FIX : appel via wooting_analog_read_analog_safe (mutex protégé)
-    float v = wooting_analog_read_analog_safe(hidKeycode);
+    float v = ReadAnalogHw(hidKeycode, cache.pad);
     if (!std::isfinite(v)) v = 0.0f;
     return Clamp01(v);
 }
@@ -378,6 +435,13 @@ static float ReadFiltered01Cached(uint16_t hidKeycode, HidCache& cache)
     return ApplyCurveByHid(hidKeycode, ReadRaw01Cached(hidKeycode, cache));
 }
 
+// Actuation_Update callback: depth after the key's curve, the value buttons used to compare to 0.10
+static uint16_t ReadFilteredMilliForActuation(void* user, uint16_t hid)
+{
+    float filtered = ReadFiltered01Cached(hid, *static_cast<HidCache*>(user));
+    return (uint16_t)std::clamp((int)(filtered * 1000.0f), 0, 1000);
+}
+
 static float ReadFiltered01CachedHardware(uint16_t hidKeycode, HidCache& cache)
 {
     if (hidKeycode == 0) return 0.0f;
@@ -409,19 +473,19 @@ static float ReadFiltered01CachedHardware(uint16_t hidKeycode, HidCache& cache)
 }
 
 // Hardware-only reads sans cache par tick
-static float ReadRaw01Hardware(uint16_t hidKeycode)
+static float ReadRaw01Hardware(uint16_t hidKeycode, int pad)
 {
     if (hidKeycode == 0) return 0.0f;
     // FIX : appel via wooting_analog_read_analog_safe (mutex protégé)
-    float v = wooting_analog_read_analog_safe(hidKeycode);
+    float v = ReadAnalogHw(hidKeycode, pad);
     if (!std::isfinite(v)) v = 0.0f;
     return Clamp01(v);
 }
 
-static float ReadFiltered01Hardware(uint16_t hidKeycode)
+static float ReadFiltered01Hardware(uint16_t hidKeycode, int pad)
 {
     if (hidKeycode == 0) return 0.0f;
-    return ApplyCurveByHid(hidKeycode, ReadRaw01Hardware(hidKeycode));
+    return ApplyCurveByHid(hidKeycode, ReadRaw01Hardware(hidKeycode, pad));
 }
 
 static SHORT StickFromMinus1Plus1(float x)
@@ -436,95 +500,162 @@ static uint8_t TriggerByte01(float v01)
     return (uint8_t)std::lround(v01 * 255.0f);
 }
 
-static bool Pressed(float v01) { return v01 >= 0.10f; }
+static_assert(kMaxVirtualPads == BINDINGS_MAX_GAMEPADS, "app profile images cover every virtual pad");
 
-static std::array<std::array<uint8_t, 4>, kMaxVirtualPads> g_snappyPrevMinusDown{};
-static std::array<std::array<uint8_t, 4>, kMaxVirtualPads> g_snappyPrevPlusDown{};
-static std::array<std::array<int8_t, 4>, kMaxVirtualPads> g_snappyLastDir{};
-static std::array<std::array<float, 4>, kMaxVirtualPads> g_snappyMinusValley{};
-static std::array<std::array<float, 4>, kMaxVirtualPads> g_snappyPlusValley{};
+// Live bindings: the snapshot the UI last published, reloaded on this thread
+// only when an edit moves the generation.
+static BindingsSnapshot g_liveBindings;
+static uint32_t g_liveBindingsGeneration = ~0u;
 
-static int AxisIndexSafe(Axis a)
+static void LiveBindings_RefreshIfChanged()
 {
-    switch (a)
-    {
-    case Axis::LX: return 0; case Axis::LY: return 1;
-    case Axis::RX: return 2; case Axis::RY: return 3;
-    default:       return -1;
-    }
+    const uint32_t gen = Bindings_Generation();
+    if (gen == g_liveBindingsGeneration && g_liveBindings) return;
+    g_liveBindingsGeneration = gen;
+    g_liveBindings = Bindings_Snapshot();
 }
 
-static float AxisValue_WithConflictModes(int padIndex, Axis a, float minusV, float plusV)
+// Layer 0 of this tick: the app profile image when one is active, the live
+// (UI edited) bindings otherwise.
+static void LoadPadBindings(const ProfileImage* img, int padIndex, PadBindings& out)
 {
-    const bool snapStick = Settings_GetSnappyJoystick();
-    const bool lastKeyPriority = Settings_GetLastKeyPriority();
-    if (!snapStick && !lastKeyPriority) return plusV - minusV;
+    if (img) { out = img->pads[padIndex].bindings; return; }
+    Bindings_ReadPad(*g_liveBindings, padIndex, out);
+}
 
-    int idx = AxisIndexSafe(a);
-    if (idx < 0 || idx >= 4) return plusV - minusV;
+// Binding layers: live tables rebuilt on this thread when the layer config
+// changes, app profile images carry their own. Layer state (toggles, held
+// keys) starts over whenever the table it was built on is replaced.
+static std::array<PadLayerTable, kMaxVirtualPads> g_liveLayers{};
+static std::array<PadLayerState, kMaxVirtualPads> g_layerState{};
+static uint32_t g_layerGeneration = ~0u;
+static const ProfileImage* g_layerImage = nullptr;
 
-    bool minusDown = Pressed(minusV);
-    bool plusDown = Pressed(plusV);
+static const PadLayerTable& PadLayerTableFor(const ProfileImage* img, int padIndex)
+{
+    return img ? img->pads[padIndex].layers : g_liveLayers[(size_t)padIndex];
+}
 
-    int p = std::clamp(padIndex, 0, kMaxVirtualPads - 1);
-    bool prevMinus = (g_snappyPrevMinusDown[(size_t)p][idx] != 0);
-    bool prevPlus = (g_snappyPrevPlusDown[(size_t)p][idx] != 0);
+static void BindingLayers_RefreshIfChanged(const ProfileImage* img)
+{
+    const uint32_t gen = BindingLayers_ConfigGeneration();
+    if (gen == g_layerGeneration && img == g_layerImage) return;
+
+    if (gen != g_layerGeneration)
+        for (int pad = 0; pad < kMaxVirtualPads; ++pad)
+            BindingLayers_Compile(BindingLayers_GetPad(pad), g_liveLayers[(size_t)pad]);
+    g_layerGeneration = gen;
+    g_layerImage = img;
+    g_layerState = {};
+}
 
-    if (minusDown && !prevMinus) g_snappyLastDir[(size_t)p][idx] = -1;
-    if (plusDown && !prevPlus)  g_snappyLastDir[(size_t)p][idx] = +1;
+// Bindings every report of this tick is built from: layer 0 + active layers.
+static std::array<PadBindings, kMaxVirtualPads> g_tickBase{};
+static std::array<PadBindings, kMaxVirtualPads> g_tickBindings{};
 
-    if (lastKeyPriority)
-    {
-        const float repDelta = std::clamp(Settings_GetLastKeyPrioritySensitivity(), 0.02f, 0.95f);
-
-        if (!minusDown) { g_snappyMinusValley[(size_t)p][idx] = 1.0f; }
-        else if (!prevMinus) { g_snappyMinusValley[(size_t)p][idx] = minusV; }
-        else {
-            float& valley = g_snappyMinusValley[(size_t)p][idx];
-            valley = std::min(valley, minusV);
-            if ((minusV - valley) >= repDelta) { g_snappyLastDir[(size_t)p][idx] = -1; valley = minusV; }
-        }
+// Opposite directions on one axis: one compiled SOCD strategy per pad / axis,
+// rebuilt only when the SOCD modes, the legacy toggles or the app profile change.
+static std::array<std::array<SocdAxis, SOCD_AXES>, kMaxVirtualPads> g_socdAxes{};
+static std::array<std::array<SocdAxisState, SOCD_AXES>, kMaxVirtualPads> g_socdState{};
+static uint64_t g_socdKey = ~0ULL;
+static const ProfileImage* g_socdImage = nullptr;
 
-        if (!plusDown) { g_snappyPlusValley[(size_t)p][idx] = 1.0f; }
-        else if (!prevPlus) { g_snappyPlusValley[(size_t)p][idx] = plusV; }
-        else {
-            float& valley = g_snappyPlusValley[(size_t)p][idx];
-            valley = std::min(valley, plusV);
-            if ((plusV - valley) >= repDelta) { g_snappyLastDir[(size_t)p][idx] = +1; valley = plusV; }
-        }
-    }
+static void Socd_RefreshIfChanged(const ProfileImage* img)
+{
+    if (img && !img->ownSocd) img = nullptr;
 
-    g_snappyPrevMinusDown[(size_t)p][idx] = minusDown ? 1u : 0u;
-    g_snappyPrevPlusDown[(size_t)p][idx] = plusDown ? 1u : 0u;
+    const bool snapStick = Settings_GetSnappyJoystick();
+    const bool lastKeyPriority = Settings_GetLastKeyPriority();
+    const float sensitivity = Settings_GetLastKeyPrioritySensitivity();
+    const uint64_t key = ((uint64_t)Socd_ConfigGeneration() << 32)
+        | ((uint64_t)lroundf(sensitivity * 1000.0f) << 2)
+        | (lastKeyPriority ? 2u : 0u) | (snapStick ? 1u : 0u);
+    if (key == g_socdKey && img == g_socdImage) return;
+    g_socdKey = key;
+    g_socdImage = img;
+
+    for (int pad = 0; pad < kMaxVirtualPads; ++pad)
+        for (int axis = 0; axis < SOCD_AXES; ++axis)
+            g_socdAxes[(size_t)pad][(size_t)axis] =
+                Socd_Compile(img ? img->pads[pad].socd[axis] : Socd_GetMode(pad, axis), snapStick, lastKeyPriority, sensitivity);
+}
 
-    float maxV = std::max(minusV, plusV);
-    if (maxV <= 0.0001f) return 0.0f;
+static float AxisValue_WithConflictModes(int padIndex, Axis a, float minusV, float plusV)
+{
+    const int idx = (int)a;
+    if (idx < 0 || idx >= SOCD_AXES) return plusV - minusV;
 
-    if (lastKeyPriority)
+    const size_t p = (size_t)std::clamp(padIndex, 0, kMaxVirtualPads - 1);
+    return Socd_Resolve(g_socdState[p][(size_t)idx], g_socdAxes[p][(size_t)idx], minusV, plusV);
+}
+
+// 2D stick shaping tables (~5 KB per stick), rebuilt on this thread when the
+// shaping config changes.
+static std::array<std::array<StickShapeTables, STICK_SHAPE_STICKS>, kMaxVirtualPads> g_stickShapes{};
+static uint32_t g_stickShapeGeneration = ~0u;
+
+static void StickShape_RefreshIfChanged()
+{
+    const uint32_t gen = StickShape_ConfigGeneration();
+    if (gen == g_stickShapeGeneration) return;
+    g_stickShapeGeneration = gen;
+
+    for (int pad = 0; pad < kMaxVirtualPads; ++pad)
+        for (int stick = 0; stick < STICK_SHAPE_STICKS; ++stick)
+            StickShape_Compile(StickShape_Get(pad, stick), g_stickShapes[(size_t)pad][(size_t)stick]);
+}
+
+// Mouse output (mouse_output.h): config copy, remainders and clock of the
+// realtime thread. SendInput unless a sink was installed (Backend_SetMouseSink).
+static SendInputMouseSink g_sendInputMouse;
+static IMouseSink* g_mouseSink = &g_sendInputMouse;
+static MouseOutConfig g_mouseCfg;
+static uint32_t g_mouseGeneration = ~0u;
+static MouseOutAccum g_mouseAcc;
+static uint64_t g_mouseLastUs = 0;
+
+// After the pad reports are built, before they are sent: a consumed stick
+// goes out centred (the UI still shows it). One sink call per tick at most.
+static void MouseOutput_Tick(HidCache& cache, bool remapOn)
+{
+    const uint32_t gen = MouseOut_ConfigGeneration();
+    if (gen != g_mouseGeneration)
     {
-        if (minusDown && !plusDown) return -minusV;
-        if (plusDown && !minusDown) return +plusV;
+        g_mouseGeneration = gen;
+        g_mouseCfg = MouseOut_Get();
     }
 
-    if (lastKeyPriority && minusDown && plusDown)
+    const uint64_t nowUs = ComboTimer_NowUs();
+    const float dt = g_mouseLastUs ? (float)(nowUs - g_mouseLastUs) * 1e-6f : 0.0f;
+    g_mouseLastUs = nowUs;
+
+    const MouseOutConfig& cfg = g_mouseCfg;
+    if (!cfg.enabled || !remapOn)
     {
-        int8_t dir = g_snappyLastDir[(size_t)p][idx];
-        if (dir == 0) dir = (plusV >= minusV) ? +1 : -1;
-        float mag = snapStick ? maxV : ((dir > 0) ? plusV : minusV);
-        return (dir > 0) ? +mag : -mag;
+        g_mouseAcc = MouseOutAccum{};
+        return;
     }
 
-    if (snapStick)
+    auto key = [&](MouseOutKey k) { return ReadFiltered01Cached(cfg.keys[(int)k], cache); };
+    MouseOutInput in;
+    in.x = key(MouseOutKey::Right) - key(MouseOutKey::Left);
+    in.y = key(MouseOutKey::Down) - key(MouseOutKey::Up);
+    in.wheel = key(MouseOutKey::WheelUp) - key(MouseOutKey::WheelDown);
+
+    if (cfg.stickPad >= 0 && cfg.stickPad < kMaxVirtualPads)
     {
-        constexpr float EQ_EPS = 0.002f;
-        float d = plusV - minusV;
-        if (std::fabs(d) > EQ_EPS) return (d > 0.0f) ? +maxV : -maxV;
-        if (g_snappyLastDir[(size_t)p][idx] > 0) return +maxV;
-        if (g_snappyLastDir[(size_t)p][idx] < 0) return -maxV;
-        return 0.0f;
+        XUSB_REPORT& r = g_reports[(size_t)cfg.stickPad];
+        SHORT& sx = cfg.stick ? r.sThumbRX : r.sThumbLX;
+        SHORT& sy = cfg.stick ? r.sThumbRY : r.sThumbLY;
+        in.x += (float)sx / 32767.0f;
+        in.y -= (float)sy / 32767.0f;   // XInput up is positive, screen down
+        if (cfg.consumeStick) { sx = 0; sy = 0; }
     }
+    in.x = std::clamp(in.x, -1.0f, 1.0f);
+    in.y = std::clamp(in.y, -1.0f, 1.0f);
 
-    return plusV - minusV;
+    const MouseOutMove move = MouseOut_Step(cfg, g_mouseAcc, in, dt);
+    if (move.Any()) MouseOut_RecordMove(move, g_mouseSink->Move(move));
 }
 
 static void SetBtn(XUSB_REPORT& report, WORD mask, bool down)
@@ -533,41 +664,48 @@ static void SetBtn(XUSB_REPORT& report, WORD mask, bool down)
     else      report.wButtons &= ~mask;
 }
 
-static bool BtnPressedFromMask(int padIndex, GameButton b, HidCache& cache)
+// Digital key state comes from the actuation state machine (per-key actuation
+// point / rapid trigger), updated earlier in the same tick: one AND per chunk.
+// Zone each zoned key was in on the previous tick (hysteresis), per pad / HID.
+static std::array<std::array<uint8_t, 256>, kMaxVirtualPads> g_zoneLevel{};
+
+// Buttons held by the depth zones of the pad's keys.
+static uint16_t ZoneButtonsForPad(const PadBindings& pb, int padIndex, HidCache& cache)
 {
+    uint16_t buttons = 0;
+    auto& levels = g_zoneLevel[(size_t)padIndex];
+    for (int i = 0; i < pb.zones.keyCount; ++i)
+    {
+        const ZoneKey& k = pb.zones.keys[i];
+        const uint16_t depth = ReadFilteredMilliForActuation(&cache, k.hid);
+        const int level = Bindings_ZoneLevel(k, depth, levels[k.hid]);
+        levels[k.hid] = (uint8_t)level;
+        if (level) buttons |= k.buttons[level - 1];
+    }
+    return buttons;
+}
+
+static bool BtnPressedFromMask(const PadBindings& pb, const uint64_t (&down)[4], uint16_t zoneButtons, GameButton b)
+{
+    if (zoneButtons & (1u << (int)b)) return true;
+
     for (int chunk = 0; chunk < 4; ++chunk)
     {
-        uint64_t bits = Bindings_GetButtonMaskChunkForPad(padIndex, b, chunk);
-        if (!bits) continue;
-#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
-        while (bits) {
-            unsigned long idx = 0;
-            _BitScanForward64(&idx, bits);
-            bits &= (bits - 1);
-            uint16_t hid = (uint16_t)(chunk * 64 + (int)idx);
-            if (Pressed(ReadFiltered01Cached(hid, cache))) return true;
-        }
-#else
-        for (int bit = 0; bit < 64; ++bit) {
-            if (bits & (1ULL << bit)) {
-                uint16_t hid = (uint16_t)(chunk * 64 + bit);
-                if (Pressed(ReadFiltered01Cached(hid, cache))) return true;
-            }
-        }
-#endif
+        uint64_t bits = pb.buttons[(int)b][chunk];
+        if (bits & down[chunk]) return true;
     }
     return false;
 }
 
-static XUSB_REPORT BuildReportForPad(int padIndex, HidCache& cache)
+static XUSB_REPORT BuildReportForPad(const ProfileImage* img, const PadBindings& pb, int padIndex, HidCache& cache)
 {
     XUSB_REPORT report{};
     report.wButtons = 0;
 
-    auto applyAxis = [&](Axis a, SHORT& out) {
-        AxisBinding b = Bindings_GetAxisForPad(padIndex, a);
-        float minusV = ReadFiltered01Hardware(b.minusHid);
-        float plusV = ReadFiltered01Hardware(b.plusHid);
+    auto applyAxis = [&](Axis a) -> float {
+        AxisBinding b = pb.axes[(int)a];
+        float minusV = ReadFiltered01Hardware(b.minusHid, cache.pad);
+        float plusV = ReadFiltered01Hardware(b.plusHid, cache.pad);
         {
             char dbg[160];
             _snprintf_s(dbg, sizeof(dbg), _TRUNCATE,
@@ -575,36 +713,94 @@ static XUSB_REPORT BuildReportForPad(int padIndex, HidCache& cache)
                 padIndex, (int)a, (unsigned int)b.minusHid, minusV, (unsigned int)b.plusHid, plusV);
             OutputDebugStringA(dbg);
         }
-        out = StickFromMinus1Plus1(AxisValue_WithConflictModes(padIndex, a, minusV, plusV));
+        return AxisValue_WithConflictModes(padIndex, a, minusV, plusV);
         };
 
-    applyAxis(Axis::LX, report.sThumbLX);
-    applyAxis(Axis::LY, report.sThumbLY);
-    applyAxis(Axis::RX, report.sThumbRX);
-    applyAxis(Axis::RY, report.sThumbRY);
-
-    report.bLeftTrigger = TriggerByte01(ReadFiltered01Cached(Bindings_GetTriggerForPad(padIndex, Trigger::LT), cache));
-    report.bRightTrigger = TriggerByte01(ReadFiltered01Cached(Bindings_GetTriggerForPad(padIndex, Trigger::RT), cache));
-
-    SetBtn(report, XUSB_GAMEPAD_A, BtnPressedFromMask(padIndex, GameButton::A, cache));
-    SetBtn(report, XUSB_GAMEPAD_B, BtnPressedFromMask(padIndex, GameButton::B, cache));
-    SetBtn(report, XUSB_GAMEPAD_X, BtnPressedFromMask(padIndex, GameButton::X, cache));
-    SetBtn(report, XUSB_GAMEPAD_Y, BtnPressedFromMask(padIndex, GameButton::Y, cache));
-    SetBtn(report, XUSB_GAMEPAD_LEFT_SHOULDER, BtnPressedFromMask(padIndex, GameButton::LB, cache));
-    SetBtn(report, XUSB_GAMEPAD_RIGHT_SHOULDER, BtnPressedFromMask(padIndex, GameButton::RB, cache));
-    SetBtn(report, XUSB_GAMEPAD_BACK, BtnPressedFromMask(padIndex, GameButton::Back, cache));
-    SetBtn(report, XUSB_GAMEPAD_START, BtnPressedFromMask(padIndex, GameButton::Start, cache));
-    SetBtn(report, XUSB_GAMEPAD_GUIDE, BtnPressedFromMask(padIndex, GameButton::Guide, cache));
-    SetBtn(report, XUSB_GAMEPAD_LEFT_THUMB, BtnPressedFromMask(padIndex, GameButton::LS, cache));
-    SetBtn(report, XUSB_GAMEPAD_RIGHT_THUMB, BtnPressedFromMask(padIndex, GameButton::RS, cache));
-    SetBtn(report, XUSB_GAMEPAD_DPAD_UP, BtnPressedFromMask(padIndex, GameButton::DpadUp, cache));
-    SetBtn(report, XUSB_GAMEPAD_DPAD_DOWN, BtnPressedFromMask(padIndex, GameButton::DpadDown, cache));
-    SetBtn(report, XUSB_GAMEPAD_DPAD_LEFT, BtnPressedFromMask(padIndex, GameButton::DpadLeft, cache));
-    SetBtn(report, XUSB_GAMEPAD_DPAD_RIGHT, BtnPressedFromMask(padIndex, GameButton::DpadRight, cache));
+    // Both axes of a stick go through the 2D shaping stage together
+    const size_t p = (size_t)std::clamp(padIndex, 0, kMaxVirtualPads - 1);
+    float lx = applyAxis(Axis::LX), ly = applyAxis(Axis::LY);
+    float rx = applyAxis(Axis::RX), ry = applyAxis(Axis::RY);
+    const StickShapeTables* sticks = (img && img->ownStickShape) ? img->pads[p].sticks : g_stickShapes[p].data();
+    StickShape_Apply(sticks[0], lx, ly);
+    StickShape_Apply(sticks[1], rx, ry);
+    report.sThumbLX = StickFromMinus1Plus1(lx);
+    report.sThumbLY = StickFromMinus1Plus1(ly);
+    report.sThumbRX = StickFromMinus1Plus1(rx);
+    report.sThumbRY = StickFromMinus1Plus1(ry);
+
+    report.bLeftTrigger = TriggerByte01(ReadFiltered01Cached(pb.triggers[(int)Trigger::LT], cache));
+    report.bRightTrigger = TriggerByte01(ReadFiltered01Cached(pb.triggers[(int)Trigger::RT], cache));
+
+    const uint16_t zoneButtons = ZoneButtonsForPad(pb, (int)p, cache);
+    // Shared actuation state; PerPad policy: only the keys of this pad's device
+    uint64_t down[4];
+    for (int chunk = 0; chunk < 4; ++chunk)
+        down[chunk] = Actuation_DownChunk(chunk) & AnalogDevices_PadKeysChunk(cache.pad, chunk);
+    SetBtn(report, XUSB_GAMEPAD_A, BtnPressedFromMask(pb, down, zoneButtons, GameButton::A));
+    SetBtn(report, XUSB_GAMEPAD_B, BtnPressedFromMask(pb, down, zoneButtons, GameButton::B));
+    SetBtn(report, XUSB_GAMEPAD_X, BtnPressedFromMask(pb, down, zoneButtons, GameButton::X));
+    SetBtn(report, XUSB_GAMEPAD_Y, BtnPressedFromMask(pb, down, zoneButtons, GameButton::Y));
+    SetBtn(report, XUSB_GAMEPAD_LEFT_SHOULDER, BtnPressedFromMask(pb, down, zoneButtons, GameButton::LB));
+    SetBtn(report, XUSB_GAMEPAD_RIGHT_SHOULDER, BtnPressedFromMask(pb, down, zoneButtons, GameButton::RB));
+    SetBtn(report, XUSB_GAMEPAD_BACK, BtnPressedFromMask(pb, down, zoneButtons, GameButton::Back));
+    SetBtn(report, XUSB_GAMEPAD_START, BtnPressedFromMask(pb, down, zoneButtons, GameButton::Start));
+    SetBtn(report, XUSB_GAMEPAD_GUIDE, BtnPressedFromMask(pb, down, zoneButtons, GameButton::Guide));
+    SetBtn(report, XUSB_GAMEPAD_LEFT_THUMB, BtnPressedFromMask(pb, down, zoneButtons, GameButton::LS));
+    SetBtn(report, XUSB_GAMEPAD_RIGHT_THUMB, BtnPressedFromMask(pb, down, zoneButtons, GameButton::RS));
+    SetBtn(report, XUSB_GAMEPAD_DPAD_UP, BtnPressedFromMask(pb, down, zoneButtons, GameButton::DpadUp));
+    SetBtn(report, XUSB_GAMEPAD_DPAD_DOWN, BtnPressedFromMask(pb, down, zoneButtons, GameButton::DpadDown));
+    SetBtn(report, XUSB_GAMEPAD_DPAD_LEFT, BtnPressedFromMask(pb, down, zoneButtons, GameButton::DpadLeft));
+    SetBtn(report, XUSB_GAMEPAD_DPAD_RIGHT, BtnPressedFromMask(pb, down, zoneButtons, GameButton::DpadRight));
 
     return report;
 }
 
+// One pad's report of the tick, published for the UI. With enough pads the
+// reports are built on the pad workers: everything written here belongs to
+// the pad, and a pad reading the shared key cache works on its own copy.
+struct PadReportJob
+{
+    const ProfileImage* profile = nullptr;
+    HidCache* cache = nullptr;
+    bool remapOn = true;
+    bool perPadInput = false;
+    bool parallel = false;
+};
+
+static void BuildPadReport(void* user, int pad)
+{
+    const PadReportJob& job = *static_cast<const PadReportJob*>(user);
+
+    // F1: remap OFF → rapport vide
+    XUSB_REPORT report{};
+    if (job.remapOn)
+    {
+        const PadBindings& pb = g_tickBindings[(size_t)pad];
+        if (job.perPadInput)
+        {
+            // PerPad device policy: every pad reads its own keyboard
+            HidCache padCache;
+            padCache.pad = pad;
+            report = BuildReportForPad(job.profile, pb, pad, padCache);
+        }
+        else if (job.parallel)
+        {
+            HidCache padCache = *job.cache;
+            report = BuildReportForPad(job.profile, pb, pad, padCache);
+        }
+        else
+        {
+            report = BuildReportForPad(job.profile, pb, pad, *job.cache);
+        }
+    }
+
+    g_reports[(size_t)pad] = report;
+    g_lastRX[(size_t)pad].store(report.sThumbRX, std::memory_order_release);
+    g_lastSeq[(size_t)pad].fetch_add(1, std::memory_order_acq_rel);
+    g_lastReport[(size_t)pad] = report;
+    g_lastSeq[(size_t)pad].fetch_add(1, std::memory_order_release);
+}
+
 static bool IsReportSignificantlyDifferent(const XUSB_REPORT& a, const XUSB_REPORT& b)
 {
     if (a.wButtons != b.wButtons) return true;
@@ -719,6 +915,13 @@ bool Backend_Init()
         g_lastSentReports[(size_t)i] = XUSB_REPORT{};
     }
 
+    // Reports of 8+ pads are built in parallel; asleep otherwise. Leave a
+    // core to the UI and one to the input thread.
+    const int cores = (int)std::thread::hardware_concurrency();
+    PadWorkers_Start(std::min(PAD_WORKERS_MAX, cores - 2), [] {
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+        });
+
     return true;
 }
 
@@ -727,6 +930,7 @@ void Backend_Shutdown()
     g_reconnectRequested.store(false, std::memory_order_release);
     g_deviceChangeReconnectRequested.store(false, std::memory_order_release);
     g_vigemUpdateFailStreak = 0;
+    PadWorkers_Stop();
     Vigem_Destroy();
     {
         std::lock_guard<std::mutex> lock(g_wootingMutex);
@@ -770,11 +974,17 @@ void Backend_Tick()
             // FIX WASD lock: reset again after reinit for any residual state
             App_ResetHookKeyDown();
             g_wootingLastInitMs = GetTickCount64();
+            AnalogDevices_RequestRescan();
             OutputDebugStringA("WOOTING_RESTART: Redémarrage OK\n");
         }
     }
 
+    // One bulk read per analog device, before any key is read this tick
+    g_deviceInput = AnalogDevices_Poll(g_wootingSource, GetTickCount64()) > 0;
+
     HidCache cache;
+    // App profile of this tick (nullptr: live bindings), read once
+    const ProfileImage* profile = AppProfiles_BeginTick();
 
     int cnt = std::clamp(g_trackedCount.load(std::memory_order_acquire), 0, 256);
 
@@ -826,18 +1036,67 @@ void Backend_Tick()
         g_bindHadDown.store(false, std::memory_order_relaxed);
     }
 
-    int logicalPads = std::clamp(g_virtualPadCount.load(std::memory_order_acquire), 1, kMaxVirtualPads);
-    const bool remapOn = g_remapEnabled.load(std::memory_order_acquire); // F1
-    for (int pad = 0; pad < logicalPads; ++pad)
+    // Macro recorder: depth of every bound key, queued only when it changes
+    if (MacroRecorder_WantsAnalog())
     {
-        // F1: remap OFF → rapport vide
-        XUSB_REPORT report = remapOn ? BuildReportForPad(pad, cache) : XUSB_REPORT{};
-        g_reports[(size_t)pad] = report;
-        g_lastRX[(size_t)pad].store(report.sThumbRX, std::memory_order_release);
-        g_lastSeq[(size_t)pad].fetch_add(1, std::memory_order_acq_rel);
-        g_lastReport[(size_t)pad] = report;
-        g_lastSeq[(size_t)pad].fetch_add(1, std::memory_order_release);
+        const uint64_t nowUs = ComboTimer_NowUs();
+        for (uint16_t hid = 1; hid < 256; ++hid)
+        {
+            if (AppProfiles_IsHidBound(hid))
+                MacroRecorder_PushAnalog(nowUs, hid, ReadRawMilliForTrigger(&cache, hid));
+        }
+    }
+
+    // Digital state of every key a gamepad button or an Actuation trigger
+    // listens to: per-key actuation point / rapid trigger, all keys at once.
+    {
+        const int pads = std::clamp(g_virtualPadCount.load(std::memory_order_acquire), 1, kMaxVirtualPads);
+        LiveBindings_RefreshIfChanged();
+        BindingLayers_RefreshIfChanged(profile);
+
+        auto& base = g_tickBase;
+        uint64_t keys[4]{};
+        for (int pad = 0; pad < pads; ++pad)
+        {
+            LoadPadBindings(profile, pad, base[(size_t)pad]);
+            for (int b = 0; b < BINDINGS_BUTTON_COUNT; ++b)
+                for (int chunk = 0; chunk < 4; ++chunk)
+                    keys[chunk] |= base[(size_t)pad].buttons[b][chunk];
+            // Layer keys and every HID a layer binds: their state decides the layers
+            const PadLayerTable& lt = PadLayerTableFor(profile, pad);
+            for (int chunk = 0; chunk < 4; ++chunk) keys[chunk] |= lt.layerHids[chunk];
+        }
+        AnalogTrigger_GetActuationKeys(keys);
+        Actuation_Update(keys, ReadFilteredMilliForActuation, &cache);
+
+        // Active layers from the state just computed, then the bindings of the tick
+        uint64_t down[4];
+        for (int chunk = 0; chunk < 4; ++chunk) down[chunk] = Actuation_DownChunk(chunk);
+        for (int pad = 0; pad < pads; ++pad)
+        {
+            const PadLayerTable& lt = PadLayerTableFor(profile, pad);
+            uint64_t padDown[4];
+            for (int chunk = 0; chunk < 4; ++chunk) padDown[chunk] = down[chunk] & AnalogDevices_PadKeysChunk(pad, chunk);
+            const uint8_t active = BindingLayers_Update(lt, g_layerState[(size_t)pad], padDown);
+            BindingLayers_Apply(lt, active, base[(size_t)pad], g_tickBindings[(size_t)pad]);
+        }
     }
+
+    // Combo triggers on depth / velocity / actuation: evaluated on this tick's values,
+    // handed to the input thread through a lock-free queue.
+    if (AnalogTrigger_HasRules())
+    {
+        if (AnalogTrigger_Evaluate(ComboTimer_NowUs(), ReadRawMilliForTrigger, &cache) > 0)
+            InputThread_RequestPump();
+    }
+
+    int logicalPads = std::clamp(g_virtualPadCount.load(std::memory_order_acquire), 1, kMaxVirtualPads);
+    const bool remapOn = g_remapEnabled.load(std::memory_order_acquire); // F1
+    const bool perPadInput = AnalogDevices_PerPad();
+    Socd_RefreshIfChanged(profile);
+    StickShape_RefreshIfChanged();
+    PadReportJob job{ profile, &cache, remapOn, perPadInput, logicalPads >= PAD_WORKERS_MIN_ITEMS && PadWorkers_Count() > 0 };
+    PadWorkers_Run(logicalPads, BuildPadReport, &job);
     for (int pad = logicalPads; pad < kMaxVirtualPads; ++pad)
     {
         XUSB_REPORT report{};
@@ -848,21 +1107,21 @@ void Backend_Tick()
         g_lastSeq[(size_t)pad].fetch_add(1, std::memory_order_release);
     }
 
+    MouseOutput_Tick(cache, remapOn);
+
     if (g_virtualPadsEnabled.load(std::memory_order_acquire))
     {
-        if (g_client && g_connectedPadCount > 0)
+        const int sinkPads = g_sink->Pads();
+        if (sinkPads > 0)
         {
-            VIGEM_ERROR err = VIGEM_ERROR_NONE;
+            int err = VIGEM_ERROR_NONE;
             bool allOk = true;
             DWORD now = GetTickCount();
             constexpr DWORD kMinSendIntervalMs = 4;
             constexpr DWORD kKeepAliveMs = 250;
 
-            for (int i = 0; i < g_connectedPadCount; ++i)
+            for (int i = 0; i < sinkPads; ++i)
             {
-                PVIGEM_TARGET pad = g_pads[(size_t)i];
-                if (!pad) continue;
-
                 int idx = std::clamp(i, 0, kMaxVirtualPads - 1);
                 const XUSB_REPORT& report = g_reports[(size_t)idx];
 
@@ -873,8 +1132,7 @@ void Backend_Tick()
                 if (!changed && elapsed < kKeepAliveMs)      continue;
                 if (changed && elapsed < kMinSendIntervalMs) continue;
 
-                err = vigem_target_x360_update(g_client, pad, report);
-                if (!VIGEM_SUCCESS(err)) { allOk = false; break; }
+                if (!PadSink_Update(*g_sink, idx, ToPadReport(report), &err, g_sinkStats)) { allOk = false; break; }
 
                 g_lastSentReports[(size_t)idx] = report;
                 g_lastSentTicks[(size_t)idx] = now;
@@ -884,7 +1142,7 @@ void Backend_Tick()
             if (!allOk)
             {
                 g_vigemOk.store(false, std::memory_order_release);
-                g_vigemLastErr.store(err, std::memory_order_release);
+                g_vigemLastErr.store((VIGEM_ERROR)err, std::memory_order_release);
                 if (++g_vigemUpdateFailStreak >= 3) { g_vigemUpdateFailStreak = 0; Vigem_ReconnectThrottled(); }
             }
             else
@@ -893,6 +1151,13 @@ void Backend_Tick()
                 g_vigemOk.store(true, std::memory_order_release);
                 g_vigemLastErr.store(VIGEM_ERROR_NONE, std::memory_order_release);
             }
+
+            // UI copy; skipped this tick if the UI holds the lock
+            if (g_sinkStatsMutex.try_lock())
+            {
+                g_sinkStatsPublished = g_sinkStats;
+                g_sinkStatsMutex.unlock();
+            }
         }
         else
         {
@@ -905,12 +1170,33 @@ void Backend_Tick()
     else
     {
         g_vigemUpdateFailStreak = 0;
-        if (g_client || g_connectedPadCount > 0) Vigem_Destroy();
+        if (g_sink->Pads() > 0) Vigem_Destroy();
         g_vigemOk.store(true, std::memory_order_release);
         g_vigemLastErr.store(VIGEM_ERROR_NONE, std::memory_order_release);
     }
 }
 
+void Backend_SetPadSink(IPadSink* sink)
+{
+    IPadSink* next = sink ? sink : &g_vigemSink;
+    if (next == g_sink) return;
+    Vigem_Destroy();
+    g_sink = next;
+    g_sinkStats = PadSinkStats{};
+}
+
+void Backend_SetMouseSink(IMouseSink* sink)
+{
+    g_mouseSink = sink ? sink : &g_sendInputMouse;
+    g_mouseAcc = MouseOutAccum{};
+}
+
+PadSinkStats Backend_GetPadSinkStats()
+{
+    std::lock_guard<std::mutex> lock(g_sinkStatsMutex);
+    return g_sinkStatsPublished;
+}
+
 SHORT Backend_GetLastRX() { return g_lastRX[0].load(std::memory_order_acquire); }
 
 XUSB_REPORT Backend_GetLastReport() { return Backend_GetLastReportForPad(0); }
@@ -62,6 +62,18 @@ struct BackendStatus
 
 BackendStatus Backend_GetStatus();
 
+// Pad output (pad_sink.h). nullptr = ViGEm (default). Call before Backend_Init
+// or after Backend_Shutdown; the current sink is disconnected.
+class IPadSink;
+struct PadSinkStats;
+void Backend_SetPadSink(IPadSink* sink);
+// Write latency of the active sink, as of the last tick that sent something
+PadSinkStats Backend_GetPadSinkStats();
+// Mouse output (mouse_output.h). nullptr = SendInput (default). Same rule:
+// not while the realtime loop runs.
+class IMouseSink;
+void Backend_SetMouseSink(IMouseSink* sink);
+
 // request reconnect attempt on next tick (e.g. on WM_DEVICECHANGE)
 void Backend_NotifyDeviceChange();
 
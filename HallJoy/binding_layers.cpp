@@ -0,0 +1,205 @@
+// binding_layers.cpp
+#include "binding_layers.h"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+
+namespace
+{
+    std::mutex                                       g_mutex;
+    std::array<PadLayers, BINDINGS_MAX_GAMEPADS>     g_pads{};
+    std::atomic<uint32_t>                            g_generation{ 0 };
+    std::array<std::atomic<uint64_t>, 4>             g_boundAny{};   // layerHids of every pad
+}
+
+static bool HasHid(const uint64_t (&mask)[4], uint16_t hid)
+{
+    return hid != 0 && hid < 256 && ((mask[hid / 64] >> (hid % 64)) & 1ULL);
+}
+
+static void MarkHid(uint64_t (&mask)[4], uint16_t hid)
+{
+    if (hid != 0 && hid < 256) mask[hid / 64] |= 1ULL << (hid % 64);
+}
+
+// Every HID<256 a layer binds (axes, triggers, buttons, depth zones).
+static void LayerHids(const PadBindings& b, uint64_t (&out)[4])
+{
+    for (const AxisBinding& a : b.axes) { MarkHid(out, a.minusHid); MarkHid(out, a.plusHid); }
+    for (uint16_t t : b.triggers) MarkHid(out, t);
+    for (const auto& btn : b.buttons)
+        for (int c = 0; c < 4; ++c) out[c] |= btn[c];
+    for (int i = 0; i < b.zones.keyCount; ++i) MarkHid(out, b.zones.keys[i].hid);
+}
+
+static void AddZoneKey(PadZones& z, const ZoneKey& k)
+{
+    if (z.keyCount < BINDINGS_MAX_ZONE_KEYS) z.keys[z.keyCount++] = k;
+}
+
+bool PadLayers::IsEmpty() const
+{
+    if (keyCount) return false;
+    for (const PadBindings& l : layers)
+    {
+        uint64_t m[4]{};
+        LayerHids(l, m);
+        if (m[0] | m[1] | m[2] | m[3]) return false;
+    }
+    return true;
+}
+
+void BindingLayers_Compile(const PadLayers& src, PadLayerTable& out)
+{
+    out = PadLayerTable{};
+
+    for (int i = 0; i < src.keyCount && i < BINDING_LAYER_MAX_KEYS; ++i)
+    {
+        const LayerKey& k = src.keys[i];
+        if (k.hid == 0 || k.hid >= 256 || k.layer < 1 || k.layer >= BINDING_LAYERS) continue;
+        out.keys[out.keyCount++] = k;
+        MarkHid(out.keyHids, k.hid);
+    }
+    if (out.keyCount == 0) return; // no way to reach a layer: layer 0 as is
+
+    uint64_t bound[BINDING_LAYERS - 1][4]{};
+    for (int l = 0; l < BINDING_LAYERS - 1; ++l)
+    {
+        LayerHids(src.layers[l], bound[l]);
+        for (int c = 0; c < 4; ++c) out.layerHids[c] |= bound[l][c] | out.keyHids[c];
+    }
+
+    for (int combo = 0; combo < BINDING_LAYER_COMBOS; ++combo)
+    {
+        LayerOverlay& ov = out.combos[combo];
+        uint64_t claimed[4]{};
+        for (int c = 0; c < 4; ++c) ov.covered[c] = out.keyHids[c];
+
+        // Highest layer first: a HID belongs to the first active layer binding it
+        for (int l = BINDING_LAYERS - 2; l >= 0; --l)
+        {
+            if (!(combo & (1 << l))) continue;
+            const PadBindings& lb = src.layers[l];
+
+            uint64_t take[4];
+            for (int c = 0; c < 4; ++c)
+            {
+                take[c] = bound[l][c] & ~claimed[c] & ~out.keyHids[c];
+                claimed[c] |= take[c];
+                ov.covered[c] |= take[c];
+            }
+
+            for (int b = 0; b < BINDINGS_BUTTON_COUNT; ++b)
+                for (int c = 0; c < 4; ++c)
+                    ov.bind.buttons[b][c] |= lb.buttons[b][c] & take[c];
+
+            // One HID per axis direction / trigger: the highest layer keeps the slot
+            auto slot = [&](uint16_t& dst, uint16_t hid) {
+                if (dst == 0 && hid != 0 && (hid >= 256 || HasHid(take, hid))) dst = hid;
+                };
+            for (int a = 0; a < 4; ++a)
+            {
+                slot(ov.bind.axes[a].minusHid, lb.axes[a].minusHid);
+                slot(ov.bind.axes[a].plusHid, lb.axes[a].plusHid);
+            }
+            for (int t = 0; t < 2; ++t)
+                slot(ov.bind.triggers[t], lb.triggers[t]);
+
+            for (int i = 0; i < lb.zones.keyCount; ++i)
+                if (HasHid(take, lb.zones.keys[i].hid)) AddZoneKey(ov.bind.zones, lb.zones.keys[i]);
+        }
+    }
+}
+
+uint8_t BindingLayers_Update(const PadLayerTable& t, PadLayerState& st, const uint64_t (&down)[4])
+{
+    uint8_t hold = 0;
+    uint8_t keysDown = 0;
+    for (int i = 0; i < t.keyCount; ++i)
+    {
+        const LayerKey& k = t.keys[i];
+        const uint8_t layerBit = (uint8_t)(1u << (k.layer - 1));
+        if (!HasHid(down, k.hid)) continue;
+
+        keysDown |= (uint8_t)(1u << i);
+        if (k.mode == LayerKeyMode::Hold)
+            hold |= layerBit;
+        else if (!(st.keysDown & (1u << i)))
+            st.toggled ^= layerBit;   // press edge
+    }
+    st.keysDown = keysDown;
+    st.active = (uint8_t)((st.toggled | hold) & (BINDING_LAYER_COMBOS - 1));
+    return st.active;
+}
+
+void BindingLayers_Apply(const PadLayerTable& t, uint8_t active, const PadBindings& base, PadBindings& out)
+{
+    if (t.keyCount == 0) { out = base; return; }
+
+    const LayerOverlay& ov = t.combos[active & (BINDING_LAYER_COMBOS - 1)];
+    for (int b = 0; b < BINDINGS_BUTTON_COUNT; ++b)
+        for (int c = 0; c < 4; ++c)
+            out.buttons[b][c] = (base.buttons[b][c] & ~ov.covered[c]) | ov.bind.buttons[b][c];
+
+    auto slot = [&](uint16_t over, uint16_t baseHid) -> uint16_t {
+        if (over) return over;
+        return HasHid(ov.covered, baseHid) ? 0 : baseHid;
+        };
+    for (int a = 0; a < 4; ++a)
+    {
+        out.axes[a].minusHid = slot(ov.bind.axes[a].minusHid, base.axes[a].minusHid);
+        out.axes[a].plusHid = slot(ov.bind.axes[a].plusHid, base.axes[a].plusHid);
+    }
+    for (int i = 0; i < 2; ++i)
+        out.triggers[i] = slot(ov.bind.triggers[i], base.triggers[i]);
+
+    out.zones = ov.bind.zones;
+    for (int i = 0; i < base.zones.keyCount; ++i)
+        if (!HasHid(ov.covered, base.zones.keys[i].hid)) AddZoneKey(out.zones, base.zones.keys[i]);
+}
+
+// ---- Config ----
+void BindingLayers_SetPad(int pad, const PadLayers& layers)
+{
+    if (pad < 0 || pad >= BINDINGS_MAX_GAMEPADS) return;
+
+    std::lock_guard<std::mutex> lk(g_mutex);
+    g_pads[(size_t)pad] = layers;
+
+    uint64_t m[4]{};
+    for (const PadLayers& p : g_pads)
+    {
+        PadLayerTable t;
+        BindingLayers_Compile(p, t);
+        for (int c = 0; c < 4; ++c) m[c] |= t.layerHids[c];
+    }
+    for (int c = 0; c < 4; ++c) g_boundAny[(size_t)c].store(m[c], std::memory_order_relaxed);
+    g_generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+PadLayers BindingLayers_GetPad(int pad)
+{
+    if (pad < 0 || pad >= BINDINGS_MAX_GAMEPADS) return PadLayers{};
+    std::lock_guard<std::mutex> lk(g_mutex);
+    return g_pads[(size_t)pad];
+}
+
+void BindingLayers_ResetAll()
+{
+    std::lock_guard<std::mutex> lk(g_mutex);
+    for (PadLayers& p : g_pads) p = PadLayers{};
+    for (auto& m : g_boundAny) m.store(0, std::memory_order_relaxed);
+    g_generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+uint32_t BindingLayers_ConfigGeneration()
+{
+    return g_generation.load(std::memory_order_acquire);
+}
+
+bool BindingLayers_IsHidBound(uint16_t hid)
+{
+    if (hid == 0 || hid >= 256) return false;
+    return (g_boundAny[hid / 64].load(std::memory_order_relaxed) >> (hid % 64)) & 1ULL;
+}
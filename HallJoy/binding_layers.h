@@ -0,0 +1,90 @@
+// binding_layers.h
+#pragma once
+#include <cstdint>
+
+#include "bindings.h"
+
+// ============================================================
+// BINDING LAYERS
+// Up to 3 layers on top of a pad's bindings (layer 0 = the usual bindings),
+// switched by layer keys:
+// - Hold:   the layer is on while the key is down
+// - Toggle: each press flips the layer
+// A key not bound on a layer is transparent: the highest active layer that
+// binds it decides, then layer 0. Layer keys themselves never drive an
+// output. "Down" is the actuation state (per-key actuation point / rapid
+// trigger) of the same tick, so a layer switch applies on the tick where the
+// key crosses its point.
+// Every combination of active layers (8) is compiled into an overlay: the
+// HIDs it takes from layer 0 and what they do instead. Resolving a pad is
+// then a few ANDs per button chunk whatever the stack depth. Outputs are
+// rebuilt from the held keys every tick: a key released on any layer
+// releases its output, nothing can stay stuck across a switch.
+// Portable (no Win32).
+// ============================================================
+
+constexpr int BINDING_LAYERS = 4;                              // 0 = base
+constexpr int BINDING_LAYER_COMBOS = 1 << (BINDING_LAYERS - 1); // bit l-1 = layer l on
+constexpr int BINDING_LAYER_MAX_KEYS = 8;
+
+enum class LayerKeyMode : uint8_t
+{
+    Hold = 0,
+    Toggle,
+};
+
+struct LayerKey
+{
+    uint16_t     hid = 0;      // 1..255
+    uint8_t      layer = 1;    // 1..BINDING_LAYERS-1
+    LayerKeyMode mode = LayerKeyMode::Hold;
+};
+
+// Layers of one pad as configured.
+struct PadLayers
+{
+    PadBindings layers[BINDING_LAYERS - 1];   // layers 1..3, unbound = transparent
+    LayerKey    keys[BINDING_LAYER_MAX_KEYS];
+    uint8_t     keyCount = 0;
+
+    bool IsEmpty() const;
+};
+
+struct LayerOverlay
+{
+    uint64_t    covered[4]{};  // HIDs taken from layer 0 (bound on an active layer, layer keys)
+    PadBindings bind;          // what the covered HIDs do on their highest active layer
+};
+
+struct PadLayerTable
+{
+    uint8_t      keyCount = 0;              // 0: no layers, layer 0 as is
+    LayerKey     keys[BINDING_LAYER_MAX_KEYS];
+    uint64_t     keyHids[4]{};              // layer keys (actuation has to track them)
+    uint64_t     layerHids[4]{};            // every HID bound on a layer or used as a layer key
+    LayerOverlay combos[BINDING_LAYER_COMBOS];
+};
+
+// Per pad, owned by the realtime thread. Zero = no layer on.
+struct PadLayerState
+{
+    uint8_t toggled = 0;   // layers flipped on by toggle keys
+    uint8_t keysDown = 0;  // bit i = keys[i] down on the previous tick
+    uint8_t active = 0;
+};
+
+// Keys outside 1..255, layers outside 1..3 and keys past the limit are dropped.
+void BindingLayers_Compile(const PadLayers& src, PadLayerTable& out);
+// Active layers from this tick's key state (one bit per HID < 256).
+uint8_t BindingLayers_Update(const PadLayerTable& t, PadLayerState& st, const uint64_t (&down)[4]);
+// Layer 0 with the overlay of the active combination.
+void BindingLayers_Apply(const PadLayerTable& t, uint8_t active, const PadBindings& base, PadBindings& out);
+
+// ---- Config (any thread) ----
+void      BindingLayers_SetPad(int pad, const PadLayers& layers);
+PadLayers BindingLayers_GetPad(int pad);
+void      BindingLayers_ResetAll();
+// Changes with every Set / ResetAll: recompile when it moves.
+uint32_t  BindingLayers_ConfigGeneration();
+// Bound on a configured layer or used as a layer key, any pad (LL hook).
+bool      BindingLayers_IsHidBound(uint16_t hid);
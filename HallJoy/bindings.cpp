@@ -4,6 +4,9 @@
 #include <atomic>
 #include <cstdint>
 #include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #if defined(_MSC_VER)
 #include <intrin.h>
@@ -32,52 +35,154 @@ static bool IsValidPadIndex(int padIndex)
     return padIndex >= 0 && padIndex < BINDINGS_MAX_GAMEPADS;
 }
 
-// Thread-safe storage (backend thread reads, UI thread writes)
-static std::array<std::array<std::atomic<uint32_t>, 4>, BINDINGS_MAX_GAMEPADS> g_axes{};     // packed AxisBinding: minus|plus
-static std::array<std::array<std::atomic<uint16_t>, 2>, BINDINGS_MAX_GAMEPADS> g_triggers{}; // LT,RT
+// Bindings of every pad: one immutable structure-of-arrays block, pad index
+// innermost so one field of all pads is contiguous. Readers (backend, UI, LL
+// hook) load the current block; writers (UI thread, rare) copy it, edit the
+// copy and publish it. Pads past the capacity read as unbound; the capacity
+// grows by 4 when a higher pad is written.
+struct BindingsBlock
+{
+    int pads = 0;
+    std::vector<uint32_t> axes;      // [axis * pads + pad], packed AxisBinding: minus|plus
+    std::vector<uint16_t> triggers;  // [trigger * pads + pad], LT,RT
+    std::vector<uint64_t> buttons;   // [(button * 4 + chunk) * pads + pad], HID 0..255
+    std::vector<PadZones> zones;     // [pad]
+
+    uint32_t& Axis(int pad, int a) { return axes[(size_t)a * pads + pad]; }
+    uint16_t& Trig(int pad, int t) { return triggers[(size_t)t * pads + pad]; }
+    uint64_t& Btn(int pad, int b, int c) { return buttons[((size_t)b * 4 + c) * pads + pad]; }
+    uint32_t Axis(int pad, int a) const { return axes[(size_t)a * pads + pad]; }
+    uint16_t Trig(int pad, int t) const { return triggers[(size_t)t * pads + pad]; }
+    uint64_t Btn(int pad, int b, int c) const { return buttons[((size_t)b * 4 + c) * pads + pad]; }
+};
+
+static std::shared_ptr<BindingsBlock> MakeBlock(int pads)
+{
+    auto blk = std::make_shared<BindingsBlock>();
+    blk->pads = pads;
+    blk->axes.assign((size_t)4 * pads, 0u);
+    blk->triggers.assign((size_t)2 * pads, 0u);
+    blk->buttons.assign((size_t)BINDINGS_BUTTON_COUNT * 4 * pads, 0ull);
+    blk->zones.assign((size_t)pads, PadZones{});
+    return blk;
+}
+
+// Copy with room for at least minPads pads.
+static std::shared_ptr<BindingsBlock> CopyBlock(const BindingsBlock& src, int minPads)
+{
+    if (minPads <= src.pads) return std::make_shared<BindingsBlock>(src);
+
+    auto blk = MakeBlock(std::min(BINDINGS_MAX_GAMEPADS, (minPads + 3) & ~3));
+    for (int pad = 0; pad < src.pads; ++pad)
+    {
+        for (int a = 0; a < 4; ++a) blk->Axis(pad, a) = src.Axis(pad, a);
+        for (int t = 0; t < 2; ++t) blk->Trig(pad, t) = src.Trig(pad, t);
+        for (int b = 0; b < BINDINGS_BUTTON_COUNT; ++b)
+            for (int c = 0; c < 4; ++c) blk->Btn(pad, b, c) = src.Btn(pad, b, c);
+        blk->zones[(size_t)pad] = src.zones[(size_t)pad];
+    }
+    return blk;
+}
+
+static std::atomic<std::shared_ptr<const BindingsBlock>> g_block{ MakeBlock(4) };
+static std::atomic<uint32_t> g_generation{ 0 };
+static std::mutex g_writeMutex;
 
-// Buttons: 14 buttons * 4 chunks (0..255)
-static std::array<std::array<std::array<std::atomic<uint64_t>, 4>, 15>, BINDINGS_MAX_GAMEPADS> g_btnMask{};
 // Pad accent/color identity (1..4), kept separate from pad index so removing a middle pad
 // does not force remaining pads to change visual identity.
 static std::array<int, BINDINGS_MAX_GAMEPADS> g_padStyle{ 1, 2, 3, 4 };
 
 static int ClampStyleVariant(int v) { return std::clamp(v, 1, BINDINGS_MAX_GAMEPADS); }
 
+// Reverse index: bit set => HID<256 is used by any pad (axis/trigger/button/zones).
+// Rebuilt on every write (UI thread, rare) so Bindings_IsHidBound() is a single
+// atomic load from the LL keyboard hook instead of a scan over every pad.
+static std::array<std::atomic<uint64_t>, 4> g_boundAny{};
+
+static void RebuildBoundIndex(const BindingsBlock& blk)
+{
+    uint64_t m[4]{};
+    auto mark = [&](uint16_t hid) {
+        if (hid != 0 && hid < 256) m[hid / 64] |= (1ULL << (hid % 64));
+    };
+
+    for (uint32_t a : blk.axes)
+    {
+        AxisBinding b = UnpackAxis(a);
+        mark(b.minusHid);
+        mark(b.plusHid);
+    }
+    for (uint16_t t : blk.triggers)
+        mark(t);
+    for (size_t i = 0; i < blk.buttons.size(); ++i)
+        m[(i / (size_t)blk.pads) % 4] |= blk.buttons[i];
+    for (const PadZones& z : blk.zones)
+        for (int i = 0; i < z.keyCount; ++i)
+            mark(z.keys[i].hid);
+
+    for (int c = 0; c < 4; ++c)
+        g_boundAny[(size_t)c].store(m[c] & (c == 0 ? ~1ULL : ~0ULL), std::memory_order_release);
+}
+
+// Copy, edit, publish. The edit writes pads below minPads.
+template <class Fn>
+static void EditBlock(int minPads, Fn&& edit)
+{
+    std::lock_guard<std::mutex> lk(g_writeMutex);
+    auto next = CopyBlock(*g_block.load(std::memory_order_acquire), minPads);
+    edit(*next);
+    RebuildBoundIndex(*next);
+    g_block.store(std::move(next), std::memory_order_release);
+    g_generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+BindingsSnapshot Bindings_Snapshot()
+{
+    return g_block.load(std::memory_order_acquire);
+}
+
+uint32_t Bindings_Generation()
+{
+    return g_generation.load(std::memory_order_acquire);
+}
+
+void Bindings_ReadPad(const BindingsBlock& blk, int padIndex, PadBindings& out)
+{
+    out = PadBindings{};
+    if (padIndex < 0 || padIndex >= blk.pads) return;
+
+    for (int a = 0; a < 4; ++a) out.axes[a] = UnpackAxis(blk.Axis(padIndex, a));
+    for (int t = 0; t < 2; ++t) out.triggers[t] = blk.Trig(padIndex, t);
+    for (int b = 0; b < BINDINGS_BUTTON_COUNT; ++b)
+        for (int c = 0; c < 4; ++c) out.buttons[b][c] = blk.Btn(padIndex, b, c);
+    out.zones = blk.zones[(size_t)padIndex];
+}
+
 // ---- Axes ----
 void Bindings_SetAxisMinusForPad(int padIndex, Axis a, uint16_t hid)
 {
     if (!IsValidPadIndex(padIndex)) return;
-    auto& atom = g_axes[(size_t)padIndex][AxisIdx(a)];
-    uint32_t old = atom.load(std::memory_order_relaxed);
-    for (;;)
-    {
-        AxisBinding b = UnpackAxis(old);
-        uint32_t nw = PackAxis(hid, b.plusHid);
-        if (atom.compare_exchange_weak(old, nw, std::memory_order_release, std::memory_order_relaxed))
-            return;
-    }
+    EditBlock(padIndex + 1, [&](BindingsBlock& blk) {
+        uint32_t& p = blk.Axis(padIndex, AxisIdx(a));
+        p = PackAxis(hid, UnpackAxis(p).plusHid);
+        });
 }
 
 void Bindings_SetAxisPlusForPad(int padIndex, Axis a, uint16_t hid)
 {
     if (!IsValidPadIndex(padIndex)) return;
-    auto& atom = g_axes[(size_t)padIndex][AxisIdx(a)];
-    uint32_t old = atom.load(std::memory_order_relaxed);
-    for (;;)
-    {
-        AxisBinding b = UnpackAxis(old);
-        uint32_t nw = PackAxis(b.minusHid, hid);
-        if (atom.compare_exchange_weak(old, nw, std::memory_order_release, std::memory_order_relaxed))
-            return;
-    }
+    EditBlock(padIndex + 1, [&](BindingsBlock& blk) {
+        uint32_t& p = blk.Axis(padIndex, AxisIdx(a));
+        p = PackAxis(UnpackAxis(p).minusHid, hid);
+        });
 }
 
 AxisBinding Bindings_GetAxisForPad(int padIndex, Axis a)
 {
     if (!IsValidPadIndex(padIndex)) return AxisBinding{};
-    uint32_t p = g_axes[(size_t)padIndex][AxisIdx(a)].load(std::memory_order_acquire);
-    return UnpackAxis(p);
+    const BindingsSnapshot blk = Bindings_Snapshot();
+    if (padIndex >= blk->pads) return AxisBinding{};
+    return UnpackAxis(blk->Axis(padIndex, AxisIdx(a)));
 }
 
 void Bindings_SetAxisMinus(Axis a, uint16_t hid) { Bindings_SetAxisMinusForPad(0, a, hid); }
@@ -88,13 +193,15 @@ AxisBinding Bindings_GetAxis(Axis a) { return Bindings_GetAxisForPad(0, a); }
 void Bindings_SetTriggerForPad(int padIndex, Trigger t, uint16_t hid)
 {
     if (!IsValidPadIndex(padIndex)) return;
-    g_triggers[(size_t)padIndex][TrigIdx(t)].store(hid, std::memory_order_release);
+    EditBlock(padIndex + 1, [&](BindingsBlock& blk) { blk.Trig(padIndex, TrigIdx(t)) = hid; });
 }
 
 uint16_t Bindings_GetTriggerForPad(int padIndex, Trigger t)
 {
     if (!IsValidPadIndex(padIndex)) return 0;
-    return g_triggers[(size_t)padIndex][TrigIdx(t)].load(std::memory_order_acquire);
+    const BindingsSnapshot blk = Bindings_Snapshot();
+    if (padIndex >= blk->pads) return 0;
+    return blk->Trig(padIndex, TrigIdx(t));
 }
 
 void Bindings_SetTrigger(Trigger t, uint16_t hid) { Bindings_SetTriggerForPad(0, t, hid); }
@@ -115,7 +222,7 @@ void Bindings_AddButtonHidForPad(int padIndex, GameButton b, uint16_t hid)
     int chunk = 0, bit = 0;
     if (!HidToChunkBit(hid, chunk, bit)) return;
 
-    g_btnMask[(size_t)padIndex][BtnIdx(b)][chunk].fetch_or(1ULL << bit, std::memory_order_release);
+    EditBlock(padIndex + 1, [&](BindingsBlock& blk) { blk.Btn(padIndex, BtnIdx(b), chunk) |= 1ULL << bit; });
 }
 
 void Bindings_RemoveButtonHidForPad(int padIndex, GameButton b, uint16_t hid)
@@ -124,7 +231,7 @@ void Bindings_RemoveButtonHidForPad(int padIndex, GameButton b, uint16_t hid)
     int chunk = 0, bit = 0;
     if (!HidToChunkBit(hid, chunk, bit)) return;
 
-    g_btnMask[(size_t)padIndex][BtnIdx(b)][chunk].fetch_and(~(1ULL << bit), std::memory_order_release);
+    EditBlock(padIndex + 1, [&](BindingsBlock& blk) { blk.Btn(padIndex, BtnIdx(b), chunk) &= ~(1ULL << bit); });
 }
 
 bool Bindings_ButtonHasHidForPad(int padIndex, GameButton b, uint16_t hid)
@@ -133,7 +240,7 @@ bool Bindings_ButtonHasHidForPad(int padIndex, GameButton b, uint16_t hid)
     int chunk = 0, bit = 0;
     if (!HidToChunkBit(hid, chunk, bit)) return false;
 
-    uint64_t m = g_btnMask[(size_t)padIndex][BtnIdx(b)][chunk].load(std::memory_order_acquire);
+    uint64_t m = Bindings_GetButtonMaskChunkForPad(padIndex, b, chunk);
     return (m & (1ULL << bit)) != 0;
 }
 
@@ -141,7 +248,9 @@ uint64_t Bindings_GetButtonMaskChunkForPad(int padIndex, GameButton b, int chunk
 {
     if (!IsValidPadIndex(padIndex)) return 0;
     if (chunk < 0 || chunk >= 4) return 0;
-    return g_btnMask[(size_t)padIndex][BtnIdx(b)][chunk].load(std::memory_order_acquire);
+    const BindingsSnapshot blk = Bindings_Snapshot();
+    if (padIndex >= blk->pads) return 0;
+    return blk->Btn(padIndex, BtnIdx(b), chunk);
 }
 
 void Bindings_AddButtonHid(GameButton b, uint16_t hid) { Bindings_AddButtonHidForPad(0, b, hid); }
@@ -150,11 +259,11 @@ bool Bindings_ButtonHasHid(GameButton b, uint16_t hid) { return Bindings_ButtonH
 uint64_t Bindings_GetButtonMaskChunk(GameButton b, int chunk) { return Bindings_GetButtonMaskChunkForPad(0, b, chunk); }
 
 // Legacy: return lowest HID set, or 0
-static uint16_t FindLowestHidInMask(const std::array<std::atomic<uint64_t>, 4>& m)
+static uint16_t FindLowestHidInMask(const uint64_t (&m)[4])
 {
     for (int chunk = 0; chunk < 4; ++chunk)
     {
-        uint64_t v = m[chunk].load(std::memory_order_acquire);
+        uint64_t v = m[chunk];
         if (!v) continue;
 
 #if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
@@ -173,87 +282,218 @@ static uint16_t FindLowestHidInMask(const std::array<std::atomic<uint64_t>, 4>&
 uint16_t Bindings_GetButtonForPad(int padIndex, GameButton b)
 {
     if (!IsValidPadIndex(padIndex)) return 0;
-    return FindLowestHidInMask(g_btnMask[(size_t)padIndex][BtnIdx(b)]);
+    const BindingsSnapshot blk = Bindings_Snapshot();
+    if (padIndex >= blk->pads) return 0;
+    uint64_t m[4];
+    for (int c = 0; c < 4; ++c) m[c] = blk->Btn(padIndex, BtnIdx(b), c);
+    return FindLowestHidInMask(m);
 }
 
 uint16_t Bindings_GetButton(GameButton b) { return Bindings_GetButtonForPad(0, b); }
 
-// ---- Clear HID from everywhere ----
-void Bindings_ClearHidForPad(int padIndex, uint16_t hid)
+// ---- Depth zones ----
+bool Bindings_SanitizeZoneKey(ZoneKey& key)
 {
-    if (!IsValidPadIndex(padIndex)) return;
-    if (!hid) return;
+    struct Zone { uint16_t t; uint16_t buttons; };
+    Zone z[BINDINGS_MAX_ZONES]{};
+    int n = 0;
+    for (int i = 0; i < key.count && i < BINDINGS_MAX_ZONES; ++i)
+    {
+        if (key.thresholdM[i] < 1 || key.thresholdM[i] > 1000) continue;
+        z[n++] = { key.thresholdM[i], (uint16_t)(key.buttons[i] & ((1u << BINDINGS_BUTTON_COUNT) - 1)) };
+    }
+    std::stable_sort(z, z + n, [](const Zone& a, const Zone& b) { return a.t < b.t; });
+    n = (int)(std::unique(z, z + n, [](const Zone& a, const Zone& b) { return a.t == b.t; }) - z);
 
-    // axes (packed CAS update)
-    for (auto& atom : g_axes[(size_t)padIndex])
+    key.count = (uint8_t)n;
+    for (int i = 0; i < BINDINGS_MAX_ZONES; ++i)
     {
-        uint32_t old = atom.load(std::memory_order_relaxed);
-        for (;;)
-        {
-            AxisBinding b = UnpackAxis(old);
-            bool changed = false;
+        key.thresholdM[i] = i < n ? z[i].t : 0;
+        key.buttons[i] = i < n ? z[i].buttons : 0;
+    }
+    return n > 0;
+}
 
-            if (b.minusHid == hid) { b.minusHid = 0; changed = true; }
-            if (b.plusHid == hid) { b.plusHid = 0; changed = true; }
+int Bindings_ZoneLevel(const ZoneKey& key, uint16_t depthM, int prevLevel)
+{
+    // enter: depth >= threshold; stay: depth >= threshold - hysteresis (never
+    // at rest: the margin is at most half the threshold)
+    int enter = 0, stay = 0;
+    for (int i = 0; i < BINDINGS_MAX_ZONES; ++i)
+    {
+        const int used = i < key.count;
+        const int t = key.thresholdM[i];
+        const int margin = std::min<int>(BINDINGS_ZONE_HYSTERESIS_M, t / 2);
+        enter += used & (depthM >= t);
+        stay += used & (depthM + margin >= t);
+    }
+    return std::clamp(prevLevel, enter, stay);
+}
 
-            if (!changed) break;
+static int FindZoneKey(const PadZones& z, uint16_t hid)
+{
+    for (int i = 0; i < z.keyCount; ++i)
+        if (z.keys[i].hid == hid) return i;
+    return -1;
+}
 
-            uint32_t nw = PackAxis(b.minusHid, b.plusHid);
-            if (atom.compare_exchange_weak(old, nw, std::memory_order_release, std::memory_order_relaxed))
-                break;
-        }
+static bool RemoveZoneKey(PadZones& z, uint16_t hid)
+{
+    const int i = FindZoneKey(z, hid);
+    if (i < 0) return false;
+    for (int j = i; j + 1 < z.keyCount; ++j) z.keys[j] = z.keys[j + 1];
+    z.keys[--z.keyCount] = ZoneKey{};
+    return true;
+}
+
+bool Bindings_SetZonesForPad(int padIndex, const ZoneKey& key)
+{
+    if (!IsValidPadIndex(padIndex)) return false;
+    if (key.hid == 0 || key.hid >= 256) return false;
+
+    ZoneKey k = key;
+    const bool any = Bindings_SanitizeZoneKey(k);
+    bool ok = true;
+    EditBlock(padIndex + 1, [&](BindingsBlock& blk) {
+        PadZones& z = blk.zones[(size_t)padIndex];
+        const int i = FindZoneKey(z, k.hid);
+        if (!any)
+            RemoveZoneKey(z, k.hid);
+        else if (i >= 0)
+            z.keys[i] = k;
+        else if (z.keyCount < BINDINGS_MAX_ZONE_KEYS)
+            z.keys[z.keyCount++] = k;
+        else
+            ok = false;
+        });
+    return ok;
+}
+
+bool Bindings_GetZonesForPad(int padIndex, uint16_t hid, ZoneKey& out)
+{
+    if (!IsValidPadIndex(padIndex)) return false;
+    const BindingsSnapshot blk = Bindings_Snapshot();
+    if (padIndex >= blk->pads) return false;
+    const PadZones& z = blk->zones[(size_t)padIndex];
+    const int i = FindZoneKey(z, hid);
+    if (i < 0) return false;
+    out = z.keys[i];
+    return true;
+}
+
+PadZones Bindings_GetPadZones(int padIndex)
+{
+    if (!IsValidPadIndex(padIndex)) return PadZones{};
+    const BindingsSnapshot blk = Bindings_Snapshot();
+    if (padIndex >= blk->pads) return PadZones{};
+    return blk->zones[(size_t)padIndex];
+}
+
+// ---- Whole pads ----
+static void WritePad(BindingsBlock& blk, int padIndex, const PadBindings& pb)
+{
+    for (int a = 0; a < 4; ++a) blk.Axis(padIndex, a) = PackAxis(pb.axes[a].minusHid, pb.axes[a].plusHid);
+    for (int t = 0; t < 2; ++t) blk.Trig(padIndex, t) = pb.triggers[t];
+    for (int b = 0; b < BINDINGS_BUTTON_COUNT; ++b)
+        for (int c = 0; c < 4; ++c)
+            blk.Btn(padIndex, b, c) = pb.buttons[b][c] & (c == 0 ? ~1ULL : ~0ULL);
+
+    PadZones& z = blk.zones[(size_t)padIndex];
+    z = PadZones{};
+    for (int i = 0; i < pb.zones.keyCount && i < BINDINGS_MAX_ZONE_KEYS; ++i)
+    {
+        ZoneKey k = pb.zones.keys[i];
+        if (k.hid == 0 || k.hid >= 256 || FindZoneKey(z, k.hid) >= 0) continue;
+        if (Bindings_SanitizeZoneKey(k)) z.keys[z.keyCount++] = k;
     }
+}
 
-    // triggers
-    for (auto& t : g_triggers[(size_t)padIndex])
+void Bindings_SetPad(int padIndex, const PadBindings& pb)
+{
+    if (!IsValidPadIndex(padIndex)) return;
+    EditBlock(padIndex + 1, [&](BindingsBlock& blk) { WritePad(blk, padIndex, pb); });
+}
+
+void Bindings_ClearAll()
+{
+    std::lock_guard<std::mutex> lk(g_writeMutex);
+    auto next = MakeBlock(4);
+    RebuildBoundIndex(*next);
+    g_block.store(std::move(next), std::memory_order_release);
+    g_generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+// ---- Clear HID from everywhere ----
+static void ClearHidInPad(BindingsBlock& blk, int padIndex, uint16_t hid)
+{
+    if (padIndex >= blk.pads) return;
+
+    // axes
+    for (int a = 0; a < 4; ++a)
     {
-        uint16_t cur = t.load(std::memory_order_relaxed);
-        if (cur == hid)
-            t.compare_exchange_strong(cur, 0, std::memory_order_release, std::memory_order_relaxed);
+        AxisBinding b = UnpackAxis(blk.Axis(padIndex, a));
+        if (b.minusHid == hid) b.minusHid = 0;
+        if (b.plusHid == hid) b.plusHid = 0;
+        blk.Axis(padIndex, a) = PackAxis(b.minusHid, b.plusHid);
     }
 
-    // buttons (mask)
+    // triggers
+    for (int t = 0; t < 2; ++t)
+        if (blk.Trig(padIndex, t) == hid) blk.Trig(padIndex, t) = 0;
+
+    // buttons (mask) + depth zones
     if (hid < 256)
     {
-        int chunk = (int)(hid / 64);
-        int bit = (int)(hid % 64);
-        uint64_t mask = ~(1ULL << bit);
+        const int chunk = (int)(hid / 64);
+        const uint64_t mask = ~(1ULL << (hid % 64));
+        for (int b = 0; b < BINDINGS_BUTTON_COUNT; ++b)
+            blk.Btn(padIndex, b, chunk) &= mask;
 
-        for (auto& btn : g_btnMask[(size_t)padIndex])
-        {
-            btn[chunk].fetch_and(mask, std::memory_order_release);
-        }
+        RemoveZoneKey(blk.zones[(size_t)padIndex], hid);
     }
 }
 
+void Bindings_ClearHidForPad(int padIndex, uint16_t hid)
+{
+    if (!IsValidPadIndex(padIndex)) return;
+    if (!hid) return;
+
+    EditBlock(0, [&](BindingsBlock& blk) { ClearHidInPad(blk, padIndex, hid); });
+}
+
 bool Bindings_IsHidBoundForPad(int padIndex, uint16_t hid)
 {
     if (!IsValidPadIndex(padIndex)) return false;
     if (!hid) return false;
 
+    const BindingsSnapshot blk = Bindings_Snapshot();
+    if (padIndex >= blk->pads) return false;
+
     for (int i = 0; i < 4; ++i)
     {
-        AxisBinding a = UnpackAxis(g_axes[(size_t)padIndex][(size_t)i].load(std::memory_order_acquire));
+        AxisBinding a = UnpackAxis(blk->Axis(padIndex, i));
         if (a.minusHid == hid || a.plusHid == hid)
             return true;
     }
 
     for (int i = 0; i < 2; ++i)
     {
-        if (g_triggers[(size_t)padIndex][(size_t)i].load(std::memory_order_acquire) == hid)
+        if (blk->Trig(padIndex, i) == hid)
             return true;
     }
 
     if (hid < 256)
     {
         const int chunk = (int)(hid / 64);
-        const int bit = (int)(hid % 64);
-        const uint64_t mask = (1ULL << bit);
-        for (size_t b = 0; b < g_btnMask[(size_t)padIndex].size(); ++b)
+        const uint64_t mask = (1ULL << (hid % 64));
+        for (int b = 0; b < BINDINGS_BUTTON_COUNT; ++b)
         {
-            if (g_btnMask[(size_t)padIndex][b][(size_t)chunk].load(std::memory_order_acquire) & mask)
+            if (blk->Btn(padIndex, b, chunk) & mask)
                 return true;
         }
+
+        if (FindZoneKey(blk->zones[(size_t)padIndex], hid) >= 0)
+            return true;
     }
 
     return false;
@@ -277,47 +517,6 @@ int Bindings_GetPadStyleVariant(int padIndex)
     return v;
 }
 
-static void CopyPadBindingsAtomic(int dstPad, int srcPad)
-{
-    if (!IsValidPadIndex(dstPad) || !IsValidPadIndex(srcPad)) return;
-
-    for (int a = 0; a < 4; ++a)
-    {
-        uint32_t v = g_axes[(size_t)srcPad][(size_t)a].load(std::memory_order_acquire);
-        g_axes[(size_t)dstPad][(size_t)a].store(v, std::memory_order_release);
-    }
-
-    for (int t = 0; t < 2; ++t)
-    {
-        uint16_t v = g_triggers[(size_t)srcPad][(size_t)t].load(std::memory_order_acquire);
-        g_triggers[(size_t)dstPad][(size_t)t].store(v, std::memory_order_release);
-    }
-
-    for (int b = 0; b < 15; ++b)
-    {
-        for (int c = 0; c < 4; ++c)
-        {
-            uint64_t v = g_btnMask[(size_t)srcPad][(size_t)b][(size_t)c].load(std::memory_order_acquire);
-            g_btnMask[(size_t)dstPad][(size_t)b][(size_t)c].store(v, std::memory_order_release);
-        }
-    }
-}
-
-static void ClearPadBindingsAtomic(int padIndex)
-{
-    if (!IsValidPadIndex(padIndex)) return;
-
-    for (int a = 0; a < 4; ++a)
-        g_axes[(size_t)padIndex][(size_t)a].store(0u, std::memory_order_release);
-
-    for (int t = 0; t < 2; ++t)
-        g_triggers[(size_t)padIndex][(size_t)t].store(0u, std::memory_order_release);
-
-    for (int b = 0; b < 15; ++b)
-        for (int c = 0; c < 4; ++c)
-            g_btnMask[(size_t)padIndex][(size_t)b][(size_t)c].store(0ull, std::memory_order_release);
-}
-
 void Bindings_RemovePadAndCompact(int removePadIndex, int activePadCount)
 {
     activePadCount = std::clamp(activePadCount, 1, BINDINGS_MAX_GAMEPADS);
@@ -325,13 +524,18 @@ void Bindings_RemovePadAndCompact(int removePadIndex, int activePadCount)
     if (removePadIndex <= 0) return; // pad #1 is always present
     if (removePadIndex >= activePadCount) return;
 
+    EditBlock(activePadCount, [&](BindingsBlock& blk) {
+        PadBindings pb;
+        for (int p = removePadIndex; p < activePadCount - 1; ++p)
+        {
+            Bindings_ReadPad(blk, p + 1, pb);
+            WritePad(blk, p, pb);
+        }
+        WritePad(blk, activePadCount - 1, PadBindings{});
+        });
+
     for (int p = removePadIndex; p < activePadCount - 1; ++p)
-    {
-        CopyPadBindingsAtomic(p, p + 1);
         g_padStyle[(size_t)p] = g_padStyle[(size_t)(p + 1)];
-    }
-
-    ClearPadBindingsAtomic(activePadCount - 1);
 
     // Keep a stable pool of unique style ids among active pads.
     bool used[BINDINGS_MAX_GAMEPADS + 1]{};
@@ -350,12 +554,21 @@ void Bindings_RemovePadAndCompact(int removePadIndex, int activePadCount)
 
 void Bindings_ClearHid(uint16_t hid)
 {
-    for (int pad = 0; pad < BINDINGS_MAX_GAMEPADS; ++pad)
-        Bindings_ClearHidForPad(pad, hid);
+    if (!hid) return;
+
+    // every pad, one publish
+    EditBlock(0, [&](BindingsBlock& blk) {
+        for (int pad = 0; pad < blk.pads; ++pad)
+            ClearHidInPad(blk, pad, hid);
+        });
 }
 
 bool Bindings_IsHidBound(uint16_t hid)
 {
+    if (hid == 0) return false;
+    if (hid < 256)
+        return (g_boundAny[(size_t)(hid / 64)].load(std::memory_order_acquire) & (1ULL << (hid % 64))) != 0;
+
     for (int pad = 0; pad < BINDINGS_MAX_GAMEPADS; ++pad)
     {
         if (Bindings_IsHidBoundForPad(pad, hid))
@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include <memory>
 
 // NOTE: We support "many keys per GAMEPAD BUTTON" by storing a HID bitmask (HID < 256).
 // Axes and triggers remain single-HID as before.
@@ -30,7 +31,60 @@ enum class GameButton
     DpadUp, DpadDown, DpadLeft, DpadRight
 };
 
-constexpr int BINDINGS_MAX_GAMEPADS = 4;
+// Virtual pads. Storage grows with the highest pad written, so 4 pads cost
+// what they always did; the editor shows the first 4.
+constexpr int BINDINGS_MAX_GAMEPADS = 16;
+constexpr int BINDINGS_BUTTON_COUNT = (int)GameButton::DpadRight + 1;
+
+// Depth zones: several actions along one key's travel. Zone i covers the
+// depths from thresholdM[i] up to the next threshold and holds its buttons
+// while the key is in it, on top of the key's axis / trigger / button
+// bindings ("W = LY+, past 900 also LS", "light press X, full press Y").
+// Depth is the key value after its curve (0..1000), as for actuation.
+constexpr int BINDINGS_MAX_ZONES = 4;        // per key
+constexpr int BINDINGS_MAX_ZONE_KEYS = 16;   // per pad
+// Going back up the travel, a zone is left this far above its threshold.
+constexpr uint16_t BINDINGS_ZONE_HYSTERESIS_M = 20;
+
+struct ZoneKey
+{
+    uint16_t hid = 0;                            // 1..255
+    uint8_t  count = 0;                          // zones used
+    uint16_t thresholdM[BINDINGS_MAX_ZONES]{};   // ascending, 1..1000
+    uint16_t buttons[BINDINGS_MAX_ZONES]{};      // bit = GameButton, 0 = nothing in that zone
+};
+
+struct PadZones
+{
+    uint8_t keyCount = 0;
+    ZoneKey keys[BINDINGS_MAX_ZONE_KEYS];
+};
+
+// Plain copy of one pad's bindings (profile files, app profile images).
+struct PadBindings
+{
+    AxisBinding axes[4]{};                          // Axis order
+    uint16_t    triggers[2]{};                      // LT, RT
+    uint64_t    buttons[BINDINGS_BUTTON_COUNT][4]{}; // same chunks as the button masks
+    PadZones    zones;
+};
+
+// ---- Snapshots ----
+// All pads as one immutable structure-of-arrays block (one field of every pad
+// contiguous). Every edit publishes a new block; a reader keeps the one it
+// loaded for as long as it holds it, consistent across pads and fields.
+struct BindingsBlock;
+using BindingsSnapshot = std::shared_ptr<const BindingsBlock>;
+
+BindingsSnapshot Bindings_Snapshot();
+// Changes with every edit: the realtime side reloads the snapshot when it moves.
+uint32_t Bindings_Generation();
+// Pads past the block's capacity read as unbound.
+void Bindings_ReadPad(const BindingsBlock& block, int padIndex, PadBindings& out);
+
+// Whole-pad edits, one publish each (profile load).
+void Bindings_SetPad(int padIndex, const PadBindings& pb);
+void Bindings_ClearAll();
 
 // ---- Per-gamepad API ----
 void Bindings_SetAxisMinusForPad(int padIndex, Axis a, uint16_t hid);
@@ -46,11 +100,25 @@ bool Bindings_ButtonHasHidForPad(int padIndex, GameButton b, uint16_t hid);
 uint64_t Bindings_GetButtonMaskChunkForPad(int padIndex, GameButton b, int chunk);
 uint16_t Bindings_GetButtonForPad(int padIndex, GameButton b);
 
+// Replaces the zones of key.hid (count 0 removes them). Thresholds are
+// sorted, out of 1..1000 or duplicated ones dropped. false: bad pad / HID,
+// or BINDINGS_MAX_ZONE_KEYS keys already zoned.
+bool Bindings_SetZonesForPad(int padIndex, const ZoneKey& key);
+bool Bindings_GetZonesForPad(int padIndex, uint16_t hid, ZoneKey& out);
+PadZones Bindings_GetPadZones(int padIndex);
+
+// Sort / clamp one key's zones in place; false if none is left.
+bool Bindings_SanitizeZoneKey(ZoneKey& key);
+// Zone the key is in at depthM (0 = below the first threshold, i = zone i-1),
+// with hysteresis from the previous tick's level. Branch-free over the
+// thresholds: realtime thread, once per zoned key.
+int  Bindings_ZoneLevel(const ZoneKey& key, uint16_t depthM, int prevLevel);
+
 void Bindings_ClearHidForPad(int padIndex, uint16_t hid);
 bool Bindings_IsHidBoundForPad(int padIndex, uint16_t hid);
 
 // Visual style (accent color identity) bound to pad slot.
-// styleVariant: 1..4
+// styleVariant: 1..4 for the pads the editor shows
 void Bindings_SetPadStyleVariant(int padIndex, int styleVariant);
 int  Bindings_GetPadStyleVariant(int padIndex);
 
@@ -92,9 +160,10 @@ uint16_t Bindings_GetButton(GameButton b);
 // - axes (minus/plus)
 // - triggers
 // - buttons (mask bits)
+// - depth zones
 // across ALL virtual gamepads.
 void Bindings_ClearHid(uint16_t hid);
 
-// Returns true if HID is used by any gamepad binding (axis/trigger/button).
+// Returns true if HID is used by any gamepad binding (axis/trigger/button/zones).
 // across ALL virtual gamepads.
 bool Bindings_IsHidBound(uint16_t hid);
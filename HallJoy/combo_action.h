@@ -0,0 +1,49 @@
+// combo_action.h
+#pragma once
+#include <cstdint>
+#include <string>
+
+// ============================================================
+// COMBO ACTION
+// One step of a combo's action list, shared by the combo systems, the
+// macro compiler and the macro recorder.
+// Portable (no Win32).
+// ============================================================
+
+// Types d'actions possibles
+enum class ComboActionType
+{
+    None = 0,
+    PressKey,           // Appuyer sur une touche
+    ReleaseKey,         // Relâcher une touche
+    TapKey,             // Appuyer puis relâcher rapidement
+    TypeText,           // Taper du texte
+    MouseClick,         // Clic de souris
+    Delay,              // Attendre X millisecondes
+
+    // Langage macro (compilé pour la VM, cf. macro_compiler.h).
+    // Les arguments réutilisent keyHid / delayMs / mouseButton (format fichier inchangé).
+    Loop,               // mouseButton = nombre de tours (0 = jusqu'à l'arrêt)
+    EndLoop,
+    IfKeyHeld,          // keyHid
+    IfAnalogAbove,      // keyHid, mouseButton = seuil milli [0..1000]
+    IfVarBelow,         // keyHid = variable (0..7), mouseButton = valeur
+    Else,
+    EndIf,
+    SetVar,             // keyHid = variable, mouseButton = valeur
+    AddVar,             // keyHid = variable, mouseButton = delta
+    RandomDelay,        // delayMs = min, mouseButton = max (ms)
+    AnalogSet,          // keyHid, mouseButton = milli [0..1000]
+    AnalogRamp,         // keyHid, mouseButton = milli cible, delayMs = durée
+    AnalogRelease,      // keyHid
+};
+
+// Action à exécuter
+struct ComboAction
+{
+    ComboActionType type = ComboActionType::None;
+    uint16_t keyHid = 0;            // Pour PressKey/ReleaseKey/TapKey
+    std::wstring text;              // Pour TypeText
+    uint32_t delayMs = 0;           // Pour Delay
+    int mouseButton = 0;            // Pour MouseClick (0=left, 1=right, 2=middle)
+};
@@ -0,0 +1,28 @@
+// combo_clock.h
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Millisecond time source of the combo engine (long press, repeats, cooldowns,
+// watchdog, capture windows). The default is QPC in ms (ComboTimer_NowUs); a simulation
+// installs a VirtualComboClock and moves time forward itself.
+// Wrap-around safe like GetTickCount: always compare with (now - then).
+class IComboClock
+{
+public:
+    virtual ~IComboClock() = default;
+    virtual uint32_t NowMs() = 0;
+};
+
+class VirtualComboClock : public IComboClock
+{
+public:
+    explicit VirtualComboClock(uint32_t startMs = 1) : m_nowMs(startMs) {}
+
+    uint32_t NowMs() override { return m_nowMs.load(std::memory_order_acquire); }
+    void Set(uint32_t ms) { m_nowMs.store(ms, std::memory_order_release); }
+    void Advance(uint32_t ms) { m_nowMs.fetch_add(ms, std::memory_order_acq_rel); }
+
+private:
+    std::atomic<uint32_t> m_nowMs;
+};
@@ -0,0 +1,147 @@
+// combo_sim.cpp
+#include "combo_sim.h"
+#include "combo_timer.h"
+
+#include <algorithm>
+
+// Far from 0: the engine uses 0 as "never" for several timestamps.
+static constexpr uint32_t kSimStartMs = 0x10000000u;
+
+ComboSimulator::ComboSimulator(uint32_t tickMs)
+    : m_clock(kSimStartMs)
+    , m_startMs(kSimStartMs)
+    , m_tickMs(tickMs ? tickMs : 1)
+{
+    ComboTimer_Suspend();   // no real-time Tick() on the virtual clock
+    InputBus_ResetHeld();
+    FreeComboSystem::SetClock(&m_clock);
+    FreeComboSystem::SetDryRun(true);
+    FreeComboSystem::SetObserver(&ComboSimulator::OnEngineEvent, this);
+}
+
+ComboSimulator::~ComboSimulator()
+{
+    FreeComboSystem::SetObserver(nullptr, nullptr);
+    FreeComboSystem::SetDryRun(false);
+    FreeComboSystem::SetClock(nullptr);
+    InputBus_ResetHeld();
+    ComboTimer_Resume();
+}
+
+void ComboSimulator::OnEngineEvent(void* user, FreeComboSystem::ComboSimEvent ev, int comboId, DWORD nowMs)
+{
+    ComboSimulator* self = static_cast<ComboSimulator*>(user);
+    switch (ev)
+    {
+    case FreeComboSystem::ComboSimEvent::Fired:
+        ++self->m_stats.fired;
+        if (comboId >= 0)
+            ++self->m_firesPerCombo[comboId];
+        break;
+    case FreeComboSystem::ComboSimEvent::CancelRequested:
+        ++self->m_stats.cancels;
+        break;
+    case FreeComboSystem::ComboSimEvent::RateLimitStop:
+        ++self->m_stats.rateLimitStops;
+        break;
+    }
+
+    if (!self->m_recording) return;
+    ComboSimRecord r;
+    r.timeMs = (uint32_t)nowMs - self->m_startMs;
+    r.ev = ev;
+    r.comboId = comboId;
+    self->m_records.push_back(r);
+}
+
+void ComboSimulator::Publish(const InputEvent& evIn)
+{
+    InputEvent ev = evIn;
+    ev.timeUs = (uint64_t)m_elapsedMs * 1000ull;
+    InputBus_Publish(ev);
+    FreeComboSystem::PumpInputBus();
+    ++m_stats.inputEvents;
+}
+
+void ComboSimulator::KeyDown(uint16_t vk)
+{
+    InputEvent ev;
+    ev.type = InputEventType::KeyDown;
+    ev.code = vk;
+    Publish(ev);
+}
+
+void ComboSimulator::KeyUp(uint16_t vk)
+{
+    InputEvent ev;
+    ev.type = InputEventType::KeyUp;
+    ev.code = vk;
+    Publish(ev);
+}
+
+void ComboSimulator::MouseDown(InputMouseButton b)
+{
+    InputEvent ev;
+    ev.type = InputEventType::MouseDown;
+    ev.code = (uint16_t)b;
+    Publish(ev);
+}
+
+void ComboSimulator::MouseUp(InputMouseButton b)
+{
+    InputEvent ev;
+    ev.type = InputEventType::MouseUp;
+    ev.code = (uint16_t)b;
+    Publish(ev);
+}
+
+void ComboSimulator::Wheel(int16_t delta)
+{
+    InputEvent ev;
+    ev.type = InputEventType::Wheel;
+    ev.wheelDelta = delta;
+    Publish(ev);
+}
+
+void ComboSimulator::Advance(uint32_t ms)
+{
+    while (ms > 0)
+    {
+        const uint32_t step = std::min(ms, m_tickMs - m_sinceTickMs);
+        m_clock.Advance(step);
+        m_elapsedMs += step;
+        m_sinceTickMs += step;
+        ms -= step;
+        if (m_sinceTickMs >= m_tickMs)
+        {
+            m_sinceTickMs = 0;
+            FreeComboSystem::Tick();
+            ++m_stats.ticks;
+        }
+    }
+}
+
+void ComboSimulator::RunScript(const std::vector<ComboSimInput>& script, uint32_t tailMs)
+{
+    const uint32_t base = m_elapsedMs;
+    for (const auto& in : script)
+    {
+        const uint32_t at = base + in.atMs;
+        if (at > m_elapsedMs) Advance(at - m_elapsedMs);
+        Publish(in.ev);
+    }
+    Advance(tailMs);
+}
+
+uint64_t ComboSimulator::FireCount(int comboId) const
+{
+    auto it = m_firesPerCombo.find(comboId);
+    return (it != m_firesPerCombo.end()) ? it->second : 0;
+}
+
+void ComboSimulator::ClearRecords()
+{
+    m_records.clear();
+    m_firesPerCombo.clear();
+    m_stats = ComboSimStats{};
+}
@@ -0,0 +1,91 @@
+// combo_sim.h
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "combo_clock.h"
+#include "input_bus.h"
+#include "free_combo_system.h"
+
+// ============================================================
+// COMBO SIMULATOR
+// Drives FreeComboSystem headless on a virtual clock: scripted input events
+// are published on the input bus, time moves forward in fixed ticks and every
+// fire / cancel / watchdog stop is recorded with its virtual timestamp.
+// Hours of repeat, long-press, cancel-on-release and watchdog behaviour
+// run in milliseconds.
+//
+// While a ComboSimulator exists it owns the engine: clock, dry run and
+// observer are installed in the constructor and restored in the destructor,
+// and the combo_timer thread is suspended (only Advance() ticks the engine).
+// Never use it while the real hooks are publishing on the bus.
+// ============================================================
+
+struct ComboSimInput
+{
+    uint32_t atMs = 0;    // virtual time, relative to the start of RunScript()
+    InputEvent ev;        // seq / timeUs are filled by the simulator
+};
+
+struct ComboSimRecord
+{
+    uint32_t timeMs = 0;  // relative to the simulator start
+    FreeComboSystem::ComboSimEvent ev = FreeComboSystem::ComboSimEvent::Fired;
+    int comboId = -1;
+};
+
+struct ComboSimStats
+{
+    uint64_t inputEvents = 0;
+    uint64_t ticks = 0;
+    uint64_t fired = 0;
+    uint64_t cancels = 0;
+    uint64_t rateLimitStops = 0;
+};
+
+class ComboSimulator
+{
+public:
+    explicit ComboSimulator(uint32_t tickMs = 10);
+    ~ComboSimulator();
+
+    ComboSimulator(const ComboSimulator&) = delete;
+    ComboSimulator& operator=(const ComboSimulator&) = delete;
+
+    // Immediate input at the current virtual time
+    void KeyDown(uint16_t vk);
+    void KeyUp(uint16_t vk);
+    void MouseDown(InputMouseButton b);
+    void MouseUp(InputMouseButton b);
+    void Wheel(int16_t delta);
+    void Publish(const InputEvent& ev);
+
+    // Move virtual time forward, running FreeComboSystem::Tick() every tickMs.
+    void Advance(uint32_t ms);
+    // Replays a script sorted by atMs, then runs `tailMs` more.
+    void RunScript(const std::vector<ComboSimInput>& script, uint32_t tailMs = 0);
+
+    uint32_t NowMs() const { return m_elapsedMs; }
+    const ComboSimStats& Stats() const { return m_stats; }
+    const std::vector<ComboSimRecord>& Records() const { return m_records; }
+    // Fires of one combo (FreeComboSystem id)
+    uint64_t FireCount(int comboId) const;
+    void ClearRecords();
+
+    // Keep only the counters (long benchmarks).
+    void SetRecording(bool on) { m_recording = on; }
+
+private:
+    static void OnEngineEvent(void* user, FreeComboSystem::ComboSimEvent ev, int comboId, DWORD nowMs);
+
+    VirtualComboClock m_clock;
+    uint32_t m_startMs = 0;
+    uint32_t m_elapsedMs = 0;
+    uint32_t m_tickMs = 10;
+    uint32_t m_sinceTickMs = 0;
+    bool m_recording = true;
+    ComboSimStats m_stats;
+    std::vector<ComboSimRecord> m_records;
+    std::unordered_map<int, uint64_t> m_firesPerCombo;
+};
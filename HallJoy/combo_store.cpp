@@ -0,0 +1,803 @@
+// combo_store.cpp
+#include "combo_store.h"
+#include "persist_service.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+// ============================================================
+// Format
+// ============================================================
+static const char     kMagic[4] = { 'D', 'C', 'J', '6' };
+static constexpr uint32_t kFormatVersion = 6;
+static constexpr size_t   kHeaderBytes = 8;
+static constexpr size_t   kRecordHeaderBytes = 8;             // length + crc
+static constexpr uint32_t kMaxRecordBytes = 16u * 1024 * 1024; // sanity bound for a damaged length
+// Compact when the file exceeds twice the live data plus this slack
+static constexpr uint64_t kCompactSlackBytes = 64 * 1024;
+
+enum RecordType : uint8_t
+{
+    Record_Settings = 1,
+    Record_Combo = 2,
+    Record_Delete = 3,
+    Record_Order = 4,
+};
+
+// Payload version of each record type (fields are only ever appended)
+static constexpr uint8_t kSettingsVersion = 1;
+static constexpr uint8_t kComboVersion = 1;
+static constexpr uint8_t kDeleteVersion = 1;
+static constexpr uint8_t kOrderVersion = 1;
+
+static uint32_t Crc32(const uint8_t* p, size_t n)
+{
+    static const auto table = []() {
+        struct T { uint32_t v[256]; } t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t.v[i] = c;
+        }
+        return t;
+    }();
+    uint32_t c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < n; ++i) c = table.v[(c ^ p[i]) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+// FNV-1a: "did this record change since the last write"
+static uint64_t Hash64(const uint8_t* p, size_t n)
+{
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < n; ++i) { h ^= p[i]; h *= 0x100000001B3ull; }
+    return h;
+}
+
+// ---- Little-endian writer / bounds-checked reader ----
+namespace
+{
+    struct Writer
+    {
+        std::vector<uint8_t> buf;
+
+        void U8(uint8_t v) { buf.push_back(v); }
+        void U16(uint16_t v) { U8((uint8_t)v); U8((uint8_t)(v >> 8)); }
+        void U32(uint32_t v) { U16((uint16_t)v); U16((uint16_t)(v >> 16)); }
+        void Str(const std::wstring& s)
+        {
+            U32((uint32_t)s.size());
+            for (wchar_t ch : s) U16((uint16_t)ch);
+        }
+    };
+
+    struct Reader
+    {
+        const uint8_t* p;
+        size_t         n;
+        size_t         pos = 0;
+        bool           ok = true;
+
+        Reader(const uint8_t* data, size_t size) : p(data), n(size) {}
+
+        bool Has(size_t k) { if (n - pos < k) ok = false; return ok; }
+        uint8_t  U8() { if (!Has(1)) return 0; return p[pos++]; }
+        uint16_t U16() { if (!Has(2)) return 0; uint16_t v = (uint16_t)(p[pos] | (p[pos + 1] << 8)); pos += 2; return v; }
+        uint32_t U32() { uint32_t lo = U16(); uint32_t hi = U16(); return lo | (hi << 16); }
+        std::wstring Str()
+        {
+            const uint32_t len = U32();
+            if (!Has((size_t)len * 2)) return {};
+            std::wstring s((size_t)len, L'\0');
+            for (uint32_t i = 0; i < len; ++i) s[i] = (wchar_t)U16();
+            return s;
+        }
+        bool AtEnd() const { return pos >= n; }
+    };
+}
+
+// ---- Record bodies (type + version + payload) ----
+static std::vector<uint8_t> EncodeSettings(const ComboLibrary& lib)
+{
+    Writer w;
+    w.U8(Record_Settings); w.U8(kSettingsVersion);
+    w.U32((uint32_t)lib.wlMode);
+    w.U8(lib.wheelCDEnabled ? 1 : 0);
+    w.U32(lib.wheelCDMs);
+    w.U32((uint32_t)lib.whitelist.size());
+    for (const auto& e : lib.whitelist) w.Str(e);
+    return std::move(w.buf);
+}
+
+static std::vector<uint8_t> EncodeCombo(const FreeCombo& c)
+{
+    Writer w;
+    w.U8(Record_Combo); w.U8(kComboVersion);
+    w.U32(c.uid);
+    w.Str(c.name);
+    w.U8((uint8_t)c.trigger.modifier);
+    w.U8((uint8_t)c.trigger.keyType);
+    w.U16(c.trigger.vkCode);
+    w.U8((uint8_t)c.trigger.holdKeyType);
+    w.U16(c.trigger.holdVkCode);
+    w.U8(c.trigger.keyTypeIsHold ? 1 : 0);
+    w.U32(c.trigger.analogParam);
+    w.U8((c.enabled ? 1 : 0) | (c.repeatWhileHeld ? 2 : 0) | (c.isExample ? 4 : 0) |
+        (c.cancelOnRelease ? 8 : 0) | (c.longPressEnabled ? 16 : 0));
+    w.U32(c.repeatDelayMs);
+    w.U32(c.repeatCount);
+    w.U32(c.longPressMs);
+    w.U32((uint32_t)c.actions.size());
+    for (const auto& a : c.actions) {
+        w.U8((uint8_t)a.type);
+        w.U16(a.keyHid);
+        w.U32(a.delayMs);
+        w.U32((uint32_t)a.mouseButton);
+        w.Str(a.text);
+    }
+    return std::move(w.buf);
+}
+
+static std::vector<uint8_t> EncodeDelete(uint32_t uid)
+{
+    Writer w;
+    w.U8(Record_Delete); w.U8(kDeleteVersion);
+    w.U32(uid);
+    return std::move(w.buf);
+}
+
+static std::vector<uint8_t> EncodeOrder(const ComboLibrary& lib)
+{
+    Writer w;
+    w.U8(Record_Order); w.U8(kOrderVersion);
+    w.U32((uint32_t)lib.combos.size());
+    for (const auto& c : lib.combos) w.U32(c.uid);
+    return std::move(w.buf);
+}
+
+// r positioned after type + version
+static bool DecodeSettings(Reader& r, ComboLibrary* lib)
+{
+    lib->wlMode = (int)r.U32();
+    lib->wheelCDEnabled = r.U8() != 0;
+    const uint32_t ms = r.U32();
+    lib->wheelCDMs = ms ? ms : 150;
+    const uint32_t n = r.U32();
+    lib->whitelist.clear();
+    for (uint32_t i = 0; i < n && r.ok; ++i) lib->whitelist.push_back(r.Str());
+    lib->hasSettings = r.ok;
+    return r.ok;
+}
+
+static bool DecodeCombo(Reader& r, FreeCombo* c)
+{
+    c->uid = r.U32();
+    c->name = r.Str();
+    c->trigger.modifier = (FreeTriggerModifier)r.U8();
+    c->trigger.keyType = (FreeTriggerKeyType)r.U8();
+    c->trigger.vkCode = r.U16();
+    c->trigger.holdKeyType = (FreeTriggerKeyType)r.U8();
+    c->trigger.holdVkCode = r.U16();
+    c->trigger.keyTypeIsHold = r.U8() != 0;
+    c->trigger.analogParam = r.U32();
+    const uint8_t flags = r.U8();
+    c->enabled = (flags & 1) != 0;
+    c->repeatWhileHeld = (flags & 2) != 0;
+    c->isExample = (flags & 4) != 0;
+    c->cancelOnRelease = (flags & 8) != 0;
+    c->longPressEnabled = (flags & 16) != 0;
+    c->repeatDelayMs = r.U32();
+    c->repeatCount = r.U32();
+    const uint32_t lpms = r.U32();
+    c->longPressMs = lpms ? lpms : 300;
+    const uint32_t n = r.U32();
+    c->actions.clear();
+    if (r.ok && n > r.n) return false; // damaged count
+    c->actions.reserve(n);
+    for (uint32_t i = 0; i < n && r.ok; ++i) {
+        ComboAction a;
+        a.type = (ComboActionType)r.U8();
+        a.keyHid = r.U16();
+        a.delayMs = r.U32();
+        a.mouseButton = (int)r.U32();
+        a.text = r.Str();
+        c->actions.push_back(std::move(a));
+    }
+    return r.ok && c->uid != 0;
+}
+
+static void AppendRecord(std::vector<uint8_t>& out, const std::vector<uint8_t>& body)
+{
+    const uint32_t len = (uint32_t)body.size();
+    const uint32_t crc = Crc32(body.data(), body.size());
+    const uint8_t hdr[8] = {
+        (uint8_t)len, (uint8_t)(len >> 8), (uint8_t)(len >> 16), (uint8_t)(len >> 24),
+        (uint8_t)crc, (uint8_t)(crc >> 8), (uint8_t)(crc >> 16), (uint8_t)(crc >> 24),
+    };
+    out.insert(out.end(), hdr, hdr + 8);
+    out.insert(out.end(), body.begin(), body.end());
+}
+
+// ============================================================
+// Journal state: what the file on disk currently holds (g_fileMutex)
+// ============================================================
+namespace
+{
+    struct LiveRecord
+    {
+        uint64_t hash = 0;
+        uint32_t bytes = 0; // header included
+    };
+
+    struct JournalState
+    {
+        bool         valid = false;  // file matches this state: appends are possible
+        std::wstring path;
+        bool         legacyBackup = false; // path is a V1..V5 import: keep it as .v5.bak on the first write
+        uint64_t     fileBytes = 0;
+        uint64_t     liveBytes = 0;
+        LiveRecord   settings;
+        LiveRecord   order;
+        std::unordered_map<uint32_t, LiveRecord> combos;
+    };
+
+    std::mutex      g_fileMutex;
+    JournalState    g_journal;
+    ComboStoreStats g_stats;
+
+    // ---- Background writes (persistence service task) ----
+    std::mutex              g_postMutex;
+    bool                    g_writerRun = false;
+    bool                    g_hasPending = false;
+    std::wstring            g_pendingPath;
+    ComboLibrary            g_pending;
+    bool                    g_lastOk = true;
+}
+
+static bool ReadWholeFile(const wchar_t* path, std::vector<uint8_t>* out)
+{
+    FILE* f = nullptr;
+    if (_wfopen_s(&f, path, L"rb") != 0 || !f) return false;
+    out->clear();
+    uint8_t chunk[64 * 1024];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+        out->insert(out->end(), chunk, chunk + n);
+    const bool ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
+// Directory entry only: is the file still the one g_journal describes?
+static bool FileSizeIs(const std::wstring& path, uint64_t expected)
+{
+    WIN32_FILE_ATTRIBUTE_DATA fad{};
+    if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &fad)) return false;
+    return (((uint64_t)fad.nFileSizeHigh << 32) | fad.nFileSizeLow) == expected;
+}
+
+static bool WriteWholeFile(const std::wstring& path, const wchar_t* mode, const std::vector<uint8_t>& data)
+{
+    FILE* f = nullptr;
+    if (_wfopen_s(&f, path.c_str(), mode) != 0 || !f) return false;
+    bool ok = data.empty() || fwrite(data.data(), 1, data.size(), f) == data.size();
+    ok = (fflush(f) == 0) && ok;
+    ok = (fclose(f) == 0) && ok;
+    return ok;
+}
+
+// ============================================================
+// Load
+// ============================================================
+static bool LoadJournal(const std::vector<uint8_t>& data, const wchar_t* path, ComboLibrary* out)
+{
+    JournalState st;
+    st.path = path;
+    bool torn = false;
+
+    std::unordered_map<uint32_t, FreeCombo> byUid;
+    std::vector<uint32_t> firstSeen;   // fallback order for uids missing from the Order record
+    std::vector<uint32_t> order;
+    bool hasOrder = false;
+    ComboLibrary settings;
+
+    size_t pos = kHeaderBytes;
+    while (pos < data.size()) {
+        if (data.size() - pos < kRecordHeaderBytes) { torn = true; break; }
+        const uint8_t* h = data.data() + pos;
+        const uint32_t len = (uint32_t)h[0] | ((uint32_t)h[1] << 8) | ((uint32_t)h[2] << 16) | ((uint32_t)h[3] << 24);
+        const uint32_t crc = (uint32_t)h[4] | ((uint32_t)h[5] << 8) | ((uint32_t)h[6] << 16) | ((uint32_t)h[7] << 24);
+        if (len < 2 || len > kMaxRecordBytes || len > data.size() - pos - kRecordHeaderBytes) { torn = true; break; }
+        const uint8_t* body = h + kRecordHeaderBytes;
+        if (Crc32(body, len) != crc) { torn = true; break; }
+
+        const LiveRecord rec{ Hash64(body, len), (uint32_t)(kRecordHeaderBytes + len) };
+        Reader r(body, len);
+        const uint8_t type = r.U8();
+        r.U8(); // version: every version so far is a prefix of the next one
+        switch (type) {
+        case Record_Settings:
+            if (DecodeSettings(r, &settings)) st.settings = rec;
+            break;
+        case Record_Combo: {
+            FreeCombo c;
+            if (!DecodeCombo(r, &c)) break;
+            const uint32_t uid = c.uid;
+            if (byUid.find(uid) == byUid.end()) firstSeen.push_back(uid);
+            byUid[uid] = std::move(c);
+            st.combos[uid] = rec;
+            break;
+        }
+        case Record_Delete: {
+            const uint32_t uid = r.U32();
+            if (!r.ok) break;
+            byUid.erase(uid);
+            st.combos.erase(uid);
+            break;
+        }
+        case Record_Order: {
+            const uint32_t n = r.U32();
+            if (!r.ok || n > len / 4) break;
+            std::vector<uint32_t> o(n);
+            for (uint32_t i = 0; i < n; ++i) o[i] = r.U32();
+            if (!r.ok) break;
+            order = std::move(o);
+            hasOrder = true;
+            st.order = rec;
+            break;
+        }
+        default:
+            break; // newer record type: skipped
+        }
+        pos += kRecordHeaderBytes + len;
+    }
+
+    out->combos.clear();
+    out->combos.reserve(byUid.size());
+    std::unordered_set<uint32_t> placed;
+    if (hasOrder) {
+        for (uint32_t uid : order) {
+            auto it = byUid.find(uid);
+            if (it == byUid.end() || !placed.insert(uid).second) continue;
+            out->combos.push_back(std::move(it->second));
+        }
+    }
+    for (uint32_t uid : firstSeen) {
+        auto it = byUid.find(uid);
+        if (it == byUid.end() || !placed.insert(uid).second) continue;
+        out->combos.push_back(std::move(it->second));
+    }
+    if (settings.hasSettings) {
+        out->wlMode = settings.wlMode;
+        out->wheelCDEnabled = settings.wheelCDEnabled;
+        out->wheelCDMs = settings.wheelCDMs;
+        out->whitelist = std::move(settings.whitelist);
+        out->hasSettings = true;
+    }
+
+    st.fileBytes = pos;
+    st.liveBytes = kHeaderBytes + st.settings.bytes + st.order.bytes;
+    for (const auto& kv : st.combos) st.liveBytes += kv.second.bytes;
+    // Damaged tail: appending after it would hide the new records, rewrite on next save
+    st.valid = !torn;
+
+    g_journal = std::move(st);
+    g_stats.fileBytes = g_journal.fileBytes;
+    g_stats.liveBytes = g_journal.liveBytes;
+    g_stats.legacy = false;
+    g_stats.tornTail = torn;
+    return true;
+}
+
+static bool ReadLegacyText(const wchar_t* path, ComboLibrary* out);   // V1..V5 text importer, below
+
+// Nothing to append to: the next write converts the file and backs it up first.
+static bool ImportLegacyLocked(const wchar_t* path, ComboLibrary* out)
+{
+    g_journal = JournalState{};
+    g_stats = ComboStoreStats{ 0, 0, 0, g_stats.rewrites, true, false };
+    if (!ReadLegacyText(path, out)) return false;
+    g_journal.path = path;
+    g_journal.legacyBackup = true;
+    return true;
+}
+
+bool ComboStore_Load(const wchar_t* path, ComboLibrary* out)
+{
+    if (!path || !out) return false;
+    std::lock_guard<std::mutex> lk(g_fileMutex);
+    std::vector<uint8_t> data;
+    if (!ReadWholeFile(path, &data)) return false;
+
+    if (data.size() >= kHeaderBytes && memcmp(data.data(), kMagic, 4) == 0)
+        return LoadJournal(data, path, out);
+
+    return ImportLegacyLocked(path, out);
+}
+
+bool ComboStore_ImportLegacy(const wchar_t* path, ComboLibrary* out)
+{
+    if (!path || !out) return false;
+    std::lock_guard<std::mutex> lk(g_fileMutex);
+    return ImportLegacyLocked(path, out);
+}
+
+// ============================================================
+// Write
+// ============================================================
+static bool WriteSnapshotLocked(const std::wstring& path, const ComboLibrary& lib)
+{
+    // First save after a V1..V5 import: keep the original text file. Once the
+    // snapshot is in, g_journal is replaced and the flag goes with it.
+    if (g_journal.legacyBackup && g_journal.path == path) {
+        const std::wstring bak = path + L".v5.bak";
+        CopyFileW(path.c_str(), bak.c_str(), TRUE);
+    }
+
+    JournalState st;
+    st.path = path;
+    std::vector<uint8_t> out(kMagic, kMagic + 4);
+    out.push_back((uint8_t)kFormatVersion); out.push_back(0); out.push_back(0); out.push_back(0);
+
+    auto add = [&](const std::vector<uint8_t>& body) -> LiveRecord {
+        AppendRecord(out, body);
+        return LiveRecord{ Hash64(body.data(), body.size()), (uint32_t)(kRecordHeaderBytes + body.size()) };
+    };
+    st.settings = add(EncodeSettings(lib));
+    st.order = add(EncodeOrder(lib));
+    st.combos.reserve(lib.combos.size());
+    for (const auto& c : lib.combos)
+        st.combos[c.uid] = add(EncodeCombo(c));
+    st.fileBytes = st.liveBytes = out.size();
+
+    // Full file next to the old one, then swapped in: a crash leaves one of the two intact
+    const std::wstring tmp = path + L".tmp";
+    if (!WriteWholeFile(tmp, L"wb", out)) { g_journal.valid = false; return false; }
+    if (!MoveFileExW(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        DeleteFileW(tmp.c_str());
+        g_journal.valid = false;
+        return false;
+    }
+
+    st.valid = true;
+    g_journal = std::move(st);
+    ++g_stats.rewrites;
+    g_stats.lastAppended = (uint32_t)(2 + lib.combos.size());
+    g_stats.fileBytes = g_journal.fileBytes;
+    g_stats.liveBytes = g_journal.liveBytes;
+    return true;
+}
+
+static bool WriteLocked(const std::wstring& path, const ComboLibrary& lib)
+{
+    JournalState& st = g_journal;
+    // Deleted, truncated or replaced behind our back: appending would leave
+    // records without a header (or after someone else's data).
+    if (!st.valid || st.path != path || !FileSizeIs(path, st.fileBytes))
+        return WriteSnapshotLocked(path, lib);
+
+    std::vector<uint8_t> out;
+    uint32_t appended = 0;
+    int64_t liveDelta = 0;
+    auto appendIfChanged = [&](LiveRecord& cur, const std::vector<uint8_t>& body) {
+        const uint64_t h = Hash64(body.data(), body.size());
+        const uint32_t bytes = (uint32_t)(kRecordHeaderBytes + body.size());
+        if (cur.bytes != 0 && cur.hash == h) return;
+        AppendRecord(out, body);
+        liveDelta += (int64_t)bytes - (int64_t)cur.bytes;
+        cur = LiveRecord{ h, bytes };
+        ++appended;
+    };
+
+    // Work on a copy: on I/O failure the state must still describe the file
+    LiveRecord settings = st.settings, order = st.order;
+    std::unordered_map<uint32_t, LiveRecord> combos = st.combos;
+
+    appendIfChanged(settings, EncodeSettings(lib));
+    std::unordered_set<uint32_t> present;
+    present.reserve(lib.combos.size());
+    for (const auto& c : lib.combos) {
+        if (c.uid == 0 || !present.insert(c.uid).second) return WriteSnapshotLocked(path, lib);
+        appendIfChanged(combos[c.uid], EncodeCombo(c));
+    }
+    for (auto it = combos.begin(); it != combos.end();) {
+        if (present.count(it->first)) { ++it; continue; }
+        AppendRecord(out, EncodeDelete(it->first));
+        liveDelta -= (int64_t)it->second.bytes;
+        ++appended;
+        it = combos.erase(it);
+    }
+    appendIfChanged(order, EncodeOrder(lib));
+
+    g_stats.lastAppended = appended;
+    if (out.empty()) return true;
+
+    if (!WriteWholeFile(path, L"ab", out)) {
+        // Partial append possible: only a full rewrite is safe now
+        st.valid = false;
+        return false;
+    }
+    st.settings = settings;
+    st.order = order;
+    st.combos = std::move(combos);
+    st.fileBytes += out.size();
+    st.liveBytes = (uint64_t)((int64_t)st.liveBytes + liveDelta);
+    g_stats.fileBytes = st.fileBytes;
+    g_stats.liveBytes = st.liveBytes;
+
+    if (st.fileBytes > 2 * st.liveBytes + kCompactSlackBytes)
+        return WriteSnapshotLocked(path, lib);
+    return true;
+}
+
+bool ComboStore_Write(const wchar_t* path, const ComboLibrary& lib)
+{
+    if (!path) return false;
+    std::lock_guard<std::mutex> lk(g_fileMutex);
+    return WriteLocked(path, lib);
+}
+
+// ============================================================
+// Background writer: a task of the persistence service
+// ============================================================
+static bool WriterTask(void*)
+{
+    std::unique_lock<std::mutex> lk(g_postMutex);
+    if (!g_hasPending) return true; // already written by an earlier run
+
+    std::wstring path = std::move(g_pendingPath);
+    ComboLibrary lib = std::move(g_pending);
+    g_hasPending = false;
+    lk.unlock();
+
+    const bool ok = ComboStore_Write(path.c_str(), lib);
+
+    lk.lock();
+    g_lastOk = ok;
+    return ok;
+}
+
+void ComboStore_StartWriter()
+{
+    std::lock_guard<std::mutex> lk(g_postMutex);
+    g_writerRun = true;
+}
+
+void ComboStore_Post(const wchar_t* path, ComboLibrary&& lib)
+{
+    if (!path) return;
+    bool async = false;
+    {
+        std::lock_guard<std::mutex> lk(g_postMutex);
+        if (g_writerRun) {
+            g_pendingPath = path;
+            g_pending = std::move(lib);
+            g_hasPending = true;
+            async = true;
+        }
+    }
+    if (async) {
+        // Several posts before the task runs: the latest library wins
+        Persist_PostTask(&WriterTask, nullptr);
+        return;
+    }
+    const bool ok = ComboStore_Write(path, lib);
+    std::lock_guard<std::mutex> lk(g_postMutex);
+    g_lastOk = ok;
+}
+
+bool ComboStore_Flush()
+{
+    Persist_Flush();
+    std::lock_guard<std::mutex> lk(g_postMutex);
+    return g_lastOk;
+}
+
+void ComboStore_StopWriter()
+{
+    {
+        std::lock_guard<std::mutex> lk(g_postMutex);
+        if (!g_writerRun) return;
+        g_writerRun = false;
+    }
+    // The pending snapshot still reaches the disk
+    Persist_Flush();
+}
+
+void ComboStore_GetStats(ComboStoreStats* out)
+{
+    if (!out) return;
+    std::lock_guard<std::mutex> lk(g_fileMutex);
+    *out = g_stats;
+}
+
+// ============================================================
+// V1..V5 text importer
+// ============================================================
+static std::wstring TrimLine(const std::wstring& s)
+{
+    size_t start = 0;
+    while (start < s.size() && (s[start] == L' ' || s[start] == L'\t' || s[start] == L'\r' || s[start] == L'\n'))
+        ++start;
+    size_t end = s.size();
+    while (end > start && (s[end - 1] == L' ' || s[end - 1] == L'\t' || s[end - 1] == L'\r' || s[end - 1] == L'\n'))
+        --end;
+    return s.substr(start, end - start);
+}
+
+static bool ReadLine(FILE* f, std::wstring& out)
+{
+    wchar_t buf[2048] = {};
+    if (!fgetws(buf, (int)_countof(buf), f))
+        return false;
+    out = TrimLine(buf);
+    if (!out.empty() && out.front() == 0xFEFF)
+        out.erase(out.begin());
+    return true;
+}
+
+static void ReadWhitelistEntries(FILE* f, unsigned count, ComboLibrary* out)
+{
+    out->whitelist.clear();
+    for (unsigned wi = 0; wi < count; ++wi) {
+        std::wstring entry;
+        if (!ReadLine(f, entry)) break;
+        if (entry.size() > 9 && entry.substr(0, 9) == L"WL_ENTRY ")
+            out->whitelist.push_back(entry.substr(9));
+    }
+}
+
+static bool ReadLegacyText(const wchar_t* path, ComboLibrary* out)
+{
+    FILE* f = nullptr;
+    if (_wfopen_s(&f, path, L"r") != 0 || !f) return false;
+
+    *out = ComboLibrary{};
+    std::wstring line;
+    if (!ReadLine(f, line)) { fclose(f); return false; }
+    bool isV5 = false, isV4 = false, isV3 = false, isV2 = false;
+    if (line == L"DRDRE_FREECOMBOS_V5") { isV5 = true; isV4 = true; isV3 = true; }
+    else if (line == L"DRDRE_FREECOMBOS_V4") { isV4 = true; isV3 = true; }
+    else if (line == L"DRDRE_FREECOMBOS_V3") isV3 = true;
+    else if (line == L"DRDRE_FREECOMBOS_V2") isV2 = true;
+    else if (line == L"DRDRE_FREECOMBOS_V1") {}
+    else { fclose(f); return false; }
+
+    // V5 : read the whitelist configuration before the combos - lire la config whitelist avant les combos
+    if (isV5) {
+        out->hasSettings = true;
+        std::wstring wlLine;
+        if (ReadLine(f, wlLine)) {
+            int wlm = 0;
+            if (swscanf_s(wlLine.c_str(), L"WL_MODE %d", &wlm) == 1)
+                out->wlMode = wlm;
+        }
+        // Wheel cooldown global (optionnel — compat anciens fichiers)
+        bool wlAlreadyRead = false;
+        if (ReadLine(f, wlLine)) {
+            int wce = 0; unsigned wcms = 150;
+            if (swscanf_s(wlLine.c_str(), L"WHEEL_CD %d %u", &wce, &wcms) == 2) {
+                // Nouveau format : ligne WHEEL_CD présente
+                out->wheelCDEnabled = (wce != 0);
+                out->wheelCDMs = wcms > 0 ? wcms : 150;
+            } else {
+                // Ancien format : pas de WHEEL_CD, cette ligne = WL_COUNT
+                unsigned wlCount2 = 0;
+                if (swscanf_s(wlLine.c_str(), L"WL_COUNT %u", &wlCount2) == 1) {
+                    ReadWhitelistEntries(f, wlCount2, out);
+                    wlAlreadyRead = true;
+                }
+            }
+        }
+        if (!wlAlreadyRead && ReadLine(f, wlLine)) {
+            unsigned wlCount = 0;
+            if (swscanf_s(wlLine.c_str(), L"WL_COUNT %u", &wlCount) == 1)
+                ReadWhitelistEntries(f, wlCount, out);
+        }
+    }
+
+    unsigned countU = 0;
+    if (!ReadLine(f, line) || swscanf_s(line.c_str(), L"%u", &countU) != 1) { fclose(f); return false; }
+    size_t count = (size_t)countU;
+
+    std::vector<FreeCombo> loaded;
+    bool parseOk = true;
+
+    for (size_t i = 0; i < count; ++i) {
+        FreeCombo combo;
+        if (!ReadLine(f, combo.name)) { parseOk = false; break; }
+
+        int mod = 0, keyType = 0, vk = 0, holdKeyType = 0, holdVk = 0, keyTypeIsHoldInt = 0;
+        unsigned analogParam = 50;
+        if (!ReadLine(f, line)) { parseOk = false; break; }
+        if (isV3 || isV2) {
+            // Lire 5 champs minimum, 6e (keyTypeIsHold) et 7e (analogParam) optionnels (compat anciens fichiers)
+            int nRead = swscanf_s(line.c_str(), L"%d %d %d %d %d %d %u",
+                &mod, &keyType, &vk, &holdKeyType, &holdVk, &keyTypeIsHoldInt, &analogParam);
+            if (nRead < 5) { parseOk = false; break; }
+        }
+        else {
+            if (swscanf_s(line.c_str(), L"%d %d %d", &mod, &keyType, &vk) != 3)
+            {
+                parseOk = false; break;
+            }
+        }
+        combo.trigger.modifier      = (FreeTriggerModifier)mod;
+        combo.trigger.keyType       = (FreeTriggerKeyType)keyType;
+        combo.trigger.vkCode        = (WORD)vk;
+        combo.trigger.holdKeyType   = (FreeTriggerKeyType)holdKeyType;
+        combo.trigger.holdVkCode    = (WORD)holdVk;
+        combo.trigger.keyTypeIsHold = (keyTypeIsHoldInt != 0);
+        combo.trigger.analogParam   = analogParam;
+
+        int en = 0, rep = 0, del = 0, isEx = 0; unsigned rcount = 0;
+        int crel = 0, lp = 0; unsigned lpms = 300;
+        if (!ReadLine(f, line)) { parseOk = false; break; }
+        if (isV4) swscanf_s(line.c_str(), L"%d %d %d %d %u %d %d %u",
+            &en, &rep, &del, &isEx, &rcount, &crel, &lp, &lpms);
+        else      swscanf_s(line.c_str(), L"%d %d %d %d", &en, &rep, &del, &isEx);
+        combo.enabled = (en != 0);
+        combo.repeatWhileHeld = (rep != 0);
+        combo.repeatDelayMs = del;
+        combo.isExample = (isEx != 0);
+        combo.repeatCount = rcount;
+        combo.cancelOnRelease = (crel != 0);
+        combo.longPressEnabled = (lp != 0);
+        combo.longPressMs = (lpms > 0) ? lpms : 300;
+
+        unsigned actionCountU = 0;
+        if (!ReadLine(f, line) || swscanf_s(line.c_str(), L"%u", &actionCountU) != 1)
+        {
+            parseOk = false; break;
+        }
+        size_t actionCount = (size_t)actionCountU;
+        for (size_t j = 0; j < actionCount; ++j) {
+            ComboAction action;
+            int type = 0, hid = 0, d = 0, btn = 0;
+            if (!ReadLine(f, line)) { parseOk = false; break; }
+            if (swscanf_s(line.c_str(), L"%d %d %d %d", &type, &hid, &d, &btn) != 4)
+            {
+                parseOk = false; break;
+            }
+            action.type = (ComboActionType)type;
+            action.keyHid = hid;
+            action.delayMs = d;
+            action.mouseButton = btn;
+            if (isV3) {
+                std::wstring txt;
+                if (!ReadLine(f, txt)) { parseOk = false; break; }
+                action.text = (txt == L"__EMPTY__") ? L"" : txt;
+            }
+            else {
+                int consumed = 0;
+                if (swscanf_s(line.c_str(), L"%d %d %d %d %n", &type, &hid, &d, &btn, &consumed) == 4 &&
+                    consumed > 0 && consumed < (int)line.size())
+                {
+                    std::wstring tail = TrimLine(line.substr((size_t)consumed));
+                    action.text = (tail == L"__EMPTY__") ? L"" : tail;
+                }
+                else {
+                    action.text.clear();
+                }
+            }
+            combo.actions.push_back(action);
+        }
+        if (!parseOk) break;
+        loaded.push_back(combo);
+    }
+    fclose(f);
+
+    // FIX : if the parsing was at least partially successful, we apply what we have - si le parsing a reussi au moins partiellement, on applique ce qu on a.
+    //  The old condition loaded.size() != count rejected EVERYTHING if 1 combo was corrupted. - L ancienne condition loaded.size() != count rejetait TOUT si 1 combo etait corrompu.
+    // Now we accept a partial LOAD rather than losing everything. - Desormais on accepte un LOAD partiel plutot que de tout perdre.
+    if (!parseOk && loaded.empty())
+        return false;   // Fichier totalement illisible -> echec propre
+
+    out->combos = std::move(loaded);
+    return true;
+}
@@ -0,0 +1,67 @@
+// combo_store.h
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "free_combo_system.h"
+
+// ============================================================
+// COMBO STORE - free_combos.dat
+// V6: binary journal of length-prefixed, CRC-32 checked records.
+//   header  "DCJ6" + u32 format version
+//   record  u32 length | u32 crc32(body) | body = u8 type, u8 version, payload
+// One Combo record per combo, keyed by its stable uid. A save appends only
+// the records whose content changed (combo, deletion, order, settings) and
+// loading replays the journal, the last record of a uid wins. When dead
+// records outweigh the live ones the file is compacted: a full snapshot is
+// written next to it, then swapped in. A torn tail (crash in the middle of
+// an append) is dropped at load and the next save rewrites the file.
+// Records carry their own version; a reader ignores trailing fields it does
+// not know, so fields can be appended without a new file format.
+// Writes run on the persistence service thread (persist_service.h) from a
+// snapshot: the combo lock is only held while the snapshot is copied.
+// Crash recovery of this file is the store's own: the service only schedules
+// the write (a task, not journaled there), the V6 journal above is what
+// survives a crash. The service journal never holds combo data.
+// V1..V5 text files are still read (ComboStore_ImportLegacy); the first save
+// after the import converts them and keeps the original as <file>.v5.bak.
+// ============================================================
+
+struct ComboLibrary
+{
+    std::vector<FreeCombo>    combos;          // list order = trigger priority
+    int                       wlMode = 0;
+    bool                      wheelCDEnabled = false;
+    uint32_t                  wheelCDMs = 150;
+    std::vector<std::wstring> whitelist;
+    bool                      hasSettings = false; // false: V1..V4 file, keep the current settings
+};
+
+struct ComboStoreStats
+{
+    uint64_t fileBytes = 0;
+    uint64_t liveBytes = 0;         // size of a fresh snapshot of the same library
+    uint32_t lastAppended = 0;      // records appended by the last write
+    uint32_t rewrites = 0;          // full snapshots written (conversion, compaction, recovery)
+    bool     legacy = false;        // last load came from a V1..V5 text file
+    bool     tornTail = false;      // last load dropped a damaged tail
+};
+
+// V6 journal or V1..V5 text. false: missing or unreadable file.
+bool ComboStore_Load(const wchar_t* path, ComboLibrary* out);
+// V1..V5 text only.
+bool ComboStore_ImportLegacy(const wchar_t* path, ComboLibrary* out);
+
+// Synchronous write on the calling thread. Every combo needs a uid != 0.
+bool ComboStore_Write(const wchar_t* path, const ComboLibrary& lib);
+
+// Background writer (a persistence service task): the latest snapshot wins, several
+// edits in a row make one write. Without a running writer, Post() writes synchronously.
+void ComboStore_StartWriter();
+void ComboStore_Post(const wchar_t* path, ComboLibrary&& lib);
+// Blocks until everything posted so far is on disk. Returns the last write result.
+bool ComboStore_Flush();
+void ComboStore_StopWriter(); // flushes first
+
+void ComboStore_GetStats(ComboStoreStats* out);
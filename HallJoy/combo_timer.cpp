@@ -0,0 +1,238 @@
+// combo_timer.cpp
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+#include "combo_timer.h"
+#include "free_combo_system.h"
+#include "logger.h"
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+// Wake up at least this often even without deadline: Tick() also resyncs the hook table.
+static constexpr DWORD kHousekeepingMs = 250;
+
+static HANDLE g_thread = nullptr;
+static HANDLE g_timer = nullptr;
+static HANDLE g_wakeEvent = nullptr;
+static std::atomic<bool> g_run{ false };
+static bool g_highRes = false;
+static std::atomic<int> g_suspended{ 0 };
+static std::mutex g_tickMutex;   // held by the thread around Tick(): Suspend waits on it
+
+// Deadline the thread is currently sleeping on: bit 32 = valid, low 32 bits = ms.
+static std::atomic<uint64_t> g_armed{ 0 };
+static constexpr uint64_t kArmedValid = 1ull << 32;
+
+static const LONGLONG g_qpcFreq = []() {
+    LARGE_INTEGER f{};
+    QueryPerformanceFrequency(&f);
+    return f.QuadPart > 0 ? f.QuadPart : 1;
+}();
+
+// ---- Stats ----
+static const uint32_t kBucketUpperUs[COMBO_TIMER_HIST_BUCKETS] = {
+    100, 250, 500, 1000, 2000, 5000, 10000, 20000, UINT32_MAX
+};
+
+static std::atomic<uint64_t> g_wakeups{ 0 };
+static std::atomic<uint64_t> g_sumLateUs{ 0 };
+static std::atomic<uint32_t> g_maxLateUs{ 0 };
+static std::atomic<uint32_t> g_buckets[COMBO_TIMER_HIST_BUCKETS]{};
+
+uint64_t ComboTimer_NowUs()
+{
+    LARGE_INTEGER c{};
+    QueryPerformanceCounter(&c);
+    const uint64_t q = (uint64_t)c.QuadPart, f = (uint64_t)g_qpcFreq;
+    return (q / f) * 1000000ull + ((q % f) * 1000000ull) / f;
+}
+
+static void RecordLateness(uint32_t deadlineMs)
+{
+    const uint64_t nowUs = ComboTimer_NowUs();
+    const int32_t lateMs = (int32_t)((uint32_t)(nowUs / 1000) - deadlineMs);
+    const int64_t late = (int64_t)lateMs * 1000 + (int64_t)(nowUs % 1000);
+    const uint32_t us = (late <= 0) ? 0u : (uint32_t)std::min<int64_t>(late, UINT32_MAX);
+
+    g_wakeups.fetch_add(1, std::memory_order_relaxed);
+    g_sumLateUs.fetch_add(us, std::memory_order_relaxed);
+    uint32_t cur = g_maxLateUs.load(std::memory_order_relaxed);
+    while (us > cur && !g_maxLateUs.compare_exchange_weak(cur, us, std::memory_order_relaxed)) {}
+
+    int b = 0;
+    while (b < COMBO_TIMER_HIST_BUCKETS - 1 && us > kBucketUpperUs[b]) ++b;
+    g_buckets[b].fetch_add(1, std::memory_order_relaxed);
+}
+
+void ComboTimer_Suspend()
+{
+    g_suspended.fetch_add(1, std::memory_order_acq_rel);
+    std::lock_guard<std::mutex> lock(g_tickMutex);   // the Tick in flight, if any
+}
+
+void ComboTimer_Resume()
+{
+    if (g_suspended.fetch_sub(1, std::memory_order_acq_rel) == 1 && g_wakeEvent)
+        SetEvent(g_wakeEvent);
+}
+
+void ComboTimer_NotifyDeadline(uint32_t deadlineMs)
+{
+    // g_armed is 0 while a Tick runs: only a deadline armed after it can be skipped.
+    const uint64_t armed = g_armed.load(std::memory_order_acquire);
+    if ((armed & kArmedValid) && (int32_t)(deadlineMs - (uint32_t)armed) >= 0)
+        return; // the thread already wakes up before this one
+    if (g_wakeEvent) SetEvent(g_wakeEvent);
+}
+
+static DWORD WINAPI ThreadProc(LPVOID)
+{
+    // Same class as the input thread: repeats are user-visible timing.
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
+
+    HANDLE handles[2] = { g_wakeEvent, g_timer };
+    while (g_run.load(std::memory_order_relaxed))
+    {
+        DWORD next = 0;
+        bool has = false;
+        {
+            std::unique_lock<std::mutex> lock(g_tickMutex);
+            if (g_suspended.load(std::memory_order_acquire) != 0)
+            {
+                lock.unlock();
+                g_armed.store(0, std::memory_order_release);
+                CancelWaitableTimer(g_timer);
+                WaitForSingleObject(g_wakeEvent, INFINITE);   // Resume / Stop
+                continue;
+            }
+            // Nothing armed while Tick runs: a deadline scheduled from here on
+            // (under the combo lock, so either Tick sees it or it sees this)
+            // always signals, even one at or after the deadline we woke up for.
+            g_armed.store(0, std::memory_order_release);
+            has = FreeComboSystem::Tick(&next);
+        }
+
+        DWORD waitMs = kHousekeepingMs;
+        if (has)
+        {
+            g_armed.store(kArmedValid | next, std::memory_order_release);
+            const uint64_t nowUs = ComboTimer_NowUs();
+            const int64_t dueUs = (int64_t)(int32_t)(next - (uint32_t)(nowUs / 1000)) * 1000 - (int64_t)(nowUs % 1000);
+            if (dueUs <= 0) continue; // already due
+
+            // Relative due time, 100 ns units
+            LARGE_INTEGER due{};
+            due.QuadPart = -(LONGLONG)dueUs * 10;
+            SetWaitableTimer(g_timer, &due, 0, nullptr, nullptr, FALSE);
+            waitMs = (DWORD)std::min<int64_t>(kHousekeepingMs, dueUs / 1000 + 50); // safety net only
+        }
+        else
+        {
+            CancelWaitableTimer(g_timer);
+        }
+
+        const DWORD r = WaitForMultipleObjects(2, handles, FALSE, waitMs);
+        if (r == WAIT_OBJECT_0 + 1 && has)
+            RecordLateness(next);
+    }
+    CancelWaitableTimer(g_timer);
+    return 0;
+}
+
+bool ComboTimer_Start()
+{
+    if (g_thread) return true;
+
+    g_timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    g_highRes = (g_timer != nullptr);
+    if (!g_timer) // before Windows 10 1803
+        g_timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+    g_wakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (!g_timer || !g_wakeEvent)
+    {
+        if (g_timer) { CloseHandle(g_timer); g_timer = nullptr; }
+        if (g_wakeEvent) { CloseHandle(g_wakeEvent); g_wakeEvent = nullptr; }
+        return false;
+    }
+
+    g_run.store(true, std::memory_order_relaxed);
+    g_thread = CreateThread(nullptr, 0, ThreadProc, nullptr, 0, nullptr);
+    if (!g_thread)
+    {
+        g_run.store(false, std::memory_order_relaxed);
+        CloseHandle(g_timer); g_timer = nullptr;
+        CloseHandle(g_wakeEvent); g_wakeEvent = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void ComboTimer_Stop()
+{
+    if (!g_thread) return;
+
+    g_run.store(false, std::memory_order_relaxed);
+    if (g_wakeEvent) SetEvent(g_wakeEvent);
+
+    WaitForSingleObject(g_thread, INFINITE);
+    CloseHandle(g_thread);
+    g_thread = nullptr;
+
+    g_armed.store(0, std::memory_order_release);
+    if (g_timer) { CloseHandle(g_timer); g_timer = nullptr; }
+    if (g_wakeEvent) { CloseHandle(g_wakeEvent); g_wakeEvent = nullptr; }
+}
+
+void ComboTimer_GetStats(ComboTimerStats* out)
+{
+    if (!out) return;
+    out->wakeups = g_wakeups.load(std::memory_order_relaxed);
+    out->sumLateUs = g_sumLateUs.load(std::memory_order_relaxed);
+    out->maxLateUs = g_maxLateUs.load(std::memory_order_relaxed);
+    for (int i = 0; i < COMBO_TIMER_HIST_BUCKETS; ++i)
+        out->buckets[i] = g_buckets[i].load(std::memory_order_relaxed);
+    out->highResolution = g_highRes;
+}
+
+void ComboTimer_ResetStats()
+{
+    g_wakeups.store(0, std::memory_order_relaxed);
+    g_sumLateUs.store(0, std::memory_order_relaxed);
+    g_maxLateUs.store(0, std::memory_order_relaxed);
+    for (auto& b : g_buckets) b.store(0, std::memory_order_relaxed);
+}
+
+uint32_t ComboTimer_GetBucketUpperUs(int bucket)
+{
+    if (bucket < 0 || bucket >= COMBO_TIMER_HIST_BUCKETS) return 0;
+    return kBucketUpperUs[bucket];
+}
+
+void ComboTimer_LogStats()
+{
+    if (!Logger::IsEnabled()) return;
+    ComboTimerStats st;
+    ComboTimer_GetStats(&st);
+    if (st.wakeups == 0) return;
+
+    char buf[160];
+    snprintf(buf, sizeof(buf), "wakeups=%llu avgLate=%lluus maxLate=%uus hires=%d [",
+        (unsigned long long)st.wakeups, (unsigned long long)(st.sumLateUs / st.wakeups),
+        st.maxLateUs, st.highResolution ? 1 : 0);
+    std::string line = buf;
+    for (int i = 0; i < COMBO_TIMER_HIST_BUCKETS; ++i)
+    {
+        snprintf(buf, sizeof(buf), (i + 1 < COMBO_TIMER_HIST_BUCKETS) ? "%u " : "%u]", st.buckets[i]);
+        line += buf;
+    }
+    Logger::Info("COMBO_TIMER", line);
+}
@@ -0,0 +1,48 @@
+// combo_timer.h
+#pragma once
+#include <cstdint>
+
+// ============================================================
+// COMBO TIMING SERVICE
+// Dedicated thread that sleeps on a high-resolution waitable timer until
+// the next combo deadline (long press, repeat-while-held) and then runs
+// FreeComboSystem::Tick(). Independent of the UI message loop: modal
+// dialogs, window drags or heavy painting no longer delay repeats.
+// FreeComboSystem calls ComboTimer_NotifyDeadline() whenever it arms a
+// deadline; the thread is only woken when it is earlier than the armed one.
+// ============================================================
+
+bool ComboTimer_Start();
+void ComboTimer_Stop();
+
+// A deadline (FreeComboSystem::NowMs() space) was scheduled. Any thread, never blocks.
+void ComboTimer_NotifyDeadline(uint32_t deadlineMs);
+
+// While suspended the thread never calls FreeComboSystem::Tick(): a simulator
+// (combo_sim.h) owns the clock and ticks itself. Suspend returns once a Tick
+// in progress has finished. Nests; any thread.
+void ComboTimer_Suspend();
+void ComboTimer_Resume();
+
+// QPC in microseconds: default time base of the combo engine (NowMs = NowUs / 1000),
+// so lateness can be measured below the millisecond.
+uint64_t ComboTimer_NowUs();
+
+// ---- Lateness stats (timer wake-up vs deadline) ----
+constexpr int COMBO_TIMER_HIST_BUCKETS = 9;
+
+struct ComboTimerStats
+{
+    uint64_t wakeups = 0;      // timer expirations handled
+    uint64_t sumLateUs = 0;
+    uint32_t maxLateUs = 0;
+    uint32_t buckets[COMBO_TIMER_HIST_BUCKETS]{};
+    bool highResolution = false; // CREATE_WAITABLE_TIMER_HIGH_RESOLUTION available
+};
+
+void ComboTimer_GetStats(ComboTimerStats* out);
+void ComboTimer_ResetStats();
+// Upper bound (microseconds, inclusive) of a histogram bucket. Last bucket = UINT32_MAX.
+uint32_t ComboTimer_GetBucketUpperUs(int bucket);
+// One-line summary through Logger (throttled by caller).
+void ComboTimer_LogStats();
@@ -1,7 +1,19 @@
 #include "free_combo_system.h"
 #include "backend.h"
-#include "bindings.h"  // Bindings_IsHidBound — used to decide ViGEm vs pure SendInput
+#include "app_profiles.h"  // AppProfiles_IsHidBound — used to decide ViGEm vs pure SendInput
+#include "input_bus.h" // état maintenu canonique + flux d'événements
+#include "output_coalescer.h"
+#include "sendinput_sink.h"
+#include "macro_compiler.h"
+#include "combo_clock.h"
+#include "combo_timer.h"  // deadlines -> service thread
+#include "trigger_automaton.h"
+#include "analog_trigger.h"
+#include "actuation.h"     // AnalogActuation triggers: key state
+#include "combo_store.h"
+#include "slot_map.h"
 #include <windows.h>
+#include <algorithm>
 #include <vector>
 #include <mutex>
 #include <atomic>
@@ -11,28 +23,6 @@
 #include <string>
 #include <utility>
 
-static std::wstring TrimLine(const std::wstring& s)
-{
-    size_t start = 0;
-    while (start < s.size() && (s[start] == L' ' || s[start] == L'\t' || s[start] == L'\r' || s[start] == L'\n'))
-        ++start;
-    size_t end = s.size();
-    while (end > start && (s[end - 1] == L' ' || s[end - 1] == L'\t' || s[end - 1] == L'\r' || s[end - 1] == L'\n'))
-        --end;
-    return s.substr(start, end - start);
-}
-
-static bool ReadLine(FILE* f, std::wstring& out)
-{
-    wchar_t buf[2048] = {};
-    if (!fgetws(buf, (int)_countof(buf), f))
-        return false;
-    out = TrimLine(buf);
-    if (!out.empty() && out.front() == 0xFEFF)
-        out.erase(out.begin());
-    return true;
-}
-
 // ============================================================
 // FREE COMBO SYSTEM - DrDre_WASD v2.0
 // ============================================================
@@ -49,60 +39,22 @@ struct QueueItem {
 
 // --- VARIABLES INTERNES ---
 namespace {
-    std::vector<FreeCombo>          g_combos;
+    // Registry: ids are generational handles (slot_map.h), stable across
+    // delete / reorder; a stale id resolves to nothing instead of another combo.
+    // Priority is a separate list of ids, so a reorder never moves a combo.
+    SlotMap<FreeCombo>              g_combos;
+    std::vector<int>                g_order;              // ids, list order (last = highest priority)
+    std::vector<uint32_t>           g_rank;               // per slot: position in g_order
+    // Guards the registry and per-combo runtime state. Held for short sections
+    // only: the trigger automaton is compiled outside of it (BuildTriggers).
     std::mutex                      g_comboMutex;
+    uint32_t                        g_nextComboUid = 1;   // sous g_comboMutex, voir FreeCombo::uid
 
-    // Modifier state (updated by keyboard hook)
-    std::atomic<bool> g_ctrlHeld = false;
-    std::atomic<bool> g_shiftHeld = false;
-    std::atomic<bool> g_altHeld = false;
-    std::atomic<bool> g_winHeld = false;
-
-
-    // Physical key held state (independent of lParam repeat bit; avoids key auto-repeat bursts)
-    // 256 VKs -> 4x64-bit bitset
-    std::atomic<unsigned long long> g_keyHeldBits0{ 0 };
-    std::atomic<unsigned long long> g_keyHeldBits1{ 0 };
-    std::atomic<unsigned long long> g_keyHeldBits2{ 0 };
-    std::atomic<unsigned long long> g_keyHeldBits3{ 0 };
-
-    static inline bool FC_IsKeyHeld(WORD vk) {
-        unsigned idx = (unsigned)vk;
-        unsigned bucket = idx >> 6; // /64
-        unsigned bit = idx & 63;
-        unsigned long long mask = 1ULL << bit;
-        switch (bucket) {
-        case 0: return (g_keyHeldBits0.load(std::memory_order_relaxed) & mask) != 0;
-        case 1: return (g_keyHeldBits1.load(std::memory_order_relaxed) & mask) != 0;
-        case 2: return (g_keyHeldBits2.load(std::memory_order_relaxed) & mask) != 0;
-        default:return (g_keyHeldBits3.load(std::memory_order_relaxed) & mask) != 0;
-        }
-    }
+    // Held keys / buttons / modifiers: canonical state of the input bus (input_bus.h),
+    // no local copy. Events arrive through g_busReader (PumpInputBus, input thread).
+    InputBusReader g_busReader;
 
-    static inline void FC_SetKeyHeld(WORD vk, bool held) {
-        unsigned idx = (unsigned)vk;
-        unsigned bucket = idx >> 6;
-        unsigned bit = idx & 63;
-        unsigned long long mask = 1ULL << bit;
-        auto setBits = [&](std::atomic<unsigned long long>& bits) {
-            unsigned long long cur = bits.load(std::memory_order_relaxed);
-            for (;;) {
-                unsigned long long next = held ? (cur | mask) : (cur & ~mask);
-                if (bits.compare_exchange_weak(cur, next, std::memory_order_relaxed, std::memory_order_relaxed))
-                    break;
-            }
-            };
-        switch (bucket) {
-        case 0: setBits(g_keyHeldBits0); break;
-        case 1: setBits(g_keyHeldBits1); break;
-        case 2: setBits(g_keyHeldBits2); break;
-        default:setBits(g_keyHeldBits3); break;
-        }
-    }
-    // Mouse state
-    std::atomic<bool> g_leftHeld = false;
-    std::atomic<bool> g_rightHeld = false;
-    std::atomic<bool> g_middleHeld = false;
+    // Mouse double-click detection (trigger capture; combos go through the automaton)
     std::atomic<DWORD> g_lastLeftDownTick = 0;
     std::atomic<DWORD> g_lastRightDownTick = 0;
 
@@ -118,12 +70,48 @@ namespace {
     std::mutex              g_queueMutex;
     std::condition_variable g_queueCv;
 
+    // ── Sortie macro ─────────────────────────────────────────
+    // Worker thread only: events due at the same deadline go out in one SendInput.
+    SendInputSink   g_sendInputSink;
+    OutputCoalescer g_out{ &g_sendInputSink };
+    OutputPacing    g_pacing;        // UI copy, taken by the worker at the start of each run
+    std::mutex      g_pacingMutex;
+
+    // ── Horloge + simulation ─────────────────────────────────
+    // Every engine time read goes through ClockNow() (nullptr = QPC, see ComboTimer_NowUs).
+    // The worker's output waits stay on real time: they pace real SendInput.
+    std::atomic<IComboClock*>        g_clock{ nullptr };
+    std::atomic<bool>                g_dryRun{ false };  // simulation: fire = observer only, no macro run
+    FreeComboSystem::ComboObserverFn g_observer = nullptr; // set while the engine is idle (simulation setup)
+    void*                            g_observerUser = nullptr;
+
+    // ── Échéances (long press, repeat-while-held) ────────────
+    // Min-heap under g_comboMutex, drained by Tick() on the combo_timer thread:
+    // no more scan of every combo on each UI timer tick. Entries that no longer
+    // match the combo state (_lpDeadline / _repeatAt) are dropped when popped.
+    enum class DeadlineKind : uint8_t { LongPress, Repeat };
+    struct ComboDeadline { DWORD at; int id; DeadlineKind kind; };
+    std::vector<ComboDeadline> g_deadlines;
+    // Repeat paused by a released modifier / hold key while the trigger is still down
+    static constexpr DWORD kRepeatRecheckMs = 10;
+
+    // ── Run en cours (cancel-on-release) ─────────────────────
+    // Trigger of the macro being played, checked on key / button up.
+    std::mutex        g_runMutex;
+    FreeTrigger       g_runTrigger;
+    std::atomic<bool> g_runCancelOnRelease{ false };
+
+    // ── Macro VM (worker thread only) ────────────────────────
+    MacroProgram    g_program;       // actions of the current run, compiled
+    MacroVm         g_vm;            // variables persist across the N runs of one trigger
+
     // ── Watchdog ─────────────────────────────────────────────────────────────
     static constexpr DWORD    kWD_MaxRuntimeMs = 10000;
-    static constexpr uint32_t kWD_MaxActions = 500;
+    static constexpr uint32_t kWD_MaxActions = 500;  // floor; a run may do what its loops unroll to
     static constexpr uint32_t kWD_MaxTrigsPerSec = 50;
     std::atomic<DWORD>    g_wdStartTick{ 0 };
     std::atomic<uint32_t> g_wdActionCount{ 0 };
+    uint64_t              g_wdActionLimit = kWD_MaxActions; // worker thread, set per queued run
     std::atomic<DWORD>    g_wdRateTick{ 0 };
     std::atomic<uint32_t> g_wdRateCount{ 0 };
     std::wstring          g_wdCurrentComboName;
@@ -136,7 +124,26 @@ namespace {
     // ── Wheel Cooldown global ─────────────────────────────────
     std::atomic<bool>     g_wheelCDEnabled{ false };
     std::atomic<uint32_t> g_wheelCDMs{ 150 };
-    DWORD                 g_wheelCDLastFire = 0; // dernier tir molette (tous combos)
+    std::atomic<DWORD>    g_wheelCDLastFire{ 0 }; // dernier tir molette (tous combos) — hook + input thread
+
+    // ── Tables lock-free pour le hook clavier ────────────────
+    // Par VK : conditions des combos actifs qui ont ce VK comme trigger clavier, packées
+    // (bit 31 = utilisée, 0..7 modificateur, 8..15 holdKeyType, 16..23 holdVkCode).
+    // Reconstruit sous g_comboMutex (API + Tick), lu sans lock depuis KeyboardBlockHookProc.
+    constexpr int         kTriggerVkConds = 4;
+    std::atomic<uint32_t> g_triggerVkConds[256][kTriggerVkConds]{};
+    // Every enabled trigger compiled into one automaton (id = combo id): a press is one
+    // automaton step instead of a scan of all combos. Rebuilt with the table above when the
+    // triggers change (signature), fed by the input thread.
+    TriggerAutomaton      g_triggerAutomaton;
+    uint64_t              g_triggerSignature = 0;
+    uint64_t              g_triggerBuildSeq = 0;     // last snapshot taken
+    uint64_t              g_triggerPublishedSeq = 0; // last build swapped in (an older one is dropped)
+    std::vector<uint32_t> g_triggerMatches;      // reused per press
+    // Whitelist évaluée sur la fenêtre au premier plan (rafraîchie au changement de focus)
+    std::atomic<bool>     g_fgInjectionAllowed{ true };
+    // Analogs a macro holds (HID bit per chunk): EmergencyStop releases them
+    std::atomic<uint64_t> g_macroAnalogHids[4]{};
 
     // Trigger CAPTURE
     std::atomic<bool>   g_capturing = false;
@@ -161,6 +168,24 @@ std::wstring FreeTriggerModifierToString(FreeTriggerModifier mod)
     }
 }
 
+static std::wstring KeyboardKeyName(WORD vk)
+{
+    // Convert VK to readable name
+    wchar_t buf[64] = {};
+    UINT scanCode = MapVirtualKeyW(vk, MAPVK_VK_TO_VSC);
+    LONG lParam = (scanCode << 16);
+    // Extended keys
+    if (vk == VK_INSERT || vk == VK_DELETE || vk == VK_HOME || vk == VK_END ||
+        vk == VK_PRIOR || vk == VK_NEXT || vk == VK_LEFT || vk == VK_RIGHT ||
+        vk == VK_UP || vk == VK_DOWN || vk == VK_NUMLOCK ||
+        vk == VK_RCONTROL || vk == VK_RMENU || vk == VK_DIVIDE)
+        lParam |= (1 << 24);
+    GetKeyNameTextW(lParam, buf, 64);
+    if (buf[0]) return std::wstring(buf);
+    // Fallback: generic name
+    return L"Key(" + std::to_wstring(vk) + L")";
+}
+
 std::wstring FreeTriggerKeyTypeToString(FreeTriggerKeyType type, WORD vk)
 {
     switch (type) {
@@ -173,22 +198,11 @@ std::wstring FreeTriggerKeyTypeToString(FreeTriggerKeyType type, WORD vk)
     case FreeTriggerKeyType::WheelDown:   return L"Wheel down";
     case FreeTriggerKeyType::MouseDoubleLeft:  return L"Double left click";
     case FreeTriggerKeyType::MouseDoubleRight: return L"Double right click";
-    case FreeTriggerKeyType::Keyboard: {
-        // Convert VK to readable name
-        wchar_t buf[64] = {};
-        UINT scanCode = MapVirtualKeyW(vk, MAPVK_VK_TO_VSC);
-        LONG lParam = (scanCode << 16);
-        // Extended keys
-        if (vk == VK_INSERT || vk == VK_DELETE || vk == VK_HOME || vk == VK_END ||
-            vk == VK_PRIOR || vk == VK_NEXT || vk == VK_LEFT || vk == VK_RIGHT ||
-            vk == VK_UP || vk == VK_DOWN || vk == VK_NUMLOCK ||
-            vk == VK_RCONTROL || vk == VK_RMENU || vk == VK_DIVIDE)
-            lParam |= (1 << 24);
-        GetKeyNameTextW(lParam, buf, 64);
-        if (buf[0]) return std::wstring(buf);
-        // Fallback: generic name
-        return L"Key(" + std::to_wstring(vk) + L")";
-    }
+    case FreeTriggerKeyType::Keyboard:              return KeyboardKeyName(vk);
+    case FreeTriggerKeyType::AnalogDepth:           return KeyboardKeyName(vk) + L" depth";
+    case FreeTriggerKeyType::AnalogVelocity:        return KeyboardKeyName(vk) + L" speed";
+    case FreeTriggerKeyType::AnalogDoubleActuation: return KeyboardKeyName(vk) + L" double";
+    case FreeTriggerKeyType::AnalogActuation:       return KeyboardKeyName(vk) + L" actuation";
     default: return L"?";
     }
 }
@@ -214,13 +228,16 @@ std::wstring FreeTrigger::ToString() const
         result += keyTypeIsHold ? L" + [hold] " : L" + [tap] ";
     }
     result += FreeTriggerKeyTypeToString(keyType, vkCode);
+    if (FreeTriggerKeyTypeIsAnalog(keyType) && keyType != FreeTriggerKeyType::AnalogActuation)
+        result += L" " + std::to_wstring(analogParam) +
+            (keyType == FreeTriggerKeyType::AnalogVelocity ? L" mm/s" : L"%");
     return result;
 }
 
 static bool TriggerKeyEquals(FreeTriggerKeyType aType, WORD aVk, FreeTriggerKeyType bType, WORD bVk)
 {
     if (aType != bType) return false;
-    if (aType == FreeTriggerKeyType::Keyboard)
+    if (aType == FreeTriggerKeyType::Keyboard || FreeTriggerKeyTypeIsAnalog(aType))
         return aVk == bVk;
     return true;
 }
@@ -228,21 +245,35 @@ static bool TriggerKeyEquals(FreeTriggerKeyType aType, WORD aVk, FreeTriggerKeyT
 static bool IsTriggerKeyHeld(FreeTriggerKeyType type, WORD vk)
 {
     switch (type) {
-    case FreeTriggerKeyType::MouseLeft:   return g_leftHeld;
-    case FreeTriggerKeyType::MouseRight:  return g_rightHeld;
-    case FreeTriggerKeyType::MouseMiddle: return g_middleHeld;
-    case FreeTriggerKeyType::Keyboard:    return (GetAsyncKeyState(vk) & 0x8000) != 0;
+    case FreeTriggerKeyType::MouseLeft:   return InputBus_IsMouseHeld(InputMouseButton::Left);
+    case FreeTriggerKeyType::MouseRight:  return InputBus_IsMouseHeld(InputMouseButton::Right);
+    case FreeTriggerKeyType::MouseMiddle: return InputBus_IsMouseHeld(InputMouseButton::Middle);
+    case FreeTriggerKeyType::MouseX1:     return InputBus_IsMouseHeld(InputMouseButton::X1);
+    case FreeTriggerKeyType::MouseX2:     return InputBus_IsMouseHeld(InputMouseButton::X2);
+    case FreeTriggerKeyType::Keyboard:    return InputBus_IsKeyHeld(vk);
+    // Analog : la profondeur fait foi (touche non bindée au clavier OS possible)
+    case FreeTriggerKeyType::AnalogDepth:
+    case FreeTriggerKeyType::AnalogVelocity:
+    case FreeTriggerKeyType::AnalogDoubleActuation:
+        return BackendUI_GetRawMilli(VkToHid(vk)) > ANALOG_TRIGGER_RELEASED_M;
+    case FreeTriggerKeyType::AnalogActuation:
+        return Actuation_IsDown(VkToHid(vk));
     default: return false;
     }
 }
 
+static bool IsCtrlHeld()  { return InputBus_IsKeyHeld(VK_LCONTROL) || InputBus_IsKeyHeld(VK_RCONTROL) || InputBus_IsKeyHeld(VK_CONTROL); }
+static bool IsShiftHeld() { return InputBus_IsKeyHeld(VK_LSHIFT) || InputBus_IsKeyHeld(VK_RSHIFT) || InputBus_IsKeyHeld(VK_SHIFT); }
+static bool IsAltHeld()   { return InputBus_IsKeyHeld(VK_LMENU) || InputBus_IsKeyHeld(VK_RMENU) || InputBus_IsKeyHeld(VK_MENU); }
+static bool IsWinHeld()   { return InputBus_IsKeyHeld(VK_LWIN) || InputBus_IsKeyHeld(VK_RWIN); }
+
 static void SetCAPTUREModifierFromCurrentState(FreeTrigger& out)
 {
-    if (g_ctrlHeld)  out.modifier = FreeTriggerModifier::Ctrl;
-    else if (g_shiftHeld) out.modifier = FreeTriggerModifier::Shift;
-    else if (g_altHeld)   out.modifier = FreeTriggerModifier::Alt;
-    else if (g_winHeld)   out.modifier = FreeTriggerModifier::Win;
-    else                  out.modifier = FreeTriggerModifier::None;
+    if (IsCtrlHeld())       out.modifier = FreeTriggerModifier::Ctrl;
+    else if (IsShiftHeld()) out.modifier = FreeTriggerModifier::Shift;
+    else if (IsAltHeld())   out.modifier = FreeTriggerModifier::Alt;
+    else if (IsWinHeld())   out.modifier = FreeTriggerModifier::Win;
+    else                    out.modifier = FreeTriggerModifier::None;
 }
 
 static bool IsModifierVk(WORD vk)
@@ -261,12 +292,90 @@ static void NormalizeCAPTUREdTrigger(FreeTrigger& t)
         t.modifier = FreeTriggerModifier::None;
 }
 
+static DWORD ClockNow()
+{
+    IComboClock* c = g_clock.load(std::memory_order_acquire);
+    return c ? (DWORD)c->NowMs() : (DWORD)(ComboTimer_NowUs() / 1000);
+}
+
+// --- Deadlines (caller holds g_comboMutex) ---
+static bool DeadlineLater(const ComboDeadline& a, const ComboDeadline& b)
+{
+    return (int32_t)(a.at - b.at) > 0; // wrap-safe, comme now - then
+}
+
+static void ScheduleUnlocked(const FreeCombo& combo, DeadlineKind kind, DWORD at)
+{
+    g_deadlines.push_back({ at, combo._id, kind });
+    std::push_heap(g_deadlines.begin(), g_deadlines.end(), DeadlineLater);
+    ComboTimer_NotifyDeadline(at);
+}
+
+static void ArmLongPressUnlocked(FreeCombo& combo)
+{
+    combo._lpPressStartTime = ClockNow();
+    combo._lpWaiting        = true;
+    combo._lpFired          = false;
+    combo._lpDeadline       = combo._lpPressStartTime + combo.longPressMs;
+    ScheduleUnlocked(combo, DeadlineKind::LongPress, combo._lpDeadline);
+}
+
+static void ArmRepeatUnlocked(FreeCombo& combo, DWORD at)
+{
+    combo._repeatArmed = true;
+    combo._repeatAt    = at;
+    ScheduleUnlocked(combo, DeadlineKind::Repeat, at);
+}
+
+// Combos replaced wholesale (load): rebuild the heap from the combo state.
+// Delete / reorder keep the heap, entries of a deleted id no longer resolve.
+static void RescheduleAllUnlocked()
+{
+    g_deadlines.clear();
+    for (int id : g_order) {
+        const FreeCombo& c = *g_combos.Get(id);
+        if (c._lpWaiting && !c._lpFired)
+            g_deadlines.push_back({ c._lpDeadline, id, DeadlineKind::LongPress });
+        if (c._repeatArmed)
+            g_deadlines.push_back({ c._repeatAt, id, DeadlineKind::Repeat });
+    }
+    std::make_heap(g_deadlines.begin(), g_deadlines.end(), DeadlineLater);
+    if (!g_deadlines.empty())
+        ComboTimer_NotifyDeadline(g_deadlines.front().at);
+}
+
+static void NotifyObserver(FreeComboSystem::ComboSimEvent ev, const FreeCombo* combo)
+{
+    if (!g_observer) return;
+    g_observer(g_observerUser, ev, combo ? combo->_id : -1, ClockNow());
+}
+
+// --- Registry (caller holds g_comboMutex) ---
+static void RebuildRankUnlocked()
+{
+    g_rank.assign(g_combos.SlotCount(), 0);
+    for (uint32_t i = 0; i < (uint32_t)g_order.size(); ++i)
+        g_rank[SlotMap<FreeCombo>::SlotOf(g_order[i])] = i;
+}
+
+static int InsertComboUnlocked(FreeCombo&& c)
+{
+    const int id = g_combos.Insert(std::move(c));
+    if (id < 0) return -1;
+    g_combos.Get(id)->_id = id;
+    g_order.push_back(id);
+    const uint32_t slot = SlotMap<FreeCombo>::SlotOf(id);
+    if (g_rank.size() <= slot) g_rank.resize(slot + 1);
+    g_rank[slot] = (uint32_t)g_order.size() - 1;
+    return id;
+}
+
 static constexpr DWORD kCAPTURESecondInputWindowMs = 900;
 
 static void FinalizeSingleCAPTUREIfTimeoutUnlocked()
 {
     if (!g_capturing || !g_CAPTUREWaitingSecond) return;
-    DWORD now = GetTickCount();
+    DWORD now = ClockNow();
     if (now - g_CAPTUREFirstTick < kCAPTURESecondInputWindowMs)
         return;
 
@@ -320,7 +429,7 @@ static bool HandleCAPTUREInput(FreeTriggerKeyType keyType, WORD vkCode)
         g_CAPTUREFirstInput = {};
         g_CAPTUREFirstInput.keyType = keyType;
         g_CAPTUREFirstInput.vkCode = vkCode;
-        g_CAPTUREFirstTick = GetTickCount();
+        g_CAPTUREFirstTick = ClockNow();
         g_CAPTUREWaitingSecond = true;
         return true;
     }
@@ -347,6 +456,12 @@ static bool HandleCAPTUREInput(FreeTriggerKeyType keyType, WORD vkCode)
 }
 
 // --- WORKER THREAD ---
+static OutputPacing GetPacingSnapshot()
+{
+    std::lock_guard<std::mutex> lk(g_pacingMutex);
+    return g_pacing;
+}
+
 static bool InjectionAllowed()
 {
     int mode = g_wlMode.load(std::memory_order_relaxed);
@@ -369,114 +484,168 @@ static bool InjectionAllowed()
     return false;
 }
 
-static bool ExecAction(const ComboAction& action)
+// Per action: the foreground cache (refreshed on focus and whitelist changes),
+// not an OpenProcess for every key of a macro
+static bool InjectionAllowedCached()
 {
-    if (g_cancelCurrent.load(std::memory_order_relaxed)) return false;
+    return g_wlMode.load(std::memory_order_relaxed) == 0
+        || g_fgInjectionAllowed.load(std::memory_order_relaxed);
+}
 
-    // Watchdog : timeout
-    DWORD now = GetTickCount();
-    DWORD wdStart = g_wdStartTick.load(std::memory_order_relaxed);
-    if (wdStart != 0 && (now - wdStart) > kWD_MaxRuntimeMs) {
-        wchar_t buf[256];
-        _snwprintf_s(buf, _countof(buf), _TRUNCATE,
-            L"[WATCHDOG] Macro stopped — reason: timeout — macro: %s — runtime: %.1fs\n",
-            g_wdCurrentComboName.c_str(), (float)(now - wdStart) / 1000.0f);
-        OutputDebugStringW(buf);
-        return false;
-    }
-    // Watchdog : max actions
-    uint32_t ac = g_wdActionCount.fetch_add(1, std::memory_order_relaxed);
-    if (ac >= kWD_MaxActions) {
-        wchar_t buf[256];
-        _snwprintf_s(buf, _countof(buf), _TRUNCATE,
-            L"[WATCHDOG] Macro stopped — reason: max actions (%u) — macro: %s\n",
-            kWD_MaxActions, g_wdCurrentComboName.c_str());
-        OutputDebugStringW(buf);
-        return false;
+static void MarkMacroAnalog(uint16_t hid, bool held)
+{
+    if (hid == 0 || hid >= 256) return;
+    const uint64_t bit = 1ull << (hid % 64);
+    if (held) g_macroAnalogHids[hid / 64].fetch_or(bit, std::memory_order_relaxed);
+    else      g_macroAnalogHids[hid / 64].fetch_and(~bit, std::memory_order_relaxed);
+}
+
+static bool SleepCancelableMs(uint32_t ms)
+{
+    if (ms == 0) return !g_cancelCurrent.load(std::memory_order_relaxed);
+    DWORD start = GetTickCount();
+    while (true) {
+        if (g_cancelCurrent.load(std::memory_order_relaxed)) return false;
+        DWORD now = GetTickCount();
+        if ((uint32_t)(now - start) >= ms) return true;
+        Sleep(1);
     }
-    // Whitelist :block injection if unauthorised app (keyboard + mouse + text) - bloquer injection si app non autorisée (clavier + souris + texte)
-    if (action.type == ComboActionType::PressKey ||
-        action.type == ComboActionType::ReleaseKey ||
-        action.type == ComboActionType::TapKey ||
-        action.type == ComboActionType::MouseClick ||
-        action.type == ComboActionType::TypeText)
+}
+
+// Macro VM host: what a macro does to the outside world (worker thread only).
+// Watchdog + whitelist + output pacing apply per instruction, as they did per action.
+class ComboMacroHost : public IMacroHost
+{
+public:
+    bool BeginStep() override
     {
-        if (!InjectionAllowed()) return true;  // action ignored, macro continuing - action ignorée, macro continue
-    }
-    if (action.type == ComboActionType::Delay) {
-        DWORD end = GetTickCount() + action.delayMs;
-        while (GetTickCount() < end) {
-            if (g_cancelCurrent.load(std::memory_order_relaxed)) return false;
-            Sleep(8);
+        if (g_cancelCurrent.load(std::memory_order_relaxed)) return false;
+
+        // Watchdog : timeout
+        DWORD now = ClockNow();
+        DWORD wdStart = g_wdStartTick.load(std::memory_order_relaxed);
+        if (wdStart != 0 && (now - wdStart) > kWD_MaxRuntimeMs) {
+            wchar_t buf[256];
+            _snwprintf_s(buf, _countof(buf), _TRUNCATE,
+                L"[WATCHDOG] Macro stopped — reason: timeout — macro: %s — runtime: %.1fs\n",
+                g_wdCurrentComboName.c_str(), (float)(now - wdStart) / 1000.0f);
+            OutputDebugStringW(buf);
+            return false;
+        }
+        // Watchdog : max actions (effects only: BeginStep is not called for jumps / variables)
+        uint32_t ac = g_wdActionCount.fetch_add(1, std::memory_order_relaxed);
+        if (ac >= g_wdActionLimit) {
+            wchar_t buf[256];
+            _snwprintf_s(buf, _countof(buf), _TRUNCATE,
+                L"[WATCHDOG] Macro stopped — reason: max actions (%llu) — macro: %s\n",
+                (unsigned long long)g_wdActionLimit, g_wdCurrentComboName.c_str());
+            OutputDebugStringW(buf);
+            return false;
         }
         return true;
     }
-    if (action.type == ComboActionType::PressKey ||
-        action.type == ComboActionType::ReleaseKey ||
-        action.type == ComboActionType::TapKey)
-    {
-        WORD vk = HidToVk(action.keyHid);
-        const bool vigemRoute = Bindings_IsHidBound(action.keyHid);
-        auto MakeKeyInput = [&](WORD wVk, DWORD flags) -> INPUT {
-            INPUT i{}; i.type = INPUT_KEYBOARD; i.ki.wVk = wVk;
-            i.ki.wScan = (WORD)MapVirtualKeyW(wVk, MAPVK_VK_TO_VSC);
-            i.ki.dwFlags = flags | KEYEVENTF_SCANCODE;
-            i.ki.dwExtraInfo = (ULONG_PTR)0x484A4D43ULL; return i;
-            };
-        if (action.type == ComboActionType::PressKey) {
-            if (vigemRoute) { BackendUI_SetAnalogMilli(action.keyHid, 1000); Backend_SetMacroAnalog(action.keyHid, 1000.0f); }
-            INPUT i = MakeKeyInput(vk, 0); SendInput(1, &i, sizeof(INPUT));
-        }
-        else if (action.type == ComboActionType::ReleaseKey) {
-            INPUT i = MakeKeyInput(vk, KEYEVENTF_KEYUP); SendInput(1, &i, sizeof(INPUT));
-            if (vigemRoute) { BackendUI_SetAnalogMilli(action.keyHid, 0); Backend_ClearMacroAnalog(action.keyHid); }
-        }
-        else {
-            if (vigemRoute) Backend_SetMacroAnalogForMs(action.keyHid, 1.0f, 120);
-            INPUT iD = MakeKeyInput(vk, 0), iU = MakeKeyInput(vk, KEYEVENTF_KEYUP);
-            SendInput(1, &iD, sizeof(INPUT)); Sleep(30); SendInput(1, &iU, sizeof(INPUT));
-        }
+
+    void KeyDown(uint16_t hid) override
+    {
+        // Whitelist : action ignorée si app non autorisée, la macro continue
+        if (!InjectionAllowedCached()) return;
+        WORD vk = HidToVk(hid);
+        if (AppProfiles_IsHidBound(hid)) { BackendUI_SetAnalogMilli(hid, 1000); Backend_SetMacroAnalog(hid, 1000.0f); MarkMacroAnalog(hid, true); }
+        g_out.Key(vk, (WORD)MapVirtualKeyW(vk, MAPVK_VK_TO_VSC), false);
+        AfterAction();
     }
-    else if (action.type == ComboActionType::MouseClick) {
-        INPUT inp[2] = {}; DWORD dF = 0, uF = 0, xb = 0; BYTE vb = 0;
-        switch (action.mouseButton) {
-        case 0:dF = MOUSEEVENTF_LEFTDOWN;  uF = MOUSEEVENTF_LEFTUP;  vb = (1 << 0); break;
-        case 1:dF = MOUSEEVENTF_RIGHTDOWN; uF = MOUSEEVENTF_RIGHTUP; vb = (1 << 1); break;
-        case 2:dF = MOUSEEVENTF_MIDDLEDOWN; uF = MOUSEEVENTF_MIDDLEUP; vb = (1 << 2); break;
-        case 3:dF = MOUSEEVENTF_XDOWN; uF = MOUSEEVENTF_XUP; xb = XBUTTON1; vb = (1 << 3); break;
-        case 4:dF = MOUSEEVENTF_XDOWN; uF = MOUSEEVENTF_XUP; xb = XBUTTON2; vb = (1 << 4); break;
-        }
-        if (dF) {
-            inp[0].type = INPUT_MOUSE; inp[0].mi.dwFlags = dF; inp[0].mi.mouseData = xb;
-            inp[1].type = INPUT_MOUSE; inp[1].mi.dwFlags = uF; inp[1].mi.mouseData = xb;
+
+    void KeyUp(uint16_t hid) override
+    {
+        if (!InjectionAllowedCached()) return;
+        WORD vk = HidToVk(hid);
+        g_out.Key(vk, (WORD)MapVirtualKeyW(vk, MAPVK_VK_TO_VSC), true);
+        if (AppProfiles_IsHidBound(hid)) { BackendUI_SetAnalogMilli(hid, 0); Backend_ClearMacroAnalog(hid); MarkMacroAnalog(hid, false); }
+        AfterAction();
+    }
+
+    void KeyTap(uint16_t hid) override
+    {
+        if (!InjectionAllowedCached()) return;
+        WORD vk = HidToVk(hid);
+        const WORD scan = (WORD)MapVirtualKeyW(vk, MAPVK_VK_TO_VSC);
+        if (AppProfiles_IsHidBound(hid)) Backend_SetMacroAnalogForMs(hid, 1.0f, 120);
+        g_out.Key(vk, scan, false);
+        g_out.Wait(g_out.Pacing().tapHoldUs);
+        g_out.Key(vk, scan, true); // envoyé par le Wait de AfterAction
+        AfterAction();
+    }
+
+    void TypeText(const wchar_t* text, uint32_t len) override
+    {
+        if (!InjectionAllowedCached()) return;
+        // Burst (défaut) : toute la chaîne part en un (ou quelques) SendInput, sans écart par caractère
+        if (!g_out.Text(text, len, &g_cancelCurrent)) return;
+        AfterAction();
+    }
+
+    void MouseClick(uint8_t button) override
+    {
+        if (!InjectionAllowedCached()) return;
+        if (button <= 4) {
+            const BYTE vb = (BYTE)(1 << button);
             g_injectedMouseState.fetch_or(vb, std::memory_order_relaxed);
-            SendInput(2, inp, sizeof(INPUT)); Sleep(30);
+            g_out.Mouse(button, false);
+            g_out.Wait(g_out.Pacing().tapHoldUs);
+            g_out.Mouse(button, true);
+            g_out.Flush();
             g_injectedMouseState.fetch_and((BYTE)~vb, std::memory_order_relaxed);
         }
+        AfterAction();
     }
-    else if (action.type == ComboActionType::TypeText) {
-        for (wchar_t ch : action.text) {
+
+    bool Wait(uint32_t ms) override
+    {
+        g_out.Flush();
+        // Elapsed time, not an end tick: GetTickCount wraps every 49.7 days
+        const DWORD start = GetTickCount();
+        while ((DWORD)(GetTickCount() - start) < ms) {
             if (g_cancelCurrent.load(std::memory_order_relaxed)) return false;
-            INPUT inp[2] = {}; inp[0].type = INPUT_KEYBOARD; inp[0].ki.wScan = ch;
-            inp[0].ki.dwFlags = KEYEVENTF_UNICODE; inp[1] = inp[0]; inp[1].ki.dwFlags |= KEYEVENTF_KEYUP;
-            SendInput(2, inp, sizeof(INPUT)); Sleep(10);
+            Sleep(ms < 16 ? 1 : 8);
         }
+        g_out.Restart();
+        return true;
     }
-    if (action.type != ComboActionType::Delay) Sleep(10);
-    return !g_cancelCurrent.load(std::memory_order_relaxed);
-}
 
-static bool SleepCancelableMs(uint32_t ms)
-{
-    if (ms == 0) return !g_cancelCurrent.load(std::memory_order_relaxed);
-    DWORD start = GetTickCount();
-    while (true) {
-        if (g_cancelCurrent.load(std::memory_order_relaxed)) return false;
-        DWORD now = GetTickCount();
-        if ((uint32_t)(now - start) >= ms) return true;
-        Sleep(1);
+    void SetAnalog(uint16_t hid, uint16_t milli) override
+    {
+        if (!InjectionAllowedCached()) return;
+        BackendUI_SetAnalogMilli(hid, milli);
+        Backend_SetMacroAnalog(hid, (float)milli / 1000.0f);
+        MarkMacroAnalog(hid, true);
     }
-}
+
+    void ReleaseAnalog(uint16_t hid) override
+    {
+        BackendUI_SetAnalogMilli(hid, 0);
+        Backend_ClearMacroAnalog(hid);
+        MarkMacroAnalog(hid, false);
+    }
+
+    bool IsKeyHeld(uint16_t hid) override
+    {
+        return InputBus_IsKeyHeld(HidToVk(hid));
+    }
+
+    uint16_t GetAnalogMilli(uint16_t hid) override
+    {
+        return BackendUI_GetRawMilli(hid);
+    }
+
+private:
+    // Both modes: a press and its release never share a batch (games polling key state)
+    static void AfterAction()
+    {
+        g_out.Wait(g_out.Pacing().actionGapUs);
+    }
+};
+
+static void CheckCancelOnRelease();
 
 static void WorkerFunc()
 {
@@ -490,23 +659,56 @@ static void WorkerFunc()
         }
         if (item.actions.empty()) continue;
 
+        // Compile once per queued run (buffers reused); the VM itself never allocates
+        std::wstring compileErr;
+        if (!MacroCompile(item.actions, &g_program, &compileErr)) {
+            OutputDebugStringW((L"[MACRO] " + item.comboName + L" — compile error: " + compileErr + L"\n").c_str());
+            continue;
+        }
+
         // Watchdog : reset for this run - reset pour ce run
-        g_wdStartTick.store(GetTickCount(), std::memory_order_relaxed);
+        g_wdStartTick.store(ClockNow(), std::memory_order_relaxed);
         g_wdActionCount.store(0, std::memory_order_relaxed);
         g_wdCurrentComboName = item.comboName;
+        // Loop 1000 { Tap } is 1000 actions, not a runaway: the limit follows the
+        // unrolled program (an endless loop is left to the runtime limit and cancel)
+        {
+            const uint64_t runsN = (item.repeatCount == 0) ? 1 : item.repeatCount;
+            const uint64_t all = (g_program.maxEffects > MACRO_EFFECTS_UNBOUNDED / runsN)
+                ? MACRO_EFFECTS_UNBOUNDED : g_program.maxEffects * runsN;
+            g_wdActionLimit = std::max<uint64_t>(kWD_MaxActions, all);
+        }
 
         g_cancelCurrent.store(false, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lk(g_runMutex);
+            g_runTrigger = item.trigger;
+        }
+        g_runCancelOnRelease.store(item.cancelOnRelease, std::memory_order_release);
+        CheckCancelOnRelease(); // relâché pendant l'attente dans la queue
+        g_out.SetPacing(GetPacingSnapshot());
+        g_out.Restart();
+        g_vm.Reset(GetTickCount() ^ (uint32_t)(uintptr_t)&item);
         uint32_t runs = (item.repeatCount == 0) ? 1 : item.repeatCount;
         for (uint32_t r = 0; r < runs; ++r) {
-            for (const auto& action : item.actions)
-                if (!ExecAction(action)) goto done;
+            ComboMacroHost host;
+            MacroRunResult res = g_vm.Run(g_program, host);
+            if (res == MacroRunResult::StepLimit || res == MacroRunResult::BadProgram)
+                OutputDebugStringW((L"[MACRO] " + item.comboName +
+                    (res == MacroRunResult::StepLimit ? L" — step limit reached\n" : L" — bad program\n")).c_str());
+            if (res != MacroRunResult::Finished) goto done;
 
             // If user requested "Run N times", respect the configured repeat delay between runs
             if (r + 1 < runs && item.repeatCount > 1 && item.repeatDelayMs > 0) {
+                g_out.Flush();
                 if (!SleepCancelableMs(item.repeatDelayMs)) goto done;
+                g_out.Restart();
             }
         }
     done:
+        // Always deliver what is pending (mostly key-ups), even when cancelled.
+        g_out.Flush();
+        g_runCancelOnRelease.store(false, std::memory_order_release);
         g_wdStartTick.store(0, std::memory_order_relaxed);
         g_wdCurrentComboName.clear();
     }
@@ -517,10 +719,10 @@ static bool ModifierMatches(FreeTriggerModifier mod)
 {
     switch (mod) {
     case FreeTriggerModifier::None:  return true;
-    case FreeTriggerModifier::Ctrl:  return g_ctrlHeld;
-    case FreeTriggerModifier::Shift: return g_shiftHeld;
-    case FreeTriggerModifier::Alt:   return g_altHeld;
-    case FreeTriggerModifier::Win:   return g_winHeld;
+    case FreeTriggerModifier::Ctrl:  return IsCtrlHeld();
+    case FreeTriggerModifier::Shift: return IsShiftHeld();
+    case FreeTriggerModifier::Alt:   return IsAltHeld();
+    case FreeTriggerModifier::Win:   return IsWinHeld();
     }
     return false;
 }
@@ -538,9 +740,273 @@ static bool TriggerExtraConditionsMatch(const FreeTrigger& trigger)
     return true;
 }
 
+// --- Cancel on release ---
+// Input thread (key / button up) and worker (start of a run). Only the trigger of
+// the macro being played matters: releasing another combo's key cancels nothing.
+static void CheckCancelOnRelease()
+{
+    if (!g_runCancelOnRelease.load(std::memory_order_acquire)) return;
+    FreeTrigger t;
+    {
+        std::lock_guard<std::mutex> lk(g_runMutex);
+        t = g_runTrigger;
+    }
+    FreeTriggerKeyType held = t.keyType;
+    if (held == FreeTriggerKeyType::MouseDoubleLeft)  held = FreeTriggerKeyType::MouseLeft;
+    if (held == FreeTriggerKeyType::MouseDoubleRight) held = FreeTriggerKeyType::MouseRight;
+    // Molette : rien à maintenir, pas d'annulation
+    if (held == FreeTriggerKeyType::WheelUp || held == FreeTriggerKeyType::WheelDown) return;
+
+    if (IsTriggerKeyHeld(held, t.vkCode) && TriggerExtraConditionsMatch(t)) return;
+    if (!g_cancelCurrent.exchange(true, std::memory_order_relaxed))
+        NotifyObserver(FreeComboSystem::ComboSimEvent::CancelRequested, nullptr);
+}
+
+// --- Trigger automaton ---
+// 0 = no symbol (None)
+static TriggerSymbol TriggerKeySymbol(FreeTriggerKeyType type, WORD vk)
+{
+    switch (type) {
+    case FreeTriggerKeyType::Keyboard:         return (vk > 0 && vk < 256) ? (TriggerSymbol)vk : 0;
+    case FreeTriggerKeyType::MouseLeft:
+    case FreeTriggerKeyType::MouseDoubleLeft:  return TRIGGER_SYM_MOUSE_LEFT;
+    case FreeTriggerKeyType::MouseRight:
+    case FreeTriggerKeyType::MouseDoubleRight: return TRIGGER_SYM_MOUSE_RIGHT;
+    case FreeTriggerKeyType::MouseMiddle:      return TRIGGER_SYM_MOUSE_MIDDLE;
+    case FreeTriggerKeyType::MouseX1:          return TRIGGER_SYM_MOUSE_X1;
+    case FreeTriggerKeyType::MouseX2:          return TRIGGER_SYM_MOUSE_X2;
+    case FreeTriggerKeyType::WheelUp:          return TRIGGER_SYM_WHEEL_UP;
+    case FreeTriggerKeyType::WheelDown:        return TRIGGER_SYM_WHEEL_DOWN;
+    default:                                   return 0;
+    }
+}
+
+static TriggerSymbol ModifierSymbol(FreeTriggerModifier mod)
+{
+    switch (mod) {
+    case FreeTriggerModifier::Ctrl:  return TRIGGER_SYM_CTRL;
+    case FreeTriggerModifier::Shift: return TRIGGER_SYM_SHIFT;
+    case FreeTriggerModifier::Alt:   return TRIGGER_SYM_ALT;
+    case FreeTriggerModifier::Win:   return TRIGGER_SYM_WIN;
+    default:                         return 0;
+    }
+}
+
+static bool IsTriggerSymbolHeld(void*, TriggerSymbol sym)
+{
+    switch (sym) {
+    case TRIGGER_SYM_MOUSE_LEFT:   return InputBus_IsMouseHeld(InputMouseButton::Left);
+    case TRIGGER_SYM_MOUSE_RIGHT:  return InputBus_IsMouseHeld(InputMouseButton::Right);
+    case TRIGGER_SYM_MOUSE_MIDDLE: return InputBus_IsMouseHeld(InputMouseButton::Middle);
+    case TRIGGER_SYM_MOUSE_X1:     return InputBus_IsMouseHeld(InputMouseButton::X1);
+    case TRIGGER_SYM_MOUSE_X2:     return InputBus_IsMouseHeld(InputMouseButton::X2);
+    case TRIGGER_SYM_CTRL:         return IsCtrlHeld();
+    case TRIGGER_SYM_SHIFT:        return IsShiftHeld();
+    case TRIGGER_SYM_ALT:          return IsAltHeld();
+    case TRIGGER_SYM_WIN:          return IsWinHeld();
+    default:                       return sym < 256 && InputBus_IsKeyHeld(sym);
+    }
+}
+
+// FNV-1a over what the automaton is built from
+static uint64_t HashTrigger(uint64_t h, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) { h ^= (v >> (i * 8)) & 0xFF; h *= 0x100000001B3ull; }
+    return h;
+}
+
+// Trigger data the automaton, the analog rules and the hook table are built from,
+// copied under g_comboMutex so that the build itself runs without it.
+struct TriggerSource { int id; FreeTrigger trigger; };
+struct TriggerSnapshot
+{
+    uint64_t                   seq = 0;
+    uint32_t                   dblMs = 0;
+    std::vector<TriggerSource> items;   // enabled, valid triggers
+};
+
+// Caller holds g_comboMutex. false: triggers unchanged since the last snapshot.
+// Slot order, not list order: a reorder only changes priority (g_rank), no rebuild.
+static bool SnapshotTriggersIfChangedUnlocked(TriggerSnapshot* out)
+{
+    const uint32_t dblMs = GetDoubleClickTime();
+    uint64_t sig = HashTrigger(0xCBF29CE484222325ull, dblMs);
+    for (uint32_t slot = 0; slot < g_combos.SlotCount(); ++slot) {
+        const FreeCombo* c = g_combos.AtSlot(slot);
+        if (!c) continue;
+        sig = HashTrigger(sig, (uint32_t)c->_id);
+        sig = HashTrigger(sig, (c->enabled ? 1u : 0u) | ((uint32_t)c->trigger.keyType << 1) | ((uint32_t)c->trigger.modifier << 8));
+        sig = HashTrigger(sig, c->trigger.vkCode | ((uint32_t)c->trigger.holdVkCode << 16));
+        sig = HashTrigger(sig, (uint32_t)c->trigger.holdKeyType);
+        sig = HashTrigger(sig, c->trigger.analogParam);
+    }
+    if (sig == g_triggerSignature) return false;
+    g_triggerSignature = sig;
+
+    out->seq = ++g_triggerBuildSeq;
+    out->dblMs = dblMs;
+    out->items.clear();
+    out->items.reserve(g_combos.Size());
+    for (uint32_t slot = 0; slot < g_combos.SlotCount(); ++slot) {
+        const FreeCombo* c = g_combos.AtSlot(slot);
+        if (c && c->enabled && c->trigger.IsValid())
+            out->items.push_back({ c->_id, c->trigger });
+    }
+    return true;
+}
+
+// Analog triggers never reach the automaton: they become rules of the realtime
+// thread table (analog_trigger.h), events come back through PumpInputBus.
+static bool AppendAnalogRule(const TriggerSource& src, AnalogTriggerRule* rules, int* count)
+{
+    const FreeTrigger& t = src.trigger;
+    if (*count >= ANALOG_TRIGGER_MAX_RULES) return false;
+    AnalogTriggerRule& r = rules[*count];
+    r = AnalogTriggerRule{};
+    r.id = (uint32_t)src.id;
+    r.hid = VkToHid(t.vkCode);
+    if (!r.hid) return true;
+    const uint32_t pct = std::clamp<uint32_t>(t.analogParam, 1, 99);
+    switch (t.keyType) {
+    case FreeTriggerKeyType::AnalogVelocity:
+        r.kind = AnalogTriggerKind::Velocity;
+        r.velocityMps = AnalogTrigger_MmPerSecToMilli(std::max<uint32_t>(t.analogParam, 1));
+        break;
+    case FreeTriggerKeyType::AnalogDoubleActuation:
+        r.kind = AnalogTriggerKind::DoubleActuation;
+        r.thresholdM = (uint16_t)(pct * 10);
+        break;
+    case FreeTriggerKeyType::AnalogActuation:
+        r.kind = AnalogTriggerKind::Actuation;
+        break;
+    default:
+        r.kind = AnalogTriggerKind::Depth;
+        r.thresholdM = (uint16_t)(pct * 10);
+        break;
+    }
+    ++*count;
+    return true;
+}
+
+// Hook table entry of a keyboard trigger: what must be held for a press to fire it.
+// Same conditions twice = one entry; past kTriggerVkConds the key is never blocked.
+static void AddHookCondition(uint32_t (&conds)[kTriggerVkConds], const FreeTrigger& t, int comboId)
+{
+    const uint32_t c = 0x80000000u | (uint32_t)t.modifier
+        | ((uint32_t)t.holdKeyType << 8)
+        | ((uint32_t)(t.holdKeyType == FreeTriggerKeyType::Keyboard ? (t.holdVkCode & 0xFF) : 0) << 16);
+    for (uint32_t& slot : conds) {
+        if (slot == c) return;
+        if (!slot) { slot = c; return; }
+    }
+    wchar_t buf[96];
+    _snwprintf_s(buf, _countof(buf), _TRUNCATE, L"[COMBO] hook table full for VK %u: combo %d\n", (unsigned)t.vkCode, comboId);
+    OutputDebugStringW(buf);
+}
+
+// Compiles a snapshot without any lock, then swaps the result in under g_comboMutex.
+// Two builds may overlap (UI + Tick): the one from the older snapshot is dropped.
+static void BuildTriggers(TriggerSnapshot&& snap)
+{
+    TriggerAutomaton  automaton;
+    uint32_t          conds[256][kTriggerVkConds]{};
+    AnalogTriggerRule rules[ANALOG_TRIGGER_MAX_RULES];
+    int               ruleCount = 0;
+
+    for (const TriggerSource& src : snap.items) {
+        const FreeTrigger& t = src.trigger;
+        if (FreeTriggerKeyTypeIsAnalog(t.keyType)) {
+            if (!AppendAnalogRule(src, rules, &ruleCount)) {
+                wchar_t buf[96];
+                _snwprintf_s(buf, _countof(buf), _TRUNCATE, L"[COMBO] analog trigger ignored (table full): combo %d\n", src.id);
+                OutputDebugStringW(buf);
+            }
+            continue;
+        }
+        if (t.keyType == FreeTriggerKeyType::Keyboard && t.vkCode < 256)
+            AddHookCondition(conds[t.vkCode], t, src.id);
+
+        TriggerStep last;
+        last.key = TriggerKeySymbol(t.keyType, t.vkCode);
+        if (!last.key) continue;
+        if (TriggerSymbol mod = ModifierSymbol(t.modifier))
+            last.with[last.withCount++] = mod;
+        TriggerSymbol hold = TriggerKeySymbol(t.holdKeyType, t.holdVkCode);
+        if (hold && hold != TRIGGER_SYM_WHEEL_UP && hold != TRIGGER_SYM_WHEEL_DOWN)
+            last.with[last.withCount++] = hold;
+
+        TriggerPattern p;
+        p.id = (uint32_t)src.id;
+        p.maxGapMs = snap.dblMs;
+        if (t.keyType == FreeTriggerKeyType::MouseDoubleLeft ||
+            t.keyType == FreeTriggerKeyType::MouseDoubleRight) {
+            // Double clic = deux appuis dans GetDoubleClickTime(), conditions vérifiées au second
+            p.steps[0].key = last.key;
+            p.steps[1] = last;
+            p.stepCount = 2;
+        } else {
+            p.steps[0] = last;
+            p.stepCount = 1;
+        }
+        if (!automaton.Add(p)) {
+            wchar_t buf[96];
+            _snwprintf_s(buf, _countof(buf), _TRUNCATE, L"[COMBO] trigger not compiled (too many held keys): combo %d\n", src.id);
+            OutputDebugStringW(buf);
+        }
+    }
+    automaton.Build();
+
+    std::lock_guard<std::mutex> lock(g_comboMutex);
+    if (snap.seq <= g_triggerPublishedSeq) return; // a newer snapshot is already out
+    g_triggerPublishedSeq = snap.seq;
+    std::swap(g_triggerAutomaton, automaton);     // the old one is freed after the unlock
+    for (int vk = 0; vk < 256; ++vk)
+        for (int i = 0; i < kTriggerVkConds; ++i)
+            g_triggerVkConds[vk][i].store(conds[vk][i], std::memory_order_relaxed);
+    AnalogTrigger_SetRules(rules, ruleCount);
+}
+
+// Triggers completed by this press, highest priority first (caller holds g_comboMutex)
+static void CollectTriggerMatchesUnlocked(TriggerSymbol sym)
+{
+    g_triggerMatches.clear();
+    g_triggerAutomaton.Press(sym, ClockNow(), IsTriggerSymbolHeld, nullptr, &g_triggerMatches);
+    // The automaton may predate a delete: drop ids that no longer resolve
+    g_triggerMatches.erase(std::remove_if(g_triggerMatches.begin(), g_triggerMatches.end(),
+        [](uint32_t id) { return g_combos.Get((int)id) == nullptr; }), g_triggerMatches.end());
+    std::sort(g_triggerMatches.begin(), g_triggerMatches.end(), [](uint32_t a, uint32_t b) {
+        return g_rank[SlotMap<FreeCombo>::SlotOf((int)a)] > g_rank[SlotMap<FreeCombo>::SlotOf((int)b)];
+    });
+}
+
+// --- Hook table + automaton ---
+// Caller holds `lock` on g_comboMutex; it is released when the triggers changed
+// and have to be rebuilt.
+static void RefreshTriggers(std::unique_lock<std::mutex>& lock)
+{
+    TriggerSnapshot snap;
+    if (!SnapshotTriggersIfChangedUnlocked(&snap)) return;
+    lock.unlock();
+    BuildTriggers(std::move(snap));
+}
+
 // --- Trigger combo ---
 static void FireCombo(FreeCombo& combo)
 {
+    NotifyObserver(FreeComboSystem::ComboSimEvent::Fired, &combo);
+    if (g_dryRun.load(std::memory_order_relaxed)) {
+        // comme le worker au début d'un run
+        g_cancelCurrent.store(false, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lk(g_runMutex);
+            g_runTrigger = combo.trigger;
+        }
+        g_runCancelOnRelease.store(combo.cancelOnRelease, std::memory_order_release);
+        combo.lastExecTime = ClockNow();
+        if (combo.repeatWhileHeld)
+            ArmRepeatUnlocked(combo, combo.lastExecTime + combo.repeatDelayMs);
+        return;
+    }
     QueueItem item;
     item.actions = combo.actions;
     item.repeatCount = combo.repeatCount;
@@ -553,7 +1019,9 @@ static void FireCombo(FreeCombo& combo)
         g_queue.push(std::move(item));
     }
     g_queueCv.notify_one();
-    combo.lastExecTime = GetTickCount();
+    combo.lastExecTime = ClockNow();
+    if (combo.repeatWhileHeld)
+        ArmRepeatUnlocked(combo, combo.lastExecTime + combo.repeatDelayMs);
 }
 
 // ============================================================
@@ -563,6 +1031,8 @@ namespace FreeComboSystem
 {
     void Initialize()
     {
+        InputBus_Subscribe(&g_busReader);
+        ComboStore_StartWriter();
         if (!g_workerRunning) {
             g_workerRunning = true;
             g_worker = std::thread(WorkerFunc);
@@ -579,6 +1049,8 @@ namespace FreeComboSystem
         g_workerRunning = false;
         g_queueCv.notify_all();
         if (g_worker.joinable()) g_worker.join();
+        // Last snapshot posted by SaveToFile() must reach the disk before exit
+        ComboStore_StopWriter();
         // g_combos is intentionally retained so that SaveToFile can be called afterwards - g_combos est intentionnellement conserve pour que SaveToFile puisse etre appele apres.
         // The g_combos destroyer (end of programme) will take care of cleaning up.- Le destructeur de g_combos (fin de programme) s occupera du nettoyage.
     }
@@ -589,79 +1061,84 @@ namespace FreeComboSystem
         std::lock_guard<std::mutex> lock(g_comboMutex);
         FreeCombo c;
         c.name = name;
-        g_combos.push_back(c);
-        return (int)g_combos.size() - 1;
+        return InsertComboUnlocked(std::move(c));
     }
 
     bool DeleteCombo(int id)
     {
-        std::lock_guard<std::mutex> lock(g_comboMutex);
-        if (id < 0 || id >= (int)g_combos.size()) return false;
-        g_combos.erase(g_combos.begin() + id);
+        std::unique_lock<std::mutex> lock(g_comboMutex);
+        if (!g_combos.Get(id)) return false;
+        g_combos.Erase(id);   // pending deadlines of this id are skipped when popped
+        g_order.erase(std::find(g_order.begin(), g_order.end(), id));
+        RebuildRankUnlocked();
+        RefreshTriggers(lock);
         return true;
     }
 
     FreeCombo* GetCombo(int id)
     {
-        if (id < 0 || id >= (int)g_combos.size()) return nullptr;
-        return &g_combos[id];
+        std::lock_guard<std::mutex> lock(g_comboMutex);
+        return g_combos.Get(id);
     }
 
     std::vector<int> GetAllIds()
     {
         std::lock_guard<std::mutex> lock(g_comboMutex);
-        std::vector<int> ids;
-        for (int i = 0; i < (int)g_combos.size(); ++i) ids.push_back(i);
-        return ids;
+        return g_order;
     }
 
     int GetCount()
     {
         std::lock_guard<std::mutex> lock(g_comboMutex);
-        return (int)g_combos.size();
+        return (int)g_order.size();
     }
 
     bool SwapCombos(int idA, int idB)
     {
         std::lock_guard<std::mutex> lock(g_comboMutex);
-        if (idA < 0 || idA >= (int)g_combos.size()) return false;
-        if (idB < 0 || idB >= (int)g_combos.size()) return false;
-        std::swap(g_combos[(size_t)idA], g_combos[(size_t)idB]);
-        return true;
+        if (!g_combos.Get(idA) || !g_combos.Get(idB)) return false;
+        uint32_t& rankA = g_rank[SlotMap<FreeCombo>::SlotOf(idA)];
+        uint32_t& rankB = g_rank[SlotMap<FreeCombo>::SlotOf(idB)];
+        std::swap(g_order[rankA], g_order[rankB]);
+        std::swap(rankA, rankB);
+        return true;   // priority only: automaton ids are stable
     }
 
     bool MoveCombo(int srcIdx, int dstIdx)
     {
         std::lock_guard<std::mutex> lock(g_comboMutex);
-        int n = (int)g_combos.size();
+        int n = (int)g_order.size();
         if (srcIdx < 0 || srcIdx >= n) return false;
         if (dstIdx < 0 || dstIdx >= n) return false;
         if (srcIdx == dstIdx) return true;
-        // Déplacement direct avec std::rotate — O(n), pas de swaps successifs
+        // Déplacement direct avec std::rotate sur la liste d'ids — les combos ne bougent pas
         if (srcIdx < dstIdx)
-            std::rotate(g_combos.begin() + srcIdx,
-                        g_combos.begin() + srcIdx + 1,
-                        g_combos.begin() + dstIdx + 1);
+            std::rotate(g_order.begin() + srcIdx,
+                        g_order.begin() + srcIdx + 1,
+                        g_order.begin() + dstIdx + 1);
         else
-            std::rotate(g_combos.begin() + dstIdx,
-                        g_combos.begin() + srcIdx,
-                        g_combos.begin() + srcIdx + 1);
+            std::rotate(g_order.begin() + dstIdx,
+                        g_order.begin() + srcIdx,
+                        g_order.begin() + srcIdx + 1);
+        RebuildRankUnlocked();
         return true;
     }
 
     bool AddAction(int id, const ComboAction& action)
     {
         std::lock_guard<std::mutex> lock(g_comboMutex);
-        if (id < 0 || id >= (int)g_combos.size()) return false;
-        g_combos[id].actions.push_back(action);
+        FreeCombo* c = g_combos.Get(id);
+        if (!c) return false;
+        c->actions.push_back(action);
         return true;
     }
 
     bool RemoveAction(int id, int actionIndex)
     {
         std::lock_guard<std::mutex> lock(g_comboMutex);
-        if (id < 0 || id >= (int)g_combos.size()) return false;
-        auto& actions = g_combos[id].actions;
+        FreeCombo* c = g_combos.Get(id);
+        if (!c) return false;
+        auto& actions = c->actions;
         if (actionIndex < 0 || actionIndex >= (int)actions.size()) return false;
         actions.erase(actions.begin() + actionIndex);
         return true;
@@ -670,8 +1147,9 @@ namespace FreeComboSystem
     bool MoveActionUp(int id, int actionIndex)
     {
         std::lock_guard<std::mutex> lock(g_comboMutex);
-        if (id < 0 || id >= (int)g_combos.size()) return false;
-        auto& actions = g_combos[id].actions;
+        FreeCombo* c = g_combos.Get(id);
+        if (!c) return false;
+        auto& actions = c->actions;
         if (actionIndex <= 0 || actionIndex >= (int)actions.size()) return false;
         std::swap(actions[actionIndex], actions[actionIndex - 1]);
         return true;
@@ -680,8 +1158,9 @@ namespace FreeComboSystem
     bool MoveActionDown(int id, int actionIndex)
     {
         std::lock_guard<std::mutex> lock(g_comboMutex);
-        if (id < 0 || id >= (int)g_combos.size()) return false;
-        auto& actions = g_combos[id].actions;
+        FreeCombo* c = g_combos.Get(id);
+        if (!c) return false;
+        auto& actions = c->actions;
         if (actionIndex < 0 || actionIndex >= (int)actions.size() - 1) return false;
         std::swap(actions[actionIndex], actions[actionIndex + 1]);
         return true;
@@ -690,47 +1169,55 @@ namespace FreeComboSystem
     bool ClearActions(int id)
     {
         std::lock_guard<std::mutex> lock(g_comboMutex);
-        if (id < 0 || id >= (int)g_combos.size()) return false;
-        g_combos[id].actions.clear();
+        FreeCombo* c = g_combos.Get(id);
+        if (!c) return false;
+        c->actions.clear();
         return true;
     }
 
     bool SetTrigger(int id, const FreeTrigger& trigger)
     {
-        std::lock_guard<std::mutex> lock(g_comboMutex);
-        if (id < 0 || id >= (int)g_combos.size()) return false;
-        g_combos[id].trigger = trigger;
+        std::unique_lock<std::mutex> lock(g_comboMutex);
+        FreeCombo* c = g_combos.Get(id);
+        if (!c) return false;
+        c->trigger = trigger;
+        RefreshTriggers(lock);
         return true;
     }
 
     bool SetEnabled(int id, bool enabled)
     {
-        std::lock_guard<std::mutex> lock(g_comboMutex);
-        if (id < 0 || id >= (int)g_combos.size()) return false;
-        g_combos[id].enabled = enabled;
+        std::unique_lock<std::mutex> lock(g_comboMutex);
+        FreeCombo* c = g_combos.Get(id);
+        if (!c) return false;
+        c->enabled = enabled;
+        RefreshTriggers(lock);
         return true;
     }
 
     bool SetRepeat(int id, bool repeat, uint32_t delayMs)
     {
         std::lock_guard<std::mutex> lock(g_comboMutex);
-        if (id < 0 || id >= (int)g_combos.size()) return false;
-        g_combos[id].repeatWhileHeld = repeat;
-        g_combos[id].repeatDelayMs = delayMs;
+        FreeCombo* c = g_combos.Get(id);
+        if (!c) return false;
+        c->repeatWhileHeld = repeat;
+        c->repeatDelayMs = delayMs;
         return true;
     }
     bool SetRepeatCount(int id, uint32_t count)
     {
         std::lock_guard<std::mutex> lock(g_comboMutex);
-        if (id < 0 || id >= (int)g_combos.size()) return false;
-        g_combos[id].repeatCount = count;
+        FreeCombo* c = g_combos.Get(id);
+        if (!c) return false;
+        c->repeatCount = count;
         return true;
     }
     bool SetCancelOnRelease(int id, bool cancel)
     {
         std::lock_guard<std::mutex> lock(g_comboMutex);
-        if (id < 0 || id >= (int)g_combos.size()) return false;
-        g_combos[id].cancelOnRelease = cancel;
+        FreeCombo* c = g_combos.Get(id);
+        if (!c) return false;
+        c->cancelOnRelease = cancel;
         return true;
     }
 
@@ -789,108 +1276,94 @@ namespace FreeComboSystem
     }
 
     // --- MOUSE EVENTS ---
-    void ProcessMouseEvent(UINT msg, WPARAM wParam, LPARAM lParam)
+    static FreeTriggerKeyType MouseButtonToKeyType(uint16_t button)
+    {
+        switch ((InputMouseButton)button) {
+        case InputMouseButton::Left:   return FreeTriggerKeyType::MouseLeft;
+        case InputMouseButton::Right:  return FreeTriggerKeyType::MouseRight;
+        case InputMouseButton::Middle: return FreeTriggerKeyType::MouseMiddle;
+        case InputMouseButton::X1:     return FreeTriggerKeyType::MouseX1;
+        case InputMouseButton::X2:     return FreeTriggerKeyType::MouseX2;
+        }
+        return FreeTriggerKeyType::None;
+    }
+
+    static void OnMouseEvent(const InputEvent& ev)
     {
-        if (msg == WM_MOUSEMOVE) return;
+        // Molette bloquée par le cooldown natif : le jeu ne l'a pas vue, les combos non plus
+        if (ev.type == InputEventType::Wheel && (ev.flags & InputEventFlag_Blocked)) return;
+        if (ev.type == InputEventType::HWheel) return;
 
-        DWORD now = GetTickCount();
+        DWORD now = ClockNow();
         bool isDoubleLeft = false;
         bool isDoubleRight = false;
-        if (msg == WM_LBUTTONDOWN)
+        if (ev.type == InputEventType::MouseDown && ev.code == (uint16_t)InputMouseButton::Left)
         {
             DWORD prev = g_lastLeftDownTick.load();
             isDoubleLeft = (prev != 0 && (now - prev) <= GetDoubleClickTime());
             g_lastLeftDownTick = now;
         }
-        else if (msg == WM_RBUTTONDOWN)
+        else if (ev.type == InputEventType::MouseDown && ev.code == (uint16_t)InputMouseButton::Right)
         {
             DWORD prev = g_lastRightDownTick.load();
             isDoubleRight = (prev != 0 && (now - prev) <= GetDoubleClickTime());
             g_lastRightDownTick = now;
         }
 
-        // Update mouse state
-        if (msg == WM_LBUTTONDOWN) g_leftHeld = true;
-        else if (msg == WM_LBUTTONUP)   g_leftHeld = false;
-        else if (msg == WM_RBUTTONDOWN) g_rightHeld = true;
-        else if (msg == WM_RBUTTONUP)   g_rightHeld = false;
-        else if (msg == WM_MBUTTONDOWN) g_middleHeld = true;
-        else if (msg == WM_MBUTTONUP)   g_middleHeld = false;
+        // Held state is already applied by the bus.
 
-        // --- CAPTURE MODE ---
-        if (g_capturing) {
-            FreeTriggerKeyType keyType = FreeTriggerKeyType::None;
-            if (msg == WM_LBUTTONDOWN) keyType = isDoubleLeft ? FreeTriggerKeyType::MouseDoubleLeft : FreeTriggerKeyType::MouseLeft;
-            else if (msg == WM_RBUTTONDOWN) keyType = isDoubleRight ? FreeTriggerKeyType::MouseDoubleRight : FreeTriggerKeyType::MouseRight;
-            else if (msg == WM_MBUTTONDOWN) keyType = FreeTriggerKeyType::MouseMiddle;
-            else if (msg == WM_XBUTTONDOWN) {
-                WORD btn = GET_XBUTTON_WPARAM(wParam);
-                keyType = (btn == XBUTTON1) ? FreeTriggerKeyType::MouseX1 : FreeTriggerKeyType::MouseX2;
-            }
-            else if (msg == WM_MOUSEWHEEL) {
-                int delta = GET_WHEEL_DELTA_WPARAM(wParam);
-                keyType = (delta > 0) ? FreeTriggerKeyType::WheelUp : FreeTriggerKeyType::WheelDown;
-            }
-
-            if (HandleCAPTUREInput(keyType, 0))
-                return;
-        }
-
-        // --- NORMAL MODE: combo checks ---
         FreeTriggerKeyType eventType = FreeTriggerKeyType::None;
-        FreeTriggerKeyType fallbackEventType = FreeTriggerKeyType::None;
         bool isDown = false;
-        if (msg == WM_LBUTTONDOWN) {
-            eventType = isDoubleLeft ? FreeTriggerKeyType::MouseDoubleLeft : FreeTriggerKeyType::MouseLeft;
-            if (isDoubleLeft) fallbackEventType = FreeTriggerKeyType::MouseLeft;
+        if (ev.type == InputEventType::MouseDown) {
+            eventType = MouseButtonToKeyType(ev.code);
+            if (isDoubleLeft)  eventType = FreeTriggerKeyType::MouseDoubleLeft;
+            if (isDoubleRight) eventType = FreeTriggerKeyType::MouseDoubleRight;
             isDown = true;
         }
-        else if (msg == WM_RBUTTONDOWN) {
-            eventType = isDoubleRight ? FreeTriggerKeyType::MouseDoubleRight : FreeTriggerKeyType::MouseRight;
-            if (isDoubleRight) fallbackEventType = FreeTriggerKeyType::MouseRight;
+        else if (ev.type == InputEventType::Wheel) {
+            eventType = (ev.wheelDelta > 0) ? FreeTriggerKeyType::WheelUp : FreeTriggerKeyType::WheelDown;
             isDown = true;
         }
-        else if (msg == WM_MBUTTONDOWN) { eventType = FreeTriggerKeyType::MouseMiddle; isDown = true; }
-        else if (msg == WM_MOUSEWHEEL) {
-            int delta = GET_WHEEL_DELTA_WPARAM(wParam);
-            eventType = (delta > 0) ? FreeTriggerKeyType::WheelUp : FreeTriggerKeyType::WheelDown;
-            isDown = true;
+
+        // --- CAPTURE MODE ---
+        if (g_capturing && isDown) {
+            if (HandleCAPTUREInput(eventType, 0))
+                return;
         }
 
         // Long press : BUTTONUP → annuler _lpWaiting si durée non atteinte
         if (!isDown) {
             FreeTriggerKeyType upType = FreeTriggerKeyType::None;
-            if (msg == WM_LBUTTONUP)  upType = FreeTriggerKeyType::MouseLeft;
-            else if (msg == WM_RBUTTONUP)  upType = FreeTriggerKeyType::MouseRight;
-            else if (msg == WM_MBUTTONUP)  upType = FreeTriggerKeyType::MouseMiddle;
+            if (ev.type == InputEventType::MouseUp) upType = MouseButtonToKeyType(ev.code);
             if (upType != FreeTriggerKeyType::None) {
-                std::unique_lock<std::mutex> lkUp(g_comboMutex, std::try_to_lock);
-                if (lkUp.owns_lock()) {
-                    for (auto& combo : g_combos) {
+                {
+                    std::lock_guard<std::mutex> lkUp(g_comboMutex);
+                    for (int id : g_order) {
+                        FreeCombo& combo = *g_combos.Get(id);
                         if (!combo.longPressEnabled || !combo._lpWaiting) continue;
                         if (combo.trigger.keyType == upType ||
                             combo.trigger.holdKeyType == upType)
                         { combo._lpWaiting = false; combo._lpFired = false; }
                     }
                 }
+                CheckCancelOnRelease();
             }
             return;
         }
 
-        std::unique_lock<std::mutex> lock(g_comboMutex, std::try_to_lock);
-        if (!lock.owns_lock()) return;
+        // Blocking: every critical section on g_comboMutex is short (the automaton is
+        // compiled outside of it), a press is never dropped because the UI is editing.
+        std::lock_guard<std::mutex> lock(g_comboMutex);
 
-        for (int i = (int)g_combos.size() - 1; i >= 0; --i) {
-            auto& combo = g_combos[(size_t)i];
+        // Simple et double clic : l'automate rend les deux, le combo le plus prioritaire gagne
+        CollectTriggerMatchesUnlocked(TriggerKeySymbol(eventType, 0));
+        for (uint32_t id : g_triggerMatches) {
+            auto& combo = *g_combos.Get((int)id);
             if (!combo.enabled || !combo.trigger.IsValid()) continue;
-            if (combo.trigger.keyType != eventType &&
-                combo.trigger.keyType != fallbackEventType) continue;
             if (!TriggerExtraConditionsMatch(combo.trigger)) continue;
             // Long press : différer si délai configuré
             if (combo.longPressEnabled) {
-                combo._lpPressStartTime = GetTickCount();
-                combo._lpWaiting        = true;
-                combo._lpFired          = false;
+                ArmLongPressUnlocked(combo);
                 break;
             }
             // Wheel cooldown global : ignorer les doublons molette
@@ -898,11 +1371,11 @@ namespace FreeComboSystem
                 (combo.trigger.keyType == FreeTriggerKeyType::WheelUp ||
                  combo.trigger.keyType == FreeTriggerKeyType::WheelDown))
             {
-                DWORD now2 = GetTickCount();
+                DWORD now2 = ClockNow();
                 uint32_t cdMs = g_wheelCDMs.load(std::memory_order_relaxed);
-                if (now2 - g_wheelCDLastFire < cdMs)
+                if (now2 - g_wheelCDLastFire.load(std::memory_order_relaxed) < cdMs)
                     break; // trop tôt — ignorer
-                g_wheelCDLastFire = now2;
+                g_wheelCDLastFire.store(now2, std::memory_order_relaxed);
             }
             FireCombo(combo);
             break; // Prioritize latest combo and avoid double-fire (e.g. P then G).
@@ -910,39 +1383,22 @@ namespace FreeComboSystem
     }
 
     // --- KEYBOARD EVENTS ---
-    bool ProcessKeyboardEvent(UINT msg, WPARAM wParam, LPARAM lParam)
+    static void OnKeyEvent(const InputEvent& ev)
     {
-        WORD vk = (WORD)wParam;
-        bool isDown = (msg == WM_KEYDOWN || msg == WM_SYSKEYDOWN);
-        bool isUp = (msg == WM_KEYUP || msg == WM_SYSKEYUP);
-
+        WORD vk = (WORD)ev.code;
+        bool isDown = (ev.type == InputEventType::KeyDown);
+        bool isUp = (ev.type == InputEventType::KeyUp);
 
-        // Track physical held state to suppress OS auto-repeat bursts (works even if lParam repeat bit is unreliable)
-        if (isDown) {
-            if (FC_IsKeyHeld(vk)) {
-                // already held -> ignore repeated keydown
-                return false;
-            }
-            FC_SetKeyHeld(vk, true);
-        }
-        else if (isUp) {
-            FC_SetKeyHeld(vk, false);
-        }
-        // Update modifiers
-        if (vk == VK_LCONTROL || vk == VK_RCONTROL || vk == VK_CONTROL)
-            g_ctrlHeld = isDown;
-        else if (vk == VK_LSHIFT || vk == VK_RSHIFT || vk == VK_SHIFT)
-            g_shiftHeld = isDown;
-        else if (vk == VK_LMENU || vk == VK_RMENU || vk == VK_MENU)
-            g_altHeld = isDown;
-        else if (vk == VK_LWIN || vk == VK_RWIN)
-            g_winHeld = isDown;
+        // OS auto-repeat: the bus flags it (key already held) -> ignore repeated keydown
+        if (isDown && (ev.flags & InputEventFlag_Repeat))
+            return;
 
         // F2: keyUp — annuler longPress
         if (isUp) {
-            std::unique_lock<std::mutex> lkUp(g_comboMutex, std::try_to_lock);
-            if (lkUp.owns_lock()) {
-                for (auto& combo : g_combos) {
+            {
+                std::lock_guard<std::mutex> lkUp(g_comboMutex);
+                for (int id : g_order) {
+                    FreeCombo& combo = *g_combos.Get(id);
                     if (!combo.longPressEnabled) continue;
                     if (combo.trigger.keyType != FreeTriggerKeyType::Keyboard) continue;
                     if (combo.trigger.vkCode != vk) continue;
@@ -950,111 +1406,178 @@ namespace FreeComboSystem
                     combo._lpFired   = false;
                 }
             }
+            CheckCancelOnRelease();
         }
-        if (!isDown) return false;
+        if (!isDown) return;
 
         // --- CAPTURE MODE ---
         if (g_capturing)
         {
             if (HandleCAPTUREInput(FreeTriggerKeyType::Keyboard, vk))
-                return false;
+                return;
         }
 
         // --- MODE NORMAL ---
-        std::unique_lock<std::mutex> lock(g_comboMutex, std::try_to_lock);
-        if (!lock.owns_lock()) return false;
+        std::lock_guard<std::mutex> lock(g_comboMutex);
 
-        for (int i = (int)g_combos.size() - 1; i >= 0; --i) {
-            auto& combo = g_combos[(size_t)i];
+        CollectTriggerMatchesUnlocked(TriggerKeySymbol(FreeTriggerKeyType::Keyboard, vk));
+        for (uint32_t id : g_triggerMatches) {
+            auto& combo = *g_combos.Get((int)id);
             if (!combo.enabled || !combo.trigger.IsValid()) continue;
-            if (combo.trigger.keyType != FreeTriggerKeyType::Keyboard) continue;
-            if (combo.trigger.vkCode != vk) continue;
             if (!TriggerExtraConditionsMatch(combo.trigger)) continue;
             // F2: Long Press
             if (combo.longPressEnabled) {
-                combo._lpPressStartTime = GetTickCount();
-                combo._lpWaiting        = true;
-                combo._lpFired          = false;
-                return true;
+                ArmLongPressUnlocked(combo);
+                return;
             }
             FireCombo(combo);
-            return true;
+            return;
         }
-        return false;
     }
 
-    // --- TICK (repeats) ---
-    void Tick()
+    // --- ANALOG TRIGGERS (realtime thread -> input thread) ---
+    static void OnAnalogEvent(const AnalogTriggerEvent& ev)
     {
-        DWORD now = GetTickCount();
-        std::unique_lock<std::mutex> lock(g_comboMutex, std::try_to_lock);
-        if (!lock.owns_lock()) return;
-
-        for (auto& combo : g_combos) {
-            // F2: Long Press check
-            if (combo.longPressEnabled && combo._lpWaiting && !combo._lpFired) {
-                DWORD elapsed = now - combo._lpPressStartTime;
-                if (elapsed >= combo.longPressMs) {
-                    // Vérifier que le bouton/touche est encore maintenu
-                    bool stillHeld = IsTriggerKeyHeld(combo.trigger.keyType,
-                                                       combo.trigger.vkCode);
-                    if (stillHeld) {
-                        combo._lpFired   = true;
-                        combo._lpWaiting = false;
-                        FireCombo(combo);
-                    } else {
-                        // Relâché avant le délai — annuler silencieusement
-                        combo._lpWaiting = false;
-                        combo._lpFired   = false;
-                    }
-                }
-            }
-            if (!combo.enabled || !combo.repeatWhileHeld) continue;
-            if (!combo.trigger.IsValid()) continue;
-            // Long press : ne pas répéter avant que le premier tir soit parti
-            if (combo.longPressEnabled && !combo._lpFired) continue;
-
-            // Check whether trigger key/button is still held
-            bool held = IsTriggerKeyHeld(combo.trigger.keyType, combo.trigger.vkCode);
-            if (held)
-                held = TriggerExtraConditionsMatch(combo.trigger);
-
-            if (combo.cancelOnRelease && !held)
-                g_cancelCurrent.store(true, std::memory_order_relaxed);
-            if (held && (now - combo.lastExecTime >= combo.repeatDelayMs)) {
-                // Watchdog rate limiter — max kWD_MaxTrigsPerSec/s
-                DWORD rt = g_wdRateTick.load(std::memory_order_relaxed);
-                if (now - rt >= 1000) {
-                    g_wdRateTick.store(now, std::memory_order_relaxed);
-                    g_wdRateCount.store(0, std::memory_order_relaxed);
-                }
-                uint32_t cnt = g_wdRateCount.fetch_add(1, std::memory_order_relaxed);
-                if (cnt < kWD_MaxTrigsPerSec) {
-                    FireCombo(combo);
-                }
-                else {
-                    // Hard stop: clear the queue + cancel the current run - Hard stop : vider la queue + annuler le run en cours
-                    {
-                        std::lock_guard<std::mutex> qLock(g_queueMutex);
-                        while (!g_queue.empty()) g_queue.pop();
-                    }
-                    g_cancelCurrent.store(true, std::memory_order_relaxed);
-                    wchar_t buf[256];
-                    _snwprintf_s(buf, _countof(buf), _TRUNCATE,
-                        L"[WATCHDOG] Hard stop — reason: rate limit (>%u/s) — macro: %s\n",
-                        kWD_MaxTrigsPerSec, combo.name.c_str());
-                    OutputDebugStringW(buf);
-                }
+        std::lock_guard<std::mutex> lock(g_comboMutex);
+
+        // id = combo id at publication time: drop if the combo was deleted since
+        FreeCombo* c = g_combos.Get((int)ev.id);
+        if (!c) return;
+        auto& combo = *c;
+        if (!combo.enabled || !FreeTriggerKeyTypeIsAnalog(combo.trigger.keyType)) return;
+        if (VkToHid(combo.trigger.vkCode) != ev.hid) return;
+        if (!TriggerExtraConditionsMatch(combo.trigger)) return;
+        // Pas d'appui long : le seuil analogique est déjà la condition de tir
+        FireCombo(combo);
+    }
+
+    void PumpInputBus()
+    {
+        InputEvent ev;
+        while (InputBus_Poll(&g_busReader, &ev)) {
+            switch (ev.type) {
+            case InputEventType::KeyDown:
+            case InputEventType::KeyUp:
+                // Combos only listen to physical keys
+                if (!(ev.flags & InputEventFlag_Injected)) OnKeyEvent(ev);
+                break;
+            case InputEventType::MouseDown:
+            case InputEventType::MouseUp:
+            case InputEventType::Wheel:
+            case InputEventType::HWheel:
+                OnMouseEvent(ev);
+                break;
+            default:
+                break;
             }
         }
+        AnalogTriggerEvent aev;
+        while (AnalogTrigger_Poll(&aev))
+            OnAnalogEvent(aev);
+    }
+
+    // --- TICK (deadlines) ---
+    static void OnLongPressDueUnlocked(FreeCombo& combo, const ComboDeadline& d, DWORD now)
+    {
+        if (!combo._lpWaiting || combo._lpFired || d.at != combo._lpDeadline) return; // périmé
+        if (now - combo._lpPressStartTime < combo.longPressMs) {
+            // longPressMs allongé depuis l'UI pendant l'appui
+            combo._lpDeadline = combo._lpPressStartTime + combo.longPressMs;
+            ScheduleUnlocked(combo, DeadlineKind::LongPress, combo._lpDeadline);
+            return;
+        }
+        // Vérifier que le bouton/touche est encore maintenu
+        bool stillHeld = IsTriggerKeyHeld(combo.trigger.keyType, combo.trigger.vkCode);
+        combo._lpWaiting = false;
+        combo._lpFired   = stillHeld; // relâché avant le délai — annuler silencieusement
+        if (stillHeld) FireCombo(combo);
+    }
+
+    static void OnRepeatDueUnlocked(FreeCombo& combo, const ComboDeadline& d, DWORD now)
+    {
+        if (!combo._repeatArmed || d.at != combo._repeatAt) return; // périmé
+        combo._repeatArmed = false;
+        if (!combo.enabled || !combo.repeatWhileHeld || !combo.trigger.IsValid()) return;
+        // Long press : ne pas répéter avant que le premier tir soit parti
+        if (combo.longPressEnabled && !combo._lpFired) return;
+
+        // Relâché : la répétition s'arrête, le prochain appui la réarme
+        if (!IsTriggerKeyHeld(combo.trigger.keyType, combo.trigger.vkCode)) return;
+        if (!TriggerExtraConditionsMatch(combo.trigger)) {
+            // Touche toujours maintenue, modificateur / hold relâché : reprendre dès qu'il revient
+            ArmRepeatUnlocked(combo, now + kRepeatRecheckMs);
+            return;
+        }
+        DWORD due = combo.lastExecTime + combo.repeatDelayMs;
+        if ((int32_t)(now - due) < 0) {
+            // repeatDelayMs allongé depuis l'UI
+            ArmRepeatUnlocked(combo, due);
+            return;
+        }
+
+        // Watchdog rate limiter — max kWD_MaxTrigsPerSec/s
+        DWORD rt = g_wdRateTick.load(std::memory_order_relaxed);
+        if (now - rt >= 1000) {
+            g_wdRateTick.store(now, std::memory_order_relaxed);
+            g_wdRateCount.store(0, std::memory_order_relaxed);
+        }
+        uint32_t cnt = g_wdRateCount.fetch_add(1, std::memory_order_relaxed);
+        if (cnt < kWD_MaxTrigsPerSec) {
+            FireCombo(combo); // réarme la répétition suivante
+            return;
+        }
+        // Hard stop: clear the queue + cancel the current run - Hard stop : vider la queue + annuler le run en cours
+        {
+            std::lock_guard<std::mutex> qLock(g_queueMutex);
+            while (!g_queue.empty()) g_queue.pop();
+        }
+        g_cancelCurrent.store(true, std::memory_order_relaxed);
+        NotifyObserver(ComboSimEvent::RateLimitStop, &combo);
+        wchar_t buf[256];
+        _snwprintf_s(buf, _countof(buf), _TRUNCATE,
+            L"[WATCHDOG] Hard stop — reason: rate limit (>%u/s) — macro: %s\n",
+            kWD_MaxTrigsPerSec, combo.name.c_str());
+        OutputDebugStringW(buf);
+    }
+
+    bool Tick(DWORD* nextDeadlineMs)
+    {
+        {
+            // L'UI modifie aussi les combos via GetCombo() (pointeur direct) :
+            // resynchroniser la table du hook ici, c'est O(n combos) si rien n'a changé.
+            std::unique_lock<std::mutex> lkTrig(g_comboMutex);
+            RefreshTriggers(lkTrig);
+        }
+
+        std::lock_guard<std::mutex> lock(g_comboMutex);
+        DWORD now = ClockNow();
+        while (!g_deadlines.empty() && (int32_t)(now - g_deadlines.front().at) >= 0) {
+            std::pop_heap(g_deadlines.begin(), g_deadlines.end(), DeadlineLater);
+            ComboDeadline d = g_deadlines.back();
+            g_deadlines.pop_back();
+            FreeCombo* c = g_combos.Get(d.id);
+            if (!c) continue;   // deleted since
+            FreeCombo& combo = *c;
+            if (d.kind == DeadlineKind::LongPress) OnLongPressDueUnlocked(combo, d, now);
+            else                                    OnRepeatDueUnlocked(combo, d, now);
+        }
+
+        if (g_deadlines.empty()) return false;
+        if (nextDeadlineMs) *nextDeadlineMs = g_deadlines.front().at;
+        return true;
+    }
+
+    DWORD NowMs()
+    {
+        return ClockNow();
     }
 
     // --- EXAMPLES ---
     bool HasExampleCombos()
     {
         std::lock_guard<std::mutex> lock(g_comboMutex);
-        for (const auto& c : g_combos)
-            if (c.isExample) return true;
+        for (int id : g_order)
+            if (g_combos.Get(id)->isExample) return true;
         return false;
     }
 
@@ -1069,8 +1592,9 @@ namespace FreeComboSystem
             c.trigger.holdKeyType = FreeTriggerKeyType::MouseRight;
             ComboAction a; a.type = ComboActionType::TapKey; a.keyHid = VkToHid('P');
             c.actions.push_back(a);
-            std::lock_guard<std::mutex> lock(g_comboMutex);
-            g_combos.push_back(c);
+            std::unique_lock<std::mutex> lock(g_comboMutex);
+            InsertComboUnlocked(std::move(c));
+            RefreshTriggers(lock);
         }
     }
 
@@ -1091,35 +1615,37 @@ namespace FreeComboSystem
         // 3. Reset injected mouse status (live mouse view) - Reset état souris injecté (vue live mouse)
         g_injectedMouseState.store(0, std::memory_order_relaxed);
 
-        // 4. Auto-release keys potentially held down by a macro - Auto-release touches potentiellement maintenues par une macro
+        // 4+5. Auto-release keys and mouse buttons potentially held down by a macro,
+        // in a single SendInput (UI thread: own sink, the worker's coalescer is not shared)
+        // Auto-release touches + boutons souris potentiellement maintenus par une macro
         static const WORD keysToRelease[] = {
             VK_LCONTROL, VK_RCONTROL,
             VK_LSHIFT,   VK_RSHIFT,
             VK_LMENU,    VK_RMENU,
             VK_LWIN,     VK_RWIN
         };
-        for (WORD vk : keysToRelease) {
-            INPUT i{};
-            i.type = INPUT_KEYBOARD;
-            i.ki.wVk = vk;
-            i.ki.wScan = (WORD)MapVirtualKeyW(vk, MAPVK_VK_TO_VSC);
-            i.ki.dwFlags = KEYEVENTF_KEYUP | KEYEVENTF_SCANCODE;
-            i.ki.dwExtraInfo = (ULONG_PTR)0x484A4D43ULL;
-            SendInput(1, &i, sizeof(INPUT));
+        OutputEvent releases[_countof(keysToRelease) + 5];
+        uint32_t n = 0;
+        for (WORD vk : keysToRelease)
+            releases[n++] = { OutputEventKind::Key, true, vk, 0 };
+        for (uint16_t b = 0; b < 5; ++b)
+            releases[n++] = { OutputEventKind::MouseButton, true, b, 0 };
+        SendInputSink sink;
+        sink.Send(releases, n);
+
+        // 6. Analogs a macro still holds (the worker may be mid-run: it releases
+        // its own at the end of the run, clearing twice is harmless)
+        for (int chunk = 0; chunk < 4; ++chunk) {
+            uint64_t bits = g_macroAnalogHids[chunk].exchange(0, std::memory_order_relaxed);
+            for (int b = 0; bits; ++b, bits >>= 1) {
+                if (!(bits & 1ull)) continue;
+                const uint16_t hid = (uint16_t)(chunk * 64 + b);
+                BackendUI_SetAnalogMilli(hid, 0);
+                Backend_ClearMacroAnalog(hid);
+            }
         }
 
-        // 5. Auto-release boutons souris
-        INPUT mouseReleases[5] = {};
-        mouseReleases[0].type = INPUT_MOUSE; mouseReleases[0].mi.dwFlags = MOUSEEVENTF_LEFTUP;
-        mouseReleases[1].type = INPUT_MOUSE; mouseReleases[1].mi.dwFlags = MOUSEEVENTF_RIGHTUP;
-        mouseReleases[2].type = INPUT_MOUSE; mouseReleases[2].mi.dwFlags = MOUSEEVENTF_MIDDLEUP;
-        mouseReleases[3].type = INPUT_MOUSE; mouseReleases[3].mi.dwFlags = MOUSEEVENTF_XUP;
-        mouseReleases[3].mi.mouseData = XBUTTON1;
-        mouseReleases[4].type = INPUT_MOUSE; mouseReleases[4].mi.dwFlags = MOUSEEVENTF_XUP;
-        mouseReleases[4].mi.mouseData = XBUTTON2;
-        SendInput(5, mouseReleases, sizeof(INPUT));
-
-        // 6. Log
+        // 7. Log
         wchar_t buf[256];
         _snwprintf_s(buf, _countof(buf), _TRUNCATE,
             L"[EMERGENCY STOP] reason: %s\n", reason);
@@ -1132,6 +1658,7 @@ namespace FreeComboSystem
     void SetWhitelistMode(int mode)  // 0=Off  1=Whitelist  2=FocusOnly
     {
         g_wlMode.store(mode, std::memory_order_relaxed);
+        RefreshForegroundCache();
     }
     int GetWhitelistMode()
     {
@@ -1139,8 +1666,11 @@ namespace FreeComboSystem
     }
     void SetWhitelist(const std::vector<std::wstring>& apps)
     {
-        std::lock_guard<std::mutex> lk(g_wlMutex);
-        g_whitelist = apps;
+        {
+            std::lock_guard<std::mutex> lk(g_wlMutex);
+            g_whitelist = apps;
+        }
+        RefreshForegroundCache();
     }
     std::vector<std::wstring> GetWhitelist()
     {
@@ -1149,17 +1679,51 @@ namespace FreeComboSystem
     }
     void AddToWhitelist(const std::wstring& exeName)
     {
-        std::lock_guard<std::mutex> lk(g_wlMutex);
-        for (const auto& w : g_whitelist)
-            if (_wcsicmp(w.c_str(), exeName.c_str()) == 0) return;
-        g_whitelist.push_back(exeName);
+        {
+            std::lock_guard<std::mutex> lk(g_wlMutex);
+            for (const auto& w : g_whitelist)
+                if (_wcsicmp(w.c_str(), exeName.c_str()) == 0) return;
+            g_whitelist.push_back(exeName);
+        }
+        RefreshForegroundCache();
     }
     void RemoveFromWhitelist(const std::wstring& exeName)
     {
-        std::lock_guard<std::mutex> lk(g_wlMutex);
-        g_whitelist.erase(std::remove_if(g_whitelist.begin(), g_whitelist.end(),
-            [&](const std::wstring& w) { return _wcsicmp(w.c_str(), exeName.c_str()) == 0; }),
-            g_whitelist.end());
+        {
+            std::lock_guard<std::mutex> lk(g_wlMutex);
+            g_whitelist.erase(std::remove_if(g_whitelist.begin(), g_whitelist.end(),
+                [&](const std::wstring& w) { return _wcsicmp(w.c_str(), exeName.c_str()) == 0; }),
+                g_whitelist.end());
+        }
+        RefreshForegroundCache();
+    }
+
+    // ── Horloge / simulation ─────────────────────────────────
+    void SetClock(IComboClock* clock)
+    {
+        g_clock.store(clock, std::memory_order_release);
+    }
+    void SetDryRun(bool dryRun)
+    {
+        g_dryRun.store(dryRun, std::memory_order_relaxed);
+    }
+    void SetObserver(ComboObserverFn fn, void* user)
+    {
+        std::lock_guard<std::mutex> lock(g_comboMutex);
+        g_observer = fn;
+        g_observerUser = user;
+    }
+
+    // ── Pacing de sortie ─────────────────────────────────────
+    void SetOutputPacing(const OutputPacing& pacing)
+    {
+        std::lock_guard<std::mutex> lk(g_pacingMutex);
+        g_pacing = pacing;
+    }
+    OutputPacing GetOutputPacing()
+    {
+        std::lock_guard<std::mutex> lk(g_pacingMutex);
+        return g_pacing;
     }
 
     // ── Wheel Cooldown global API ────────────────────────────
@@ -1184,230 +1748,100 @@ namespace FreeComboSystem
     {
         if (!g_wheelCDEnabled.load(std::memory_order_relaxed)) return true;
         // Si WATCHMAN actif : ne bloquer QUE dans les apps listées
+        // (valeur en cache : pas d'OpenProcess dans le hook, cf. RefreshForegroundCache)
         int wlMode = g_wlMode.load(std::memory_order_relaxed);
-        if (wlMode != 0 && !InjectionAllowed()) return true; // app non listée → laisser passer
+        if (wlMode != 0 && !g_fgInjectionAllowed.load(std::memory_order_relaxed)) return true; // app non listée → laisser passer
         // Appliquer le cooldown
-        DWORD now = GetTickCount();
+        DWORD now = ClockNow();
         uint32_t cdMs = g_wheelCDMs.load(std::memory_order_relaxed);
-        if (now - g_wheelCDLastFire < cdMs) return false; // trop tôt → bloquer
-        g_wheelCDLastFire = now;
+        if (now - g_wheelCDLastFire.load(std::memory_order_relaxed) < cdMs) return false; // trop tôt → bloquer
+        g_wheelCDLastFire.store(now, std::memory_order_relaxed);
         return true;
     }
 
+    void RefreshForegroundCache()
+    {
+        g_fgInjectionAllowed.store(InjectionAllowed(), std::memory_order_relaxed);
+    }
+
+    bool IsKeyboardTriggerCandidate(WORD vk, const HookHeldState& held)
+    {
+        if (vk >= 256) return false;
+        for (int i = 0; i < kTriggerVkConds; ++i) {
+            const uint32_t c = g_triggerVkConds[vk][i].load(std::memory_order_relaxed);
+            if (!c) break;
+            if (!(held.modifiers & (1u << (c & 0xFF)))) continue;
+            // keyTypeIsHold : la touche trigger est celle qu'on presse, elle est maintenue
+            const FreeTriggerKeyType hold = (FreeTriggerKeyType)((c >> 8) & 0xFF);
+            const WORD holdVk = (WORD)((c >> 16) & 0xFF);
+            bool holdOk = true;
+            switch (hold) {
+            case FreeTriggerKeyType::None:     break;
+            case FreeTriggerKeyType::Keyboard: holdOk = held.keys && held.keys[holdVk]; break;
+            case FreeTriggerKeyType::MouseLeft:
+            case FreeTriggerKeyType::MouseRight:
+            case FreeTriggerKeyType::MouseMiddle:
+            case FreeTriggerKeyType::MouseX1:
+            case FreeTriggerKeyType::MouseX2:
+                holdOk = (held.mouseButtons >> ((unsigned)hold - (unsigned)FreeTriggerKeyType::MouseLeft)) & 1u;
+                break;
+            default:                           holdOk = IsTriggerKeyHeld(hold, holdVk); break; // analog: atomics
+            }
+            if (holdOk) return true;
+        }
+        return false;
+    }
+
     bool SaveToFile(const wchar_t* path)
     {
-        std::lock_guard<std::mutex> lock(g_comboMutex);
-        FILE* f = nullptr;
-        if (_wfopen_s(&f, path, L"w") != 0 || !f) return false;
-
-        fwprintf(f, L"DRDRE_FREECOMBOS_V5\n");
-        // Whitelist config
-        fwprintf(f, L"WL_MODE %d\n", g_wlMode.load(std::memory_order_relaxed));
-        fwprintf(f, L"WHEEL_CD %d %u\n",
-            g_wheelCDEnabled.load(std::memory_order_relaxed) ? 1 : 0,
-            g_wheelCDMs.load(std::memory_order_relaxed));
+        if (!path) return false;
+        ComboLibrary lib;
         {
-            std::lock_guard<std::mutex> wlLk(g_wlMutex);
-            fwprintf(f, L"WL_COUNT %u\n", (unsigned)g_whitelist.size());
-            for (const auto& w : g_whitelist)
-                fwprintf(f, L"WL_ENTRY %s\n", w.c_str());
-        }
-        fwprintf(f, L"%u\n", (unsigned)g_combos.size());
-
-        for (const auto& combo : g_combos) {
-            fwprintf(f, L"%s\n", combo.name.c_str());
-            fwprintf(f, L"%d %d %d %d %d %d\n",
-                (int)combo.trigger.modifier,
-                (int)combo.trigger.keyType,
-                (int)combo.trigger.vkCode,
-                (int)combo.trigger.holdKeyType,
-                (int)combo.trigger.holdVkCode,
-                combo.trigger.keyTypeIsHold ? 1 : 0);
-            fwprintf(f, L"%d %d %d %d %u %d %d %u\n",
-                combo.enabled ? 1 : 0,
-                combo.repeatWhileHeld ? 1 : 0,
-                combo.repeatDelayMs,
-                combo.isExample ? 1 : 0,
-                combo.repeatCount,
-                combo.cancelOnRelease ? 1 : 0,
-                combo.longPressEnabled ? 1 : 0,
-                combo.longPressMs);
-            fwprintf(f, L"%u\n", (unsigned)combo.actions.size());
-            for (const auto& action : combo.actions) {
-                std::wstring textLine = action.text;
-                for (wchar_t& ch : textLine) {
-                    if (ch == L'\r' || ch == L'\n') ch = L' ';
-                }
-                if (textLine.empty()) textLine = L"__EMPTY__";
-                fwprintf(f, L"%d %d %d %d\n",
-                    (int)action.type, action.keyHid, action.delayMs, action.mouseButton);
-                fwprintf(f, L"%s\n", textLine.c_str());
+            std::lock_guard<std::mutex> lock(g_comboMutex);
+            lib.combos.reserve(g_order.size());
+            for (int id : g_order) {
+                FreeCombo& c = *g_combos.Get(id);
+                if (c.uid == 0) c.uid = g_nextComboUid++;
+                lib.combos.push_back(c);
             }
         }
-        fclose(f);
+        lib.wlMode = g_wlMode.load(std::memory_order_relaxed);
+        lib.wheelCDEnabled = g_wheelCDEnabled.load(std::memory_order_relaxed);
+        lib.wheelCDMs = g_wheelCDMs.load(std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> wlLk(g_wlMutex);
+            lib.whitelist = g_whitelist;
+        }
+        lib.hasSettings = true;
+        ComboStore_Post(path, std::move(lib));
         return true;
     }
 
     // --- LOAD ---
     bool LoadFromFile(const wchar_t* path)
     {
-        std::lock_guard<std::mutex> lock(g_comboMutex);
-        FILE* f = nullptr;
-        if (_wfopen_s(&f, path, L"r") != 0 || !f) return false;
-
-        std::wstring line;
-        if (!ReadLine(f, line)) { fclose(f); return false; }
-        bool isV5 = false, isV4 = false, isV3 = false, isV2 = false;
-        if (line == L"DRDRE_FREECOMBOS_V5") { isV5 = true; isV4 = true; isV3 = true; }
-        else if (line == L"DRDRE_FREECOMBOS_V4") { isV4 = true; isV3 = true; }
-        else if (line == L"DRDRE_FREECOMBOS_V3") isV3 = true;
-        else if (line == L"DRDRE_FREECOMBOS_V2") isV2 = true;
-        else if (line == L"DRDRE_FREECOMBOS_V1") {}
-        else { fclose(f); return false; }
-
-        // V5 : read the whitelist configuration before the combos - lire la config whitelist avant les combos
-        if (isV5) {
-            std::wstring wlLine;
-            if (ReadLine(f, wlLine)) {
-                int wlm = 0;
-                if (swscanf_s(wlLine.c_str(), L"WL_MODE %d", &wlm) == 1)
-                    g_wlMode.store(wlm, std::memory_order_relaxed);
-            }
-            // Wheel cooldown global (optionnel — compat anciens fichiers)
-            bool wlAlreadyRead = false;
-            if (ReadLine(f, wlLine)) {
-                int wce = 0; unsigned wcms = 150;
-                if (swscanf_s(wlLine.c_str(), L"WHEEL_CD %d %u", &wce, &wcms) == 2) {
-                    // Nouveau format : ligne WHEEL_CD présente
-                    g_wheelCDEnabled.store(wce != 0, std::memory_order_relaxed);
-                    g_wheelCDMs.store(wcms > 0 ? wcms : 150, std::memory_order_relaxed);
-                } else {
-                    // Ancien format : pas de WHEEL_CD, cette ligne = WL_COUNT
-                    unsigned wlCount2 = 0;
-                    if (swscanf_s(wlLine.c_str(), L"WL_COUNT %u", &wlCount2) == 1) {
-                        std::lock_guard<std::mutex> wlLk2(g_wlMutex);
-                        g_whitelist.clear();
-                        for (unsigned wi = 0; wi < wlCount2; ++wi) {
-                            std::wstring entry;
-                            if (!ReadLine(f, entry)) break;
-                            if (entry.size() > 9 && entry.substr(0, 9) == L"WL_ENTRY ")
-                                g_whitelist.push_back(entry.substr(9));
-                        }
-                        wlAlreadyRead = true;
-                    }
-                }
-            }
-            if (!wlAlreadyRead && ReadLine(f, wlLine)) {
-                unsigned wlCount = 0;
-                if (swscanf_s(wlLine.c_str(), L"WL_COUNT %u", &wlCount) == 1) {
-                    std::lock_guard<std::mutex> wlLk(g_wlMutex);
-                    g_whitelist.clear();
-                    for (unsigned wi = 0; wi < wlCount; ++wi) {
-                        std::wstring entry;
-                        if (!ReadLine(f, entry)) break;
-                        if (entry.size() > 9 && entry.substr(0, 9) == L"WL_ENTRY ")
-                            g_whitelist.push_back(entry.substr(9));
-                    }
-                }
-            }
+        // Lecture + décodage hors du verrou combos
+        ComboLibrary lib;
+        if (!ComboStore_Load(path, &lib)) return false;
+
+        if (lib.hasSettings) {
+            g_wlMode.store(lib.wlMode, std::memory_order_relaxed);
+            g_wheelCDEnabled.store(lib.wheelCDEnabled, std::memory_order_relaxed);
+            g_wheelCDMs.store(lib.wheelCDMs, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> wlLk(g_wlMutex);
+            g_whitelist = std::move(lib.whitelist);
         }
 
-        unsigned countU = 0;
-        if (!ReadLine(f, line) || swscanf_s(line.c_str(), L"%u", &countU) != 1) { fclose(f); return false; }
-        size_t count = (size_t)countU;
-
-        std::vector<FreeCombo> loaded;
-        bool parseOk = true;
-
-        for (size_t i = 0; i < count; ++i) {
-            FreeCombo combo;
-            if (!ReadLine(f, combo.name)) { parseOk = false; break; }
-
-            int mod = 0, keyType = 0, vk = 0, holdKeyType = 0, holdVk = 0, keyTypeIsHoldInt = 0;
-            if (!ReadLine(f, line)) { parseOk = false; break; }
-            if (isV3 || isV2) {
-                // Lire 5 champs minimum, 6e (keyTypeIsHold) optionnel (compat anciens fichiers)
-                int nRead = swscanf_s(line.c_str(), L"%d %d %d %d %d %d",
-                    &mod, &keyType, &vk, &holdKeyType, &holdVk, &keyTypeIsHoldInt);
-                if (nRead < 5) { parseOk = false; break; }
-            }
-            else {
-                if (swscanf_s(line.c_str(), L"%d %d %d", &mod, &keyType, &vk) != 3)
-                {
-                    parseOk = false; break;
-                }
-            }
-            combo.trigger.modifier      = (FreeTriggerModifier)mod;
-            combo.trigger.keyType       = (FreeTriggerKeyType)keyType;
-            combo.trigger.vkCode        = (WORD)vk;
-            combo.trigger.holdKeyType   = (FreeTriggerKeyType)holdKeyType;
-            combo.trigger.holdVkCode    = (WORD)holdVk;
-            combo.trigger.keyTypeIsHold = (keyTypeIsHoldInt != 0);
-
-            int en = 0, rep = 0, del = 0, isEx = 0; unsigned rcount = 0;
-            int crel = 0, lp = 0; unsigned lpms = 300;
-            if (!ReadLine(f, line)) { parseOk = false; break; }
-            if (isV4) swscanf_s(line.c_str(), L"%d %d %d %d %u %d %d %u",
-                &en, &rep, &del, &isEx, &rcount, &crel, &lp, &lpms);
-            else      swscanf_s(line.c_str(), L"%d %d %d %d", &en, &rep, &del, &isEx);
-            combo.enabled = (en != 0);
-            combo.repeatWhileHeld = (rep != 0);
-            combo.repeatDelayMs = del;
-            combo.isExample = (isEx != 0);
-            combo.repeatCount = rcount;
-            combo.cancelOnRelease = (crel != 0);
-            combo.longPressEnabled = (lp != 0);
-            combo.longPressMs = (lpms > 0) ? lpms : 300;
-
-            unsigned actionCountU = 0;
-            if (!ReadLine(f, line) || swscanf_s(line.c_str(), L"%u", &actionCountU) != 1)
-            {
-                parseOk = false; break;
-            }
-            size_t actionCount = (size_t)actionCountU;
-            for (size_t j = 0; j < actionCount; ++j) {
-                ComboAction action;
-                int type = 0, hid = 0, d = 0, btn = 0;
-                if (!ReadLine(f, line)) { parseOk = false; break; }
-                if (swscanf_s(line.c_str(), L"%d %d %d %d", &type, &hid, &d, &btn) != 4)
-                {
-                    parseOk = false; break;
-                }
-                action.type = (ComboActionType)type;
-                action.keyHid = hid;
-                action.delayMs = d;
-                action.mouseButton = btn;
-                if (isV3) {
-                    std::wstring txt;
-                    if (!ReadLine(f, txt)) { parseOk = false; break; }
-                    action.text = (txt == L"__EMPTY__") ? L"" : txt;
-                }
-                else {
-                    int consumed = 0;
-                    if (swscanf_s(line.c_str(), L"%d %d %d %d %n", &type, &hid, &d, &btn, &consumed) == 4 &&
-                        consumed > 0 && consumed < (int)line.size())
-                    {
-                        std::wstring tail = TrimLine(line.substr((size_t)consumed));
-                        action.text = (tail == L"__EMPTY__") ? L"" : tail;
-                    }
-                    else {
-                        action.text.clear();
-                    }
-                }
-                combo.actions.push_back(action);
-            }
-            if (!parseOk) break;
-            loaded.push_back(combo);
+        std::unique_lock<std::mutex> lock(g_comboMutex);
+        // New ids: ids handed out before the load must not resolve to loaded combos
+        g_combos.Clear();
+        g_order.clear();
+        for (auto& c : lib.combos) {
+            if (c.uid >= g_nextComboUid) g_nextComboUid = c.uid + 1;
+            InsertComboUnlocked(std::move(c));
         }
-        fclose(f);
-
-        // FIX : if the parsing was at least partially successful, we apply what we have - si le parsing a reussi au moins partiellement, on applique ce qu on a.
-        //  The old condition loaded.size() != count rejected EVERYTHING if 1 combo was corrupted. - L ancienne condition loaded.size() != count rejetait TOUT si 1 combo etait corrompu.
-        // Now we accept a partial LOAD rather than losing everything. - Desormais on accepte un LOAD partiel plutot que de tout perdre.
-        if (!parseOk && loaded.empty())
-            return false;   // Fichier totalement illisible -> echec propre
-
-        g_combos = std::move(loaded);
+        RescheduleAllUnlocked();
+        RefreshTriggers(lock);
         return true;
     }
 
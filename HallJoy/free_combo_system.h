@@ -13,6 +13,8 @@
 
 // Reuse action types from the existing combo system
 #include "mouse_combo_system.h"
+#include "output_coalescer.h" // OutputPacing
+#include "combo_clock.h"      // IComboClock
 
 // Main trigger key type
 enum class FreeTriggerKeyType
@@ -28,8 +30,18 @@ enum class FreeTriggerKeyType
     WheelDown,      // Wheel down
     MouseDoubleLeft,   // Double left click
     MouseDoubleRight,  // Double right click
+    AnalogDepth,            // Keyboard key (VK) crossing a depth threshold (analog_trigger.h)
+    AnalogVelocity,         // Keyboard key pressed faster than a speed
+    AnalogDoubleActuation,  // Keyboard key actuated twice without full release
+    AnalogActuation,        // Every actuation of the key (per-key actuation point / rapid trigger, actuation.h)
 };
 
+inline bool FreeTriggerKeyTypeIsAnalog(FreeTriggerKeyType t)
+{
+    return t == FreeTriggerKeyType::AnalogDepth || t == FreeTriggerKeyType::AnalogVelocity ||
+        t == FreeTriggerKeyType::AnalogDoubleActuation || t == FreeTriggerKeyType::AnalogActuation;
+}
+
 // Supported modifiers
 enum class FreeTriggerModifier
 {
@@ -49,6 +61,7 @@ struct FreeTrigger
     FreeTriggerKeyType  holdKeyType  = FreeTriggerKeyType::None; // Optional held button/key
     WORD                holdVkCode   = 0;    // For holdKeyType == Keyboard
     bool                keyTypeIsHold = false; // true = keyType doit aussi être maintenu (hold+hold)
+    uint32_t            analogParam  = 50;   // Analog*: depth % (Depth, DoubleActuation) or mm/s (Velocity), unused by Actuation
     
     bool IsValid() const { return keyType != FreeTriggerKeyType::None; }
     std::wstring ToString() const;      // Ex: "Ctrl + F" or "Shift + Left click"
@@ -57,6 +70,7 @@ struct FreeTrigger
 // Free combo
 struct FreeCombo
 {
+    uint32_t                uid             = 0;     // identifiant stable dans free_combos.dat (attribué à la 1re sauvegarde)
     std::wstring            name;
     FreeTrigger             trigger;
     std::vector<ComboAction> actions;
@@ -75,9 +89,17 @@ struct FreeCombo
     DWORD    _lpPressStartTime = 0;
     bool     _lpWaiting        = false;
     bool     _lpFired          = false;
+    DWORD    _lpDeadline       = 0;      // échéance armée pour l'appui en cours
+
+    // State interne repeat-while-held — non sérialisé
+    DWORD    _repeatAt         = 0;      // prochaine répétition armée
+    bool     _repeatArmed      = false;
 
     // State interne wheel — non sérialisé
     DWORD    _lastWheelFireTime = 0;
+
+    // Id dans le registre (handle, voir CreateCombo) — non sérialisé
+    int      _id               = -1;
 };
 
 // Free combo management system
@@ -87,10 +109,12 @@ namespace FreeComboSystem
     void Shutdown();
 
     // CRUD
+    // Ids are stable handles: unchanged by delete / reorder / other edits, never
+    // reused for another combo (a stale id makes GetCombo return nullptr).
     int  CreateCombo(const std::wstring& name);
     bool DeleteCombo(int id);
-    FreeCombo* GetCombo(int id);
-    std::vector<int> GetAllIds();
+    FreeCombo* GetCombo(int id);   // O(1); pointer valid until the combo is deleted
+    std::vector<int> GetAllIds();  // list order (last = highest trigger priority)
     int  GetCount();
 
     // Actions
@@ -105,8 +129,8 @@ namespace FreeComboSystem
 
     // Options
     bool SetEnabled(int id, bool enabled);
-    bool SwapCombos(int idA, int idB); // swap two combos in the internal list (for drag & drop reorder)
-    // Déplace le combo à l'index srcIdx vers dstIdx (déplacement direct, sans swaps successifs)
+    bool SwapCombos(int idA, int idB); // swap the list positions of two combos (for drag & drop reorder)
+    // Déplace le combo à la position srcIdx de la liste vers dstIdx (seul l'ordre bouge, ids inchangés)
     bool MoveCombo(int srcIdx, int dstIdx);
     bool SetRepeat(int id, bool repeat, uint32_t delayMs);
     bool SetRepeatCount(int id, uint32_t count);
@@ -124,12 +148,29 @@ namespace FreeComboSystem
     bool IsCaptureWaitingSecondInput();
     FreeTrigger GetCaptureFirstInput();
 
-    // Events (called by existing hooks)
-    void ProcessMouseEvent(UINT msg, WPARAM wParam, LPARAM lParam);
-    bool ProcessKeyboardEvent(UINT msg, WPARAM wParam, LPARAM lParam); // true => event consumed
-
-    // Tick for repeats
-    void Tick();
+    // Events: consumes everything published on the input bus since the last call
+    // (combos + trigger capture). Input thread only, see input_thread.cpp.
+    void PumpInputBus();
+
+    // What the LL hooks see held right now (their own tracking: the bus lags behind).
+    struct HookHeldState
+    {
+        uint8_t     modifiers = 1;      // bit (1 << FreeTriggerModifier), bit 0 (None) always set
+        uint8_t     mouseButtons = 0;   // bit (FreeTriggerKeyType - MouseLeft), MouseLeft..MouseX2
+        const bool* keys = nullptr;     // 256 entries, by VK
+    };
+
+    // Lock-free, safe from the LL keyboard hook.
+    // true => pressing vk now fires (or arms the long press of) an enabled keyboard
+    // combo: its modifier and its hold key are held, as the input thread will check.
+    bool IsKeyboardTriggerCandidate(WORD vk, const HookHeldState& held);
+
+    // Deadlines (long press, repeat-while-held) due at NowMs(), then resync of the hook table.
+    // Called by the combo_timer thread (combo_timer.h), or by the simulator.
+    // Returns false when nothing is scheduled, else *nextDeadlineMs = next deadline.
+    bool Tick(DWORD* nextDeadlineMs = nullptr);
+    // Engine time: installed clock, else QPC in ms (wraps like GetTickCount).
+    DWORD NowMs();
 
     // ── Whitelist d'applications ─────────────────────────────────────────────
     // Empêche l'injection clavier/souris dans les apps non autorisées.
@@ -145,6 +186,24 @@ namespace FreeComboSystem
     void AddToWhitelist(const std::wstring& exeName);          // ex: L"cs2.exe"
     void RemoveFromWhitelist(const std::wstring& exeName);
 
+    // ── Horloge injectable / simulation (combo_sim.h) ────────
+    // Every engine time read (long press, repeats, cooldowns, watchdog, capture)
+    // goes through this clock. nullptr = QPC milliseconds (default).
+    void SetClock(IComboClock* clock);
+    // Dry run: a fired combo is only reported to the observer, no macro is queued.
+    void SetDryRun(bool dryRun);
+    enum class ComboSimEvent { Fired, CancelRequested, RateLimitStop };
+    // Called under the combo lock (input thread / Tick) with the combo id.
+    using ComboObserverFn = void (*)(void* user, ComboSimEvent ev, int comboId, DWORD nowMs);
+    void SetObserver(ComboObserverFn fn, void* user);
+
+    // ── Pacing de sortie des macros ──────────────────────────
+    // Burst (défaut) : un écart après chaque action, TypeText part dans un seul SendInput.
+    // Paced : timings historiques, un écart aussi après chaque caractère.
+    // settings.ini [MacroOutput]. Pris en compte au prochain run.
+    void SetOutputPacing(const OutputPacing& pacing);
+    OutputPacing GetOutputPacing();
+
     // ── Wheel Cooldown global ────────────────────────────────
     void SetWheelCooldown(bool enabled, uint32_t ms);
     bool     GetWheelCooldownEnabled();
@@ -152,8 +211,13 @@ namespace FreeComboSystem
     // Hook bas niveau : true = laisser passer, false = bloquer
     // Vérifie cooldown ET WATCHMAN (ne bloque que si app en whitelist)
     bool IsWheelEventAllowed();
+    // Re-evaluate the whitelist against the foreground app (call on focus change).
+    // IsWheelEventAllowed() only reads the cached result.
+    void RefreshForegroundCache();
 
-    // Save / Load
+    // Save / Load (combo_store.h)
+    // SaveToFile copies the library under the combo lock and hands it to the persistence
+    // service thread (only changed combos are appended). Shutdown() waits for it.
     bool SaveToFile(const wchar_t* path);
     bool LoadFromFile(const wchar_t* path);
 
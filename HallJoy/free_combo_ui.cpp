@@ -27,6 +27,8 @@
 
 #include "free_combo_ui.h"
 #include "free_combo_system.h"
+#include "key_table.h"
+#include "macro_recorder.h"
 #include "ui_theme.h"
 #include "win_util.h"
 #include "Resource.h"   // IDR_LANTERN_20_PNG / IDR_LANTERN_24_PNG
@@ -259,6 +261,8 @@ static HWND g_hEditName = nullptr;
 // Trigger card
 static HWND g_hLblTrigger = nullptr;
 static HWND g_hBtnCapture = nullptr;
+static HWND g_hAnalogModeCB    = nullptr;  // Keyboard trigger read as digital or analog
+static HWND g_hEditAnalogParam = nullptr;  // Depth % / mm/s
 // Options card
 static HWND g_hChkEnabled      = nullptr;
 static HWND g_hChkRepeat       = nullptr;
@@ -280,7 +284,9 @@ static HWND g_hBtnAddDelay = nullptr;
 static HWND g_hBtnDelAct = nullptr;
 static HWND g_hBtnUp = nullptr;
 static HWND g_hBtnDown = nullptr;
+static HWND g_hBtnRecord = nullptr;
 static HWND g_hBtnSave = nullptr;
+static int  g_recordComboId = -1;   // combo receiving the recording
 
 // ── Whitelist UI ─────────────────────────────────────────────────────────────
 static HWND g_hWlModeCB = nullptr;
@@ -332,11 +338,44 @@ static LRESULT CALLBACK ComboListSubclassProc(HWND hWnd, UINT msg, WPARAM wParam
 static const wchar_t* ACTION_NAMES[] = {
     L"Press key", L"Release key", L"Tap key",
     L"Type text", L"Mouse click", L"Wait (ms)",
+    // Macro language (value field: see ActionValueHint)
+    L"Random wait (min max)", L"Loop (count, 0=forever)", L"End loop",
+    L"If key held", L"If depth above (key milli)", L"If var below (var value)",
+    L"Else", L"End if",
+    L"Set var (var value)", L"Add var (var delta)",
+    L"Analog set (key milli)", L"Analog ramp (key milli ms)", L"Analog release",
 };
 static const COLORREF ACTION_COLORS[] = {
     Pal::ActPress, Pal::ActRel, Pal::ActTap,
     Pal::ActText,  Pal::ActClick, Pal::ActDelay,
+    Pal::ActDelay, Pal::ActText, Pal::ActText,
+    Pal::ActText,  Pal::ActText, Pal::ActText,
+    Pal::ActText,  Pal::ActText,
+    Pal::ActRel,   Pal::ActRel,
+    Pal::ActPress, Pal::ActPress, Pal::ActPress,
 };
+static constexpr int ACTION_TYPE_COUNT = (int)(sizeof(ACTION_NAMES) / sizeof(ACTION_NAMES[0]));
+static_assert(ACTION_TYPE_COUNT == (int)(sizeof(ACTION_COLORS) / sizeof(ACTION_COLORS[0])), "ACTION_NAMES / ACTION_COLORS mismatch");
+
+// Default text of the value field for each action type (combobox index)
+static const wchar_t* ActionValueHint(int ti)
+{
+    switch (ti) {
+    case 3:  return L"";           // Type text
+    case 4:  return L"left";       // Mouse click
+    case 5:  return L"100";        // Wait ms
+    case 6:  return L"50 150";     // Random wait
+    case 7:  return L"5";          // Loop
+    case 8: case 12: case 13: return L"";
+    case 10: return L"W 500";      // If depth above
+    case 11: return L"0 10";       // If var below
+    case 14: return L"0 0";        // Set var
+    case 15: return L"0 1";        // Add var
+    case 16: return L"W 700";      // Analog set
+    case 17: return L"W 1000 200"; // Analog ramp
+    default: return L"P";          // Key
+    }
+}
 
 // ────────────────────────────────────────────────────────────────────
 // Font helpers
@@ -447,7 +486,9 @@ static std::wstring ActionLabel(const ComboAction& a)
     auto keyName = [&](int hid) -> std::wstring {
         wchar_t n[64]{}; UINT sc = MapVirtualKeyW(HidToVk(hid), MAPVK_VK_TO_VSC);
         GetKeyNameTextW((LONG)(sc << 16), n, 64);
-        return n[0] ? std::wstring(n) : L"?";
+        if (n[0]) return std::wstring(n);
+        const wchar_t* label = KeyTable_Label((uint16_t)hid);
+        return label ? std::wstring(label) : L"?";
         };
     switch (a.type) {
     case ComboActionType::PressKey:   return L"Press      " + keyName(a.keyHid);
@@ -459,6 +500,26 @@ static std::wstring ActionLabel(const ComboAction& a)
         return std::wstring(L"Click      ") + b[a.mouseButton < 5 ? a.mouseButton : 0];
     }
     case ComboActionType::Delay: return L"Wait       " + std::to_wstring(a.delayMs) + L" ms";
+    case ComboActionType::RandomDelay:
+        return L"Wait rand  " + std::to_wstring(a.delayMs) + L"-" + std::to_wstring(a.mouseButton) + L" ms";
+    case ComboActionType::Loop:
+        return a.mouseButton > 0 ? L"Loop       x" + std::to_wstring(a.mouseButton) : std::wstring(L"Loop       forever");
+    case ComboActionType::EndLoop:   return L"End loop";
+    case ComboActionType::IfKeyHeld: return L"If held    " + keyName(a.keyHid);
+    case ComboActionType::IfAnalogAbove:
+        return L"If depth   " + keyName(a.keyHid) + L" > " + std::to_wstring(a.mouseButton);
+    case ComboActionType::IfVarBelow:
+        return L"If var     v" + std::to_wstring(a.keyHid) + L" < " + std::to_wstring(a.mouseButton);
+    case ComboActionType::Else:   return L"Else";
+    case ComboActionType::EndIf:  return L"End if";
+    case ComboActionType::SetVar: return L"Set var    v" + std::to_wstring(a.keyHid) + L" = " + std::to_wstring(a.mouseButton);
+    case ComboActionType::AddVar: return L"Add var    v" + std::to_wstring(a.keyHid) + L" += " + std::to_wstring(a.mouseButton);
+    case ComboActionType::AnalogSet:
+        return L"Analog     " + keyName(a.keyHid) + L" = " + std::to_wstring(a.mouseButton);
+    case ComboActionType::AnalogRamp:
+        return L"Ramp       " + keyName(a.keyHid) + L" -> " + std::to_wstring(a.mouseButton) +
+            L" in " + std::to_wstring(a.delayMs) + L" ms";
+    case ComboActionType::AnalogRelease: return L"Analog off " + keyName(a.keyHid);
     default: return L"?";
     }
 }
@@ -470,10 +531,62 @@ static int ActionTypeIdx(ComboActionType t)
     case ComboActionType::TapKey:     return 2;
     case ComboActionType::TypeText:   return 3;
     case ComboActionType::MouseClick: return 4;
+    case ComboActionType::RandomDelay:   return 6;
+    case ComboActionType::Loop:          return 7;
+    case ComboActionType::EndLoop:       return 8;
+    case ComboActionType::IfKeyHeld:     return 9;
+    case ComboActionType::IfAnalogAbove: return 10;
+    case ComboActionType::IfVarBelow:    return 11;
+    case ComboActionType::Else:          return 12;
+    case ComboActionType::EndIf:         return 13;
+    case ComboActionType::SetVar:        return 14;
+    case ComboActionType::AddVar:        return 15;
+    case ComboActionType::AnalogSet:     return 16;
+    case ComboActionType::AnalogRamp:    return 17;
+    case ComboActionType::AnalogRelease: return 18;
     default:                           return 5;
     }
 }
 
+// Key name typed in the value field ("P", "F5", "Space"...) -> HID, 0 if unknown
+static uint16_t ParseActionKeyHid(const wchar_t* kbuf)
+{
+    WORD vk = 0;
+    if (wcslen(kbuf) == 1) {
+        wchar_t c2 = towupper(kbuf[0]);
+        if ((c2 >= L'A' && c2 <= L'Z') || (c2 >= L'0' && c2 <= L'9'))vk = (WORD)c2;
+    }
+    else {
+        struct { const wchar_t* s; WORD vk; }map[] = {
+            {L"F1",VK_F1},{L"F2",VK_F2},{L"F3",VK_F3},{L"F4",VK_F4},
+            {L"F5",VK_F5},{L"F6",VK_F6},{L"F7",VK_F7},{L"F8",VK_F8},
+            {L"F9",VK_F9},{L"F10",VK_F10},{L"F11",VK_F11},{L"F12",VK_F12},
+            {L"Space",VK_SPACE},{L"Enter",VK_RETURN},{L"Tab",VK_TAB},
+            {L"Esc",VK_ESCAPE},{L"Delete",VK_DELETE},
+            {L"Shift",VK_SHIFT},{L"Ctrl",VK_CONTROL},{L"Control",VK_CONTROL},
+            {L"Alt",VK_MENU},{L"Win",VK_LWIN},{L"Windows",VK_LWIN},
+            {L"Up",VK_UP},{L"Down",VK_DOWN},{L"Left",VK_LEFT},{L"Right",VK_RIGHT},
+        };
+        for (auto& e : map) if (_wcsicmp(kbuf, e.s) == 0) { vk = e.vk; break; }
+    }
+    return VkToHid(vk);
+}
+
+// "W 500 200" -> key HID + up to 2 integers
+static uint16_t ParseKeyAndInts(const wchar_t* kbuf, int* n1, int* n2)
+{
+    wchar_t key[64]{};
+    int i = 0;
+    while (kbuf[i] && kbuf[i] != L' ' && i < 63) { key[i] = kbuf[i]; ++i; }
+    if (n1 || n2) {
+        int a = 0, b = 0;
+        int got = swscanf_s(kbuf + i, L"%d %d", &a, &b);
+        if (n1 && got >= 1) *n1 = a;
+        if (n2 && got >= 2) *n2 = b;
+    }
+    return ParseActionKeyHid(key);
+}
+
 // ────────────────────────────────────────────────────────────────────
 // Double-buffer helper
 // ────────────────────────────────────────────────────────────────────
@@ -1147,6 +1260,49 @@ static void RefreshTriggerLabel()
         c->trigger.IsValid() ? c->trigger.ToString().c_str() : L"(not configured)");
 }
 
+// Analog mode combobox, same order as the items
+static const FreeTriggerKeyType kAnalogModeTypes[] = {
+    FreeTriggerKeyType::Keyboard, FreeTriggerKeyType::AnalogDepth,
+    FreeTriggerKeyType::AnalogVelocity, FreeTriggerKeyType::AnalogDoubleActuation,
+    FreeTriggerKeyType::AnalogActuation,
+};
+static const wchar_t* const kAnalogModeNames[] = { L"Digital", L"Depth %", L"Speed mm/s", L"Double %", L"Actuation" };
+static constexpr int kAnalogModeCount = (int)(sizeof(kAnalogModeTypes) / sizeof(kAnalogModeTypes[0]));
+
+static bool IsKeyTrigger(const FreeTrigger& t)
+{
+    return t.keyType == FreeTriggerKeyType::Keyboard || FreeTriggerKeyTypeIsAnalog(t.keyType);
+}
+
+// Keyboard trigger <-> analog trigger on the same key, from the mode combobox + param edit
+static void ApplyAnalogModeFromUI(FreeTrigger& t)
+{
+    if (!g_hAnalogModeCB || !IsKeyTrigger(t)) return;
+    int sel = std::clamp(CB_GETSEL(g_hAnalogModeCB), 0, kAnalogModeCount - 1);
+    t.keyType = kAnalogModeTypes[sel];
+    if (sel == 0 || t.keyType == FreeTriggerKeyType::AnalogActuation) return; // no parameter
+    int v = g_hEditAnalogParam ? GetWindowTextInt(g_hEditAnalogParam) : 0;
+    t.analogParam = (t.keyType == FreeTriggerKeyType::AnalogVelocity)
+        ? (uint32_t)std::clamp(v, 1, 2000)   // mm/s
+        : (uint32_t)std::clamp(v, 1, 99);    // % of travel
+    if (g_hEditAnalogParam) SetWindowTextInt(g_hEditAnalogParam, (int)t.analogParam);
+}
+
+static void LoadAnalogModeToUI(const FreeTrigger* t)
+{
+    if (!g_hAnalogModeCB) return;
+    int sel = 0;
+    for (int i = 0; t && i < kAnalogModeCount; ++i)
+        if (t->keyType == kAnalogModeTypes[i]) sel = i;
+    CB_SETSEL(g_hAnalogModeCB, sel);
+    if (g_hEditAnalogParam) SetWindowTextInt(g_hEditAnalogParam, t ? (int)t->analogParam : 50);
+    // Only a keyboard key has a depth: mouse / wheel triggers stay digital
+    const bool keyTrigger = t && IsKeyTrigger(*t);
+    EnableWindow(g_hAnalogModeCB, keyTrigger);
+    if (g_hEditAnalogParam)
+        EnableWindow(g_hEditAnalogParam, keyTrigger && sel > 0 && kAnalogModeTypes[sel] != FreeTriggerKeyType::AnalogActuation);
+}
+
 static void RefreshActionList()
 {
     if (!g_hActionList) return;
@@ -1159,12 +1315,51 @@ static void RefreshActionList()
     InvalidateRect(g_hActionList, nullptr, TRUE);
 }
 
+// ── Macro recorder ──────────────────────────────────────────
+static void StartRecording()
+{
+    if (g_selectedId < 0 || MacroRecorder_IsRecording()) return;
+    g_recordComboId = g_selectedId;
+    MacroRecorder_Start();
+    SetWindowTextW(g_hBtnRecord, L"\u23F9  Stop");
+    SetTimer(g_hPage, FreeComboUI::ID_TIMER_RECORD, 100, nullptr);
+}
+
+static void OnRecordTimer()
+{
+    MacroRecorder_Drain();
+    MacroRecStats st;
+    MacroRecorder_GetStats(&st);
+    wchar_t buf[48];
+    _snwprintf_s(buf, _countof(buf), _TRUNCATE, L"\u23F9  Stop (%u)", st.events);
+    SetWindowTextW(g_hBtnRecord, buf);
+}
+
+// Recording -> actions appended to the combo it was started on
+static void StopRecording()
+{
+    if (!MacroRecorder_IsRecording()) return;
+    KillTimer(g_hPage, FreeComboUI::ID_TIMER_RECORD);
+    std::vector<MacroRecEvent> events;
+    MacroRecorder_Stop(&events);
+    SetWindowTextW(g_hBtnRecord, L"\u23FA  Record");
+
+    std::vector<ComboAction> actions;
+    MacroRecorder_Compile(events, MacroRecOptions{}, &actions);
+    for (const ComboAction& a : actions)
+        FreeComboSystem::AddAction(g_recordComboId, a);
+    g_recordComboId = -1;
+    RefreshActionList();
+    if (!actions.empty()) PersistToDisk();
+}
+
 static void UpdateControlsEnabled()
 {
     bool has = (g_selectedId >= 0);
     auto En = [&](HWND h) { if (h && IsWindow(h)) EnableWindow(h, has); };
     En(g_hEditName);    En(g_hLblTrigger);
     En(g_hBtnCapture);  En(g_hChkEnabled); En(g_hChkRepeat);
+    if (!has) LoadAnalogModeToUI(nullptr);
     if (g_hChkCancelRel)    EnableWindow(g_hChkCancelRel,    has);
     if (g_hEditRepeatCount) EnableWindow(g_hEditRepeatCount, has);
     En(g_hEditDelay);   En(g_hDelaySlider); En(g_hDelayValue);
@@ -1178,6 +1373,7 @@ static void UpdateControlsEnabled()
     En(g_hActionList);  En(g_hActionTypeCB); En(g_hActionKeyEdt);
     En(g_hBtnAdd);      En(g_hBtnAddDelay);  En(g_hBtnDelAct);
     En(g_hBtnUp);       En(g_hBtnDown);      En(g_hBtnSave);
+    if (g_hBtnRecord) EnableWindow(g_hBtnRecord, has || MacroRecorder_IsRecording());
     En(g_hBtnDelete);
     // Mouse capture button: only enabled when "Mouse click" type is selected
     if (g_hBtnCaptureMouse && IsWindow(g_hBtnCaptureMouse)) {
@@ -1207,6 +1403,7 @@ static void LoadComboToUI()
     RefreshTriggerLabel();
     RefreshActionList();
     UpdateControlsEnabled();
+    LoadAnalogModeToUI(&c->trigger);
 }
 
 // ────────────────────────────────────────────────────────────────────
@@ -1356,6 +1553,11 @@ namespace FreeComboUI
             }
             break;
 
+        case ID_BTN_RECORD:
+            if (MacroRecorder_IsRecording()) StopRecording();
+            else StartRecording();
+            break;
+
         case ID_BTN_CAPTURE_MOUSE:
             if (!g_capturingMouseAction) {
                 g_capturingMouseAction = true;
@@ -1382,33 +1584,31 @@ namespace FreeComboUI
                 ComboActionType::TypeText,   // 3
                 ComboActionType::MouseClick, // 4
                 ComboActionType::Delay,      // 5
+                ComboActionType::RandomDelay,   // 6
+                ComboActionType::Loop,          // 7
+                ComboActionType::EndLoop,       // 8
+                ComboActionType::IfKeyHeld,     // 9
+                ComboActionType::IfAnalogAbove, // 10
+                ComboActionType::IfVarBelow,    // 11
+                ComboActionType::Else,          // 12
+                ComboActionType::EndIf,         // 13
+                ComboActionType::SetVar,        // 14
+                ComboActionType::AddVar,        // 15
+                ComboActionType::AnalogSet,     // 16
+                ComboActionType::AnalogRamp,    // 17
+                ComboActionType::AnalogRelease, // 18
             };
-            action.type = (ti >= 0 && ti < 6) ? kTypeMap[ti] : ComboActionType::TapKey;
+            static_assert(sizeof(kTypeMap) / sizeof(kTypeMap[0]) == ACTION_TYPE_COUNT, "kTypeMap / ACTION_NAMES mismatch");
+            action.type = (ti >= 0 && ti < ACTION_TYPE_COUNT) ? kTypeMap[ti] : ComboActionType::TapKey;
             wchar_t kbuf[256]{}; GetWindowTextW(g_hActionKeyEdt, kbuf, 256);
 
             if (action.type == ComboActionType::PressKey ||
                 action.type == ComboActionType::ReleaseKey ||
-                action.type == ComboActionType::TapKey)
+                action.type == ComboActionType::TapKey ||
+                action.type == ComboActionType::IfKeyHeld ||
+                action.type == ComboActionType::AnalogRelease)
             {
-                WORD vk = 0;
-                if (wcslen(kbuf) == 1) {
-                    wchar_t c2 = towupper(kbuf[0]);
-                    if ((c2 >= L'A' && c2 <= L'Z') || (c2 >= L'0' && c2 <= L'9'))vk = (WORD)c2;
-                }
-                else {
-                    struct { const wchar_t* s; WORD vk; }map[] = {
-                        {L"F1",VK_F1},{L"F2",VK_F2},{L"F3",VK_F3},{L"F4",VK_F4},
-                        {L"F5",VK_F5},{L"F6",VK_F6},{L"F7",VK_F7},{L"F8",VK_F8},
-                        {L"F9",VK_F9},{L"F10",VK_F10},{L"F11",VK_F11},{L"F12",VK_F12},
-                        {L"Space",VK_SPACE},{L"Enter",VK_RETURN},{L"Tab",VK_TAB},
-                        {L"Esc",VK_ESCAPE},{L"Delete",VK_DELETE},
-                        {L"Shift",VK_SHIFT},{L"Ctrl",VK_CONTROL},{L"Control",VK_CONTROL},
-                        {L"Alt",VK_MENU},{L"Win",VK_LWIN},{L"Windows",VK_LWIN},
-                        {L"Up",VK_UP},{L"Down",VK_DOWN},{L"Left",VK_LEFT},{L"Right",VK_RIGHT},
-                    };
-                    for (auto& e : map) if (_wcsicmp(kbuf, e.s) == 0) { vk = e.vk; break; }
-                }
-                action.keyHid = VkToHid(vk);
+                action.keyHid = ParseActionKeyHid(kbuf);
             }
             else if (action.type == ComboActionType::Delay)    action.delayMs = _wtoi(kbuf);
             else if (action.type == ComboActionType::TypeText)  action.text = kbuf;
@@ -1419,6 +1619,37 @@ namespace FreeComboUI
                 else if (_wcsicmp(kbuf, L"x2") == 0 || _wcsicmp(kbuf, L"x2 (thumb2)") == 0) action.mouseButton = 4;
                 // else: left click = 0 (default)
             }
+            else if (action.type == ComboActionType::RandomDelay) {
+                int lo = 0, hi = 0;
+                if (swscanf_s(kbuf, L"%d%*[ -]%d", &lo, &hi) < 2) hi = lo;
+                action.delayMs = (uint32_t)(std::max)(0, lo);
+                action.mouseButton = (std::max)(0, hi);
+            }
+            else if (action.type == ComboActionType::Loop) {
+                action.mouseButton = (std::max)(0, _wtoi(kbuf));
+            }
+            else if (action.type == ComboActionType::IfVarBelow ||
+                     action.type == ComboActionType::SetVar ||
+                     action.type == ComboActionType::AddVar)
+            {
+                int var = 0, val = 0;
+                swscanf_s(kbuf, L"%d %d", &var, &val);
+                action.keyHid = (uint16_t)std::clamp(var, 0, 7);
+                action.mouseButton = val;
+            }
+            else if (action.type == ComboActionType::IfAnalogAbove ||
+                     action.type == ComboActionType::AnalogSet)
+            {
+                int milli = 0;
+                action.keyHid = ParseKeyAndInts(kbuf, &milli, nullptr);
+                action.mouseButton = std::clamp(milli, 0, 1000);
+            }
+            else if (action.type == ComboActionType::AnalogRamp) {
+                int milli = 0, ms = 0;
+                action.keyHid = ParseKeyAndInts(kbuf, &milli, &ms);
+                action.mouseButton = std::clamp(milli, 0, 1000);
+                action.delayMs = (uint32_t)(std::max)(0, ms);
+            }
             FreeComboSystem::AddAction(g_selectedId, action);
             RefreshActionList();
             { int n = (int)SendMessageW(g_hActionList, LB_GETCOUNT, 0, 0); if (n > 0)LB_SETCUR(g_hActionList, n - 1); }
@@ -1488,6 +1719,22 @@ namespace FreeComboUI
                     PersistToDisk();
                 }
             break;
+        case ID_ANALOG_MODE_CB:
+        case ID_EDIT_ANALOG_PARAM:
+            if (g_selectedId < 0) break;
+            if ((ctlId == ID_ANALOG_MODE_CB && notif == CBN_SELCHANGE) ||
+                (ctlId == ID_EDIT_ANALOG_PARAM && notif == EN_KILLFOCUS))
+                if (FreeCombo* c = FreeComboSystem::GetCombo(g_selectedId)) {
+                    FreeTrigger t = c->trigger;
+                    ApplyAnalogModeFromUI(t);
+                    FreeComboSystem::SetTrigger(g_selectedId, t); // republie les seuils temps réel
+                    if (c->enabled) DisableOtherCombosWithSameTrigger(g_selectedId);
+                    LoadAnalogModeToUI(&c->trigger);
+                    RefreshTriggerLabel();
+                    RefreshComboList();
+                    PersistToDisk();
+                }
+            break;
         } // switch
     }
 
@@ -1499,6 +1746,7 @@ namespace FreeComboUI
             g_capturing = false;
             if (g_selectedId >= 0) {
                 FreeTrigger t = FreeComboSystem::GetCapturedTrigger();
+                ApplyAnalogModeFromUI(t); // une touche capturée garde le mode analogique choisi
                 FreeComboSystem::SetTrigger(g_selectedId, t);
                 if (FreeCombo* c = FreeComboSystem::GetCombo(g_selectedId))
                     if (c->enabled) DisableOtherCombosWithSameTrigger(g_selectedId);
@@ -1626,6 +1874,12 @@ namespace FreeComboUI
         g_hBtnCapture = CreateWindowExW(0, L"BUTTON", L"\u25CF  Capture trigger",
             WS_CHILD | WS_VISIBLE | BS_OWNERDRAW,
             rx, ry, 204, btnH, g_hPage, (HMENU)ID_BTN_CAPTURE, hInst, nullptr);
+        // Analog mode of a keyboard trigger (items added after ApplyFontChildren)
+        g_hAnalogModeCB = CreateWindowExW(0, L"COMBOBOX", L"", WS_CHILD | WS_VISIBLE | CBS_DROPDOWNLIST,
+            rx + 212, ry, 92, 200, g_hPage, (HMENU)ID_ANALOG_MODE_CB, hInst, nullptr);
+        g_hEditAnalogParam = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"50",
+            WS_CHILD | WS_VISIBLE | ES_NUMBER,
+            rx + 308, ry, 44, rowH, g_hPage, (HMENU)ID_EDIT_ANALOG_PARAM, hInst, nullptr);
         ry += btnH + 14;
 
         // ─ Options card ─
@@ -1726,12 +1980,13 @@ g_hActionTypeCB = CreateWindowExW(0, L"COMBOBOX", L"", WS_CHILD | WS_VISIBLE | C
             rx + (w3 + 4) * 2, ry, w3, btnH, g_hPage, (HMENU)ID_BTN_DEL_ACTION, hInst, nullptr);
         ry += btnH + 4;
 
-        // Buttons Up / Down (2 columns)
-        const int w2 = (rw - 4) / 2;
+        // Buttons Up / Down / Record (3 columns)
         g_hBtnUp = CreateWindowExW(0, L"BUTTON", L"\u25B2  Move up", WS_CHILD | WS_VISIBLE | BS_OWNERDRAW,
-            rx, ry, w2, btnH, g_hPage, (HMENU)ID_BTN_UP_ACTION, hInst, nullptr);
+            rx, ry, w3, btnH, g_hPage, (HMENU)ID_BTN_UP_ACTION, hInst, nullptr);
         g_hBtnDown = CreateWindowExW(0, L"BUTTON", L"\u25BC  Move down", WS_CHILD | WS_VISIBLE | BS_OWNERDRAW,
-            rx + w2 + 4, ry, w2, btnH, g_hPage, (HMENU)ID_BTN_DOWN_ACTION, hInst, nullptr);
+            rx + w3 + 4, ry, w3, btnH, g_hPage, (HMENU)ID_BTN_DOWN_ACTION, hInst, nullptr);
+        g_hBtnRecord = CreateWindowExW(0, L"BUTTON", L"\u23FA  Record", WS_CHILD | WS_VISIBLE | BS_OWNERDRAW,
+            rx + (w3 + 4) * 2, ry, w3, btnH, g_hPage, (HMENU)ID_BTN_RECORD, hInst, nullptr);
         ry += btnH + 8;
 
         // Save button (full width, blue accent)
@@ -1743,6 +1998,7 @@ g_hActionTypeCB = CreateWindowExW(0, L"COMBOBOX", L"", WS_CHILD | WS_VISIBLE | C
         auto ApplyTheme = [&](HWND h) { if (h) UiTheme::ApplyToControl(h); };
         ApplyTheme(g_hComboList); ApplyTheme(g_hEditName);   ApplyTheme(g_hLblTrigger);
         ApplyTheme(g_hBtnCapture); ApplyTheme(g_hActionList); ApplyTheme(g_hActionTypeCB);
+        ApplyTheme(g_hAnalogModeCB); ApplyTheme(g_hEditAnalogParam);
         ApplyTheme(g_hActionKeyEdt); ApplyTheme(g_hBtnCaptureMouse);
         ApplyTheme(g_hChkRepeat); ApplyTheme(g_hChkEnabled);
         if (g_hChkCancelRel)    ApplyTheme(g_hChkCancelRel);
@@ -1756,8 +2012,12 @@ g_hActionTypeCB = CreateWindowExW(0, L"COMBOBOX", L"", WS_CHILD | WS_VISIBLE | C
         // Apply font to combobox manually (skipped by ApplyFontChildren) then add items
         if (HFONT f = GetFont(g_hPage))
             SendMessageW(g_hActionTypeCB, WM_SETFONT, (WPARAM)f, FALSE);
-        for (int i = 0; i < 6; ++i) CB_ADD(g_hActionTypeCB, ACTION_NAMES[i]);
+        for (int i = 0; i < ACTION_TYPE_COUNT; ++i) CB_ADD(g_hActionTypeCB, ACTION_NAMES[i]);
         CB_SETSEL(g_hActionTypeCB, 2);
+        if (HFONT f = GetFont(g_hPage))
+            SendMessageW(g_hAnalogModeCB, WM_SETFONT, (WPARAM)f, FALSE);
+        for (int i = 0; i < kAnalogModeCount; ++i) CB_ADD(g_hAnalogModeCB, kAnalogModeNames[i]);
+        LoadAnalogModeToUI(nullptr);
 
         if (g_hBtnCaptureMouse) ShowWindow(g_hBtnCaptureMouse, SW_HIDE);
         SetDelayUi(400);
@@ -1970,9 +2230,7 @@ static LRESULT CALLBACK FreeComboPageProc(HWND hWnd, UINT msg, WPARAM wParam, LP
                     // Reset grace so any ongoing capture doesn't catch the combobox click
                     g_captureGraceUntil = GetTickCount() + 300;
                 }
-                else if (ti == 5)   SetWindowTextW(g_hActionKeyEdt, L"100");   // Wait ms
-                else if (ti == 3)   SetWindowTextW(g_hActionKeyEdt, L"");      // Type text
-                else                SetWindowTextW(g_hActionKeyEdt, L"P");     // Key
+                else SetWindowTextW(g_hActionKeyEdt, ActionValueHint(ti));
             }
             return 0;
         }
@@ -1995,6 +2253,7 @@ static LRESULT CALLBACK FreeComboPageProc(HWND hWnd, UINT msg, WPARAM wParam, LP
         // ── Capture timer ─────────────────────────────────────────────
     case WM_TIMER:
         if (wParam == FreeComboUI::ID_TIMER_CAPTURE) { FreeComboUI::OnTimer(); return 0; }
+        if (wParam == FreeComboUI::ID_TIMER_RECORD)  { OnRecordTimer(); return 0; }
         if (wParam == FreeComboUI::ID_TIMER_MOUSE_CAPTURE) {
             struct { int vk; int btn; const wchar_t* name; } btns[] = {
                 { VK_LBUTTON,  0, L"left"        },
@@ -2102,6 +2361,8 @@ static LRESULT CALLBACK FreeComboPageProc(HWND hWnd, UINT msg, WPARAM wParam, LP
         if (g_hLblTrigger)   SetWindowPos(g_hLblTrigger, nullptr, rx, ry, rw, rowH, SWP_NOZORDER);
         ry += rowH + Sc(hWnd, 6);
         if (g_hBtnCapture)   SetWindowPos(g_hBtnCapture, nullptr, rx, ry, Sc(hWnd, 204), btnH, SWP_NOZORDER);
+        if (g_hAnalogModeCB) SetWindowPos(g_hAnalogModeCB, nullptr, rx + Sc(hWnd, 212), ry, Sc(hWnd, 92), Sc(hWnd, 200), SWP_NOZORDER);
+        if (g_hEditAnalogParam) SetWindowPos(g_hEditAnalogParam, nullptr, rx + Sc(hWnd, 308), ry, Sc(hWnd, 44), rowH, SWP_NOZORDER);
         ry += btnH + Sc(hWnd, 14);
 
         // Options card
@@ -2155,11 +2416,13 @@ static LRESULT CALLBACK FreeComboPageProc(HWND hWnd, UINT msg, WPARAM wParam, LP
         }
         ry += btnH + Sc(hWnd, 4);
 
-        // 2-column buttons: Up / Down
+        // 3-column buttons: Up / Down / Record
         {
-            int w2 = (rw - Sc(hWnd, 4)) / 2;
-            if (g_hBtnUp)   SetWindowPos(g_hBtnUp, nullptr, rx, ry, w2, btnH, SWP_NOZORDER);
-            if (g_hBtnDown) SetWindowPos(g_hBtnDown, nullptr, rx + w2 + Sc(hWnd, 4), ry, w2, btnH, SWP_NOZORDER);
+            int w3 = (rw - Sc(hWnd, 8)) / 3;
+            int g3 = Sc(hWnd, 4);
+            if (g_hBtnUp)     SetWindowPos(g_hBtnUp, nullptr, rx, ry, w3, btnH, SWP_NOZORDER);
+            if (g_hBtnDown)   SetWindowPos(g_hBtnDown, nullptr, rx + w3 + g3, ry, w3, btnH, SWP_NOZORDER);
+            if (g_hBtnRecord) SetWindowPos(g_hBtnRecord, nullptr, rx + (w3 + g3) * 2, ry, w3, btnH, SWP_NOZORDER);
         }
         ry += btnH + Sc(hWnd, 8);
 
@@ -2325,16 +2588,13 @@ static LRESULT CALLBACK FreeComboPageProc(HWND hWnd, UINT msg, WPARAM wParam, LP
             if (src >= 0 && dst >= 0 && src != dst
                 && src < (int)g_comboIds.size() && dst < (int)g_comboIds.size()) {
                 // Déplacement direct : src → dst en une seule opération
-                // g_comboIds[i] == i car les IDs sont des index séquentiels
-                // MoveCombo fait un std::rotate dans g_combos
+                // src / dst sont des positions dans la liste ; les IDs sont stables,
+                // MoveCombo ne fait que réordonner la liste de priorité
+                int movedId = g_comboIds[(size_t)src];
                 FreeComboSystem::MoveCombo(src, dst);
-                // Reconstruire g_comboIds depuis le nouvel ordre
-                int selId = -1;
+                // Reconstruire g_comboIds depuis le nouvel ordre, le combo déplacé reste sélectionné
+                g_selectedId = movedId;
                 FreeComboUI::RefreshComboList();
-                // Sélectionner le combo qui était à src (maintenant à dst)
-                if (dst < (int)g_comboIds.size())
-                    selId = g_comboIds[(size_t)dst];
-                if (selId >= 0) FreeComboUI::SelectCombo(selId);
                 PersistToDisk();
             }
             InvalidateRect(g_hComboList, nullptr, FALSE);
@@ -49,8 +49,12 @@ namespace FreeComboUI
         ID_EDIT_REPEAT_COUNT  = 2023,  // Run N times
         ID_CHK_LONG_PRESS     = 2024,  // Long press enable
         ID_EDIT_LONG_PRESS_MS = 2025,  // Long press duration (ms)
+        ID_ANALOG_MODE_CB     = 2026,  // Keyboard trigger: digital / depth / speed / double actuation
+        ID_EDIT_ANALOG_PARAM  = 2027,  // Analog trigger: depth % or mm/s
+        ID_BTN_RECORD         = 2028,  // Record live input into the action list
         ID_TIMER_CAPTURE = 2099,
         ID_TIMER_MOUSE_CAPTURE = 2098,  // Poll mouse during action capture
+        ID_TIMER_RECORD = 2097,         // Drain the macro recorder while recording
         // Whitelist UI
         ID_WL_MODE_CB  = 2090,
         ID_WL_LIST     = 2091,
@@ -92,6 +92,56 @@ void GamepadRender_DrawTriggerBar01(HDC hdc, RECT rc, uint8_t v)
         FillRect(hdc, &fill, GamepadRender_GetTriggerFillBrush());
 }
 
+void GamepadRender_DrawStick2D(HDC hdc, RECT rc, SHORT x, SHORT y, const StickShapeConfig& shape)
+{
+    const int side = std::min(rc.right - rc.left, rc.bottom - rc.top);
+    if (side < 8) return;
+    RECT box{ rc.left, rc.top, rc.left + side, rc.top + side };
+    DrawFramedBox(hdc, box);
+
+    const int cx = (box.left + box.right) / 2;
+    const int cy = (box.top + box.bottom) / 2;
+    const float rad = (side - 4) * 0.5f;
+
+    HGDIOBJ oldPen = SelectObject(hdc, PenMid());
+    HGDIOBJ oldBrush = SelectObject(hdc, GetStockObject(HOLLOW_BRUSH));
+
+    auto circle = [&](float r01) {
+        const int r = (int)lround(rad * r01);
+        if (r > 0) Ellipse(hdc, cx - r, cy - r, cx + r + 1, cy + r + 1);
+        };
+
+    // Unit circle: where a shaped (circular) stick can go
+    circle(1.0f);
+    if (shape.innerM > 0) circle(shape.innerM / 1000.0f);
+    if (shape.outerM < 1000) circle(shape.outerM / 1000.0f);
+
+    if (shape.snap != StickSnap::Off)
+    {
+        const int stepDeg = (shape.snap == StickSnap::Four) ? 90 : 45;
+        for (int deg = 0; deg < 360; deg += stepDeg)
+        {
+            for (int edge = -1; edge <= 1; edge += 2)
+            {
+                const float a = (float)(deg + edge * shape.snapDeg) * 3.14159265f / 180.0f;
+                MoveToEx(hdc, cx, cy, nullptr);
+                LineTo(hdc, cx + (int)lround(rad * std::cos(a)), cy - (int)lround(rad * std::sin(a)));
+            }
+        }
+    }
+
+    // Position (XInput Y is up)
+    const int px = cx + (int)lround(rad * std::clamp((float)x / 32767.0f, -1.0f, 1.0f));
+    const int py = cy - (int)lround(rad * std::clamp((float)y / 32767.0f, -1.0f, 1.0f));
+    const int dot = std::max(2, side / 24);
+    SelectObject(hdc, GetStockObject(NULL_PEN));
+    SelectObject(hdc, GamepadRender_GetAxisFillBrush());
+    Ellipse(hdc, px - dot, py - dot, px + dot + 1, py + dot + 1);
+
+    SelectObject(hdc, oldBrush);
+    SelectObject(hdc, oldPen);
+}
+
 std::wstring GamepadRender_ButtonsToString(WORD w)
 {
     std::wstring s;
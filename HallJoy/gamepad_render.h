@@ -7,6 +7,8 @@
 
 #include <ViGEm/Client.h>
 
+#include "stick_shape.h"
+
 // Shared UI helpers for rendering an XUSB_REPORT (used by Debug page and Tester page).
 
 HBRUSH GamepadRender_GetAxisFillBrush();    // cached
@@ -15,5 +17,9 @@ HBRUSH GamepadRender_GetTriggerFillBrush(); // cached
 void GamepadRender_DrawAxisBarCentered(HDC hdc, RECT rc, SHORT v);
 void GamepadRender_DrawTriggerBar01(HDC hdc, RECT rc, uint8_t v);
 
+// Stick position in 2D (square, centred in rc) over the shaping config:
+// unit circle, inner / outer deadzones and snap directions.
+void GamepadRender_DrawStick2D(HDC hdc, RECT rc, SHORT x, SHORT y, const StickShapeConfig& shape);
+
 // Converts wButtons bitmask to a compact string like "A LB DU"
 std::wstring GamepadRender_ButtonsToString(WORD wButtons);
\ No newline at end of file
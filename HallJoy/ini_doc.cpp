@@ -0,0 +1,642 @@
+// ini_doc.cpp
+#include "ini_doc.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace
+{
+    bool IsSpace(wchar_t c)
+    {
+        return c == L' ' || c == L'\t' || c == L'\r' || c == L'\n' || c == L'\v' || c == L'\f';
+    }
+
+    std::wstring_view Trim(std::wstring_view s)
+    {
+        size_t a = 0, b = s.size();
+        while (a < b && IsSpace(s[a])) ++a;
+        while (b > a && IsSpace(s[b - 1])) --b;
+        return s.substr(a, b - a);
+    }
+
+    wchar_t FoldAscii(wchar_t c)
+    {
+        return (c >= L'A' && c <= L'Z') ? (wchar_t)(c - L'A' + L'a') : c;
+    }
+
+    void AppendCodePoint(std::wstring& out, uint32_t cp)
+    {
+        if constexpr (sizeof(wchar_t) == 2)
+        {
+            if (cp >= 0x10000)
+            {
+                cp -= 0x10000;
+                out.push_back((wchar_t)(0xD800 + (cp >> 10)));
+                out.push_back((wchar_t)(0xDC00 + (cp & 0x3FF)));
+                return;
+            }
+        }
+        out.push_back((wchar_t)cp);
+    }
+
+    // Strict UTF-8: false on the first invalid sequence (then the file is ANSI).
+    bool DecodeUtf8(const uint8_t* p, size_t n, std::wstring& out)
+    {
+        out.clear();
+        out.reserve(n);
+        for (size_t i = 0; i < n;)
+        {
+            const uint8_t c = p[i];
+            if (c < 0x80) { out.push_back((wchar_t)c); ++i; continue; }
+
+            int extra;
+            uint32_t cp;
+            if ((c & 0xE0) == 0xC0)      { extra = 1; cp = c & 0x1F; }
+            else if ((c & 0xF0) == 0xE0) { extra = 2; cp = c & 0x0F; }
+            else if ((c & 0xF8) == 0xF0) { extra = 3; cp = c & 0x07; }
+            else return false;
+
+            if (i + (size_t)extra >= n) return false;
+            for (int k = 1; k <= extra; ++k)
+            {
+                const uint8_t cc = p[i + (size_t)k];
+                if ((cc & 0xC0) != 0x80) return false;
+                cp = (cp << 6) | (cc & 0x3F);
+            }
+            static constexpr uint32_t kMin[4] = { 0, 0x80, 0x800, 0x10000 };
+            if (cp < kMin[extra] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return false;
+
+            AppendCodePoint(out, cp);
+            i += (size_t)extra + 1;
+        }
+        return true;
+    }
+}
+
+void IniDoc::Clear()
+{
+    m_text.clear();
+    m_lines.clear();
+    m_sections.clear();
+    m_sections.emplace_back();     // lines before the first header
+    m_index.clear();
+    m_indexUsed = 0;
+    m_liveKeys = 0;
+    m_lastSection = -1;
+}
+
+void IniDoc::Parse(std::wstring_view text)
+{
+    Clear();
+    m_text.reserve(text.size() + text.size() / 4);
+    m_lines.reserve(text.size() / 16);
+
+    uint32_t cur = 0;
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        size_t eol = text.find(L'\n', pos);
+        if (eol == std::wstring_view::npos) eol = text.size();
+        std::wstring_view raw = text.substr(pos, eol - pos);
+        if (!raw.empty() && raw.back() == L'\r') raw.remove_suffix(1);
+        pos = eol + 1;
+
+        const std::wstring_view t = Trim(raw);
+        if (t.empty())
+        {
+            AddLine(cur, LineKind::Blank, {}, {});
+        }
+        else if (t[0] == L';' || t[0] == L'#')
+        {
+            AddLine(cur, LineKind::Comment, raw, {});
+        }
+        else if (t[0] == L'[')
+        {
+            size_t close = t.find(L']');
+            if (close == std::wstring_view::npos) close = t.size();
+            // A repeated header gets its own section: lookups still resolve
+            // to the first one, as with the profile API.
+            cur = (uint32_t)AddSection(Trim(t.substr(1, close - 1)), false);
+        }
+        else
+        {
+            const size_t eq = t.find(L'=');
+            const std::wstring_view key = (eq == std::wstring_view::npos) ? std::wstring_view{} : Trim(t.substr(0, eq));
+            if (key.empty())
+                AddLine(cur, LineKind::Other, raw, {});
+            else
+                AddLine(cur, LineKind::Key, key, Trim(t.substr(eq + 1)));
+        }
+    }
+}
+
+void IniDoc::ParseBytes(const void* data, size_t size)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    std::wstring text;
+
+    if (size >= 2 && p[0] == 0xFF && p[1] == 0xFE)
+    {
+        text.reserve(size / 2);
+        for (size_t i = 2; i + 1 < size; i += 2)
+        {
+            uint32_t u = (uint32_t)p[i] | ((uint32_t)p[i + 1] << 8);
+            if constexpr (sizeof(wchar_t) > 2)
+            {
+                if (u >= 0xD800 && u <= 0xDBFF && i + 3 < size)
+                {
+                    const uint32_t lo = (uint32_t)p[i + 2] | ((uint32_t)p[i + 3] << 8);
+                    if (lo >= 0xDC00 && lo <= 0xDFFF)
+                    {
+                        u = 0x10000 + ((u - 0xD800) << 10) + (lo - 0xDC00);
+                        i += 2;
+                    }
+                }
+            }
+            text.push_back((wchar_t)u);
+        }
+    }
+    else
+    {
+        size_t skip = (size >= 3 && p[0] == 0xEF && p[1] == 0xBB && p[2] == 0xBF) ? 3 : 0;
+        if (!DecodeUtf8(p + skip, size - skip, text))
+        {
+            text.assign(size, L'\0');
+            for (size_t i = 0; i < size; ++i) text[i] = (wchar_t)p[i];
+        }
+    }
+
+    Parse(text);
+}
+
+std::wstring IniDoc::Serialize() const
+{
+    std::wstring out;
+    out.reserve(m_text.size() + m_lines.size() * 3 + m_sections.size() * 4);
+
+    for (size_t s = 0; s < m_sections.size(); ++s)
+    {
+        const Section& sec = m_sections[s];
+        if (!sec.live) continue;
+        if (s > 0)
+        {
+            out += L'[';
+            out += View(sec.name);
+            out += L"]\r\n";
+        }
+        for (uint32_t li : sec.lines)
+        {
+            const Line& l = m_lines[li];
+            switch (l.kind)
+            {
+            case LineKind::Dead: continue;
+            case LineKind::Blank: break;
+            case LineKind::Key:
+                out += View(l.text);
+                out += L'=';
+                out += View(l.value);
+                break;
+            default:
+                out += View(l.text);
+                break;
+            }
+            out += L"\r\n";
+        }
+    }
+    return out;
+}
+
+std::vector<uint8_t> IniDoc::SerializeBytes() const
+{
+    const std::wstring text = Serialize();
+    std::vector<uint8_t> out;
+    out.reserve(2 + text.size() * 2);
+    out.push_back(0xFF);
+    out.push_back(0xFE);
+
+    auto put = [&](uint32_t u) {
+        out.push_back((uint8_t)(u & 0xFF));
+        out.push_back((uint8_t)(u >> 8));
+        };
+    for (wchar_t c : text)
+    {
+        const uint32_t cp = (uint32_t)c;
+        if (cp >= 0x10000)
+        {
+            put(0xD800 + ((cp - 0x10000) >> 10));
+            put(0xDC00 + ((cp - 0x10000) & 0x3FF));
+        }
+        else
+        {
+            put(cp);
+        }
+    }
+    return out;
+}
+
+namespace
+{
+    constexpr uint32_t kCompiledVersion = 1;
+
+    void PutRaw(std::vector<uint8_t>& out, const void* p, size_t n)
+    {
+        const uint8_t* b = (const uint8_t*)p;
+        out.insert(out.end(), b, b + n);
+    }
+
+    void PutU32(std::vector<uint8_t>& out, uint32_t v)
+    {
+        PutRaw(out, &v, sizeof(v));
+    }
+
+    struct Reader
+    {
+        const uint8_t* p;
+        size_t         left;
+
+        bool Raw(void* dst, size_t n)
+        {
+            if (n > left) return false;
+            if (n) memcpy(dst, p, n);
+            p += n;
+            left -= n;
+            return true;
+        }
+        bool U32(uint32_t& v) { return Raw(&v, sizeof(v)); }
+    };
+}
+
+void IniDoc::SaveCompiled(std::vector<uint8_t>& out) const
+{
+    out.clear();
+    PutU32(out, kCompiledVersion);
+    PutU32(out, (uint32_t)sizeof(wchar_t));
+    PutU32(out, (uint32_t)sizeof(Line));
+    PutU32(out, (uint32_t)m_text.size());
+    PutU32(out, (uint32_t)m_lines.size());
+    PutU32(out, (uint32_t)m_sections.size());
+    PutU32(out, (uint32_t)m_index.size());
+    PutU32(out, (uint32_t)m_indexUsed);
+    PutU32(out, (uint32_t)m_liveKeys);
+
+    PutRaw(out, m_text.data(), m_text.size() * sizeof(wchar_t));
+    PutRaw(out, m_lines.data(), m_lines.size() * sizeof(Line));
+    for (const Section& sec : m_sections)
+    {
+        PutRaw(out, &sec.name, sizeof(Span));
+        PutU32(out, sec.live ? 1u : 0u);
+        PutU32(out, (uint32_t)sec.lines.size());
+    }
+    for (const Section& sec : m_sections)
+        PutRaw(out, sec.lines.data(), sec.lines.size() * sizeof(uint32_t));
+    PutRaw(out, m_index.data(), m_index.size() * sizeof(uint32_t));
+}
+
+bool IniDoc::LoadCompiled(const void* data, size_t size)
+{
+    Clear();
+    Reader r{ (const uint8_t*)data, data ? size : 0 };
+
+    uint32_t version = 0, wcharSize = 0, lineSize = 0;
+    uint32_t textChars = 0, lineCount = 0, sectionCount = 0, slots = 0, used = 0, liveKeys = 0;
+    const bool headOk = r.U32(version) && r.U32(wcharSize) && r.U32(lineSize)
+        && r.U32(textChars) && r.U32(lineCount) && r.U32(sectionCount)
+        && r.U32(slots) && r.U32(used) && r.U32(liveKeys);
+    if (!headOk || version != kCompiledVersion || wcharSize != sizeof(wchar_t) || lineSize != sizeof(Line)
+        || sectionCount == 0 || (slots & (slots - 1)) != 0
+        || (size_t)textChars * sizeof(wchar_t) + (size_t)lineCount * sizeof(Line) > r.left)
+    {
+        Clear();
+        return false;
+    }
+
+    m_text.resize(textChars);
+    m_lines.resize(lineCount);
+    m_sections.resize(sectionCount);
+    bool ok = r.Raw(m_text.data(), (size_t)textChars * sizeof(wchar_t))
+        && r.Raw(m_lines.data(), (size_t)lineCount * sizeof(Line));
+
+    std::vector<uint32_t> counts(sectionCount);
+    for (uint32_t s = 0; ok && s < sectionCount; ++s)
+    {
+        uint32_t live = 0;
+        ok = r.Raw(&m_sections[s].name, sizeof(Span)) && r.U32(live) && r.U32(counts[s]) && counts[s] <= lineCount;
+        m_sections[s].live = (live != 0);
+    }
+    for (uint32_t s = 0; ok && s < sectionCount; ++s)
+    {
+        m_sections[s].lines.resize(counts[s]);
+        ok = r.Raw(m_sections[s].lines.data(), (size_t)counts[s] * sizeof(uint32_t));
+    }
+    if (ok)
+    {
+        m_index.resize(slots);
+        ok = r.Raw(m_index.data(), (size_t)slots * sizeof(uint32_t)) && r.left == 0;
+    }
+
+    // Cheap structural checks: a damaged blob must not index out of range
+    auto spanOk = [&](Span sp) { return (size_t)sp.off + sp.len <= m_text.size(); };
+    for (size_t i = 0; ok && i < m_lines.size(); ++i)
+    {
+        const Line& l = m_lines[i];
+        ok = (uint8_t)l.kind <= (uint8_t)LineKind::Other && l.section < sectionCount && spanOk(l.text) && spanOk(l.value);
+    }
+    for (size_t s = 0; ok && s < m_sections.size(); ++s)
+    {
+        ok = spanOk(m_sections[s].name);
+        for (uint32_t li : m_sections[s].lines) ok = ok && li < lineCount;
+    }
+    for (size_t i = 0; ok && i < m_index.size(); ++i)
+        ok = m_index[i] <= lineCount;
+
+    if (!ok)
+    {
+        Clear();
+        return false;
+    }
+    m_indexUsed = used;
+    m_liveKeys = liveKeys;
+    return true;
+}
+
+bool IniDoc::HasSection(std::wstring_view section) const
+{
+    return FindSection(section) >= 0;
+}
+
+bool IniDoc::Has(std::wstring_view section, std::wstring_view key) const
+{
+    const int s = FindSection(section);
+    return s >= 0 && FindKey((uint32_t)s, key) >= 0;
+}
+
+bool IniDoc::TryGet(std::wstring_view section, std::wstring_view key, std::wstring_view& out) const
+{
+    const int s = FindSection(section);
+    if (s < 0) return false;
+    const int k = FindKey((uint32_t)s, key);
+    if (k < 0) return false;
+
+    out = View(m_lines[(size_t)k].value);
+    if (out.size() >= 2 && (out[0] == L'"' || out[0] == L'\'') && out.back() == out[0])
+        out = out.substr(1, out.size() - 2);
+    return true;
+}
+
+std::wstring IniDoc::GetString(std::wstring_view section, std::wstring_view key, std::wstring_view def) const
+{
+    std::wstring_view v;
+    return std::wstring(TryGet(section, key, v) ? v : def);
+}
+
+int IniDoc::GetInt(std::wstring_view section, std::wstring_view key, int def) const
+{
+    std::wstring_view v;
+    if (!TryGet(section, key, v)) return def;
+
+    size_t i = 0;
+    while (i < v.size() && IsSpace(v[i])) ++i;
+    bool neg = false;
+    if (i < v.size() && (v[i] == L'-' || v[i] == L'+')) neg = (v[i++] == L'-');
+
+    int base = 10;
+    if (i + 1 < v.size() && v[i] == L'0' && (v[i + 1] == L'x' || v[i + 1] == L'X')) { base = 16; i += 2; }
+
+    long long n = 0;
+    for (; i < v.size(); ++i)
+    {
+        const wchar_t c = v[i];
+        int d;
+        if (c >= L'0' && c <= L'9') d = c - L'0';
+        else if (base == 16 && FoldAscii(c) >= L'a' && FoldAscii(c) <= L'f') d = FoldAscii(c) - L'a' + 10;
+        else break;
+        n = std::min<long long>(n * base + d, (long long)UINT_MAX);
+    }
+    // Out of int range wraps like the profile API's UINT result.
+    return (int)(neg ? -n : n);
+}
+
+void IniDoc::Keys(std::wstring_view section, std::vector<std::wstring_view>& out) const
+{
+    out.clear();
+    const int s = FindSection(section);
+    if (s < 0) return;
+    for (uint32_t li : m_sections[(size_t)s].lines)
+        if (m_lines[li].kind == LineKind::Key)
+            out.push_back(View(m_lines[li].text));
+}
+
+void IniDoc::Set(std::wstring_view section, std::wstring_view key, std::wstring_view value)
+{
+    if (m_sections.empty()) Clear();
+    key = Trim(key);
+    if (key.empty()) return;
+
+    int s = FindSection(section);
+    if (s < 0) s = AddSection(Trim(section), true);
+
+    const int k = FindKey((uint32_t)s, key);
+    if (k >= 0)
+    {
+        Line& l = m_lines[(size_t)k];
+        if (value.size() <= l.value.len)
+        {
+            // Same or shorter: rewrite in place, the arena does not grow
+            std::copy(value.begin(), value.end(), m_text.begin() + l.value.off);
+            l.value.len = (uint32_t)value.size();
+        }
+        else
+        {
+            l.value = Store(value);
+        }
+        return;
+    }
+
+    AddLine((uint32_t)s, LineKind::Key, key, value);
+
+    // Keep the blank lines that end the section after the new key
+    std::vector<uint32_t>& lines = m_sections[(size_t)s].lines;
+    size_t at = lines.size() - 1;
+    while (at > 0 && (m_lines[lines[at - 1]].kind == LineKind::Blank || m_lines[lines[at - 1]].kind == LineKind::Dead))
+        --at;
+    if (at != lines.size() - 1)
+    {
+        const uint32_t li = lines.back();
+        lines.pop_back();
+        lines.insert(lines.begin() + (ptrdiff_t)at, li);
+    }
+}
+
+void IniDoc::SetInt(std::wstring_view section, std::wstring_view key, int v)
+{
+    Set(section, key, std::to_wstring(v));
+}
+
+void IniDoc::SetUInt(std::wstring_view section, std::wstring_view key, uint32_t v)
+{
+    Set(section, key, std::to_wstring(v));
+}
+
+void IniDoc::Erase(std::wstring_view section, std::wstring_view key)
+{
+    const int s = FindSection(section);
+    if (s < 0) return;
+    const int k = FindKey((uint32_t)s, key);
+    if (k < 0) return;
+    m_lines[(size_t)k].kind = LineKind::Dead;   // stays in the index as a tombstone
+    --m_liveKeys;
+}
+
+void IniDoc::EraseSection(std::wstring_view section)
+{
+    for (size_t s = 1; s < m_sections.size(); ++s)
+    {
+        Section& sec = m_sections[s];
+        if (!sec.live || !EqualNoCase(View(sec.name), section)) continue;
+        sec.live = false;
+        for (uint32_t li : sec.lines)
+        {
+            if (m_lines[li].kind == LineKind::Key) --m_liveKeys;
+            m_lines[li].kind = LineKind::Dead;
+        }
+    }
+    m_lastSection = -1;
+}
+
+IniDoc::Span IniDoc::Store(std::wstring_view s)
+{
+    Span sp{ (uint32_t)m_text.size(), (uint32_t)s.size() };
+    m_text.append(s.data(), s.size());
+    return sp;
+}
+
+int IniDoc::FindSection(std::wstring_view name) const
+{
+    if (m_lastSection > 0 && m_lastSection < (int)m_sections.size())
+    {
+        const Section& c = m_sections[(size_t)m_lastSection];
+        if (c.live && EqualNoCase(View(c.name), name)) return m_lastSection;
+    }
+    for (size_t s = 1; s < m_sections.size(); ++s)
+    {
+        const Section& sec = m_sections[s];
+        if (sec.live && EqualNoCase(View(sec.name), name))
+        {
+            m_lastSection = (int)s;
+            return (int)s;
+        }
+    }
+    return -1;
+}
+
+int IniDoc::AddSection(std::wstring_view name, bool separate)
+{
+    if (m_sections.empty()) Clear();
+
+    // One blank line between the previous section and a new one
+    for (size_t s = m_sections.size(); separate && s-- > 0;)
+    {
+        const Section& prev = m_sections[s];
+        if (!prev.live) continue;
+        auto it = std::find_if(prev.lines.rbegin(), prev.lines.rend(),
+            [&](uint32_t li) { return m_lines[li].kind != LineKind::Dead; });
+        const bool hasHeader = s > 0;
+        if (it != prev.lines.rend() ? m_lines[*it].kind != LineKind::Blank : hasHeader)
+            AddLine((uint32_t)s, LineKind::Blank, {}, {});
+        break;
+    }
+
+    Section sec;
+    sec.name = Store(name);
+    m_sections.push_back(std::move(sec));
+    return (int)m_sections.size() - 1;
+}
+
+int IniDoc::FindKey(uint32_t section, std::wstring_view key) const
+{
+    if (m_index.empty()) return -1;
+    const size_t mask = m_index.size() - 1;
+    for (size_t i = HashKey(section, key) & mask;; i = (i + 1) & mask)
+    {
+        const uint32_t e = m_index[i];
+        if (e == 0) return -1;
+        const Line& l = m_lines[e - 1];
+        if (l.kind == LineKind::Key && l.section == section && EqualNoCase(View(l.text), key))
+            return (int)(e - 1);
+    }
+}
+
+void IniDoc::IndexKey(uint32_t lineIdx)
+{
+    if ((m_indexUsed + 1) * 2 > m_index.size())
+        Rehash(std::max<size_t>(64, m_index.size() * 2));
+
+    const Line& l = m_lines[lineIdx];
+    const size_t mask = m_index.size() - 1;
+    size_t i = HashKey(l.section, View(l.text)) & mask;
+    while (m_index[i] != 0) i = (i + 1) & mask;
+    m_index[i] = lineIdx + 1;
+    ++m_indexUsed;
+}
+
+void IniDoc::Rehash(size_t slots)
+{
+    // Live keys only: drops the tombstones. Line order = first occurrence first.
+    size_t live = 0;
+    for (const Line& l : m_lines) live += (l.kind == LineKind::Key);
+    while (slots < (live + 1) * 2) slots *= 2;
+
+    m_index.assign(slots, 0);
+    m_indexUsed = 0;
+    const size_t mask = slots - 1;
+    for (uint32_t li = 0; li < (uint32_t)m_lines.size(); ++li)
+    {
+        const Line& l = m_lines[li];
+        if (l.kind != LineKind::Key) continue;
+        size_t i = HashKey(l.section, View(l.text)) & mask;
+        while (m_index[i] != 0) i = (i + 1) & mask;
+        m_index[i] = li + 1;
+        ++m_indexUsed;
+    }
+}
+
+void IniDoc::AddLine(uint32_t section, LineKind kind, std::wstring_view text, std::wstring_view value)
+{
+    Line l;
+    l.kind = kind;
+    l.section = section;
+    l.text = Store(text);
+    if (kind == LineKind::Key) l.value = Store(value);
+
+    const uint32_t idx = (uint32_t)m_lines.size();
+    m_lines.push_back(l);
+    m_sections[section].lines.push_back(idx);
+
+    if (kind == LineKind::Key)
+    {
+        ++m_liveKeys;
+        // A duplicate key is kept in the file but never found (first wins)
+        if (FindKey(section, text) < 0)
+            IndexKey(idx);
+    }
+}
+
+uint32_t IniDoc::HashKey(uint32_t section, std::wstring_view key)
+{
+    uint32_t h = 2166136261u ^ (section * 0x9E3779B9u);
+    for (wchar_t c : key)
+    {
+        h ^= (uint32_t)FoldAscii(c);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+bool IniDoc::EqualNoCase(std::wstring_view a, std::wstring_view b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (FoldAscii(a[i]) != FoldAscii(b[i])) return false;
+    return true;
+}
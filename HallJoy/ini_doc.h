@@ -0,0 +1,107 @@
+// ini_doc.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ============================================================
+// INI DOCUMENT
+// A whole INI file in memory: parsed once, queried and edited in place,
+// serialized in one buffer. Replaces the GetPrivateProfile* /
+// WritePrivateProfile* calls, each of which re-opens, re-parses and (for
+// writes) re-writes the file.
+// - Flat storage: every name / value / raw line lives in one text arena,
+//   lines are small records pointing into it, each section keeps the list
+//   of its lines in file order.
+// - Comments (';' / '#'), blank lines, unknown sections and key order
+//   survive a load / edit / save round trip. New keys go to the end of
+//   their section, new sections to the end of the file.
+// - Same lookup rules as the profile API: section and key names are case
+//   insensitive (ASCII), surrounding whitespace is trimmed, the first
+//   occurrence of a duplicate wins, a value in matching quotes is unquoted.
+// - Key lookup is a hash probe, no scan.
+// Not thread-safe. Portable (no Win32); file I/O is in ini_util.h.
+// ============================================================
+
+class IniDoc
+{
+public:
+    void Clear();
+
+    void Parse(std::wstring_view text);
+    // File bytes: UTF-16LE with BOM, UTF-8 (BOM optional) or ANSI (as Latin-1).
+    void ParseBytes(const void* data, size_t size);
+
+    // CRLF text.
+    std::wstring Serialize() const;
+    // UTF-16LE with BOM, the format the profile API also reads.
+    std::vector<uint8_t> SerializeBytes() const;
+
+    bool HasSection(std::wstring_view section) const;
+    bool Has(std::wstring_view section, std::wstring_view key) const;
+
+    // Views into the document: valid until the next change.
+    bool TryGet(std::wstring_view section, std::wstring_view key, std::wstring_view& out) const;
+    std::wstring GetString(std::wstring_view section, std::wstring_view key, std::wstring_view def = {}) const;
+    // Like GetPrivateProfileInt: def if the key is missing, leading number otherwise.
+    int GetInt(std::wstring_view section, std::wstring_view key, int def) const;
+    // Key names of a section in file order.
+    void Keys(std::wstring_view section, std::vector<std::wstring_view>& out) const;
+
+    void Set(std::wstring_view section, std::wstring_view key, std::wstring_view value);
+    void SetInt(std::wstring_view section, std::wstring_view key, int v);
+    void SetUInt(std::wstring_view section, std::wstring_view key, uint32_t v);
+    void Erase(std::wstring_view section, std::wstring_view key);
+    void EraseSection(std::wstring_view section);
+
+    size_t KeyCount() const { return m_liveKeys; }
+
+    // Compiled form (profile cache): the parsed document as flat arrays, hash
+    // index included. Loading it back is a few copies, no decoding, parsing
+    // or hashing. Only valid for the build that wrote it (false otherwise).
+    void SaveCompiled(std::vector<uint8_t>& out) const;
+    bool LoadCompiled(const void* data, size_t size);
+
+private:
+    struct Span { uint32_t off = 0; uint32_t len = 0; };
+
+    enum class LineKind : uint8_t { Dead, Blank, Comment, Key, Other };
+
+    struct Line
+    {
+        LineKind kind = LineKind::Dead;
+        uint32_t section = 0;
+        Span     text;     // Key: name, others: raw line
+        Span     value;    // Key only
+    };
+
+    struct Section
+    {
+        Span                  name;       // section 0: the lines before the first header
+        bool                  live = true;
+        std::vector<uint32_t> lines;
+    };
+
+    Span Store(std::wstring_view s);
+    std::wstring_view View(Span s) const { return std::wstring_view(m_text).substr(s.off, s.len); }
+
+    int FindSection(std::wstring_view name) const;
+    int AddSection(std::wstring_view name, bool separate);
+    int FindKey(uint32_t section, std::wstring_view key) const;
+    void IndexKey(uint32_t lineIdx);
+    void Rehash(size_t slots);
+    void AddLine(uint32_t section, LineKind kind, std::wstring_view text, std::wstring_view value);
+
+    static uint32_t HashKey(uint32_t section, std::wstring_view key);
+    static bool EqualNoCase(std::wstring_view a, std::wstring_view b);
+
+    std::wstring          m_text;      // arena
+    std::vector<Line>     m_lines;
+    std::vector<Section>  m_sections;
+    std::vector<uint32_t> m_index;     // open addressing, line index + 1 (0 = empty)
+    size_t                m_indexUsed = 0;
+    size_t                m_liveKeys = 0;
+    mutable int           m_lastSection = -1;
+};
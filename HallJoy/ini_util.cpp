@@ -1,7 +1,10 @@
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 
+#include <vector>
+
 #include "ini_util.h"
+#include "ini_doc.h"
 
 void IniUtil_Flush(const wchar_t* path)
 {
@@ -22,4 +25,57 @@ bool IniUtil_AtomicReplace(const wchar_t* tmpPath, const wchar_t* dstPath)
         return false;
     }
     return true;
-}
\ No newline at end of file
+}
+
+bool IniUtil_LoadDoc(const wchar_t* path, IniDoc& doc)
+{
+    doc.Clear();
+    if (!path) return false;
+
+    HANDLE h = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size{};
+    bool ok = GetFileSizeEx(h, &size) && size.QuadPart < (64LL << 20); // 64 MB safety cap
+    std::vector<uint8_t> buf;
+    if (ok)
+    {
+        buf.resize((size_t)size.QuadPart);
+        DWORD got = 0;
+        ok = buf.empty() || (ReadFile(h, buf.data(), (DWORD)buf.size(), &got, nullptr) && got == (DWORD)buf.size());
+    }
+    CloseHandle(h);
+    if (!ok) return false;
+
+    doc.ParseBytes(buf.data(), buf.size());
+    return true;
+}
+
+bool IniUtil_WriteFileAtomic(const wchar_t* path, const void* data, size_t size)
+{
+    if (!path) return false;
+
+    std::wstring tmp = std::wstring(path) + L".tmp";
+
+    HANDLE h = CreateFileW(tmp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+
+    DWORD written = 0;
+    bool ok = size == 0 || (WriteFile(h, data, (DWORD)size, &written, nullptr) && written == (DWORD)size);
+    ok = FlushFileBuffers(h) && ok;
+    CloseHandle(h);
+
+    if (!ok)
+    {
+        DeleteFileW(tmp.c_str());
+        return false;
+    }
+    return IniUtil_AtomicReplace(tmp.c_str(), path);
+}
+
+bool IniUtil_SaveDoc(const IniDoc& doc, const wchar_t* path)
+{
+    const std::vector<uint8_t> bytes = doc.SerializeBytes();
+    return IniUtil_WriteFileAtomic(path, bytes.data(), bytes.size());
+}
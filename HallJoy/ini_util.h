@@ -4,6 +4,8 @@
 
 #include <string>
 
+class IniDoc;
+
 // Forces WritePrivateProfile* buffers to be flushed to disk for this INI file.
 void IniUtil_Flush(const wchar_t* path);
 
@@ -11,4 +13,13 @@ void IniUtil_Flush(const wchar_t* path);
 // - Flushes tmp
 // - MoveFileEx(REPLACE_EXISTING | WRITE_THROUGH)
 // - Deletes tmp on failure
-bool IniUtil_AtomicReplace(const wchar_t* tmpPath, const wchar_t* dstPath);
\ No newline at end of file
+bool IniUtil_AtomicReplace(const wchar_t* tmpPath, const wchar_t* dstPath);
+
+// Reads and parses the whole file in one go. False (doc cleared) if it cannot be read.
+bool IniUtil_LoadDoc(const wchar_t* path, IniDoc& doc);
+
+// One write to "<path>.tmp", FlushFileBuffers, then IniUtil_AtomicReplace.
+bool IniUtil_WriteFileAtomic(const wchar_t* path, const void* data, size_t size);
+
+// Serializes the document and writes it with IniUtil_WriteFileAtomic.
+bool IniUtil_SaveDoc(const IniDoc& doc, const wchar_t* path);
@@ -0,0 +1,180 @@
+// input_bus.cpp
+#include "input_bus.h"
+
+#include <array>
+#include <atomic>
+
+static_assert((INPUT_BUS_CAPACITY & (INPUT_BUS_CAPACITY - 1)) == 0, "INPUT_BUS_CAPACITY must be a power of two");
+
+// Each slot is a tiny seqlock made only of atomics (no torn reads, no UB):
+// seq = 0 while the producer rewrites it, then the event sequence number.
+// The event itself is packed in two 64-bit words.
+struct BusSlot
+{
+    std::atomic<uint64_t> seq{ 0 };
+    std::atomic<uint64_t> timeUs{ 0 };
+    std::atomic<uint64_t> payload{ 0 };
+};
+
+static std::array<BusSlot, INPUT_BUS_CAPACITY> g_slots;
+static std::atomic<uint64_t> g_head{ 0 }; // last published sequence
+
+// Canonical held state (VK 0..255 + mouse buttons)
+static std::array<std::atomic<uint64_t>, 4> g_keyHeld{};
+static std::atomic<uint8_t> g_mouseHeld{ 0 };
+
+static uint64_t Pack(const InputEvent& ev)
+{
+    return (uint64_t)(uint8_t)ev.type
+        | ((uint64_t)ev.flags << 8)
+        | ((uint64_t)ev.code << 16)
+        | ((uint64_t)ev.hid << 32)
+        | ((uint64_t)(uint16_t)ev.wheelDelta << 48);
+}
+
+static void Unpack(uint64_t p, InputEvent* ev)
+{
+    ev->type = (InputEventType)(uint8_t)(p & 0xFFu);
+    ev->flags = (uint8_t)((p >> 8) & 0xFFu);
+    ev->code = (uint16_t)((p >> 16) & 0xFFFFu);
+    ev->hid = (uint16_t)((p >> 32) & 0xFFFFu);
+    ev->wheelDelta = (int16_t)(uint16_t)((p >> 48) & 0xFFFFu);
+}
+
+static bool KeyHeldBit(uint16_t vk)
+{
+    if (vk >= 256) return false;
+    return (g_keyHeld[vk >> 6].load(std::memory_order_acquire) & (1ULL << (vk & 63))) != 0;
+}
+
+// Producer-only writer: plain load/store is enough (consumers only read).
+static void SetKeyHeldBit(uint16_t vk, bool held)
+{
+    if (vk >= 256) return;
+    auto& w = g_keyHeld[vk >> 6];
+    const uint64_t bit = 1ULL << (vk & 63);
+    const uint64_t cur = w.load(std::memory_order_relaxed);
+    w.store(held ? (cur | bit) : (cur & ~bit), std::memory_order_release);
+}
+
+uint64_t InputBus_Publish(const InputEvent& evIn)
+{
+    InputEvent ev = evIn;
+
+    // 1) Canonical state first, so a consumer reading the event already sees it applied.
+    switch (ev.type)
+    {
+    case InputEventType::KeyDown:
+        if (KeyHeldBit(ev.code)) ev.flags |= InputEventFlag_Repeat;
+        else SetKeyHeldBit(ev.code, true);
+        break;
+    case InputEventType::KeyUp:
+        SetKeyHeldBit(ev.code, false);
+        break;
+    case InputEventType::MouseDown:
+        if (ev.code < 8) g_mouseHeld.fetch_or((uint8_t)(1u << ev.code), std::memory_order_acq_rel);
+        break;
+    case InputEventType::MouseUp:
+        if (ev.code < 8) g_mouseHeld.fetch_and((uint8_t)~(1u << ev.code), std::memory_order_acq_rel);
+        break;
+    default:
+        break;
+    }
+
+    // 2) Slot write (seqlock)
+    const uint64_t s = g_head.load(std::memory_order_relaxed) + 1;
+    BusSlot& slot = g_slots[(size_t)(s & (INPUT_BUS_CAPACITY - 1))];
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.timeUs.store(ev.timeUs, std::memory_order_relaxed);
+    slot.payload.store(Pack(ev), std::memory_order_relaxed);
+    slot.seq.store(s, std::memory_order_release);
+
+    g_head.store(s, std::memory_order_release);
+    return s;
+}
+
+void InputBus_Subscribe(InputBusReader* r)
+{
+    if (!r) return;
+    r->next = g_head.load(std::memory_order_acquire) + 1;
+    r->overruns = 0;
+}
+
+bool InputBus_Poll(InputBusReader* r, InputEvent* out)
+{
+    if (!r || !out) return false;
+
+    for (;;)
+    {
+        const uint64_t head = g_head.load(std::memory_order_acquire);
+        if (r->next > head) return false;
+
+        // Lapped: oldest still-valid sequence is head - capacity + 1
+        if (head - r->next >= INPUT_BUS_CAPACITY)
+        {
+            const uint64_t oldest = head - INPUT_BUS_CAPACITY + 1;
+            r->overruns += oldest - r->next;
+            r->next = oldest;
+        }
+
+        const BusSlot& slot = g_slots[(size_t)(r->next & (INPUT_BUS_CAPACITY - 1))];
+        const uint64_t s1 = slot.seq.load(std::memory_order_acquire);
+        const uint64_t t = slot.timeUs.load(std::memory_order_relaxed);
+        const uint64_t p = slot.payload.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t s2 = slot.seq.load(std::memory_order_relaxed);
+
+        if (s1 != r->next || s2 != s1)
+        {
+            // Producer is rewriting / has rewritten this slot for a newer lap: event lost.
+            ++r->overruns;
+            ++r->next;
+            continue;
+        }
+
+        out->seq = s1;
+        out->timeUs = t;
+        Unpack(p, out);
+        ++r->next;
+        return true;
+    }
+}
+
+uint64_t InputBus_GetHeadSeq()
+{
+    return g_head.load(std::memory_order_acquire);
+}
+
+bool InputBus_IsKeyHeld(uint16_t vk)
+{
+    return KeyHeldBit(vk);
+}
+
+bool InputBus_IsMouseHeld(InputMouseButton b)
+{
+    return (g_mouseHeld.load(std::memory_order_acquire) & (1u << (unsigned)b)) != 0;
+}
+
+uint8_t InputBus_GetMouseHeldMask()
+{
+    return g_mouseHeld.load(std::memory_order_acquire);
+}
+
+void InputBus_GetKeyHeldBits(uint64_t out[4])
+{
+    if (!out) return;
+    for (int i = 0; i < 4; ++i)
+        out[i] = g_keyHeld[(size_t)i].load(std::memory_order_acquire);
+}
+
+void InputBus_ResetHeld()
+{
+    for (auto& w : g_keyHeld) w.store(0, std::memory_order_release);
+    g_mouseHeld.store(0, std::memory_order_release);
+}
+
+uint64_t InputBus_GetPublishedCount()
+{
+    return g_head.load(std::memory_order_relaxed);
+}
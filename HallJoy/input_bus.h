@@ -0,0 +1,85 @@
+// input_bus.h
+#pragma once
+#include <cstdint>
+
+// ============================================================
+// INPUT BUS
+// Single typed, timestamped stream of keyboard/mouse events with one
+// canonical held-key/button state. Published by the input thread only
+// (single producer); any number of consumers read it at their own pace
+// through an InputBusReader (broadcast ring + sequence numbers).
+// A consumer that falls more than INPUT_BUS_CAPACITY events behind is
+// moved forward and the skipped events are counted in reader.overruns.
+// Portable: no Win32 dependency.
+// ============================================================
+
+enum class InputEventType : uint8_t
+{
+    None = 0,
+    KeyDown,
+    KeyUp,
+    MouseDown,
+    MouseUp,
+    Wheel,      // vertical, wheelDelta > 0 = up
+    HWheel,     // horizontal
+};
+
+// Bit index matches the live mouse view / GetInjectedMouseState() (0=L,1=R,2=M,3=X1,4=X2)
+enum class InputMouseButton : uint8_t
+{
+    Left = 0,
+    Right,
+    Middle,
+    X1,
+    X2,
+};
+
+enum InputEventFlags : uint8_t
+{
+    InputEventFlag_None = 0,
+    InputEventFlag_Repeat = 1u << 0,   // KeyDown while already held (OS auto-repeat), set by the bus
+    InputEventFlag_Injected = 1u << 1, // synthetic (SendInput, our marker or another tool)
+    InputEventFlag_Blocked = 1u << 2,  // the hook did not let it reach the foreground app
+};
+
+struct InputEvent
+{
+    uint64_t seq = 0;       // assigned by InputBus_Publish (first event = 1)
+    uint64_t timeUs = 0;    // producer timestamp, monotonic microseconds
+    InputEventType type = InputEventType::None;
+    uint8_t flags = InputEventFlag_None;
+    uint16_t code = 0;      // Key*: VK code, Mouse*: InputMouseButton
+    uint16_t hid = 0;       // Key*: HID usage, 0 if unknown
+    int16_t wheelDelta = 0; // Wheel / HWheel
+};
+
+constexpr uint32_t INPUT_BUS_CAPACITY = 4096; // power of two
+
+struct InputBusReader
+{
+    uint64_t next = 1;      // next sequence to read
+    uint64_t overruns = 0;  // events lost because this reader was lapped
+};
+
+// ---- Producer (input thread only) ----
+// Updates the canonical held state, then makes the event visible. Returns its sequence.
+uint64_t InputBus_Publish(const InputEvent& ev);
+
+// ---- Consumers ----
+// Start reading from the next published event (history is skipped).
+void InputBus_Subscribe(InputBusReader* r);
+// false => nothing new. Never blocks, safe from any thread.
+bool InputBus_Poll(InputBusReader* r, InputEvent* out);
+// Sequence of the last published event (0 = none yet).
+uint64_t InputBus_GetHeadSeq();
+
+// ---- Canonical held state ----
+bool InputBus_IsKeyHeld(uint16_t vk);
+bool InputBus_IsMouseHeld(InputMouseButton b);
+uint8_t InputBus_GetMouseHeldMask();    // bit = InputMouseButton
+void InputBus_GetKeyHeldBits(uint64_t out[4]);
+// Stuck-key recovery (device reconnect): forget every held key/button.
+void InputBus_ResetHeld();
+
+// ---- Stats ----
+uint64_t InputBus_GetPublishedCount();
@@ -0,0 +1,361 @@
+// input_thread.cpp
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <cwchar>
+#include <cstdio>
+
+#include "input_thread.h"
+#include "spsc_ring.h"
+#include "input_bus.h"
+#include "free_combo_system.h"
+#include "logger.h"
+
+#pragma comment(lib, "Advapi32.lib")
+
+extern std::atomic<unsigned long long> s_ignoreKeyEventsUntilMs; // app.cpp
+
+// 1024 events ~= several seconds of fast typing + mouse buttons.
+// Mouse moves are never queued (hook filters them).
+static SpscRing<RawInputEvent, 1024> g_ring;
+
+static HANDLE g_thread = nullptr;
+static HANDLE g_wakeEvent = nullptr;
+static std::atomic<bool> g_run{ false };
+static std::atomic<bool> g_consumerSleeping{ false };
+static std::atomic<bool> g_pumpRequested{ false };
+
+static const LONGLONG g_qpcFreq = []() {
+    LARGE_INTEGER f{};
+    QueryPerformanceFrequency(&f);
+    return f.QuadPart > 0 ? f.QuadPart : 1;
+}();
+
+// ---- Histograms ----
+// Written by the hook thread only (relaxed), read by UI.
+static const uint32_t kBucketUpperUs[INPUT_HOOK_HIST_BUCKETS] = {
+    5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, UINT32_MAX
+};
+
+struct HookStatsAtomic
+{
+    std::atomic<uint64_t> calls{ 0 };
+    std::atomic<uint64_t> dropped{ 0 };
+    std::atomic<uint32_t> maxUs{ 0 };
+    std::atomic<uint32_t> buckets[INPUT_HOOK_HIST_BUCKETS]{};
+    std::atomic<uint32_t> maxQueueLagUs{ 0 };
+};
+
+static HookStatsAtomic g_hookStats[2];
+
+static HookStatsAtomic& StatsFor(InputHookId hook)
+{
+    return g_hookStats[(hook == InputHookId::Mouse) ? 1 : 0];
+}
+
+static uint32_t QpcToUs(uint64_t ticks)
+{
+    uint64_t us = (ticks * 1000000ull) / (uint64_t)g_qpcFreq;
+    return (us > 0xFFFFFFFFull) ? 0xFFFFFFFFu : (uint32_t)us;
+}
+
+static void AtomicMaxU32(std::atomic<uint32_t>& a, uint32_t v)
+{
+    uint32_t cur = a.load(std::memory_order_relaxed);
+    while (v > cur && !a.compare_exchange_weak(cur, v, std::memory_order_relaxed, std::memory_order_relaxed)) {}
+}
+
+uint64_t InputThread_Now()
+{
+    LARGE_INTEGER c{};
+    QueryPerformanceCounter(&c);
+    return (uint64_t)c.QuadPart;
+}
+
+void InputThread_RecordHookTime(InputHookId hook, uint64_t qpcStart)
+{
+    const uint32_t us = QpcToUs(InputThread_Now() - qpcStart);
+    HookStatsAtomic& s = StatsFor(hook);
+    s.calls.fetch_add(1, std::memory_order_relaxed);
+    AtomicMaxU32(s.maxUs, us);
+
+    int b = 0;
+    while (b < INPUT_HOOK_HIST_BUCKETS - 1 && us > kBucketUpperUs[b]) ++b;
+    s.buckets[b].fetch_add(1, std::memory_order_relaxed);
+}
+
+void InputThread_GetHookStats(InputHookId hook, InputHookStats* out)
+{
+    if (!out) return;
+    const HookStatsAtomic& s = StatsFor(hook);
+    out->calls = s.calls.load(std::memory_order_relaxed);
+    out->dropped = s.dropped.load(std::memory_order_relaxed);
+    out->maxUs = s.maxUs.load(std::memory_order_relaxed);
+    for (int i = 0; i < INPUT_HOOK_HIST_BUCKETS; ++i)
+        out->buckets[i] = s.buckets[i].load(std::memory_order_relaxed);
+    out->maxQueueLagUs = s.maxQueueLagUs.load(std::memory_order_relaxed);
+    out->timeoutMs = InputThread_GetLowLevelHooksTimeoutMs();
+}
+
+void InputThread_ResetHookStats()
+{
+    for (auto& s : g_hookStats)
+    {
+        s.calls.store(0, std::memory_order_relaxed);
+        s.dropped.store(0, std::memory_order_relaxed);
+        s.maxUs.store(0, std::memory_order_relaxed);
+        for (auto& b : s.buckets) b.store(0, std::memory_order_relaxed);
+        s.maxQueueLagUs.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint32_t InputThread_GetHookBucketUpperUs(int bucket)
+{
+    if (bucket < 0 || bucket >= INPUT_HOOK_HIST_BUCKETS) return 0;
+    return kBucketUpperUs[bucket];
+}
+
+uint32_t InputThread_GetLowLevelHooksTimeoutMs()
+{
+    static std::atomic<uint32_t> s_cached{ 0 };
+    uint32_t v = s_cached.load(std::memory_order_relaxed);
+    if (v) return v;
+
+    // Value may be REG_DWORD or REG_SZ depending on who wrote it.
+    // Not present => Windows default (300 ms on current versions).
+    v = 300;
+    DWORD dw = 0, cb = sizeof(dw);
+    if (RegGetValueW(HKEY_CURRENT_USER, L"Control Panel\\Desktop", L"LowLevelHooksTimeout",
+        RRF_RT_REG_DWORD, nullptr, &dw, &cb) == ERROR_SUCCESS && dw > 0)
+    {
+        v = dw;
+    }
+    else
+    {
+        wchar_t buf[32]{};
+        DWORD cbs = sizeof(buf);
+        if (RegGetValueW(HKEY_CURRENT_USER, L"Control Panel\\Desktop", L"LowLevelHooksTimeout",
+            RRF_RT_REG_SZ, nullptr, buf, &cbs) == ERROR_SUCCESS)
+        {
+            unsigned long n = wcstoul(buf, nullptr, 10);
+            if (n > 0) v = (uint32_t)n;
+        }
+    }
+    s_cached.store(v, std::memory_order_relaxed);
+    return v;
+}
+
+void InputThread_LogHookStats()
+{
+    if (!Logger::IsEnabled()) return;
+    static const char* kNames[2] = { "kbd", "mouse" };
+    std::string line;
+    for (int h = 0; h < 2; ++h)
+    {
+        InputHookStats st;
+        InputThread_GetHookStats((InputHookId)h, &st);
+        char buf[256];
+        snprintf(buf, sizeof(buf), "%s calls=%llu max=%uus lag=%uus drop=%llu [",
+            kNames[h], (unsigned long long)st.calls, st.maxUs, st.maxQueueLagUs, (unsigned long long)st.dropped);
+        line += buf;
+        for (int i = 0; i < INPUT_HOOK_HIST_BUCKETS; ++i)
+        {
+            snprintf(buf, sizeof(buf), (i + 1 < INPUT_HOOK_HIST_BUCKETS) ? "%u " : "%u] ", st.buckets[i]);
+            line += buf;
+        }
+    }
+    line += "timeout=" + std::to_string(InputThread_GetLowLevelHooksTimeoutMs()) + "ms";
+    Logger::Info("HOOKS", line);
+}
+
+// ---- Producer ----
+bool InputThread_Push(const RawInputEvent& ev)
+{
+    if (!g_ring.TryPush(ev))
+    {
+        StatsFor(ev.kind == RawInputKind::Mouse ? InputHookId::Mouse : InputHookId::Keyboard)
+            .dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    // Pair with the consumer's fence: either it sees the new head, or we see it sleeping.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (g_consumerSleeping.load(std::memory_order_relaxed) && g_wakeEvent)
+        SetEvent(g_wakeEvent);
+    return true;
+}
+
+void InputThread_RequestPump()
+{
+    g_pumpRequested.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (g_consumerSleeping.load(std::memory_order_relaxed) && g_wakeEvent)
+        SetEvent(g_wakeEvent);
+}
+
+// ---- Consumer ----
+static void ReinjectTap(const RawInputEvent& ev)
+{
+    // Auto-repeat of a key that is blocked for the game: send a marked tap so
+    // the focused app still gets its repeat, exactly like the old inline hook path.
+    INPUT inputs[2] = {};
+    inputs[0].type = INPUT_KEYBOARD;
+    inputs[0].ki.wVk = (WORD)ev.vkCode;
+    inputs[0].ki.dwFlags = 0;
+    inputs[0].ki.dwExtraInfo = (ULONG_PTR)0x484A4D43ULL;
+    inputs[1] = inputs[0];
+    inputs[1].ki.dwFlags = KEYEVENTF_KEYUP;
+    s_ignoreKeyEventsUntilMs.store(GetTickCount64() + 200ULL, std::memory_order_release);
+    SendInput(2, inputs, sizeof(INPUT));
+}
+
+static uint64_t QpcToBusUs(uint64_t qpc)
+{
+    // Split to avoid overflowing qpc * 1e6 after a few days of uptime.
+    const uint64_t f = (uint64_t)g_qpcFreq;
+    return (qpc / f) * 1000000ull + ((qpc % f) * 1000000ull) / f;
+}
+
+static bool TranslateMouse(const RawInputEvent& raw, InputEvent& out)
+{
+    switch (raw.msg)
+    {
+    case WM_LBUTTONDOWN: out.type = InputEventType::MouseDown; out.code = (uint16_t)InputMouseButton::Left; return true;
+    case WM_LBUTTONUP:   out.type = InputEventType::MouseUp;   out.code = (uint16_t)InputMouseButton::Left; return true;
+    case WM_RBUTTONDOWN: out.type = InputEventType::MouseDown; out.code = (uint16_t)InputMouseButton::Right; return true;
+    case WM_RBUTTONUP:   out.type = InputEventType::MouseUp;   out.code = (uint16_t)InputMouseButton::Right; return true;
+    case WM_MBUTTONDOWN: out.type = InputEventType::MouseDown; out.code = (uint16_t)InputMouseButton::Middle; return true;
+    case WM_MBUTTONUP:   out.type = InputEventType::MouseUp;   out.code = (uint16_t)InputMouseButton::Middle; return true;
+    case WM_XBUTTONDOWN:
+    case WM_XBUTTONUP:
+    {
+        const WORD xb = HIWORD(raw.mouseData);
+        if (xb != XBUTTON1 && xb != XBUTTON2) return false;
+        out.type = (raw.msg == WM_XBUTTONDOWN) ? InputEventType::MouseDown : InputEventType::MouseUp;
+        out.code = (uint16_t)((xb == XBUTTON1) ? InputMouseButton::X1 : InputMouseButton::X2);
+        return true;
+    }
+    case WM_MOUSEWHEEL:
+    case WM_MOUSEHWHEEL:
+        out.type = (raw.msg == WM_MOUSEWHEEL) ? InputEventType::Wheel : InputEventType::HWheel;
+        out.wheelDelta = (int16_t)HIWORD(raw.mouseData);
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void Dispatch(const RawInputEvent& raw)
+{
+    InputEvent ev;
+    ev.timeUs = QpcToBusUs(raw.qpc);
+    if (raw.flags & RawInputFlag_Injected) ev.flags |= InputEventFlag_Injected;
+    if (raw.flags & RawInputFlag_Blocked)  ev.flags |= InputEventFlag_Blocked;
+
+    if (raw.kind == RawInputKind::Keyboard)
+    {
+        if (raw.flags & RawInputFlag_ReinjectTap)
+            ReinjectTap(raw);
+
+        const bool down = (raw.msg == WM_KEYDOWN || raw.msg == WM_SYSKEYDOWN);
+        const bool up = (raw.msg == WM_KEYUP || raw.msg == WM_SYSKEYUP);
+        if (!down && !up) return;
+        ev.type = down ? InputEventType::KeyDown : InputEventType::KeyUp;
+        ev.code = (uint16_t)(raw.vkCode & 0xFFu);
+        ev.hid = raw.hid;
+    }
+    else if (!TranslateMouse(raw, ev))
+    {
+        return;
+    }
+
+    InputBus_Publish(ev);
+}
+
+static DWORD WINAPI ThreadProc(LPVOID)
+{
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
+
+    RawInputEvent ev;
+    while (g_run.load(std::memory_order_relaxed))
+    {
+        bool any = false;
+        uint64_t oldestQpc[2] = { 0, 0 };
+        while (g_ring.TryPop(ev))
+        {
+            uint64_t& o = oldestQpc[ev.kind == RawInputKind::Mouse ? 1 : 0];
+            if (!o) o = ev.qpc;
+            Dispatch(ev);
+            any = true;
+        }
+        if (g_pumpRequested.exchange(false, std::memory_order_relaxed) && !any)
+        {
+            FreeComboSystem::PumpInputBus();
+            continue;
+        }
+        if (any)
+        {
+            // Consumers on this thread read the whole batch in one go.
+            FreeComboSystem::PumpInputBus();
+
+            const uint64_t now = InputThread_Now();
+            if (oldestQpc[0]) AtomicMaxU32(StatsFor(InputHookId::Keyboard).maxQueueLagUs, QpcToUs(now - oldestQpc[0]));
+            if (oldestQpc[1]) AtomicMaxU32(StatsFor(InputHookId::Mouse).maxQueueLagUs, QpcToUs(now - oldestQpc[1]));
+            continue;
+        }
+
+        g_consumerSleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (g_ring.EmptyApprox() && !g_pumpRequested.load(std::memory_order_relaxed) &&
+            g_run.load(std::memory_order_relaxed))
+            WaitForSingleObject(g_wakeEvent, 50); // timeout = safety net only
+        g_consumerSleeping.store(false, std::memory_order_relaxed);
+    }
+
+    // Drain what is left so key-up events are not lost on shutdown.
+    while (g_ring.TryPop(ev))
+        Dispatch(ev);
+    FreeComboSystem::PumpInputBus();
+    return 0;
+}
+
+bool InputThread_Start()
+{
+    if (g_thread) return true;
+
+    g_wakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (!g_wakeEvent) return false;
+
+    g_run.store(true, std::memory_order_relaxed);
+    g_thread = CreateThread(nullptr, 0, ThreadProc, nullptr, 0, nullptr);
+    if (!g_thread)
+    {
+        g_run.store(false, std::memory_order_relaxed);
+        CloseHandle(g_wakeEvent);
+        g_wakeEvent = nullptr;
+        return false;
+    }
+    InputThread_GetLowLevelHooksTimeoutMs(); // warm the cache outside the hook
+    return true;
+}
+
+void InputThread_Stop()
+{
+    if (!g_thread) return;
+
+    g_run.store(false, std::memory_order_relaxed);
+    if (g_wakeEvent) SetEvent(g_wakeEvent);
+
+    WaitForSingleObject(g_thread, INFINITE);
+    CloseHandle(g_thread);
+    g_thread = nullptr;
+
+    if (g_wakeEvent)
+    {
+        CloseHandle(g_wakeEvent);
+        g_wakeEvent = nullptr;
+    }
+}
@@ -0,0 +1,91 @@
+// input_thread.h
+#pragma once
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <cstdint>
+
+// ============================================================
+// INPUT THREAD
+// The LL hooks only decide block/pass (lock-free tables) and push a
+// timestamped raw event here. A dedicated thread drains the ring,
+// publishes typed events on the input bus (input_bus.h) and then
+// drives FreeComboSystem (combos + trigger capture) from it.
+// Windows silently removes a LL hook that exceeds LowLevelHooksTimeout,
+// so nothing slow (locks, SendInput, process queries) may run in the hook.
+// ============================================================
+
+enum class RawInputKind : uint8_t
+{
+    Keyboard = 0,
+    Mouse = 1,
+};
+
+enum RawInputFlags : uint8_t
+{
+    RawInputFlag_None = 0,
+    RawInputFlag_Blocked = 1u << 0,     // hook returned 1: the game never saw this event
+    RawInputFlag_ReinjectTap = 1u << 1, // auto-repeat of a blocked bound key: re-send a marked tap
+    RawInputFlag_Injected = 1u << 2,    // LLKHF_INJECTED / LLMHF_INJECTED or our own marker
+};
+
+struct RawInputEvent
+{
+    uint64_t qpc = 0;        // QueryPerformanceCounter at hook entry
+    uint32_t msg = 0;        // WM_KEYDOWN, WM_LBUTTONDOWN, WM_MOUSEWHEEL...
+    uint32_t vkCode = 0;     // keyboard only
+    uint32_t scanCode = 0;   // keyboard only
+    uint32_t llFlags = 0;    // KBDLLHOOKSTRUCT::flags / MSLLHOOKSTRUCT::flags
+    uint32_t mouseData = 0;  // mouse only: HIWORD = wheel delta or XBUTTON1/2
+    uint32_t time = 0;       // OS event time (ms)
+    uint16_t hid = 0;        // keyboard only, 0 if unknown
+    RawInputKind kind = RawInputKind::Keyboard;
+    uint8_t flags = RawInputFlag_None;
+};
+
+bool InputThread_Start();
+void InputThread_Stop();
+
+// Producer side: LL hook thread only. Never blocks.
+// Returns false when the ring is full (event dropped and counted).
+bool InputThread_Push(const RawInputEvent& ev);
+
+// Any thread, never blocks: run FreeComboSystem::PumpInputBus() on the input
+// thread even without raw input (analog triggers queued by the realtime loop).
+void InputThread_RequestPump();
+
+// QPC timestamp used for events and hook timings.
+uint64_t InputThread_Now();
+
+// ---- Hook execution-time histograms ----
+enum class InputHookId : int
+{
+    Keyboard = 0,
+    Mouse = 1,
+};
+
+constexpr int INPUT_HOOK_HIST_BUCKETS = 12;
+
+struct InputHookStats
+{
+    uint64_t calls = 0;
+    uint64_t dropped = 0;       // raw events not queued (ring full)
+    uint32_t maxUs = 0;
+    uint32_t buckets[INPUT_HOOK_HIST_BUCKETS]{};
+    uint32_t maxQueueLagUs = 0; // hook entry -> processed on the input thread
+    uint32_t timeoutMs = 0;     // current LowLevelHooksTimeout
+};
+
+// Call at the very end of a hook, with the InputThread_Now() taken on entry.
+void InputThread_RecordHookTime(InputHookId hook, uint64_t qpcStart);
+
+void InputThread_GetHookStats(InputHookId hook, InputHookStats* out);
+void InputThread_ResetHookStats();
+
+// Upper bound (microseconds, inclusive) of a histogram bucket. Last bucket = UINT32_MAX.
+uint32_t InputThread_GetHookBucketUpperUs(int bucket);
+
+// LowLevelHooksTimeout from HKCU\Control Panel\Desktop (read once, cached).
+uint32_t InputThread_GetLowLevelHooksTimeoutMs();
+
+// One-line summary of both hooks through Logger (throttled by caller).
+void InputThread_LogHookStats();
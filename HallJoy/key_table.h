@@ -0,0 +1,223 @@
+// key_table.h
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// ============================================================
+// KEY TABLE
+// One declarative list of the keys HallJoy knows: HID usage, set-1 scan
+// code (+ E0 extended flag, as reported by the LL hook), Windows virtual-key
+// and a short label. Every translation direction is generated from it at
+// compile time into a dense array, so a lookup is one bounds check and one
+// load:
+//   scan + extended -> HID   (hook, every key event)
+//   HID -> VK                (SendInput, key paint)
+//   VK -> HID                (combo triggers, action editor)
+//   HID -> label
+// A key that only exists in one form (e.g. Right Shift, never extended) also
+// fills the other form of its scan code, as the old hand-written switch did.
+// Consistency (unique HID / scan, HID -> VK -> HID round trip) is checked by
+// static_assert below: a bad row does not compile.
+// VK values are numeric so the header stays portable (no Win32 include).
+// ============================================================
+
+struct KeyTableRow
+{
+    uint16_t       hid;
+    uint8_t        scan;      // 0 = no scan code
+    bool           extended;  // E0 prefix
+    uint8_t        vk;
+    const wchar_t* label;
+};
+
+// Order matters only for VK -> HID: when several keys share a VK (Enter and
+// Numpad Enter), the first row wins.
+inline constexpr KeyTableRow KEY_TABLE[] =
+{
+    {  4, 0x1E, false, 'A', L"A" }, {  5, 0x30, false, 'B', L"B" }, {  6, 0x2E, false, 'C', L"C" },
+    {  7, 0x20, false, 'D', L"D" }, {  8, 0x12, false, 'E', L"E" }, {  9, 0x21, false, 'F', L"F" },
+    { 10, 0x22, false, 'G', L"G" }, { 11, 0x23, false, 'H', L"H" }, { 12, 0x17, false, 'I', L"I" },
+    { 13, 0x24, false, 'J', L"J" }, { 14, 0x25, false, 'K', L"K" }, { 15, 0x26, false, 'L', L"L" },
+    { 16, 0x32, false, 'M', L"M" }, { 17, 0x31, false, 'N', L"N" }, { 18, 0x18, false, 'O', L"O" },
+    { 19, 0x19, false, 'P', L"P" }, { 20, 0x10, false, 'Q', L"Q" }, { 21, 0x13, false, 'R', L"R" },
+    { 22, 0x1F, false, 'S', L"S" }, { 23, 0x14, false, 'T', L"T" }, { 24, 0x16, false, 'U', L"U" },
+    { 25, 0x2F, false, 'V', L"V" }, { 26, 0x11, false, 'W', L"W" }, { 27, 0x2D, false, 'X', L"X" },
+    { 28, 0x15, false, 'Y', L"Y" }, { 29, 0x2C, false, 'Z', L"Z" },
+
+    { 30, 0x02, false, '1', L"1" }, { 31, 0x03, false, '2', L"2" }, { 32, 0x04, false, '3', L"3" },
+    { 33, 0x05, false, '4', L"4" }, { 34, 0x06, false, '5', L"5" }, { 35, 0x07, false, '6', L"6" },
+    { 36, 0x08, false, '7', L"7" }, { 37, 0x09, false, '8', L"8" }, { 38, 0x0A, false, '9', L"9" },
+    { 39, 0x0B, false, '0', L"0" },
+
+    { 40, 0x1C, false, 0x0D, L"Enter" },      // VK_RETURN
+    { 41, 0x01, false, 0x1B, L"Esc" },        // VK_ESCAPE
+    { 42, 0x0E, false, 0x08, L"Backspace" },  // VK_BACK
+    { 43, 0x0F, false, 0x09, L"Tab" },        // VK_TAB
+    { 44, 0x39, false, 0x20, L"Space" },      // VK_SPACE
+    { 45, 0x0C, false, 0xBD, L"-" },          // VK_OEM_MINUS
+    { 46, 0x0D, false, 0xBB, L"=" },          // VK_OEM_PLUS
+    { 47, 0x1A, false, 0xDB, L"[" },          // VK_OEM_4
+    { 48, 0x1B, false, 0xDD, L"]" },          // VK_OEM_6
+    { 49, 0x2B, false, 0xDC, L"\\" },         // VK_OEM_5
+    { 51, 0x27, false, 0xBA, L";" },          // VK_OEM_1
+    { 52, 0x28, false, 0xDE, L"'" },          // VK_OEM_7
+    { 53, 0x29, false, 0xC0, L"`" },          // VK_OEM_3
+    { 54, 0x33, false, 0xBC, L"," },          // VK_OEM_COMMA
+    { 55, 0x34, false, 0xBE, L"." },          // VK_OEM_PERIOD
+    { 56, 0x35, false, 0xBF, L"/" },          // VK_OEM_2
+    { 57, 0x3A, false, 0x14, L"Caps" },       // VK_CAPITAL
+
+    { 58, 0x3B, false, 0x70, L"F1" },  { 59, 0x3C, false, 0x71, L"F2" },  { 60, 0x3D, false, 0x72, L"F3" },
+    { 61, 0x3E, false, 0x73, L"F4" },  { 62, 0x3F, false, 0x74, L"F5" },  { 63, 0x40, false, 0x75, L"F6" },
+    { 64, 0x41, false, 0x76, L"F7" },  { 65, 0x42, false, 0x77, L"F8" },  { 66, 0x43, false, 0x78, L"F9" },
+    { 67, 0x44, false, 0x79, L"F10" }, { 68, 0x57, false, 0x7A, L"F11" }, { 69, 0x58, false, 0x7B, L"F12" },
+
+    { 70, 0x37, true,  0x2C, L"PrtSc" },      // VK_SNAPSHOT
+    { 71, 0x46, false, 0x91, L"ScrLk" },      // VK_SCROLL
+    { 72, 0x45, false, 0x13, L"Pause" },      // VK_PAUSE (E1 1D 45, reported as plain 45)
+    { 73, 0x52, true,  0x2D, L"Ins" },        // VK_INSERT
+    { 74, 0x47, true,  0x24, L"Home" },       // VK_HOME
+    { 75, 0x49, true,  0x21, L"PgUp" },       // VK_PRIOR
+    { 76, 0x53, true,  0x2E, L"Del" },        // VK_DELETE
+    { 77, 0x4F, true,  0x23, L"End" },        // VK_END
+    { 78, 0x51, true,  0x22, L"PgDn" },       // VK_NEXT
+    { 79, 0x4D, true,  0x27, L"Right" },      // VK_RIGHT
+    { 80, 0x4B, true,  0x25, L"Left" },       // VK_LEFT
+    { 81, 0x50, true,  0x28, L"Down" },       // VK_DOWN
+    { 82, 0x48, true,  0x26, L"Up" },         // VK_UP
+
+    { 83, 0x45, true,  0x90, L"NumLk" },      // VK_NUMLOCK (the hook flags it extended)
+    { 84, 0x35, true,  0x6F, L"Num /" },      // VK_DIVIDE
+    { 85, 0x37, false, 0x6A, L"Num *" },      // VK_MULTIPLY
+    { 86, 0x4A, false, 0x6D, L"Num -" },      // VK_SUBTRACT
+    { 87, 0x4E, false, 0x6B, L"Num +" },      // VK_ADD
+    { 88, 0x1C, true,  0x0D, L"Num Enter" },  // VK_RETURN, shared with Enter
+    { 89, 0x4F, false, 0x61, L"Num 1" },
+    { 90, 0x50, false, 0x62, L"Num 2" },
+    { 91, 0x51, false, 0x63, L"Num 3" },
+    { 92, 0x4B, false, 0x64, L"Num 4" },
+    { 93, 0x4C, false, 0x65, L"Num 5" },
+    { 94, 0x4D, false, 0x66, L"Num 6" },
+    { 95, 0x47, false, 0x67, L"Num 7" },
+    { 96, 0x48, false, 0x68, L"Num 8" },
+    { 97, 0x49, false, 0x69, L"Num 9" },
+    { 98, 0x52, false, 0x60, L"Num 0" },
+    { 99, 0x53, false, 0x6E, L"Num ." },      // VK_DECIMAL
+
+    { 100, 0x56, false, 0xE2, L"<>" },        // VK_OEM_102 (ISO key next to Left Shift)
+    { 101, 0x5D, true,  0x5D, L"Menu" },      // VK_APPS
+
+    { 104, 0x64, false, 0x7C, L"F13" }, { 105, 0x65, false, 0x7D, L"F14" }, { 106, 0x66, false, 0x7E, L"F15" },
+    { 107, 0x67, false, 0x7F, L"F16" }, { 108, 0x68, false, 0x80, L"F17" }, { 109, 0x69, false, 0x81, L"F18" },
+    { 110, 0x6A, false, 0x82, L"F19" }, { 111, 0x6B, false, 0x83, L"F20" }, { 112, 0x6C, false, 0x84, L"F21" },
+    { 113, 0x6D, false, 0x85, L"F22" }, { 114, 0x6E, false, 0x86, L"F23" }, { 115, 0x76, false, 0x87, L"F24" },
+
+    { 224, 0x1D, false, 0xA2, L"LCtrl" },     // VK_LCONTROL
+    { 225, 0x2A, false, 0xA0, L"LShift" },    // VK_LSHIFT
+    { 226, 0x38, false, 0xA4, L"LAlt" },      // VK_LMENU
+    { 227, 0x5B, true,  0x5B, L"LWin" },      // VK_LWIN
+    { 228, 0x1D, true,  0xA3, L"RCtrl" },     // VK_RCONTROL
+    { 229, 0x36, false, 0xA1, L"RShift" },    // VK_RSHIFT
+    { 230, 0x38, true,  0xA5, L"RAlt" },      // VK_RMENU
+    { 231, 0x5C, true,  0x5C, L"RWin" },      // VK_RWIN
+};
+
+// Side-less modifier VKs (VK_SHIFT / VK_CONTROL / VK_MENU) -> left key.
+// VK -> HID only: HID -> VK always gives the sided VK.
+struct KeyTableVkAlias { uint8_t vk; uint16_t hid; };
+inline constexpr KeyTableVkAlias KEY_TABLE_VK_ALIASES[] =
+{
+    { 0x10, 225 }, { 0x11, 224 }, { 0x12, 226 },
+};
+
+// ---- Generated lookups ----
+namespace key_table_detail
+{
+    constexpr std::array<std::array<uint16_t, 128>, 2> BuildScanToHid()
+    {
+        std::array<std::array<uint16_t, 128>, 2> t{};
+        for (const KeyTableRow& r : KEY_TABLE)
+            if (r.scan && r.scan < 128) t[r.extended ? 1 : 0][r.scan] = r.hid;
+        // Keys with a single form answer for both (extended flag ignored).
+        for (int sc = 0; sc < 128; ++sc) {
+            if (!t[0][sc]) t[0][sc] = t[1][sc];
+            if (!t[1][sc]) t[1][sc] = t[0][sc];
+        }
+        return t;
+    }
+
+    constexpr std::array<uint8_t, 256> BuildHidToVk()
+    {
+        std::array<uint8_t, 256> t{};
+        for (const KeyTableRow& r : KEY_TABLE) t[r.hid] = r.vk;
+        return t;
+    }
+
+    constexpr std::array<uint16_t, 256> BuildVkToHid()
+    {
+        std::array<uint16_t, 256> t{};
+        for (const KeyTableRow& r : KEY_TABLE)
+            if (r.vk && !t[r.vk]) t[r.vk] = r.hid;
+        for (const KeyTableVkAlias& a : KEY_TABLE_VK_ALIASES)
+            if (!t[a.vk]) t[a.vk] = a.hid;
+        return t;
+    }
+
+    constexpr std::array<const wchar_t*, 256> BuildHidToLabel()
+    {
+        std::array<const wchar_t*, 256> t{};
+        for (const KeyTableRow& r : KEY_TABLE) t[r.hid] = r.label;
+        return t;
+    }
+
+    inline constexpr auto kScanToHid = BuildScanToHid();
+    inline constexpr auto kHidToVk = BuildHidToVk();
+    inline constexpr auto kVkToHid = BuildVkToHid();
+    inline constexpr auto kHidToLabel = BuildHidToLabel();
+
+    constexpr bool Consistent()
+    {
+        for (size_t i = 0; i < std::size(KEY_TABLE); ++i) {
+            const KeyTableRow& r = KEY_TABLE[i];
+            if (r.hid == 0 || r.hid > 255 || r.vk == 0 || !r.label || r.scan >= 128) return false;
+            for (size_t j = 0; j < i; ++j) {
+                const KeyTableRow& o = KEY_TABLE[j];
+                if (o.hid == r.hid) return false;                                        // duplicate HID
+                if (r.scan && o.scan == r.scan && o.extended == r.extended) return false; // duplicate scan
+            }
+            // scan -> HID
+            if (r.scan && kScanToHid[r.extended ? 1 : 0][r.scan] != r.hid) return false;
+            // HID -> VK -> HID: exact, or the VK belongs to an earlier row and round-trips there
+            const uint16_t back = kVkToHid[kHidToVk[r.hid]];
+            if (back != r.hid && kHidToVk[back] != r.vk) return false;
+        }
+        for (const KeyTableVkAlias& a : KEY_TABLE_VK_ALIASES)
+            if (kHidToVk[a.hid] == 0 || kHidToVk[a.hid] == a.vk) return false;
+        return true;
+    }
+}
+
+static_assert(key_table_detail::Consistent(), "KEY_TABLE: duplicate or non round-tripping row");
+static_assert(key_table_detail::kScanToHid[0][0x1C] == 40 && key_table_detail::kScanToHid[1][0x1C] == 88, "KEY_TABLE: Enter / Numpad Enter");
+static_assert(key_table_detail::kScanToHid[1][0x36] == 229, "KEY_TABLE: single-form keys ignore the extended flag");
+
+// 0 when unknown.
+inline uint16_t KeyTable_HidFromScan(uint32_t scanCode, bool extended)
+{
+    const uint32_t sc = scanCode & 0xFFu;
+    return sc < 128 ? key_table_detail::kScanToHid[extended ? 1 : 0][sc] : 0;
+}
+inline uint8_t KeyTable_HidToVk(uint16_t hid)
+{
+    return hid < 256 ? key_table_detail::kHidToVk[hid] : 0;
+}
+inline uint16_t KeyTable_VkToHid(uint32_t vk)
+{
+    return vk < 256 ? key_table_detail::kVkToHid[vk] : 0;
+}
+// Fixed English label, nullptr when unknown (not keyboard-layout aware).
+inline const wchar_t* KeyTable_Label(uint16_t hid)
+{
+    return hid < 256 ? key_table_detail::kHidToLabel[hid] : nullptr;
+}
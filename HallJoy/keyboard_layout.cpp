@@ -10,6 +10,9 @@
 #include <filesystem>
 #include <cwctype>
 
+#include "ini_doc.h"
+#include "persist_service.h"
+#include "profile_cache.h"
 #include "win_util.h"
 
 namespace fs = std::filesystem;
@@ -417,9 +420,11 @@ namespace
     static bool LoadPresetFile(const wchar_t* path, PresetStore& out)
     {
         if (!path || !path[0]) return false;
-        if (GetFileAttributesW(path) == INVALID_FILE_ATTRIBUTES) return false;
 
-        int count = GetPrivateProfileIntW(L"LayoutPreset", L"Count", 0, path);
+        IniDoc doc;
+        if (!ProfileCache_LoadIni(path, doc)) return false;
+
+        int count = doc.GetInt(L"LayoutPreset", L"Count", 0);
         if (count <= 0) return false;
 
         std::vector<KeyDef> keys;
@@ -431,12 +436,11 @@ namespace
         {
             wchar_t k[64]{};
             swprintf_s(k, L"K%d", i);
-            wchar_t packed[1024]{};
-            GetPrivateProfileStringW(L"LayoutPreset", k, L"", packed, (DWORD)_countof(packed), path);
+            const std::wstring packed = doc.GetString(L"LayoutPreset", k);
 
             KeyDef kd{};
             std::wstring label;
-            if (ParsePackedKeyEntry(packed, kd, label))
+            if (ParsePackedKeyEntry(packed.c_str(), kd, label))
             {
                 keys.push_back(kd);
                 labels.push_back(std::move(label));
@@ -449,8 +453,8 @@ namespace
         out.filePath = path;
         out.keys = std::move(keys);
         out.labels = std::move(labels);
-        out.uniformSpacing = (GetPrivateProfileIntW(L"LayoutPreset", L"UniformSpacing", 0, path) != 0);
-        out.uniformGap = ClampUniformGap(GetPrivateProfileIntW(L"LayoutPreset", L"UniformGap", 8, path));
+        out.uniformSpacing = (doc.GetInt(L"LayoutPreset", L"UniformSpacing", 0) != 0);
+        out.uniformGap = ClampUniformGap(doc.GetInt(L"LayoutPreset", L"UniformGap", 8));
         for (size_t i = 0; i < out.keys.size() && i < out.labels.size(); ++i)
             out.keys[i].label = out.labels[i].c_str();
         return true;
@@ -463,23 +467,22 @@ namespace
         std::error_code ec;
         fs::create_directories(dir, ec);
 
-        WritePrivateProfileStringW(L"LayoutPreset", nullptr, nullptr, p.filePath.c_str());
+        // The preset file only holds [LayoutPreset]: built from scratch, the
+        // persistence service writes it (tmp + atomic replace)
+        IniDoc doc;
 
-        wchar_t v[64]{};
-        swprintf_s(v, L"%d", (int)p.keys.size());
-        WritePrivateProfileStringW(L"LayoutPreset", L"Count", v, p.filePath.c_str());
-        WritePrivateProfileStringW(L"LayoutPreset", L"UniformSpacing", p.uniformSpacing ? L"1" : L"0", p.filePath.c_str());
-        swprintf_s(v, L"%d", ClampUniformGap(p.uniformGap));
-        WritePrivateProfileStringW(L"LayoutPreset", L"UniformGap", v, p.filePath.c_str());
+        doc.SetInt(L"LayoutPreset", L"Count", (int)p.keys.size());
+        doc.SetInt(L"LayoutPreset", L"UniformSpacing", p.uniformSpacing ? 1 : 0);
+        doc.SetInt(L"LayoutPreset", L"UniformGap", ClampUniformGap(p.uniformGap));
 
         for (int i = 0; i < (int)p.keys.size(); ++i)
         {
             const KeyDef& k = p.keys[i];
             wchar_t key[64]{};
             swprintf_s(key, L"K%d", i);
-            std::wstring packed = BuildPackedKeyEntry(k);
-            WritePrivateProfileStringW(L"LayoutPreset", key, packed.c_str(), p.filePath.c_str());
+            doc.Set(L"LayoutPreset", key, BuildPackedKeyEntry(k));
         }
+        Persist_PostFile(p.filePath.c_str(), doc.SerializeBytes());
         return true;
     }
 
@@ -945,16 +948,14 @@ bool KeyboardLayout_StorePresetSnapshot(int presetIdx, const std::vector<KeyDef>
     return true;
 }
 
-bool KeyboardLayout_LoadFromIni(const wchar_t* path)
+bool KeyboardLayout_LoadFromIni(const IniDoc& doc)
 {
-    if (!path) return false;
     EnsureInit();
 
-    wchar_t nameBuf[128]{};
-    GetPrivateProfileStringW(L"KeyboardLayout", L"PresetName", L"", nameBuf, 128, path);
-    if (nameBuf[0])
+    const std::wstring name = doc.GetString(L"KeyboardLayout", L"PresetName");
+    if (!name.empty())
     {
-        int idx = FindPresetByName(nameBuf);
+        int idx = FindPresetByName(name);
         if (idx >= 0)
         {
             ActivatePreset(idx);
@@ -966,11 +967,10 @@ bool KeyboardLayout_LoadFromIni(const wchar_t* path)
     return true;
 }
 
-void KeyboardLayout_SaveToIni(const wchar_t* path)
+void KeyboardLayout_SaveToIni(IniDoc& doc)
 {
-    if (!path) return;
     EnsureInit();
 
-    WritePrivateProfileStringW(L"KeyboardLayout", nullptr, nullptr, path);
-    WritePrivateProfileStringW(L"KeyboardLayout", L"PresetName", g_presets[ClampPreset(g_currentPresetIdx)].name.c_str(), path);
+    doc.EraseSection(L"KeyboardLayout");
+    doc.Set(L"KeyboardLayout", L"PresetName", g_presets[ClampPreset(g_currentPresetIdx)].name);
 }
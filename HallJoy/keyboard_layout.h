@@ -40,5 +40,7 @@ bool KeyboardLayout_DeletePreset(int idx);
 bool KeyboardLayout_GetPresetSnapshot(int presetIdx, std::vector<KeyDef>& outKeys, std::vector<std::wstring>& outLabels, bool* outUniformSpacing, int* outUniformGap);
 bool KeyboardLayout_StorePresetSnapshot(int presetIdx, const std::vector<KeyDef>& keys, const std::vector<std::wstring>& labels, bool applyIfActive, bool uniformSpacing, int uniformGap);
 
-bool KeyboardLayout_LoadFromIni(const wchar_t* path);
-void KeyboardLayout_SaveToIni(const wchar_t* path);
+// [KeyboardLayout] section of settings.ini (settings_ini.cpp owns the document).
+class IniDoc;
+bool KeyboardLayout_LoadFromIni(const IniDoc& doc);
+void KeyboardLayout_SaveToIni(IniDoc& doc);
@@ -41,6 +41,7 @@
 #include "key_settings.h" // NEW
 #include "free_combo_ui.h"
 #include "free_combo_system.h" // FreeComboSystem::GetInjectedMouseState
+#include "input_bus.h"
 
 #pragma comment(lib, "Comctl32.lib")
 
@@ -123,15 +124,24 @@ static float g_mousePolyN[MPOLY_COUNT][MPOLY_PTS][2] =
 // force first paint
 static DWORD g_wheelUpFlash = 0;    // tick when wheel-up was last seen (for flash)
 static DWORD g_wheelDownFlash = 0;    // tick when wheel-down was last seen
+static InputBusReader g_mouseViewBus;  // live view: wheel events from the input bus
+
+// Wheel events seen by the hook (even when the window is not focused)
+static void MouseView_DrainBus()
+{
+    InputEvent ev;
+    while (InputBus_Poll(&g_mouseViewBus, &ev))
+    {
+        if (ev.type != InputEventType::Wheel || ev.wheelDelta == 0) continue;
+        if (ev.wheelDelta > 0) g_wheelUpFlash = GetTickCount();
+        else                   g_wheelDownFlash = GetTickCount();
+    }
+}
 
 static BYTE MouseCurrentState()
 {
-    BYTE s = 0;
-    if (GetAsyncKeyState(VK_LBUTTON) & 0x8000) s |= (1 << 0);
-    if (GetAsyncKeyState(VK_RBUTTON) & 0x8000) s |= (1 << 1);
-    if (GetAsyncKeyState(VK_MBUTTON) & 0x8000) s |= (1 << 2);
-    if (GetAsyncKeyState(VK_XBUTTON1) & 0x8000) s |= (1 << 3);
-    if (GetAsyncKeyState(VK_XBUTTON2) & 0x8000) s |= (1 << 4);
+    // Bits 0..4 = L, R, M, X1, X2 (same layout as InputMouseButton)
+    BYTE s = (BYTE)(InputBus_GetMouseHeldMask() & 0x1F);
     // OR with macro-injected state so simulated clicks light up the view
     s |= FreeComboSystem::GetInjectedMouseState();
     // Wheel flash: bit 5=up, bit 6=down — active for 120ms after last scroll event
@@ -2767,6 +2777,7 @@ static LRESULT CALLBACK PageMainProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM
     {
         HINSTANCE hInst = (HINSTANCE)GetWindowLongPtrW(hWnd, GWLP_HINSTANCE);
 
+        InputBus_Subscribe(&g_mouseViewBus);
         SetTimer(hWnd, 9104, 16, nullptr); // mouse view 60fps timer
         // Hotkeys for mouse overlay calibration (works even when focus is on child controls)
         RegisterHotKey(hWnd, 0xC08, MOD_NOREPEAT, VK_F8);  // toggle Synapse vector mode (when no PNG)
@@ -2915,6 +2926,7 @@ static LRESULT CALLBACK PageMainProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM
     case WM_TIMER:
         if (wParam == 9104) // MOUSE_VIEW_TIMER_ID
         {
+            MouseView_DrainBus();
             BYTE cur = MouseCurrentState();
             if (cur != g_mouseStatePrev)
             {
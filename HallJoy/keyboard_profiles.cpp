@@ -11,7 +11,9 @@
 #include <filesystem>
 
 #include "keyboard_profiles.h"
+#include "ini_doc.h"
 #include "ini_util.h"
+#include "persist_service.h"
 #include "win_util.h"
 
 namespace fs = std::filesystem;
@@ -163,9 +165,9 @@ static void LoadStateOnce()
 
     const std::wstring& stPath = GetStateIniPath();
 
-    wchar_t buf[260]{};
-    GetPrivateProfileStringW(L"UI", L"ActiveName", L"", buf, 260, stPath.c_str());
-    g_activeName = buf;
+    IniDoc doc;
+    IniUtil_LoadDoc(stPath.c_str(), doc);
+    g_activeName = doc.GetString(L"UI", L"ActiveName");
 
     // We don't persist dirty; always start clean (UI will compute it anyway)
     g_dirty = false;
@@ -178,8 +180,10 @@ static void SaveState()
     // Ensure dir exists (should already, but safe)
     EnsureDirExists(GetPresetsDir());
 
-    WritePrivateProfileStringW(L"UI", L"ActiveName", g_activeName.c_str(), stPath.c_str());
-    IniUtil_Flush(stPath.c_str());
+    // Only [UI] lives there: no need to read it back
+    IniDoc doc;
+    doc.Set(L"UI", L"ActiveName", g_activeName);
+    Persist_PostFile(stPath.c_str(), doc.SerializeBytes());
 }
 
 static float ClampF(float v, float lo, float hi)
@@ -192,29 +196,22 @@ static int ClampI(int v, int lo, int hi)
     return (v < lo) ? lo : (v > hi ? hi : v);
 }
 
-static float ReadM01(const wchar_t* sec, const wchar_t* key, int defM, const wchar_t* path)
+static float ReadM01(const IniDoc& doc, const wchar_t* sec, const wchar_t* key, int defM)
 {
-    int m = GetPrivateProfileIntW(sec, key, defM, path);
+    int m = doc.GetInt(sec, key, defM);
     m = ClampI(m, 0, 1000);
     return (float)m / 1000.0f;
 }
 
-static int ReadI(const wchar_t* sec, const wchar_t* key, int defV, const wchar_t* path)
+static int ReadI(const IniDoc& doc, const wchar_t* sec, const wchar_t* key, int defV)
 {
-    return GetPrivateProfileIntW(sec, key, defV, path);
+    return doc.GetInt(sec, key, defV);
 }
 
-static void WriteI(const wchar_t* sec, const wchar_t* key, int v, const wchar_t* path)
-{
-    wchar_t buf[64]{};
-    swprintf_s(buf, L"%d", v);
-    WritePrivateProfileStringW(sec, key, buf, path);
-}
-
-static void WriteM01(const wchar_t* sec, const wchar_t* key, float v01, const wchar_t* path)
+static void WriteM01(IniDoc& doc, const wchar_t* sec, const wchar_t* key, float v01)
 {
     int m = (int)lroundf(ClampF(v01, 0.0f, 1.0f) * 1000.0f);
-    WriteI(sec, key, m, path);
+    doc.SetInt(sec, key, m);
 }
 
 static KeyDeadzone NormalizePreset(KeyDeadzone ks)
@@ -252,28 +249,29 @@ static KeyDeadzone NormalizePreset(KeyDeadzone ks)
 // Internal load that NEVER touches module active/dirty state (safe for comparisons)
 static bool LoadPresetFile_NoState(const std::wstring& path, KeyDeadzone& outKs)
 {
-    if (GetFileAttributesW(path.c_str()) == INVALID_FILE_ATTRIBUTES)
+    IniDoc doc;
+    if (!IniUtil_LoadDoc(path.c_str(), doc))
         return false;
 
     // defaults from struct
     KeyDeadzone ks{};
 
     // Read milli-values to avoid locale float issues
-    ks.low = ReadM01(L"Curve", L"Low", (int)lroundf(ks.low * 1000.0f), path.c_str());
-    ks.high = ReadM01(L"Curve", L"High", (int)lroundf(ks.high * 1000.0f), path.c_str());
-    ks.antiDeadzone = ReadM01(L"Curve", L"AntiDeadzone", (int)lroundf(ks.antiDeadzone * 1000.0f), path.c_str());
-    ks.outputCap = ReadM01(L"Curve", L"OutputCap", (int)lroundf(ks.outputCap * 1000.0f), path.c_str());
+    ks.low = ReadM01(doc, L"Curve", L"Low", (int)lroundf(ks.low * 1000.0f));
+    ks.high = ReadM01(doc, L"Curve", L"High", (int)lroundf(ks.high * 1000.0f));
+    ks.antiDeadzone = ReadM01(doc, L"Curve", L"AntiDeadzone", (int)lroundf(ks.antiDeadzone * 1000.0f));
+    ks.outputCap = ReadM01(doc, L"Curve", L"OutputCap", (int)lroundf(ks.outputCap * 1000.0f));
 
-    ks.cp1_x = ReadM01(L"Curve", L"Cp1X", (int)lroundf(ks.cp1_x * 1000.0f), path.c_str());
-    ks.cp1_y = ReadM01(L"Curve", L"Cp1Y", (int)lroundf(ks.cp1_y * 1000.0f), path.c_str());
-    ks.cp2_x = ReadM01(L"Curve", L"Cp2X", (int)lroundf(ks.cp2_x * 1000.0f), path.c_str());
-    ks.cp2_y = ReadM01(L"Curve", L"Cp2Y", (int)lroundf(ks.cp2_y * 1000.0f), path.c_str());
+    ks.cp1_x = ReadM01(doc, L"Curve", L"Cp1X", (int)lroundf(ks.cp1_x * 1000.0f));
+    ks.cp1_y = ReadM01(doc, L"Curve", L"Cp1Y", (int)lroundf(ks.cp1_y * 1000.0f));
+    ks.cp2_x = ReadM01(doc, L"Curve", L"Cp2X", (int)lroundf(ks.cp2_x * 1000.0f));
+    ks.cp2_y = ReadM01(doc, L"Curve", L"Cp2Y", (int)lroundf(ks.cp2_y * 1000.0f));
 
-    ks.cp1_w = ReadM01(L"Curve", L"Cp1W", (int)lroundf(ks.cp1_w * 1000.0f), path.c_str());
-    ks.cp2_w = ReadM01(L"Curve", L"Cp2W", (int)lroundf(ks.cp2_w * 1000.0f), path.c_str());
+    ks.cp1_w = ReadM01(doc, L"Curve", L"Cp1W", (int)lroundf(ks.cp1_w * 1000.0f));
+    ks.cp2_w = ReadM01(doc, L"Curve", L"Cp2W", (int)lroundf(ks.cp2_w * 1000.0f));
 
-    ks.curveMode = (uint8_t)(ReadI(L"Curve", L"Mode", (int)ks.curveMode, path.c_str()) == 0 ? 0 : 1);
-    ks.invert = (ReadI(L"Curve", L"Invert", ks.invert ? 1 : 0, path.c_str()) != 0);
+    ks.curveMode = (uint8_t)(ReadI(doc, L"Curve", L"Mode", (int)ks.curveMode) == 0 ? 0 : 1);
+    ks.invert = (ReadI(doc, L"Curve", L"Invert", ks.invert ? 1 : 0) != 0);
 
     ks = NormalizePreset(ks);
     outKs = ks;
@@ -367,36 +365,31 @@ namespace KeyboardProfiles
 
         if (path.empty()) return false;
 
-        // Write to tmp, then atomic replace
-        std::wstring tmp = path + L".tmp";
-        DeleteFileW(tmp.c_str());
-
         KeyDeadzone ks = NormalizePreset(inKs);
 
-        // clear section (no compatibility needed, keep file clean)
-        WritePrivateProfileStringW(L"Curve", nullptr, nullptr, tmp.c_str());
+        // fresh document (no compatibility needed, keep file clean)
+        IniDoc doc;
 
-        WriteM01(L"Curve", L"Low", ks.low, tmp.c_str());
-        WriteM01(L"Curve", L"High", ks.high, tmp.c_str());
-        WriteM01(L"Curve", L"AntiDeadzone", ks.antiDeadzone, tmp.c_str());
-        WriteM01(L"Curve", L"OutputCap", ks.outputCap, tmp.c_str());
+        WriteM01(doc, L"Curve", L"Low", ks.low);
+        WriteM01(doc, L"Curve", L"High", ks.high);
+        WriteM01(doc, L"Curve", L"AntiDeadzone", ks.antiDeadzone);
+        WriteM01(doc, L"Curve", L"OutputCap", ks.outputCap);
 
-        WriteM01(L"Curve", L"Cp1X", ks.cp1_x, tmp.c_str());
-        WriteM01(L"Curve", L"Cp1Y", ks.cp1_y, tmp.c_str());
-        WriteM01(L"Curve", L"Cp2X", ks.cp2_x, tmp.c_str());
-        WriteM01(L"Curve", L"Cp2Y", ks.cp2_y, tmp.c_str());
+        WriteM01(doc, L"Curve", L"Cp1X", ks.cp1_x);
+        WriteM01(doc, L"Curve", L"Cp1Y", ks.cp1_y);
+        WriteM01(doc, L"Curve", L"Cp2X", ks.cp2_x);
+        WriteM01(doc, L"Curve", L"Cp2Y", ks.cp2_y);
 
-        WriteM01(L"Curve", L"Cp1W", ks.cp1_w, tmp.c_str());
-        WriteM01(L"Curve", L"Cp2W", ks.cp2_w, tmp.c_str());
+        WriteM01(doc, L"Curve", L"Cp1W", ks.cp1_w);
+        WriteM01(doc, L"Curve", L"Cp2W", ks.cp2_w);
 
-        WriteI(L"Curve", L"Mode", (int)(ks.curveMode == 0 ? 0 : 1), tmp.c_str());
-        WriteI(L"Curve", L"Invert", ks.invert ? 1 : 0, tmp.c_str());
+        doc.SetInt(L"Curve", L"Mode", (int)(ks.curveMode == 0 ? 0 : 1));
+        doc.SetInt(L"Curve", L"Invert", ks.invert ? 1 : 0);
 
-        if (!IniUtil_AtomicReplace(tmp.c_str(), path.c_str()))
-        {
-            DeleteFileW(tmp.c_str());
+        // Write to tmp, then atomic replace. Synchronous on purpose (not the
+        // persistence service): the caller rescans the folder right after.
+        if (!IniUtil_SaveDoc(doc, path.c_str()))
             return false;
-        }
 
         // Update "active preset" state (saving means "this preset is now current")
         fs::path pp(path);
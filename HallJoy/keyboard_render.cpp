@@ -27,6 +27,7 @@
 #include "remap_icons.h"
 #include "win_util.h"
 #include "key_settings.h"
+#include "key_table.h"
 
 using namespace Gdiplus;
 
@@ -343,72 +344,9 @@ static float GearSpin_GetAngle(uint16_t hid)
 // ---------------- digital (Windows keydown) state ----------------
 static std::array<uint8_t, 256> g_digLast{};
 
-static int VkFromHid(uint16_t hid)
-{
-    if (hid >= 4 && hid <= 29) return 'A' + (int)hid - 4;
-    if (hid >= 30 && hid <= 38) return '1' + (int)hid - 30;
-    if (hid == 39) return '0';
-
-    switch (hid)
-    {
-    case 41: return VK_ESCAPE;
-    case 42: return VK_BACK;
-    case 43: return VK_TAB;
-    case 44: return VK_SPACE;
-    case 40: return VK_RETURN;
-
-    case 53: return VK_OEM_3;
-    case 45: return VK_OEM_MINUS;
-    case 46: return VK_OEM_PLUS;
-    case 47: return VK_OEM_4;
-    case 48: return VK_OEM_6;
-    case 49: return VK_OEM_5;
-    case 51: return VK_OEM_1;
-    case 52: return VK_OEM_7;
-    case 54: return VK_OEM_COMMA;
-    case 55: return VK_OEM_PERIOD;
-    case 56: return VK_OEM_2;
-
-    case 58: return VK_F1;
-    case 59: return VK_F2;
-    case 60: return VK_F3;
-    case 61: return VK_F4;
-    case 62: return VK_F5;
-    case 63: return VK_F6;
-    case 64: return VK_F7;
-    case 65: return VK_F8;
-    case 66: return VK_F9;
-    case 67: return VK_F10;
-    case 68: return VK_F11;
-    case 69: return VK_F12;
-
-    case 74: return VK_HOME;
-    case 75: return VK_PRIOR;
-    case 76: return VK_DELETE;
-    case 77: return VK_END;
-    case 78: return VK_NEXT;
-
-    case 80: return VK_LEFT;
-    case 79: return VK_RIGHT;
-    case 81: return VK_DOWN;
-    case 82: return VK_UP;
-
-    case 224: return VK_LCONTROL;
-    case 225: return VK_LSHIFT;
-    case 226: return VK_LMENU;
-    case 227: return VK_LWIN;
-    case 229: return VK_RSHIFT;
-    case 230: return VK_RMENU;
-
-    case 57: return VK_CAPITAL;
-
-    default: return 0;
-    }
-}
-
 static bool IsDigitalDownByHid(uint16_t hid)
 {
-    int vk = VkFromHid(hid);
+    int vk = KeyTable_HidToVk(hid);
     if (!vk) return false;
     return (GetAsyncKeyState(vk) & 0x8000) != 0;
 }
@@ -202,6 +202,16 @@ LRESULT CALLBACK KeyboardSubpages_TesterPageProc(HWND hWnd, UINT msg, WPARAM wPa
             y += trigH + S(hWnd, 6);
 
             textLine(x0, y, L"Buttons: " + GamepadRender_ButtonsToString(r.wButtons), lineH);
+
+            // Both sticks in 2D, as sent (after shaping), over their shaping config
+            int stickSide = std::min(halfW, (int)card.bottom - S(hWnd, 8) - y);
+            if (stickSide >= S(hWnd, 24))
+            {
+                RECT rcL{ x0, y, x0 + stickSide, y + stickSide };
+                RECT rcR{ x0 + halfW + barGapX, y, x0 + halfW + barGapX + stickSide, y + stickSide };
+                GamepadRender_DrawStick2D(memDC, rcL, r.sThumbLX, r.sThumbLY, StickShape_Get(pad, 0));
+                GamepadRender_DrawStick2D(memDC, rcR, r.sThumbRX, r.sThumbRY, StickShape_Get(pad, 1));
+            }
         }
 
         SelectObject(memDC, oldFont);
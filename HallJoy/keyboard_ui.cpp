@@ -29,6 +29,7 @@
 #include "ui_theme.h"
 #include "settings.h"
 #include "free_combo_system.h"
+#include "stick_shape.h"
 #include "win_util.h"
 
 // created in keyboard_page_main.cpp
@@ -197,6 +198,7 @@ void KeyboardUI_OnTimerTick(HWND)
 
         int pads = std::clamp(Backend_GetVirtualGamepadCount(), 1, 4);
         uint32_t h = 2166136261u ^ (uint32_t)pads;
+        h = (h ^ StickShape_ConfigGeneration()) * 16777619u; // shaping overlay
         for (int i = 0; i < pads; ++i)
         {
             XUSB_REPORT r = Backend_GetLastReportForPad(i);
@@ -0,0 +1,208 @@
+// macro_compiler.cpp
+#include "macro_compiler.h"
+
+namespace
+{
+    enum class BlockKind : uint8_t { Loop, If };
+
+    struct Block
+    {
+        BlockKind kind = BlockKind::Loop;
+        uint8_t loopSlot = 0;
+        uint32_t bodyStart = 0;  // Loop: first instruction of the body
+        uint32_t pendingJump = 0; // If: jump to patch at Else (condition) or EndIf (else-skip)
+        bool hasElse = false;
+        uint64_t outerRuns = 1;   // Loop: runs of the enclosing code (restored at EndLoop)
+    };
+
+    // Saturating: MACRO_EFFECTS_UNBOUNDED absorbs everything
+    uint64_t MulEffects(uint64_t a, uint64_t b)
+    {
+        if (a == 0 || b == 0) return 0;
+        return (a > MACRO_EFFECTS_UNBOUNDED / b) ? MACRO_EFFECTS_UNBOUNDED : a * b;
+    }
+
+    uint64_t AddEffects(uint64_t a, uint64_t b)
+    {
+        return (a > MACRO_EFFECTS_UNBOUNDED - b) ? MACRO_EFFECTS_UNBOUNDED : a + b;
+    }
+
+    constexpr int kMaxBlocks = 32;
+
+    struct Compiler
+    {
+        MacroProgram* prog = nullptr;
+        Block blocks[kMaxBlocks];
+        int depth = 0;
+        int loopDepth = 0;
+        uint64_t runs = 1;        // how many times the current position runs
+        std::wstring err;
+
+        uint32_t Pc() const { return (uint32_t)prog->code.size(); }
+
+        // Instructions that go through IMacroHost::BeginStep
+        static bool IsEffect(MacroOp op)
+        {
+            switch (op)
+            {
+            case MacroOp::KeyDown: case MacroOp::KeyUp: case MacroOp::KeyTap:
+            case MacroOp::Text: case MacroOp::MouseClick:
+            case MacroOp::Wait: case MacroOp::WaitRandom:
+            case MacroOp::AnalogSet: case MacroOp::AnalogRamp: case MacroOp::AnalogRelease:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        uint32_t Emit(MacroOp op, uint16_t hid = 0, int32_t a = 0, int32_t b = 0, uint8_t reg = 0)
+        {
+            if (IsEffect(op)) prog->maxEffects = AddEffects(prog->maxEffects, runs);
+            MacroInstr in;
+            in.op = op; in.reg = reg; in.hid = hid; in.a = a; in.b = b;
+            prog->code.push_back(in);
+            return Pc() - 1;
+        }
+
+        bool Fail(size_t index, const wchar_t* msg)
+        {
+            err = L"action " + std::to_wstring(index + 1) + L": " + msg;
+            return false;
+        }
+
+        bool PushBlock(size_t index, const Block& b)
+        {
+            if (depth >= kMaxBlocks) return Fail(index, L"too many nested blocks");
+            blocks[depth++] = b;
+            return true;
+        }
+
+        bool OpenIf(size_t index, MacroOp op, uint16_t hid, int32_t b, uint8_t reg)
+        {
+            Block blk;
+            blk.kind = BlockKind::If;
+            blk.pendingJump = Emit(op, hid, 0, b, reg); // target patched later
+            return PushBlock(index, blk);
+        }
+
+        void CloseLoop(const Block& blk)
+        {
+            Emit(MacroOp::LoopNext, 0, (int32_t)blk.bodyStart, 0, blk.loopSlot);
+            --loopDepth;
+            runs = blk.outerRuns;
+        }
+
+        void CloseIf(const Block& blk)
+        {
+            prog->code[blk.pendingJump].a = (int32_t)Pc();
+        }
+
+        bool Action(size_t index, const ComboAction& a)
+        {
+            switch (a.type)
+            {
+            case ComboActionType::PressKey:   Emit(MacroOp::KeyDown, a.keyHid); return true;
+            case ComboActionType::ReleaseKey: Emit(MacroOp::KeyUp, a.keyHid); return true;
+            case ComboActionType::TapKey:     Emit(MacroOp::KeyTap, a.keyHid); return true;
+            case ComboActionType::TypeText:
+            {
+                const int32_t off = (int32_t)prog->text.size();
+                prog->text.insert(prog->text.end(), a.text.begin(), a.text.end());
+                Emit(MacroOp::Text, 0, off, (int32_t)a.text.size());
+                return true;
+            }
+            case ComboActionType::MouseClick: Emit(MacroOp::MouseClick, 0, a.mouseButton); return true;
+            case ComboActionType::Delay:      Emit(MacroOp::Wait, 0, (int32_t)a.delayMs); return true;
+            case ComboActionType::RandomDelay: Emit(MacroOp::WaitRandom, 0, (int32_t)a.delayMs, a.mouseButton); return true;
+
+            case ComboActionType::AnalogSet:     Emit(MacroOp::AnalogSet, a.keyHid, a.mouseButton); return true;
+            case ComboActionType::AnalogRamp:    Emit(MacroOp::AnalogRamp, a.keyHid, a.mouseButton, (int32_t)a.delayMs); return true;
+            case ComboActionType::AnalogRelease: Emit(MacroOp::AnalogRelease, a.keyHid); return true;
+
+            case ComboActionType::SetVar:
+            case ComboActionType::AddVar:
+                if (a.keyHid >= MACRO_VM_VARS) return Fail(index, L"variable index out of range");
+                Emit(a.type == ComboActionType::SetVar ? MacroOp::SetVar : MacroOp::AddVar,
+                    0, a.mouseButton, 0, (uint8_t)a.keyHid);
+                return true;
+
+            case ComboActionType::Loop:
+            {
+                if (loopDepth >= MACRO_VM_LOOP_DEPTH) return Fail(index, L"too many nested loops");
+                Block blk;
+                blk.kind = BlockKind::Loop;
+                blk.loopSlot = (uint8_t)loopDepth;
+                blk.outerRuns = runs;
+                Emit(MacroOp::LoopInit, 0, a.mouseButton, 0, blk.loopSlot);
+                blk.bodyStart = Pc();
+                if (!PushBlock(index, blk)) return false;
+                ++loopDepth;
+                runs = (a.mouseButton > 0) ? MulEffects(runs, (uint64_t)a.mouseButton) : MACRO_EFFECTS_UNBOUNDED;
+                return true;
+            }
+            case ComboActionType::EndLoop:
+                if (depth == 0 || blocks[depth - 1].kind != BlockKind::Loop)
+                    return Fail(index, L"End loop without Loop");
+                CloseLoop(blocks[--depth]);
+                return true;
+
+            case ComboActionType::IfKeyHeld:
+                return OpenIf(index, MacroOp::JumpIfNotHeld, a.keyHid, 0, 0);
+            case ComboActionType::IfAnalogAbove:
+                return OpenIf(index, MacroOp::JumpIfAnalogNotAbove, a.keyHid, a.mouseButton, 0);
+            case ComboActionType::IfVarBelow:
+                if (a.keyHid >= MACRO_VM_VARS) return Fail(index, L"variable index out of range");
+                return OpenIf(index, MacroOp::JumpIfVarNotBelow, 0, a.mouseButton, (uint8_t)a.keyHid);
+
+            case ComboActionType::Else:
+            {
+                if (depth == 0 || blocks[depth - 1].kind != BlockKind::If || blocks[depth - 1].hasElse)
+                    return Fail(index, L"Else without If");
+                Block& blk = blocks[depth - 1];
+                const uint32_t skip = Emit(MacroOp::Jump); // end of the "then" part
+                CloseIf(blk);                              // condition false -> else part
+                blk.pendingJump = skip;
+                blk.hasElse = true;
+                return true;
+            }
+            case ComboActionType::EndIf:
+                if (depth == 0 || blocks[depth - 1].kind != BlockKind::If)
+                    return Fail(index, L"End if without If");
+                CloseIf(blocks[--depth]);
+                return true;
+
+            case ComboActionType::None:
+            default:
+                return true; // unknown / empty action: ignored, like the old executor
+            }
+        }
+    };
+}
+
+bool MacroCompile(const std::vector<ComboAction>& actions, MacroProgram* out, std::wstring* error)
+{
+    if (!out) return false;
+    out->Clear();
+
+    Compiler c;
+    c.prog = out;
+    for (size_t i = 0; i < actions.size(); ++i)
+    {
+        if (!c.Action(i, actions[i]))
+        {
+            if (error) *error = c.err;
+            out->Clear();
+            return false;
+        }
+    }
+
+    // Close what the user left open (innermost first)
+    while (c.depth > 0)
+    {
+        const Block blk = c.blocks[--c.depth];
+        if (blk.kind == BlockKind::Loop) c.CloseLoop(blk);
+        else c.CloseIf(blk);
+    }
+    c.Emit(MacroOp::Halt);
+    return true;
+}
@@ -0,0 +1,15 @@
+// macro_compiler.h
+#pragma once
+#include <string>
+#include <vector>
+
+#include "macro_vm.h"
+#include "combo_action.h"
+
+// Compiles a combo action list (flat V1..V5 actions + Loop/If/... blocks) to VM bytecode.
+// - Blocks still open at the end are closed implicitly.
+// - A stray EndLoop / Else / EndIf, a block closed by the wrong keyword,
+//   too many nested loops or a bad variable index fail with a message.
+// - out->maxEffects is filled for the host's action watchdog.
+// `out` is cleared first; its buffers are reused (no allocation once warm).
+bool MacroCompile(const std::vector<ComboAction>& actions, MacroProgram* out, std::wstring* error = nullptr);
@@ -0,0 +1,372 @@
+// macro_recorder.cpp
+#include "macro_recorder.h"
+#include "input_bus.h"
+#include "spsc_ring.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iterator>
+#include <utility>
+
+namespace
+{
+    struct AnalogSample
+    {
+        MacroRecEvent ev;
+        uint32_t      session = 0;   // stale samples of a previous recording are dropped
+    };
+
+    std::atomic<bool>     g_recording{ false };
+    std::atomic<uint32_t> g_session{ 0 };
+
+    // ---- UI thread ----
+    InputBusReader             g_reader;
+    std::vector<MacroRecEvent> g_events;     // reserved by Start, never grows past it
+    uint32_t                   g_maxEvents = 0;
+    MacroRecStats              g_stats;
+
+    // ---- Realtime thread -> UI thread ----
+    // 8192 samples ~ 2 s of four keys moving at 1 kHz between two drains.
+    SpscRing<AnalogSample, 8192> g_analog;
+    std::atomic<uint32_t>        g_analogDropped{ 0 };
+
+    // ---- Realtime thread only ----
+    constexpr uint16_t kUnknown = 0xFFFF;
+    uint16_t g_lastM[256];
+    uint32_t g_rtSession = 0;
+}
+
+void MacroRecorder_Start(uint32_t maxEvents)
+{
+    g_recording.store(false, std::memory_order_relaxed);
+    AnalogSample s;
+    while (g_analog.TryPop(s)) {}
+
+    g_events.clear();
+    g_maxEvents = std::max<uint32_t>(maxEvents, 16);
+    g_events.reserve(g_maxEvents);
+    g_stats = MacroRecStats{};
+    g_analogDropped.store(0, std::memory_order_relaxed);
+    InputBus_Subscribe(&g_reader);
+
+    g_session.fetch_add(1, std::memory_order_release);
+    g_recording.store(true, std::memory_order_release);
+}
+
+bool MacroRecorder_IsRecording()
+{
+    return g_recording.load(std::memory_order_relaxed);
+}
+
+static void Append(const MacroRecEvent& ev)
+{
+    if (g_events.size() >= g_maxEvents) { ++g_stats.dropped; return; }
+    g_events.push_back(ev);
+}
+
+void MacroRecorder_Drain()
+{
+    if (!MacroRecorder_IsRecording()) return;
+
+    InputEvent in;
+    while (InputBus_Poll(&g_reader, &in)) {
+        // Our own macro output and OS auto-repeat are not the user's input
+        if (in.flags & (InputEventFlag_Injected | InputEventFlag_Repeat)) { ++g_stats.ignored; continue; }
+
+        MacroRecEvent ev;
+        ev.timeUs = in.timeUs;
+        switch (in.type) {
+        case InputEventType::KeyDown:
+        case InputEventType::KeyUp:
+            if (in.hid == 0 || in.hid >= 256) { ++g_stats.ignored; continue; }
+            ev.kind = (in.type == InputEventType::KeyDown) ? MacroRecKind::KeyDown : MacroRecKind::KeyUp;
+            ev.code = in.hid;
+            break;
+        case InputEventType::MouseDown:
+        case InputEventType::MouseUp:
+            ev.kind = (in.type == InputEventType::MouseDown) ? MacroRecKind::MouseDown : MacroRecKind::MouseUp;
+            ev.code = in.code;
+            break;
+        default:
+            ++g_stats.ignored;   // wheel: no action type for it
+            continue;
+        }
+        Append(ev);
+    }
+    g_stats.busOverruns = (uint32_t)g_reader.overruns;
+
+    const uint32_t session = g_session.load(std::memory_order_relaxed);
+    AnalogSample s;
+    while (g_analog.TryPop(s)) {
+        if (s.session != session) continue;
+        Append(s.ev);
+        ++g_stats.analogSamples;
+    }
+}
+
+void MacroRecorder_Stop(std::vector<MacroRecEvent>* out)
+{
+    MacroRecorder_Drain();
+    g_recording.store(false, std::memory_order_relaxed);
+    g_stats.dropped += g_analogDropped.load(std::memory_order_relaxed);
+    g_stats.events = (uint32_t)g_events.size();
+
+    // Bus and analog samples are appended per drain batch: merge them by time
+    std::stable_sort(g_events.begin(), g_events.end(),
+        [](const MacroRecEvent& a, const MacroRecEvent& b) { return a.timeUs < b.timeUs; });
+    if (out) *out = std::move(g_events);
+    g_events = {};
+}
+
+void MacroRecorder_GetStats(MacroRecStats* out)
+{
+    if (!out) return;
+    *out = g_stats;
+    if (MacroRecorder_IsRecording()) {
+        out->events = (uint32_t)g_events.size();
+        out->dropped += g_analogDropped.load(std::memory_order_relaxed);
+    }
+}
+
+bool MacroRecorder_WantsAnalog()
+{
+    return g_recording.load(std::memory_order_relaxed);
+}
+
+void MacroRecorder_PushAnalog(uint64_t timeUs, uint16_t hid, uint16_t milli)
+{
+    if (hid >= 256 || !g_recording.load(std::memory_order_relaxed)) return;
+    const uint32_t session = g_session.load(std::memory_order_acquire);
+    if (session != g_rtSession) {
+        g_rtSession = session;
+        std::fill(std::begin(g_lastM), std::end(g_lastM), kUnknown);
+    }
+    milli = std::min<uint16_t>(milli, 1000);
+    if (g_lastM[hid] == milli) return;
+
+    AnalogSample s;
+    s.ev.timeUs = timeUs;
+    s.ev.kind = MacroRecKind::Analog;
+    s.ev.code = hid;
+    s.ev.value = milli;
+    s.session = session;
+    if (g_analog.TryPush(s)) {
+        g_lastM[hid] = milli;
+    } else {
+        g_lastM[hid] = kUnknown;   // retried next tick
+        g_analogDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// ============================================================
+// Post-processing
+// ============================================================
+namespace
+{
+    struct Point { uint64_t timeUs; uint16_t milli; };
+
+    struct Item
+    {
+        uint64_t    timeUs = 0;
+        ComboAction action;
+        bool        analog = false;   // keyframe of an analog curve (keyHid)
+    };
+
+    // Ramer-Douglas-Peucker on the value axis: keeps the points the linear
+    // interpolation between kept points cannot approach within `tol`.
+    void SimplifyCurve(const std::vector<Point>& pts, uint16_t tol, std::vector<Point>* out)
+    {
+        out->clear();
+        if (pts.size() <= 2) { *out = pts; return; }
+
+        std::vector<uint8_t> keep(pts.size(), 0);
+        keep.front() = keep.back() = 1;
+        std::vector<std::pair<size_t, size_t>> stack;
+        stack.push_back({ 0, pts.size() - 1 });
+        while (!stack.empty()) {
+            const auto [a, b] = stack.back();
+            stack.pop_back();
+            if (b <= a + 1) continue;
+
+            const double t0 = (double)pts[a].timeUs, v0 = pts[a].milli;
+            const double span = (double)(pts[b].timeUs - pts[a].timeUs);
+            const double dv = (double)pts[b].milli - v0;
+            size_t worst = 0;
+            double worstErr = 0.0;
+            for (size_t i = a + 1; i < b; ++i) {
+                const double f = (span > 0.0) ? ((double)pts[i].timeUs - t0) / span : 0.0;
+                const double err = std::abs((double)pts[i].milli - (v0 + dv * f));
+                if (err > worstErr) { worstErr = err; worst = i; }
+            }
+            if (worstErr <= (double)tol) continue;
+            keep[worst] = 1;
+            stack.push_back({ a, worst });
+            stack.push_back({ worst, b });
+        }
+        for (size_t i = 0; i < pts.size(); ++i)
+            if (keep[i]) out->push_back(pts[i]);
+    }
+
+    // Keyframes of one key (curve starts at the first press, see Compile), up
+    // to the final return to rest (AnalogRelease), trailing rest dropped.
+    void AppendCurveItems(uint16_t hid, const std::vector<Point>& curve, std::vector<Item>* items)
+    {
+        size_t last = curve.size();
+        while (last > 0 && curve[last - 1].milli == 0) --last;
+        if (last == 0) return;   // never pressed
+        const bool endsReleased = (last < curve.size());
+
+        for (size_t i = 0; i < last; ++i) {
+            Item it;
+            it.timeUs = curve[i].timeUs;
+            it.analog = true;
+            it.action.type = ComboActionType::AnalogSet;
+            it.action.keyHid = hid;
+            it.action.mouseButton = curve[i].milli;
+            items->push_back(it);
+        }
+        Item rel;
+        rel.timeUs = endsReleased ? curve[last].timeUs : curve.back().timeUs;
+        rel.analog = true;
+        rel.action.type = ComboActionType::AnalogRelease;
+        rel.action.keyHid = hid;
+        items->push_back(rel);
+    }
+
+    ComboAction MakeAction(ComboActionType type, uint16_t hid)
+    {
+        ComboAction a;
+        a.type = type;
+        a.keyHid = hid;
+        return a;
+    }
+}
+
+void MacroRecorder_Compile(const std::vector<MacroRecEvent>& events, const MacroRecOptions& opt,
+    std::vector<ComboAction>* out)
+{
+    if (!out) return;
+    out->clear();
+    if (events.empty()) return;
+
+    // Keys recorded with a depth curve: their digital presses are the same input
+    std::vector<Point> curves[256];
+    bool analogKey[256]{};
+    if (opt.keepAnalog) {
+        for (const MacroRecEvent& e : events) {
+            if (e.kind != MacroRecKind::Analog || e.code >= 256) continue;
+            curves[e.code].push_back({ e.timeUs, e.value });
+            if (e.value > opt.analogToleranceM) analogKey[e.code] = true;
+        }
+    }
+
+    // The click that stopped the recording: last mouse press, nothing but releases after it
+    size_t skipIndex = events.size();
+    if (opt.dropTrailingClick) {
+        for (size_t i = events.size(); i-- > 0;) {
+            const MacroRecKind k = events[i].kind;
+            if (k == MacroRecKind::MouseDown) { skipIndex = i; break; }
+            if (k == MacroRecKind::KeyDown || k == MacroRecKind::KeyUp) break;
+        }
+    }
+
+    std::vector<Item> items;
+    items.reserve(events.size());
+    bool   down[256]{};
+    size_t pressItem[256]{};
+    const uint64_t tapMaxUs = (uint64_t)opt.tapMaxMs * 1000ull;
+    uint64_t endUs = 0;
+
+    for (size_t i = 0; i < events.size(); ++i) {
+        const MacroRecEvent& e = events[i];
+        if (i >= skipIndex) {
+            if (i == skipIndex) continue;
+        } else {
+            endUs = std::max(endUs, e.timeUs);
+        }
+        switch (e.kind) {
+        case MacroRecKind::KeyDown:
+            if (e.code >= 256 || analogKey[e.code] || down[e.code]) break;
+            down[e.code] = true;
+            pressItem[e.code] = items.size();
+            items.push_back({ e.timeUs, MakeAction(ComboActionType::PressKey, e.code), false });
+            break;
+        case MacroRecKind::KeyUp:
+            if (e.code >= 256 || !down[e.code]) break;   // held before the recording started
+            down[e.code] = false;
+            // Nothing else in between and short: one tap
+            if (pressItem[e.code] == items.size() - 1 && e.timeUs - items.back().timeUs <= tapMaxUs)
+                items.back().action.type = ComboActionType::TapKey;
+            else
+                items.push_back({ e.timeUs, MakeAction(ComboActionType::ReleaseKey, e.code), false });
+            break;
+        case MacroRecKind::MouseDown:
+            if (e.code > 2) break;   // MouseClick: left / right / middle
+            {
+                Item it;
+                it.timeUs = e.timeUs;
+                it.action.type = ComboActionType::MouseClick;
+                it.action.mouseButton = e.code;
+                items.push_back(it);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    std::vector<Point> simplified;
+    for (uint16_t hid = 0; hid < 256; ++hid) {
+        if (!analogKey[hid]) continue;
+        // Samples are taken on change only: the rest before the first press says
+        // nothing about when the press started, the curve begins at its first sample.
+        std::vector<Point>& raw = curves[hid];
+        raw.erase(raw.begin(), std::find_if(raw.begin(), raw.end(), [](const Point& p) { return p.milli != 0; }));
+        SimplifyCurve(raw, opt.analogToleranceM, &simplified);
+        AppendCurveItems(hid, simplified, &items);
+    }
+    // After the curves: at equal time a curve ends with its ramp before these
+    for (uint16_t hid = 0; hid < 256; ++hid)
+        if (down[hid]) items.push_back({ endUs, MakeAction(ComboActionType::ReleaseKey, hid), false });
+    if (items.empty()) return;
+
+    std::stable_sort(items.begin(), items.end(),
+        [](const Item& a, const Item& b) { return a.timeUs < b.timeUs; });
+
+    // Absolute grid from the first action: rounding never accumulates
+    const uint64_t startUs = items.front().timeUs;
+    const uint32_t quantum = std::max<uint32_t>(opt.quantumMs, 1);
+    auto gridMs = [&](uint64_t t) -> uint64_t {
+        const uint64_t ms = (t - startUs + 500) / 1000;
+        return (ms + quantum / 2) / quantum * quantum;
+    };
+
+    uint64_t prevMs = 0;
+    int      prevAnalogHid = -1;   // previous action = keyframe of this key
+    for (const Item& it : items) {
+        const uint64_t atMs = gridMs(it.timeUs);
+        uint64_t gap = atMs - prevMs;
+        if (opt.maxDelayMs && gap > opt.maxDelayMs) gap = opt.maxDelayMs;
+        prevMs = atMs;
+
+        const ComboAction& a = it.action;
+        const bool ramp = it.analog && gap > 0 && prevAnalogHid == (int)a.keyHid;
+        if (ramp) {
+            // Two keyframes of the same key in a row: the ramp is the wait
+            ComboAction r = MakeAction(ComboActionType::AnalogRamp, a.keyHid);
+            r.mouseButton = (a.type == ComboActionType::AnalogRelease) ? 0 : a.mouseButton;
+            r.delayMs = (uint32_t)gap;
+            out->push_back(r);
+            if (a.type == ComboActionType::AnalogRelease) out->push_back(a);
+        } else {
+            if (gap > 0) {
+                ComboAction d;
+                d.type = ComboActionType::Delay;
+                d.delayMs = (uint32_t)gap;
+                out->push_back(d);
+            }
+            out->push_back(a);
+        }
+        prevAnalogHid = it.analog ? (int)a.keyHid : -1;
+    }
+}
@@ -0,0 +1,84 @@
+// macro_recorder.h
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "combo_action.h"
+
+// ============================================================
+// MACRO RECORDER
+// Records live input and turns it into a combo action list.
+// Capture:
+// - keys / mouse buttons: read from the input bus (input_bus.h) by a
+//   private reader, nothing is added to the hooks or the input thread
+// - analog depth of bound keys: pushed by the realtime thread (Backend_Tick)
+//   into a preallocated lock-free ring, only when a value changes
+// Both are drained by the UI thread (MacroRecorder_Drain, timer while
+// recording) into a buffer reserved by MacroRecorder_Start: no allocation
+// and no lock on any input path.
+// Post-processing (MacroRecorder_Compile) is plain code on a recording:
+// press / release pairs become taps, delays are quantized on an absolute
+// grid (no drift), analog curves are simplified to a few ramps.
+// Portable (no Win32 call).
+// ============================================================
+
+enum class MacroRecKind : uint8_t
+{
+    KeyDown = 0,
+    KeyUp,
+    MouseDown,   // code = InputMouseButton
+    MouseUp,
+    Analog,      // code = hid, value = depth milli [0..1000]
+};
+
+struct MacroRecEvent
+{
+    uint64_t     timeUs = 0;   // same timebase as InputEvent::timeUs (QPC microseconds)
+    MacroRecKind kind = MacroRecKind::KeyDown;
+    uint16_t     code = 0;     // Key*: HID usage
+    uint16_t     value = 0;
+};
+
+struct MacroRecStats
+{
+    uint32_t events = 0;        // kept in the recording
+    uint32_t analogSamples = 0;
+    uint32_t dropped = 0;       // buffer or analog ring full
+    uint32_t busOverruns = 0;   // input bus lapped the reader (drained too late)
+    uint32_t ignored = 0;       // injected, auto-repeat, no HID usage, wheel
+};
+
+// ---- Capture (UI thread) ----
+// Reserves room for maxEvents; recording stops growing when it is full.
+void MacroRecorder_Start(uint32_t maxEvents = 65536);
+bool MacroRecorder_IsRecording();
+// Moves what was captured since the last call into the recording. Call it at
+// least every few hundred ms while recording (bus and analog ring are finite).
+void MacroRecorder_Drain();
+// Last drain, then the recording sorted by time.
+void MacroRecorder_Stop(std::vector<MacroRecEvent>* out);
+void MacroRecorder_GetStats(MacroRecStats* out);
+
+// ---- Realtime thread ----
+// Cheap, lock-free: lets Backend_Tick skip the per-key loop.
+bool MacroRecorder_WantsAnalog();
+// Called for every bound key each tick; only changes are queued.
+void MacroRecorder_PushAnalog(uint64_t timeUs, uint16_t hid, uint16_t milli);
+
+// ---- Post-processing ----
+struct MacroRecOptions
+{
+    uint32_t quantumMs = 10;        // delay grid, 0 or 1 = exact milliseconds
+    uint32_t tapMaxMs = 150;        // press + release shorter than this, nothing in between -> TapKey
+    uint32_t maxDelayMs = 0;        // longer pauses are shortened to this, 0 = keep
+    bool     dropTrailingClick = true; // last mouse click = the Stop button
+    bool     keepAnalog = true;     // analog keys become AnalogSet / AnalogRamp instead of presses
+    uint16_t analogToleranceM = 25; // max deviation of the simplified curve (milli)
+};
+
+// Mouse buttons become MouseClick at the press (left / right / middle only,
+// the action list has no mouse press / release); a release with no press in
+// the recording (key held at start) is ignored; keys still held at the end
+// get their ReleaseKey. `out` is cleared first.
+void MacroRecorder_Compile(const std::vector<MacroRecEvent>& events, const MacroRecOptions& opt,
+    std::vector<ComboAction>* out);
@@ -0,0 +1,193 @@
+// macro_vm.cpp
+#include "macro_vm.h"
+
+#include <algorithm>
+#include <cstdint>
+
+void MacroVm::Reset(uint32_t seed)
+{
+    for (auto& v : m_vars) v = 0;
+    for (auto& l : m_loops) l = 0;
+    for (auto& a : m_analog) a = 0;
+    m_rng = seed ? seed : 0x9E3779B9u;
+    m_steps = 0;
+}
+
+// xorshift32: plenty for humanized delays, no state outside the VM.
+uint32_t MacroVm::NextRandom()
+{
+    uint32_t x = m_rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    m_rng = x;
+    return x;
+}
+
+static uint16_t ClampMilli(int32_t v)
+{
+    return (uint16_t)std::clamp(v, 0, 1000);
+}
+
+bool MacroVm::Ramp(IMacroHost& host, uint16_t hid, int32_t target, uint32_t durationMs)
+{
+    const int32_t from = m_analog[hid & 0xFF];
+    const int32_t to = ClampMilli(target);
+    const uint32_t n = std::max<uint32_t>(1, durationMs / MACRO_VM_RAMP_STEP_MS);
+
+    uint32_t elapsed = 0;
+    for (uint32_t i = 1; i <= n; ++i)
+    {
+        const int32_t v = from + (int32_t)((int64_t)(to - from) * i / n);
+        host.SetAnalog(hid, (uint16_t)v);
+        m_analog[hid & 0xFF] = (uint16_t)v;
+
+        // Spread the duration exactly, whatever the rounding of each step.
+        const uint32_t until = (uint32_t)((uint64_t)durationMs * i / n);
+        if (until > elapsed)
+        {
+            if (!host.Wait(until - elapsed)) return false;
+            elapsed = until;
+        }
+    }
+    return true;
+}
+
+void MacroVm::ReleaseAnalogs(IMacroHost& host)
+{
+    for (int hid = 0; hid < 256; ++hid)
+    {
+        if (!m_analog[hid]) continue;
+        host.ReleaseAnalog((uint16_t)hid);
+        m_analog[hid] = 0;
+    }
+}
+
+MacroRunResult MacroVm::Run(const MacroProgram& prog, IMacroHost& host, uint64_t maxSteps)
+{
+    const MacroRunResult res = Execute(prog, host, maxSteps);
+    // Whatever ended the run: never leave a virtual axis deflected by the macro.
+    ReleaseAnalogs(host);
+    return res;
+}
+
+MacroRunResult MacroVm::Execute(const MacroProgram& prog, IMacroHost& host, uint64_t maxSteps)
+{
+    const MacroInstr* code = prog.code.data();
+    const uint32_t size = (uint32_t)prog.code.size();
+    uint32_t pc = 0;
+    m_steps = 0;
+
+    auto validPc = [size](int32_t t) { return t >= 0 && (uint32_t)t <= size; };
+
+    while (pc < size)
+    {
+        if (++m_steps > maxSteps) return MacroRunResult::StepLimit;
+
+        const MacroInstr& in = code[pc++];
+        switch (in.op)
+        {
+        case MacroOp::Halt:
+            return MacroRunResult::Finished;
+
+        case MacroOp::KeyDown:
+            if (!host.BeginStep()) goto stopped;
+            host.KeyDown(in.hid);
+            break;
+        case MacroOp::KeyUp:
+            if (!host.BeginStep()) goto stopped;
+            host.KeyUp(in.hid);
+            break;
+        case MacroOp::KeyTap:
+            if (!host.BeginStep()) goto stopped;
+            host.KeyTap(in.hid);
+            break;
+        case MacroOp::Text:
+            if (in.a < 0 || in.b < 0 || (size_t)in.a + (size_t)in.b > prog.text.size())
+                return MacroRunResult::BadProgram;
+            if (!host.BeginStep()) goto stopped;
+            host.TypeText(prog.text.data() + in.a, (uint32_t)in.b);
+            break;
+        case MacroOp::MouseClick:
+            if (!host.BeginStep()) goto stopped;
+            host.MouseClick((uint8_t)in.a);
+            break;
+
+        case MacroOp::Wait:
+            if (!host.BeginStep()) goto stopped;
+            if (in.a > 0 && !host.Wait((uint32_t)in.a)) goto stopped;
+            break;
+        case MacroOp::WaitRandom:
+        {
+            if (!host.BeginStep()) goto stopped;
+            const uint32_t lo = (uint32_t)std::max(0, std::min(in.a, in.b));
+            const uint32_t hi = (uint32_t)std::max(0, std::max(in.a, in.b));
+            const uint32_t ms = lo + NextRandom() % (hi - lo + 1);
+            if (ms > 0 && !host.Wait(ms)) goto stopped;
+            break;
+        }
+
+        case MacroOp::AnalogSet:
+            if (!host.BeginStep()) goto stopped;
+            m_analog[in.hid & 0xFF] = ClampMilli(in.a);
+            host.SetAnalog(in.hid, ClampMilli(in.a));
+            break;
+        case MacroOp::AnalogRamp:
+            if (!host.BeginStep()) goto stopped;
+            if (!Ramp(host, in.hid, in.a, (uint32_t)std::max(0, in.b))) goto stopped;
+            break;
+        case MacroOp::AnalogRelease:
+            if (!host.BeginStep()) goto stopped;
+            m_analog[in.hid & 0xFF] = 0;
+            host.ReleaseAnalog(in.hid);
+            break;
+
+        case MacroOp::Jump:
+            if (!validPc(in.a)) return MacroRunResult::BadProgram;
+            pc = (uint32_t)in.a;
+            break;
+        case MacroOp::JumpIfNotHeld:
+            if (!validPc(in.a)) return MacroRunResult::BadProgram;
+            if (!host.IsKeyHeld(in.hid)) pc = (uint32_t)in.a;
+            break;
+        case MacroOp::JumpIfAnalogNotAbove:
+            if (!validPc(in.a)) return MacroRunResult::BadProgram;
+            if ((int32_t)host.GetAnalogMilli(in.hid) <= in.b) pc = (uint32_t)in.a;
+            break;
+        case MacroOp::JumpIfVarNotBelow:
+            if (!validPc(in.a) || in.reg >= MACRO_VM_VARS) return MacroRunResult::BadProgram;
+            if (m_vars[in.reg] >= in.b) pc = (uint32_t)in.a;
+            break;
+
+        case MacroOp::SetVar:
+            if (in.reg >= MACRO_VM_VARS) return MacroRunResult::BadProgram;
+            m_vars[in.reg] = in.a;
+            break;
+        case MacroOp::AddVar:
+        {
+            if (in.reg >= MACRO_VM_VARS) return MacroRunResult::BadProgram;
+            // Saturates instead of wrapping (signed overflow): a counter bumped
+            // forever in an endless loop sticks at the limit.
+            const int64_t sum = (int64_t)m_vars[in.reg] + in.a;
+            m_vars[in.reg] = (int32_t)std::clamp<int64_t>(sum, INT32_MIN, INT32_MAX);
+            break;
+        }
+
+        case MacroOp::LoopInit:
+            if (in.reg >= MACRO_VM_LOOP_DEPTH) return MacroRunResult::BadProgram;
+            m_loops[in.reg] = (in.a > 0) ? in.a : -1; // -1 = until stopped
+            break;
+        case MacroOp::LoopNext:
+            if (in.reg >= MACRO_VM_LOOP_DEPTH || !validPc(in.a)) return MacroRunResult::BadProgram;
+            if (m_loops[in.reg] < 0 || --m_loops[in.reg] > 0) pc = (uint32_t)in.a;
+            break;
+
+        default:
+            return MacroRunResult::BadProgram;
+        }
+    }
+    return MacroRunResult::Finished;
+
+stopped:
+    return MacroRunResult::Stopped;
+}
@@ -0,0 +1,127 @@
+// macro_vm.h
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// ============================================================
+// MACRO VM
+// Small bytecode interpreter behind the combo macros: loops, branches on
+// live input (key held, analog depth), integer variables, random delays
+// and analog ramps. Programs are produced by MacroCompile() (macro_compiler.h)
+// from the combo action list; everything the VM does to the outside world
+// goes through IMacroHost, so it runs headless as well.
+// Run() never allocates: all state is fixed-size inside MacroVm.
+// Portable: no Win32 dependency.
+// ============================================================
+
+constexpr int MACRO_VM_VARS = 8;
+constexpr int MACRO_VM_LOOP_DEPTH = 8;
+constexpr uint32_t MACRO_VM_RAMP_STEP_MS = 10; // analog ramp resolution
+
+enum class MacroOp : uint8_t
+{
+    Halt = 0,
+    KeyDown,              // hid
+    KeyUp,                // hid
+    KeyTap,               // hid
+    Text,                 // a = offset in MacroProgram::text, b = length
+    MouseClick,           // a = button (0=L, 1=R, 2=M, 3=X1, 4=X2)
+    Wait,                 // a = ms
+    WaitRandom,           // a = min ms, b = max ms (inclusive)
+    AnalogSet,            // hid, a = milli [0..1000]
+    AnalogRamp,           // hid, a = target milli, b = duration ms (from the last value set by this VM)
+    AnalogRelease,        // hid
+    Jump,                 // a = target pc
+    JumpIfNotHeld,        // hid, a = target pc
+    JumpIfAnalogNotAbove, // hid, a = target pc, b = threshold milli
+    JumpIfVarNotBelow,    // reg = variable, a = target pc, b = value
+    SetVar,               // reg = variable, a = value
+    AddVar,               // reg = variable, a = delta
+    LoopInit,             // reg = loop slot, a = count (0 = until stopped)
+    LoopNext,             // reg = loop slot, a = body start pc
+};
+
+struct MacroInstr
+{
+    MacroOp op = MacroOp::Halt;
+    uint8_t reg = 0;
+    uint16_t hid = 0;
+    int32_t a = 0;
+    int32_t b = 0;
+};
+
+// Effect count of a program that runs a loop "until stopped"
+constexpr uint64_t MACRO_EFFECTS_UNBOUNDED = ~0ull;
+
+struct MacroProgram
+{
+    std::vector<MacroInstr> code;
+    std::vector<wchar_t> text; // pool for Text instructions
+    // Effects (BeginStep calls) of one full run, finite loops unrolled; upper
+    // bound when If blocks skip some. MACRO_EFFECTS_UNBOUNDED: endless loop.
+    uint64_t maxEffects = 0;
+
+    void Clear() { code.clear(); text.clear(); maxEffects = 0; } // keeps capacity
+};
+
+// Everything observable. Implemented by the combo worker (SendInput + backend)
+// and by test/simulation doubles.
+class IMacroHost
+{
+public:
+    virtual ~IMacroHost() = default;
+
+    // Called before every instruction with an effect (output or wait).
+    // false => stop now (cancelled, watchdog...).
+    virtual bool BeginStep() = 0;
+
+    virtual void KeyDown(uint16_t hid) = 0;
+    virtual void KeyUp(uint16_t hid) = 0;
+    virtual void KeyTap(uint16_t hid) = 0;
+    virtual void TypeText(const wchar_t* text, uint32_t len) = 0;
+    virtual void MouseClick(uint8_t button) = 0;
+    // false => cancelled while waiting
+    virtual bool Wait(uint32_t ms) = 0;
+
+    // Macro analog path (milli [0..1000])
+    virtual void SetAnalog(uint16_t hid, uint16_t milli) = 0;
+    virtual void ReleaseAnalog(uint16_t hid) = 0;
+
+    // Live input state
+    virtual bool IsKeyHeld(uint16_t hid) = 0;
+    virtual uint16_t GetAnalogMilli(uint16_t hid) = 0;
+};
+
+enum class MacroRunResult : uint8_t
+{
+    Finished = 0,
+    Stopped,     // host said stop (BeginStep / Wait returned false)
+    StepLimit,   // maxSteps reached (runaway loop without effects)
+    BadProgram,  // pc / register out of range
+};
+
+class MacroVm
+{
+public:
+    // Clears variables and seeds the random generator (variables survive between Run calls).
+    void Reset(uint32_t seed);
+
+    // Every analog the program set is released when Run returns, however it ended.
+    MacroRunResult Run(const MacroProgram& prog, IMacroHost& host, uint64_t maxSteps = 1000000);
+
+    // Instructions executed by the last Run().
+    uint64_t Steps() const { return m_steps; }
+    int32_t Var(int i) const { return (i >= 0 && i < MACRO_VM_VARS) ? m_vars[i] : 0; }
+
+private:
+    MacroRunResult Execute(const MacroProgram& prog, IMacroHost& host, uint64_t maxSteps);
+    uint32_t NextRandom();
+    bool Ramp(IMacroHost& host, uint16_t hid, int32_t target, uint32_t durationMs);
+    void ReleaseAnalogs(IMacroHost& host);
+
+    int32_t m_vars[MACRO_VM_VARS]{};
+    int32_t m_loops[MACRO_VM_LOOP_DEPTH]{};
+    uint16_t m_analog[256]{};   // last milli set per HID (0 = released)
+    uint32_t m_rng = 0x9E3779B9u;
+    uint64_t m_steps = 0;
+};
@@ -6,6 +6,9 @@
 
 #include "app.h"
 #include "win_util.h"
+#include "ini_doc.h"
+#include "persist_service.h"
+#include "profile_cache.h"
 #include "Resource.h"
 #include "Logger.h"
 #include "free_combo_system.h"   // ← Nouveau système de combos libres
@@ -207,9 +210,17 @@ static void ShutdownFreeComboSystem()
 // ─────────────────────────────────────────────────────────────
 int WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, PWSTR, int nCmdShow)
 {
+    // 0. Service de persistance : rejoue le journal d'un crash AVANT toute lecture
+    //    des fichiers de reglages
+    Persist_Start(WinUtil_BuildPathNearExe(L"persist.journal").c_str());
+    // Cache compile des .ini lus au demarrage (relache a l'entree de la boucle messages)
+    ProfileCache_Open(WinUtil_BuildPathNearExe(L"profile.cache").c_str());
+
     // 1. Logger : lire settings.ini AVANT d'initialiser
     std::wstring iniPath = WinUtil_BuildPathNearExe(L"settings.ini");
-    int loggingEnabled = GetPrivateProfileIntW(L"Main", L"Logging", 0, iniPath.c_str());
+    IniDoc iniDoc;
+    ProfileCache_LoadIni(iniPath.c_str(), iniDoc);
+    int loggingEnabled = iniDoc.GetInt(L"Main", L"Logging", 0);
     Logger::SetEnabled(loggingEnabled != 0);
     Logger::Init("DrDre_WASD_log.txt");
     Logger::Info("MAIN", "=== wWinMain demarre ===");
@@ -219,6 +230,8 @@ int WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, PWSTR, int nCmdShow)
     if (!EnsureWootingWrapperReady(hInst)) {
         Logger::Critical("MAIN", "EnsureWootingWrapperReady echoue - arret");
         MessageBoxW(nullptr, L"Failed to prepare wooting_analog_wrapper.dll near the executable.", L"DrDre_WASD", MB_ICONERROR | MB_OK);
+        ProfileCache_Close();
+        Persist_Stop();
         Logger::Close(); return 1;
     }
     Logger::Info("MAIN", "EnsureWootingWrapperReady OK");
@@ -251,6 +264,10 @@ int WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, PWSTR, int nCmdShow)
 
     // 7. Nettoyage dans l'ordre inverse
     ShutdownFreeComboSystem();
+    // Tout ce qui est encore en attente part sur le disque, puis le cache
+    // est recompile si un .ini a change pendant la session
+    ProfileCache_ScheduleRebuild();
+    Persist_Stop();
 
     if (gdiStatus == Gdiplus::Ok && gdiToken != 0) {
         Gdiplus::GdiplusShutdown(gdiToken);
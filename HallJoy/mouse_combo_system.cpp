@@ -1,5 +1,7 @@
 #include "mouse_combo_system.h"
 #include "backend.h" // NÉCESSAIRE pour parler à l'UI et au Backend
+#include "input_bus.h"
+#include "key_table.h"
 #include <windows.h>
 #include <iostream>
 #include <vector>
@@ -29,10 +31,10 @@ namespace {
     std::vector<MouseCombo> g_combos;
     std::mutex g_comboMutex; // Protège l'accès à la liste des combos
 
-    // État des boutons de la souris
-    std::atomic<bool> g_rightButtonHeld = false;
-    std::atomic<bool> g_leftButtonHeld = false;
-    std::atomic<bool> g_middleButtonHeld = false;
+    // État des boutons de la souris : état canonique du bus d'entrée (plus de copie locale)
+    bool RightHeld() { return InputBus_IsMouseHeld(InputMouseButton::Right); }
+    bool LeftHeld() { return InputBus_IsMouseHeld(InputMouseButton::Left); }
+    bool MiddleHeld() { return InputBus_IsMouseHeld(InputMouseButton::Middle); }
 
     // --- SYSTÈME ASYNCHRONE (WORKER THREAD) ---
     std::thread g_workerThread;
@@ -163,12 +165,10 @@ namespace MouseComboSystem
 
         // Mise à jour rapide de l'état des boutons
         bool stateChanged = false;
-        if (msg == WM_RBUTTONDOWN) { g_rightButtonHeld = true; stateChanged = true; }
-        else if (msg == WM_RBUTTONUP) { g_rightButtonHeld = false; stateChanged = true; }
-        else if (msg == WM_LBUTTONDOWN) { g_leftButtonHeld = true; stateChanged = true; }
-        else if (msg == WM_LBUTTONUP) { g_leftButtonHeld = false; stateChanged = true; }
-        else if (msg == WM_MBUTTONDOWN) { g_middleButtonHeld = true; stateChanged = true; }
-        else if (msg == WM_MBUTTONUP) { g_middleButtonHeld = false; stateChanged = true; }
+        if (msg == WM_RBUTTONDOWN || msg == WM_RBUTTONUP ||
+            msg == WM_LBUTTONDOWN || msg == WM_LBUTTONUP ||
+            msg == WM_MBUTTONDOWN || msg == WM_MBUTTONUP)
+            stateChanged = true; // l'état maintenu est déjà à jour dans le bus
 
         if (!stateChanged) return;
 
@@ -188,10 +188,10 @@ namespace MouseComboSystem
             // Logique de déclenchement
             switch (combo.trigger) {
             case ComboTriggerType::RightClickHeld_LeftClick:
-                if (g_rightButtonHeld && msg == WM_LBUTTONDOWN) triggered = true;
+                if (RightHeld() && msg == WM_LBUTTONDOWN) triggered = true;
                 break;
             case ComboTriggerType::LeftClickHeld_RightClick:
-                if (g_leftButtonHeld && msg == WM_RBUTTONDOWN) triggered = true;
+                if (LeftHeld() && msg == WM_RBUTTONDOWN) triggered = true;
                 break;
             case ComboTriggerType::DoubleLeftClick:
                 if (msg == WM_LBUTTONDBLCLK) triggered = true;
@@ -226,19 +226,19 @@ namespace MouseComboSystem
             bool active = false;
             switch (combo.trigger) {
                 case ComboTriggerType::RightClickHeld_LeftClick:
-                    active = (g_rightButtonHeld && g_leftButtonHeld);
+                    active = (RightHeld() && LeftHeld());
                     break;
                 case ComboTriggerType::LeftClickHeld_RightClick:
-                    active = (g_leftButtonHeld && g_rightButtonHeld);
+                    active = (LeftHeld() && RightHeld());
                     break;
                 case ComboTriggerType::MiddleClickHeld_LeftClick:
-                    active = (g_middleButtonHeld && g_leftButtonHeld);
+                    active = (MiddleHeld() && LeftHeld());
                     break;
                 case ComboTriggerType::MiddleClickHeld_RightClick:
-                    active = (g_middleButtonHeld && g_rightButtonHeld);
+                    active = (MiddleHeld() && RightHeld());
                     break;
                 case ComboTriggerType::LeftAndRightTogether:
-                    active = (g_leftButtonHeld && g_rightButtonHeld);
+                    active = (LeftHeld() && RightHeld());
                     break;
                 default:
                     break;
@@ -359,9 +359,9 @@ namespace MouseComboSystem
     }
 
     void ProcessKeyboardEvent(UINT msg, WPARAM wParam, LPARAM lParam) {}
-    bool IsRightButtonHeld() { return g_rightButtonHeld; }
-    bool IsLeftButtonHeld() { return g_leftButtonHeld; }
-    bool IsMiddleButtonHeld() { return g_middleButtonHeld; }
+    bool IsRightButtonHeld() { return RightHeld(); }
+    bool IsLeftButtonHeld() { return LeftHeld(); }
+    bool IsMiddleButtonHeld() { return MiddleHeld(); }
     
     bool SaveToFile(const wchar_t* filePath) {
         std::lock_guard<std::mutex> lock(g_comboMutex);
@@ -458,155 +458,6 @@ namespace MouseComboSystem
 }
 
 // --- CONVERSION HID/VK ---
-uint16_t VkToHid(WORD vk) {
-    if (vk >= 'A' && vk <= 'Z') return (uint16_t)(vk - 'A' + 4);
-    if (vk >= '1' && vk <= '9') return (uint16_t)(vk - '1' + 30);
-    if (vk == '0') return 39;
-    
-    switch (vk) {
-        case VK_RETURN: return 40;
-        case VK_ESCAPE: return 41;
-        case VK_BACK: return 42;
-        case VK_TAB: return 43;
-        case VK_SPACE: return 44;
-        case VK_OEM_MINUS: return 45;
-        case VK_OEM_PLUS: return 46;
-        case VK_OEM_4: return 47; // [
-        case VK_OEM_6: return 48; // ]
-        case VK_OEM_5: return 49; // \ 
-        case VK_OEM_1: return 51; // ;
-        case VK_OEM_7: return 52; // '
-        case VK_OEM_3: return 53; // `
-        case VK_OEM_COMMA: return 54;
-        case VK_OEM_PERIOD: return 55;
-        case VK_OEM_2: return 56; // /
-        case VK_CAPITAL: return 57;
-        case VK_F1: return 58;
-        case VK_F2: return 59;
-        case VK_F3: return 60;
-        case VK_F4: return 61;
-        case VK_F5: return 62;
-        case VK_F6: return 63;
-        case VK_F7: return 64;
-        case VK_F8: return 65;
-        case VK_F9: return 66;
-        case VK_F10: return 67;
-        case VK_F11: return 68;
-        case VK_F12: return 69;
-        case VK_PRINT: return 70;
-        case VK_SCROLL: return 71;
-        case VK_PAUSE: return 72;
-        case VK_INSERT: return 73;
-        case VK_HOME: return 74;
-        case VK_PRIOR: return 75;
-        case VK_DELETE: return 76;
-        case VK_END: return 77;
-        case VK_NEXT: return 78;
-        case VK_RIGHT: return 79;
-        case VK_LEFT: return 80;
-        case VK_DOWN: return 81;
-        case VK_UP: return 82;
-        case VK_NUMLOCK: return 83;
-        case VK_DIVIDE: return 84;
-        case VK_MULTIPLY: return 85;
-        case VK_SUBTRACT: return 86;
-        case VK_ADD: return 87;
-        case VK_NUMPAD1: return 89;
-        case VK_NUMPAD2: return 90;
-        case VK_NUMPAD3: return 91;
-        case VK_NUMPAD4: return 92;
-        case VK_NUMPAD5: return 93;
-        case VK_NUMPAD6: return 94;
-        case VK_NUMPAD7: return 95;
-        case VK_NUMPAD8: return 96;
-        case VK_NUMPAD9: return 97;
-        case VK_NUMPAD0: return 98;
-        case VK_DECIMAL: return 99;
-        case VK_LCONTROL: return 224;
-        case VK_LSHIFT: return 225;
-        case VK_LMENU: return 226;
-        case VK_LWIN: return 227;
-        case VK_RCONTROL: return 228;
-        case VK_RSHIFT: return 229;
-        case VK_RMENU: return 230;
-        case VK_RWIN: return 231;
-    }
-    return 0;
-}
-
-WORD HidToVk(uint16_t hid) {
-    if (hid >= 4 && hid <= 29) return (WORD)('A' + (hid - 4));
-    if (hid >= 30 && hid <= 38) return (WORD)('1' + (hid - 30));
-    if (hid == 39) return '0';
-    
-    switch (hid) {
-        case 40: return VK_RETURN;
-        case 41: return VK_ESCAPE;
-        case 42: return VK_BACK;
-        case 43: return VK_TAB;
-        case 44: return VK_SPACE;
-        case 45: return VK_OEM_MINUS;
-        case 46: return VK_OEM_PLUS;
-        case 47: return VK_OEM_4;
-        case 48: return VK_OEM_6;
-        case 49: return VK_OEM_5;
-        case 51: return VK_OEM_1;
-        case 52: return VK_OEM_7;
-        case 53: return VK_OEM_3;
-        case 54: return VK_OEM_COMMA;
-        case 55: return VK_OEM_PERIOD;
-        case 56: return VK_OEM_2;
-        case 57: return VK_CAPITAL;
-        case 58: return VK_F1;
-        case 59: return VK_F2;
-        case 60: return VK_F3;
-        case 61: return VK_F4;
-        case 62: return VK_F5;
-        case 63: return VK_F6;
-        case 64: return VK_F7;
-        case 65: return VK_F8;
-        case 66: return VK_F9;
-        case 67: return VK_F10;
-        case 68: return VK_F11;
-        case 69: return VK_F12;
-        case 70: return VK_PRINT;
-        case 71: return VK_SCROLL;
-        case 72: return VK_PAUSE;
-        case 73: return VK_INSERT;
-        case 74: return VK_HOME;
-        case 75: return VK_PRIOR;
-        case 76: return VK_DELETE;
-        case 77: return VK_END;
-        case 78: return VK_NEXT;
-        case 79: return VK_RIGHT;
-        case 80: return VK_LEFT;
-        case 81: return VK_DOWN;
-        case 82: return VK_UP;
-        case 83: return VK_NUMLOCK;
-        case 84: return VK_DIVIDE;
-        case 85: return VK_MULTIPLY;
-        case 86: return VK_SUBTRACT;
-        case 87: return VK_ADD;
-        case 88: return VK_RETURN; // Numpad Enter
-        case 89: return VK_NUMPAD1;
-        case 90: return VK_NUMPAD2;
-        case 91: return VK_NUMPAD3;
-        case 92: return VK_NUMPAD4;
-        case 93: return VK_NUMPAD5;
-        case 94: return VK_NUMPAD6;
-        case 95: return VK_NUMPAD7;
-        case 96: return VK_NUMPAD8;
-        case 97: return VK_NUMPAD9;
-        case 98: return VK_NUMPAD0;
-        case 99: return VK_DECIMAL;
-        case 224: return VK_LCONTROL;
-        case 225: return VK_LSHIFT;
-        case 226: return VK_LMENU;
-        case 227: return VK_LWIN;
-        case 228: return VK_RCONTROL;
-        case 229: return VK_RSHIFT;
-        case 230: return VK_RMENU;
-        case 231: return VK_RWIN;
-    }
-    return 0;
-}
+// Generated from KEY_TABLE (key_table.h)
+uint16_t VkToHid(WORD vk) { return KeyTable_VkToHid(vk); }
+WORD HidToVk(uint16_t hid) { return KeyTable_HidToVk(hid); }
@@ -5,21 +5,11 @@
 #include <vector>
 #include <string>
 
+#include "combo_action.h" // ComboActionType, ComboAction
+
 // Système de combos de souris pour HallJoy
 // Permet de détecter des combinaisons de clics et déclencher des actions
 
-// Types d'actions possibles
-enum class ComboActionType
-{
-    None = 0,
-    PressKey,           // Appuyer sur une touche
-    ReleaseKey,         // Relâcher une touche
-    TapKey,             // Appuyer puis relâcher rapidement
-    TypeText,           // Taper du texte
-    MouseClick,         // Clic de souris
-    Delay               // Attendre X millisecondes
-};
-
 // Conditions de déclenchement
 enum class ComboTriggerType
 {
@@ -36,16 +26,6 @@ enum class ComboTriggerType
     WheelDown_WithRightHeld         // Molette bas avec clic droit maintenu
 };
 
-// Action à exécuter
-struct ComboAction
-{
-    ComboActionType type = ComboActionType::None;
-    uint16_t keyHid = 0;            // Pour PressKey/ReleaseKey/TapKey
-    std::wstring text;              // Pour TypeText
-    uint32_t delayMs = 0;           // Pour Delay
-    int mouseButton = 0;            // Pour MouseClick (0=left, 1=right, 2=middle)
-};
-
 // Définition d'un combo
 struct MouseCombo
 {
@@ -0,0 +1,156 @@
+// mouse_output.cpp
+#include "mouse_output.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+
+namespace
+{
+    std::mutex g_mutex;
+    MouseOutConfig g_config;
+    std::atomic<uint32_t> g_generation{ 0 };
+    std::atomic<uint64_t> g_boundHids[4]{};     // enabled config's keys, HID bit per chunk
+
+    std::atomic<uint64_t> g_moves{ 0 };
+    std::atomic<uint64_t> g_failures{ 0 };
+    std::atomic<int64_t>  g_totalX{ 0 };
+    std::atomic<int64_t>  g_totalY{ 0 };
+
+    MouseOutCurve SanitizeCurve(const MouseOutCurve& c)
+    {
+        MouseOutCurve out;
+        out.deadzoneM = (uint16_t)std::clamp<int>(c.deadzoneM, 0, 900);
+        out.gammaM = (uint16_t)std::clamp<int>(c.gammaM, 250, 4000);
+        out.maxSpeed = std::clamp<uint32_t>(c.maxSpeed, 1, 20000);
+        return out;
+    }
+
+    // Whole part out of the remainder, toward zero: the remainder stays in (-1, 1)
+    // and a direction reversal first eats what was left of the other way.
+    int32_t TakeWhole(double& acc)
+    {
+        const double whole = std::trunc(acc);
+        acc -= whole;
+        return (int32_t)whole;
+    }
+}
+
+bool RecordingMouseSink::Move(const MouseOutMove& move)
+{
+    m_moves.push_back(move);
+    m_x += move.dx;
+    m_y += move.dy;
+    m_wheel += move.wheel;
+    return true;
+}
+
+MouseOutConfig MouseOut_Sanitize(const MouseOutConfig& cfg)
+{
+    MouseOutConfig out = cfg;
+    for (uint16_t& hid : out.keys)
+        if (hid >= 256) hid = 0;
+    if (out.stickPad < -1 || out.stickPad >= MOUSE_OUT_MAX_PADS) out.stickPad = -1;
+    out.stick = (uint8_t)std::min<int>(out.stick, 1);
+    out.move = SanitizeCurve(cfg.move);
+    out.wheel = SanitizeCurve(cfg.wheel);
+    return out;
+}
+
+float MouseOut_Speed(const MouseOutCurve& c, float deflection)
+{
+    const float dz = (float)c.deadzoneM / 1000.0f;
+    const float d = std::clamp(deflection, 0.0f, 1.0f);
+    if (d <= dz) return 0.0f;
+    const float t = (d - dz) / (1.0f - dz);
+    return (float)c.maxSpeed * std::pow(t, (float)c.gammaM / 1000.0f);
+}
+
+MouseOutMove MouseOut_Integrate(MouseOutAccum& acc, float vx, float vy, float vwheel, float dtSec)
+{
+    const double dt = (double)std::clamp(dtSec, 0.0f, MOUSE_OUT_MAX_DT);
+    acc.x += (double)vx * dt;
+    acc.y += (double)vy * dt;
+    acc.wheel += (double)vwheel * dt;
+
+    MouseOutMove m;
+    m.dx = TakeWhole(acc.x);
+    m.dy = TakeWhole(acc.y);
+    m.wheel = TakeWhole(acc.wheel);
+    return m;
+}
+
+MouseOutMove MouseOut_Step(const MouseOutConfig& cfg, MouseOutAccum& acc, const MouseOutInput& in, float dtSec)
+{
+    if (!cfg.enabled)
+    {
+        acc = MouseOutAccum{};
+        return MouseOutMove{};
+    }
+
+    // Radial: the speed follows the deflection, the direction is kept
+    float vx = 0.0f, vy = 0.0f;
+    const float r = std::sqrt(in.x * in.x + in.y * in.y);
+    if (r > 0.0f)
+    {
+        const float speed = MouseOut_Speed(cfg.move, std::min(r, 1.0f));
+        vx = in.x / r * speed;
+        vy = in.y / r * speed;
+    }
+
+    const float w = std::clamp(in.wheel, -1.0f, 1.0f);
+    const float vw = std::copysign(MouseOut_Speed(cfg.wheel, std::fabs(w)), w) * (float)MOUSE_OUT_WHEEL_DELTA;
+
+    return MouseOut_Integrate(acc, vx, vy, vw, dtSec);
+}
+
+void MouseOut_Set(const MouseOutConfig& cfg)
+{
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_config = MouseOut_Sanitize(cfg);
+
+        uint64_t bound[4]{};
+        if (g_config.enabled)
+            for (uint16_t hid : g_config.keys)
+                if (hid) bound[hid / 64] |= 1ull << (hid % 64);
+        for (int chunk = 0; chunk < 4; ++chunk)
+            g_boundHids[chunk].store(bound[chunk], std::memory_order_relaxed);
+    }
+    g_generation.fetch_add(1, std::memory_order_release);
+}
+
+MouseOutConfig MouseOut_Get()
+{
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_config;
+}
+
+uint32_t MouseOut_ConfigGeneration()
+{
+    return g_generation.load(std::memory_order_acquire);
+}
+
+bool MouseOut_IsHidBound(uint16_t hid)
+{
+    if (hid == 0 || hid >= 256) return false;
+    return (g_boundHids[hid / 64].load(std::memory_order_relaxed) >> (hid % 64)) & 1ull;
+}
+
+void MouseOut_RecordMove(const MouseOutMove& move, bool ok)
+{
+    g_moves.fetch_add(1, std::memory_order_relaxed);
+    if (!ok) { g_failures.fetch_add(1, std::memory_order_relaxed); return; }
+    g_totalX.fetch_add(move.dx, std::memory_order_relaxed);
+    g_totalY.fetch_add(move.dy, std::memory_order_relaxed);
+}
+
+void MouseOut_GetStats(MouseOutStats* out)
+{
+    if (!out) return;
+    out->moves = g_moves.load(std::memory_order_relaxed);
+    out->failures = g_failures.load(std::memory_order_relaxed);
+    out->totalX = g_totalX.load(std::memory_order_relaxed);
+    out->totalY = g_totalY.load(std::memory_order_relaxed);
+}
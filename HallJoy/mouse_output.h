@@ -0,0 +1,137 @@
+// mouse_output.h
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// ============================================================
+// MOUSE OUTPUT
+// Analog keys and / or one pad stick as relative mouse movement and wheel.
+// - Sources: four cursor keys and two wheel keys, read after their curve,
+//   and one stick of one pad as the bindings, SOCD and stick shaping made
+//   it. Both add up; the stick can be centred on the pad (consumed).
+// - Velocity curve: the deflection (radial for the cursor) goes through a
+//   deadzone and an exponent to a speed in pixels / s (wheel: notches / s);
+//   a tick moves speed * dt.
+// - Sub-pixel accumulators: a tick adds its movement to the remainder and
+//   only the whole part is sent, the fraction carries to the next tick.
+//   Slow movement is not lost to truncation and the total sent stays
+//   within one unit of the integral of the speed, however long it runs.
+// - One batched relative move (x, y, wheel) per tick, sent by the realtime
+//   thread through IMouseSink (SendInputMouseSink on Windows).
+// Portable (no Win32).
+// ============================================================
+
+constexpr int   MOUSE_OUT_MAX_PADS = 16;        // = BINDINGS_MAX_GAMEPADS
+constexpr int   MOUSE_OUT_WHEEL_DELTA = 120;    // wheel units per notch (WHEEL_DELTA)
+// A longer tick (stall, resume) moves as if it lasted this long
+constexpr float MOUSE_OUT_MAX_DT = 0.05f;
+
+enum class MouseOutKey : uint8_t
+{
+    Left = 0,
+    Right,
+    Up,
+    Down,
+    WheelUp,
+    WheelDown,
+    Count
+};
+
+struct MouseOutCurve
+{
+    uint16_t deadzoneM = 50;      // 0..900, deflection below = no movement
+    uint16_t gammaM = 1500;       // exponent x1000, 250..4000 (1000 = linear)
+    uint32_t maxSpeed = 1500;     // full deflection: pixels / s (wheel: notches / s), 1..20000
+};
+
+struct MouseOutConfig
+{
+    bool     enabled = false;
+    uint16_t keys[(int)MouseOutKey::Count]{};   // HID 1..255, 0 = none
+    int8_t   stickPad = -1;                     // -1 = no stick source
+    uint8_t  stick = 1;                         // 0 = left, 1 = right
+    bool     consumeStick = true;               // the pad sends the stick centred
+    MouseOutCurve move;
+    MouseOutCurve wheel{ 50, 1000, 12 };
+};
+
+// Deflections of one tick: x right, y down (screen), wheel up = positive.
+struct MouseOutInput
+{
+    float x = 0.0f;       // -1..1
+    float y = 0.0f;
+    float wheel = 0.0f;
+};
+
+// What one tick sends: pixels, wheel in 1/MOUSE_OUT_WHEEL_DELTA notches.
+struct MouseOutMove
+{
+    int32_t dx = 0;
+    int32_t dy = 0;
+    int32_t wheel = 0;
+
+    bool Any() const { return dx != 0 || dy != 0 || wheel != 0; }
+};
+
+// Remainders below one unit, owned by the realtime thread. Double: the
+// per-tick rounding does not add up to a visible drift over hours.
+struct MouseOutAccum
+{
+    double x = 0.0;
+    double y = 0.0;
+    double wheel = 0.0;
+};
+
+class IMouseSink
+{
+public:
+    virtual ~IMouseSink() = default;
+    // The whole move as one OS call. false: not delivered (UIPI, desktop switch).
+    virtual bool Move(const MouseOutMove& move) = 0;
+};
+
+// Test double / simulation sink: records every move and the running totals.
+class RecordingMouseSink : public IMouseSink
+{
+public:
+    bool Move(const MouseOutMove& move) override;
+
+    const std::vector<MouseOutMove>& Moves() const { return m_moves; }
+    int64_t TotalX() const { return m_x; }
+    int64_t TotalY() const { return m_y; }
+    int64_t TotalWheel() const { return m_wheel; }
+    void Clear() { m_moves.clear(); m_x = m_y = m_wheel = 0; }
+
+private:
+    std::vector<MouseOutMove> m_moves;
+    int64_t m_x = 0, m_y = 0, m_wheel = 0;
+};
+
+// Clamps the config to its ranges (keys >= 256 and bad pads cleared).
+MouseOutConfig MouseOut_Sanitize(const MouseOutConfig& cfg);
+// Speed for a deflection 0..1 (units / s).
+float MouseOut_Speed(const MouseOutCurve& c, float deflection);
+// Speeds (units / s) over dtSec into the accumulators; returns the whole part.
+MouseOutMove MouseOut_Integrate(MouseOutAccum& acc, float vx, float vy, float vwheel, float dtSec);
+// Curve + integration of one tick. Disabled: clears the accumulators.
+MouseOutMove MouseOut_Step(const MouseOutConfig& cfg, MouseOutAccum& acc, const MouseOutInput& in, float dtSec);
+
+// ---- Config (any thread) ----
+void           MouseOut_Set(const MouseOutConfig& cfg);
+MouseOutConfig MouseOut_Get();
+// Changes with every Set: the realtime side reloads its copy when it moves.
+uint32_t       MouseOut_ConfigGeneration();
+// Key drives the mouse (output enabled). Lock-free: keyboard hook.
+bool           MouseOut_IsHidBound(uint16_t hid);
+
+// ---- Stats (realtime thread writes, any thread reads) ----
+struct MouseOutStats
+{
+    uint64_t moves = 0;       // sink calls
+    uint64_t failures = 0;
+    int64_t  totalX = 0;      // pixels sent since start
+    int64_t  totalY = 0;
+};
+
+void MouseOut_RecordMove(const MouseOutMove& move, bool ok);
+void MouseOut_GetStats(MouseOutStats* out);
@@ -0,0 +1,73 @@
+// output_coalescer.cpp
+#include "output_coalescer.h"
+
+#include <algorithm>
+
+uint32_t RecordingOutputSink::Send(const OutputEvent* events, uint32_t count)
+{
+    Batch b;
+    b.timeUs = m_nowUs;
+    b.events.assign(events, events + count);
+    m_batches.push_back(std::move(b));
+    return count;
+}
+
+void OutputCoalescer::Add(const OutputEvent& ev)
+{
+    if (m_pendingCount >= kMaxPending)
+        Flush();
+    m_pending[m_pendingCount++] = ev;
+}
+
+bool OutputCoalescer::Text(const wchar_t* text, uint32_t len, const std::atomic<bool>* cancel)
+{
+    const bool burst = (m_pacing.mode == OutputPacingMode::Burst);
+    for (uint32_t k = 0; k < len; ++k)
+    {
+        if (cancel && cancel->load(std::memory_order_relaxed)) return false;
+        Unicode((uint16_t)text[k], false);
+        Unicode((uint16_t)text[k], true);
+        if (!burst) Wait(m_pacing.textCharGapUs);
+    }
+    return true;
+}
+
+void OutputCoalescer::Flush()
+{
+    if (m_pendingCount == 0) return;
+    if (!m_sink) { m_pendingCount = 0; return; }
+
+    const uint32_t chunk = std::max<uint32_t>(1, m_pacing.maxBatch);
+    uint32_t off = 0;
+    while (off < m_pendingCount)
+    {
+        const uint32_t n = std::min(chunk, m_pendingCount - off);
+        m_eventsSent += m_sink->Send(m_pending + off, n);
+        ++m_sendCalls;
+        off += n;
+        if (off < m_pendingCount && m_pacing.batchGapUs > 0)
+            m_sink->SleepUntilUs(m_sink->NowUs() + m_pacing.batchGapUs);
+    }
+    m_pendingCount = 0;
+}
+
+void OutputCoalescer::Wait(uint32_t us)
+{
+    Flush();
+    if (!m_sink || us == 0) return;
+
+    // Absolute deadlines: a slow send does not push every following event back.
+    // If we are already late by more than one gap, restart from now instead of
+    // firing a catch-up burst.
+    const uint64_t now = m_sink->NowUs();
+    uint64_t base = m_cursorUs;
+    if (base == 0 || now > base + us) base = now;
+    m_cursorUs = base + us;
+    m_sink->SleepUntilUs(m_cursorUs);
+}
+
+void OutputCoalescer::Restart()
+{
+    Flush();
+    m_cursorUs = 0;
+}
@@ -0,0 +1,128 @@
+// output_coalescer.h
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// ============================================================
+// OUTPUT COALESCER
+// Macro output stage: every keyboard/mouse event due at the same
+// deadline is collected and handed to the sink in ONE call (one
+// SendInput array on Windows) instead of one call + Sleep per event.
+// Deadlines are absolute (cursor += gap), so pacing does not drift
+// with the cost of each send.
+// Portable: the OS side lives behind IOutputSink (sendinput_sink.h).
+// Single thread (the combo worker); not thread-safe.
+// ============================================================
+
+enum class OutputEventKind : uint8_t
+{
+    Key = 0,       // code = VK, scan = scan code (0 = sink maps it)
+    Unicode,       // code = UTF-16 unit (TypeText)
+    MouseButton,   // code = 0=L, 1=R, 2=M, 3=X1, 4=X2
+};
+
+struct OutputEvent
+{
+    OutputEventKind kind = OutputEventKind::Key;
+    bool up = false;
+    uint16_t code = 0;
+    uint16_t scan = 0;
+};
+
+class IOutputSink
+{
+public:
+    virtual ~IOutputSink() = default;
+    // Emit a batch atomically (one OS call). Returns how many events were accepted.
+    virtual uint32_t Send(const OutputEvent* events, uint32_t count) = 0;
+    // Monotonic clock used for pacing deadlines.
+    virtual uint64_t NowUs() = 0;
+    virtual void SleepUntilUs(uint64_t deadlineUs) = 0;
+};
+
+// Test double / simulation sink: virtual clock, records every batch with its timestamp.
+class RecordingOutputSink : public IOutputSink
+{
+public:
+    struct Batch
+    {
+        uint64_t timeUs = 0;
+        std::vector<OutputEvent> events;
+    };
+
+    uint32_t Send(const OutputEvent* events, uint32_t count) override;
+    uint64_t NowUs() override { return m_nowUs; }
+    void SleepUntilUs(uint64_t deadlineUs) override { if (deadlineUs > m_nowUs) m_nowUs = deadlineUs; }
+
+    void AdvanceUs(uint64_t us) { m_nowUs += us; }
+    const std::vector<Batch>& Batches() const { return m_batches; }
+    void Clear() { m_batches.clear(); }
+
+private:
+    uint64_t m_nowUs = 0;
+    std::vector<Batch> m_batches;
+};
+
+enum class OutputPacingMode : uint8_t
+{
+    Paced = 0,  // legacy timing: one gap after every action, one gap per text character
+    Burst = 1,  // as Paced, but TypeText sends the whole string at once (no gap per character)
+};
+
+// Every action keeps its gap in both modes: games that poll key state must
+// see a press before its release (a PressKey / ReleaseKey pair never shares
+// a batch). Burst is the default: it only changes TypeText, whose Unicode
+// events go to the focused window's text input, not to key state polling.
+// settings.ini [MacroOutput] can set Paced back.
+struct OutputPacing
+{
+    OutputPacingMode mode = OutputPacingMode::Burst;
+    uint32_t actionGapUs = 10000;   // Paced: wait after each action (old Sleep(10))
+    uint32_t tapHoldUs = 30000;     // TapKey / MouseClick: down -> up (games need to see a frame)
+    uint32_t textCharGapUs = 10000; // Paced: wait after each character
+    uint32_t maxBatch = 64;         // events per sink call (very long bursts are split)
+    uint32_t batchGapUs = 0;        // wait between split chunks of the same deadline
+};
+
+class OutputCoalescer
+{
+public:
+    static constexpr uint32_t kMaxPending = 256;
+
+    explicit OutputCoalescer(IOutputSink* sink) : m_sink(sink) {}
+
+    void SetSink(IOutputSink* sink) { Flush(); m_sink = sink; }
+    void SetPacing(const OutputPacing& p) { m_pacing = p; }
+    const OutputPacing& Pacing() const { return m_pacing; }
+
+    // Queue an event on the current deadline (auto-flushes when the buffer is full).
+    void Add(const OutputEvent& ev);
+    void Key(uint16_t vk, uint16_t scan, bool up) { Add({ OutputEventKind::Key, up, vk, scan }); }
+    void Unicode(uint16_t ch, bool up) { Add({ OutputEventKind::Unicode, up, ch, 0 }); }
+    void Mouse(uint8_t button, bool up) { Add({ OutputEventKind::MouseButton, up, button, 0 }); }
+    // Down + up per UTF-16 unit. Paced: textCharGapUs after each one; Burst:
+    // the whole string on the current deadline. cancel (optional) is checked
+    // before each unit; false = cancelled.
+    bool Text(const wchar_t* text, uint32_t len, const std::atomic<bool>* cancel = nullptr);
+
+    // Send everything pending now (split by maxBatch).
+    void Flush();
+    // Flush, then move the deadline cursor by `us` and sleep until it.
+    void Wait(uint32_t us);
+    // Forget the previous deadline: the next Wait() counts from now (start of a run).
+    void Restart();
+
+    uint32_t PendingCount() const { return m_pendingCount; }
+    uint64_t SendCalls() const { return m_sendCalls; }
+    uint64_t EventsSent() const { return m_eventsSent; }
+
+private:
+    IOutputSink* m_sink = nullptr;
+    OutputPacing m_pacing;
+    OutputEvent m_pending[kMaxPending];
+    uint32_t m_pendingCount = 0;
+    uint64_t m_cursorUs = 0;   // deadline of the last Wait (0 = not started)
+    uint64_t m_sendCalls = 0;
+    uint64_t m_eventsSent = 0;
+};
@@ -0,0 +1,61 @@
+// pad_sink.cpp
+#include "pad_sink.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+bool RecordingPadSink::Connect(int count, int* outErr)
+{
+    if (outErr) *outErr = 0;
+    m_pads = std::clamp(count, 1, PAD_SINK_MAX_PADS);
+    return true;
+}
+
+bool RecordingPadSink::Update(int pad, const PadReport& report, int* outErr)
+{
+    if (outErr) *outErr = 0;
+    if (m_broken || pad < 0 || pad >= m_pads)
+    {
+        if (outErr) *outErr = 1;
+        return false;
+    }
+    m_updates.push_back({ pad, report });
+    return true;
+}
+
+bool PadSink_Update(IPadSink& sink, int pad, const PadReport& report, int* outErr, PadSinkStats& stats)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    const bool ok = sink.Update(pad, report, outErr);
+    const uint64_t us = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+
+    int bucket = 0;
+    while (bucket < PAD_SINK_LATENCY_BUCKETS - 1 && us >= (1ull << bucket)) ++bucket;
+
+    ++stats.updates;
+    if (!ok) ++stats.failures;
+    stats.totalUs += us;
+    stats.lastUs = (uint32_t)std::min<uint64_t>(us, UINT32_MAX);
+    stats.maxUs = std::max(stats.maxUs, stats.lastUs);
+    ++stats.latency[bucket];
+    return ok;
+}
+
+uint32_t PadSink_LatencyPercentileUs(const PadSinkStats& stats, float share)
+{
+    uint64_t total = 0;
+    for (uint64_t n : stats.latency) total += n;
+    if (!total) return 0;
+
+    const uint64_t want = (uint64_t)std::ceil(std::clamp(share, 0.0f, 1.0f) * (float)total);
+    uint64_t seen = 0;
+    for (int i = 0; i < PAD_SINK_LATENCY_BUCKETS - 1; ++i)
+    {
+        seen += stats.latency[i];
+        if (seen >= want) return 1u << i;
+    }
+    return stats.maxUs;
+}
@@ -0,0 +1,110 @@
+// pad_sink.h
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// ============================================================
+// PAD SINK
+// Where the virtual gamepad reports go. The realtime thread builds one
+// report per pad and tick and hands the ones worth sending to the sink.
+// - ViGEm (vigem_pad_sink.h): Xbox 360 targets on the ViGEm bus, Windows.
+// - uinput (uinput_pad_sink.h): Xbox-compatible evdev gamepads, Linux. The
+//   events of one report go out in a single write().
+// - RecordingPadSink: keeps every report, for tests and the simulation.
+// PadSink_Update times every update into PadSinkStats, so the write
+// latency of the sinks can be compared on the same pipeline.
+// Portable (no Win32).
+// ============================================================
+
+constexpr int PAD_SINK_MAX_PADS = 16;
+
+// Buttons: same bits as XUSB_GAMEPAD_*
+enum : uint16_t
+{
+    PAD_BTN_DPAD_UP = 0x0001,
+    PAD_BTN_DPAD_DOWN = 0x0002,
+    PAD_BTN_DPAD_LEFT = 0x0004,
+    PAD_BTN_DPAD_RIGHT = 0x0008,
+    PAD_BTN_START = 0x0010,
+    PAD_BTN_BACK = 0x0020,
+    PAD_BTN_LEFT_THUMB = 0x0040,
+    PAD_BTN_RIGHT_THUMB = 0x0080,
+    PAD_BTN_LEFT_SHOULDER = 0x0100,
+    PAD_BTN_RIGHT_SHOULDER = 0x0200,
+    PAD_BTN_GUIDE = 0x0400,
+    PAD_BTN_A = 0x1000,
+    PAD_BTN_B = 0x2000,
+    PAD_BTN_X = 0x4000,
+    PAD_BTN_Y = 0x8000,
+};
+
+// One pad state, XUSB_REPORT layout: sticks -32768..32767 (Y up), triggers 0..255.
+struct PadReport
+{
+    uint16_t buttons = 0;
+    uint8_t  leftTrigger = 0;
+    uint8_t  rightTrigger = 0;
+    int16_t  lx = 0;
+    int16_t  ly = 0;
+    int16_t  rx = 0;
+    int16_t  ry = 0;
+};
+
+class IPadSink
+{
+public:
+    virtual ~IPadSink() = default;
+    virtual const char* Name() const = 0;
+    // Creates count pads (1..PAD_SINK_MAX_PADS). false: nothing is left
+    // connected, outErr = the sink's error code.
+    virtual bool Connect(int count, int* outErr) = 0;
+    virtual void Disconnect() = 0;
+    virtual int  Pads() const = 0;
+    // false: the pad is gone or the sink broke (the caller reconnects).
+    virtual bool Update(int pad, const PadReport& report, int* outErr) = 0;
+};
+
+// Test double / simulation sink: records every update.
+class RecordingPadSink : public IPadSink
+{
+public:
+    struct Sent
+    {
+        int       pad = 0;
+        PadReport report;
+    };
+
+    const char* Name() const override { return "recording"; }
+    bool Connect(int count, int* outErr) override;
+    void Disconnect() override { m_pads = 0; }
+    int  Pads() const override { return m_pads; }
+    bool Update(int pad, const PadReport& report, int* outErr) override;
+
+    // Next updates fail (error 1), as a sink whose bus went away.
+    void SetBroken(bool broken) { m_broken = broken; }
+    const std::vector<Sent>& Updates() const { return m_updates; }
+    void Clear() { m_updates.clear(); }
+
+private:
+    int  m_pads = 0;
+    bool m_broken = false;
+    std::vector<Sent> m_updates;
+};
+
+// Update latency, bucket i: below 2^i us (the last bucket: the rest).
+constexpr int PAD_SINK_LATENCY_BUCKETS = 12;
+
+struct PadSinkStats
+{
+    uint64_t updates = 0;
+    uint64_t failures = 0;
+    uint64_t totalUs = 0;
+    uint32_t maxUs = 0;
+    uint32_t lastUs = 0;
+    uint64_t latency[PAD_SINK_LATENCY_BUCKETS]{};
+};
+
+// sink.Update, timed into stats.
+bool PadSink_Update(IPadSink& sink, int pad, const PadReport& report, int* outErr, PadSinkStats& stats);
+// Latency below which share (0..1) of the updates completed, in us (bucket bound).
+uint32_t PadSink_LatencyPercentileUs(const PadSinkStats& stats, float share);
@@ -0,0 +1,136 @@
+// pad_workers.cpp
+#include "pad_workers.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::vector<std::thread> g_threads;
+    void (*g_threadInit)() = nullptr;
+    std::atomic<bool>      g_stop{ false };
+
+    // Current run. The claim word is (epoch << 32) | (count << 16) | next index:
+    // the count is read with the index it bounds, so a worker still holding the
+    // last claim of a finished run fails it (index == count of that run) even
+    // while the next run's fields are being written. A claim that succeeds keeps
+    // its run open until the index is done, so fn / user read after it are that
+    // run's.
+    constexpr int kClaimShift = 16;
+    constexpr int kClaimMaxItems = 0xFFFF;
+
+    std::atomic<uint32_t>  g_epoch{ 0 };     // workers sleep on it
+    std::atomic<uint64_t>  g_claim{ 0 };
+    std::atomic<PadWorkFn> g_fn{ nullptr };
+    std::atomic<void*>     g_user{ nullptr };
+    std::atomic<int>       g_done{ 0 };
+
+    std::atomic<uint64_t>  g_statRuns{ 0 };
+    std::atomic<uint64_t>  g_statParallelRuns{ 0 };
+    std::atomic<uint64_t>  g_statWorkerItems{ 0 };
+}
+
+// Claims and runs indices of the published run until none is left.
+// Returns the number of indices run.
+static int Drain()
+{
+    int ran = 0;
+    uint64_t c = g_claim.load(std::memory_order_acquire);
+    for (;;)
+    {
+        const int count = (int)((uint32_t)c >> kClaimShift);
+        const int index = (int)(c & kClaimMaxItems);
+        if (index >= count) return ran;
+        if (!g_claim.compare_exchange_weak(c, c + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+            continue;
+
+        g_fn.load(std::memory_order_relaxed)(g_user.load(std::memory_order_relaxed), index);
+        ++ran;
+        if (g_done.fetch_add(1, std::memory_order_acq_rel) + 1 == count)
+            g_done.notify_one();
+        c = g_claim.load(std::memory_order_acquire);
+    }
+}
+
+static void WorkerMain()
+{
+    if (g_threadInit) g_threadInit();
+
+    uint32_t seen = g_epoch.load(std::memory_order_acquire);
+    while (!g_stop.load(std::memory_order_acquire))
+    {
+        g_epoch.wait(seen, std::memory_order_acquire);
+        seen = g_epoch.load(std::memory_order_acquire);
+        if (g_stop.load(std::memory_order_acquire)) break;
+
+        const int ran = Drain();
+        if (ran) g_statWorkerItems.fetch_add((uint64_t)ran, std::memory_order_relaxed);
+    }
+}
+
+void PadWorkers_Start(int workers, void (*threadInit)())
+{
+    PadWorkers_Stop();
+    workers = std::clamp(workers, 0, PAD_WORKERS_MAX);
+
+    g_threadInit = threadInit;
+    g_stop.store(false, std::memory_order_release);
+    for (int i = 0; i < workers; ++i)
+        g_threads.emplace_back(WorkerMain);
+}
+
+void PadWorkers_Stop()
+{
+    if (g_threads.empty()) return;
+
+    g_stop.store(true, std::memory_order_release);
+    g_epoch.fetch_add(1, std::memory_order_acq_rel);
+    g_epoch.notify_all();
+    for (std::thread& t : g_threads)
+        if (t.joinable()) t.join();
+    g_threads.clear();
+}
+
+int PadWorkers_Count()
+{
+    return (int)g_threads.size();
+}
+
+void PadWorkers_Run(int count, PadWorkFn fn, void* user)
+{
+    if (!fn || count <= 0) return;
+    g_statRuns.fetch_add(1, std::memory_order_relaxed);
+
+    if (count < PAD_WORKERS_MIN_ITEMS || count > kClaimMaxItems || g_threads.empty())
+    {
+        for (int i = 0; i < count; ++i) fn(user, i);
+        return;
+    }
+    g_statParallelRuns.fetch_add(1, std::memory_order_relaxed);
+
+    // Publish: job fields, then the claim word of the new epoch, then wake
+    const uint32_t epoch = g_epoch.load(std::memory_order_relaxed) + 1;
+    g_fn.store(fn, std::memory_order_relaxed);
+    g_user.store(user, std::memory_order_relaxed);
+    g_done.store(0, std::memory_order_relaxed);
+    g_claim.store(((uint64_t)epoch << 32) | ((uint64_t)count << kClaimShift), std::memory_order_release);
+    g_epoch.store(epoch, std::memory_order_release);
+    g_epoch.notify_all();
+
+    Drain();
+
+    // Indices still running on a worker
+    for (int done = g_done.load(std::memory_order_acquire); done < count; done = g_done.load(std::memory_order_acquire))
+        g_done.wait(done, std::memory_order_acquire);
+}
+
+void PadWorkers_GetStats(PadWorkersStats* out)
+{
+    if (!out) return;
+    out->workers = (uint32_t)g_threads.size();
+    out->runs = g_statRuns.load(std::memory_order_relaxed);
+    out->parallelRuns = g_statParallelRuns.load(std::memory_order_relaxed);
+    out->workerItems = g_statWorkerItems.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,44 @@
+// pad_workers.h
+#pragma once
+#include <cstdint>
+
+// ============================================================
+// PAD WORKERS
+// Small persistent worker group for the per-pad work of one tick.
+// - PadWorkers_Run(count, fn, user) calls fn(user, i) once for every i in
+//   [0, count) and returns when all are done. The calling thread takes part;
+//   indices are claimed one at a time from a shared counter, so a slow pad
+//   does not hold back the others.
+// - Workers are started once and sleep on an atomic between runs: no thread
+//   creation, lock or allocation per tick.
+// - Below PAD_WORKERS_MIN_ITEMS (or without workers) the caller runs every
+//   index itself, in order: waking a worker costs more than building a few
+//   reports. So does a run of more than 65535 indices (the claim word packs
+//   the count in 16 bits).
+// fn must only touch state owned by its index, or read-only state.
+// Portable (no Win32): the caller sets the workers' priority with threadInit.
+// ============================================================
+
+constexpr int PAD_WORKERS_MAX = 3;
+constexpr int PAD_WORKERS_MIN_ITEMS = 8;
+
+using PadWorkFn = void (*)(void* user, int index);
+
+// workers is clamped to 0..PAD_WORKERS_MAX. threadInit (optional) runs first
+// on every worker thread. Not reentrant with Run.
+void PadWorkers_Start(int workers, void (*threadInit)() = nullptr);
+void PadWorkers_Stop();
+int  PadWorkers_Count();
+
+// One run at a time (the realtime thread).
+void PadWorkers_Run(int count, PadWorkFn fn, void* user);
+
+struct PadWorkersStats
+{
+    uint32_t workers = 0;
+    uint64_t runs = 0;
+    uint64_t parallelRuns = 0;    // runs handed to the workers
+    uint64_t workerItems = 0;     // indices run by a worker (not the caller)
+};
+
+void PadWorkers_GetStats(PadWorkersStats* out);
@@ -0,0 +1,486 @@
+// persist_service.cpp
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "persist_service.h"
+#include "ini_util.h"
+#include "logger.h"
+
+// ============================================================
+// Journal format
+//   header  "DPJ1"
+//   record  u32 length | u64 fnv1a(body) | body = u32 path chars, path (UTF-16LE), file bytes
+// ============================================================
+static const char         kJournalMagic[4] = { 'D', 'P', 'J', '1' };
+static constexpr size_t   kRecordHeaderBytes = 12;             // length + checksum
+static constexpr uint32_t kMaxRecordBytes = 64u * 1024 * 1024; // sanity bound for a damaged length
+
+namespace
+{
+    using Snapshot = std::shared_ptr<const std::vector<uint8_t>>;
+
+    struct PendingFile
+    {
+        std::wstring path;
+        Snapshot     bytes;
+        uint64_t     version = 0;     // bumped by every post
+        uint64_t     journaled = 0;   // version last appended to the journal
+        uint64_t     firstPostUs = 0;
+        uint64_t     dueUs = 0;
+    };
+
+    struct PendingTask
+    {
+        PersistTaskFn fn = nullptr;
+        void*         user = nullptr;
+        uint64_t      firstPostUs = 0;
+        uint64_t      dueUs = 0;
+    };
+
+    std::mutex               g_mutex;
+    std::condition_variable  g_cv;        // work posted / flush / stop
+    std::condition_variable  g_idleCv;    // queue drained
+    std::thread              g_thread;
+    bool                     g_run = false;
+    int                      g_flushers = 0;   // > 0: delays are skipped
+    int                      g_busy = 0;       // items taken out of the queue, being written
+    bool                     g_allOk = true;   // since the last Flush
+    std::vector<PendingFile> g_files;
+    std::vector<PendingTask> g_tasks;
+    PersistStats             g_stats;
+
+    // Journal: only the service thread touches it while it runs
+    std::wstring             g_journalPath;
+    HANDLE                   g_journal = INVALID_HANDLE_VALUE;
+    uint64_t                 g_journalBytes = 0;
+}
+
+static uint64_t NowUs()
+{
+    static const uint64_t freq = [] {
+        LARGE_INTEGER f{};
+        QueryPerformanceFrequency(&f);
+        return (uint64_t)f.QuadPart;
+    }();
+    LARGE_INTEGER c{};
+    QueryPerformanceCounter(&c);
+    const uint64_t t = (uint64_t)c.QuadPart;
+    return (t / freq) * 1000000ull + (t % freq) * 1000000ull / freq;
+}
+
+static uint64_t Fnv1a64(const uint8_t* p, size_t n)
+{
+    uint64_t h = 1469598103934665603ull;
+    for (size_t i = 0; i < n; ++i) { h ^= p[i]; h *= 1099511628211ull; }
+    return h;
+}
+
+static void PutU32(std::vector<uint8_t>& out, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) out.push_back((uint8_t)(v >> (8 * i)));
+}
+
+static uint32_t GetU32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t GetU64(const uint8_t* p)
+{
+    return (uint64_t)GetU32(p) | ((uint64_t)GetU32(p + 4) << 32);
+}
+
+static bool SamePath(const std::wstring& a, const wchar_t* b)
+{
+    return _wcsicmp(a.c_str(), b) == 0;
+}
+
+static void RecordWrite(bool ok, uint64_t queueUs, uint64_t writeUs)
+{
+    ++g_stats.writes;
+    if (!ok) { ++g_stats.failures; g_allOk = false; }
+    g_stats.sumQueueUs += queueUs;
+    g_stats.maxQueueUs = std::max(g_stats.maxQueueUs, (uint32_t)std::min<uint64_t>(queueUs, UINT32_MAX));
+    g_stats.sumWriteUs += writeUs;
+    g_stats.maxWriteUs = std::max(g_stats.maxWriteUs, (uint32_t)std::min<uint64_t>(writeUs, UINT32_MAX));
+}
+
+// ============================================================
+// Journal
+// ============================================================
+static bool JournalTruncate(uint64_t size)
+{
+    LARGE_INTEGER pos{};
+    pos.QuadPart = (LONGLONG)size;
+    bool ok = SetFilePointerEx(g_journal, pos, nullptr, FILE_BEGIN) && SetEndOfFile(g_journal);
+    ok = FlushFileBuffers(g_journal) && ok;
+    g_journalBytes = size;
+    return ok;
+}
+
+static bool JournalAppend(const std::vector<std::pair<std::wstring, Snapshot>>& items)
+{
+    if (g_journal == INVALID_HANDLE_VALUE) return false;
+
+    std::vector<uint8_t> buf;
+    for (const auto& it : items)
+    {
+        const size_t pathBytes = it.first.size() * sizeof(wchar_t);
+        const size_t bodyBytes = 4 + pathBytes + it.second->size();
+        if (bodyBytes > kMaxRecordBytes) continue;
+
+        const size_t at = buf.size();
+        buf.resize(at + kRecordHeaderBytes);
+        PutU32(buf, (uint32_t)it.first.size());
+        const uint8_t* path = (const uint8_t*)it.first.data();
+        buf.insert(buf.end(), path, path + pathBytes);
+        buf.insert(buf.end(), it.second->begin(), it.second->end());
+
+        const uint64_t sum = Fnv1a64(buf.data() + at + kRecordHeaderBytes, bodyBytes);
+        for (int i = 0; i < 4; ++i) buf[at + i] = (uint8_t)(bodyBytes >> (8 * i));
+        for (int i = 0; i < 8; ++i) buf[at + 4 + i] = (uint8_t)(sum >> (8 * i));
+    }
+    if (buf.empty()) return true;
+
+    DWORD written = 0;
+    bool ok = WriteFile(g_journal, buf.data(), (DWORD)buf.size(), &written, nullptr) && written == (DWORD)buf.size();
+    ok = FlushFileBuffers(g_journal) && ok;
+    if (!ok)
+    {
+        // Drop the partial record so later appends stay readable
+        JournalTruncate(g_journalBytes);
+        return false;
+    }
+    g_journalBytes += buf.size();
+    return true;
+}
+
+// Writes back the last snapshot of each file found in the journal.
+static uint32_t ReplayJournal(const wchar_t* path)
+{
+    HANDLE h = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return 0;
+
+    LARGE_INTEGER size{};
+    std::vector<uint8_t> data;
+    bool ok = GetFileSizeEx(h, &size) && size.QuadPart < (256LL << 20);
+    if (ok)
+    {
+        data.resize((size_t)size.QuadPart);
+        DWORD got = 0;
+        ok = data.empty() || (ReadFile(h, data.data(), (DWORD)data.size(), &got, nullptr) && got == (DWORD)data.size());
+    }
+    CloseHandle(h);
+    if (!ok || data.size() < sizeof(kJournalMagic) || memcmp(data.data(), kJournalMagic, sizeof(kJournalMagic)) != 0)
+        return 0;
+
+    struct Last { size_t off = 0; size_t len = 0; };
+    std::unordered_map<std::wstring, Last> last;
+    size_t pos = sizeof(kJournalMagic);
+    while (pos + kRecordHeaderBytes <= data.size())
+    {
+        const uint32_t len = GetU32(data.data() + pos);
+        const uint64_t sum = GetU64(data.data() + pos + 4);
+        const uint8_t* body = data.data() + pos + kRecordHeaderBytes;
+        if (len < 4 || len > kMaxRecordBytes || pos + kRecordHeaderBytes + len > data.size()) break;
+        if (Fnv1a64(body, len) != sum) break;
+
+        const uint32_t chars = GetU32(body);
+        if (4 + (size_t)chars * sizeof(wchar_t) > len) break;
+        std::wstring file(chars, L'\0');
+        memcpy(file.data(), body + 4, (size_t)chars * sizeof(wchar_t));
+
+        const size_t head = 4 + (size_t)chars * sizeof(wchar_t);
+        last[file] = Last{ pos + kRecordHeaderBytes + head, len - head };
+        pos += kRecordHeaderBytes + len;
+    }
+    if (pos != data.size())
+        Logger::Warn("PERSIST", "Journal: enregistrement final endommage ignore");
+
+    uint32_t restored = 0;
+    for (const auto& kv : last)
+    {
+        if (IniUtil_WriteFileAtomic(kv.first.c_str(), data.data() + kv.second.off, kv.second.len))
+            ++restored;
+    }
+    return restored;
+}
+
+// ============================================================
+// Service thread
+// ============================================================
+static void ServiceFunc()
+{
+    std::unique_lock<std::mutex> lk(g_mutex);
+    for (;;)
+    {
+        const uint64_t now = NowUs();
+        const bool hurry = g_flushers > 0 || !g_run;
+
+        // 1. New snapshots go to the journal first. All of them, so the last
+        //    record of a file is never older than the file itself.
+        if (!hurry && g_journal != INVALID_HANDLE_VALUE)
+        {
+            std::vector<std::pair<std::wstring, Snapshot>> items;
+            std::vector<uint64_t> versions;
+            for (const PendingFile& f : g_files)
+            {
+                if (f.journaled == f.version) continue;
+                items.emplace_back(f.path, f.bytes);
+                versions.push_back(f.version);
+            }
+            if (!items.empty())
+            {
+                lk.unlock();
+                const bool ok = JournalAppend(items);
+                lk.lock();
+                if (!ok) Logger::Warn("PERSIST", "Journal: ecriture echouee");
+                g_stats.journalAppends += items.size();
+                // Marked even on failure: the journal is best effort, the write still happens
+                for (size_t i = 0; i < items.size(); ++i)
+                    for (PendingFile& f : g_files)
+                        if (SamePath(f.path, items[i].first.c_str())) f.journaled = versions[i];
+                continue;
+            }
+        }
+
+        // 2. Take out what is due
+        std::vector<PendingFile> files;
+        std::vector<PendingTask> tasks;
+        uint64_t nextDue = UINT64_MAX;
+        for (size_t i = 0; i < g_files.size();)
+        {
+            if (hurry || g_files[i].dueUs <= now) { files.push_back(std::move(g_files[i])); g_files.erase(g_files.begin() + (ptrdiff_t)i); }
+            else { nextDue = std::min(nextDue, g_files[i].dueUs); ++i; }
+        }
+        for (size_t i = 0; i < g_tasks.size();)
+        {
+            if (hurry || g_tasks[i].dueUs <= now) { tasks.push_back(g_tasks[i]); g_tasks.erase(g_tasks.begin() + (ptrdiff_t)i); }
+            else { nextDue = std::min(nextDue, g_tasks[i].dueUs); ++i; }
+        }
+
+        if (!files.empty() || !tasks.empty())
+        {
+            g_busy = 1;
+            lk.unlock();
+
+            struct Result { bool ok; uint64_t queueUs; uint64_t writeUs; };
+            std::vector<Result> results;
+            for (const PendingFile& f : files)
+            {
+                const uint64_t t0 = NowUs();
+                const bool ok = IniUtil_WriteFileAtomic(f.path.c_str(), f.bytes->data(), f.bytes->size());
+                results.push_back({ ok, t0 - f.firstPostUs, NowUs() - t0 });
+                if (!ok) Logger::Error("PERSIST", "Ecriture echouee");
+            }
+            for (const PendingTask& t : tasks)
+            {
+                const uint64_t t0 = NowUs();
+                const bool ok = t.fn(t.user);
+                results.push_back({ ok, t0 - t.firstPostUs, NowUs() - t0 });
+            }
+
+            lk.lock();
+            for (const Result& r : results) RecordWrite(r.ok, r.queueUs, r.writeUs);
+            g_busy = 0;
+
+            // Nothing journaled is still waiting: the journal can be emptied
+            bool journalLive = false;
+            for (const PendingFile& f : g_files) journalLive |= (f.journaled != 0);
+            if (!journalLive && g_journal != INVALID_HANDLE_VALUE && g_journalBytes > sizeof(kJournalMagic))
+            {
+                lk.unlock();
+                JournalTruncate(sizeof(kJournalMagic));
+                lk.lock();
+            }
+            continue;
+        }
+
+        if (g_files.empty() && g_tasks.empty())
+        {
+            g_idleCv.notify_all();
+            if (!g_run) break;
+            g_cv.wait(lk);
+        }
+        else
+        {
+            g_cv.wait_for(lk, std::chrono::microseconds(nextDue - now));
+        }
+    }
+}
+
+// ============================================================
+// API
+// ============================================================
+bool Persist_Start(const wchar_t* journalPath)
+{
+    std::lock_guard<std::mutex> lk(g_mutex);
+    if (g_run) return g_journal != INVALID_HANDLE_VALUE;
+
+    if (journalPath && journalPath[0])
+    {
+        g_journalPath = journalPath;
+        g_stats.replayed += ReplayJournal(journalPath);
+        if (g_stats.replayed)
+            Logger::Warn("PERSIST", "Journal rejoue : " + std::to_string(g_stats.replayed) + " fichier(s) restaure(s)");
+
+        g_journal = CreateFileW(journalPath, GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (g_journal != INVALID_HANDLE_VALUE)
+        {
+            DWORD written = 0;
+            const bool ok = WriteFile(g_journal, kJournalMagic, sizeof(kJournalMagic), &written, nullptr)
+                && written == sizeof(kJournalMagic) && FlushFileBuffers(g_journal);
+            if (!ok) { CloseHandle(g_journal); g_journal = INVALID_HANDLE_VALUE; }
+            g_journalBytes = sizeof(kJournalMagic);
+        }
+        if (g_journal == INVALID_HANDLE_VALUE)
+            Logger::Warn("PERSIST", "Journal indisponible - ecritures sans rejeu apres crash");
+    }
+
+    g_run = true;
+    g_thread = std::thread(ServiceFunc);
+    return g_journal != INVALID_HANDLE_VALUE;
+}
+
+void Persist_Stop()
+{
+    {
+        std::lock_guard<std::mutex> lk(g_mutex);
+        if (!g_run) return;
+        g_run = false; // the thread still drains the queue
+        g_cv.notify_one();
+    }
+    if (g_thread.joinable()) g_thread.join();
+
+    // Everything is on disk: nothing left to replay
+    if (g_journal != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(g_journal);
+        g_journal = INVALID_HANDLE_VALUE;
+        DeleteFileW(g_journalPath.c_str());
+    }
+}
+
+void Persist_PostFile(const wchar_t* path, std::vector<uint8_t>&& bytes, uint32_t delayMs)
+{
+    if (!path || !path[0]) return;
+    Snapshot snap = std::make_shared<const std::vector<uint8_t>>(std::move(bytes));
+    {
+        std::lock_guard<std::mutex> lk(g_mutex);
+        ++g_stats.posts;
+        if (g_run)
+        {
+            const uint64_t now = NowUs();
+            const uint64_t due = now + (uint64_t)delayMs * 1000;
+            auto it = std::find_if(g_files.begin(), g_files.end(), [&](const PendingFile& f) { return SamePath(f.path, path); });
+            if (it != g_files.end())
+            {
+                // The deadline of the burst stays the one of its first post
+                it->bytes = std::move(snap);
+                ++it->version;
+                it->dueUs = std::min(it->dueUs, due);
+                ++g_stats.coalesced;
+            }
+            else
+            {
+                PendingFile f;
+                f.path = path;
+                f.bytes = std::move(snap);
+                f.version = 1;
+                f.firstPostUs = now;
+                f.dueUs = due;
+                g_files.push_back(std::move(f));
+            }
+            g_cv.notify_one();
+            return;
+        }
+    }
+
+    const uint64_t t0 = NowUs();
+    const bool ok = IniUtil_WriteFileAtomic(path, snap->data(), snap->size());
+    std::lock_guard<std::mutex> lk(g_mutex);
+    RecordWrite(ok, 0, NowUs() - t0);
+}
+
+void Persist_PostTask(PersistTaskFn fn, void* user, uint32_t delayMs)
+{
+    if (!fn) return;
+    {
+        std::lock_guard<std::mutex> lk(g_mutex);
+        ++g_stats.posts;
+        if (g_run)
+        {
+            const uint64_t now = NowUs();
+            const uint64_t due = now + (uint64_t)delayMs * 1000;
+            auto it = std::find_if(g_tasks.begin(), g_tasks.end(),
+                [&](const PendingTask& t) { return t.fn == fn && t.user == user; });
+            if (it != g_tasks.end())
+            {
+                it->dueUs = std::min(it->dueUs, due);
+                ++g_stats.coalesced;
+            }
+            else
+            {
+                g_tasks.push_back(PendingTask{ fn, user, now, due });
+            }
+            g_cv.notify_one();
+            return;
+        }
+    }
+
+    const uint64_t t0 = NowUs();
+    const bool ok = fn(user);
+    std::lock_guard<std::mutex> lk(g_mutex);
+    RecordWrite(ok, 0, NowUs() - t0);
+}
+
+bool Persist_Flush()
+{
+    std::unique_lock<std::mutex> lk(g_mutex);
+    ++g_flushers;
+    g_cv.notify_one();
+    g_idleCv.wait(lk, [] { return g_files.empty() && g_tasks.empty() && g_busy == 0; });
+    --g_flushers;
+
+    const bool ok = g_allOk;
+    g_allOk = true;
+    return ok;
+}
+
+void Persist_GetStats(PersistStats* out)
+{
+    if (!out) return;
+    std::lock_guard<std::mutex> lk(g_mutex);
+    *out = g_stats;
+    out->pending = (uint32_t)(g_files.size() + g_tasks.size()) + (uint32_t)g_busy;
+}
+
+void Persist_LogStats()
+{
+    if (!Logger::IsEnabled()) return;
+    PersistStats st;
+    Persist_GetStats(&st);
+    if (st.writes == 0 && st.replayed == 0) return;
+
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+        "posts=%llu coalesced=%llu writes=%llu failed=%llu journal=%llu replayed=%u pending=%u "
+        "avgQueue=%lluus maxQueue=%uus avgWrite=%lluus maxWrite=%uus",
+        (unsigned long long)st.posts, (unsigned long long)st.coalesced, (unsigned long long)st.writes,
+        (unsigned long long)st.failures, (unsigned long long)st.journalAppends, st.replayed, st.pending,
+        (unsigned long long)(st.writes ? st.sumQueueUs / st.writes : 0), st.maxQueueUs,
+        (unsigned long long)(st.writes ? st.sumWriteUs / st.writes : 0), st.maxWriteUs);
+    Logger::Info("PERSIST", buf);
+}
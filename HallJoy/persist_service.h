@@ -0,0 +1,60 @@
+// persist_service.h
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// ============================================================
+// PERSISTENCE SERVICE
+// One background thread owns the settings writes of every module.
+// Callers hand over an immutable snapshot (the file bytes, built in memory
+// on their own thread) and return at once; the UI thread never waits on
+// the disk.
+// - Coalescing: the latest snapshot of a file wins. A file is written
+//   delayMs after its first unwritten post, so a burst of edits makes one
+//   write.
+// - Crash safety: every file goes to "<path>.tmp", FlushFileBuffers, then
+//   MoveFileEx(REPLACE_EXISTING | WRITE_THROUGH). Before that, waiting
+//   snapshots are appended to a small journal (length + checksum records,
+//   flushed). Persist_Start() replays what a crash left in it, a torn last
+//   record is dropped: at most the edit being journaled is lost.
+// - Tasks: modules with their own file format (combo store journal) post
+//   a callback instead. Same coalescing, keyed by (fn, user); not journaled:
+//   the module's format owns its crash recovery, not this service.
+// Without a running service, posts are written synchronously.
+// ============================================================
+
+constexpr uint32_t PERSIST_DEFAULT_DELAY_MS = 250;
+
+using PersistTaskFn = bool (*)(void* user);
+
+// journalPath: replayed (then emptied) before the thread starts, so call it
+// before the first settings load.
+bool Persist_Start(const wchar_t* journalPath);
+void Persist_Stop(); // writes everything pending first
+
+void Persist_PostFile(const wchar_t* path, std::vector<uint8_t>&& bytes, uint32_t delayMs = PERSIST_DEFAULT_DELAY_MS);
+void Persist_PostTask(PersistTaskFn fn, void* user, uint32_t delayMs = 0);
+
+// Blocks until everything posted so far is on disk (delays are skipped).
+// false if a write failed since the previous Flush.
+bool Persist_Flush();
+
+// ---- Metrics ----
+struct PersistStats
+{
+    uint64_t posts = 0;          // snapshots + tasks accepted
+    uint64_t coalesced = 0;      // replaced before reaching the disk
+    uint64_t writes = 0;         // files written + tasks run
+    uint64_t failures = 0;
+    uint64_t journalAppends = 0;
+    uint32_t replayed = 0;       // files restored by Persist_Start
+    uint32_t pending = 0;
+    uint64_t sumQueueUs = 0;     // first unwritten post -> write start (coalescing delay included)
+    uint32_t maxQueueUs = 0;
+    uint64_t sumWriteUs = 0;     // tmp write + flush + rename (task: run time)
+    uint32_t maxWriteUs = 0;
+};
+
+void Persist_GetStats(PersistStats* out);
+// One-line summary through Logger (throttled by caller).
+void Persist_LogStats();
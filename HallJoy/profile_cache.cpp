@@ -0,0 +1,402 @@
+// profile_cache.cpp
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "profile_cache.h"
+#include "ini_doc.h"
+#include "ini_util.h"
+#include "persist_service.h"
+#include "logger.h"
+
+// ============================================================
+// Format (native layout, same build only: IniDoc checks its own part)
+//   header  "DPC1" | u32 version | u32 count | u32 reserved | u64 fnv1a(table)
+//   table   count x Entry
+//   data    per entry: path (UTF-16), compiled document (8-byte aligned)
+// ============================================================
+static const char         kMagic[4] = { 'D', 'P', 'C', '1' };
+static constexpr uint32_t kVersion = 1;
+// Startup rebuild waits a little: no disk competition with the first frames
+static constexpr uint32_t kRebuildDelayMs = 2000;
+
+namespace
+{
+    struct Header
+    {
+        char     magic[4];
+        uint32_t version;
+        uint32_t count;
+        uint32_t reserved;
+        uint64_t tableSum;
+    };
+
+    struct Entry
+    {
+        uint64_t size;
+        uint64_t writeTime;     // FILETIME as u64
+        uint64_t contentHash;   // fnv1a of the file bytes
+        uint64_t pathOff;
+        uint64_t blobOff;
+        uint64_t blobLen;
+        uint32_t pathChars;
+        uint32_t reserved;
+    };
+
+    struct SourceMeta
+    {
+        std::wstring path;
+        uint64_t     size = 0;
+        uint64_t     writeTime = 0;
+        uint64_t     contentHash = 0;
+    };
+
+    std::mutex                g_mutex;
+    std::wstring              g_cachePath;
+    HANDLE                    g_file = INVALID_HANDLE_VALUE;
+    HANDLE                    g_map = nullptr;
+    const uint8_t*            g_view = nullptr;
+    const Entry*              g_entries = nullptr;
+    uint32_t                  g_count = 0;
+    std::vector<SourceMeta>   g_built;     // what the cache file holds
+    std::vector<std::wstring> g_sources;   // every path loaded during startup
+    bool                      g_startup = false; // Open() .. Close()
+    bool                      g_stale = false;
+    ProfileCacheStats         g_stats;
+}
+
+static uint64_t NowUs()
+{
+    static const uint64_t freq = [] {
+        LARGE_INTEGER f{};
+        QueryPerformanceFrequency(&f);
+        return (uint64_t)f.QuadPart;
+    }();
+    LARGE_INTEGER c{};
+    QueryPerformanceCounter(&c);
+    const uint64_t t = (uint64_t)c.QuadPart;
+    return (t / freq) * 1000000ull + (t % freq) * 1000000ull / freq;
+}
+
+static uint64_t Fnv1a64(const uint8_t* p, size_t n)
+{
+    uint64_t h = 1469598103934665603ull;
+    for (size_t i = 0; i < n; ++i) { h ^= p[i]; h *= 1099511628211ull; }
+    return h;
+}
+
+static uint64_t FileTimeU64(const FILETIME& ft)
+{
+    return ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+}
+
+// Directory entry only, the file is not opened.
+static bool StatSource(const wchar_t* path, uint64_t& size, uint64_t& writeTime)
+{
+    WIN32_FILE_ATTRIBUTE_DATA fad{};
+    if (!GetFileAttributesExW(path, GetFileExInfoStandard, &fad)) return false;
+    size = ((uint64_t)fad.nFileSizeHigh << 32) | fad.nFileSizeLow;
+    writeTime = FileTimeU64(fad.ftLastWriteTime);
+    return true;
+}
+
+static bool ReadSource(const wchar_t* path, std::vector<uint8_t>& bytes, SourceMeta& meta)
+{
+    HANDLE h = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size{};
+    FILETIME ft{};
+    bool ok = GetFileSizeEx(h, &size) && GetFileTime(h, nullptr, nullptr, &ft) && size.QuadPart < (64LL << 20);
+    if (ok)
+    {
+        bytes.resize((size_t)size.QuadPart);
+        DWORD got = 0;
+        ok = bytes.empty() || (ReadFile(h, bytes.data(), (DWORD)bytes.size(), &got, nullptr) && got == (DWORD)bytes.size());
+    }
+    CloseHandle(h);
+    if (!ok) return false;
+
+    meta.path = path;
+    meta.size = bytes.size();
+    meta.writeTime = FileTimeU64(ft);
+    meta.contentHash = Fnv1a64(bytes.data(), bytes.size());
+    return true;
+}
+
+static void RememberSource(const wchar_t* path)
+{
+    for (const std::wstring& s : g_sources)
+        if (_wcsicmp(s.c_str(), path) == 0) return;
+    g_sources.emplace_back(path);
+}
+
+static void UnmapLocked()
+{
+    if (g_view) UnmapViewOfFile(g_view);
+    if (g_map) CloseHandle(g_map);
+    if (g_file != INVALID_HANDLE_VALUE) CloseHandle(g_file);
+    g_view = nullptr;
+    g_map = nullptr;
+    g_file = INVALID_HANDLE_VALUE;
+    g_entries = nullptr;
+    g_count = 0;
+}
+
+// ============================================================
+// Rebuild (persistence service thread)
+// ============================================================
+static bool RebuildTask(void*)
+{
+    std::vector<std::wstring> sources;
+    std::wstring cachePath;
+    {
+        std::lock_guard<std::mutex> lk(g_mutex);
+        if (g_view || g_cachePath.empty()) return true; // still mapped: Close() queues it again
+        sources = g_sources;
+        cachePath = g_cachePath;
+
+        // Up to date: same sources, same size and time
+        bool fresh = sources.size() == g_built.size();
+        for (size_t i = 0; fresh && i < sources.size(); ++i)
+        {
+            uint64_t size = 0, time = 0;
+            fresh = _wcsicmp(sources[i].c_str(), g_built[i].path.c_str()) == 0
+                && StatSource(sources[i].c_str(), size, time)
+                && size == g_built[i].size && time == g_built[i].writeTime;
+        }
+        if (fresh) { g_stale = false; return true; }
+    }
+
+    std::vector<SourceMeta> metas;
+    std::vector<std::vector<uint8_t>> blobs;
+    std::vector<uint8_t> bytes;
+    IniDoc doc;
+    for (const std::wstring& path : sources)
+    {
+        SourceMeta meta;
+        if (!ReadSource(path.c_str(), bytes, meta)) continue; // deleted since: dropped
+        doc.ParseBytes(bytes.data(), bytes.size());
+        blobs.emplace_back();
+        doc.SaveCompiled(blobs.back());
+        metas.push_back(std::move(meta));
+    }
+
+    std::vector<Entry> table(metas.size());
+    std::vector<uint8_t> data;
+    uint64_t off = sizeof(Header) + table.size() * sizeof(Entry);
+    for (size_t i = 0; i < metas.size(); ++i)
+    {
+        Entry& e = table[i];
+        e = Entry{};
+        e.size = metas[i].size;
+        e.writeTime = metas[i].writeTime;
+        e.contentHash = metas[i].contentHash;
+        e.pathChars = (uint32_t)metas[i].path.size();
+        e.pathOff = off + data.size();
+        const uint8_t* p = (const uint8_t*)metas[i].path.data();
+        data.insert(data.end(), p, p + metas[i].path.size() * sizeof(wchar_t));
+        data.resize((data.size() + 7) & ~(size_t)7, 0);
+        e.blobOff = off + data.size();
+        e.blobLen = blobs[i].size();
+        data.insert(data.end(), blobs[i].begin(), blobs[i].end());
+        data.resize((data.size() + 7) & ~(size_t)7, 0);
+    }
+
+    Header hdr{};
+    memcpy(hdr.magic, kMagic, sizeof(kMagic));
+    hdr.version = kVersion;
+    hdr.count = (uint32_t)table.size();
+    hdr.tableSum = Fnv1a64((const uint8_t*)table.data(), table.size() * sizeof(Entry));
+
+    std::vector<uint8_t> file;
+    file.reserve((size_t)off + data.size());
+    file.insert(file.end(), (const uint8_t*)&hdr, (const uint8_t*)&hdr + sizeof(hdr));
+    file.insert(file.end(), (const uint8_t*)table.data(), (const uint8_t*)table.data() + table.size() * sizeof(Entry));
+    file.insert(file.end(), data.begin(), data.end());
+
+    // Written without g_mutex: ProfileCache_LoadIni takes it for every load.
+    // The replace is atomic; if Open maps the old file meanwhile, it fails
+    // (file in use) and the next Close rebuilds.
+    const bool ok = IniUtil_WriteFileAtomic(cachePath.c_str(), file.data(), file.size());
+
+    std::lock_guard<std::mutex> lk(g_mutex);
+    if (g_view) return true; // reopened meanwhile (never at runtime): g_built is the mapped file's, next Close retries
+    if (ok)
+    {
+        g_built = std::move(metas);
+        g_stale = false;
+        ++g_stats.rebuilds;
+    }
+    return ok;
+}
+
+// ============================================================
+// API
+// ============================================================
+bool ProfileCache_Open(const wchar_t* cachePath)
+{
+    if (!cachePath || !cachePath[0]) return false;
+    std::lock_guard<std::mutex> lk(g_mutex);
+    if (g_startup) return g_view != nullptr;
+
+    const uint64_t t0 = NowUs();
+    g_cachePath = cachePath;
+    g_built.clear();
+    g_sources.clear();
+    g_startup = true;
+
+    g_file = CreateFileW(cachePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER size{};
+    bool ok = g_file != INVALID_HANDLE_VALUE && GetFileSizeEx(g_file, &size) && size.QuadPart >= (LONGLONG)sizeof(Header);
+    if (ok)
+    {
+        g_map = CreateFileMappingW(g_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        g_view = g_map ? (const uint8_t*)MapViewOfFile(g_map, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        ok = g_view != nullptr;
+    }
+
+    const uint64_t total = ok ? (uint64_t)size.QuadPart : 0;
+    const Header* hdr = ok ? (const Header*)g_view : nullptr;
+    ok = ok && memcmp(hdr->magic, kMagic, sizeof(kMagic)) == 0 && hdr->version == kVersion
+        && sizeof(Header) + (uint64_t)hdr->count * sizeof(Entry) <= total;
+    if (ok)
+    {
+        g_entries = (const Entry*)(g_view + sizeof(Header));
+        g_count = hdr->count;
+        ok = Fnv1a64((const uint8_t*)g_entries, (size_t)g_count * sizeof(Entry)) == hdr->tableSum;
+    }
+    for (uint32_t i = 0; ok && i < g_count; ++i)
+    {
+        const Entry& e = g_entries[i];
+        ok = e.pathOff + (uint64_t)e.pathChars * sizeof(wchar_t) <= total && e.blobOff + e.blobLen <= total;
+        if (!ok) break;
+
+        SourceMeta meta;
+        meta.path.assign((const wchar_t*)(g_view + e.pathOff), e.pathChars);
+        meta.size = e.size;
+        meta.writeTime = e.writeTime;
+        meta.contentHash = e.contentHash;
+        g_built.push_back(std::move(meta));
+    }
+
+    if (!ok)
+    {
+        UnmapLocked();
+        g_built.clear();
+        g_stale = true; // missing or unusable: rebuilt after startup
+    }
+    g_stats.sources = g_count;
+    g_stats.openUs = NowUs() - t0;
+    return ok;
+}
+
+bool ProfileCache_LoadIni(const wchar_t* path, IniDoc& doc)
+{
+    if (!path) return false;
+    std::lock_guard<std::mutex> lk(g_mutex);
+    if (!g_startup)
+        return IniUtil_LoadDoc(path, doc); // runtime loads (profile switch...) are not cached
+
+    RememberSource(path);
+    if (!g_view)
+    {
+        ++g_stats.misses;
+        return IniUtil_LoadDoc(path, doc);
+    }
+
+    const uint64_t t0 = NowUs();
+    bool loaded = false;
+    bool ok = false;
+    for (uint32_t i = 0; i < g_count; ++i)
+    {
+        if (_wcsicmp(g_built[i].path.c_str(), path) != 0) continue;
+
+        const Entry& e = g_entries[i];
+        uint64_t size = 0, time = 0;
+        if (!StatSource(path, size, time) || size != e.size) break;
+
+        if (time == e.writeTime)
+        {
+            loaded = ok = doc.LoadCompiled(g_view + e.blobOff, (size_t)e.blobLen);
+            if (ok) ++g_stats.hits;
+            break;
+        }
+
+        // Touched: the content decides
+        std::vector<uint8_t> bytes;
+        SourceMeta meta;
+        if (!ReadSource(path, bytes, meta)) break;
+        g_stale = true; // new time to record either way
+        if (meta.contentHash == e.contentHash && doc.LoadCompiled(g_view + e.blobOff, (size_t)e.blobLen))
+        {
+            ++g_stats.hashHits;
+        }
+        else
+        {
+            doc.ParseBytes(bytes.data(), bytes.size());
+            ++g_stats.misses;
+        }
+        loaded = ok = true;
+        break;
+    }
+
+    if (!loaded)
+    {
+        g_stale = true;
+        ++g_stats.misses;
+        ok = IniUtil_LoadDoc(path, doc);
+    }
+    g_stats.loadUs += NowUs() - t0;
+    return ok;
+}
+
+void ProfileCache_Close()
+{
+    bool rebuild = false;
+    {
+        std::lock_guard<std::mutex> lk(g_mutex);
+        if (!g_startup) return;
+        g_startup = false;
+        UnmapLocked();
+        rebuild = g_stale && !g_cachePath.empty();
+    }
+    if (rebuild) Persist_PostTask(&RebuildTask, nullptr, kRebuildDelayMs);
+}
+
+void ProfileCache_ScheduleRebuild()
+{
+    ProfileCache_Close(); // startup never finished (early exit): unmap first
+    {
+        std::lock_guard<std::mutex> lk(g_mutex);
+        if (g_cachePath.empty()) return;
+    }
+    Persist_PostTask(&RebuildTask, nullptr);
+}
+
+void ProfileCache_GetStats(ProfileCacheStats* out)
+{
+    if (!out) return;
+    std::lock_guard<std::mutex> lk(g_mutex);
+    *out = g_stats;
+}
+
+void ProfileCache_LogStats()
+{
+    if (!Logger::IsEnabled()) return;
+    ProfileCacheStats st;
+    ProfileCache_GetStats(&st);
+
+    char buf[192];
+    snprintf(buf, sizeof(buf), "sources=%u hits=%u hashHits=%u misses=%u open=%lluus load=%lluus rebuilds=%u",
+        st.sources, st.hits, st.hashHits, st.misses,
+        (unsigned long long)st.openUs, (unsigned long long)st.loadUs, st.rebuilds);
+    Logger::Info("PROFILE_CACHE", buf);
+}
@@ -0,0 +1,46 @@
+// profile_cache.h
+#pragma once
+#include <cstdint>
+
+class IniDoc;
+
+// ============================================================
+// PROFILE CACHE - profile.cache
+// Compiled copy of the INI files read at startup (settings.ini, bindings,
+// layout presets). Each source is stored in IniDoc's compiled form, parsed
+// and indexed, so a hit is a memory copy out of the mapped file: no
+// decoding, no parsing, no key hashing. The module loaders still run on
+// the document, so clamping and validation stay in one place.
+// - Validation per source: size + last write time from the directory entry
+//   (no read). When only the time moved, the content hash decides (the file
+//   is read and hashed, but still not parsed).
+// - Open() maps the cache read-only, Close() unmaps it once startup is done.
+//   A miss or a stale source queues a rebuild on the persistence service
+//   thread; the file is replaced atomically.
+// - free_combos.dat is not cached: it is already a binary journal.
+// ============================================================
+
+bool ProfileCache_Open(const wchar_t* cachePath);
+// Through the cache when it is open and the entry is valid, IniUtil_LoadDoc otherwise.
+// The paths loaded between Open() and Close() make the next rebuild; later
+// loads (profile switch at runtime) go straight to the file.
+bool ProfileCache_LoadIni(const wchar_t* path, IniDoc& doc);
+// Unmaps the cache; queues a rebuild if a source missed or changed.
+void ProfileCache_Close();
+// Queues a rebuild that only writes if a source changed since the cache was
+// built (call at shutdown, after the last settings post).
+void ProfileCache_ScheduleRebuild();
+
+struct ProfileCacheStats
+{
+    uint32_t sources = 0;    // entries in the mapped cache
+    uint32_t hits = 0;       // size + time match
+    uint32_t hashHits = 0;   // time changed, same content
+    uint32_t misses = 0;
+    uint64_t openUs = 0;     // map + header check
+    uint64_t loadUs = 0;     // all LoadIni calls while open
+    uint32_t rebuilds = 0;
+};
+
+void ProfileCache_GetStats(ProfileCacheStats* out);
+void ProfileCache_LogStats();
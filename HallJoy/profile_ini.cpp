@@ -2,10 +2,10 @@
 #include <windows.h>
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 #include <algorithm>
-#include <fstream> // for fast file writing
 
 #if defined(_MSC_VER)
 #include <intrin.h>
@@ -13,14 +13,17 @@
 
 #include "profile_ini.h"
 #include "bindings.h"
-#include "ini_util.h"
+#include "binding_layers.h"
+#include "ini_doc.h"
+#include "persist_service.h"
+#include "profile_cache.h"
 
 // -----------------------------------------------------------------------------
 // Helpers
 // -----------------------------------------------------------------------------
-static uint16_t ReadU16(const wchar_t* section, const wchar_t* key, uint16_t def, const wchar_t* path)
+static uint16_t ReadU16(const IniDoc& doc, const wchar_t* section, const wchar_t* key, uint16_t def)
 {
-    return (uint16_t)GetPrivateProfileIntW(section, key, def, path);
+    return (uint16_t)doc.GetInt(section, key, def);
 }
 
 static bool IsSep(wchar_t c)
@@ -61,13 +64,13 @@ static void ParseHidList256(const wchar_t* s, std::vector<uint16_t>& out)
     out.erase(std::unique(out.begin(), out.end()), out.end());
 }
 
-static std::wstring MaskToCsvForPad(int padIndex, GameButton b)
+static std::wstring MaskToCsv(const uint64_t (&mask)[4])
 {
     std::wstring s;
 
     for (int chunk = 0; chunk < 4; ++chunk)
     {
-        uint64_t bits = Bindings_GetButtonMaskChunkForPad(padIndex, b, chunk);
+        uint64_t bits = mask[chunk];
         if (!bits) continue;
 
 #if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
@@ -97,176 +100,295 @@ static std::wstring MaskToCsvForPad(int padIndex, GameButton b)
     return s;
 }
 
-// NEW: Optimized saving using streams instead of slow WritePrivateProfileString
-static bool Profile_SaveIni_Internal(const wchar_t* path)
+static const wchar_t* const kAxisNames[4] = { L"LX", L"LY", L"RX", L"RY" };
+static const wchar_t* const kButtonNames[BINDINGS_BUTTON_COUNT] = {
+    L"A", L"B", L"X", L"Y", L"LB", L"RB", L"Back", L"Start", L"Guide", L"LS", L"RS",
+    L"DpadUp", L"DpadDown", L"DpadLeft", L"DpadRight",
+};
+
+static bool PadBindingsEmpty(const PadBindings& pb)
 {
-    std::wofstream f(path, std::ios::out | std::ios::trunc);
-    if (!f.is_open()) return false;
+    uint64_t any = pb.zones.keyCount;
+    for (const AxisBinding& a : pb.axes) any |= a.minusHid | a.plusHid;
+    for (uint16_t t : pb.triggers) any |= t;
+    for (const auto& b : pb.buttons)
+        for (uint64_t c : b) any |= c;
+    return any == 0;
+}
 
-    f << L"[General]\n";
-    f << L"Pads=" << BINDINGS_MAX_GAMEPADS << L"\n\n";
+// "300:X,950:Y+LS": threshold (0..1000) then the buttons held in that zone
+static std::wstring ZonesToString(const ZoneKey& k)
+{
+    std::wstring s;
+    for (int i = 0; i < k.count && i < BINDINGS_MAX_ZONES; ++i)
+    {
+        if (!s.empty()) s += L",";
+        s += std::to_wstring((unsigned)k.thresholdM[i]) + L":";
+        bool first = true;
+        for (int b = 0; b < BINDINGS_BUTTON_COUNT; ++b)
+        {
+            if (!(k.buttons[i] & (1u << b))) continue;
+            if (!first) s += L"+";
+            s += kButtonNames[b];
+            first = false;
+        }
+    }
+    return s;
+}
 
-    for (int pad = 0; pad < BINDINGS_MAX_GAMEPADS; ++pad)
+static void ZonesFromString(const std::wstring& str, ZoneKey& k)
+{
+    k.count = 0;
+    size_t pos = 0;
+    while (pos < str.size() && k.count < BINDINGS_MAX_ZONES)
     {
-        const int padNum = pad + 1;
+        size_t end = str.find(L',', pos);
+        if (end == std::wstring::npos) end = str.size();
+        const std::wstring item = str.substr(pos, end - pos);
+        pos = end + 1;
+
+        const size_t colon = item.find(L':');
+        if (colon == std::wstring::npos) continue;
+        const int t = (int)wcstol(item.substr(0, colon).c_str(), nullptr, 10);
+
+        uint16_t buttons = 0;
+        size_t bp = colon + 1;
+        while (bp < item.size())
+        {
+            size_t be = item.find(L'+', bp);
+            if (be == std::wstring::npos) be = item.size();
+            std::wstring name = item.substr(bp, be - bp);
+            name.erase(std::remove_if(name.begin(), name.end(), IsSep), name.end());
+            for (int b = 0; b < BINDINGS_BUTTON_COUNT; ++b)
+                if (_wcsicmp(name.c_str(), kButtonNames[b]) == 0) buttons |= (uint16_t)(1u << b);
+            bp = be + 1;
+        }
 
-        // [PadN_Axes]
-        f << L"[Pad" << padNum << L"_Axes]\n";
-        auto wAxis = [&](Axis a, const wchar_t* name)
-            {
-                AxisBinding b = Bindings_GetAxisForPad(pad, a);
-                f << name << L"_Minus=" << b.minusHid << L"\n";
-                f << name << L"_Plus=" << b.plusHid << L"\n";
-            };
-        wAxis(Axis::LX, L"LX");
-        wAxis(Axis::LY, L"LY");
-        wAxis(Axis::RX, L"RX");
-        wAxis(Axis::RY, L"RY");
-        f << L"\n";
-
-        // [PadN_Triggers]
-        f << L"[Pad" << padNum << L"_Triggers]\n";
-        f << L"LT=" << Bindings_GetTriggerForPad(pad, Trigger::LT) << L"\n";
-        f << L"RT=" << Bindings_GetTriggerForPad(pad, Trigger::RT) << L"\n";
-        f << L"\n";
-
-        // [PadN_Buttons]
-        f << L"[Pad" << padNum << L"_Buttons]\n";
-        auto wBtn = [&](GameButton b, const wchar_t* name)
-            {
-                std::wstring csv = MaskToCsvForPad(pad, b);
-                f << name << L"=" << csv << L"\n";
-            };
-
-        wBtn(GameButton::A, L"A");
-        wBtn(GameButton::B, L"B");
-        wBtn(GameButton::X, L"X");
-        wBtn(GameButton::Y, L"Y");
-        wBtn(GameButton::LB, L"LB");
-        wBtn(GameButton::RB, L"RB");
-        wBtn(GameButton::Back, L"Back");
-        wBtn(GameButton::Start, L"Start");
-        wBtn(GameButton::Guide, L"Guide");
-        wBtn(GameButton::LS, L"LS");
-        wBtn(GameButton::RS, L"RS");
-
-        wBtn(GameButton::DpadUp, L"DpadUp");
-        wBtn(GameButton::DpadDown, L"DpadDown");
-        wBtn(GameButton::DpadLeft, L"DpadLeft");
-        wBtn(GameButton::DpadRight, L"DpadRight");
-        f << L"\n";
+        k.thresholdM[k.count] = (uint16_t)std::clamp(t, 0, 1000);
+        k.buttons[k.count] = buttons;
+        ++k.count;
     }
+    Bindings_SanitizeZoneKey(k);
+}
 
-    return true;
+// [<prefix>_Axes] / [<prefix>_Triggers] / [<prefix>_Buttons]
+static void WritePadBindings(IniDoc& doc, const wchar_t* prefix, const PadBindings& pb)
+{
+    const std::wstring secAxes = std::wstring(prefix) + L"_Axes";
+    const std::wstring secTriggers = std::wstring(prefix) + L"_Triggers";
+    const std::wstring secButtons = std::wstring(prefix) + L"_Buttons";
+
+    for (int a = 0; a < 4; ++a)
+    {
+        doc.SetUInt(secAxes, std::wstring(kAxisNames[a]) + L"_Minus", pb.axes[a].minusHid);
+        doc.SetUInt(secAxes, std::wstring(kAxisNames[a]) + L"_Plus", pb.axes[a].plusHid);
+    }
+
+    doc.SetUInt(secTriggers, L"LT", pb.triggers[(int)Trigger::LT]);
+    doc.SetUInt(secTriggers, L"RT", pb.triggers[(int)Trigger::RT]);
+
+    for (int b = 0; b < BINDINGS_BUTTON_COUNT; ++b)
+        doc.Set(secButtons, kButtonNames[b], MaskToCsv(pb.buttons[b]));
+
+    // [<prefix>_Zones] Keys, Key<i>_Hid, Key<i>_Zones (only when some key has zones)
+    if (pb.zones.keyCount)
+    {
+        const std::wstring secZones = std::wstring(prefix) + L"_Zones";
+        doc.SetInt(secZones, L"Keys", pb.zones.keyCount);
+        for (int i = 0; i < pb.zones.keyCount; ++i)
+        {
+            const std::wstring k = L"Key" + std::to_wstring(i + 1);
+            doc.SetUInt(secZones, k + L"_Hid", pb.zones.keys[i].hid);
+            doc.Set(secZones, k + L"_Zones", ZonesToString(pb.zones.keys[i]));
+        }
+    }
 }
 
-bool Profile_SaveIni(const wchar_t* path)
+// [PadN_Layers] Keys, Key<i>_Hid, Key<i>_Layer, Key<i>_Toggle, then one
+// binding block per layer: [PadN_L<l>_Axes] ... (only pads that have layers)
+static void WritePadLayers(IniDoc& doc, int pad, const PadLayers& pl)
 {
-    if (!path) return false;
+    wchar_t sec[32]{};
+    swprintf_s(sec, L"Pad%d_Layers", pad + 1);
+    doc.SetInt(sec, L"Keys", pl.keyCount);
+    for (int i = 0; i < pl.keyCount && i < BINDING_LAYER_MAX_KEYS; ++i)
+    {
+        const std::wstring k = L"Key" + std::to_wstring(i + 1);
+        doc.SetUInt(sec, k + L"_Hid", pl.keys[i].hid);
+        doc.SetUInt(sec, k + L"_Layer", pl.keys[i].layer);
+        doc.SetInt(sec, k + L"_Toggle", pl.keys[i].mode == LayerKeyMode::Toggle ? 1 : 0);
+    }
 
-    std::wstring tmp = std::wstring(path) + L".tmp";
+    for (int l = 1; l < BINDING_LAYERS; ++l)
+    {
+        wchar_t prefix[32]{};
+        swprintf_s(prefix, L"Pad%d_L%d", pad + 1, l);
+        WritePadBindings(doc, prefix, pl.layers[l - 1]);
+    }
+}
 
-    // Save to tmp file first
-    if (!Profile_SaveIni_Internal(tmp.c_str()))
+// Whole profile built in memory, written once. Pads past the last bound one
+// are left out (at least the 4 the editor shows).
+static void Profile_SaveIni_Internal(IniDoc& doc)
+{
+    const BindingsSnapshot live = Bindings_Snapshot();
+    PadBindings pads[BINDINGS_MAX_GAMEPADS];
+    int padCount = 4;
+    for (int pad = 0; pad < BINDINGS_MAX_GAMEPADS; ++pad)
     {
-        DeleteFileW(tmp.c_str());
-        return false;
+        Bindings_ReadPad(*live, pad, pads[pad]);
+        if (!PadBindingsEmpty(pads[pad]) || !BindingLayers_GetPad(pad).IsEmpty())
+            padCount = std::max(padCount, pad + 1);
     }
 
-    // Atomic replace
-    return IniUtil_AtomicReplace(tmp.c_str(), path);
+    doc.SetInt(L"General", L"Pads", padCount);
+
+    for (int pad = 0; pad < padCount; ++pad)
+    {
+        wchar_t prefix[32]{};
+        swprintf_s(prefix, L"Pad%d", pad + 1);
+        WritePadBindings(doc, prefix, pads[pad]);
+
+        const PadLayers layers = BindingLayers_GetPad(pad);
+        if (!layers.IsEmpty())
+            WritePadLayers(doc, pad, layers);
+    }
 }
 
-static void LoadButtonCsvForPad(int padIndex, const wchar_t* section, GameButton b, const wchar_t* keyName, const wchar_t* path)
+bool Profile_SaveIni(const wchar_t* path)
 {
-    wchar_t buf[2048]{};
-    DWORD n = GetPrivateProfileStringW(section, keyName, L"", buf, (DWORD)(sizeof(buf) / sizeof(buf[0])), path);
+    if (!path) return false;
+
+    // The profile is fully generated: start from an empty document
+    IniDoc doc;
+    Profile_SaveIni_Internal(doc);
 
-    if (n == 0 || buf[0] == 0)
+    // Written by the persistence service (tmp file + atomic replace)
+    Persist_PostFile(path, doc.SerializeBytes());
+    return true;
+}
+
+static void ReadButtonCsv(const IniDoc& doc, const wchar_t* section, const wchar_t* keyName, uint64_t (&out)[4])
+{
+    const std::wstring csv = doc.GetString(section, keyName);
+    if (csv.empty())
         return;
 
     std::vector<uint16_t> hids;
-    ParseHidList256(buf, hids);
+    ParseHidList256(csv.c_str(), hids);
     for (uint16_t hid : hids)
-        Bindings_AddButtonHidForPad(padIndex, b, hid);
+        out[hid / 64] |= 1ULL << (hid % 64);
 }
 
-// NEW: full reset of axes/triggers + button masks (HID<256)
-static void ResetAllBindingsBeforeLoad()
+static void ReadPadBindingsFromSections(const IniDoc& doc, const wchar_t* prefix, PadBindings& out)
 {
-    // Axes/triggers could contain HID>=256; clear those explicitly for each pad.
-    for (int pad = 0; pad < BINDINGS_MAX_GAMEPADS; ++pad)
+    const std::wstring secAxes = std::wstring(prefix) + L"_Axes";
+    const std::wstring secTriggers = std::wstring(prefix) + L"_Triggers";
+    const std::wstring secButtons = std::wstring(prefix) + L"_Buttons";
+
+    for (int a = 0; a < 4; ++a)
     {
-        Bindings_SetAxisMinusForPad(pad, Axis::LX, 0); Bindings_SetAxisPlusForPad(pad, Axis::LX, 0);
-        Bindings_SetAxisMinusForPad(pad, Axis::LY, 0); Bindings_SetAxisPlusForPad(pad, Axis::LY, 0);
-        Bindings_SetAxisMinusForPad(pad, Axis::RX, 0); Bindings_SetAxisPlusForPad(pad, Axis::RX, 0);
-        Bindings_SetAxisMinusForPad(pad, Axis::RY, 0); Bindings_SetAxisPlusForPad(pad, Axis::RY, 0);
+        std::wstring k1 = std::wstring(kAxisNames[a]) + L"_Minus";
+        std::wstring k2 = std::wstring(kAxisNames[a]) + L"_Plus";
+        out.axes[a].minusHid = ReadU16(doc, secAxes.c_str(), k1.c_str(), 0);
+        out.axes[a].plusHid = ReadU16(doc, secAxes.c_str(), k2.c_str(), 0);
+    }
+
+    out.triggers[(int)Trigger::LT] = ReadU16(doc, secTriggers.c_str(), L"LT", 0);
+    out.triggers[(int)Trigger::RT] = ReadU16(doc, secTriggers.c_str(), L"RT", 0);
+
+    for (int b = 0; b < BINDINGS_BUTTON_COUNT; ++b)
+        ReadButtonCsv(doc, secButtons.c_str(), kButtonNames[b], out.buttons[b]);
 
-        Bindings_SetTriggerForPad(pad, Trigger::LT, 0);
-        Bindings_SetTriggerForPad(pad, Trigger::RT, 0);
+    const std::wstring secZones = std::wstring(prefix) + L"_Zones";
+    if (!doc.HasSection(secZones)) return;
+    const int keys = std::clamp(doc.GetInt(secZones, L"Keys", 0), 0, BINDINGS_MAX_ZONE_KEYS);
+    for (int i = 0; i < keys; ++i)
+    {
+        const std::wstring k = L"Key" + std::to_wstring(i + 1);
+        ZoneKey zk;
+        zk.hid = ReadU16(doc, secZones.c_str(), (k + L"_Hid").c_str(), 0);
+        if (zk.hid == 0 || zk.hid >= 256) continue;
+        bool dup = false;
+        for (int j = 0; j < out.zones.keyCount; ++j) dup |= out.zones.keys[j].hid == zk.hid;
+        if (dup) continue;
+        ZonesFromString(doc.GetString(secZones, k + L"_Zones"), zk);
+        if (zk.count) out.zones.keys[out.zones.keyCount++] = zk;
     }
+}
 
-    // Clear button masks + any axis/trigger references for HID<256 (fast enough, only 255 ops)
-    for (uint16_t hid = 1; hid < 256; ++hid)
-        Bindings_ClearHid(hid);
+void Profile_ReadBindings(const IniDoc& doc, PadBindings (&out)[BINDINGS_MAX_GAMEPADS])
+{
+    for (int pad = 0; pad < BINDINGS_MAX_GAMEPADS; ++pad)
+    {
+        out[pad] = PadBindings{};
+
+        wchar_t prefix[32]{};
+        swprintf_s(prefix, L"Pad%d", pad + 1);
+        ReadPadBindingsFromSections(doc, prefix, out[pad]);
+    }
 }
 
-static void LoadPadBindingsFromSections(int padIndex, const wchar_t* axesSection, const wchar_t* triggersSection, const wchar_t* buttonsSection, const wchar_t* path)
+void Profile_ReadLayers(const IniDoc& doc, PadLayers (&out)[BINDINGS_MAX_GAMEPADS])
 {
-    auto rAxis = [&](Axis a, const wchar_t* name)
+    for (int pad = 0; pad < BINDINGS_MAX_GAMEPADS; ++pad)
+    {
+        PadLayers& pl = out[pad];
+        pl = PadLayers{};
+
+        wchar_t sec[32]{};
+        swprintf_s(sec, L"Pad%d_Layers", pad + 1);
+        if (!doc.HasSection(sec)) continue;
+
+        const int keys = std::clamp(doc.GetInt(sec, L"Keys", 0), 0, BINDING_LAYER_MAX_KEYS);
+        for (int i = 0; i < keys; ++i)
+        {
+            const std::wstring k = L"Key" + std::to_wstring(i + 1);
+            LayerKey lk;
+            lk.hid = ReadU16(doc, sec, (k + L"_Hid").c_str(), 0);
+            lk.layer = (uint8_t)std::clamp(doc.GetInt(sec, k + L"_Layer", 1), 1, BINDING_LAYERS - 1);
+            lk.mode = doc.GetInt(sec, k + L"_Toggle", 0) ? LayerKeyMode::Toggle : LayerKeyMode::Hold;
+            if (lk.hid == 0 || lk.hid >= 256) continue;
+            pl.keys[pl.keyCount++] = lk;
+        }
+
+        for (int l = 1; l < BINDING_LAYERS; ++l)
         {
-            std::wstring k1 = std::wstring(name) + L"_Minus";
-            std::wstring k2 = std::wstring(name) + L"_Plus";
-            uint16_t minusHid = ReadU16(axesSection, k1.c_str(), 0, path);
-            uint16_t plusHid = ReadU16(axesSection, k2.c_str(), 0, path);
-            Bindings_SetAxisMinusForPad(padIndex, a, minusHid);
-            Bindings_SetAxisPlusForPad(padIndex, a, plusHid);
-        };
-
-    rAxis(Axis::LX, L"LX");
-    rAxis(Axis::LY, L"LY");
-    rAxis(Axis::RX, L"RX");
-    rAxis(Axis::RY, L"RY");
-
-    Bindings_SetTriggerForPad(padIndex, Trigger::LT, ReadU16(triggersSection, L"LT", 0, path));
-    Bindings_SetTriggerForPad(padIndex, Trigger::RT, ReadU16(triggersSection, L"RT", 0, path));
-
-    LoadButtonCsvForPad(padIndex, buttonsSection, GameButton::A, L"A", path);
-    LoadButtonCsvForPad(padIndex, buttonsSection, GameButton::B, L"B", path);
-    LoadButtonCsvForPad(padIndex, buttonsSection, GameButton::X, L"X", path);
-    LoadButtonCsvForPad(padIndex, buttonsSection, GameButton::Y, L"Y", path);
-    LoadButtonCsvForPad(padIndex, buttonsSection, GameButton::LB, L"LB", path);
-    LoadButtonCsvForPad(padIndex, buttonsSection, GameButton::RB, L"RB", path);
-    LoadButtonCsvForPad(padIndex, buttonsSection, GameButton::Back, L"Back", path);
-    LoadButtonCsvForPad(padIndex, buttonsSection, GameButton::Start, L"Start", path);
-    LoadButtonCsvForPad(padIndex, buttonsSection, GameButton::Guide, L"Guide", path);
-    LoadButtonCsvForPad(padIndex, buttonsSection, GameButton::LS, L"LS", path);
-    LoadButtonCsvForPad(padIndex, buttonsSection, GameButton::RS, L"RS", path);
-
-    LoadButtonCsvForPad(padIndex, buttonsSection, GameButton::DpadUp, L"DpadUp", path);
-    LoadButtonCsvForPad(padIndex, buttonsSection, GameButton::DpadDown, L"DpadDown", path);
-    LoadButtonCsvForPad(padIndex, buttonsSection, GameButton::DpadLeft, L"DpadLeft", path);
-    LoadButtonCsvForPad(padIndex, buttonsSection, GameButton::DpadRight, L"DpadRight", path);
+            wchar_t prefix[32]{};
+            swprintf_s(prefix, L"Pad%d_L%d", pad + 1, l);
+            ReadPadBindingsFromSections(doc, prefix, pl.layers[l - 1]);
+        }
+    }
 }
 
 bool Profile_LoadIni(const wchar_t* path)
 {
     if (!path) return false;
 
-    DWORD attr = GetFileAttributesW(path);
-    if (attr == INVALID_FILE_ATTRIBUTES) return false;
+    IniDoc doc;
+    if (!ProfileCache_LoadIni(path, doc)) return false;
 
-    ResetAllBindingsBeforeLoad();
+    // Every pad with its layers (~50 KB): off the stack
+    struct LoadedPads
+    {
+        PadBindings pads[BINDINGS_MAX_GAMEPADS];
+        PadLayers   layers[BINDINGS_MAX_GAMEPADS];
+    };
+    auto loaded = std::make_unique<LoadedPads>();
+    PadBindings (&pads)[BINDINGS_MAX_GAMEPADS] = loaded->pads;
+    PadLayers (&layers)[BINDINGS_MAX_GAMEPADS] = loaded->layers;
+    Profile_ReadBindings(doc, pads);
+    Profile_ReadLayers(doc, layers);
+
+    // One publish per pad: the realtime side never sees a half-loaded pad
+    Bindings_ClearAll();
 
     for (int pad = 0; pad < BINDINGS_MAX_GAMEPADS; ++pad)
     {
-        wchar_t secAxes[32]{};
-        wchar_t secTriggers[32]{};
-        wchar_t secButtons[32]{};
-        swprintf_s(secAxes, L"Pad%d_Axes", pad + 1);
-        swprintf_s(secTriggers, L"Pad%d_Triggers", pad + 1);
-        swprintf_s(secButtons, L"Pad%d_Buttons", pad + 1);
-        LoadPadBindingsFromSections(pad, secAxes, secTriggers, secButtons, path);
+        if (!PadBindingsEmpty(pads[pad]))
+            Bindings_SetPad(pad, pads[pad]);
+
+        BindingLayers_SetPad(pad, layers[pad]);
     }
 
     return true;
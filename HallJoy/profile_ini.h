@@ -1,5 +1,16 @@
 #pragma once
 #include <windows.h>
 
+#include "bindings.h"
+#include "binding_layers.h"
+
+class IniDoc;
+
 bool Profile_SaveIni(const wchar_t* path);
-bool Profile_LoadIni(const wchar_t* path);
\ No newline at end of file
+bool Profile_LoadIni(const wchar_t* path);
+
+// Bindings of a profile document, without touching the live bindings
+// (app profile images).
+void Profile_ReadBindings(const IniDoc& doc, PadBindings (&out)[BINDINGS_MAX_GAMEPADS]);
+// Layers of a profile document ([PadN_Layers], [PadN_L<l>_...]), same rule.
+void Profile_ReadLayers(const IniDoc& doc, PadLayers (&out)[BINDINGS_MAX_GAMEPADS]);
@@ -1586,6 +1586,13 @@ static void Remap_SetScrollY(HWND hWnd, RemapPanelState* st, int newScrollY)
     InvalidateRect(hWnd, &tr, FALSE);
 }
 
+// Virtual pads in use: the editor shows the first REMAP_MAX_GAMEPADS, pads past
+// them come from settings.ini (VirtualGamepads) and the bindings profile.
+static int Remap_TotalPadCount(const RemapPanelState* st)
+{
+    return std::max(st->gamepadPacks, Settings_GetVirtualGamepadCount());
+}
+
 static bool Remap_AddGamepadPack(HWND hWnd, RemapPanelState* st, HINSTANCE hInst, HFONT hFont)
 {
     if (!st) return false;
@@ -2162,9 +2169,9 @@ static LRESULT CALLBACK RemapPanelProc(HWND hWnd, UINT msg, WPARAM wParam, LPARA
 
         int savedPacks = std::clamp(Settings_GetVirtualGamepadCount(), 1, REMAP_MAX_GAMEPADS);
         Remap_RebuildGamepadPacks(hWnd, st, cs->hInstance, hFont, savedPacks);
-        Settings_SetVirtualGamepadCount(st->gamepadPacks);
+        Settings_SetVirtualGamepadCount(Remap_TotalPadCount(st));
         Settings_SetVirtualGamepadsEnabled(true);
-        Backend_SetVirtualGamepadCount(st->gamepadPacks);
+        Backend_SetVirtualGamepadCount(Remap_TotalPadCount(st));
         Backend_SetVirtualGamepadsEnabled(true);
         Remap_UpdateAddGamepadButtonText(st);
 
@@ -2203,18 +2210,20 @@ static LRESULT CALLBACK RemapPanelProc(HWND hWnd, UINT msg, WPARAM wParam, LPARA
                 {
                     HINSTANCE hInst = (HINSTANCE)GetWindowLongPtrW(hWnd, GWLP_HINSTANCE);
                     HFONT hFont = (HFONT)GetStockObject(DEFAULT_GUI_FONT);
-                    int newCount = std::clamp(st->gamepadPacks - 1, 1, REMAP_MAX_GAMEPADS);
+                    const int totalPads = Remap_TotalPadCount(st);
+                    int newCount = std::clamp(totalPads - 1, 1, REMAP_MAX_GAMEPADS);
 
-                    // Remove selected pad and keep following pads (shift left).
-                    Bindings_RemovePadAndCompact(packIdx, st->gamepadPacks);
+                    // Remove selected pad and keep following pads (shift left),
+                    // pads the editor does not show included.
+                    Bindings_RemovePadAndCompact(packIdx, totalPads);
                     Profile_SaveIni(AppPaths_BindingsIni().c_str());
-                    Settings_SetVirtualGamepadCount(newCount);
-                    Backend_SetVirtualGamepadCount(newCount);
+                    Settings_SetVirtualGamepadCount(totalPads - 1);
+                    Backend_SetVirtualGamepadCount(totalPads - 1);
 
                     Remap_RebuildGamepadPacksBatched(hWnd, st, hInst, hFont, newCount);
 
-                    Settings_SetVirtualGamepadCount(st->gamepadPacks);
-                    Backend_SetVirtualGamepadCount(st->gamepadPacks);
+                    Settings_SetVirtualGamepadCount(std::max(st->gamepadPacks, totalPads - 1));
+                    Backend_SetVirtualGamepadCount(std::max(st->gamepadPacks, totalPads - 1));
                     Remap_UpdateAddGamepadButtonText(st);
                     Remap_RequestSettingsSave(hWnd);
                     InvalidateRect(hWnd, nullptr, FALSE);
@@ -0,0 +1,105 @@
+// sendinput_sink.cpp
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include <algorithm>
+
+#include "sendinput_sink.h"
+
+static const ULONG_PTR kInjectMarker = (ULONG_PTR)0x484A4D43ULL;
+
+static const LONGLONG g_qpcFreq = []() {
+    LARGE_INTEGER f{};
+    QueryPerformanceFrequency(&f);
+    return f.QuadPart > 0 ? f.QuadPart : 1;
+}();
+
+static INPUT ToInput(const OutputEvent& ev)
+{
+    INPUT i{};
+    switch (ev.kind)
+    {
+    case OutputEventKind::Key:
+        i.type = INPUT_KEYBOARD;
+        i.ki.wVk = ev.code;
+        i.ki.wScan = ev.scan ? ev.scan : (WORD)MapVirtualKeyW(ev.code, MAPVK_VK_TO_VSC);
+        i.ki.dwFlags = KEYEVENTF_SCANCODE | (ev.up ? KEYEVENTF_KEYUP : 0);
+        break;
+    case OutputEventKind::Unicode:
+        i.type = INPUT_KEYBOARD;
+        i.ki.wScan = ev.code;
+        i.ki.dwFlags = KEYEVENTF_UNICODE | (ev.up ? KEYEVENTF_KEYUP : 0);
+        break;
+    case OutputEventKind::MouseButton:
+        i.type = INPUT_MOUSE;
+        switch (ev.code)
+        {
+        case 0: i.mi.dwFlags = ev.up ? MOUSEEVENTF_LEFTUP : MOUSEEVENTF_LEFTDOWN; break;
+        case 1: i.mi.dwFlags = ev.up ? MOUSEEVENTF_RIGHTUP : MOUSEEVENTF_RIGHTDOWN; break;
+        case 2: i.mi.dwFlags = ev.up ? MOUSEEVENTF_MIDDLEUP : MOUSEEVENTF_MIDDLEDOWN; break;
+        case 3: i.mi.dwFlags = ev.up ? MOUSEEVENTF_XUP : MOUSEEVENTF_XDOWN; i.mi.mouseData = XBUTTON1; break;
+        case 4: i.mi.dwFlags = ev.up ? MOUSEEVENTF_XUP : MOUSEEVENTF_XDOWN; i.mi.mouseData = XBUTTON2; break;
+        }
+        break;
+    }
+    // Every INPUT, not only keys: the hooks skip what carries the marker
+    if (i.type == INPUT_KEYBOARD) i.ki.dwExtraInfo = kInjectMarker;
+    else                          i.mi.dwExtraInfo = kInjectMarker;
+    return i;
+}
+
+uint32_t SendInputSink::Send(const OutputEvent* events, uint32_t count)
+{
+    INPUT inputs[OutputCoalescer::kMaxPending];
+    uint32_t sent = 0;
+    while (sent < count)
+    {
+        const uint32_t n = std::min<uint32_t>(count - sent, OutputCoalescer::kMaxPending);
+        for (uint32_t k = 0; k < n; ++k)
+            inputs[k] = ToInput(events[sent + k]);
+        const UINT ok = SendInput(n, inputs, sizeof(INPUT));
+        sent += ok;
+        if (ok < n) break; // blocked by UIPI or input desktop switch
+    }
+    return sent;
+}
+
+uint64_t SendInputSink::NowUs()
+{
+    LARGE_INTEGER c{};
+    QueryPerformanceCounter(&c);
+    const uint64_t q = (uint64_t)c.QuadPart, f = (uint64_t)g_qpcFreq;
+    return (q / f) * 1000000ull + ((q % f) * 1000000ull) / f;
+}
+
+void SendInputSink::SleepUntilUs(uint64_t deadlineUs)
+{
+    for (;;)
+    {
+        const uint64_t now = NowUs();
+        if (now >= deadlineUs) return;
+        const uint64_t left = deadlineUs - now;
+        if (left > 2000) Sleep((DWORD)((left - 1000) / 1000));
+        else Sleep(0);
+    }
+}
+
+bool SendInputMouseSink::Move(const MouseOutMove& move)
+{
+    INPUT i{};
+    i.type = INPUT_MOUSE;
+    if (move.dx || move.dy)
+    {
+        i.mi.dx = move.dx;
+        i.mi.dy = move.dy;
+        i.mi.dwFlags |= MOUSEEVENTF_MOVE;
+    }
+    if (move.wheel)
+    {
+        i.mi.mouseData = (DWORD)move.wheel;
+        i.mi.dwFlags |= MOUSEEVENTF_WHEEL;
+    }
+    if (!i.mi.dwFlags) return true;
+    i.mi.dwExtraInfo = kInjectMarker;
+    return SendInput(1, &i, sizeof(INPUT)) == 1;
+}
@@ -0,0 +1,28 @@
+// sendinput_sink.h
+#pragma once
+#include <cstdint>
+
+#include "output_coalescer.h"
+#include "mouse_output.h"
+
+// Windows output sink: one SendInput() per batch.
+// Every event (keys, text, mouse) carries the HallJoy marker in dwExtraInfo so our own hooks
+// recognise them as injected.
+class SendInputSink : public IOutputSink
+{
+public:
+    uint32_t Send(const OutputEvent* events, uint32_t count) override;
+    uint64_t NowUs() override;
+    // Sleep() for the coarse part, then yield until the deadline (sub-ms accuracy).
+    void SleepUntilUs(uint64_t deadlineUs) override;
+};
+
+// Windows mouse sink: the tick's relative move and wheel as one SendInput()
+// (MOUSEEVENTF_MOVE | MOUSEEVENTF_WHEEL in one MOUSEINPUT), HallJoy marker in
+// dwExtraInfo. Relative moves still go through pointer acceleration
+// ("Enhance pointer precision"), as a real mouse does.
+class SendInputMouseSink : public IMouseSink
+{
+public:
+    bool Move(const MouseOutMove& move) override;
+};
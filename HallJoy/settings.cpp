@@ -1,6 +1,7 @@
 // settings.cpp
 #define NOMINMAX
 #include "settings.h"
+#include "bindings.h"
 
 #include <algorithm>
 #include <atomic>
@@ -351,7 +352,7 @@ UINT Settings_GetUIRefreshMs()
 
 void Settings_SetVirtualGamepadCount(int count)
 {
-    count = std::clamp(count, 1, 4);
+    count = std::clamp(count, 1, BINDINGS_MAX_GAMEPADS);
     g_virtualGamepadCount.store(count, std::memory_order_release);
 }
 
@@ -77,6 +77,7 @@ bool Settings_GetSnappyJoystick();
 
 // Last Key Priority for opposite directions on the same axis.
 // When both directions are pressed, the most recently pressed direction wins.
+// Both toggles are the Global SOCD mode; socd.h overrides them per pad / axis.
 void Settings_SetLastKeyPriority(bool on);
 bool Settings_GetLastKeyPriority();
 void Settings_SetLastKeyPrioritySensitivity(float v01); // 0.02..0.95
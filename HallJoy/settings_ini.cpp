@@ -11,14 +11,30 @@
 #include <unordered_set>
 #include <algorithm>
 #include <limits>
+#include <memory>
 
 #include "settings_ini.h"
 #include "settings.h"
 #include "key_settings.h"
-#include "ini_util.h"
+#include "actuation.h"
+#include "socd.h"
+#include "stick_shape.h"
+#include "ini_doc.h"
 #include "keyboard_layout.h"
+#include "persist_service.h"
+#include "profile_cache.h"
+#include "profile_ini.h"
+#include "app_profiles.h"
+#include "analog_devices.h"
+#include "mouse_output.h"
+#include "free_combo_system.h"
+#include "win_util.h"
 #include "logger.h"
 
+// settings.ini as last loaded / saved (UI thread): saves edit it in memory, comments
+// and unknown keys stay, and no save has to read the file again.
+static IniDoc g_settingsDoc;
+
 static float ClampF(float v, float lo, float hi)
 {
     if (v < lo) return lo;
@@ -26,107 +42,58 @@ static float ClampF(float v, float lo, float hi)
     return v;
 }
 
-static void IniWriteFloat1000(const wchar_t* section, const wchar_t* key, float v, const wchar_t* path)
+static void IniWriteFloat1000(IniDoc& doc, const wchar_t* section, const wchar_t* key, float v)
 {
-    int iv = (int)lroundf(v * 1000.0f);
-    wchar_t buf[32]{};
-    swprintf_s(buf, L"%d", iv);
-    WritePrivateProfileStringW(section, key, buf, path);
+    doc.SetInt(section, key, (int)lroundf(v * 1000.0f));
 }
 
-static float IniReadFloat1000(const wchar_t* section, const wchar_t* key, float def, const wchar_t* path)
+static float IniReadFloat1000(const IniDoc& doc, const wchar_t* section, const wchar_t* key, float def)
 {
     int defI = (int)lroundf(def * 1000.0f);
-    int iv = GetPrivateProfileIntW(section, key, defI, path);
+    int iv = doc.GetInt(section, key, defI);
     return (float)iv / 1000.0f;
 }
 
-static void IniWriteU32(const wchar_t* section, const wchar_t* key, UINT v, const wchar_t* path)
+static void IniWriteU32(IniDoc& doc, const wchar_t* section, const wchar_t* key, UINT v)
 {
-    wchar_t buf[32]{};
-    swprintf_s(buf, L"%u", (unsigned)v);
-    WritePrivateProfileStringW(section, key, buf, path);
+    doc.SetUInt(section, key, (uint32_t)v);
 }
 
-static UINT IniReadU32(const wchar_t* section, const wchar_t* key, UINT def, const wchar_t* path)
+static UINT IniReadU32(const IniDoc& doc, const wchar_t* section, const wchar_t* key, UINT def)
 {
-    return (UINT)GetPrivateProfileIntW(section, key, (int)def, path);
+    return (UINT)doc.GetInt(section, key, (int)def);
 }
 
-static void IniWriteI32(const wchar_t* section, const wchar_t* key, int v, const wchar_t* path)
+static void IniWriteI32(IniDoc& doc, const wchar_t* section, const wchar_t* key, int v)
 {
-    wchar_t buf[32]{};
-    swprintf_s(buf, L"%d", v);
-    WritePrivateProfileStringW(section, key, buf, path);
+    doc.SetInt(section, key, v);
 }
 
-static int IniReadI32(const wchar_t* section, const wchar_t* key, int def, const wchar_t* path)
+static int IniReadI32(const IniDoc& doc, const wchar_t* section, const wchar_t* key, int def)
 {
-    wchar_t buf[64]{};
-    GetPrivateProfileStringW(section, key, L"", buf, (DWORD)_countof(buf), path);
-    if (buf[0] == 0)
+    std::wstring_view v;
+    if (!doc.TryGet(section, key, v) || v.empty())
         return def;
-    return _wtoi(buf);
+    return doc.GetInt(section, key, def);
 }
 
-static bool ReadSectionKeys(const wchar_t* section, const wchar_t* path, std::vector<std::wstring>& keysOut)
+// HID prefix of a per-key entry ("<hid>_<field>"), 0 if none.
+static int HidPrefix(std::wstring_view key)
 {
-    keysOut.clear();
-    if (!section || !path) return false;
-
-    // GetPrivateProfileSectionW truncates output if buffer is too small.
-    // If truncated, return value is typically (cap - 2).
-    // We grow the buffer until it fits or we hit a sane limit.
-    DWORD cap = 64 * 1024;
-    const DWORD CAP_MAX = 4 * 1024 * 1024; // 4 MB safety cap
-
-    std::vector<wchar_t> buf;
-
-    for (;;)
+    int v = 0;
+    for (wchar_t c : key)
     {
-        buf.assign(cap, 0);
-
-        DWORD n = GetPrivateProfileSectionW(section, buf.data(), cap, path);
-        if (n == 0)
-        {
-            // section missing or empty
-            return false;
-        }
-
-        // If truncated, n will be close to cap-2 (no guaranteed contract, but this is the common behavior).
-        // Also ensure double-null termination exists.
-        bool likelyTruncated = (n >= cap - 2);
-
-        if (!likelyTruncated)
-        {
-            // parse normally
-            const wchar_t* p = buf.data();
-            while (*p)
-            {
-                const wchar_t* eq = wcschr(p, L'=');
-                if (eq && eq > p)
-                    keysOut.emplace_back(p, (size_t)(eq - p));
-
-                p += wcslen(p) + 1;
-            }
-            return true;
-        }
-
-        // grow buffer
-        if (cap >= CAP_MAX)
-        {
-            // still truncated at maximum size -> fail fast (better than silently losing settings)
-            return false;
-        }
-
-        cap = std::min<DWORD>(cap * 2, CAP_MAX);
+        if (c < L'0' || c > L'9') break;
+        v = v * 10 + (c - L'0');
+        if (v > 65535) return 0;
     }
+    return v;
 }
 
-static void KeySettingsIni_SaveToSettingsIni(const wchar_t* path)
+static void KeySettingsIni_SaveToSettingsIni(IniDoc& doc)
 {
     // rewrite the whole section
-    WritePrivateProfileStringW(L"KeyDeadzone", nullptr, nullptr, path);
+    doc.EraseSection(L"KeyDeadzone");
 
     std::vector<std::pair<uint16_t, KeyDeadzone>> all;
     KeySettings_Enumerate(all);
@@ -158,47 +125,46 @@ static void KeySettingsIni_SaveToSettingsIni(const wchar_t* path)
         swprintf_s(kC1W, L"%u_C1W", (unsigned)hid);
         swprintf_s(kC2W, L"%u_C2W", (unsigned)hid);
 
-        IniWriteI32(L"KeyDeadzone", kUse, ks.useUnique ? 1 : 0, path);
+        IniWriteI32(doc, L"KeyDeadzone", kUse, ks.useUnique ? 1 : 0);
 
-        if (ks.invert) IniWriteI32(L"KeyDeadzone", kInv, 1, path);
-        if (ks.curveMode != 0) IniWriteI32(L"KeyDeadzone", kMode, (int)ks.curveMode, path);
+        if (ks.invert) IniWriteI32(doc, L"KeyDeadzone", kInv, 1);
+        if (ks.curveMode != 0) IniWriteI32(doc, L"KeyDeadzone", kMode, (int)ks.curveMode);
 
-        IniWriteI32(L"KeyDeadzone", kLow, (int)lroundf(ks.low * 1000.0f), path);
-        IniWriteI32(L"KeyDeadzone", kHigh, (int)lroundf(ks.high * 1000.0f), path);
+        IniWriteI32(doc, L"KeyDeadzone", kLow, (int)lroundf(ks.low * 1000.0f));
+        IniWriteI32(doc, L"KeyDeadzone", kHigh, (int)lroundf(ks.high * 1000.0f));
 
         if (ks.antiDeadzone > 0.001f)
-            IniWriteI32(L"KeyDeadzone", kADZ, (int)lroundf(ks.antiDeadzone * 1000.0f), path);
+            IniWriteI32(doc, L"KeyDeadzone", kADZ, (int)lroundf(ks.antiDeadzone * 1000.0f));
 
         if (ks.outputCap < 0.999f)
-            IniWriteI32(L"KeyDeadzone", kCap, (int)lroundf(ks.outputCap * 1000.0f), path);
+            IniWriteI32(doc, L"KeyDeadzone", kCap, (int)lroundf(ks.outputCap * 1000.0f));
 
-        IniWriteI32(L"KeyDeadzone", kC1X, (int)lroundf(ks.cp1_x * 1000.0f), path);
-        IniWriteI32(L"KeyDeadzone", kC1Y, (int)lroundf(ks.cp1_y * 1000.0f), path);
-        IniWriteI32(L"KeyDeadzone", kC2X, (int)lroundf(ks.cp2_x * 1000.0f), path);
-        IniWriteI32(L"KeyDeadzone", kC2Y, (int)lroundf(ks.cp2_y * 1000.0f), path);
+        IniWriteI32(doc, L"KeyDeadzone", kC1X, (int)lroundf(ks.cp1_x * 1000.0f));
+        IniWriteI32(doc, L"KeyDeadzone", kC1Y, (int)lroundf(ks.cp1_y * 1000.0f));
+        IniWriteI32(doc, L"KeyDeadzone", kC2X, (int)lroundf(ks.cp2_x * 1000.0f));
+        IniWriteI32(doc, L"KeyDeadzone", kC2Y, (int)lroundf(ks.cp2_y * 1000.0f));
 
         float w1 = ClampF(ks.cp1_w, 0.0f, 1.0f);
         float w2 = ClampF(ks.cp2_w, 0.0f, 1.0f);
-        IniWriteI32(L"KeyDeadzone", kC1W, (int)lroundf(w1 * 1000.0f), path);
-        IniWriteI32(L"KeyDeadzone", kC2W, (int)lroundf(w2 * 1000.0f), path);
+        IniWriteI32(doc, L"KeyDeadzone", kC1W, (int)lroundf(w1 * 1000.0f));
+        IniWriteI32(doc, L"KeyDeadzone", kC2W, (int)lroundf(w2 * 1000.0f));
     }
 }
 
-static void KeySettingsIni_LoadFromSettingsIni(const wchar_t* path)
+static void KeySettingsIni_LoadFromSettingsIni(const IniDoc& doc)
 {
     KeySettings_ClearAll();
 
-    std::vector<std::wstring> keys;
-    if (!ReadSectionKeys(L"KeyDeadzone", path, keys)) return;
+    std::vector<std::wstring_view> keys;
+    doc.Keys(L"KeyDeadzone", keys);
+    if (keys.empty()) return;
 
     std::unordered_set<uint16_t> hids;
     hids.reserve(keys.size());
 
-    for (const auto& k : keys)
+    for (std::wstring_view k : keys)
     {
-        size_t us = k.find(L'_');
-        std::wstring prefix = (us == std::wstring::npos) ? k : k.substr(0, us);
-        int hidI = _wtoi(prefix.c_str());
+        int hidI = HidPrefix(k);
         if (hidI > 0 && hidI <= 65535)
             hids.insert((uint16_t)hidI);
     }
@@ -227,23 +193,23 @@ static void KeySettingsIni_LoadFromSettingsIni(const wchar_t* path)
         swprintf_s(kC1W, L"%u_C1W", (unsigned)hid);
         swprintf_s(kC2W, L"%u_C2W", (unsigned)hid);
 
-        int use = GetPrivateProfileIntW(L"KeyDeadzone", kUse, 0, path);
-        int inv = GetPrivateProfileIntW(L"KeyDeadzone", kInv, 0, path);
-        int mode = GetPrivateProfileIntW(L"KeyDeadzone", kMode, 0, path);
+        int use = doc.GetInt(L"KeyDeadzone", kUse, 0);
+        int inv = doc.GetInt(L"KeyDeadzone", kInv, 0);
+        int mode = doc.GetInt(L"KeyDeadzone", kMode, 0);
 
-        int lowM = GetPrivateProfileIntW(L"KeyDeadzone", kLow, 80, path);
-        int higM = GetPrivateProfileIntW(L"KeyDeadzone", kHigh, 900, path);
+        int lowM = doc.GetInt(L"KeyDeadzone", kLow, 80);
+        int higM = doc.GetInt(L"KeyDeadzone", kHigh, 900);
 
-        int adzM = GetPrivateProfileIntW(L"KeyDeadzone", kADZ, 0, path);
-        int capM = GetPrivateProfileIntW(L"KeyDeadzone", kCap, 1000, path);
+        int adzM = doc.GetInt(L"KeyDeadzone", kADZ, 0);
+        int capM = doc.GetInt(L"KeyDeadzone", kCap, 1000);
 
-        int c1x = GetPrivateProfileIntW(L"KeyDeadzone", kC1X, 380, path);
-        int c1y = GetPrivateProfileIntW(L"KeyDeadzone", kC1Y, 330, path);
-        int c2x = GetPrivateProfileIntW(L"KeyDeadzone", kC2X, 680, path);
-        int c2y = GetPrivateProfileIntW(L"KeyDeadzone", kC2Y, 660, path);
+        int c1x = doc.GetInt(L"KeyDeadzone", kC1X, 380);
+        int c1y = doc.GetInt(L"KeyDeadzone", kC1Y, 330);
+        int c2x = doc.GetInt(L"KeyDeadzone", kC2X, 680);
+        int c2y = doc.GetInt(L"KeyDeadzone", kC2Y, 660);
 
-        int c1w = GetPrivateProfileIntW(L"KeyDeadzone", kC1W, 1000, path);
-        int c2w = GetPrivateProfileIntW(L"KeyDeadzone", kC2W, 1000, path);
+        int c1w = doc.GetInt(L"KeyDeadzone", kC1W, 1000);
+        int c2w = doc.GetInt(L"KeyDeadzone", kC2W, 1000);
 
         KeyDeadzone ks;
         ks.useUnique = (use != 0);
@@ -267,47 +233,407 @@ static void KeySettingsIni_LoadFromSettingsIni(const wchar_t* path)
     }
 }
 
+// [KeyActuation] <hid>_Mode (0 fixed, 1 rapid trigger, 2 continuous), _Act, _Rel, _RTD, _RTU
+// in 1/1000 of travel. Only keys that differ from the default are written.
+static void KeyActuationIni_SaveToSettingsIni(IniDoc& doc)
+{
+    doc.EraseSection(L"KeyActuation");
+
+    std::vector<std::pair<uint16_t, KeyActuation>> all;
+    Actuation_Enumerate(all);
+
+    for (const auto& kv : all)
+    {
+        const unsigned hid = kv.first;
+        const KeyActuation& a = kv.second;
+        wchar_t k[64];
+
+        swprintf_s(k, L"%u_Mode", hid); IniWriteI32(doc, L"KeyActuation", k, (int)a.mode);
+        swprintf_s(k, L"%u_Act", hid);  IniWriteI32(doc, L"KeyActuation", k, (int)a.pressM);
+        if (a.releaseM)
+        {
+            swprintf_s(k, L"%u_Rel", hid); IniWriteI32(doc, L"KeyActuation", k, (int)a.releaseM);
+        }
+        if (a.mode != ActuationMode::Fixed)
+        {
+            swprintf_s(k, L"%u_RTD", hid); IniWriteI32(doc, L"KeyActuation", k, (int)a.rtDownM);
+            swprintf_s(k, L"%u_RTU", hid); IniWriteI32(doc, L"KeyActuation", k, (int)a.rtUpM);
+        }
+    }
+}
+
+static void KeyActuationIni_LoadFromSettingsIni(const IniDoc& doc)
+{
+    Actuation_ClearAll();
+
+    std::vector<std::wstring_view> keys;
+    doc.Keys(L"KeyActuation", keys);
+
+    std::unordered_set<uint16_t> hids;
+    for (std::wstring_view k : keys)
+    {
+        int hidI = HidPrefix(k);
+        if (hidI > 0 && hidI < 256)
+            hids.insert((uint16_t)hidI);
+    }
+
+    for (uint16_t hid : hids)
+    {
+        wchar_t k[64];
+        KeyActuation a;
+        swprintf_s(k, L"%u_Mode", (unsigned)hid);
+        a.mode = (ActuationMode)std::clamp((int)doc.GetInt(L"KeyActuation", k, 0), 0, 2);
+        swprintf_s(k, L"%u_Act", (unsigned)hid);
+        a.pressM = (uint16_t)std::clamp((int)doc.GetInt(L"KeyActuation", k, ACTUATION_DEFAULT_PRESS_M), 1, 1000);
+        swprintf_s(k, L"%u_Rel", (unsigned)hid);
+        a.releaseM = (uint16_t)std::clamp((int)doc.GetInt(L"KeyActuation", k, 0), 0, (int)a.pressM);
+        swprintf_s(k, L"%u_RTD", (unsigned)hid);
+        a.rtDownM = (uint16_t)std::clamp((int)doc.GetInt(L"KeyActuation", k, 50), 1, 1000);
+        swprintf_s(k, L"%u_RTU", (unsigned)hid);
+        a.rtUpM = (uint16_t)std::clamp((int)doc.GetInt(L"KeyActuation", k, 50), 1, 1000);
+        Actuation_Set(hid, a);
+    }
+}
+
+// [SOCD] Pad<n>_<axis> = SocdMode (0 global, 1 sum, 2 neutral, 3 last wins,
+// 4 first wins, 5 minus priority, 6 plus priority, 7 analog max).
+// Only axes that do not follow the global toggles are written.
+static const wchar_t* const kSocdAxisNames[SOCD_AXES] = { L"LX", L"LY", L"RX", L"RY" };
+
+static void SocdIni_SaveToSettingsIni(IniDoc& doc)
+{
+    doc.EraseSection(L"SOCD");
+
+    for (int pad = 0; pad < SOCD_MAX_PADS; ++pad)
+    {
+        for (int axis = 0; axis < SOCD_AXES; ++axis)
+        {
+            SocdMode mode = Socd_GetMode(pad, axis);
+            if (mode == SocdMode::Global) continue;
+
+            wchar_t k[32];
+            swprintf_s(k, L"Pad%d_%s", pad + 1, kSocdAxisNames[axis]);
+            IniWriteI32(doc, L"SOCD", k, (int)mode);
+        }
+    }
+}
+
+void SettingsIni_ReadSocdModes(const IniDoc& doc, SocdMode (&out)[SOCD_MAX_PADS][SOCD_AXES])
+{
+    for (int pad = 0; pad < SOCD_MAX_PADS; ++pad)
+    {
+        for (int axis = 0; axis < SOCD_AXES; ++axis)
+        {
+            wchar_t k[32];
+            swprintf_s(k, L"Pad%d_%s", pad + 1, kSocdAxisNames[axis]);
+            int mode = (int)doc.GetInt(L"SOCD", k, 0);
+            out[pad][axis] = (mode > 0 && mode < (int)SocdMode::Count) ? (SocdMode)mode : SocdMode::Global;
+        }
+    }
+}
+
+static void SocdIni_LoadFromSettingsIni(const IniDoc& doc)
+{
+    SocdMode modes[SOCD_MAX_PADS][SOCD_AXES];
+    SettingsIni_ReadSocdModes(doc, modes);
+
+    Socd_ResetModes();
+    for (int pad = 0; pad < SOCD_MAX_PADS; ++pad)
+        for (int axis = 0; axis < SOCD_AXES; ++axis)
+            if (modes[pad][axis] != SocdMode::Global)
+                Socd_SetMode(pad, axis, modes[pad][axis]);
+}
+
+// [StickShape] Pad<n>_<L|R>_Circle, _Inner, _Outer, _AntiDz (1/1000 of the radius),
+// _Gamma (x1000), _Snap (0 off, 1 4-way, 2 8-way), _SnapDeg.
+// Only sticks that are not the identity are written.
+static const wchar_t* const kStickNames[STICK_SHAPE_STICKS] = { L"L", L"R" };
+
+static void StickShapeIni_SaveToSettingsIni(IniDoc& doc)
+{
+    doc.EraseSection(L"StickShape");
+
+    for (int pad = 0; pad < STICK_SHAPE_MAX_PADS; ++pad)
+    {
+        for (int stick = 0; stick < STICK_SHAPE_STICKS; ++stick)
+        {
+            const StickShapeConfig c = StickShape_Get(pad, stick);
+            if (c.IsIdentity()) continue;
+
+            wchar_t k[48];
+            auto put = [&](const wchar_t* name, int v) {
+                swprintf_s(k, L"Pad%d_%s_%s", pad + 1, kStickNames[stick], name);
+                IniWriteI32(doc, L"StickShape", k, v);
+                };
+            put(L"Circle", c.circle ? 1 : 0);
+            put(L"Inner", c.innerM);
+            put(L"Outer", c.outerM);
+            put(L"AntiDz", c.antiDzM);
+            put(L"Gamma", c.gammaM);
+            put(L"Snap", (int)c.snap);
+            put(L"SnapDeg", c.snapDeg);
+        }
+    }
+}
+
+void SettingsIni_ReadStickShapes(const IniDoc& doc, StickShapeConfig (&out)[STICK_SHAPE_MAX_PADS][STICK_SHAPE_STICKS])
+{
+    for (int pad = 0; pad < STICK_SHAPE_MAX_PADS; ++pad)
+    {
+        for (int stick = 0; stick < STICK_SHAPE_STICKS; ++stick)
+        {
+            wchar_t k[48];
+            auto get = [&](const wchar_t* name, int def) {
+                swprintf_s(k, L"Pad%d_%s_%s", pad + 1, kStickNames[stick], name);
+                return (int)doc.GetInt(L"StickShape", k, def);
+                };
+
+            const StickShapeConfig d;
+            StickShapeConfig& c = out[pad][stick];
+            c.circle = get(L"Circle", 0) != 0;
+            c.innerM = (uint16_t)std::clamp(get(L"Inner", d.innerM), 0, 900);
+            c.outerM = (uint16_t)std::clamp(get(L"Outer", d.outerM), 100, 1000);
+            c.antiDzM = (uint16_t)std::clamp(get(L"AntiDz", d.antiDzM), 0, 900);
+            c.gammaM = (uint16_t)std::clamp(get(L"Gamma", d.gammaM), 250, 4000);
+            c.snap = (StickSnap)std::clamp(get(L"Snap", 0), 0, 2);
+            c.snapDeg = (uint8_t)std::clamp(get(L"SnapDeg", d.snapDeg), 1, 45);
+        }
+    }
+}
+
+static void StickShapeIni_LoadFromSettingsIni(const IniDoc& doc)
+{
+    StickShapeConfig cfg[STICK_SHAPE_MAX_PADS][STICK_SHAPE_STICKS];
+    SettingsIni_ReadStickShapes(doc, cfg);
+
+    StickShape_ResetAll();
+    for (int pad = 0; pad < STICK_SHAPE_MAX_PADS; ++pad)
+        for (int stick = 0; stick < STICK_SHAPE_STICKS; ++stick)
+            if (!cfg[pad][stick].IsIdentity())
+                StickShape_Set(pad, stick, cfg[pad][stick]);
+}
+
+// [AnalogDevices] Policy (0 max, 1 first device, 2 per-device pads),
+// Slot<n> = device id (hex) of slot n, <hid>_Device = slot (1-based) a key is
+// pinned to. Slots are written as they are, known devices keep their slot.
+static void AnalogDevicesIni_SaveToSettingsIni(IniDoc& doc)
+{
+    doc.EraseSection(L"AnalogDevices");
+    IniWriteI32(doc, L"AnalogDevices", L"Policy", (int)AnalogDevices_GetPolicy());
+
+    const std::vector<uint64_t> ids = AnalogDevices_GetSlotIds();
+    for (size_t slot = 0; slot < ids.size(); ++slot)
+    {
+        if (ids[slot] == 0) continue;
+        wchar_t k[32], v[32];
+        swprintf_s(k, L"Slot%d", (int)slot + 1);
+        swprintf_s(v, L"0x%016llX", (unsigned long long)ids[slot]);
+        doc.Set(L"AnalogDevices", k, v);
+    }
+
+    std::vector<std::pair<uint16_t, int>> pins;
+    AnalogDevices_EnumerateKeyDevices(pins);
+    for (const auto& kv : pins)
+    {
+        wchar_t k[32];
+        swprintf_s(k, L"%u_Device", (unsigned)kv.first);
+        IniWriteI32(doc, L"AnalogDevices", k, kv.second + 1);
+    }
+}
+
+static void AnalogDevicesIni_LoadFromSettingsIni(const IniDoc& doc)
+{
+    AnalogDevices_SetPolicy((AnalogMergePolicy)std::clamp((int)doc.GetInt(L"AnalogDevices", L"Policy", 0),
+        0, (int)AnalogMergePolicy::Count - 1));
+
+    std::vector<uint64_t> ids(ANALOG_MAX_DEVICES, 0);
+    for (int slot = 0; slot < ANALOG_MAX_DEVICES; ++slot)
+    {
+        wchar_t k[32];
+        swprintf_s(k, L"Slot%d", slot + 1);
+        const std::wstring v = doc.GetString(L"AnalogDevices", k);
+        if (!v.empty()) ids[(size_t)slot] = wcstoull(v.c_str(), nullptr, 0);
+    }
+    AnalogDevices_SetSlotIds(ids);
+
+    AnalogDevices_ClearKeyDevices();
+    std::vector<std::wstring_view> keys;
+    doc.Keys(L"AnalogDevices", keys);
+    for (std::wstring_view k : keys)
+    {
+        const int hid = HidPrefix(k);
+        if (hid <= 0 || hid >= 256) continue;
+        const int slot = (int)doc.GetInt(L"AnalogDevices", k, 0);
+        if (slot >= 1 && slot <= ANALOG_MAX_DEVICES)
+            AnalogDevices_SetKeyDevice((uint16_t)hid, slot - 1);
+    }
+}
+
+// [MouseOutput] Enabled, Left/Right/Up/Down/WheelUp/WheelDown = HID,
+// StickPad (1-based, 0 none), Stick (0 left, 1 right), ConsumeStick, and per
+// curve (Move*, Wheel*): Deadzone (1/1000), Gamma (x1000), Speed (px or notches / s).
+static const wchar_t* const kMouseOutKeyNames[(int)MouseOutKey::Count] = {
+    L"Left", L"Right", L"Up", L"Down", L"WheelUp", L"WheelDown"
+};
+
+static void MouseOutputIni_SaveToSettingsIni(IniDoc& doc)
+{
+    doc.EraseSection(L"MouseOutput");
+    const MouseOutConfig c = MouseOut_Get();
+
+    IniWriteI32(doc, L"MouseOutput", L"Enabled", c.enabled ? 1 : 0);
+    for (int k = 0; k < (int)MouseOutKey::Count; ++k)
+        if (c.keys[k]) IniWriteI32(doc, L"MouseOutput", kMouseOutKeyNames[k], c.keys[k]);
+    IniWriteI32(doc, L"MouseOutput", L"StickPad", c.stickPad + 1);
+    IniWriteI32(doc, L"MouseOutput", L"Stick", c.stick);
+    IniWriteI32(doc, L"MouseOutput", L"ConsumeStick", c.consumeStick ? 1 : 0);
+
+    auto putCurve = [&](const wchar_t* prefix, const MouseOutCurve& cv) {
+        wchar_t k[32];
+        swprintf_s(k, L"%sDeadzone", prefix); IniWriteI32(doc, L"MouseOutput", k, cv.deadzoneM);
+        swprintf_s(k, L"%sGamma", prefix);    IniWriteI32(doc, L"MouseOutput", k, cv.gammaM);
+        swprintf_s(k, L"%sSpeed", prefix);    IniWriteU32(doc, L"MouseOutput", k, cv.maxSpeed);
+        };
+    putCurve(L"Move", c.move);
+    putCurve(L"Wheel", c.wheel);
+}
+
+static void MouseOutputIni_LoadFromSettingsIni(const IniDoc& doc)
+{
+    const MouseOutConfig d;
+    MouseOutConfig c;
+    c.enabled = IniReadI32(doc, L"MouseOutput", L"Enabled", 0) != 0;
+    for (int k = 0; k < (int)MouseOutKey::Count; ++k)
+        c.keys[k] = (uint16_t)std::clamp(IniReadI32(doc, L"MouseOutput", kMouseOutKeyNames[k], 0), 0, 255);
+    c.stickPad = (int8_t)(std::clamp(IniReadI32(doc, L"MouseOutput", L"StickPad", 0), 0, MOUSE_OUT_MAX_PADS) - 1);
+    c.stick = (uint8_t)std::clamp(IniReadI32(doc, L"MouseOutput", L"Stick", d.stick), 0, 1);
+    c.consumeStick = IniReadI32(doc, L"MouseOutput", L"ConsumeStick", d.consumeStick ? 1 : 0) != 0;
+
+    auto getCurve = [&](const wchar_t* prefix, const MouseOutCurve& def) {
+        MouseOutCurve cv;
+        wchar_t k[32];
+        swprintf_s(k, L"%sDeadzone", prefix); cv.deadzoneM = (uint16_t)std::clamp(IniReadI32(doc, L"MouseOutput", k, def.deadzoneM), 0, 900);
+        swprintf_s(k, L"%sGamma", prefix);    cv.gammaM = (uint16_t)std::clamp(IniReadI32(doc, L"MouseOutput", k, def.gammaM), 250, 4000);
+        swprintf_s(k, L"%sSpeed", prefix);    cv.maxSpeed = std::clamp(IniReadU32(doc, L"MouseOutput", k, def.maxSpeed), 1u, 20000u);
+        return cv;
+        };
+    c.move = getCurve(L"Move", d.move);
+    c.wheel = getCurve(L"Wheel", d.wheel);
+    MouseOut_Set(c);
+}
+
+// [MacroOutput] Pacing (0 Paced, 1 Burst), ActionGapUs, TapHoldUs, CharGapUs:
+// macro output timing (output_coalescer.h), taken by the next macro run.
+static void MacroOutputIni_SaveToSettingsIni(IniDoc& doc)
+{
+    const OutputPacing p = FreeComboSystem::GetOutputPacing();
+    IniWriteI32(doc, L"MacroOutput", L"Pacing", (int)p.mode);
+    IniWriteU32(doc, L"MacroOutput", L"ActionGapUs", p.actionGapUs);
+    IniWriteU32(doc, L"MacroOutput", L"TapHoldUs", p.tapHoldUs);
+    IniWriteU32(doc, L"MacroOutput", L"CharGapUs", p.textCharGapUs);
+}
+
+static void MacroOutputIni_LoadFromSettingsIni(const IniDoc& doc)
+{
+    const OutputPacing d;
+    OutputPacing p;
+    p.mode = (OutputPacingMode)std::clamp(IniReadI32(doc, L"MacroOutput", L"Pacing", (int)d.mode), 0, 1);
+    p.actionGapUs = std::min(IniReadU32(doc, L"MacroOutput", L"ActionGapUs", d.actionGapUs), 1000000u);
+    p.tapHoldUs = std::min(IniReadU32(doc, L"MacroOutput", L"TapHoldUs", d.tapHoldUs), 1000000u);
+    p.textCharGapUs = std::min(IniReadU32(doc, L"MacroOutput", L"CharGapUs", d.textCharGapUs), 1000000u);
+    FreeComboSystem::SetOutputPacing(p);
+}
+
+// [AppProfiles] Count, Rule<n> = executable pattern, Profile<n> = profile name.
+// Profile <name> is AppProfiles\<name>.ini near the exe: a bindings profile
+// (Profile_SaveIni format) plus optional [SOCD] / [StickShape] sections.
+// Edited by hand; the section is kept as is when the settings are saved.
+static void AppProfilesIni_LoadFromSettingsIni(const IniDoc& doc)
+{
+    std::vector<AppProfileRule> rules;
+    std::vector<std::unique_ptr<ProfileImage>> images;
+
+    const int count = std::clamp((int)doc.GetInt(L"AppProfiles", L"Count", 0), 0, 256);
+    for (int i = 1; i <= count; ++i)
+    {
+        wchar_t kRule[32], kProfile[32];
+        swprintf_s(kRule, L"Rule%d", i);
+        swprintf_s(kProfile, L"Profile%d", i);
+
+        AppProfileRule r;
+        r.exePattern = doc.GetString(L"AppProfiles", kRule);
+        r.profile = doc.GetString(L"AppProfiles", kProfile);
+        if (r.exePattern.empty() || r.profile.empty()) continue;
+        if (r.profile.find_first_of(L"\\/:") != std::wstring::npos || r.profile.find(L"..") != std::wstring::npos)
+            continue;
+
+        // Each profile is compiled once, however many rules use it
+        bool known = false;
+        for (const auto& img : images) known = known || img->name == r.profile;
+        if (!known)
+        {
+            IniDoc pdoc;
+            const std::wstring ppath = WinUtil_BuildPathNearExe((L"AppProfiles\\" + r.profile + L".ini").c_str());
+            if (!ProfileCache_LoadIni(ppath.c_str(), pdoc)) continue;
+
+            auto src = std::make_unique<ProfileSource>();
+            src->name = r.profile;
+            Profile_ReadBindings(pdoc, src->pads);
+            Profile_ReadLayers(pdoc, src->layers);
+            src->hasSocd = pdoc.HasSection(L"SOCD");
+            if (src->hasSocd) SettingsIni_ReadSocdModes(pdoc, src->socd);
+            src->hasStickShape = pdoc.HasSection(L"StickShape");
+            if (src->hasStickShape) SettingsIni_ReadStickShapes(pdoc, src->sticks);
+            images.push_back(AppProfiles_Compile(*src));
+        }
+        rules.push_back(std::move(r));
+    }
+
+    AppProfiles_SetProfiles(std::move(images), std::move(rules));
+}
+
 bool SettingsIni_Load(const wchar_t* path)
 {
     if (!path) return false;
 
-    DWORD attr = GetFileAttributesW(path);
-    if (attr == INVALID_FILE_ATTRIBUTES) return false;
+    // One read and one parse for the whole file
+    IniDoc doc;
+    if (!ProfileCache_LoadIni(path, doc)) return false;
 
-    float low = IniReadFloat1000(L"Input", L"DeadzoneLow", Settings_GetInputDeadzoneLow(), path);
-    float high = IniReadFloat1000(L"Input", L"DeadzoneHigh", Settings_GetInputDeadzoneHigh(), path);
+    float low = IniReadFloat1000(doc, L"Input", L"DeadzoneLow", Settings_GetInputDeadzoneLow());
+    float high = IniReadFloat1000(doc, L"Input", L"DeadzoneHigh", Settings_GetInputDeadzoneHigh());
 
-    float adz = IniReadFloat1000(L"Input", L"AntiDeadzone", Settings_GetInputAntiDeadzone(), path);
-    float cap = IniReadFloat1000(L"Input", L"OutputCap", Settings_GetInputOutputCap(), path);
+    float adz = IniReadFloat1000(doc, L"Input", L"AntiDeadzone", Settings_GetInputAntiDeadzone());
+    float cap = IniReadFloat1000(doc, L"Input", L"OutputCap", Settings_GetInputOutputCap());
 
-    float c1x = IniReadFloat1000(L"Input", L"Cp1X", Settings_GetInputBezierCp1X(), path);
-    float c1y = IniReadFloat1000(L"Input", L"Cp1Y", Settings_GetInputBezierCp1Y(), path);
-    float c2x = IniReadFloat1000(L"Input", L"Cp2X", Settings_GetInputBezierCp2X(), path);
-    float c2y = IniReadFloat1000(L"Input", L"Cp2Y", Settings_GetInputBezierCp2Y(), path);
+    float c1x = IniReadFloat1000(doc, L"Input", L"Cp1X", Settings_GetInputBezierCp1X());
+    float c1y = IniReadFloat1000(doc, L"Input", L"Cp1Y", Settings_GetInputBezierCp1Y());
+    float c2x = IniReadFloat1000(doc, L"Input", L"Cp2X", Settings_GetInputBezierCp2X());
+    float c2y = IniReadFloat1000(doc, L"Input", L"Cp2Y", Settings_GetInputBezierCp2Y());
 
-    float c1w = IniReadFloat1000(L"Input", L"Cp1W", Settings_GetInputBezierCp1W(), path);
-    float c2w = IniReadFloat1000(L"Input", L"Cp2W", Settings_GetInputBezierCp2W(), path);
+    float c1w = IniReadFloat1000(doc, L"Input", L"Cp1W", Settings_GetInputBezierCp1W());
+    float c2w = IniReadFloat1000(doc, L"Input", L"Cp2W", Settings_GetInputBezierCp2W());
 
-    UINT curveMode = IniReadU32(L"Input", L"CurveMode", Settings_GetInputCurveMode(), path);
-    int invert = GetPrivateProfileIntW(L"Input", L"Invert", 0, path);
-    int snappy = GetPrivateProfileIntW(L"Input", L"SnappyJoystick", Settings_GetSnappyJoystick() ? 1 : 0, path);
-    int lastKeyPriority = GetPrivateProfileIntW(L"Input", L"LastKeyPriority", Settings_GetLastKeyPriority() ? 1 : 0, path);
+    UINT curveMode = IniReadU32(doc, L"Input", L"CurveMode", Settings_GetInputCurveMode());
+    int invert = doc.GetInt(L"Input", L"Invert", 0);
+    int snappy = doc.GetInt(L"Input", L"SnappyJoystick", Settings_GetSnappyJoystick() ? 1 : 0);
+    int lastKeyPriority = doc.GetInt(L"Input", L"LastKeyPriority", Settings_GetLastKeyPriority() ? 1 : 0);
     float lastKeyPrioritySensitivity = IniReadFloat1000(
-        L"Input", L"LastKeyPrioritySensitivity",
-        Settings_GetLastKeyPrioritySensitivity(), path);
-    int blockBoundKeys = GetPrivateProfileIntW(L"Input", L"BlockBoundKeys", Settings_GetBlockBoundKeys() ? 1 : 0, path);
-
-    UINT poll = IniReadU32(L"Main", L"PollingMs", Settings_GetPollingMs(), path);
-    UINT uiMs = IniReadU32(L"Main", L"UIRefreshMs", Settings_GetUIRefreshMs(), path);
-    int vpadCount = GetPrivateProfileIntW(L"Main", L"VirtualGamepads", Settings_GetVirtualGamepadCount(), path);
-    int vpadEnabled = GetPrivateProfileIntW(L"Main", L"VirtualGamepadsEnabled", Settings_GetVirtualGamepadsEnabled() ? 1 : 0, path);
+        doc, L"Input", L"LastKeyPrioritySensitivity",
+        Settings_GetLastKeyPrioritySensitivity());
+    int blockBoundKeys = doc.GetInt(L"Input", L"BlockBoundKeys", Settings_GetBlockBoundKeys() ? 1 : 0);
+
+    UINT poll = IniReadU32(doc, L"Main", L"PollingMs", Settings_GetPollingMs());
+    UINT uiMs = IniReadU32(doc, L"Main", L"UIRefreshMs", Settings_GetUIRefreshMs());
+    int vpadCount = doc.GetInt(L"Main", L"VirtualGamepads", Settings_GetVirtualGamepadCount());
+    int vpadEnabled = doc.GetInt(L"Main", L"VirtualGamepadsEnabled", Settings_GetVirtualGamepadsEnabled() ? 1 : 0);
     // Logging
-    int loggingEnabled = GetPrivateProfileIntW(L"Main", L"Logging", 0, path);
+    int loggingEnabled = doc.GetInt(L"Main", L"Logging", 0);
     Logger::SetEnabled(loggingEnabled != 0);
-    int winW = GetPrivateProfileIntW(L"Window", L"Width", Settings_GetMainWindowWidthPx(), path);
-    int winH = GetPrivateProfileIntW(L"Window", L"Height", Settings_GetMainWindowHeightPx(), path);
-    int winX = IniReadI32(L"Window", L"PosX", std::numeric_limits<int>::min(), path);
-    int winY = IniReadI32(L"Window", L"PosY", std::numeric_limits<int>::min(), path);
+    int winW = doc.GetInt(L"Window", L"Width", Settings_GetMainWindowWidthPx());
+    int winH = doc.GetInt(L"Window", L"Height", Settings_GetMainWindowHeightPx());
+    int winX = IniReadI32(doc, L"Window", L"PosX", std::numeric_limits<int>::min());
+    int winY = IniReadI32(doc, L"Window", L"PosY", std::numeric_limits<int>::min());
 
     Settings_SetInputDeadzoneLow(low);
     Settings_SetInputDeadzoneHigh(high);
@@ -338,89 +664,100 @@ bool SettingsIni_Load(const wchar_t* path)
     Settings_SetMainWindowHeightPx(winH);
     Settings_SetMainWindowPosXPx(winX);
     Settings_SetMainWindowPosYPx(winY);
-    Settings_SetCompactWinPosXPx(IniReadI32(L"CompactWindow", L"PosX",
-        std::numeric_limits<int>::min(), path));
-    Settings_SetCompactWinPosYPx(IniReadI32(L"CompactWindow", L"PosY",
-        std::numeric_limits<int>::min(), path));
-
-    KeySettingsIni_LoadFromSettingsIni(path);
-    KeyboardLayout_LoadFromIni(path);
+    Settings_SetCompactWinPosXPx(IniReadI32(doc, L"CompactWindow", L"PosX",
+        std::numeric_limits<int>::min()));
+    Settings_SetCompactWinPosYPx(IniReadI32(doc, L"CompactWindow", L"PosY",
+        std::numeric_limits<int>::min()));
+
+    KeySettingsIni_LoadFromSettingsIni(doc);
+    KeyActuationIni_LoadFromSettingsIni(doc);
+    SocdIni_LoadFromSettingsIni(doc);
+    StickShapeIni_LoadFromSettingsIni(doc);
+    AnalogDevicesIni_LoadFromSettingsIni(doc);
+    MouseOutputIni_LoadFromSettingsIni(doc);
+    MacroOutputIni_LoadFromSettingsIni(doc);
+    AppProfilesIni_LoadFromSettingsIni(doc);
+    KeyboardLayout_LoadFromIni(doc);
     // Combo settings
-    UINT comboThrottle = IniReadU32(L"Combo", L"RepeatThrottleMs", Settings_GetComboRepeatThrottleMs(), path);
+    UINT comboThrottle = IniReadU32(doc, L"Combo", L"RepeatThrottleMs", Settings_GetComboRepeatThrottleMs());
     Settings_SetComboRepeatThrottleMs(comboThrottle);
+
+    g_settingsDoc = std::move(doc);
     return true;
 }
 
 // Writes ONLY application settings (settings.ini).
 // Curve presets are stored separately by KeyboardProfiles (CurvePresets folder).
-static bool SettingsIni_Save_Internal(const wchar_t* tmpPath)
+static void SettingsIni_Save_Internal(IniDoc& doc)
 {
-    if (!tmpPath) return false;
-    IniWriteU32(L"Main", L"Logging", Logger::IsEnabled() ? 1 : 0, tmpPath);
-    IniWriteFloat1000(L"Input", L"DeadzoneLow", Settings_GetInputDeadzoneLow(), tmpPath);
-    IniWriteFloat1000(L"Input", L"DeadzoneHigh", Settings_GetInputDeadzoneHigh(), tmpPath);
-
-    IniWriteFloat1000(L"Input", L"AntiDeadzone", Settings_GetInputAntiDeadzone(), tmpPath);
-    IniWriteFloat1000(L"Input", L"OutputCap", Settings_GetInputOutputCap(), tmpPath);
-
-    IniWriteFloat1000(L"Input", L"Cp1X", Settings_GetInputBezierCp1X(), tmpPath);
-    IniWriteFloat1000(L"Input", L"Cp1Y", Settings_GetInputBezierCp1Y(), tmpPath);
-    IniWriteFloat1000(L"Input", L"Cp2X", Settings_GetInputBezierCp2X(), tmpPath);
-    IniWriteFloat1000(L"Input", L"Cp2Y", Settings_GetInputBezierCp2Y(), tmpPath);
-
-    IniWriteFloat1000(L"Input", L"Cp1W", Settings_GetInputBezierCp1W(), tmpPath);
-    IniWriteFloat1000(L"Input", L"Cp2W", Settings_GetInputBezierCp2W(), tmpPath);
-
-    IniWriteU32(L"Input", L"CurveMode", Settings_GetInputCurveMode(), tmpPath);
-    IniWriteI32(L"Input", L"Invert", Settings_GetInputInvert() ? 1 : 0, tmpPath);
-    IniWriteI32(L"Input", L"SnappyJoystick", Settings_GetSnappyJoystick() ? 1 : 0, tmpPath);
-    IniWriteI32(L"Input", L"LastKeyPriority", Settings_GetLastKeyPriority() ? 1 : 0, tmpPath);
-    IniWriteFloat1000(L"Input", L"LastKeyPrioritySensitivity", Settings_GetLastKeyPrioritySensitivity(), tmpPath);
-    IniWriteI32(L"Input", L"BlockBoundKeys", Settings_GetBlockBoundKeys() ? 1 : 0, tmpPath);
-
-    IniWriteU32(L"Main", L"PollingMs", Settings_GetPollingMs(), tmpPath);
-    IniWriteU32(L"Main", L"UIRefreshMs", Settings_GetUIRefreshMs(), tmpPath);
-    IniWriteI32(L"Main", L"VirtualGamepads", std::clamp(Settings_GetVirtualGamepadCount(), 1, 4), tmpPath);
-    IniWriteI32(L"Main", L"VirtualGamepadsEnabled", Settings_GetVirtualGamepadsEnabled() ? 1 : 0, tmpPath);
-    IniWriteI32(L"Window", L"Width", std::max(0, Settings_GetMainWindowWidthPx()), tmpPath);
-    IniWriteI32(L"Window", L"Height", std::max(0, Settings_GetMainWindowHeightPx()), tmpPath);
+    IniWriteU32(doc, L"Main", L"Logging", Logger::IsEnabled() ? 1 : 0);
+    IniWriteFloat1000(doc, L"Input", L"DeadzoneLow", Settings_GetInputDeadzoneLow());
+    IniWriteFloat1000(doc, L"Input", L"DeadzoneHigh", Settings_GetInputDeadzoneHigh());
+
+    IniWriteFloat1000(doc, L"Input", L"AntiDeadzone", Settings_GetInputAntiDeadzone());
+    IniWriteFloat1000(doc, L"Input", L"OutputCap", Settings_GetInputOutputCap());
+
+    IniWriteFloat1000(doc, L"Input", L"Cp1X", Settings_GetInputBezierCp1X());
+    IniWriteFloat1000(doc, L"Input", L"Cp1Y", Settings_GetInputBezierCp1Y());
+    IniWriteFloat1000(doc, L"Input", L"Cp2X", Settings_GetInputBezierCp2X());
+    IniWriteFloat1000(doc, L"Input", L"Cp2Y", Settings_GetInputBezierCp2Y());
+
+    IniWriteFloat1000(doc, L"Input", L"Cp1W", Settings_GetInputBezierCp1W());
+    IniWriteFloat1000(doc, L"Input", L"Cp2W", Settings_GetInputBezierCp2W());
+
+    IniWriteU32(doc, L"Input", L"CurveMode", Settings_GetInputCurveMode());
+    IniWriteI32(doc, L"Input", L"Invert", Settings_GetInputInvert() ? 1 : 0);
+    IniWriteI32(doc, L"Input", L"SnappyJoystick", Settings_GetSnappyJoystick() ? 1 : 0);
+    IniWriteI32(doc, L"Input", L"LastKeyPriority", Settings_GetLastKeyPriority() ? 1 : 0);
+    IniWriteFloat1000(doc, L"Input", L"LastKeyPrioritySensitivity", Settings_GetLastKeyPrioritySensitivity());
+    IniWriteI32(doc, L"Input", L"BlockBoundKeys", Settings_GetBlockBoundKeys() ? 1 : 0);
+
+    IniWriteU32(doc, L"Main", L"PollingMs", Settings_GetPollingMs());
+    IniWriteU32(doc, L"Main", L"UIRefreshMs", Settings_GetUIRefreshMs());
+    IniWriteI32(doc, L"Main", L"VirtualGamepads", std::clamp(Settings_GetVirtualGamepadCount(), 1, BINDINGS_MAX_GAMEPADS));
+    IniWriteI32(doc, L"Main", L"VirtualGamepadsEnabled", Settings_GetVirtualGamepadsEnabled() ? 1 : 0);
+    IniWriteI32(doc, L"Window", L"Width", std::max(0, Settings_GetMainWindowWidthPx()));
+    IniWriteI32(doc, L"Window", L"Height", std::max(0, Settings_GetMainWindowHeightPx()));
     const int winX = Settings_GetMainWindowPosXPx();
     const int winY = Settings_GetMainWindowPosYPx();
     if (winX == std::numeric_limits<int>::min())
-        WritePrivateProfileStringW(L"Window", L"PosX", nullptr, tmpPath);
+        doc.Erase(L"Window", L"PosX");
     else
-        IniWriteI32(L"Window", L"PosX", winX, tmpPath);
+        IniWriteI32(doc, L"Window", L"PosX", winX);
     if (winY == std::numeric_limits<int>::min())
-        WritePrivateProfileStringW(L"Window", L"PosY", nullptr, tmpPath);
+        doc.Erase(L"Window", L"PosY");
     else
-        IniWriteI32(L"Window", L"PosY", winY, tmpPath);
+        IniWriteI32(doc, L"Window", L"PosY", winY);
     // Compact window position
     const int cWinX = Settings_GetCompactWinPosXPx();
     const int cWinY = Settings_GetCompactWinPosYPx();
     if (cWinX != std::numeric_limits<int>::min())
-        IniWriteI32(L"CompactWindow", L"PosX", cWinX, tmpPath);
+        IniWriteI32(doc, L"CompactWindow", L"PosX", cWinX);
+    else
+        doc.Erase(L"CompactWindow", L"PosX");
     if (cWinY != std::numeric_limits<int>::min())
-        IniWriteI32(L"CompactWindow", L"PosY", cWinY, tmpPath);
-
-    KeySettingsIni_SaveToSettingsIni(tmpPath);
-    KeyboardLayout_SaveToIni(tmpPath);
+        IniWriteI32(doc, L"CompactWindow", L"PosY", cWinY);
+    else
+        doc.Erase(L"CompactWindow", L"PosY");
+
+    KeySettingsIni_SaveToSettingsIni(doc);
+    KeyActuationIni_SaveToSettingsIni(doc);
+    SocdIni_SaveToSettingsIni(doc);
+    StickShapeIni_SaveToSettingsIni(doc);
+    AnalogDevicesIni_SaveToSettingsIni(doc);
+    MouseOutputIni_SaveToSettingsIni(doc);
+    MacroOutputIni_SaveToSettingsIni(doc);
+    KeyboardLayout_SaveToIni(doc);
     // Combo settings
-    IniWriteU32(L"Combo", L"RepeatThrottleMs", Settings_GetComboRepeatThrottleMs(), tmpPath);
-    return true;
+    IniWriteU32(doc, L"Combo", L"RepeatThrottleMs", Settings_GetComboRepeatThrottleMs());
 }
 
 bool SettingsIni_Save(const wchar_t* path)
 {
     if (!path) return false;
 
-    std::wstring tmp = std::wstring(path) + L".tmp";
-    DeleteFileW(tmp.c_str());
-
-    if (!SettingsIni_Save_Internal(tmp.c_str()))
-    {
-        DeleteFileW(tmp.c_str());
-        return false;
-    }
-
-    return IniUtil_AtomicReplace(tmp.c_str(), path);
+    // Snapshot in memory, the persistence service writes it (tmp + atomic replace)
+    SettingsIni_Save_Internal(g_settingsDoc);
+    Persist_PostFile(path, g_settingsDoc.SerializeBytes());
+    return true;
 }
@@ -1,5 +1,15 @@
 #pragma once
 #include <windows.h>
 
+#include "socd.h"
+#include "stick_shape.h"
+
+class IniDoc;
+
 bool SettingsIni_Load(const wchar_t* path);
-bool SettingsIni_Save(const wchar_t* path);
\ No newline at end of file
+bool SettingsIni_Save(const wchar_t* path);
+
+// [SOCD] / [StickShape] of a document, without touching the live settings
+// (app profile files use the same sections).
+void SettingsIni_ReadSocdModes(const IniDoc& doc, SocdMode (&out)[SOCD_MAX_PADS][SOCD_AXES]);
+void SettingsIni_ReadStickShapes(const IniDoc& doc, StickShapeConfig (&out)[STICK_SHAPE_MAX_PADS][STICK_SHAPE_STICKS]);
@@ -0,0 +1,117 @@
+// slot_map.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+// Slot map: O(1) insert / lookup / erase behind generational handles.
+// - A handle packs the slot index (low kIndexBits) and the slot generation.
+//   Erase bumps the generation: a handle to a deleted element stops resolving
+//   instead of silently pointing at whatever reuses the slot.
+// - Elements never move (std::deque): a pointer stays valid until its own Erase.
+// - Handles are positive ints (>= 1 << kIndexBits), so -1 stays "none".
+// - Iteration order is slot order, not insertion order: the owner keeps its own
+//   ordering list when order matters.
+// Not thread-safe: the owner locks.
+template <typename T>
+class SlotMap
+{
+public:
+    static constexpr int      kIndexBits = 20;
+    static constexpr uint32_t kIndexMask = (1u << kIndexBits) - 1;
+    static constexpr uint32_t kMaxGeneration = (1u << (31 - kIndexBits)) - 1;
+
+    // -1 when every slot index is used.
+    int Insert(T value)
+    {
+        uint32_t slot;
+        if (!m_free.empty()) {
+            slot = m_free.back();
+            m_free.pop_back();
+        } else {
+            if (m_slots.size() > kIndexMask) return -1;
+            slot = (uint32_t)m_slots.size();
+            m_slots.emplace_back();
+        }
+        Slot& s = m_slots[slot];
+        s.value = std::move(value);
+        s.live = true;
+        ++m_size;
+        return MakeHandle(slot, s.generation);
+    }
+
+    T* Get(int handle)
+    {
+        Slot* s = Resolve(handle);
+        return s ? &s->value : nullptr;
+    }
+    const T* Get(int handle) const
+    {
+        return const_cast<SlotMap*>(this)->Get(handle);
+    }
+
+    bool Erase(int handle)
+    {
+        Slot* s = Resolve(handle);
+        if (!s) return false;
+        s->value = T{};   // release the element's memory now
+        s->live = false;
+        s->generation = (s->generation >= kMaxGeneration) ? 1 : s->generation + 1;
+        m_free.push_back(SlotOf(handle));
+        --m_size;
+        return true;
+    }
+
+    void Clear()
+    {
+        for (uint32_t i = 0; i < (uint32_t)m_slots.size(); ++i)
+            if (m_slots[i].live) Erase(MakeHandle(i, m_slots[i].generation));
+    }
+
+    size_t   Size() const { return m_size; }
+    // Exclusive upper bound of slot indices (for arrays indexed by slot).
+    uint32_t SlotCount() const { return (uint32_t)m_slots.size(); }
+
+    static uint32_t SlotOf(int handle) { return (uint32_t)handle & kIndexMask; }
+
+    // Current handle of a live slot, -1 if free.
+    int HandleAt(uint32_t slot) const
+    {
+        if (slot >= m_slots.size() || !m_slots[slot].live) return -1;
+        return MakeHandle(slot, m_slots[slot].generation);
+    }
+    T* AtSlot(uint32_t slot)
+    {
+        if (slot >= m_slots.size() || !m_slots[slot].live) return nullptr;
+        return &m_slots[slot].value;
+    }
+
+private:
+    struct Slot
+    {
+        T        value{};
+        uint32_t generation = 1;
+        bool     live = false;
+    };
+
+    static int MakeHandle(uint32_t slot, uint32_t generation)
+    {
+        return (int)((generation << kIndexBits) | slot);
+    }
+
+    Slot* Resolve(int handle)
+    {
+        if (handle < 0) return nullptr;
+        const uint32_t slot = SlotOf(handle);
+        if (slot >= m_slots.size()) return nullptr;
+        Slot& s = m_slots[slot];
+        if (!s.live || s.generation != ((uint32_t)handle >> kIndexBits)) return nullptr;
+        return &s;
+    }
+
+    std::deque<Slot>      m_slots;
+    std::vector<uint32_t> m_free;
+    size_t                m_size = 0;
+};
@@ -0,0 +1,178 @@
+// socd.cpp
+#include "socd.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+
+namespace
+{
+    constexpr float kEqEps = 0.002f;   // AnalogMax: closer than this = tie
+    constexpr float kZeroV = 0.0001f;  // both directions at rest
+
+    // c is 0 / 1. Masks rather than ?: so the compiler cannot turn a select
+    // back into a jump (it does for float ternaries).
+    inline float Sel(int c, float a, float b)
+    {
+        const uint32_t mask = 0u - (uint32_t)c;
+        return std::bit_cast<float>((std::bit_cast<uint32_t>(a) & mask) | (std::bit_cast<uint32_t>(b) & ~mask));
+    }
+
+    inline int SelI(int c, int a, int b)
+    {
+        return b ^ ((a ^ b) & -c);
+    }
+
+    // One instance per strategy: the mode is a template argument, so the
+    // only remaining conditions are on the values, all through Sel / SelI.
+    template <SocdMode M>
+    float Resolve(SocdAxisState& st, const SocdAxis& ax, float m, float p)
+    {
+        const int md = m >= SOCD_PRESS_V;
+        const int pd = p >= SOCD_PRESS_V;
+        const int mPrev = st.prevDown & 1;
+        const int pPrev = (st.prevDown >> 1) & 1;
+        const int mEdge = md & (mPrev ^ 1);
+        const int pEdge = pd & (pPrev ^ 1);
+
+        // Both pressed on the same tick: plus counts as last (as before)
+        int last = SelI(pEdge, +1, SelI(mEdge, -1, (int)st.lastDir));
+
+        if constexpr (M == SocdMode::LastWins)
+        {
+            // Valley of each held direction: going back down by `reactivate`
+            // from it is a new press of that direction.
+            const float mValley = Sel(md, Sel(mPrev, std::min(st.minusValley, m), m), 1.0f);
+            const float pValley = Sel(pd, Sel(pPrev, std::min(st.plusValley, p), p), 1.0f);
+            const int mAgain = md & mPrev & (int)((m - mValley) >= ax.reactivate);
+            const int pAgain = pd & pPrev & (int)((p - pValley) >= ax.reactivate);
+            last = SelI(pAgain, +1, SelI(mAgain, -1, last));
+            st.minusValley = Sel(mAgain, m, mValley);
+            st.plusValley = Sel(pAgain, p, pValley);
+        }
+
+        const int both = md & pd;
+        const int plusAhead = p >= m;
+        if constexpr (M == SocdMode::FirstWins)
+        {
+            const int alone = SelI(md, -1, pd);
+            const int first = SelI(st.firstDir != 0, (int)st.firstDir, SelI(plusAhead, +1, -1));
+            st.firstDir = (int8_t)SelI(both, first, alone);
+        }
+
+        st.lastDir = (int8_t)last;
+        st.prevDown = (uint8_t)(md | (pd << 1));
+
+        const float diff = p - m;
+        const float single = Sel(md & (pd ^ 1), -m, Sel(pd & (md ^ 1), p, diff));
+        const float maxV = std::max(m, p);
+        const int atRest = maxV <= kZeroV;
+
+        if constexpr (M == SocdMode::Sum)
+        {
+            return diff;
+        }
+        else if constexpr (M == SocdMode::Neutral)
+        {
+            return Sel(both, 0.0f, single);
+        }
+        else if constexpr (M == SocdMode::FirstWins)
+        {
+            return Sel(both, Sel(st.firstDir > 0, p, -m), single);
+        }
+        else if constexpr (M == SocdMode::PriorityMinus)
+        {
+            return Sel(both, -m, single);
+        }
+        else if constexpr (M == SocdMode::PriorityPlus)
+        {
+            return Sel(both, p, single);
+        }
+        else
+        {
+            const int maxSign = SelI(diff > kEqEps, 1, SelI(diff < -kEqEps, -1, last));
+            const float analogMax = (float)maxSign * maxV;
+
+            if constexpr (M == SocdMode::AnalogMax)
+            {
+                return Sel(atRest, 0.0f, analogMax);
+            }
+            else // LastWins
+            {
+                const int dir = SelI(last != 0, last, SelI(plusAhead, +1, -1));
+                const float winner = Sel(dir > 0, p, m);
+                const float conflict = (float)dir * Sel(ax.snap > 0.0f, maxV, winner);
+                const float neither = Sel(ax.snap > 0.0f, analogMax, diff);
+                return Sel(atRest, 0.0f, Sel(both, conflict, Sel(md | pd, single, neither)));
+            }
+        }
+    }
+
+    constexpr SocdResolveFn kResolvers[(size_t)SocdMode::Count] = {
+        &Resolve<SocdMode::Sum>,   // Global, never used once compiled
+        &Resolve<SocdMode::Sum>,
+        &Resolve<SocdMode::Neutral>,
+        &Resolve<SocdMode::LastWins>,
+        &Resolve<SocdMode::FirstWins>,
+        &Resolve<SocdMode::PriorityMinus>,
+        &Resolve<SocdMode::PriorityPlus>,
+        &Resolve<SocdMode::AnalogMax>,
+    };
+
+    std::array<std::atomic<uint8_t>, SOCD_MAX_PADS * SOCD_AXES> g_modes{};
+    std::atomic<uint32_t> g_generation{ 0 };
+
+    bool ValidSlot(int pad, int axis)
+    {
+        return pad >= 0 && pad < SOCD_MAX_PADS && axis >= 0 && axis < SOCD_AXES;
+    }
+}
+
+SocdAxis Socd_Compile(SocdMode mode, bool snapStick, bool lastKeyPriority, float sensitivity)
+{
+    SocdAxis ax;
+    ax.reactivate = std::clamp(sensitivity, 0.02f, 0.95f);
+
+    if (mode == SocdMode::Global)
+    {
+        if (lastKeyPriority)
+        {
+            mode = SocdMode::LastWins;
+            ax.snap = snapStick ? 1.0f : 0.0f;
+        }
+        else
+        {
+            mode = snapStick ? SocdMode::AnalogMax : SocdMode::Sum;
+        }
+    }
+    if ((size_t)mode >= (size_t)SocdMode::Count) mode = SocdMode::Sum;
+
+    ax.fn = kResolvers[(size_t)mode];
+    return ax;
+}
+
+void Socd_SetMode(int pad, int axis, SocdMode mode)
+{
+    if (!ValidSlot(pad, axis)) return;
+    if ((size_t)mode >= (size_t)SocdMode::Count) mode = SocdMode::Global;
+    g_modes[(size_t)(pad * SOCD_AXES + axis)].store((uint8_t)mode, std::memory_order_release);
+    g_generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+SocdMode Socd_GetMode(int pad, int axis)
+{
+    if (!ValidSlot(pad, axis)) return SocdMode::Global;
+    return (SocdMode)g_modes[(size_t)(pad * SOCD_AXES + axis)].load(std::memory_order_acquire);
+}
+
+void Socd_ResetModes()
+{
+    for (auto& m : g_modes) m.store((uint8_t)SocdMode::Global, std::memory_order_release);
+    g_generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+uint32_t Socd_ConfigGeneration()
+{
+    return g_generation.load(std::memory_order_acquire);
+}
@@ -0,0 +1,77 @@
+// socd.h
+#pragma once
+#include <cstdint>
+
+// ============================================================
+// SOCD (Simultaneous Opposing Cardinal Directions)
+// How one stick axis resolves its two keys (minus / plus) when both are held.
+// One strategy per axis and per pad:
+// - Sum:          plus - minus (no resolution, the old default)
+// - Neutral:      both held = centre
+// - LastWins:     the key pressed last wins; a held key that goes back down
+//                 by the reactivation sensitivity from its lowest point
+//                 counts as pressed again (the old Last Key Priority)
+// - FirstWins:    the key held first keeps the axis until it is released
+// - PriorityMinus / PriorityPlus: that side always wins
+// - AnalogMax:    the deeper key wins with its full depth, ties go to the
+//                 last pressed (the old Snap Stick)
+// Global follows the Snap Stick / Last Key Priority toggles of the settings.
+//
+// Socd_Compile turns a mode into a SocdAxis (one function per strategy, no
+// branch on the mode) once, when the settings change; the realtime thread
+// then only calls Socd_Resolve with the packed state of the axis.
+// Portable (no Win32).
+// ============================================================
+
+constexpr int SOCD_MAX_PADS = 16;     // = BINDINGS_MAX_GAMEPADS
+constexpr int SOCD_AXES = 4;          // LX, LY, RX, RY (Axis order)
+constexpr float SOCD_PRESS_V = 0.10f; // a direction counts as held from this value
+
+enum class SocdMode : uint8_t
+{
+    Global = 0,
+    Sum,
+    Neutral,
+    LastWins,
+    FirstWins,
+    PriorityMinus,
+    PriorityPlus,
+    AnalogMax,
+    Count
+};
+
+// Per axis state, owned by the realtime thread. Zero / default = released.
+struct SocdAxisState
+{
+    float   minusValley = 1.0f;  // LastWins: lowest point since the last (re)press
+    float   plusValley = 1.0f;
+    uint8_t prevDown = 0;        // bit 0 minus, bit 1 plus
+    int8_t  lastDir = 0;         // -1 / +1: direction pressed last
+    int8_t  firstDir = 0;        // -1 / +1: direction held first (FirstWins)
+};
+
+struct SocdAxis;
+using SocdResolveFn = float (*)(SocdAxisState& st, const SocdAxis& axis, float minusV, float plusV);
+
+struct SocdAxis
+{
+    SocdResolveFn fn = nullptr;
+    float reactivate = 0.12f;    // LastWins reactivation sensitivity (0.02..0.95)
+    float snap = 0.0f;           // LastWins: 1 = the winner gets the deeper value (Snap Stick)
+};
+
+// Global is resolved here from the two legacy toggles.
+SocdAxis Socd_Compile(SocdMode mode, bool snapStick, bool lastKeyPriority, float sensitivity);
+
+// Returns the axis value (-1..1) from the two directions (0..1).
+inline float Socd_Resolve(SocdAxisState& st, const SocdAxis& axis, float minusV, float plusV)
+{
+    return axis.fn(st, axis, minusV, plusV);
+}
+
+// ---- Config (any thread) ----
+void     Socd_SetMode(int pad, int axis, SocdMode mode);
+SocdMode Socd_GetMode(int pad, int axis);
+void     Socd_ResetModes();
+// Changes with every Socd_SetMode / Socd_ResetModes: recompile when it moves.
+uint32_t Socd_ConfigGeneration();
@@ -0,0 +1,67 @@
+// spsc_ring.h
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Single-producer / single-consumer ring buffer, lock-free and allocation-free.
+// Used to hand events from a latency-critical thread (LL hooks, realtime loop)
+// to a worker thread without ever blocking the producer.
+//
+// - Capacity must be a power of two.
+// - TryPush() only from the producer thread, TryPop() only from the consumer thread.
+// - When full, TryPush() fails: the producer decides whether to drop or count it.
+template <typename T, size_t Capacity>
+struct SpscRing
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+    static constexpr size_t kMask = Capacity - 1;
+
+    bool TryPush(const T& v)
+    {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h - tailCache >= Capacity)
+        {
+            tailCache = tail.load(std::memory_order_acquire);
+            if (h - tailCache >= Capacity)
+                return false;
+        }
+        slots[h & kMask] = v;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& out)
+    {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t == headCache)
+        {
+            headCache = head.load(std::memory_order_acquire);
+            if (t == headCache)
+                return false;
+        }
+        out = slots[t & kMask];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool EmptyApprox() const
+    {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    size_t SizeApprox() const
+    {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    // Producer side (own cache line, consumer never writes here)
+    alignas(64) std::atomic<size_t> head{ 0 };
+    size_t tailCache = 0;
+
+    // Consumer side
+    alignas(64) std::atomic<size_t> tail{ 0 };
+    size_t headCache = 0;
+
+    alignas(64) T slots[Capacity]{};
+};
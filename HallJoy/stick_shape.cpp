@@ -0,0 +1,181 @@
+// stick_shape.cpp
+#include "stick_shape.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+
+namespace
+{
+    constexpr float kPi = 3.14159265358979f;
+    constexpr int   kAtanSteps = 256;
+    constexpr float kQuarter = STICK_SHAPE_ANGLE_STEPS / 4.0f;   // 90 degrees in angle buckets
+    constexpr float kDiag = 0.70710678f;
+
+    constexpr float kSnapX[8] = { 1.0f, kDiag, 0.0f, -kDiag, -1.0f, -kDiag, 0.0f, kDiag };
+    constexpr float kSnapY[8] = { 0.0f, kDiag, 1.0f, kDiag, 0.0f, -kDiag, -1.0f, -kDiag };
+
+    // atan(i / kAtanSteps) in angle buckets: the angle of any (x, y) from
+    // its octant ratio, no atan2 per tick.
+    struct AtanTable
+    {
+        float v[kAtanSteps + 1];
+        AtanTable()
+        {
+            for (int i = 0; i <= kAtanSteps; ++i)
+                v[i] = std::atan((float)i / kAtanSteps) * (STICK_SHAPE_ANGLE_STEPS / (2.0f * kPi));
+        }
+    };
+    const AtanTable g_atan;
+
+    int AngleBucket(float x, float y)
+    {
+        const float ax = std::fabs(x), ay = std::fabs(y);
+        const float hi = std::max(ax, ay), lo = std::min(ax, ay);
+        const float oct = g_atan.v[(int)(lo / hi * kAtanSteps + 0.5f)];
+        float a = (ay > ax) ? kQuarter - oct : oct;         // first quadrant
+        if (x < 0.0f) a = 2.0f * kQuarter - a;
+        if (y < 0.0f) a = 4.0f * kQuarter - a;
+        return (int)a & (STICK_SHAPE_ANGLE_STEPS - 1);
+    }
+
+    // Packed config: one atomic per stick, the realtime thread reads it
+    // without a lock when it recompiles.
+    uint64_t Pack(const StickShapeConfig& c)
+    {
+        return (uint64_t)(c.circle ? 1u : 0u)
+            | ((uint64_t)c.innerM << 1)
+            | ((uint64_t)c.outerM << 11)
+            | ((uint64_t)c.antiDzM << 21)
+            | ((uint64_t)c.gammaM << 31)
+            | ((uint64_t)c.snap << 43)
+            | ((uint64_t)c.snapDeg << 45);
+    }
+
+    StickShapeConfig Unpack(uint64_t v)
+    {
+        StickShapeConfig c;
+        c.circle = (v & 1u) != 0;
+        c.innerM = (uint16_t)((v >> 1) & 0x3FF);
+        c.outerM = (uint16_t)((v >> 11) & 0x3FF);
+        c.antiDzM = (uint16_t)((v >> 21) & 0x3FF);
+        c.gammaM = (uint16_t)((v >> 31) & 0xFFF);
+        c.snap = (StickSnap)((v >> 43) & 0x3);
+        c.snapDeg = (uint8_t)((v >> 45) & 0x3F);
+        return c;
+    }
+
+    struct Slots
+    {
+        std::array<std::atomic<uint64_t>, STICK_SHAPE_MAX_PADS * STICK_SHAPE_STICKS> v;
+        Slots() { for (auto& s : v) s.store(Pack(StickShapeConfig{}), std::memory_order_relaxed); }
+    } g_slots;
+    std::atomic<uint32_t> g_generation{ 0 };
+
+    bool ValidSlot(int pad, int stick)
+    {
+        return pad >= 0 && pad < STICK_SHAPE_MAX_PADS && stick >= 0 && stick < STICK_SHAPE_STICKS;
+    }
+}
+
+StickShapeConfig StickShape_Sanitize(const StickShapeConfig& cfg)
+{
+    StickShapeConfig c = cfg;
+    c.innerM = std::min<uint16_t>(c.innerM, 900);
+    c.outerM = std::clamp<uint16_t>(c.outerM, (uint16_t)std::max(100, c.innerM + 50), 1000);
+    c.antiDzM = std::min<uint16_t>(c.antiDzM, 900);
+    c.gammaM = std::clamp<uint16_t>(c.gammaM, 250, 4000);
+    if ((uint8_t)c.snap > (uint8_t)StickSnap::Eight) c.snap = StickSnap::Off;
+    c.snapDeg = std::clamp<uint8_t>(c.snapDeg, 1, (c.snap == StickSnap::Eight) ? 22 : 45);
+    return c;
+}
+
+void StickShape_Compile(const StickShapeConfig& cfgIn, StickShapeTables& out)
+{
+    const StickShapeConfig cfg = StickShape_Sanitize(cfgIn);
+    out.identity = cfg.IsIdentity();
+    out.circle = cfg.circle;
+    out.inner = cfg.innerM / 1000.0f;
+
+    const float outer = cfg.outerM / 1000.0f;
+    const float anti = cfg.antiDzM / 1000.0f;
+    const float gamma = cfg.gammaM / 1000.0f;
+    for (int i = 0; i <= STICK_SHAPE_RADIAL_STEPS; ++i)
+    {
+        const float r = (float)i / STICK_SHAPE_RADIAL_STEPS;
+        float u = std::clamp((r - out.inner) / (outer - out.inner), 0.0f, 1.0f);
+        if (cfg.gammaM != 1000) u = std::pow(u, gamma);
+        // The step at the inner deadzone is applied in StickShape_Apply, the
+        // table holds the curve from its edge on.
+        out.radial[i] = anti + (1.0f - anti) * u;
+    }
+
+    const float step = 360.0f / STICK_SHAPE_ANGLE_STEPS;
+    const float dirDeg = (cfg.snap == StickSnap::Four) ? 90.0f : 45.0f;
+    for (int b = 0; b < STICK_SHAPE_ANGLE_STEPS; ++b)
+    {
+        out.snapDir[b] = 0xFF;
+        if (cfg.snap == StickSnap::Off) continue;
+
+        const float deg = (b + 0.5f) * step;
+        const float k = std::round(deg / dirDeg);
+        if (std::fabs(deg - k * dirDeg) <= (float)cfg.snapDeg)
+            out.snapDir[b] = (uint8_t)((int)(k * dirDeg / 45.0f) & 7);
+    }
+}
+
+void StickShape_Apply(const StickShapeTables& t, float& x, float& y)
+{
+    if (t.identity) return;
+
+    x = std::clamp(x, -1.0f, 1.0f);
+    y = std::clamp(y, -1.0f, 1.0f);
+    const float len = std::sqrt(x * x + y * y);
+    if (len <= 1e-6f) { x = y = 0.0f; return; }
+
+    // Square: (1, 1) has radius 1, the Chebyshev norm of the pair.
+    const float rIn = t.circle ? std::max(std::fabs(x), std::fabs(y)) : std::min(len, 1.0f);
+    if (rIn <= t.inner) { x = y = 0.0f; return; }
+
+    const float f = rIn * STICK_SHAPE_RADIAL_STEPS;
+    const int i = std::min((int)f, STICK_SHAPE_RADIAL_STEPS - 1);
+    const float rOut = t.radial[i] + (t.radial[i + 1] - t.radial[i]) * (f - (float)i);
+
+    const uint8_t snap = t.snapDir[AngleBucket(x, y)];
+    if (snap != 0xFF)
+    {
+        x = kSnapX[snap] * rOut;
+        y = kSnapY[snap] * rOut;
+    }
+    else
+    {
+        const float k = rOut / len;
+        x *= k;
+        y *= k;
+    }
+}
+
+void StickShape_Set(int pad, int stick, const StickShapeConfig& cfg)
+{
+    if (!ValidSlot(pad, stick)) return;
+    g_slots.v[(size_t)(pad * STICK_SHAPE_STICKS + stick)].store(Pack(StickShape_Sanitize(cfg)), std::memory_order_release);
+    g_generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+StickShapeConfig StickShape_Get(int pad, int stick)
+{
+    if (!ValidSlot(pad, stick)) return StickShapeConfig{};
+    return Unpack(g_slots.v[(size_t)(pad * STICK_SHAPE_STICKS + stick)].load(std::memory_order_acquire));
+}
+
+void StickShape_ResetAll()
+{
+    for (auto& s : g_slots.v) s.store(Pack(StickShapeConfig{}), std::memory_order_release);
+    g_generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+uint32_t StickShape_ConfigGeneration()
+{
+    return g_generation.load(std::memory_order_acquire);
+}
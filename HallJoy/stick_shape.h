@@ -0,0 +1,72 @@
+// stick_shape.h
+#pragma once
+#include <cstdint>
+
+// ============================================================
+// STICK SHAPING (2D)
+// Runs after the per-axis stage (curves, SOCD) on the (x, y) pair of a stick:
+// - square to circle: the key pair covers a square, the diagonal (1, 1) is
+//                     mapped onto the unit circle instead of its corner
+// - radial deadzones: inner (below = centre) and outer (above = full tilt)
+// - anti-deadzone:    output radius right outside the inner deadzone, for
+//                     games with their own deadzone
+// - response curve:   radius exponent between the two deadzones
+// - angular snapping: 4-way or 8-way, inside a window of +-snapDeg around
+//                     each direction; outside the windows the angle is kept
+// The config is compiled into a radial table (radius in -> radius out) and
+// an angular table (angle bucket -> snap direction), so applying it costs
+// the same for every position: two table reads, one sqrt, one divide.
+// The default config is the identity: the axes stay independent as before.
+// Portable (no Win32).
+// ============================================================
+
+constexpr int STICK_SHAPE_MAX_PADS = 16;       // = BINDINGS_MAX_GAMEPADS
+constexpr int STICK_SHAPE_STICKS = 2;          // 0 = left, 1 = right
+constexpr int STICK_SHAPE_RADIAL_STEPS = 1024;
+constexpr int STICK_SHAPE_ANGLE_STEPS = 1024;  // full turn
+
+enum class StickSnap : uint8_t
+{
+    Off = 0,
+    Four,
+    Eight,
+};
+
+struct StickShapeConfig
+{
+    bool      circle = false;   // square to circle
+    uint16_t  innerM = 0;       // 0..900 (1/1000 of the radius)
+    uint16_t  outerM = 1000;    // > innerM, 100..1000
+    uint16_t  antiDzM = 0;      // 0..900
+    uint16_t  gammaM = 1000;    // radius exponent x1000, 250..4000 (1000 = linear)
+    StickSnap snap = StickSnap::Off;
+    uint8_t   snapDeg = 10;     // half window, 1..45 (4-way) / 1..22 (8-way)
+
+    bool IsIdentity() const
+    {
+        return !circle && innerM == 0 && outerM == 1000 && antiDzM == 0 && gammaM == 1000
+            && snap == StickSnap::Off;
+    }
+};
+
+struct StickShapeTables
+{
+    bool    identity = true;
+    bool    circle = false;
+    float   inner = 0.0f;
+    float   radial[STICK_SHAPE_RADIAL_STEPS + 1]{};   // radius in [0..1] -> radius out
+    uint8_t snapDir[STICK_SHAPE_ANGLE_STEPS]{};       // 0..7 = k * 45 degrees, 0xFF = keep
+};
+
+// Clamps the config to its ranges.
+StickShapeConfig StickShape_Sanitize(const StickShapeConfig& cfg);
+void StickShape_Compile(const StickShapeConfig& cfg, StickShapeTables& out);
+// x, y: -1..1 in, shaped in place.
+void StickShape_Apply(const StickShapeTables& t, float& x, float& y);
+
+// ---- Config (any thread) ----
+void             StickShape_Set(int pad, int stick, const StickShapeConfig& cfg);
+StickShapeConfig StickShape_Get(int pad, int stick);
+void             StickShape_ResetAll();
+// Changes with every Set / ResetAll: recompile when it moves.
+uint32_t         StickShape_ConfigGeneration();
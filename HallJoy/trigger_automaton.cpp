@@ -0,0 +1,193 @@
+// trigger_automaton.cpp
+#include "trigger_automaton.h"
+
+#include <utility>
+
+void TriggerAutomaton::Clear()
+{
+    m_nodes.assign(1, Node{});
+    m_pending.assign(1, {});
+    m_edges.clear();
+    m_rootNext.clear();
+    m_out.clear();
+    m_patterns.clear();
+    m_heldSyms.clear();
+    m_maxGapMs = 0;
+    m_built = false;
+    Reset();
+}
+
+int TriggerAutomaton::HeldBit(TriggerSymbol sym, bool create)
+{
+    for (size_t i = 0; i < m_heldSyms.size(); ++i)
+        if (m_heldSyms[i] == sym) return (int)i;
+    if (!create || (int)m_heldSyms.size() >= TRIGGER_MAX_HELD_SYMBOLS) return -1;
+    m_heldSyms.push_back(sym);
+    return (int)m_heldSyms.size() - 1;
+}
+
+bool TriggerAutomaton::Add(const TriggerPattern& p)
+{
+    if (p.stepCount == 0 || p.stepCount > TRIGGER_MAX_STEPS) return false;
+    if (m_nodes.empty()) Clear();   // before HeldBit: Clear() empties the held symbols
+
+    Compiled c;
+    c.id = p.id;
+    c.maxGapMs = p.maxGapMs;
+    for (int i = 0; i < p.stepCount; ++i) {
+        const TriggerStep& st = p.steps[i];
+        if (st.key >= TRIGGER_SYM_COUNT || st.withCount > TRIGGER_MAX_WITH) return false;
+        for (int w = 0; w < st.withCount; ++w) {
+            if (st.with[w] >= TRIGGER_SYM_COUNT) return false;
+            int bit = HeldBit(st.with[w], true);
+            if (bit < 0) return false;
+            c.required[i] |= 1ull << bit;
+        }
+    }
+
+    int32_t node = 0;
+    for (int i = 0; i < p.stepCount; ++i) {
+        const uint64_t key = EdgeKey(node, p.steps[i].key);
+        auto it = m_edges.find(key);
+        if (it != m_edges.end()) { node = it->second; continue; }
+        Node n;
+        n.depth = m_nodes[(size_t)node].depth + 1;
+        m_nodes.push_back(n);
+        m_pending.emplace_back();
+        const int32_t child = (int32_t)m_nodes.size() - 1;
+        m_edges.emplace(key, child);
+        node = child;
+    }
+    m_pending[(size_t)node].push_back((uint32_t)m_patterns.size());
+    m_patterns.push_back(c);
+    if (p.stepCount > 1 && p.maxGapMs > m_maxGapMs) m_maxGapMs = p.maxGapMs;
+    m_built = false;
+    return true;
+}
+
+bool TriggerAutomaton::AddChord(uint32_t id, const TriggerSymbol* keys, int count)
+{
+    if (!keys || count <= 0 || count > TRIGGER_MAX_WITH + 1) return false;
+    bool ok = true;
+    for (int last = 0; last < count; ++last) {
+        TriggerPattern p;
+        p.id = id;
+        p.stepCount = 1;
+        p.steps[0].key = keys[last];
+        for (int i = 0; i < count; ++i)
+            if (i != last) p.steps[0].with[p.steps[0].withCount++] = keys[i];
+        ok = Add(p) && ok;
+    }
+    return ok;
+}
+
+int32_t TriggerAutomaton::Goto(int32_t node, TriggerSymbol sym) const
+{
+    if (node == 0) {
+        const int32_t n = m_rootNext[sym];
+        return n ? n : -1;
+    }
+    auto it = m_edges.find(EdgeKey(node, sym));
+    return (it != m_edges.end()) ? it->second : -1;
+}
+
+void TriggerAutomaton::Build()
+{
+    if (m_nodes.empty()) Clear();
+
+    std::vector<std::vector<std::pair<TriggerSymbol, int32_t>>> children(m_nodes.size());
+    for (const auto& e : m_edges)
+        children[(size_t)(e.first >> 16)].push_back({ (TriggerSymbol)(e.first & 0xFFFF), e.second });
+
+    m_rootNext.assign(TRIGGER_SYM_COUNT, 0);
+    for (const auto& c : children[0])
+        m_rootNext[c.first] = c.second;
+
+    // Breadth first: a failure link always points to a shallower, already linked node
+    std::vector<int32_t> order;
+    order.reserve(m_nodes.size());
+    m_nodes[0].fail = 0;
+    m_nodes[0].dict = 0;
+    order.push_back(0);
+    for (size_t qi = 0; qi < order.size(); ++qi) {
+        const int32_t u = order[qi];
+        for (const auto& c : children[(size_t)u]) {
+            const int32_t v = c.second;
+            int32_t f = 0;
+            if (u != 0) {
+                f = m_nodes[(size_t)u].fail;
+                int32_t g;
+                while ((g = Goto(f, c.first)) < 0 && f != 0) f = m_nodes[(size_t)f].fail;
+                f = (g >= 0) ? g : 0;
+            }
+            m_nodes[(size_t)v].fail = f;
+            m_nodes[(size_t)v].dict = m_pending[(size_t)f].empty() ? m_nodes[(size_t)f].dict : f;
+            order.push_back(v);
+        }
+    }
+
+    m_out.clear();
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+        m_nodes[i].outBegin = (uint32_t)m_out.size();
+        m_nodes[i].outCount = (uint32_t)m_pending[i].size();
+        m_out.insert(m_out.end(), m_pending[i].begin(), m_pending[i].end());
+    }
+    m_built = true;
+    Reset();
+}
+
+void TriggerAutomaton::Reset()
+{
+    m_state = 0;
+    m_lastMs = 0;
+    m_histPos = 0;
+}
+
+int TriggerAutomaton::Press(TriggerSymbol sym, uint32_t timeMs, TriggerHeldFn held, void* user, std::vector<uint32_t>* out)
+{
+    if (!m_built || sym >= TRIGGER_SYM_COUNT) return 0;
+
+    // Too late for every sequence: restart from the root
+    if (m_state != 0 && timeMs - m_lastMs > m_maxGapMs) m_state = 0;
+    m_lastMs = timeMs;
+
+    int32_t s = m_state, next;
+    while ((next = Goto(s, sym)) < 0 && s != 0) s = m_nodes[(size_t)s].fail;
+    m_state = (next < 0) ? 0 : next;
+    if (m_state == 0) return 0; // key used by no trigger
+
+    uint64_t heldMask = 0;
+    if (held) {
+        for (size_t i = 0; i < m_heldSyms.size(); ++i)
+            if (held(user, m_heldSyms[i])) heldMask |= 1ull << i;
+    }
+    const uint32_t slot = m_histPos % TRIGGER_MAX_STEPS;
+    m_histTime[slot] = timeMs;
+    m_histHeld[slot] = heldMask;
+    ++m_histPos;
+
+    int found = 0;
+    int32_t v = m_state;
+    if (m_nodes[(size_t)v].outCount == 0) v = m_nodes[(size_t)v].dict;
+    for (; v != 0; v = m_nodes[(size_t)v].dict) {
+        const Node& n = m_nodes[(size_t)v];
+        for (uint32_t k = n.outBegin; k < n.outBegin + n.outCount; ++k) {
+            const Compiled& c = m_patterns[m_out[k]];
+            bool ok = true;
+            // Walk the last `depth` presses backwards: held requirements + gaps
+            for (uint32_t back = 0; back < n.depth && ok; ++back) {
+                const uint32_t hs = (m_histPos - 1 - back) % TRIGGER_MAX_STEPS;
+                const uint64_t req = c.required[n.depth - 1 - back];
+                if ((m_histHeld[hs] & req) != req) ok = false;
+                else if (back + 1 < n.depth) {
+                    const uint32_t prev = (m_histPos - 2 - back) % TRIGGER_MAX_STEPS;
+                    if (m_histTime[hs] - m_histTime[prev] > c.maxGapMs) ok = false;
+                }
+            }
+            if (!ok) continue;
+            if (out) out->push_back(c.id);
+            ++found;
+        }
+    }
+    return found;
+}
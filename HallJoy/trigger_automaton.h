@@ -0,0 +1,122 @@
+// trigger_automaton.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// ============================================================
+// TRIGGER AUTOMATON
+// Every combo trigger (single key, chord, timed sequence, double / triple
+// tap) is compiled into one shared Aho-Corasick automaton over pressed
+// symbols. A press advances a single state; the cost depends on the depth
+// of the longest pattern and on the triggers that end on that exact key
+// sequence, never on the total number of triggers.
+//
+// - Step: the pressed symbol + up to TRIGGER_MAX_WITH symbols that must be
+//   held at that moment (chord / modifier / held button). Other held keys
+//   are ignored.
+// - Sequence: up to TRIGGER_MAX_STEPS steps, each press at most maxGapMs
+//   after the previous one. Any unrelated press in between breaks it.
+// - Held state is read through a callback at press time, so aliases
+//   (left / right Ctrl -> Ctrl) and the canonical state stay with the caller.
+//
+// Portable (no Win32). Not thread-safe: the owner serialises Press / Build.
+// ============================================================
+
+using TriggerSymbol = uint16_t;
+
+// 0x00..0xFF: Windows virtual-key codes. Above: mouse and generic modifiers.
+constexpr TriggerSymbol TRIGGER_SYM_MOUSE_LEFT   = 0x100;
+constexpr TriggerSymbol TRIGGER_SYM_MOUSE_RIGHT  = 0x101;
+constexpr TriggerSymbol TRIGGER_SYM_MOUSE_MIDDLE = 0x102;
+constexpr TriggerSymbol TRIGGER_SYM_MOUSE_X1     = 0x103;
+constexpr TriggerSymbol TRIGGER_SYM_MOUSE_X2     = 0x104;
+constexpr TriggerSymbol TRIGGER_SYM_WHEEL_UP     = 0x105; // press only, never held
+constexpr TriggerSymbol TRIGGER_SYM_WHEEL_DOWN   = 0x106;
+constexpr TriggerSymbol TRIGGER_SYM_CTRL         = 0x107; // either side
+constexpr TriggerSymbol TRIGGER_SYM_SHIFT        = 0x108;
+constexpr TriggerSymbol TRIGGER_SYM_ALT          = 0x109;
+constexpr TriggerSymbol TRIGGER_SYM_WIN          = 0x10A;
+constexpr int TRIGGER_SYM_COUNT = 0x110;
+
+constexpr int TRIGGER_MAX_STEPS = 8;
+constexpr int TRIGGER_MAX_WITH = 3;
+// Distinct "with" symbols over all patterns (one bit each in the held snapshot)
+constexpr int TRIGGER_MAX_HELD_SYMBOLS = 64;
+
+struct TriggerStep
+{
+    TriggerSymbol key = 0;
+    uint8_t       withCount = 0;
+    TriggerSymbol with[TRIGGER_MAX_WITH]{};
+};
+
+struct TriggerPattern
+{
+    uint32_t    id = 0;          // returned by Press() on match (not unique: chords add one per order)
+    uint32_t    maxGapMs = 500;  // between two consecutive steps
+    uint8_t     stepCount = 0;
+    TriggerStep steps[TRIGGER_MAX_STEPS];
+};
+
+// true if `sym` is currently held
+using TriggerHeldFn = bool (*)(void* user, TriggerSymbol sym);
+
+class TriggerAutomaton
+{
+public:
+    void Clear();
+    // false: empty / too long pattern, symbol out of range, too many held symbols.
+    bool Add(const TriggerPattern& pattern);
+    // N keys held together, pressed in any order (one single-step pattern per last key).
+    bool AddChord(uint32_t id, const TriggerSymbol* keys, int count);
+    // Failure links + output lists. Required after Add / AddChord, Press() is a no-op before.
+    void Build();
+
+    // Forget any sequence in progress.
+    void Reset();
+    // Advance on a press (no key-ups, no OS auto-repeat). Appends the id of every
+    // pattern completed by this press to `out`, returns how many.
+    int Press(TriggerSymbol sym, uint32_t timeMs, TriggerHeldFn held, void* user, std::vector<uint32_t>* out);
+
+    size_t PatternCount() const { return m_patterns.size(); }
+    size_t StateCount() const { return m_nodes.size(); }
+
+private:
+    struct Node
+    {
+        int32_t  fail = 0;
+        int32_t  dict = 0;       // nearest proper suffix with outputs (0 = none)
+        uint32_t depth = 0;
+        uint32_t outBegin = 0;
+        uint32_t outCount = 0;
+    };
+    struct Compiled
+    {
+        uint32_t id = 0;
+        uint32_t maxGapMs = 0;
+        uint64_t required[TRIGGER_MAX_STEPS]{};
+    };
+
+    static uint64_t EdgeKey(int32_t node, TriggerSymbol sym) { return ((uint64_t)(uint32_t)node << 16) | sym; }
+    int32_t Goto(int32_t node, TriggerSymbol sym) const;
+    int HeldBit(TriggerSymbol sym, bool create);
+
+    std::vector<Node>                     m_nodes;
+    std::unordered_map<uint64_t, int32_t> m_edges;
+    std::vector<int32_t>                  m_rootNext;  // root transitions, direct index
+    std::vector<std::vector<uint32_t>>    m_pending;   // outputs per node, source of Build()
+    std::vector<uint32_t>                 m_out;       // pattern indices, grouped per node
+    std::vector<Compiled>                 m_patterns;
+    std::vector<TriggerSymbol>            m_heldSyms;  // bit i of a snapshot = m_heldSyms[i] held
+    uint32_t                              m_maxGapMs = 0;
+    bool                                  m_built = false;
+
+    // Progress
+    int32_t  m_state = 0;
+    uint32_t m_lastMs = 0;
+    uint32_t m_histTime[TRIGGER_MAX_STEPS]{};
+    uint64_t m_histHeld[TRIGGER_MAX_STEPS]{};
+    uint32_t m_histPos = 0;
+};
@@ -0,0 +1,179 @@
+// uinput_pad_sink.cpp
+#include "uinput_pad_sink.h"
+
+#if defined(__linux__)
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+// XUSB button bit -> evdev key, xpad order
+static const struct { uint16_t bit; uint16_t code; } kButtons[] = {
+    { PAD_BTN_A, BTN_SOUTH },
+    { PAD_BTN_B, BTN_EAST },
+    { PAD_BTN_X, BTN_NORTH },
+    { PAD_BTN_Y, BTN_WEST },
+    { PAD_BTN_LEFT_SHOULDER, BTN_TL },
+    { PAD_BTN_RIGHT_SHOULDER, BTN_TR },
+    { PAD_BTN_BACK, BTN_SELECT },
+    { PAD_BTN_START, BTN_START },
+    { PAD_BTN_GUIDE, BTN_MODE },
+    { PAD_BTN_LEFT_THUMB, BTN_THUMBL },
+    { PAD_BTN_RIGHT_THUMB, BTN_THUMBR },
+};
+
+static_assert(std::size(kButtons) + 4 + 2 + 2 + 1 <= UINPUT_PAD_MAX_EVENTS, "one report fits one write");
+
+UinputPadSink::UinputPadSink(const char* devicePath) : m_path(devicePath)
+{
+    std::fill(std::begin(m_fd), std::end(m_fd), -1);
+}
+
+static bool SetupAbs(int fd, uint16_t code, int32_t min, int32_t max, int32_t fuzz, int32_t flat)
+{
+    uinput_abs_setup abs{};
+    abs.code = code;
+    abs.absinfo.minimum = min;
+    abs.absinfo.maximum = max;
+    abs.absinfo.fuzz = fuzz;
+    abs.absinfo.flat = flat;
+    return ioctl(fd, UI_ABS_SETUP, &abs) == 0;
+}
+
+// One Xbox 360 pad (xpad ids). Needs UI_DEV_SETUP (Linux 4.5+).
+static int CreatePadDevice(const char* path, int index, int* outErr)
+{
+    const int fd = open(path, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) { *outErr = errno; return -1; }
+
+    bool ok = ioctl(fd, UI_SET_EVBIT, EV_KEY) == 0
+        && ioctl(fd, UI_SET_EVBIT, EV_ABS) == 0
+        && ioctl(fd, UI_SET_EVBIT, EV_SYN) == 0;
+    for (const auto& b : kButtons)
+        ok = ok && ioctl(fd, UI_SET_KEYBIT, b.code) == 0;
+    for (uint16_t axis : { ABS_X, ABS_Y, ABS_RX, ABS_RY, ABS_Z, ABS_RZ, ABS_HAT0X, ABS_HAT0Y })
+        ok = ok && ioctl(fd, UI_SET_ABSBIT, axis) == 0;
+
+    ok = ok && SetupAbs(fd, ABS_X, -32768, 32767, 16, 128) && SetupAbs(fd, ABS_Y, -32768, 32767, 16, 128)
+        && SetupAbs(fd, ABS_RX, -32768, 32767, 16, 128) && SetupAbs(fd, ABS_RY, -32768, 32767, 16, 128)
+        && SetupAbs(fd, ABS_Z, 0, 255, 0, 0) && SetupAbs(fd, ABS_RZ, 0, 255, 0, 0)
+        && SetupAbs(fd, ABS_HAT0X, -1, 1, 0, 0) && SetupAbs(fd, ABS_HAT0Y, -1, 1, 0, 0);
+
+    uinput_setup setup{};
+    setup.id.bustype = BUS_USB;
+    setup.id.vendor = 0x045E;    // Microsoft
+    setup.id.product = 0x028E;   // Xbox 360 Controller
+    setup.id.version = 0x0110;
+    snprintf(setup.name, sizeof(setup.name), "Microsoft X-Box 360 pad %d", index);
+    ok = ok && ioctl(fd, UI_DEV_SETUP, &setup) == 0
+        && ioctl(fd, UI_DEV_CREATE) == 0;
+
+    if (!ok)
+    {
+        *outErr = errno;
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool UinputPadSink::Connect(int count, int* outErr)
+{
+    Disconnect();
+    count = std::clamp(count, 1, PAD_SINK_MAX_PADS);
+    int err = 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        const int fd = CreatePadDevice(m_path, i, &err);
+        if (fd < 0) { Disconnect(); if (outErr) *outErr = err; return false; }
+        m_fd[i] = fd;
+        m_sent[i] = false;
+        m_count = i + 1;
+    }
+    if (outErr) *outErr = 0;
+    return true;
+}
+
+void UinputPadSink::Disconnect()
+{
+    for (int i = 0; i < m_count; ++i)
+    {
+        if (m_fd[i] < 0) continue;
+        ioctl(m_fd[i], UI_DEV_DESTROY);
+        close(m_fd[i]);
+        m_fd[i] = -1;
+    }
+    m_count = 0;
+}
+
+int UinputPadSink::Encode(const PadReport& prev, const PadReport& next, bool full, input_event* out)
+{
+    int n = 0;
+    auto put = [&](uint16_t type, uint16_t code, int32_t value) {
+        out[n] = input_event{};
+        out[n].type = type;
+        out[n].code = code;
+        out[n].value = value;
+        ++n;
+    };
+    auto axis = [&](uint16_t code, int32_t before, int32_t after) {
+        if (full || before != after) put(EV_ABS, code, after);
+    };
+    // XInput: Y up is positive; evdev: down is positive (same ~y as xpad)
+    auto flipY = [](int16_t y) { return (int32_t)(int16_t)~y; };
+    auto hat = [](uint16_t b, uint16_t minus, uint16_t plus) {
+        return (int32_t)((b & plus) ? 1 : 0) - (int32_t)((b & minus) ? 1 : 0);
+    };
+
+    const uint16_t changed = full ? 0xFFFFu : (uint16_t)(prev.buttons ^ next.buttons);
+    for (const auto& b : kButtons)
+        if (changed & b.bit) put(EV_KEY, b.code, (next.buttons & b.bit) ? 1 : 0);
+
+    axis(ABS_X, prev.lx, next.lx);
+    axis(ABS_Y, flipY(prev.ly), flipY(next.ly));
+    axis(ABS_RX, prev.rx, next.rx);
+    axis(ABS_RY, flipY(prev.ry), flipY(next.ry));
+    axis(ABS_Z, prev.leftTrigger, next.leftTrigger);
+    axis(ABS_RZ, prev.rightTrigger, next.rightTrigger);
+    axis(ABS_HAT0X, hat(prev.buttons, PAD_BTN_DPAD_LEFT, PAD_BTN_DPAD_RIGHT), hat(next.buttons, PAD_BTN_DPAD_LEFT, PAD_BTN_DPAD_RIGHT));
+    axis(ABS_HAT0Y, hat(prev.buttons, PAD_BTN_DPAD_UP, PAD_BTN_DPAD_DOWN), hat(next.buttons, PAD_BTN_DPAD_UP, PAD_BTN_DPAD_DOWN));
+
+    if (n == 0) return 0;
+    put(EV_SYN, SYN_REPORT, 0);
+    return n;
+}
+
+bool UinputPadSink::Update(int pad, const PadReport& report, int* outErr)
+{
+    if (outErr) *outErr = 0;
+    if (pad < 0 || pad >= m_count || m_fd[pad] < 0)
+    {
+        if (outErr) *outErr = ENODEV;
+        return false;
+    }
+
+    input_event ev[UINPUT_PAD_MAX_EVENTS];
+    const int n = Encode(m_last[pad], report, !m_sent[pad], ev);
+    if (n == 0) return true;
+
+    // The kernel stamps the events; one write for the whole report
+    const ssize_t bytes = (ssize_t)(sizeof(input_event) * (size_t)n);
+    if (write(m_fd[pad], ev, (size_t)bytes) != bytes)
+    {
+        if (outErr) *outErr = errno ? errno : EIO;
+        return false;
+    }
+    m_last[pad] = report;
+    m_sent[pad] = true;
+    return true;
+}
+
+#endif
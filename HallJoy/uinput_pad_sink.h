@@ -0,0 +1,45 @@
+// uinput_pad_sink.h
+#pragma once
+#include <cstdint>
+
+#include "pad_sink.h"
+
+// Linux pad sink: one uinput device per pad that looks like an Xbox 360 pad
+// to evdev, SDL and Steam Input (xpad ids, names, buttons and axes).
+// - Update() sends only what changed since the pad's previous report,
+//   followed by SYN_REPORT, as one input_event array in one write().
+// - Y axes are flipped (XInput up is evdev down), the d-pad is ABS_HAT0X/Y
+//   and the triggers ABS_Z/ABS_RZ (0..255), as the xpad driver reports them.
+// Error codes are errno values. Compiled on Linux only.
+#if defined(__linux__)
+
+struct input_event;
+
+class UinputPadSink : public IPadSink
+{
+public:
+    explicit UinputPadSink(const char* devicePath = "/dev/uinput");
+    ~UinputPadSink() override { Disconnect(); }
+
+    const char* Name() const override { return "uinput"; }
+    bool Connect(int count, int* outErr) override;
+    void Disconnect() override;
+    int  Pads() const override { return m_count; }
+    bool Update(int pad, const PadReport& report, int* outErr) override;
+
+    // Events for prev -> next (everything when full), SYN_REPORT last; 0 if
+    // nothing changed. out holds at least UINPUT_PAD_MAX_EVENTS.
+    static int Encode(const PadReport& prev, const PadReport& next, bool full, input_event* out);
+
+private:
+    const char* m_path;
+    int         m_fd[PAD_SINK_MAX_PADS];   // -1 = no device
+    PadReport   m_last[PAD_SINK_MAX_PADS]{};
+    bool        m_sent[PAD_SINK_MAX_PADS]{};
+    int         m_count = 0;
+};
+
+// 11 buttons + 4 sticks + 2 triggers + 2 hat axes + SYN_REPORT
+constexpr int UINPUT_PAD_MAX_EVENTS = 20;
+
+#endif
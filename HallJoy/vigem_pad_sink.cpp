@@ -0,0 +1,77 @@
+// vigem_pad_sink.cpp
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include <algorithm>
+
+#include <ViGEm/Client.h>
+
+#include "vigem_pad_sink.h"
+
+static_assert(sizeof(PadReport) == sizeof(XUSB_REPORT), "PadReport mirrors XUSB_REPORT");
+
+static XUSB_REPORT ToXusb(const PadReport& r)
+{
+    XUSB_REPORT x{};
+    x.wButtons = r.buttons;
+    x.bLeftTrigger = r.leftTrigger;
+    x.bRightTrigger = r.rightTrigger;
+    x.sThumbLX = r.lx;
+    x.sThumbLY = r.ly;
+    x.sThumbRX = r.rx;
+    x.sThumbRY = r.ry;
+    return x;
+}
+
+bool VigemPadSink::Connect(int count, int* outErr)
+{
+    Disconnect();
+    count = std::clamp(count, 1, PAD_SINK_MAX_PADS);
+    if (outErr) *outErr = VIGEM_ERROR_NONE;
+
+    PVIGEM_CLIENT client = vigem_alloc();
+    if (!client) { if (outErr) *outErr = VIGEM_ERROR_BUS_NOT_FOUND; return false; }
+    VIGEM_ERROR err = vigem_connect(client);
+    if (!VIGEM_SUCCESS(err)) { if (outErr) *outErr = err; vigem_free(client); return false; }
+    m_client = client;
+
+    for (int i = 0; i < count; ++i)
+    {
+        PVIGEM_TARGET pad = vigem_target_x360_alloc();
+        if (!pad) { if (outErr) *outErr = VIGEM_ERROR_INVALID_TARGET; Disconnect(); return false; }
+        err = vigem_target_add(client, pad);
+        if (!VIGEM_SUCCESS(err)) { if (outErr) *outErr = err; vigem_target_free(pad); Disconnect(); return false; }
+        m_targets[i] = pad;
+        m_count = i + 1;
+    }
+    return true;
+}
+
+void VigemPadSink::Disconnect()
+{
+    PVIGEM_CLIENT client = (PVIGEM_CLIENT)m_client;
+    for (int i = 0; i < m_count; ++i)
+    {
+        PVIGEM_TARGET pad = (PVIGEM_TARGET)m_targets[i];
+        if (!pad) continue;
+        if (client) vigem_target_remove(client, pad);
+        vigem_target_free(pad);
+        m_targets[i] = nullptr;
+    }
+    m_count = 0;
+    if (client) { vigem_disconnect(client); vigem_free(client); m_client = nullptr; }
+}
+
+bool VigemPadSink::Update(int pad, const PadReport& report, int* outErr)
+{
+    if (outErr) *outErr = VIGEM_ERROR_NONE;
+    if (!m_client || pad < 0 || pad >= m_count || !m_targets[pad])
+    {
+        if (outErr) *outErr = VIGEM_ERROR_INVALID_TARGET;
+        return false;
+    }
+
+    const VIGEM_ERROR err = vigem_target_x360_update((PVIGEM_CLIENT)m_client, (PVIGEM_TARGET)m_targets[pad], ToXusb(report));
+    if (outErr) *outErr = err;
+    return VIGEM_SUCCESS(err);
+}
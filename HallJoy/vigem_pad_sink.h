@@ -0,0 +1,24 @@
+// vigem_pad_sink.h
+#pragma once
+#include <cstdint>
+
+#include "pad_sink.h"
+
+// Windows pad sink: one Xbox 360 target per pad on the ViGEm bus, one
+// vigem_target_x360_update per report. Error codes are VIGEM_ERROR values.
+class VigemPadSink : public IPadSink
+{
+public:
+    ~VigemPadSink() override { Disconnect(); }
+
+    const char* Name() const override { return "vigem"; }
+    bool Connect(int count, int* outErr) override;
+    void Disconnect() override;
+    int  Pads() const override { return m_count; }
+    bool Update(int pad, const PadReport& report, int* outErr) override;
+
+private:
+    void* m_client = nullptr;                    // PVIGEM_CLIENT
+    void* m_targets[PAD_SINK_MAX_PADS]{};        // PVIGEM_TARGET
+    int   m_count = 0;
+};